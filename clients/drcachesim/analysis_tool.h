@@ -46,6 +46,8 @@
 #include "memref.h"
 #include "memtrace_stream.h"
 #include "trace_entry.h"
+#include <istream>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -169,6 +171,19 @@ public:
     {
         return SHARD_BY_THREAD;
     }
+    /**
+     * Returns whether this tool examines the addresses of data references.  If every
+     * tool returns false, the framework asks the scheduler to skip decoding data
+     * addresses from input formats which store them separately, such as the columnar
+     * format, and data references are then delivered with an address of 0 (see
+     * #dynamorio::drmemtrace::scheduler_tmpl_t::scheduler_options_t::
+     * skip_data_addresses).
+     */
+    virtual bool
+    data_addresses_needed()
+    {
+        return true;
+    }
     /** Returns whether the tool was created successfully. */
     virtual bool
     operator!()
@@ -531,12 +546,83 @@ public:
     {
         return false;
     }
+    /**
+     * Returns whether this tool can receive records through
+     * parallel_shard_memref_batch() rather than one at a time through
+     * parallel_shard_memref().  The analyzer delivers batches only when every tool
+     * returns true and no interval analysis was requested.  A tool returning true
+     * must tolerate shard stream queries reflecting the final record of the batch
+     * rather than the record being processed (see
+     * #dynamorio::drmemtrace::scheduler_tmpl_t::stream_t::next_record_batch()).
+     */
+    virtual bool
+    parallel_shard_batch_supported()
+    {
+        return false;
+    }
+    /**
+     * Operates on \p count consecutive trace entries from the same shard and input,
+     * just as though parallel_shard_memref() were called on each in turn.  A thread
+     * exit record only appears as the final entry of a batch.  This is only called
+     * if parallel_shard_batch_supported() returns true.  Overriding it lets a tool
+     * avoid the per-record virtual call overhead.  The return value and error
+     * reporting match parallel_shard_memref().
+     */
+    virtual bool
+    parallel_shard_memref_batch(void *shard_data, const RecordType *entries,
+                                size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            if (!parallel_shard_memref(shard_data, entries[i]))
+                return false;
+        }
+        return true;
+    }
     /** Returns a description of the last error for this shard. */
     virtual std::string
     parallel_shard_error(void *shard_data)
     {
         return "";
     }
+    /**
+     * Returns whether this tool can save the final state of a shard with
+     * parallel_shard_state_save() and later restore it with
+     * parallel_shard_state_restore(), which lets the analyzer skip inputs that are
+     * unchanged since an earlier run (see the -analysis_cache_dir option).  If so,
+     * \p config is set to a description of every tool option that affects shard
+     * state: saved state is only restored into a tool with the same description.
+     * This may be called prior to initialize().
+     */
+    virtual bool
+    parallel_shard_state_supported(std::string &config)
+    {
+        return false;
+    }
+    /**
+     * Writes to \p out the state of the shard represented by \p shard_data, which
+     * has been passed to parallel_shard_exit(), in a form that
+     * parallel_shard_state_restore() reads back.  Returns whether this was
+     * successful.
+     */
+    virtual bool
+    parallel_shard_state_save(void *shard_data, std::ostream &out)
+    {
+        return false;
+    }
+    /**
+     * Restores from \p in a shard state written by parallel_shard_state_save() in
+     * an earlier run, in place of calling parallel_shard_init_stream(),
+     * parallel_shard_memref(), and parallel_shard_exit() for that shard.  The tool
+     * should include the restored shard in print_results() as it would any other.
+     * The \p shard_index is unique among this run's shards but need not match the
+     * shard's index in the earlier run, and no stream is available for the shard.
+     * Returns nullptr on failure.
+     */
+    virtual void *
+    parallel_shard_state_restore(int shard_index, std::istream &in)
+    {
+        return nullptr;
+    }
     /**
      * Notifies the analysis tool that the given trace \p interval_id in the shard
      * represented by the given \p shard_data has ended, so that it can generate a
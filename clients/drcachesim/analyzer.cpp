@@ -34,13 +34,18 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/stat.h>
 
 #include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
 #include <set>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <utility>
@@ -49,6 +54,7 @@
 #include "memref.h"
 #include "scheduler.h"
 #include "analysis_tool.h"
+#include "directory_iterator.h"
 #ifdef HAS_ZLIB
 #    include "compressed_file_reader.h"
 #else
@@ -239,7 +245,7 @@ analyzer_tmpl_t<RecordType, ReaderType>::init_scheduler(
         ERRMSG("Missing trace path(s)\n");
         return false;
     }
-    std::vector<typename sched_type_t::range_t> regions;
+    std::vector<typename sched_type_t::range_t> regions = regions_of_interest_;
     if (skip_instrs_ > 0) {
         // TODO i#5843: For serial mode with multiple inputs this is not doing the
         // right thing: this is skipping in every input stream, while the documented
@@ -247,6 +253,21 @@ analyzer_tmpl_t<RecordType, ReaderType>::init_scheduler(
         // capability in the scheduler we should switch to that.
         regions.emplace_back(skip_instrs_ + 1, 0);
     }
+    std::set<int> live_shards = only_shards;
+    if (!shard_state_dir_.empty()) {
+        // Saved state stands in for a whole input, so the input must be analyzed
+        // whole and on its own.
+        if (trace_paths.size() != 1 || !only_threads.empty() || !only_shards.empty() ||
+            !regions.empty() || skip_to_timestamp_ > 0 || output_limit > 0 ||
+            interval_microseconds_ != 0 || interval_instr_count_ != 0 ||
+            shard_type_ != SHARD_BY_THREAD || !parallel_ || add_noise_generator_) {
+            error_string_ = "-analysis_cache_dir requires a parallel thread-sharded "
+                            "analysis of whole inputs without intervals";
+            return false;
+        }
+        if (!load_shard_states(trace_paths[0], live_shards))
+            return false;
+    }
     std::vector<typename sched_type_t::input_workload_t> workloads;
     for (const std::string &path : trace_paths) {
         if (path.empty()) {
@@ -258,7 +279,7 @@ analyzer_tmpl_t<RecordType, ReaderType>::init_scheduler(
         // limits are not supported with -multi_indir.  That's already been checked, so
         // we do not perform additional checks here.
         workloads.back().only_threads = only_threads;
-        workloads.back().only_shards = only_shards;
+        workloads.back().only_shards = live_shards;
         workloads.back().output_limit = output_limit;
         if (regions.empty() && skip_to_timestamp_ > 0) {
             workloads.back().times_of_interest.emplace_back(skip_to_timestamp_, 0);
@@ -282,7 +303,21 @@ analyzer_tmpl_t<RecordType, ReaderType>::init_scheduler(
     // Use a sentinel for the tid so the scheduler will use the memref record tid.
     readers.emplace_back(std::move(reader), std::move(reader_end),
                          /*tid=*/INVALID_THREAD_ID);
-    std::vector<typename sched_type_t::range_t> regions;
+    return init_scheduler(std::move(readers), verbosity, std::move(options));
+}
+
+template <typename RecordType, typename ReaderType>
+bool
+analyzer_tmpl_t<RecordType, ReaderType>::init_scheduler(
+    std::vector<typename sched_type_t::input_reader_t> readers, int verbosity,
+    typename sched_type_t::scheduler_options_t options)
+{
+    verbosity_ = verbosity;
+    if (readers.empty()) {
+        ERRMSG("Readers are empty\n");
+        return false;
+    }
+    std::vector<typename sched_type_t::range_t> regions = regions_of_interest_;
     if (skip_instrs_ > 0)
         regions.emplace_back(skip_instrs_ + 1, 0);
     std::vector<typename sched_type_t::input_workload_t> workloads;
@@ -326,6 +361,16 @@ analyzer_tmpl_t<RecordType, ReaderType>::init_scheduler_common(
             break;
         }
     }
+    // Interval processing needs to see every record, so batches are only used
+    // without it.
+    batch_records_ =
+        parallel_ && interval_microseconds_ == 0 && interval_instr_count_ == 0
+        ? MAX_BATCH_RECORDS
+        : 0;
+    for (int i = 0; i < num_tools_ && batch_records_ > 0; ++i) {
+        if (!tools_[i]->parallel_shard_batch_supported())
+            batch_records_ = 0;
+    }
 
     typename sched_type_t::scheduler_options_t sched_ops;
     int output_count = worker_count_;
@@ -362,6 +407,13 @@ analyzer_tmpl_t<RecordType, ReaderType>::init_scheduler_common(
         sched_ops.read_inputs_in_init = options.read_inputs_in_init;
         sched_ops.kernel_syscall_trace_path = options.kernel_syscall_trace_path;
     }
+    sched_ops.skip_data_addresses = true;
+    for (int i = 0; i < num_tools_; ++i) {
+        if (tools_[i]->data_addresses_needed()) {
+            sched_ops.skip_data_addresses = false;
+            break;
+        }
+    }
     sched_mapping_ = options.mapping;
     if (scheduler_.init(workloads, output_count, std::move(sched_ops)) !=
         sched_type_t::STATUS_SUCCESS) {
@@ -369,6 +421,14 @@ analyzer_tmpl_t<RecordType, ReaderType>::init_scheduler_common(
                scheduler_.get_error_string().c_str());
         return false;
     }
+    // The regions are applied to each input separately, so with several inputs
+    // they would not match the whole-trace instruction counts they came from.
+    if (!regions_of_interest_.empty() &&
+        scheduler_.get_input_stream_count() - (add_noise_generator_ ? 1 : 0) > 1) {
+        error_string_ = "-instr_intervals_file requires a single input: use "
+                        "-only_thread to select one";
+        return false;
+    }
 
     for (int i = 0; i < worker_count_; ++i) {
         worker_data_.push_back(analyzer_worker_data_t(i, scheduler_.get_stream(i)));
@@ -660,44 +720,321 @@ analyzer_tmpl_t<RecordType, ReaderType>::process_shard_exit(
             return false;
         }
     }
+    if (!shard_state_files_.empty())
+        save_shard_state(worker, shard_index);
+    return true;
+}
+
+static constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+static constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+static const char *const SHARD_STATE_MAGIC = "drmemtrace_shard_state";
+static constexpr int SHARD_STATE_VERSION = 3;
+
+// Folds size bytes at data into the FNV-1a hash.
+static uint64_t
+hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    return hash;
+}
+
+// The size of each of the blocks of an input that are hashed.
+static constexpr size_t HASH_SAMPLE_SIZE = 64 * 1024;
+
+// Hashes the first, middle, and last HASH_SAMPLE_SIZE bytes of the file at path,
+// which is size bytes long, or the whole file if it is no larger than that.
+// Reading just these blocks keeps saving and checking the state of a large input
+// from reading it all over again: together with the size and modification time
+// this catches every change short of a rewrite in place that keeps both.
+static bool
+hash_file_sample(const std::string &path, uint64_t size, uint64_t &hash)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<char> buf(HASH_SAMPLE_SIZE);
+    std::vector<uint64_t> offsets;
+    if (size <= 3 * HASH_SAMPLE_SIZE)
+        offsets = { 0, HASH_SAMPLE_SIZE, 2 * HASH_SAMPLE_SIZE };
+    else
+        offsets = { 0, size / 2 - HASH_SAMPLE_SIZE / 2, size - HASH_SAMPLE_SIZE };
+    hash = FNV_OFFSET;
+    for (uint64_t offset : offsets) {
+        if (offset >= size)
+            break;
+        if (!file.seekg(offset))
+            return false;
+        file.read(buf.data(), buf.size());
+        size_t count = static_cast<size_t>(file.gcount());
+        if (file.bad() ||
+            count != std::min<uint64_t>(HASH_SAMPLE_SIZE, size - offset))
+            return false;
+        // Whole words are folded in at a time.
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= count; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, &buf[i], sizeof(word));
+            hash = (hash ^ word) * FNV_PRIME;
+        }
+        hash = hash_bytes(hash, &buf[i], count - i);
+        file.clear();
+    }
+    hash = hash_bytes(hash, &size, sizeof(size));
+    return true;
+}
+
+static bool
+get_file_size_and_mtime(const std::string &path, uint64_t &size, int64_t &mtime)
+{
+#ifdef WINDOWS
+    struct _stat64 st;
+    if (_stat64(path.c_str(), &st) != 0)
+        return false;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+#endif
+    size = static_cast<uint64_t>(st.st_size);
+    mtime = static_cast<int64_t>(st.st_mtime);
     return true;
 }
 
+// Reads the per-tool states from a file written by save_shard_state().  Returns
+// false if the file is missing, was saved under a different configuration or for
+// a different version of the input, or is incomplete.  The input is only sampled
+// once its size and modification time are known to match.
+static bool
+read_shard_state(const std::string &path, uint64_t config_hash,
+                 const std::string &input_path, uint64_t input_size,
+                 int64_t input_mtime, int num_tools, std::vector<std::string> &states)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::string magic;
+    int version, file_tools;
+    uint64_t file_config, file_size, file_content;
+    int64_t file_mtime;
+    if (!(in >> magic >> version >> std::hex >> file_config >> std::dec >> file_size >>
+          file_mtime >> std::hex >> file_content >> std::dec >> file_tools) ||
+        magic != SHARD_STATE_MAGIC || version != SHARD_STATE_VERSION ||
+        file_config != config_hash || file_size != input_size ||
+        file_mtime != input_mtime || file_tools != num_tools)
+        return false;
+    uint64_t content_hash;
+    if (!hash_file_sample(input_path, input_size, content_hash) ||
+        content_hash != file_content)
+        return false;
+    states.resize(num_tools);
+    for (std::string &state : states) {
+        size_t size;
+        if (!(in >> size) || in.get() != '\n')
+            return false;
+        state.resize(size);
+        if (size > 0 && !in.read(&state[0], size))
+            return false;
+    }
+    std::string end;
+    return (in >> end) && end == "end";
+}
+
 template <typename RecordType, typename ReaderType>
 bool
-analyzer_tmpl_t<RecordType, ReaderType>::process_tasks_internal(
-    analyzer_worker_data_t *worker)
+analyzer_tmpl_t<RecordType, ReaderType>::load_shard_states(const std::string &trace_path,
+                                                           std::set<int> &only_shards)
 {
-    std::vector<void *> user_worker_data(num_tools_);
+    if (!directory_iterator_t::is_directory(shard_state_dir_)) {
+        error_string_ = "-analysis_cache_dir " + shard_state_dir_ + " is not a directory";
+        return false;
+    }
+    std::string config = std::to_string(SHARD_STATE_VERSION);
+    for (int i = 0; i < num_tools_; ++i) {
+        std::string tool_config;
+        if (!tools_[i]->parallel_shard_supported() ||
+            !tools_[i]->parallel_shard_state_supported(tool_config)) {
+            error_string_ = "-analysis_cache_dir is not supported by every selected tool";
+            return false;
+        }
+        config += "\n" + tool_config;
+    }
+    const uint64_t config_hash = hash_bytes(FNV_OFFSET, config.data(), config.size());
+    std::vector<std::string> files;
+    if (sched_type_t::list_input_files(trace_path, files, error_string_) !=
+        sched_type_t::STATUS_SUCCESS)
+        return false;
+    for (int i = 0; i < static_cast<int>(files.size()); ++i) {
+        shard_state_file_t state_file;
+        state_file.input_path = files[i];
+        state_file.config_hash = config_hash;
+        if (!get_file_size_and_mtime(files[i], state_file.input_size,
+                                     state_file.input_mtime)) {
+            error_string_ = "Failed to read " + files[i];
+            return false;
+        }
+        std::string name = files[i];
+        size_t sep = name.find_last_of(DIRSEP);
+        if (sep != std::string::npos)
+            name = name.substr(sep + 1);
+        std::ostringstream path;
+        path << shard_state_dir_ << DIRSEP << name << '.' << std::hex << config_hash
+             << ".state";
+        state_file.state_path = path.str();
+        std::vector<std::string> states;
+        // The scheduler needs at least one input, so the final one is analyzed
+        // if all the others were skipped.
+        bool must_analyze =
+            i == static_cast<int>(files.size()) - 1 && only_shards.empty();
+        if (!must_analyze &&
+            read_shard_state(state_file.state_path, config_hash, files[i],
+                             state_file.input_size, state_file.input_mtime, num_tools_,
+                             states)) {
+            VPRINT(this, 1, "Skipping unchanged input %s\n", files[i].c_str());
+            restored_shard_states_.push_back(std::move(states));
+        } else {
+            // Inputs not in only_shards are dropped before shard indices are
+            // assigned, so the analyzed inputs take consecutive indices.
+            only_shards.insert(i);
+            shard_state_files_.push_back(state_file);
+        }
+    }
+    return true;
+}
 
-    for (int i = 0; i < num_tools_; ++i)
-        user_worker_data[i] = tools_[i]->parallel_worker_init(worker->index);
+template <typename RecordType, typename ReaderType>
+bool
+analyzer_tmpl_t<RecordType, ReaderType>::restore_shard_states()
+{
+    // Restored shards are numbered after the analyzed ones.
+    int shard_index = static_cast<int>(shard_state_files_.size());
+    for (const std::vector<std::string> &states : restored_shard_states_) {
+        for (int i = 0; i < num_tools_; ++i) {
+            std::istringstream in(states[i]);
+            if (tools_[i]->parallel_shard_state_restore(shard_index, in) == nullptr) {
+                error_string_ = "Failed to restore saved shard state: " +
+                    tools_[i]->get_error_string();
+                return false;
+            }
+        }
+        ++shard_index;
+    }
+    restored_shard_states_.clear();
+    return true;
+}
 
-    RecordType record;
-    // The current time is used for time quanta; for instr quanta, it's ignored and
-    // we pass 0.
+template <typename RecordType, typename ReaderType>
+void
+analyzer_tmpl_t<RecordType, ReaderType>::save_shard_state(analyzer_worker_data_t *worker,
+                                                          int shard_index)
+{
+    if (shard_index < 0 || shard_index >= static_cast<int>(shard_state_files_.size()))
+        return;
+    const shard_state_file_t &state_file = shard_state_files_[shard_index];
+    const std::string &path = state_file.state_path;
+    uint64_t content_hash;
+    if (!hash_file_sample(state_file.input_path, state_file.input_size, content_hash)) {
+        ERRMSG("Failed to read %s\n", state_file.input_path.c_str());
+        return;
+    }
+    std::ostringstream out;
+    out << SHARD_STATE_MAGIC << ' ' << SHARD_STATE_VERSION << ' ' << std::hex
+        << state_file.config_hash << std::dec << ' ' << state_file.input_size << ' '
+        << state_file.input_mtime << ' ' << std::hex << content_hash << std::dec << ' '
+        << num_tools_ << '\n';
+    for (int i = 0; i < num_tools_; ++i) {
+        void *shard_data = worker->shard_data[shard_index].tool_data[i].shard_data;
+        std::ostringstream state;
+        if (!tools_[i]->parallel_shard_state_save(shard_data, state)) {
+            // The analysis itself is unaffected, so we just warn.
+            ERRMSG("Failed to save the state of shard %d: %s\n", shard_index,
+                   tools_[i]->parallel_shard_error(shard_data).c_str());
+            return;
+        }
+        const std::string bytes = state.str();
+        out << bytes.size() << '\n' << bytes;
+    }
+    out << "end\n";
+    // We write to a temporary file first so that an interrupted run cannot leave
+    // a partial state file under the final name.
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary);
+        file << out.str();
+        if (!file.good()) {
+            ERRMSG("Failed to write %s\n", tmp_path.c_str());
+            return;
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        ERRMSG("Failed to rename %s\n", tmp_path.c_str());
+}
+
+template <typename RecordType, typename ReaderType>
+void
+analyzer_tmpl_t<RecordType, ReaderType>::init_shard(
+    analyzer_worker_data_t *worker, int shard_index,
+    const std::vector<void *> &user_worker_data)
+{
+    if (worker->shard_data.find(shard_index) != worker->shard_data.end())
+        return;
+    VPRINT(this, 1, "Worker %d starting on trace shard %d stream is %p\n", worker->index,
+           shard_index, worker->stream);
+    worker->shard_data[shard_index].tool_data.resize(num_tools_);
+    if (interval_microseconds_ != 0 || interval_instr_count_ != 0)
+        worker->shard_data[shard_index].cur_interval_index = 1;
+    for (int i = 0; i < num_tools_; ++i) {
+        worker->shard_data[shard_index].tool_data[i].shard_data =
+            tools_[i]->parallel_shard_init_stream(shard_index, user_worker_data[i],
+                                                  worker->stream);
+    }
+    worker->shard_data[shard_index].shard_index = shard_index;
+}
+
+template <typename RecordType, typename ReaderType>
+void
+analyzer_tmpl_t<RecordType, ReaderType>::set_shard_id(analyzer_worker_data_t *worker,
+                                                      int shard_index,
+                                                      const RecordType &record)
+{
+    memref_tid_t tid;
+    if (worker->shard_data[shard_index].shard_id == 0) {
+        if (shard_type_ == SHARD_BY_CORE)
+            worker->shard_data[shard_index].shard_id = worker->index;
+        else if (record_has_tid(record, tid))
+            worker->shard_data[shard_index].shard_id = tid;
+    }
+}
+
+template <typename RecordType, typename ReaderType>
+bool
+analyzer_tmpl_t<RecordType, ReaderType>::process_batches(
+    analyzer_worker_data_t *worker, const std::vector<void *> &user_worker_data)
+{
+    std::vector<RecordType> batch(batch_records_);
+    // See the comments in process_tasks_internal() on the time and on waits.
     uint64_t cur_micros = sched_by_time_ ? get_current_microseconds() : 0;
-    for (typename sched_type_t::stream_status_t status =
-             worker->stream->next_record(record, cur_micros);
-         status != sched_type_t::STATUS_EOF;
-         status = worker->stream->next_record(record, cur_micros)) {
+    while (true) {
+        size_t count;
+        int shard_index;
+        typename sched_type_t::stream_status_t status = worker->stream->next_record_batch(
+            batch.data(), batch.size(), count, shard_index, cur_micros);
+        if (status == sched_type_t::STATUS_EOF)
+            break;
         if (sched_by_time_)
             cur_micros = get_current_microseconds();
         if (status == sched_type_t::STATUS_WAIT) {
-            // We let tools know about waits so they can analyze the schedule.
-            // We synthesize a record here.  If we wanted this to count toward output
-            // stream ordinals we would need to add a scheduler API to inject it.
-            record = create_wait_marker();
-            if (parallel_) {
-                // Don't spin on this artificial wait; retry later.
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            }
+            batch[0] = create_wait_marker();
+            count = 1;
+            shard_index = worker->stream->get_shard_index();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
         } else if (status == sched_type_t::STATUS_IDLE) {
             assert(shard_type_ == SHARD_BY_CORE);
-            // We let tools know about idle time so they can analyze cpu usage.
-            // We synthesize a record here.  If we wanted this to count toward output
-            // stream ordinals we would need to add a scheduler API to inject it.
-            record = create_idle_marker();
+            batch[0] = create_idle_marker();
+            count = 1;
+            shard_index = worker->stream->get_shard_index();
         } else if (status != sched_type_t::STATUS_OK) {
             if (status == sched_type_t::STATUS_REGION_INVALID) {
                 worker->error =
@@ -708,52 +1045,127 @@ analyzer_tmpl_t<RecordType, ReaderType>::process_tasks_internal(
             }
             return false;
         }
-        int shard_index = worker->stream->get_shard_index();
-        if (worker->shard_data.find(shard_index) == worker->shard_data.end()) {
-            VPRINT(this, 1, "Worker %d starting on trace shard %d stream is %p\n",
-                   worker->index, shard_index, worker->stream);
-            worker->shard_data[shard_index].tool_data.resize(num_tools_);
-            if (interval_microseconds_ != 0 || interval_instr_count_ != 0)
-                worker->shard_data[shard_index].cur_interval_index = 1;
+        init_shard(worker, shard_index, user_worker_data);
+        analyzer_shard_data_t &shard = worker->shard_data[shard_index];
+        if (shard.shard_id == 0) {
+            for (size_t i = 0; i < count && shard.shard_id == 0; ++i)
+                set_shard_id(worker, shard_index, batch[i]);
+        }
+        // The scheduler ends a batch at a thread exit, but the thread-final record
+        // for record_analyzer_t is the footer after it, so we split here as well.
+        size_t start = 0;
+        while (start < count) {
+            size_t end = start;
+            while (end < count && !record_is_thread_final(batch[end]))
+                ++end;
+            bool at_final = end < count;
+            if (at_final)
+                ++end;
             for (int i = 0; i < num_tools_; ++i) {
-                worker->shard_data[shard_index].tool_data[i].shard_data =
-                    tools_[i]->parallel_shard_init_stream(
-                        shard_index, user_worker_data[i], worker->stream);
+                if (!tools_[i]->parallel_shard_memref_batch(
+                        shard.tool_data[i].shard_data, &batch[start], end - start)) {
+                    worker->error =
+                        tools_[i]->parallel_shard_error(shard.tool_data[i].shard_data);
+                    VPRINT(this, 1,
+                           "Worker %d hit shard memref error %s on trace shard %s\n",
+                           worker->index, worker->error.c_str(),
+                           worker->stream->get_stream_name().c_str());
+                    return false;
+                }
             }
-            worker->shard_data[shard_index].shard_index = shard_index;
-        }
-        memref_tid_t tid;
-        if (worker->shard_data[shard_index].shard_id == 0) {
-            if (shard_type_ == SHARD_BY_CORE)
-                worker->shard_data[shard_index].shard_id = worker->index;
-            else if (record_has_tid(record, tid))
-                worker->shard_data[shard_index].shard_id = tid;
+            if (at_final && shard_type_ != SHARD_BY_CORE) {
+                if (!process_shard_exit(worker, shard_index))
+                    return false;
+            }
+            start = end;
         }
-        uint64_t prev_interval_index;
-        uint64_t prev_interval_init_instr_count;
-        if ((record_is_timestamp(record) || record_is_instr(record)) &&
-            advance_interval_id(worker->stream, &worker->shard_data[shard_index],
-                                prev_interval_index, prev_interval_init_instr_count,
-                                record_is_instr(record)) &&
-            !process_interval(prev_interval_index, prev_interval_init_instr_count, worker,
-                              /*parallel=*/true, record_is_instr(record), shard_index)) {
+    }
+    return true;
+}
+
+template <typename RecordType, typename ReaderType>
+bool
+analyzer_tmpl_t<RecordType, ReaderType>::process_tasks_internal(
+    analyzer_worker_data_t *worker)
+{
+    std::vector<void *> user_worker_data(num_tools_);
+
+    for (int i = 0; i < num_tools_; ++i)
+        user_worker_data[i] = tools_[i]->parallel_worker_init(worker->index);
+
+    if (batch_records_ > 0) {
+        if (!process_batches(worker, user_worker_data))
             return false;
-        }
-        for (int i = 0; i < num_tools_; ++i) {
-            if (!tools_[i]->parallel_shard_memref(
-                    worker->shard_data[shard_index].tool_data[i].shard_data, record)) {
-                worker->error = tools_[i]->parallel_shard_error(
-                    worker->shard_data[shard_index].tool_data[i].shard_data);
-                VPRINT(this, 1, "Worker %d hit shard memref error %s on trace shard %s\n",
-                       worker->index, worker->error.c_str(),
-                       worker->stream->get_stream_name().c_str());
+    } else {
+        RecordType record;
+        // The current time is used for time quanta; for instr quanta, it's ignored and
+        // we pass 0.
+        uint64_t cur_micros = sched_by_time_ ? get_current_microseconds() : 0;
+        for (typename sched_type_t::stream_status_t status =
+                 worker->stream->next_record(record, cur_micros);
+             status != sched_type_t::STATUS_EOF;
+             status = worker->stream->next_record(record, cur_micros)) {
+            if (sched_by_time_)
+                cur_micros = get_current_microseconds();
+            if (status == sched_type_t::STATUS_WAIT) {
+                // We let tools know about waits so they can analyze the schedule.
+                // We synthesize a record here.  If we wanted this to count toward output
+                // stream ordinals we would need to add a scheduler API to inject it.
+                record = create_wait_marker();
+                if (parallel_) {
+                    // Don't spin on this artificial wait; retry later.
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            } else if (status == sched_type_t::STATUS_IDLE) {
+                assert(shard_type_ == SHARD_BY_CORE);
+                // We let tools know about idle time so they can analyze cpu usage.
+                // We synthesize a record here.  If we wanted this to count toward output
+                // stream ordinals we would need to add a scheduler API to inject it.
+                record = create_idle_marker();
+            } else if (status != sched_type_t::STATUS_OK) {
+                if (status == sched_type_t::STATUS_REGION_INVALID) {
+                    worker->error =
+                        "Too-far -skip_instrs for: " + worker->stream->get_stream_name();
+                } else {
+                    worker->error =
+                        "Failed to read from trace: " + worker->stream->get_stream_name();
+                }
                 return false;
             }
-        }
-        if (record_is_thread_final(record) && shard_type_ != SHARD_BY_CORE) {
-            if (!process_shard_exit(worker, shard_index)) {
+            int shard_index = worker->stream->get_shard_index();
+            init_shard(worker, shard_index, user_worker_data);
+            set_shard_id(worker, shard_index, record);
+            uint64_t prev_interval_index;
+            uint64_t prev_interval_init_instr_count;
+            if ((record_is_timestamp(record) || record_is_instr(record)) &&
+                advance_interval_id(worker->stream, &worker->shard_data[shard_index],
+                                    prev_interval_index,
+                                    prev_interval_init_instr_count,
+                                    record_is_instr(record)) &&
+                !process_interval(prev_interval_index, prev_interval_init_instr_count,
+                                  worker,
+                                  /*parallel=*/true, record_is_instr(record),
+                                  shard_index)) {
                 return false;
             }
+            for (int i = 0; i < num_tools_; ++i) {
+                if (!tools_[i]->parallel_shard_memref(
+                        worker->shard_data[shard_index].tool_data[i].shard_data,
+                        record)) {
+                    worker->error = tools_[i]->parallel_shard_error(
+                        worker->shard_data[shard_index].tool_data[i].shard_data);
+                    VPRINT(this, 1,
+                           "Worker %d hit shard memref error %s on trace shard %s\n",
+                           worker->index, worker->error.c_str(),
+                           worker->stream->get_stream_name().c_str());
+                    return false;
+                }
+            }
+            if (record_is_thread_final(record) && shard_type_ != SHARD_BY_CORE) {
+                if (!process_shard_exit(worker, shard_index)) {
+                    return false;
+                }
+            }
         }
     }
     if (shard_type_ == SHARD_BY_CORE) {
@@ -1043,6 +1455,8 @@ analyzer_tmpl_t<RecordType, ReaderType>::run()
             if (!error_string_.empty())
                 return false;
         }
+        if (!restore_shard_states())
+            return false;
         std::vector<std::thread> threads;
         VPRINT(this, 1, "Creating %d worker threads\n", worker_count_);
         threads.reserve(worker_count_);
@@ -232,6 +232,12 @@ protected:
                    std::unique_ptr<ReaderType> reader_end, int verbosity,
                    typename sched_type_t::scheduler_options_t options);
 
+    // Like the single-reader version but with each reader a separate input.
+    // See comment on init_scheduler_common() for some noteworthy details.
+    bool
+    init_scheduler(std::vector<typename sched_type_t::input_reader_t> readers,
+                   int verbosity, typename sched_type_t::scheduler_options_t options);
+
     // For core-sharded, worker_count_ must be set prior to calling this; for parallel
     // mode if it is not set it will be set to the underlying core count.
     // For core-sharded, all of "options" is used; otherwise, the
@@ -252,12 +258,44 @@ protected:
     bool
     process_tasks_internal(analyzer_worker_data_t *worker);
 
+    // Helper for process_tasks_internal() that delivers records to tools in batches
+    // of up to batch_records_ through parallel_shard_memref_batch().
+    bool
+    process_batches(analyzer_worker_data_t *worker,
+                    const std::vector<void *> &user_worker_data);
+
+    // Creates the per-tool data for shard_index on its first use by this worker.
+    void
+    init_shard(analyzer_worker_data_t *worker, int shard_index,
+               const std::vector<void *> &user_worker_data);
+
+    // Sets the shard id from the first record carrying a thread id.
+    void
+    set_shard_id(analyzer_worker_data_t *worker, int shard_index,
+                 const RecordType &record);
+
     // Helper for process_tasks() which calls parallel_shard_exit() in each tool.
     // Returns false if there was an error and the caller should return early.
     bool
     process_shard_exit(analyzer_worker_data_t *worker, int shard_index,
                        bool do_process_final_interval = true);
 
+    // For shard_state_dir_: reads the saved state of each input of trace_path that
+    // is unchanged since it was saved into restored_shard_states_, and adds the
+    // ordinals of the remaining inputs to only_shards.  An input is unchanged if its
+    // size and modification time match and then, to guard against edits that keep
+    // both, its contents hash the same.  Returns false on error.
+    bool
+    load_shard_states(const std::string &trace_path, std::set<int> &only_shards);
+
+    // Hands the state read by load_shard_states() to the tools.
+    bool
+    restore_shard_states();
+
+    // Saves the state of an exited shard into its shard_state_files_ entry.
+    void
+    save_shard_state(analyzer_worker_data_t *worker, int shard_index);
+
     bool
     record_has_tid(RecordType record, memref_tid_t &tid);
 
@@ -432,11 +470,18 @@ protected:
     const char *output_prefix_ = "[analyzer]";
     uint64_t skip_instrs_ = 0;
     uint64_t skip_to_timestamp_ = 0;
+    // If non-empty, the instruction ranges to analyze in each input; this replaces
+    // skip_instrs_.
+    std::vector<typename sched_type_t::range_t> regions_of_interest_;
     uint64_t interval_microseconds_ = 0;
     uint64_t interval_instr_count_ = 0;
     int verbosity_ = 0;
     shard_type_t shard_type_ = SHARD_BY_THREAD;
     bool sched_by_time_ = false;
+    // The batch size for process_batches(), or 0 if records are delivered one at a
+    // time because some tool does not support batches or intervals are enabled.
+    static constexpr size_t MAX_BATCH_RECORDS = 256;
+    size_t batch_records_ = 0;
     typename sched_type_t::mapping_t sched_mapping_ = sched_type_t::MAP_TO_ANY_OUTPUT;
 
     // Factory to create noise generators that can then be added to the scheduler's
@@ -444,6 +489,22 @@ protected:
     noise_generator_factory_t<RecordType, ReaderType> noise_generator_factory_;
     bool add_noise_generator_ = false;
 
+    // If non-empty, the directory where each input's final shard state is saved so
+    // that a later run can skip the inputs that have not changed.
+    std::string shard_state_dir_;
+    // Where to save each analyzed shard's state and the version of its input that
+    // was analyzed, indexed by shard index.
+    struct shard_state_file_t {
+        std::string state_path;
+        std::string input_path;
+        uint64_t config_hash;
+        uint64_t input_size;
+        int64_t input_mtime;
+    };
+    std::vector<shard_state_file_t> shard_state_files_;
+    // The saved state of each tool for each skipped input.
+    std::vector<std::vector<std::string>> restored_shard_states_;
+
 private:
     bool
     serial_mode_supported();
@@ -30,6 +30,12 @@
  * DAMAGE.
  */
 
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
 #include "analysis_tool.h"
 #include "analyzer.h"
 #include "analyzer_multi.h"
@@ -51,8 +57,12 @@
 #endif
 #ifdef HAS_ZIP
 #    include "common/zipfile_istream.h"
+#    include "reader/zipfile_file_reader.h"
 #endif
 #include "reader/ipc_reader.h"
+#ifdef LINUX
+#    include "reader/shm_ring_reader.h"
+#endif
 #include "simulator/cache_simulator_create.h"
 #include "simulator/tlb_simulator_create.h"
 #include "tools/basic_counts_create.h"
@@ -63,6 +73,7 @@
 #include "tools/invariant_checker_create.h"
 #include "tools/opcode_mix_create.h"
 #include "tools/schedule_stats_create.h"
+#include "tools/simpoint_create.h"
 #include "tools/syscall_mix_create.h"
 #include "tools/reuse_distance_create.h"
 #include "tools/reuse_time_create.h"
@@ -96,6 +107,32 @@ analyzer_multi_t::create_ipc_reader_end()
     return std::unique_ptr<reader_t>(new ipc_reader_t());
 }
 
+template <>
+std::vector<analyzer_multi_t::sched_type_t::input_reader_t>
+analyzer_multi_t::create_shm_ring_readers(const char *name, int verbose)
+{
+    std::vector<sched_type_t::input_reader_t> readers;
+#ifdef LINUX
+    uint32_t ring_count = op_ipc_shm_rings.get_value();
+    auto region = std::make_shared<shm_ring_region_t>(
+        name, ring_count, op_ipc_shm_ring_size.get_value());
+    if (!region->get_error().empty()) {
+        error_string_ = region->get_error();
+        return readers;
+    }
+    for (uint32_t i = 0; i < ring_count; ++i) {
+        // Use a sentinel for the tid so the scheduler will use the memref record tid.
+        readers.emplace_back(
+            std::unique_ptr<reader_t>(new shm_ring_reader_t(region, i, verbose)),
+            std::unique_ptr<reader_t>(new shm_ring_reader_t()),
+            /*tid=*/INVALID_THREAD_ID);
+    }
+#else
+    error_string_ = "-ipc_shm is only supported on Linux";
+#endif
+    return readers;
+}
+
 template <>
 analysis_tool_t *
 analyzer_multi_t::create_external_tool(const std::string &tool_name)
@@ -223,7 +260,7 @@ analyzer_multi_t::create_analysis_tool_from_options(const std::string &tool)
         return tlb_simulator;
     } else if (tool == HISTOGRAM) {
         return histogram_tool_create(op_line_size.get_value(), op_report_top.get_value(),
-                                     op_verbose.get_value());
+                                     op_verbose.get_value(), op_sketch_mode.get_value());
     } else if (tool == REUSE_DIST) {
         reuse_distance_knobs_t knobs;
         knobs.line_size = op_line_size.get_value();
@@ -238,12 +275,20 @@ analyzer_multi_t::create_analysis_tool_from_options(const std::string &tool)
             ERRMSG("Usage error: reuse_histogram_bin_multiplier must be >= 1.0\n");
             return nullptr;
         }
+        knobs.use_tree = op_reuse_tree.get_value();
+        knobs.sample_rate = op_reuse_sample_rate.get_value();
+        if (knobs.sample_rate <= 0.0 || knobs.sample_rate > 1.0) {
+            ERRMSG("Usage error: reuse_sample_rate must be > 0 and <= 1.0\n");
+            return nullptr;
+        }
         knobs.verbose = op_verbose.get_value();
         return reuse_distance_tool_create(knobs);
     } else if (tool == REUSE_TIME) {
-        return reuse_time_tool_create(op_line_size.get_value(), op_verbose.get_value());
+        return reuse_time_tool_create(op_line_size.get_value(), op_verbose.get_value(),
+                                      op_sketch_mode.get_value());
     } else if (tool == BASIC_COUNTS) {
-        return basic_counts_tool_create(op_verbose.get_value());
+        return basic_counts_tool_create(op_verbose.get_value(),
+                                        op_sketch_mode.get_value());
     } else if (tool == OPCODE_MIX) {
         std::string module_file_path = get_module_file_path();
         if (module_file_path.empty() && op_indir.get_value().empty() &&
@@ -277,13 +322,22 @@ analyzer_multi_t::create_analysis_tool_from_options(const std::string &tool)
     } else if (tool == SCHEDULE_STATS) {
         return schedule_stats_tool_create(op_schedule_stats_print_every.get_value(),
                                           op_verbose.get_value());
+    } else if (tool == SIMPOINT) {
+        if (op_interval_instr_count.get_value() == 0) {
+            ERRMSG("Usage error: the simpoint tool requires -interval_instr_count.\n");
+            return nullptr;
+        }
+        return simpoint_tool_create(
+            op_simpoint_max_k.get_value(), op_simpoint_dimensions.get_value(),
+            op_simpoint_output_file.get_value(), op_verbose.get_value());
     } else {
         auto ext_tool = create_external_tool(tool);
         if (ext_tool == nullptr) {
             ERRMSG("Usage error: unsupported analyzer type \"%s\". "
                    "Please choose " CPU_CACHE ", " MISS_ANALYZER ", " TLB ", " HISTOGRAM
                    ", " REUSE_DIST ", " BASIC_COUNTS ", " OPCODE_MIX ", " SYSCALL_MIX
-                   ", " VIEW ", " FUNC_VIEW ", or some external analyzer.\n",
+                   ", " SIMPOINT ", " VIEW ", " FUNC_VIEW
+                   ", or some external analyzer.\n",
                    tool.c_str());
         }
         return ext_tool;
@@ -313,6 +367,15 @@ record_analyzer_multi_t::create_ipc_reader_end()
     return std::unique_ptr<record_reader_t>();
 }
 
+template <>
+std::vector<record_analyzer_multi_t::sched_type_t::input_reader_t>
+record_analyzer_multi_t::create_shm_ring_readers(const char *name, int verbose)
+{
+    error_string_ = "Online analysis is not supported for record_filter";
+    ERRMSG("%s\n", error_string_.c_str());
+    return std::vector<sched_type_t::input_reader_t>();
+}
+
 template <>
 record_analysis_tool_t *
 record_analyzer_multi_t::create_external_tool(const std::string &tool_name)
@@ -342,7 +405,7 @@ record_analyzer_multi_t::create_analysis_tool_from_options(const std::string &to
             op_filter_marker_types.get_value(), op_trim_before_timestamp.get_value(),
             op_trim_after_timestamp.get_value(), op_encodings2regdeps.get_value(),
             op_filter_func_ids.get_value(), op_modify_marker_value.get_value(),
-            op_verbose.get_value());
+            op_verbose.get_value(), op_filter_output_threads.get_value());
     }
     ERRMSG("Usage error: unsupported record analyzer type \"%s\".  Only " RECORD_FILTER
            " is supported.\n",
@@ -387,6 +450,51 @@ analyzer_multi_tmpl_t<RecordType, ReaderType>::set_input_limit(
     return "";
 }
 
+template <typename RecordType, typename ReaderType>
+std::string
+analyzer_multi_tmpl_t<RecordType, ReaderType>::read_instr_intervals_file(
+    const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+        return "Failed to open -instr_intervals_file " + path;
+    // Each line is "start,duration" with start being the count of instructions to
+    // skip, matching the tracer's -trace_instr_intervals_file.
+    std::vector<std::pair<uint64_t, uint64_t>> intervals;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty())
+            continue;
+        std::vector<std::string> fields = split_by(line, ",");
+        char *end_start = nullptr, *end_duration = nullptr;
+        uint64_t start = 0, duration = 0;
+        if (fields.size() >= 2) {
+            start = strtoull(fields[0].c_str(), &end_start, 10);
+            duration = strtoull(fields[1].c_str(), &end_duration, 10);
+        }
+        if (fields.size() < 2 || end_start == fields[0].c_str() ||
+            end_duration == fields[1].c_str() || duration == 0)
+            return "Invalid -instr_intervals_file line: " + line;
+        intervals.emplace_back(start, start + duration);
+    }
+    if (intervals.empty())
+        return "-instr_intervals_file " + path + " contains no intervals";
+    std::sort(intervals.begin(), intervals.end());
+    // The scheduler requires a gap between regions, so we merge overlapping and
+    // adjacent intervals just like the tracer does.
+    std::vector<std::pair<uint64_t, uint64_t>> merged;
+    for (const auto &interval : intervals) {
+        if (!merged.empty() && interval.first <= merged.back().second) {
+            merged.back().second = std::max(merged.back().second, interval.second);
+        } else
+            merged.push_back(interval);
+    }
+    // Convert to 1-based instruction ordinals with an inclusive stop.
+    for (const auto &interval : merged)
+        this->regions_of_interest_.emplace_back(interval.first + 1, interval.second);
+    return "";
+}
+
 template <typename RecordType, typename ReaderType>
 analyzer_multi_tmpl_t<RecordType, ReaderType>::analyzer_multi_tmpl_t()
 {
@@ -400,8 +508,36 @@ analyzer_multi_tmpl_t<RecordType, ReaderType>::analyzer_multi_tmpl_t()
         this->success_ = false;
         return;
     }
+    if (!op_instr_intervals_file.get_value().empty()) {
+        if (this->skip_instrs_ > 0 || this->skip_to_timestamp_ > 0) {
+            this->error_string_ = "Usage error: -instr_intervals_file cannot be "
+                                  "combined with -skip_instrs or -skip_to_timestamp";
+            this->success_ = false;
+            return;
+        }
+        this->error_string_ =
+            read_instr_intervals_file(op_instr_intervals_file.get_value());
+        if (!this->error_string_.empty()) {
+            this->success_ = false;
+            return;
+        }
+    }
     this->interval_microseconds_ = op_interval_microseconds.get_value();
     this->interval_instr_count_ = op_interval_instr_count.get_value();
+    this->shard_state_dir_ = op_analysis_cache_dir.get_value();
+#ifdef HAS_ZIP
+    if (op_zip_read_ahead.get_value() > 0) {
+        int read_ahead_threads = op_zip_read_ahead_threads.get_value();
+        if (read_ahead_threads < 0) {
+            read_ahead_threads = std::thread::hardware_concurrency();
+            if (read_ahead_threads > 16)
+                read_ahead_threads = 16;
+            else if (read_ahead_threads < 1)
+                read_ahead_threads = 1;
+        }
+        set_zipfile_read_ahead(op_zip_read_ahead.get_value(), read_ahead_threads);
+    }
+#endif
     // Initial measurements show it's sometimes faster to keep the parallel model
     // of using single-file readers but use them sequentially, as opposed to
     // the every-file interleaving reader, but the user can specify -jobs 1, so
@@ -473,7 +609,8 @@ analyzer_multi_tmpl_t<RecordType, ReaderType>::analyzer_multi_tmpl_t()
                 raw2trace_directory_t dir(op_verbose.get_value());
                 std::string dir_err =
                     dir.initialize(indir, "", op_trace_compress.get_value(),
-                                   op_syscall_template_file.get_value());
+                                   op_syscall_template_file.get_value(),
+                                   op_trace_compress_level.get_value());
                 if (!dir_err.empty()) {
                     this->success_ = false;
                     this->error_string_ = "Directory setup failed: " + dir_err;
@@ -562,6 +699,8 @@ analyzer_multi_tmpl_t<RecordType, ReaderType>::analyzer_multi_tmpl_t()
             this->parallel_ = false;
         }
         sched_ops = init_dynamic_schedule();
+        if (!this->success_)
+            return;
     } else if (op_skip_to_timestamp.get_value() > 0) {
 #ifdef HAS_ZIP
         if (!op_cpu_schedule_file.get_value().empty()) {
@@ -597,6 +736,35 @@ analyzer_multi_tmpl_t<RecordType, ReaderType>::analyzer_multi_tmpl_t()
             this->success_ = false;
             return;
         }
+    } else if (op_infile.get_value().empty() && op_ipc_shm.get_value()) {
+        // Every ring gets its own worker: a worker waiting on one ring while
+        // another fills up would stall that ring's traced thread, which could
+        // in turn be holding up the thread we are waiting on.
+        for (int i = 0; i < this->num_tools_; ++i) {
+            if (!this->tools_[i]->parallel_shard_supported()) {
+                this->error_string_ = "-ipc_shm requires tools that support parallel "
+                                      "shards";
+                this->success_ = false;
+                return;
+            }
+        }
+        this->parallel_ = true;
+        this->worker_count_ = op_ipc_shm_rings.get_value();
+        auto readers = create_shm_ring_readers(op_ipc_name.get_value().c_str(),
+                                               op_verbose.get_value());
+        if (readers.empty()) {
+            this->error_string_ =
+                "Failed to create shared-memory readers: " + this->error_string_;
+            this->success_ = false;
+            return;
+        }
+        // As for the pipe, reading blocks, so the scheduler's init() must not read.
+        sched_ops.read_inputs_in_init = false;
+        if (!this->init_scheduler(std::move(readers), op_verbose.get_value(),
+                                  std::move(sched_ops))) {
+            this->success_ = false;
+            return;
+        }
     } else if (op_infile.get_value().empty()) {
         // XXX i#3323: Add parallel analysis support for online tools.
         this->parallel_ = false;
@@ -643,6 +811,16 @@ analyzer_multi_tmpl_t<RecordType, ReaderType>::~analyzer_multi_tmpl_t()
         }
     }
 #endif
+    if (this->success_ && !op_sched_checkpoint_file.get_value().empty()) {
+        std::ofstream checkpoint(op_sched_checkpoint_file.get_value());
+        if (!checkpoint ||
+            this->scheduler_.write_checkpoint(checkpoint) !=
+                sched_type_t::STATUS_SUCCESS) {
+            ERRMSG("Failed to write schedule checkpoint to %s: %s",
+                   op_sched_checkpoint_file.get_value().c_str(),
+                   this->scheduler_.get_error_string().c_str());
+        }
+    }
     destroy_analysis_tools();
 }
 
@@ -671,10 +849,34 @@ analyzer_multi_tmpl_t<RecordType, ReaderType>::init_dynamic_schedule()
     sched_ops.honor_infinite_timeouts = op_sched_infinite_timeouts.get_value();
     sched_ops.migration_threshold_us = op_sched_migration_threshold_us.get_value();
     sched_ops.rebalance_period_us = op_sched_rebalance_period_us.get_value();
+    sched_ops.work_stealing = op_sched_work_stealing.get_value();
+    if (!op_sched_topology.get_value().empty()) {
+        int nodes = 0, llcs = 0, cores = 0, threads = 0;
+        char extra;
+        if (sscanf(op_sched_topology.get_value().c_str(), "%dx%dx%dx%d%c", &nodes,
+                   &llcs, &cores, &threads, &extra) != 4) {
+            this->success_ = false;
+            this->error_string_ = "Invalid -sched_topology: expected NxLxCxT";
+            return sched_ops;
+        }
+        sched_ops.output_topology =
+            sched_type_t::make_output_topology(nodes, llcs, cores, threads);
+        if (sched_ops.output_topology.size() !=
+            static_cast<size_t>(op_num_cores.get_value())) {
+            this->success_ = false;
+            this->error_string_ = "-sched_topology must describe exactly -cores cores";
+            return sched_ops;
+        }
+    }
     sched_ops.randomize_next_input = op_sched_randomize.get_value();
     sched_ops.honor_direct_switches = !op_sched_disable_direct_switches.get_value();
     sched_ops.exit_if_fraction_inputs_left =
         op_sched_exit_if_fraction_inputs_left.get_value();
+    sched_ops.stop_after_instrs = op_sched_stop_after_instrs.get_value();
+    if (!op_sched_resume_file.get_value().empty()) {
+        sched_resume_file_.reset(new std::ifstream(op_sched_resume_file.get_value()));
+        sched_ops.checkpoint_istream = sched_resume_file_.get();
+    }
 #ifdef HAS_ZIP
     if (!op_record_file.get_value().empty()) {
         record_schedule_zip_.reset(new zipfile_ostream_t(op_record_file.get_value()));
@@ -752,6 +954,12 @@ bool
 analyzer_multi_tmpl_t<RecordType, ReaderType>::init_analysis_tools()
 {
     // initialize_stream() is now called from analyzer_t::run().
+    // Tools initialize their decode caches lazily, after this point.
+    if (op_decode_cache_entries.get_value() > 0) {
+        shared_decode_cache_ = std::make_shared<shared_decode_cache_t>(
+            static_cast<size_t>(op_decode_cache_entries.get_value()));
+        decode_cache_base_t::set_shared_decode_cache(shared_decode_cache_);
+    }
     return true;
 }
 
@@ -759,6 +967,14 @@ template <typename RecordType, typename ReaderType>
 void
 analyzer_multi_tmpl_t<RecordType, ReaderType>::destroy_analysis_tools()
 {
+    if (shared_decode_cache_ != nullptr) {
+        VPRINT(this, 1, "Shared decode cache: %" PRIu64 " decodes, %" PRIu64
+               " hits, %" PRIu64 " evictions\n",
+               shared_decode_cache_->get_decode_count(),
+               shared_decode_cache_->get_hit_count(),
+               shared_decode_cache_->get_eviction_count());
+        decode_cache_base_t::set_shared_decode_cache(nullptr);
+    }
     if (!this->success_)
         return;
     for (int i = 0; i < this->num_tools_; i++)
@@ -856,9 +1072,13 @@ analyzer_multi_tmpl_t<RecordType, ReaderType>::get_cache_simulator_knobs()
     knobs->LL_size = op_LL_size.get_value();
     knobs->LL_assoc = op_LL_assoc.get_value();
     knobs->LL_miss_file = op_LL_miss_file.get_value();
+    knobs->LL_sweep = op_LL_sweep.get_value();
     knobs->model_coherence = op_coherence.get_value();
     knobs->replace_policy = op_replace_policy.get_value();
     knobs->data_prefetcher = op_data_prefetcher.get_value();
+    knobs->prefetcher_table_entries = op_prefetcher_table_entries.get_value();
+    knobs->prefetcher_degree = op_prefetcher_degree.get_value();
+    knobs->prefetcher_late_distance = op_prefetcher_late_distance.get_value();
     knobs->skip_refs = op_skip_refs.get_value();
     knobs->warmup_refs = op_warmup_refs.get_value();
     knobs->warmup_fraction = op_warmup_fraction.get_value();
@@ -866,6 +1086,8 @@ analyzer_multi_tmpl_t<RecordType, ReaderType>::get_cache_simulator_knobs()
     knobs->verbose = op_verbose.get_value();
     knobs->cpu_scheduling = op_cpu_scheduling.get_value();
     knobs->use_physical = op_use_physical.get_value();
+    knobs->sim_parallel = op_sim_parallel.get_value();
+    knobs->sim_parallel_batch = op_sim_parallel_batch.get_value();
     return knobs;
 }
 
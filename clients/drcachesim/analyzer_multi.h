@@ -40,6 +40,7 @@
 #include "analyzer.h"
 #include "archive_ostream.h"
 #include "scheduler.h"
+#include "tools/common/decode_cache.h"
 #include "simulator/cache_simulator_create.h"
 
 namespace dynamorio {
@@ -71,6 +72,11 @@ protected:
     std::unique_ptr<ReaderType>
     create_ipc_reader_end();
 
+    // Creates the -ipc_shm file and one reader per ring.  Returns an empty vector
+    // and sets error_string_ on failure.
+    std::vector<typename sched_type_t::input_reader_t>
+    create_shm_ring_readers(const char *name, int verbose);
+
     analysis_tool_tmpl_t<RecordType> *
     create_analysis_tool_from_options(const std::string &type);
 
@@ -98,6 +104,10 @@ protected:
     std::string
     set_input_limit(std::set<memref_tid_t> &only_threads, std::set<int> &only_shards);
 
+    // Reads -instr_intervals_file into this->regions_of_interest_.
+    std::string
+    read_instr_intervals_file(const std::string &path);
+
     std::unique_ptr<std::istream> serial_schedule_file_;
     // This is read in a single stream by invariant_checker and so is not
     // an archive_istream_t.
@@ -107,6 +117,9 @@ protected:
     std::unique_ptr<archive_istream_t> cpu_schedule_zip_;
     std::unique_ptr<archive_ostream_t> record_schedule_zip_;
     std::unique_ptr<archive_istream_t> replay_schedule_zip_;
+    std::unique_ptr<std::istream> sched_resume_file_;
+    // Installed for the tools' decode caches by init_analysis_tools().
+    std::shared_ptr<shared_decode_cache_t> shared_decode_cache_;
 
     static const int max_num_tools_ = 8;
 };
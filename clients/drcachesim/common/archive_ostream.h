@@ -38,6 +38,8 @@
 #ifndef _ARCHIVE_OSTREAM_H_
 #define _ARCHIVE_OSTREAM_H_ 1
 
+#include <stdint.h>
+
 #include <fstream>
 
 namespace dynamorio {
@@ -51,9 +53,18 @@ public:
     }
     // Closes any currently open component and opens a new one.  Future writes are
     // appended to the new component.  Returns an empty string on success or a non-empty
-    // error description on failure.
+    // error description on failure.  Except for zip archives, which require a call
+    // before any writing, the first component is implicitly open: callers writing a
+    // single stream need not call this.
     virtual std::string
     open_new_component(const std::string &name) = 0;
+    // Records the instruction ordinal and most recent timestamp at the start of the
+    // component just opened, for archives that write a chunk index file (see
+    // trace_index.h).  Other archives ignore this.
+    virtual void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp)
+    {
+    }
 };
 
 } // namespace drmemtrace
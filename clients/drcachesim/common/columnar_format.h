@@ -0,0 +1,200 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Definitions for the columnar trace format, shared by columnar_ostream_t and
+ * columnar_file_reader_t.  A columnar file is a sequence of blocks, each holding
+ * up to COLUMNAR_BLOCK_RECORDS trace_entry_t records split into separately
+ * zstd-compressed columns: the types and sizes, the instruction PCs, the data
+ * addresses, and the marker values and other payloads.  Addresses and timestamps
+ * are delta-encoded against predictions from prior records (see
+ * columnar_predictor_t), and every column holds varints, so the deltas of nearby
+ * addresses take few bytes.  A
+ * reader can skip a column it does not need without decompressing it.  Each
+ * archive component starts a new block, so a chunk index can point at any
+ * component.
+ */
+
+#ifndef _COLUMNAR_FORMAT_H_
+#define _COLUMNAR_FORMAT_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// "DRCB": begins every block.
+static const uint32_t COLUMNAR_BLOCK_MAGIC = 0x42435244;
+static const uint32_t COLUMNAR_VERSION = 1;
+// The maximum number of records in a block.
+static const uint32_t COLUMNAR_BLOCK_RECORDS = 64 * 1024;
+
+enum columnar_column_t {
+    // The type and then the size of each record.
+    COLUMNAR_COLUMN_TYPES,
+    // The address of each instruction record, as a delta from the prior one.
+    COLUMNAR_COLUMN_PCS,
+    // The address of each data record, as a delta from its prediction.
+    COLUMNAR_COLUMN_DATA_ADDRS,
+    // The value of each marker, with timestamps as a delta from the prior one,
+    // and the payload of every other record type.
+    COLUMNAR_COLUMN_MARKERS,
+    COLUMNAR_COLUMN_COUNT,
+};
+
+struct columnar_column_header_t {
+    uint32_t compressed_size;
+    uint32_t raw_size;
+};
+
+// Each block starts with this header, in the native byte order of the trace,
+// followed by the compressed contents of each column in order.  A column whose
+// raw size is zero has no compressed contents.  Readers skip any columns past
+// those they know.
+struct columnar_block_header_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t column_count;
+    columnar_column_header_t columns[COLUMNAR_COLUMN_COUNT];
+};
+
+// Tracks the prior values which addresses and timestamps are delta-encoded
+// against.  Each data address is predicted to be the last address of the same
+// operand of the same instruction, which captures strided accesses by loops even
+// when they are interleaved with other accesses.  Writers and readers update it
+// identically, starting afresh at each block.
+class columnar_predictor_t {
+public:
+    columnar_predictor_t()
+        : data_addrs_(1 << DATA_ADDR_TABLE_BITS)
+    {
+    }
+    void
+    reset()
+    {
+        std::fill(data_addrs_.begin(), data_addrs_.end(), 0);
+        pc_ = 0;
+        operand_ = 0;
+        timestamp_ = 0;
+    }
+    // Each accessor returns the slot holding the prediction for the next value
+    // of its kind.  The caller must store the actual value in it.
+    uint64_t &
+    next_pc()
+    {
+        operand_ = 0;
+        return pc_;
+    }
+    uint64_t &
+    next_data_addr()
+    {
+        uint64_t key = (pc_ + operand_++) * 0x9e3779b97f4a7c15ULL;
+        return data_addrs_[key >> (64 - DATA_ADDR_TABLE_BITS)];
+    }
+    uint64_t &
+    next_timestamp()
+    {
+        return timestamp_;
+    }
+
+private:
+    static const int DATA_ADDR_TABLE_BITS = 12;
+    std::vector<uint64_t> data_addrs_;
+    uint64_t pc_ = 0;
+    uint64_t operand_ = 0;
+    uint64_t timestamp_ = 0;
+};
+
+// Returns the column holding the address field of a record of this type.
+static inline columnar_column_t
+columnar_address_column(trace_type_t type)
+{
+    if (is_any_instr_type(type))
+        return COLUMNAR_COLUMN_PCS;
+    if (type_is_data(type))
+        return COLUMNAR_COLUMN_DATA_ADDRS;
+    return COLUMNAR_COLUMN_MARKERS;
+}
+
+static inline void
+columnar_append_varint(std::vector<unsigned char> &column, uint64_t value)
+{
+    while (value >= 0x80) {
+        column.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    column.push_back(static_cast<unsigned char>(value));
+}
+
+// Reads a varint from [*pos, end), advancing *pos.  Returns false if the data
+// ends first or the value overflows.
+static inline bool
+columnar_read_varint(const unsigned char **pos, const unsigned char *end,
+                     uint64_t *value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*pos >= end)
+            return false;
+        unsigned char byte = *(*pos)++;
+        result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Maps signed deltas to unsigned values so small negative deltas stay small.
+static inline uint64_t
+columnar_zigzag_encode(uint64_t delta)
+{
+    return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+}
+
+static inline uint64_t
+columnar_zigzag_decode(uint64_t value)
+{
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _COLUMNAR_FORMAT_H_ */
@@ -0,0 +1,262 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* columnar_ostream_t: an instance of archive_ostream_t that writes the columnar
+ * trace format described in columnar_format.h.  The written bytes must be a
+ * sequence of trace_entry_t records.  Each component starts a new block, and the
+ * block offsets are written to a chunk index file (see trace_index.h).  Component
+ * names are not recorded.
+ */
+
+#ifndef _COLUMNAR_OSTREAM_H_
+#define _COLUMNAR_OSTREAM_H_ 1
+
+#ifndef HAS_ZSTD
+#    error HAS_ZSTD is required
+#endif
+
+#include <string.h>
+
+#include <fstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <zstd.h>
+
+#include "archive_ostream.h"
+#include "columnar_format.h"
+#include "trace_entry.h"
+#include "trace_index.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+class columnar_ostreambuf_t : public std::basic_streambuf<char, std::char_traits<char>> {
+public:
+    columnar_ostreambuf_t(const std::string &path, int level)
+        : level_(level)
+        , index_(path)
+    {
+        cctx_ = ZSTD_createCCtx();
+        if (cctx_ == nullptr)
+            return;
+        file_ = new std::ofstream(path, std::ofstream::binary);
+        src_buf_.resize(buffer_size_);
+        char *base = &src_buf_.front();
+        // We leave an extra slot for extra_char on overflow.
+        setp(base, base + src_buf_.size() - 1);
+    }
+
+    ~columnar_ostreambuf_t() override
+    {
+        if (file_ != nullptr) {
+            sync();
+            write_block();
+            delete file_;
+            file_ = nullptr;
+            index_.write();
+        }
+        ZSTD_freeCCtx(cctx_);
+    }
+
+    bool
+    is_open() const
+    {
+        return file_ != nullptr && *file_;
+    }
+
+    // Ends the current block so that the new component starts a fresh one.
+    std::string
+    open_new_component(const std::string &name)
+    {
+        if (file_ == nullptr)
+            return "File is not open";
+        if (sync() != 0)
+            return "Failed to flush prior component";
+        if (pptr() != pbase())
+            return "Component ends with a partial record";
+        if (!write_block())
+            return "Failed to write prior component";
+        index_.add_chunk(file_offset_);
+        return "";
+    }
+
+    void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp)
+    {
+        index_.set_chunk_start(instr_ordinal, timestamp);
+    }
+
+private:
+    int
+    overflow(int extra_char) override
+    {
+        if (file_ == nullptr)
+            return traits_type::eof();
+        if (extra_char != traits_type::eof()) {
+            *pptr() = traits_type::to_char_type(extra_char);
+            pbump(1);
+        }
+        size_t size = pptr() - pbase();
+        size_t whole = size - size % sizeof(trace_entry_t);
+        for (size_t pos = 0; pos < whole; pos += sizeof(trace_entry_t)) {
+            trace_entry_t entry;
+            memcpy(&entry, pbase() + pos, sizeof(entry));
+            add_record(entry);
+            if (record_count_ >= COLUMNAR_BLOCK_RECORDS && !write_block())
+                return traits_type::eof();
+        }
+        // Keep any partial record for the next write.
+        memmove(pbase(), pbase() + whole, size - whole);
+        setp(pbase(), epptr());
+        pbump(static_cast<int>(size - whole));
+        return traits_type::not_eof(extra_char);
+    }
+
+    int
+    sync() override
+    {
+        return overflow(traits_type::eof()) == traits_type::eof() ? -1 : 0;
+    }
+
+    void
+    add_record(const trace_entry_t &entry)
+    {
+        trace_type_t type = static_cast<trace_type_t>(entry.type);
+        columnar_append_varint(columns_[COLUMNAR_COLUMN_TYPES], entry.type);
+        columnar_append_varint(columns_[COLUMNAR_COLUMN_TYPES], entry.size);
+        uint64_t addr = entry.addr;
+        columnar_column_t column = columnar_address_column(type);
+        uint64_t *predicted = nullptr;
+        if (column == COLUMNAR_COLUMN_PCS)
+            predicted = &predictor_.next_pc();
+        else if (column == COLUMNAR_COLUMN_DATA_ADDRS)
+            predicted = &predictor_.next_data_addr();
+        else if (type == TRACE_TYPE_MARKER && entry.size == TRACE_MARKER_TYPE_TIMESTAMP)
+            predicted = &predictor_.next_timestamp();
+        if (predicted != nullptr) {
+            columnar_append_varint(columns_[column],
+                                   columnar_zigzag_encode(addr - *predicted));
+            *predicted = addr;
+        } else
+            columnar_append_varint(columns_[column], addr);
+        ++record_count_;
+    }
+
+    bool
+    write_block()
+    {
+        if (record_count_ == 0)
+            return true;
+        columnar_block_header_t header = {};
+        header.magic = COLUMNAR_BLOCK_MAGIC;
+        header.version = COLUMNAR_VERSION;
+        header.record_count = record_count_;
+        header.column_count = COLUMNAR_COLUMN_COUNT;
+        for (int i = 0; i < COLUMNAR_COLUMN_COUNT; ++i) {
+            std::vector<unsigned char> &raw = columns_[i];
+            std::vector<char> &dest = compressed_[i];
+            dest.clear();
+            if (!raw.empty()) {
+                dest.resize(ZSTD_compressBound(raw.size()));
+                size_t size = ZSTD_compressCCtx(cctx_, &dest.front(), dest.size(),
+                                                &raw.front(), raw.size(), level_);
+                if (ZSTD_isError(size))
+                    return false;
+                dest.resize(size);
+            }
+            header.columns[i].compressed_size = static_cast<uint32_t>(dest.size());
+            header.columns[i].raw_size = static_cast<uint32_t>(raw.size());
+        }
+        file_->write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file_offset_ += sizeof(header);
+        for (int i = 0; i < COLUMNAR_COLUMN_COUNT; ++i) {
+            if (!compressed_[i].empty())
+                file_->write(&compressed_[i].front(), compressed_[i].size());
+            file_offset_ += compressed_[i].size();
+            columns_[i].clear();
+        }
+        // Each block decodes on its own.
+        predictor_.reset();
+        record_count_ = 0;
+        return static_cast<bool>(*file_);
+    }
+
+    static const int buffer_size_ = 1024 * 1024;
+    std::ofstream *file_ = nullptr;
+    std::vector<char> src_buf_;
+    ZSTD_CCtx *cctx_ = nullptr;
+    int level_;
+    uint32_t record_count_ = 0;
+    columnar_predictor_t predictor_;
+    uint64_t file_offset_ = 0;
+    std::vector<unsigned char> columns_[COLUMNAR_COLUMN_COUNT];
+    std::vector<char> compressed_[COLUMNAR_COLUMN_COUNT];
+    trace_index_writer_t index_;
+};
+
+class columnar_ostream_t : public archive_ostream_t {
+public:
+    explicit columnar_ostream_t(const std::string &path,
+                                int level = ZSTD_CLEVEL_DEFAULT)
+        : archive_ostream_t(new columnar_ostreambuf_t(path, level))
+    {
+        if (!colbuf()->is_open())
+            setstate(std::ios::badbit);
+    }
+    ~columnar_ostream_t() override
+    {
+        delete rdbuf();
+    }
+    std::string
+    open_new_component(const std::string &name) override
+    {
+        return colbuf()->open_new_component(name);
+    }
+    void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp) override
+    {
+        colbuf()->set_component_start(instr_ordinal, timestamp);
+    }
+
+private:
+    columnar_ostreambuf_t *
+    colbuf()
+    {
+        return static_cast<columnar_ostreambuf_t *>(rdbuf());
+    }
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _COLUMNAR_OSTREAM_H_ */
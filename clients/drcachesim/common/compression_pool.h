@@ -0,0 +1,120 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* compression_pool_t: a fixed set of threads shared by many writers to compress
+ * their output in parallel.
+ */
+
+#ifndef _COMPRESSION_POOL_H_
+#define _COMPRESSION_POOL_H_ 1
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// A fixed set of threads which runs queued tasks in any order.
+class compression_pool_t {
+public:
+    // At most "max_tasks" tasks may be queued or running at once, which bounds
+    // the memory held by blocks awaiting compression.
+    compression_pool_t(int num_threads, int max_tasks)
+        : max_tasks_(max_tasks)
+    {
+        for (int i = 0; i < num_threads; ++i)
+            threads_.emplace_back(&compression_pool_t::worker, this);
+    }
+    ~compression_pool_t()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            exiting_ = true;
+        }
+        work_cond_.notify_all();
+        for (std::thread &thread : threads_)
+            thread.join();
+    }
+    int
+    get_thread_count() const
+    {
+        return static_cast<int>(threads_.size());
+    }
+    // Queues "task", first waiting for space if the pool is full.
+    void
+    submit(std::function<void()> task)
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        space_cond_.wait(lock, [this] { return outstanding_ < max_tasks_; });
+        ++outstanding_;
+        tasks_.push_back(std::move(task));
+        lock.unlock();
+        work_cond_.notify_one();
+    }
+
+private:
+    void
+    worker()
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        while (true) {
+            work_cond_.wait(lock, [this] { return exiting_ || !tasks_.empty(); });
+            if (tasks_.empty())
+                return;
+            std::function<void()> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+            --outstanding_;
+            space_cond_.notify_one();
+        }
+    }
+
+    const int max_tasks_;
+    std::mutex lock_;
+    std::condition_variable work_cond_;
+    std::condition_variable space_cond_;
+    std::deque<std::function<void()>> tasks_;
+    int outstanding_ = 0;
+    bool exiting_ = false;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _COMPRESSION_POOL_H_ */
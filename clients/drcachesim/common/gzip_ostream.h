@@ -32,7 +32,10 @@
 
 /* gzip_ostream_t: a wrapper around zlib gzFile to match the parts of the
  * std::ostream interface we use for raw2trace and file_reader_t.
- * Seeking is not supported.
+ * Seeking is not supported.  As an archive_ostream_t, each component after the
+ * first starts a new gzip member, and the member offsets are written to a chunk
+ * index file (see trace_index.h) so that readers can start decompressing at any
+ * component.  The result is still a single valid gzip file.
  */
 
 #ifndef _GZIP_OSTREAM_H_
@@ -42,8 +45,12 @@
 #    error HAS_ZLIB is required
 #endif
 #include <fstream>
+#include <string>
 #include <zlib.h>
 
+#include "archive_ostream.h"
+#include "trace_index.h"
+
 namespace dynamorio {
 namespace drmemtrace {
 
@@ -55,6 +62,7 @@ namespace drmemtrace {
 class gzip_streambuf_t : public std::basic_streambuf<char, std::char_traits<char>> {
 public:
     explicit gzip_streambuf_t(const std::string &path)
+        : index_(path)
     {
         file_ = gzopen(path.c_str(), "wb");
         if (file_ != nullptr) {
@@ -67,8 +75,10 @@ public:
     {
         sync();
         delete[] buf_;
-        if (file_ != nullptr)
+        if (file_ != nullptr) {
             gzclose(file_);
+            index_.write();
+        }
     }
     int
     overflow(int extra_char) override
@@ -86,6 +96,7 @@ public:
                 gzwrite(file_, pbase(), static_cast<unsigned int>(pptr() - pbase()));
             if (len < pptr() - pbase())
                 res = traits_type::eof();
+            member_has_data_ = true;
         }
         setp(buf_, buf_ + buffer_size_ - 1);
         return res;
@@ -95,17 +106,44 @@ public:
     {
         return overflow(traits_type::eof());
     }
+    // Completes the current gzip member so that the new component starts a fresh
+    // one, which needs no prior decompression state to read.
+    std::string
+    open_new_component(const std::string &name)
+    {
+        if (file_ == nullptr)
+            return "File is not open";
+        if (sync() == traits_type::eof())
+            return "Failed to flush prior component";
+        if (member_has_data_) {
+            if (gzflush(file_, Z_FINISH) != Z_OK)
+                return "Failed to end prior gzip member";
+            member_has_data_ = false;
+        }
+        z_off_t offset = gzoffset(file_);
+        if (offset < 0)
+            return "Failed to find the component offset";
+        index_.add_chunk(static_cast<uint64_t>(offset));
+        return "";
+    }
+    void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp)
+    {
+        index_.set_chunk_start(instr_ordinal, timestamp);
+    }
 
 private:
     static const int buffer_size_ = 4096;
     gzFile file_ = nullptr;
     char *buf_ = nullptr;
+    bool member_has_data_ = false;
+    trace_index_writer_t index_;
 };
 
-class gzip_ostream_t : public std::ostream {
+class gzip_ostream_t : public archive_ostream_t {
 public:
     explicit gzip_ostream_t(const std::string &path)
-        : std::ostream(new gzip_streambuf_t(path))
+        : archive_ostream_t(new gzip_streambuf_t(path))
     {
         if (!rdbuf())
             setstate(std::ios::badbit);
@@ -114,6 +152,23 @@ public:
     {
         delete rdbuf();
     }
+    std::string
+    open_new_component(const std::string &name) override
+    {
+        return gzbuf()->open_new_component(name);
+    }
+    void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp) override
+    {
+        gzbuf()->set_component_start(instr_ordinal, timestamp);
+    }
+
+private:
+    gzip_streambuf_t *
+    gzbuf()
+    {
+        return static_cast<gzip_streambuf_t *>(rdbuf());
+    }
 };
 
 } // namespace drmemtrace
@@ -121,6 +121,19 @@ public:
         }
         return gptr() - eback();
     }
+    // Discards buffered data and positions the stream at "offset" in the file,
+    // which must be the start of an lz4 frame.
+    bool
+    seek_to_frame_offset(uint64_t offset)
+    {
+        if (file_ == nullptr || fseek(file_, static_cast<long>(offset), SEEK_SET) != 0)
+            return false;
+        LZ4F_resetDecompressionContext(lzcxt_);
+        src_left_ = 0;
+        cur_src_ = buf_compressed_;
+        setg(buf_uncompressed_, buf_uncompressed_, buf_uncompressed_);
+        return true;
+    }
 
 private:
     static const int buffer_size_ = 1024 * 1024;
@@ -144,6 +157,15 @@ public:
     {
         delete rdbuf();
     }
+    // Clears any error state on success, as a prior read may have hit the end.
+    bool
+    seek_to_frame_offset(uint64_t offset)
+    {
+        if (!static_cast<lz4_istreambuf_t *>(rdbuf())->seek_to_frame_offset(offset))
+            return false;
+        clear();
+        return true;
+    }
 };
 
 } // namespace drmemtrace
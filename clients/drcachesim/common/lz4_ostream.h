@@ -32,6 +32,9 @@
 
 /* lz4_ostream_t: a wrapper around lz4 to match the parts of the
  * std::ostream interface we use for raw2trace and file_reader_t.
+ * As an archive_ostream_t, each component after the first starts a new lz4
+ * frame, and the frame offsets are written to a chunk index file (see
+ * trace_index.h) so that readers can start decompressing at any component.
  */
 
 #ifndef _LZ4_OSTREAM_H_
@@ -43,15 +46,20 @@
 
 #include <array>
 #include <streambuf>
+#include <string>
 #include <vector>
 #include <lz4frame.h>
 
+#include "archive_ostream.h"
+#include "trace_index.h"
+
 namespace dynamorio {
 namespace drmemtrace {
 
 class lz4_ostreambuf_t : public std::basic_streambuf<char, std::char_traits<char>> {
 public:
     lz4_ostreambuf_t(const std::string &path)
+        : index_(path)
     {
         auto res = LZ4F_createCompressionContext(&lzctx_, LZ4F_VERSION);
         if (LZ4F_isError(res)) {
@@ -74,10 +82,38 @@ public:
         if (file_ != nullptr) {
             delete file_;
             file_ = nullptr;
+            index_.write();
         }
         LZ4F_freeCompressionContext(lzctx_);
     }
 
+    // Ends the current frame so that the new component starts a fresh one, which
+    // needs no prior decompression state to read.
+    std::string
+    open_new_component(const std::string &name)
+    {
+        if (file_ == nullptr)
+            return "File is not open";
+        if (sync() == traits_type::eof())
+            return "Failed to flush prior component";
+        if (frame_has_data_) {
+            write_footer();
+            frame_start_ = file_->tellp();
+            write_header();
+            frame_has_data_ = false;
+        }
+        if (!*file_ || frame_start_ < 0)
+            return "Failed to start a new lz4 frame";
+        index_.add_chunk(static_cast<uint64_t>(frame_start_));
+        return "";
+    }
+
+    void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp)
+    {
+        index_.set_chunk_start(instr_ordinal, timestamp);
+    }
+
 private:
     int
     overflow(int extra_char) override
@@ -92,6 +128,8 @@ private:
 
         int size = static_cast<int>(pptr() - pbase());
         pbump(-size);
+        if (size > 0)
+            frame_has_data_ = true;
         auto ret = LZ4F_compressUpdate(lzctx_, &dest_buf_.front(), dest_buf_.capacity(),
                                        pbase(), size, nullptr);
         if (LZ4F_isError(ret)) {
@@ -136,12 +174,16 @@ private:
     std::array<char, buffer_size_> src_buf_;
     std::vector<char> dest_buf_;
     LZ4F_compressionContext_t lzctx_ = nullptr;
+    // The file offset of the current frame's header.
+    std::streamoff frame_start_ = 0;
+    bool frame_has_data_ = false;
+    trace_index_writer_t index_;
 };
 
-class lz4_ostream_t : public std::ostream {
+class lz4_ostream_t : public archive_ostream_t {
 public:
     explicit lz4_ostream_t(const std::string &path)
-        : std::ostream(new lz4_ostreambuf_t(path))
+        : archive_ostream_t(new lz4_ostreambuf_t(path))
     {
         if (!rdbuf())
             setstate(std::ios::badbit);
@@ -151,6 +193,25 @@ public:
     {
         delete rdbuf();
     }
+
+    std::string
+    open_new_component(const std::string &name) override
+    {
+        return lz4buf()->open_new_component(name);
+    }
+
+    void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp) override
+    {
+        lz4buf()->set_component_start(instr_ordinal, timestamp);
+    }
+
+private:
+    lz4_ostreambuf_t *
+    lz4buf()
+    {
+        return static_cast<lz4_ostreambuf_t *>(rdbuf());
+    }
 };
 
 } // namespace drmemtrace
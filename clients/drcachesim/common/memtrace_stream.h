@@ -120,6 +120,24 @@ public:
          * Counts the instances when the kernel syscall sequences were injected.
          */
         SCHED_STAT_KERNEL_SYSCALL_SEQUENCE_INJECTIONS,
+        /**
+         * Counts the number of times an input started running on this output after
+         * last running on an output on a different physical core, per the
+         * scheduler's output topology.
+         */
+        SCHED_STAT_MIGRATIONS_CROSS_CORE,
+        /**
+         * Counts the number of times an input started running on this output after
+         * last running on an output in a different last-level cache domain.
+         * This is a subset of #SCHED_STAT_MIGRATIONS_CROSS_CORE.
+         */
+        SCHED_STAT_MIGRATIONS_CROSS_LLC,
+        /**
+         * Counts the number of times an input started running on this output after
+         * last running on an output on a different node.  This is a subset of
+         * #SCHED_STAT_MIGRATIONS_CROSS_LLC.
+         */
+        SCHED_STAT_MIGRATIONS_CROSS_NODE,
         /** Count of statistic types. */
         SCHED_STAT_TYPE_COUNT,
     };
@@ -69,6 +69,28 @@ droption_t<std::string> op_ipc_name(
     "for each instance of the simulator being run at any one time.  On Windows, the name "
     "is limited to 247 characters.");
 
+droption_t<bool> op_ipc_shm(
+    DROPTION_SCOPE_ALL, "ipc_shm", false, "Use shared-memory rings for online tracing",
+    "Linux-only.  For online tracing, replaces the named pipe with a shared-memory file "
+    "in /dev/shm derived from -ipc_name.  Each traced thread writes to its own ring, "
+    "sleeping only when the ring is full, and the analyzer consumes the rings in "
+    "parallel with one worker per ring, so all tools must support parallel shards.  "
+    "Once a thread exits and its data is consumed, its ring is reused by a later "
+    "thread, so a shard holds a sequence of threads.  The number of rings set by "
+    "-ipc_shm_rings is the maximum number of threads that can be traced at once, and "
+    "threads started while all rings are in use are left untraced with a warning.");
+
+droption_t<unsigned int> op_ipc_shm_rings(
+    DROPTION_SCOPE_FRONTEND, "ipc_shm_rings", 32, "Number of -ipc_shm rings",
+    "The number of rings, and thus of simultaneously traced threads, supported by "
+    "-ipc_shm.  The analyzer uses one worker per ring.");
+
+droption_t<bytesize_t> op_ipc_shm_ring_size(
+    DROPTION_SCOPE_FRONTEND, "ipc_shm_ring_size", 1 * 1024 * 1024,
+    "Size of each -ipc_shm ring",
+    "The size of the data area of each -ipc_shm ring, which must be a power of two.  "
+    "The full size of all rings is reserved in /dev/shm up front.");
+
 droption_t<std::string> op_outdir(
     DROPTION_SCOPE_ALL, "outdir", ".", "Target directory for offline trace files",
     "For the offline analysis mode (when -offline is requested), specifies the path "
@@ -126,6 +148,21 @@ droption_t<int> op_jobs(
     "with a cap of 16.  This is ignored for -core_sharded where -cores sets the "
     "parallelism.");
 
+droption_t<int> op_zip_read_ahead(
+    DROPTION_SCOPE_FRONTEND, "zip_read_ahead", 0,
+    "Chunks of each .zip input to decompress ahead of analysis",
+    "When analyzing .zip trace files, this many chunks of each input are decompressed "
+    "in the background by a shared pool of -zip_read_ahead_threads threads, so that "
+    "analysis threads do not wait on decompression.  Decompressed chunks are held in "
+    "memory in their entirety, with at most -zip_read_ahead times "
+    "-zip_read_ahead_threads chunks held across all inputs.  0 disables read-ahead.");
+
+droption_t<int> op_zip_read_ahead_threads(
+    DROPTION_SCOPE_FRONTEND, "zip_read_ahead_threads", -1,
+    "Threads decompressing .zip chunks for -zip_read_ahead",
+    "The number of background threads used for -zip_read_ahead.  A negative value "
+    "sets the count to the number of hardware threads, with a cap of 16.");
+
 droption_t<std::string> op_module_file(
     DROPTION_SCOPE_ALL, "module_file", "", "Path to modules.log for opcode_mix tool",
     "The opcode_mix tool needs the modules.log file (generated by the offline "
@@ -139,6 +176,31 @@ droption_t<std::string> op_alt_module_dir(
     "analysis tools, or in the raw modules file for post-prcoessing of offline "
     "raw trace files.  This directory takes precedence over the recorded path.");
 
+droption_t<uint64_t> op_decode_cache_entries(
+    DROPTION_SCOPE_FRONTEND, "decode_cache_entries", 1 << 18,
+    "Maximum decoded instructions shared across tools and shards",
+    "Analysis tools that decode instructions, such as opcode_mix and "
+    "invariant_checker, share a single cache of decoded instructions keyed by "
+    "encoding, pc, and ISA mode, so that each unique instruction is decoded once "
+    "rather than once per tool per shard.  This bounds the number of instructions it "
+    "holds, past which those not recently used are evicted.  A value of 0 disables "
+    "the sharing.");
+
+droption_t<std::string> op_analysis_cache_dir(
+    DROPTION_SCOPE_FRONTEND, "analysis_cache_dir", "",
+    "Directory for saved per-input analysis state",
+    "If non-empty, names an existing directory where the final state of each "
+    "thread-sharded input is saved, keyed by a hash of the selected tools' options "
+    "and checked against the input file's size, modification time, and a hash of its "
+    "first, middle, and last 64KiB.  A later analysis skips each input whose state "
+    "was saved and merges the saved state with the results for the other inputs, so "
+    "that re-running after new threads are added to a trace directory only analyzes "
+    "the new ones.  Every selected tool must support saving its shard state, and "
+    "the analysis must be parallel, thread-sharded, and cover whole inputs: this "
+    "cannot be combined with interval analysis, -skip_instrs, -skip_to_timestamp, "
+    "-instr_intervals_file, -only_thread, -only_threads, or -only_shards.  The "
+    "directory should not be inside the trace directory.");
+
 droption_t<bytesize_t> op_chunk_instr_count(
     DROPTION_SCOPE_FRONTEND, "chunk_instr_count", bytesize_t(10 * 1000 * 1000U),
     // We do not support tiny chunks.  We do not support disabling chunks with a 0
@@ -232,6 +294,20 @@ droption_t<std::string> op_LL_miss_file(
     "based on the miss analysis be written to the specified file. Each hint is written "
     "in text format as a <program counter, stride, locality level> tuple.");
 
+droption_t<std::string> op_LL_sweep(
+    DROPTION_SCOPE_FRONTEND, "LL_sweep", "",
+    "Additional last-level cache configurations to simulate",
+    "A comma-separated list of last-level cache configurations to simulate alongside "
+    "the one given by -LL_size and -LL_assoc, in the same pass over the trace.  Each "
+    "entry is a size with an optional K, M, or G suffix, optionally followed by a colon "
+    "and an associativity which otherwise defaults to -LL_assoc: for example, "
+    "\"4M:8,8M,16M:32\".  Hit and miss counts for each configuration are printed after "
+    "the regular results.  With the LRU replacement policy, configurations with the "
+    "same number of sets share a single stack-distance computation.  Since the last-"
+    "level cache does not affect the L1 caches in this hierarchy, each configuration "
+    "sees exactly the requests it would see in its own run.  This is not supported "
+    "with -cache_config_file.");
+
 droption_t<bool> op_L0_filter_deprecated(
     DROPTION_SCOPE_CLIENT, "L0_filter", false,
     "Filter out first-level instruction and data cache hits during tracing",
@@ -426,25 +502,68 @@ droption_t<std::string> op_raw_compress(
     // All other choices are slowdowns for an SSD so we turn them off by default.
     "none",
 #endif
-    "Raw compression: \"snappy\",\"snappy_nocrc\",\"gzip\",\"zlib\",\"lz4\",\"none\"",
+    "Raw compression: "
+    "\"snappy\",\"snappy_nocrc\",\"gzip\",\"zlib\",\"lz4\",\"zstd\",\"none\"",
     "Specifies the compression type to use for raw offline files: \"snappy\", "
     "\"snappy_nocrc\" (snappy without checksums, which is much faster), \"gzip\", "
-    "\"zlib\", \"lz4\", or \"none\".  Whether this reduces overhead depends on the "
-    "storage type: "
+    "\"zlib\", \"lz4\", \"zstd\", or \"none\".  Whether this reduces overhead "
+    "depends on the storage type: "
     "for an SSD, zlib and gzip typically add overhead and would only be used if space is "
-    "at a premium; snappy_nocrc and lz4 are nearly always performance wins.");
+    "at a premium; snappy_nocrc and lz4 are nearly always performance wins.  zstd at "
+    "its low levels (see -raw_compress_level) compresses much better than lz4 at a "
+    "moderate cost.");
+
+droption_t<int> op_raw_compress_level(
+    DROPTION_SCOPE_CLIENT, "raw_compress_level", 1,
+    "Compression level for -raw_compress zstd",
+    "The zstd compression level for raw offline files with -raw_compress zstd.  "
+    "Negative levels trade ratio for speed; 0 selects zstd's default level.");
+
+droption_t<unsigned int> op_raw_output_threads(
+    DROPTION_SCOPE_CLIENT, "raw_output_threads", 0,
+    "Threads that compress and write raw offline files",
+    "If non-zero, each full per-thread buffer of -offline trace data is handed to one "
+    "of this many background threads, which apply -raw_compress and write the data "
+    "to the thread's raw file, rather than being written by the application thread "
+    "that filled it.  The application thread swaps in a clean buffer without "
+    "locking, and only blocks when -raw_output_max_buffers buffers are already "
+    "waiting to be written.  Any replacement file writing function passed to "
+    "drmemtrace_replace_file_ops() is then called from the background threads.  "
+    "This is ignored if drmemtrace_buffer_handoff() is used, and a child process "
+    "created by fork writes its buffers synchronously.");
+
+droption_t<unsigned int> op_raw_output_max_buffers(
+    DROPTION_SCOPE_CLIENT, "raw_output_max_buffers", 64,
+    "Cap on buffers waiting for -raw_output_threads",
+    "The maximum number of full trace buffers waiting for the -raw_output_threads "
+    "threads at any one time, across all application threads.  This bounds the extra "
+    "memory used for asynchronous output, as each buffer holds 4096 trace entries "
+    "plus a redzone.");
 
 droption_t<std::string> op_trace_compress(
     DROPTION_SCOPE_FRONTEND, "compress", DEFAULT_TRACE_COMPRESSION_TYPE,
-    "Trace compression: \"zip\",\"gzip\",\"zlib\",\"lz4\",\"none\"",
+    "Trace compression: \"zip\",\"gzip\",\"zlib\",\"lz4\",\"zstd\",\"columnar\","
+    "\"none\"",
     "Specifies the compression type to use for trace files: \"zip\", "
-    "\"gzip\", \"zlib\", \"lz4\", or \"none\". "
+    "\"gzip\", \"zlib\", \"lz4\", \"zstd\", \"columnar\", or \"none\". "
     "In most cases where fast skipping by instruction count is not needed "
     "lz4 compression generally improves performance and is recommended. "
+    "zstd supports fast skipping like zip, as each chunk is a separately seekable "
+    "frame, with a better ratio and faster decompression. "
+    "columnar stores the record types, instruction addresses, data addresses, and "
+    "marker values as separately zstd-compressed delta-encoded columns, which "
+    "compresses better still and lets tools that ignore data addresses skip "
+    "decompressing them. "
     "When it comes to storage types, the impact on overhead varies: "
     "for SSDs, zip and gzip often increase overhead and should only be chosen "
     "if space is limited.");
 
+droption_t<int> op_trace_compress_level(
+    DROPTION_SCOPE_FRONTEND, "compress_level", 0,
+    "Compression level for -compress zstd or columnar",
+    "The zstd compression level for trace files with -compress zstd or columnar.  "
+    "Negative levels trade ratio for speed; 0 selects zstd's default level.");
+
 droption_t<bool> op_online_instr_types(
     DROPTION_SCOPE_CLIENT, "online_instr_types", false,
     "Whether online traces should distinguish instr types",
@@ -454,18 +573,57 @@ droption_t<bool> op_online_instr_types(
 
 droption_t<std::string> op_replace_policy(
     DROPTION_SCOPE_FRONTEND, "replace_policy", REPLACE_POLICY_LRU,
-    "Cache replacement policy (LRU, LFU, FIFO)",
+    "Cache replacement policy (LRU, LFU, FIFO, SRRIP, BRRIP, DRRIP, SHIP, HAWKEYE)",
     "Specifies the replacement policy for "
     "caches. Supported policies: LRU (Least Recently Used), LFU (Least Frequently Used), "
-    "FIFO (First-In-First-Out).");
+    "FIFO (First-In-First-Out), SRRIP (Static Re-Reference Interval Prediction), "
+    "BRRIP (Bimodal RRIP, which resists scans), DRRIP (Dynamic RRIP, which picks "
+    "between SRRIP and BRRIP by set dueling), SHIP (Signature-based Hit Predictor: "
+    "SRRIP with the insertion position predicted from the PC), and HAWKEYE (which "
+    "learns from a reconstruction of Belady's optimal policy on sampled sets which "
+    "PCs load lines worth caching).");
 
 droption_t<std::string> op_data_prefetcher(
     DROPTION_SCOPE_FRONTEND, "data_prefetcher", PREFETCH_POLICY_NEXTLINE,
-    "Hardware data prefetcher policy (nextline, none)",
+    "Hardware data prefetcher policy (nextline, stride, stream, sms, none)",
     "Specifies the hardware data "
     "prefetcher policy.  The currently supported policies are 'nextline' (fetch the "
-    "subsequent cache line) and 'none' (disables hardware prefetching).  The prefetcher "
-    "is located between the L1D and LL caches.");
+    "subsequent cache line), 'stride' (a PC-indexed table that detects a constant "
+    "stride in lines between consecutive accesses by the same instruction), 'stream' "
+    "(a table of ascending or descending streams of lines within a 4K page), 'sms' "
+    "(spatial memory streaming: records which lines of each 2K region are touched and "
+    "replays that footprint on the next access to a new region by the same "
+    "instruction at the same offset), and 'none' (disables hardware prefetching).  The "
+    "prefetcher is located between the L1D and LL caches.  The 'stride', 'stream', "
+    "and 'sms' prefetchers are sized by -prefetcher_table_entries and "
+    "-prefetcher_degree, and they add prefetch usefulness, lateness, accuracy, and "
+    "coverage statistics to the cache results.");
+
+droption_t<unsigned int> op_prefetcher_table_entries(
+    DROPTION_SCOPE_FRONTEND, "prefetcher_table_entries", 0,
+    "Entries in the hardware prefetcher table",
+    "For the 'stride', 'stream', and 'sms' values of -data_prefetcher, the number of "
+    "entries in the prefetcher's table: instructions tracked for 'stride', streams "
+    "tracked for 'stream', and footprints remembered for 'sms'.  0 selects the "
+    "default of 256, 32, and 2048 respectively.");
+
+droption_t<unsigned int> op_prefetcher_degree(
+    DROPTION_SCOPE_FRONTEND, "prefetcher_degree", 0,
+    "Lines fetched per hardware prefetcher trigger",
+    "For the 'stride', 'stream', and 'sms' values of -data_prefetcher, the maximum "
+    "number of lines prefetched per access: how many strides ahead for 'stride', how "
+    "many lines ahead of the access for 'stream', and how many lines of the footprint "
+    "for 'sms'.  0 selects the default of 4 for 'stride' and 'stream' and the whole "
+    "footprint for 'sms'.");
+
+droption_t<unsigned int> op_prefetcher_late_distance(
+    DROPTION_SCOPE_FRONTEND, "prefetcher_late_distance", 32,
+    "Demand accesses within which a prefetch is late",
+    "The cache simulator does not model latency, so for the 'stride', 'stream', and "
+    "'sms' values of -data_prefetcher, a useful prefetch is counted as late when its "
+    "line's first demand use comes within this many demand accesses to the same cache "
+    "after the prefetch.  This approximates a prefetch that would still have been in "
+    "flight.  0 disables lateness tracking.");
 
 droption_t<bytesize_t> op_page_size(DROPTION_SCOPE_FRONTEND, "page_size",
                                     bytesize_t(4 * 1024), "Virtual/physical page size",
@@ -652,6 +810,19 @@ droption_t<uint64_t> op_skip_to_timestamp(
     "records will not appear to analysis tools; however, their contants can be obtained "
     "from #dynamorio::drmemtrace::memtrace_stream_t API accessors.");
 
+droption_t<std::string> op_instr_intervals_file(
+    DROPTION_SCOPE_FRONTEND, "instr_intervals_file", "",
+    "File of instruction intervals to analyze",
+    "Path to a file of instruction intervals to analyze, in the format of the tracer's "
+    "-trace_instr_intervals_file: one \"start,duration\" line per interval, where "
+    "start is the count of instructions to skip and any further comma-separated "
+    "fields are ignored.  Overlapping and adjacent intervals are merged.  The "
+    "simpoint tool's -simpoint_output_file is in this format.  The intervals count "
+    "the instructions of a single input, so this requires a single-threaded trace or "
+    "the use of -only_thread to select one thread.  Each interval after the "
+    "first is preceded by a #dynamorio::drmemtrace::TRACE_MARKER_TYPE_WINDOW_ID "
+    "marker.  This cannot be combined with -skip_instrs or -skip_to_timestamp.");
+
 droption_t<bytesize_t> op_L0_filter_until_instrs(
     DROPTION_SCOPE_CLIENT, "L0_filter_until_instrs", 0,
     "Number of instructions for warmup trace",
@@ -701,6 +872,28 @@ droption_t<bytesize_t> op_sim_refs(
     "all the records and it is the tool who is ignoring those outside of this range, a "
     "large trace may still take time even with a small value for this option.");
 
+droption_t<bool> op_sim_parallel(
+    DROPTION_SCOPE_FRONTEND, "sim_parallel", false,
+    "Simulate each core's caches on its own thread",
+    "Applies to the cache simulator in -core_sharded mode.  Each core's private caches "
+    "are simulated on a separate worker thread while accesses to shared caches are "
+    "queued and applied at a barrier across all cores every -sim_parallel_batch "
+    "records.  The queued accesses are applied in the same order as -core_serial would "
+    "apply them, so results match -core_serial exactly when the schedule has no waits "
+    "(such as with -cpu_schedule_file or -replay_file).  Since a shared cache sees the "
+    "private caches of other cores up to one batch ahead, configurations where shared "
+    "caches reach back into private caches are rejected: -sim_parallel is not "
+    "compatible with -coherence or with inclusive or exclusive shared caches.  Nor is "
+    "it compatible with -skip_refs, -warmup_refs, -warmup_fraction, -sim_refs, or "
+    "-use_physical.");
+
+droption_t<bytesize_t> op_sim_parallel_batch(
+    DROPTION_SCOPE_FRONTEND, "sim_parallel_batch", 4096,
+    "Records per core between shared cache updates",
+    "For -sim_parallel, the number of records each core processes between barriers "
+    "where the queued shared cache accesses are applied.  Larger values reduce "
+    "synchronization overhead at the cost of memory for the queued accesses.");
+
 droption_t<std::string>
     op_view_syntax(DROPTION_SCOPE_FRONTEND, "view_syntax", "att/arm/dr/riscv",
                    "Syntax to use for disassembly.",
@@ -731,6 +924,19 @@ droption_t<unsigned int>
                   "Number of top results to be reported",
                   "Specifies the number of top results to be reported.");
 
+droption_t<bool> op_sketch_mode(
+    DROPTION_SCOPE_FRONTEND, "sketch_mode", false,
+    "Use mergeable probabilistic summaries in place of exact per-shard sets",
+    "For the histogram, reuse_time, and basic_counts tools, replaces the exact "
+    "per-shard sets of cache lines, reuse times, and instruction addresses with "
+    "fixed-size summaries that are cheap to merge across shards and intervals: "
+    "HyperLogLog for unique counts (about 1.6% standard error), a Count-Min sketch "
+    "for the -report_top most frequent cache lines, and a DDSketch-style sketch "
+    "for reuse time quantiles (1% relative error).  Unique instruction counts are "
+    "then also kept in interval snapshots, as cumulative estimates.  The reuse_time "
+    "tool still needs each line's last access time, so only its histogram is "
+    "bounded.");
+
 // XXX: if we separate histogram + reuse_distance we should move these with them.
 droption_t<unsigned int> op_reuse_distance_threshold(
     DROPTION_SCOPE_FRONTEND, "reuse_distance_threshold", 100,
@@ -759,7 +965,8 @@ droption_t<unsigned int> op_reuse_distance_limit(
 droption_t<bool> op_reuse_verify_skip(
     DROPTION_SCOPE_FRONTEND, "reuse_verify_skip", false,
     "Use full list walks to verify the skip list results.",
-    "Verifies every skip list-calculated reuse distance with a full list walk. "
+    "Verifies every skip list-calculated (or, with -reuse_tree, tree-calculated) reuse "
+    "distance with a full list walk. "
     "This incurs significant additional overhead.  This option is only available "
     "in debug builds.");
 droption_t<double> op_reuse_histogram_bin_multiplier(
@@ -773,6 +980,24 @@ droption_t<double> op_reuse_histogram_bin_multiplier(
     "bins.  Note that this option only affects the printing of histograms via "
     "the -reuse_distance_histogram option; the raw histogram data is always "
     "collected at full precision.");
+droption_t<bool> op_reuse_tree(
+    DROPTION_SCOPE_FRONTEND, "reuse_tree", false,
+    "Compute reuse distances with an order-statistic tree.",
+    "Computes each reuse distance in time logarithmic in the number of distinct cache "
+    "lines, using a Fenwick tree over access order, instead of walking the skip list "
+    "whose cost grows linearly with the distance.  This is much faster for traces with "
+    "large working sets.  The results are identical.  -reuse_skip_dist is ignored.");
+droption_t<double> op_reuse_sample_rate(
+    DROPTION_SCOPE_FRONTEND, "reuse_sample_rate", 1.0,
+    "Fraction of cache lines to track for approximate reuse distances.",
+    "If less than 1, only this fraction of the cache lines, selected by a hash of the "
+    "line address, is tracked, as in the SHARDS technique.  All accesses to a tracked "
+    "line are seen, and each reuse distance is the distance among the tracked lines "
+    "scaled by the inverse of the rate, so the histogram approximates the full one "
+    "while time and memory shrink with the rate.  The error shrinks as the number of "
+    "tracked lines grows: rates of 0.01 or even 0.001 work well for traces touching "
+    "many millions of lines.  The -reuse_distance_threshold is scaled as well, while "
+    "-reuse_distance_limit applies to the tracked lines.");
 
 #define OP_RECORD_FUNC_ITEM_SEP "&"
 // XXX i#3048: replace function return address with function callstack
@@ -1064,6 +1289,32 @@ droption_t<std::string> op_sched_syscall_file(
     "TRACE_MARKER_TYPE_SYSCALL_TRACE_START and TRACE_MARKER_TYPE_SYSCALL_TRACE_END "
     "markers.");
 
+droption_t<uint64_t> op_sched_stop_after_instrs(
+    DROPTION_SCOPE_FRONTEND, "sched_stop_after_instrs", 0,
+    "Stop all cores after this many total instructions",
+    "Applies to -core_sharded and -core_serial.  If non-zero, the scheduler stops all "
+    "cores once they have collectively executed this many instructions (counting any "
+    "instructions executed before a -sched_resume_file checkpoint), leaving the rest of "
+    "the schedule in place to be saved with -sched_checkpoint_file.");
+
+droption_t<std::string> op_sched_checkpoint_file(
+    DROPTION_SCOPE_FRONTEND, "sched_checkpoint_file", "",
+    "Path for storing a checkpoint of the schedule",
+    "Applies to -core_sharded and -core_serial.  At the end of the run, the complete "
+    "scheduler state (input positions, run queues, blocked times, and core "
+    "assignments) is written to this path.  It is typically combined with "
+    "-sched_stop_after_instrs.  A later run with the same trace and scheduling options "
+    "can pass the file to -sched_resume_file to continue from that point.");
+
+droption_t<std::string> op_sched_resume_file(
+    DROPTION_SCOPE_FRONTEND, "sched_resume_file", "",
+    "Path with a schedule checkpoint to resume from",
+    "Applies to -core_sharded and -core_serial.  Resumes the schedule from a checkpoint "
+    "written by -sched_checkpoint_file, with each input seeking directly to its "
+    "checkpointed position, rather than scheduling from the start of the trace.  The "
+    "same trace and scheduling options must be passed as for the run that wrote the "
+    "checkpoint.");
+
 droption_t<bool> op_sched_randomize(
     DROPTION_SCOPE_FRONTEND, "sched_randomize", false,
     "Pick next inputs randomly on context switches",
@@ -1109,6 +1360,28 @@ droption_t<uint64_t> op_sched_rebalance_period_us(
     "The period in simulated microseconds at which per-core run queues are re-balanced "
     "to redistribute load.");
 
+droption_t<bool> op_sched_work_stealing(
+    DROPTION_SCOPE_ALL, "sched_work_stealing", false,
+    "Balance core run queues by work stealing instead of periodic rebalancing",
+    "Applies to -core_sharded and -core_serial.  Idle cores repeatedly try to steal "
+    "inputs from other cores' run queues, skipping empty queues without locking them "
+    "and never waiting on a contended queue lock.  The periodic rebalancing of "
+    "-sched_rebalance_period_us is disabled.  This reduces lock contention when "
+    "simulating large core counts.");
+
+droption_t<std::string> op_sched_topology(
+    DROPTION_SCOPE_FRONTEND, "sched_topology", "",
+    "Cache topology of the simulated cores: NODESxLLCSxCORESxTHREADS",
+    "Applies to -core_sharded and -core_serial.  Describes the simulated machine as "
+    "the number of nodes (sockets) times the number of last-level cache domains per "
+    "node times the number of physical cores per cache domain times the number of SMT "
+    "threads per core: e.g., \"2x2x4x2\" for 32 cores.  The product must equal "
+    "-cores.  Cores are numbered consecutively within each level, so cores 0 and 1 are "
+    "SMT siblings in that example.  When stealing from or rebalancing run queues, the "
+    "scheduler then prefers to keep inputs on the same physical core, then in the same "
+    "cache domain, then on the same node.  The schedule_stats tool reports migrations "
+    "across each level.");
+
 droption_t<double> op_sched_exit_if_fraction_inputs_left(
     DROPTION_SCOPE_FRONTEND, "sched_exit_if_fraction_inputs_left", 0.1,
     "Exit if non-EOF inputs left are <= this fraction of the total",
@@ -1133,6 +1406,26 @@ droption_t<uint64_t>
                                   500000, "A letter is printed every N instrs",
                                   "A letter is printed every N instrs or N waits");
 
+// SimPoint options.
+droption_t<unsigned int> op_simpoint_max_k(
+    DROPTION_SCOPE_FRONTEND, "simpoint_max_k", 30, "Maximum number of SimPoint clusters",
+    "For the simpoint tool, the largest number of clusters to consider.  The smallest "
+    "cluster count whose clustering score is within 90% of the best is selected.");
+
+droption_t<unsigned int> op_simpoint_dimensions(
+    DROPTION_SCOPE_FRONTEND, "simpoint_dimensions", 15,
+    "Dimensions to project basic block vectors onto",
+    "For the simpoint tool, the number of dimensions that each interval's basic block "
+    "vector is randomly projected onto before clustering.");
+
+droption_t<std::string> op_simpoint_output_file(
+    DROPTION_SCOPE_FRONTEND, "simpoint_output_file", "",
+    "Output file for the selected SimPoint intervals",
+    "For the simpoint tool, a file to write the selected intervals to, one "
+    "\"start,duration,weight\" line per interval.  This can be passed directly to "
+    "the tracer's -trace_instr_intervals_file or to the analyzer's "
+    "-instr_intervals_file.");
+
 droption_t<std::string> op_syscall_template_file(
     DROPTION_SCOPE_FRONTEND, "syscall_template_file", "",
     "Path to the file that contains system call trace templates.",
@@ -1201,6 +1494,20 @@ droption_t<std::string> op_modify_marker_value(
     "sets all TRACE_MARKER_TYPE_CPU_ID == 3 in the trace to core 24 and "
     "TRACE_MARKER_TYPE_PAGE_SIZE == 18 to 2k.");
 
+/* XXX i#6369: we should partition our options by tool. This one should belong to the
+ * record_filter partition. For now we add the filter_ prefix to options that should be
+ * used in conjunction with record_filter.
+ */
+droption_t<int> op_filter_output_threads(
+    DROPTION_SCOPE_FRONTEND, "filter_output_threads", 0,
+    "Threads for compressing and writing record_filter output.",
+    "This option is for -tool " RECORD_FILTER ". When non-zero, the filtered "
+    "records of every shard are handed in blocks to a pool of this many threads which "
+    "compress them in parallel, and the blocks are then assembled into each output "
+    "file in order.  This keeps output compression from limiting each shard to one "
+    "thread's deflate speed.  The output format is unchanged.  When 0, each shard "
+    "compresses and writes its own output.  Requires zlib support.");
+
 droption_t<uint64_t> op_trim_before_timestamp(
     DROPTION_SCOPE_ALL, "trim_before_timestamp", 0, 0,
     (std::numeric_limits<uint64_t>::max)(),
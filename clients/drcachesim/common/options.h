@@ -53,6 +53,7 @@
 #define INVARIANT_CHECKER "invariant_checker"
 #define SCHEDULE_STATS "schedule_stats"
 #define RECORD_FILTER "record_filter"
+#define SIMPOINT "simpoint"
 
 // Constants used by specific tools.
 #define REPLACE_POLICY_NON_SPECIFIED ""
@@ -60,9 +61,17 @@
 #define REPLACE_POLICY_BIT_PLRU "BIT_PLRU"
 #define REPLACE_POLICY_LFU "LFU"
 #define REPLACE_POLICY_FIFO "FIFO"
+#define REPLACE_POLICY_SRRIP "SRRIP"
+#define REPLACE_POLICY_BRRIP "BRRIP"
+#define REPLACE_POLICY_DRRIP "DRRIP"
+#define REPLACE_POLICY_SHIP "SHIP"
+#define REPLACE_POLICY_HAWKEYE "HAWKEYE"
 #define PREFETCH_POLICY_NEXTLINE "nextline"
 #define PREFETCH_POLICY_NONE "none"
 #define PREFETCH_POLICY_CUSTOM "custom"
+#define PREFETCH_POLICY_STRIDE "stride"
+#define PREFETCH_POLICY_STREAM "stream"
+#define PREFETCH_POLICY_SMS "sms"
 #define CACHE_TYPE_INSTRUCTION "instruction"
 #define CACHE_TYPE_DATA "data"
 #define CACHE_TYPE_UNIFIED "unified"
@@ -92,6 +101,10 @@ namespace drmemtrace {
 
 extern dynamorio::droption::droption_t<bool> op_offline;
 extern dynamorio::droption::droption_t<std::string> op_ipc_name;
+extern dynamorio::droption::droption_t<bool> op_ipc_shm;
+extern dynamorio::droption::droption_t<unsigned int> op_ipc_shm_rings;
+extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t>
+    op_ipc_shm_ring_size;
 extern dynamorio::droption::droption_t<std::string> op_outdir;
 extern dynamorio::droption::droption_t<std::string> op_subdir_prefix;
 extern dynamorio::droption::droption_t<std::string> op_infile;
@@ -99,6 +112,8 @@ extern dynamorio::droption::droption_t<std::string> op_indir;
 extern dynamorio::droption::droption_t<std::string> op_multi_indir;
 extern dynamorio::droption::droption_t<std::string> op_module_file;
 extern dynamorio::droption::droption_t<std::string> op_alt_module_dir;
+extern dynamorio::droption::droption_t<uint64_t> op_decode_cache_entries;
+extern dynamorio::droption::droption_t<std::string> op_analysis_cache_dir;
 extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t>
     op_chunk_instr_count;
 extern dynamorio::droption::droption_t<bool> op_instr_encodings;
@@ -112,6 +127,7 @@ extern dynamorio::droption::droption_t<unsigned int> op_L1D_assoc;
 extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t> op_LL_size;
 extern dynamorio::droption::droption_t<unsigned int> op_LL_assoc;
 extern dynamorio::droption::droption_t<std::string> op_LL_miss_file;
+extern dynamorio::droption::droption_t<std::string> op_LL_sweep;
 extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t> op_L0I_size;
 extern dynamorio::droption::droption_t<bool> op_L0_filter_deprecated;
 extern dynamorio::droption::droption_t<bool> op_L0I_filter;
@@ -140,10 +156,17 @@ extern dynamorio::droption::droption_t<bool> op_split_windows;
 extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t>
     op_exit_after_tracing;
 extern dynamorio::droption::droption_t<std::string> op_raw_compress;
+extern dynamorio::droption::droption_t<int> op_raw_compress_level;
+extern dynamorio::droption::droption_t<unsigned int> op_raw_output_threads;
+extern dynamorio::droption::droption_t<unsigned int> op_raw_output_max_buffers;
 extern dynamorio::droption::droption_t<std::string> op_trace_compress;
+extern dynamorio::droption::droption_t<int> op_trace_compress_level;
 extern dynamorio::droption::droption_t<bool> op_online_instr_types;
 extern dynamorio::droption::droption_t<std::string> op_replace_policy;
 extern dynamorio::droption::droption_t<std::string> op_data_prefetcher;
+extern dynamorio::droption::droption_t<unsigned int> op_prefetcher_table_entries;
+extern dynamorio::droption::droption_t<unsigned int> op_prefetcher_degree;
+extern dynamorio::droption::droption_t<unsigned int> op_prefetcher_late_distance;
 extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t> op_page_size;
 extern dynamorio::droption::droption_t<unsigned int> op_TLB_L1I_entries;
 extern dynamorio::droption::droption_t<unsigned int> op_TLB_L1D_entries;
@@ -156,6 +179,8 @@ extern dynamorio::droption::droption_t<std::string> op_tool;
 extern dynamorio::droption::droption_t<unsigned int> op_verbose;
 extern dynamorio::droption::droption_t<bool> op_show_func_trace;
 extern dynamorio::droption::droption_t<int> op_jobs;
+extern dynamorio::droption::droption_t<int> op_zip_read_ahead;
+extern dynamorio::droption::droption_t<int> op_zip_read_ahead_threads;
 extern dynamorio::droption::droption_t<bool> op_test_mode;
 extern dynamorio::droption::droption_t<std::string> op_test_mode_name;
 extern dynamorio::droption::droption_t<bool> op_disable_optimizations;
@@ -175,18 +200,25 @@ extern dynamorio::droption::droption_t<std::string> op_only_shards;
 extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t> op_skip_instrs;
 extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t> op_skip_refs;
 extern dynamorio::droption::droption_t<uint64_t> op_skip_to_timestamp;
+extern dynamorio::droption::droption_t<std::string> op_instr_intervals_file;
 extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t> op_warmup_refs;
 extern dynamorio::droption::droption_t<double> op_warmup_fraction;
 extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t> op_sim_refs;
+extern dynamorio::droption::droption_t<bool> op_sim_parallel;
+extern dynamorio::droption::droption_t<dynamorio::droption::bytesize_t>
+    op_sim_parallel_batch;
 extern dynamorio::droption::droption_t<std::string> op_config_file;
 extern dynamorio::droption::droption_t<bool> op_add_noise_generator;
 extern dynamorio::droption::droption_t<unsigned int> op_report_top;
+extern dynamorio::droption::droption_t<bool> op_sketch_mode;
 extern dynamorio::droption::droption_t<unsigned int> op_reuse_distance_threshold;
 extern dynamorio::droption::droption_t<bool> op_reuse_distance_histogram;
 extern dynamorio::droption::droption_t<unsigned int> op_reuse_skip_dist;
 extern dynamorio::droption::droption_t<unsigned int> op_reuse_distance_limit;
 extern dynamorio::droption::droption_t<bool> op_reuse_verify_skip;
 extern dynamorio::droption::droption_t<double> op_reuse_histogram_bin_multiplier;
+extern dynamorio::droption::droption_t<bool> op_reuse_tree;
+extern dynamorio::droption::droption_t<double> op_reuse_sample_rate;
 extern dynamorio::droption::droption_t<std::string> op_view_syntax;
 extern dynamorio::droption::droption_t<std::string> op_record_function;
 extern dynamorio::droption::droption_t<bool> op_record_heap;
@@ -219,15 +251,23 @@ extern dynamorio::droption::droption_t<std::string> op_cpu_schedule_file;
 #endif
 extern dynamorio::droption::droption_t<std::string> op_sched_switch_file;
 extern dynamorio::droption::droption_t<std::string> op_sched_syscall_file;
+extern dynamorio::droption::droption_t<uint64_t> op_sched_stop_after_instrs;
+extern dynamorio::droption::droption_t<std::string> op_sched_checkpoint_file;
+extern dynamorio::droption::droption_t<std::string> op_sched_resume_file;
 extern dynamorio::droption::droption_t<bool> op_sched_randomize;
 extern dynamorio::droption::droption_t<bool> op_sched_disable_direct_switches;
 extern dynamorio::droption::droption_t<bool> op_sched_infinite_timeouts;
 extern dynamorio::droption::droption_t<uint64_t> op_sched_migration_threshold_us;
 extern dynamorio::droption::droption_t<uint64_t> op_sched_rebalance_period_us;
+extern dynamorio::droption::droption_t<bool> op_sched_work_stealing;
+extern dynamorio::droption::droption_t<std::string> op_sched_topology;
 extern dynamorio::droption::droption_t<double> op_sched_time_units_per_us;
 extern dynamorio::droption::droption_t<double> op_sched_exit_if_fraction_inputs_left;
 extern dynamorio::droption::droption_t<int> op_sched_max_cores;
 extern dynamorio::droption::droption_t<uint64_t> op_schedule_stats_print_every;
+extern dynamorio::droption::droption_t<unsigned int> op_simpoint_max_k;
+extern dynamorio::droption::droption_t<unsigned int> op_simpoint_dimensions;
+extern dynamorio::droption::droption_t<std::string> op_simpoint_output_file;
 extern dynamorio::droption::droption_t<std::string> op_syscall_template_file;
 extern dynamorio::droption::droption_t<uint64_t> op_filter_stop_timestamp;
 extern dynamorio::droption::droption_t<int> op_filter_cache_size;
@@ -236,6 +276,7 @@ extern dynamorio::droption::droption_t<std::string> op_filter_marker_types;
 extern dynamorio::droption::droption_t<bool> op_encodings2regdeps;
 extern dynamorio::droption::droption_t<std::string> op_filter_func_ids;
 extern dynamorio::droption::droption_t<std::string> op_modify_marker_value;
+extern dynamorio::droption::droption_t<int> op_filter_output_threads;
 extern dynamorio::droption::droption_t<uint64_t> op_trim_before_timestamp;
 extern dynamorio::droption::droption_t<uint64_t> op_trim_after_timestamp;
 extern dynamorio::droption::droption_t<bool> op_abort_on_invariant_error;
@@ -0,0 +1,506 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* parallel_archive_ostream_t: an instance of archive_ostream_t which compresses
+ * its output on the threads of a shared compression_pool_t, so that many writers
+ * compressing at once are not each bound by a single thread's deflate speed.
+ *
+ * Each component is split into blocks which are deflated independently, each
+ * primed with the final window of the block before it as its dictionary, and
+ * ended with a sync flush so that the blocks of a component concatenate into one
+ * deflate stream.  Blocks are compressed in any order but assembled into the file
+ * in order by whichever worker completes the next one.  The result is the same
+ * format that gzip_ostream_t, zipfile_ostream_t, or uncompressed_ostream_t write
+ * for the same components, including the chunk index file for gzip and
+ * uncompressed output.
+ */
+
+#ifndef _PARALLEL_ARCHIVE_OSTREAM_H_
+#define _PARALLEL_ARCHIVE_OSTREAM_H_ 1
+
+#ifndef HAS_ZLIB
+#    error HAS_ZLIB is required
+#endif
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "archive_ostream.h"
+#include "compression_pool.h"
+#include "trace_index.h"
+#ifdef HAS_ZIP
+#    include "minizip/zip.h"
+#endif
+
+namespace dynamorio {
+namespace drmemtrace {
+
+enum parallel_archive_format_t {
+    PARALLEL_ARCHIVE_UNCOMPRESSED,
+    PARALLEL_ARCHIVE_GZIP,
+#ifdef HAS_ZIP
+    PARALLEL_ARCHIVE_ZIP,
+#endif
+};
+
+class parallel_archive_streambuf_t
+    : public std::basic_streambuf<char, std::char_traits<char>> {
+public:
+    parallel_archive_streambuf_t(const std::string &path,
+                                 parallel_archive_format_t format,
+                                 compression_pool_t *pool, size_t block_size)
+        : format_(format)
+        , pool_(pool)
+        , block_size_(block_size)
+        , buf_(BUFFER_SIZE)
+        , index_(path)
+    {
+#ifdef HAS_ZIP
+        if (format_ == PARALLEL_ARCHIVE_ZIP) {
+            zip_ = zipOpen2_64(path.c_str(), APPEND_STATUS_CREATE, nullptr, nullptr);
+            if (zip_ == nullptr)
+                return;
+        } else
+#endif
+        {
+            file_.open(path, std::ofstream::binary);
+            if (!file_)
+                return;
+        }
+        is_open_ = true;
+        // We leave an extra slot for extra_char on overflow.
+        setp(buf_.data(), buf_.data() + buf_.size() - 1);
+    }
+    ~parallel_archive_streambuf_t() override
+    {
+        close();
+    }
+    bool
+    is_open() const
+    {
+        return is_open_;
+    }
+    int
+    overflow(int extra_char) override
+    {
+        if (!is_open_ || closed_)
+            return traits_type::eof();
+        if (extra_char != traits_type::eof()) {
+            // Put the extra char into the buffer.  We left an extra slot for it.
+            *pptr() = traits_type::to_char_type(extra_char);
+            pbump(1);
+        }
+        raw_.append(pbase(), pptr() - pbase());
+        setp(buf_.data(), buf_.data() + buf_.size() - 1);
+        if (raw_.size() >= block_size_)
+            submit_block();
+        std::lock_guard<std::mutex> guard(lock_);
+        return error_.empty() ? traits_type::not_eof(extra_char) : traits_type::eof();
+    }
+    int
+    sync() override
+    {
+        return overflow(traits_type::eof()) == traits_type::eof() ? -1 : 0;
+    }
+    std::string
+    open_new_component(const std::string &name)
+    {
+        if (sync() != 0)
+            return "Failed to flush prior component";
+        submit_block();
+        queue_item(std::unique_ptr<item_t>(new item_t(name)));
+        return "";
+    }
+    void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp)
+    {
+        if (pending_component_ == nullptr)
+            return;
+        pending_component_->has_start = true;
+        pending_component_->instr_ordinal = instr_ordinal;
+        pending_component_->timestamp = timestamp;
+    }
+    // Writes out all data and closes the file.  Returns "" or an error string.
+    std::string
+    close()
+    {
+        if (!is_open_ || closed_)
+            return "";
+        sync();
+        submit_block();
+        // Release any pending component, now that its start is final.
+        queue_item(nullptr);
+        closed_ = true;
+        std::unique_lock<std::mutex> lock(lock_);
+        drained_cond_.wait(lock, [this] { return !writing_ && all_items_done(); });
+        // Trailing component starts have no block to trigger their writing.
+        write_completed_items(lock);
+        std::string error = end_component();
+        if (!error.empty() && error_.empty())
+            error_ = error;
+#ifdef HAS_ZIP
+        if (zip_ != nullptr) {
+            if (zipClose(zip_, nullptr) != ZIP_OK && error_.empty())
+                error_ = "Failed to close zipfile";
+            zip_ = nullptr;
+        }
+#endif
+        if (file_.is_open()) {
+            file_.close();
+            if (!file_ && error_.empty())
+                error_ = "Failed to write output file";
+            if (!index_.write() && error_.empty())
+                error_ = "Failed to write chunk index";
+        }
+        return error_;
+    }
+
+private:
+    static const size_t BUFFER_SIZE = 64 * 1024;
+    // The deflate window, which is all the history a block can refer back to.
+    static const size_t WINDOW_SIZE = 32 * 1024;
+
+    // Either a block of data or, if is_component is set, the start of a new
+    // component.
+    struct item_t {
+        item_t() = default;
+        explicit item_t(const std::string &name)
+            : is_component(true)
+            , name(name)
+        {
+        }
+        bool is_component = false;
+        std::string name;
+        bool has_start = false;
+        uint64_t instr_ordinal = 0;
+        uint64_t timestamp = 0;
+        std::string raw;
+        std::string dictionary;
+        std::string compressed;
+        uint64_t raw_size = 0;
+        uint32_t crc = 0;
+        bool done = false;
+    };
+
+    void
+    submit_block()
+    {
+        if (raw_.empty())
+            return;
+        std::unique_ptr<item_t> block(new item_t);
+        if (format_ != PARALLEL_ARCHIVE_UNCOMPRESSED)
+            block->dictionary = std::move(window_);
+        window_.assign(raw_, raw_.size() - std::min(raw_.size(), WINDOW_SIZE),
+                       std::string::npos);
+        block->raw = std::move(raw_);
+        raw_.clear();
+        item_t *item = block.get();
+        queue_item(std::move(block));
+        pool_->submit([this, item] { compress_block(item); });
+    }
+
+    // Appends "item" to the queue, first releasing any component start which is
+    // held back until set_component_start() can no longer modify it.
+    void
+    queue_item(std::unique_ptr<item_t> item)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (pending_component_ != nullptr) {
+            pending_component_->done = true;
+            queue_.push_back(std::move(pending_component_));
+        }
+        if (item == nullptr)
+            return;
+        if (item->is_component) {
+            window_.clear();
+            pending_component_ = std::move(item);
+        } else
+            queue_.push_back(std::move(item));
+    }
+
+    void
+    compress_block(item_t *item)
+    {
+        std::string error;
+        item->raw_size = item->raw.size();
+        if (format_ == PARALLEL_ARCHIVE_UNCOMPRESSED)
+            item->compressed = std::move(item->raw);
+        else {
+            item->crc = static_cast<uint32_t>(
+                crc32(0, reinterpret_cast<const Bytef *>(item->raw.data()),
+                      static_cast<uInt>(item->raw.size())));
+            error = deflate_block(item);
+        }
+        std::unique_lock<std::mutex> lock(lock_);
+        item->done = true;
+        if (!error.empty() && error_.empty())
+            error_ = error;
+        if (!writing_)
+            write_completed_items(lock);
+    }
+
+    // Writes out every completed item at the front of the queue.  We drop the
+    // lock while writing so other workers can mark their items done.
+    void
+    write_completed_items(std::unique_lock<std::mutex> &lock)
+    {
+        writing_ = true;
+        while (!queue_.empty() && queue_.front()->done) {
+            std::unique_ptr<item_t> next = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            std::string error = write_item(*next);
+            lock.lock();
+            if (!error.empty() && error_.empty())
+                error_ = error;
+        }
+        writing_ = false;
+        drained_cond_.notify_all();
+    }
+
+    bool
+    all_items_done()
+    {
+        for (const std::unique_ptr<item_t> &item : queue_) {
+            if (!item->done)
+                return false;
+        }
+        return true;
+    }
+
+    std::string
+    deflate_block(item_t *item)
+    {
+        z_stream zstream = {};
+        if (deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+            return "Failed to initialize deflate";
+        std::string error;
+        if (!item->dictionary.empty() &&
+            deflateSetDictionary(
+                &zstream, reinterpret_cast<const Bytef *>(item->dictionary.data()),
+                static_cast<uInt>(item->dictionary.size())) != Z_OK)
+            error = "Failed to set deflate dictionary";
+        // The sync flush adds up to 5 more bytes beyond the bound.
+        item->compressed.resize(deflateBound(&zstream, item->raw.size()) + 16);
+        zstream.next_in = reinterpret_cast<Bytef *>(&item->raw[0]);
+        zstream.avail_in = static_cast<uInt>(item->raw.size());
+        zstream.next_out = reinterpret_cast<Bytef *>(&item->compressed[0]);
+        zstream.avail_out = static_cast<uInt>(item->compressed.size());
+        if (error.empty() &&
+            (deflate(&zstream, Z_SYNC_FLUSH) != Z_OK || zstream.avail_in != 0))
+            error = "Failed to deflate block";
+        item->compressed.resize(zstream.total_out);
+        deflateEnd(&zstream);
+        std::string().swap(item->raw);
+        std::string().swap(item->dictionary);
+        return error;
+    }
+
+    // Only one thread at a time calls this, in queue order.
+    std::string
+    write_item(const item_t &item)
+    {
+        if (item.is_component) {
+            std::string error = end_component();
+            if (!error.empty())
+                return error;
+#ifdef HAS_ZIP
+            if (zip_ != nullptr) {
+                // We supply the raw deflate data and the crc and size ourselves.
+                if (zipOpenNewFileInZip2(zip_, item.name.c_str(), nullptr, nullptr, 0,
+                                         nullptr, 0, nullptr, Z_DEFLATED,
+                                         Z_DEFAULT_COMPRESSION, /*raw=*/1) != ZIP_OK)
+                    return "Failed to add new component " + item.name + " to zipfile";
+                in_component_ = true;
+                return "";
+            }
+#endif
+            index_.add_chunk(file_offset_);
+            if (item.has_start)
+                index_.set_chunk_start(item.instr_ordinal, item.timestamp);
+            return "";
+        }
+#ifdef HAS_ZIP
+        if (zip_ != nullptr && !in_component_)
+            return "No component is open";
+#endif
+        if (format_ == PARALLEL_ARCHIVE_GZIP && !in_component_) {
+            // A minimal gzip member header, as gzwrite() writes.
+            static const char header[] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3 };
+            std::string error = write_bytes(header, sizeof(header));
+            if (!error.empty())
+                return error;
+        }
+        in_component_ = true;
+        if (format_ != PARALLEL_ARCHIVE_UNCOMPRESSED) {
+            component_crc_ = static_cast<uint32_t>(
+                crc32_combine(component_crc_, item.crc,
+                              static_cast<z_off_t>(item.raw_size)));
+            component_size_ += item.raw_size;
+        }
+        return write_bytes(item.compressed.data(), item.compressed.size());
+    }
+
+    std::string
+    end_component()
+    {
+        if (!in_component_)
+            return "";
+        in_component_ = false;
+        std::string error;
+        if (format_ != PARALLEL_ARCHIVE_UNCOMPRESSED) {
+            // An empty final fixed-Huffman block ends the deflate stream.
+            static const char final_block[] = { 3, 0 };
+            error = write_bytes(final_block, sizeof(final_block));
+        }
+        if (error.empty() && format_ == PARALLEL_ARCHIVE_GZIP) {
+            char trailer[8];
+            for (int i = 0; i < 4; ++i) {
+                trailer[i] = static_cast<char>(component_crc_ >> (8 * i));
+                trailer[4 + i] = static_cast<char>(component_size_ >> (8 * i));
+            }
+            error = write_bytes(trailer, sizeof(trailer));
+        }
+#ifdef HAS_ZIP
+        if (error.empty() && zip_ != nullptr &&
+            zipCloseFileInZipRaw(zip_, static_cast<uLong>(component_size_),
+                                 component_crc_) != ZIP_OK)
+            error = "Failed to close prior component";
+#endif
+        component_crc_ = 0;
+        component_size_ = 0;
+        return error;
+    }
+
+    std::string
+    write_bytes(const char *data, size_t size)
+    {
+#ifdef HAS_ZIP
+        if (zip_ != nullptr) {
+            if (zipWriteInFileInZip(zip_, data, static_cast<unsigned int>(size)) !=
+                ZIP_OK)
+                return "Failed to write to zipfile";
+            return "";
+        }
+#endif
+        if (!file_.write(data, size))
+            return "Failed to write to output file";
+        file_offset_ += size;
+        return "";
+    }
+
+    const parallel_archive_format_t format_;
+    compression_pool_t *const pool_;
+    const size_t block_size_;
+    bool is_open_ = false;
+    bool closed_ = false;
+    // These fields are only accessed by the writing thread.
+    std::vector<char> buf_;
+    std::string raw_;
+    std::string window_;
+    std::unique_ptr<item_t> pending_component_;
+    // The lock guards the queue and the error.
+    std::mutex lock_;
+    std::condition_variable drained_cond_;
+    std::deque<std::unique_ptr<item_t>> queue_;
+    std::string error_;
+    bool writing_ = false;
+    // These fields are only accessed by the thread assembling the file.
+    trace_index_writer_t index_;
+    std::ofstream file_;
+#ifdef HAS_ZIP
+    zipFile zip_ = nullptr;
+#endif
+    uint64_t file_offset_ = 0;
+    bool in_component_ = false;
+    uint32_t component_crc_ = 0;
+    uint64_t component_size_ = 0;
+};
+
+// The gzip and uncompressed formats have an implicitly open first component;
+// the zip format requires open_new_component() before any writing.
+class parallel_archive_ostream_t : public archive_ostream_t {
+public:
+    parallel_archive_ostream_t(const std::string &path, parallel_archive_format_t format,
+                               compression_pool_t *pool,
+                               size_t block_size = DEFAULT_BLOCK_SIZE)
+        : archive_ostream_t(new parallel_archive_streambuf_t(path, format, pool,
+                                                             block_size))
+    {
+        if (!pbuf()->is_open())
+            setstate(std::ios::badbit);
+    }
+    ~parallel_archive_ostream_t() override
+    {
+        delete rdbuf();
+    }
+    std::string
+    open_new_component(const std::string &name) override
+    {
+        return pbuf()->open_new_component(name);
+    }
+    void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp) override
+    {
+        pbuf()->set_component_start(instr_ordinal, timestamp);
+    }
+    // Waits for all queued blocks to be written and closes the file.  Returns ""
+    // or a description of the first error.
+    std::string
+    close()
+    {
+        return pbuf()->close();
+    }
+
+    static const size_t DEFAULT_BLOCK_SIZE = 1024 * 1024;
+
+private:
+    parallel_archive_streambuf_t *
+    pbuf()
+    {
+        return static_cast<parallel_archive_streambuf_t *>(rdbuf());
+    }
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _PARALLEL_ARCHIVE_OSTREAM_H_ */
@@ -0,0 +1,426 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* shm_ring: the shared-memory layout used by the -ipc_shm online transport.
+ *
+ * The analyzer creates a file in /dev/shm holding a control page followed by
+ * a fixed number of rings.  Each traced thread claims its own ring and is its
+ * only producer; each ring is drained by one reader, so no ring needs a lock.
+ * Both sides sleep on futexes in the shared pages when the ring is full or
+ * empty and only wake the other side when it has announced that it is waiting.
+ * A ring is closed at thread exit and, once its reader has drained it, returned
+ * to the free pool for the next new thread, so the ring count only limits how
+ * many threads are traced at once.  The free rings are marked unused when the
+ * last traced process detaches.  Readers periodically check that the processes
+ * and threads they wait on are still alive, so one that dies without closing
+ * its ring or detaching does not leave the analyzer waiting forever.
+ */
+
+#ifndef _SHM_RING_H_
+#define _SHM_RING_H_ 1
+
+#ifndef LINUX
+#    error The shared-memory ring transport is only supported on Linux
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+
+namespace dynamorio {
+namespace drmemtrace {
+
+#define SHM_RING_MAGIC 0x474e495253524d44ULL /* "DMRSRING" */
+#define SHM_RING_VERSION 2
+#define SHM_RING_PAGE_SIZE 4096
+// Attached processes beyond this many are not checked for liveness.
+#define SHM_RING_MAX_PROCESSES 256
+// How often a waiting reader checks that its producers are still alive.
+#define SHM_RING_LIVENESS_CHECK_SECONDS 1
+
+enum shm_ring_state_t {
+    SHM_RING_FREE,   // Not claimed by a traced thread.
+    SHM_RING_ACTIVE, // Claimed and being written.
+    SHM_RING_CLOSED, // The thread exited: the reader drains the rest and frees it.
+    SHM_RING_UNUSED, // All tracers detached while it was free.
+};
+
+// At the start of the file.  The reader fills it in before any tracer can
+// attach, and only the atomic fields change afterward.
+struct shm_ring_control_t {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t ring_count;
+    // Bytes of trace data per ring: a power of two.
+    uint64_t ring_size;
+    // Traced processes currently attached.
+    std::atomic<uint32_t> attached;
+    // Futex word new threads sleep on while every ring is taken but some are
+    // closed; bumped whenever a reader frees a ring.
+    std::atomic<uint32_t> free_seq;
+    std::atomic<uint32_t> free_waiting;
+    // The ids of the attached processes, with 0 for an empty slot.
+    std::atomic<uint32_t> pids[SHM_RING_MAX_PROCESSES];
+};
+
+// At the start of each ring's first page; the data follows on the next page.
+// The producer and consumer fields are on separate cache lines.
+struct shm_ring_t {
+    // Bytes ever written, only advanced by the producer.
+    alignas(64) std::atomic<uint64_t> head;
+    std::atomic<uint32_t> state;
+    // The process id in the top half and the thread id in the bottom half of
+    // the writing thread, or 0 while the ring is free or just being claimed.
+    std::atomic<uint64_t> owner;
+    // Futex word the consumer sleeps on; bumped on every publish and state change.
+    std::atomic<uint32_t> data_seq;
+    std::atomic<uint32_t> consumer_waiting;
+    // Bytes ever read, only advanced by the consumer.
+    alignas(64) std::atomic<uint64_t> tail;
+    // Futex word the producer sleeps on; bumped whenever space is freed.
+    std::atomic<uint32_t> space_seq;
+    std::atomic<uint32_t> producer_waiting;
+};
+
+static_assert(sizeof(shm_ring_control_t) <= SHM_RING_PAGE_SIZE, "control too big");
+static_assert(sizeof(shm_ring_t) <= SHM_RING_PAGE_SIZE, "ring header too big");
+// Atomics shared across processes must be lock-free.
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "shared-memory atomics must be lock-free");
+
+// Returns the /dev/shm path for the transport named by -ipc_name.
+static inline std::string
+shm_ring_path(const std::string &ipc_name)
+{
+    std::string name = ipc_name;
+    for (char &c : name) {
+        if (c == '/')
+            c = '_';
+    }
+    return "/dev/shm/drmemtrace." + name;
+}
+
+static inline uint64_t
+shm_ring_file_size(uint32_t ring_count, uint64_t ring_size)
+{
+    return SHM_RING_PAGE_SIZE + ring_count * (SHM_RING_PAGE_SIZE + ring_size);
+}
+
+static inline shm_ring_t *
+shm_ring_get(shm_ring_control_t *control, uint32_t index)
+{
+    uint64_t offs =
+        SHM_RING_PAGE_SIZE + index * (SHM_RING_PAGE_SIZE + control->ring_size);
+    return reinterpret_cast<shm_ring_t *>(reinterpret_cast<char *>(control) + offs);
+}
+
+static inline char *
+shm_ring_data(shm_ring_t *ring)
+{
+    return reinterpret_cast<char *>(ring) + SHM_RING_PAGE_SIZE;
+}
+
+// The futexes are shared between processes so we cannot use FUTEX_PRIVATE_FLAG.
+// Returns false if "timeout" expired.
+static inline bool
+shm_ring_futex_wait(std::atomic<uint32_t> *word, uint32_t expected,
+                    const struct timespec *timeout = nullptr)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected,
+                   timeout, nullptr, 0) == 0 ||
+        errno != ETIMEDOUT;
+}
+
+static inline void
+shm_ring_futex_wake(std::atomic<uint32_t> *word, int count = 1)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, count, nullptr,
+            nullptr, 0);
+}
+
+static inline void
+shm_ring_notify_consumer(shm_ring_t *ring)
+{
+    ring->data_seq.fetch_add(1);
+    if (ring->consumer_waiting.load() != 0)
+        shm_ring_futex_wake(&ring->data_seq);
+}
+
+static inline void
+shm_ring_notify_producer(shm_ring_t *ring)
+{
+    ring->space_seq.fetch_add(1);
+    if (ring->producer_waiting.load() != 0)
+        shm_ring_futex_wake(&ring->space_seq);
+}
+
+// Removes the process in slot "slot" (or no slot if it is SHM_RING_MAX_PROCESSES)
+// from the attached count.  Once none are left, the free rings are marked
+// unused so their readers see the end.
+static inline void
+shm_ring_drop_process(shm_ring_control_t *control, uint32_t slot, uint32_t pid)
+{
+    if (slot < SHM_RING_MAX_PROCESSES &&
+        !control->pids[slot].compare_exchange_strong(pid, 0)) {
+        // Someone else already dropped it.
+        return;
+    }
+    if (control->attached.fetch_sub(1) != 1)
+        return;
+    for (uint32_t i = 0; i < control->ring_count; ++i) {
+        shm_ring_t *ring = shm_ring_get(control, i);
+        uint32_t expected = SHM_RING_FREE;
+        if (ring->state.compare_exchange_strong(expected, SHM_RING_UNUSED))
+            shm_ring_notify_consumer(ring);
+    }
+}
+
+/**************************************************
+ * Producer side, used by the tracer.
+ */
+
+// Called as each traced process starts, including each forked child.
+static inline void
+shm_ring_attach(shm_ring_control_t *control, uint32_t pid)
+{
+    control->attached.fetch_add(1);
+    for (uint32_t i = 0; i < SHM_RING_MAX_PROCESSES; ++i) {
+        uint32_t expected = 0;
+        if (control->pids[i].compare_exchange_strong(expected, pid))
+            return;
+    }
+}
+
+// Returns a free ring marked as active, or nullptr if all are active.  If the
+// only rings left are closed ones their readers are still draining, this waits
+// for one of them to be freed.
+static inline shm_ring_t *
+shm_ring_claim(shm_ring_control_t *control, uint32_t pid, uint32_t tid)
+{
+    while (true) {
+        uint32_t seq = control->free_seq.load();
+        bool any_closed = false;
+        for (uint32_t i = 0; i < control->ring_count; ++i) {
+            shm_ring_t *ring = shm_ring_get(control, i);
+            uint32_t expected = SHM_RING_FREE;
+            if (ring->state.compare_exchange_strong(expected, SHM_RING_ACTIVE)) {
+                ring->owner.store((static_cast<uint64_t>(pid) << 32) | tid);
+                shm_ring_notify_consumer(ring);
+                return ring;
+            }
+            if (expected == SHM_RING_CLOSED)
+                any_closed = true;
+        }
+        if (!any_closed)
+            return nullptr;
+        control->free_waiting.fetch_add(1);
+        shm_ring_futex_wait(&control->free_seq, seq);
+        control->free_waiting.fetch_sub(1);
+    }
+}
+
+// Appends [data, data+size), blocking while the ring is full.
+static inline void
+shm_ring_write(shm_ring_control_t *control, shm_ring_t *ring, const char *data,
+               size_t size)
+{
+    const uint64_t ring_size = control->ring_size;
+    char *base = shm_ring_data(ring);
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    while (size > 0) {
+        uint64_t avail = ring_size - (head - ring->tail.load(std::memory_order_acquire));
+        if (avail == 0) {
+            uint32_t seq = ring->space_seq.load();
+            ring->producer_waiting.store(1);
+            if (ring_size - (head - ring->tail.load()) == 0)
+                shm_ring_futex_wait(&ring->space_seq, seq);
+            ring->producer_waiting.store(0);
+            continue;
+        }
+        size_t chunk = static_cast<size_t>(avail < size ? avail : size);
+        size_t offs = static_cast<size_t>(head & (ring_size - 1));
+        size_t first = chunk < ring_size - offs ? chunk : ring_size - offs;
+        memcpy(base + offs, data, first);
+        memcpy(base, data + first, chunk - first);
+        head += chunk;
+        data += chunk;
+        size -= chunk;
+        ring->head.store(head);
+        shm_ring_notify_consumer(ring);
+    }
+}
+
+static inline void
+shm_ring_close(shm_ring_t *ring)
+{
+    ring->state.store(SHM_RING_CLOSED);
+    shm_ring_notify_consumer(ring);
+}
+
+// Called as each traced process goes away.  Threads still running at process
+// exit do not get a thread exit event, so this closes their rings.
+static inline void
+shm_ring_detach(shm_ring_control_t *control, uint32_t pid)
+{
+    for (uint32_t i = 0; i < control->ring_count; ++i) {
+        shm_ring_t *ring = shm_ring_get(control, i);
+        if (ring->state.load() == SHM_RING_ACTIVE &&
+            (ring->owner.load() >> 32) == pid)
+            shm_ring_close(ring);
+    }
+    uint32_t slot = 0;
+    while (slot < SHM_RING_MAX_PROCESSES && control->pids[slot].load() != pid)
+        ++slot;
+    shm_ring_drop_process(control, slot, pid);
+}
+
+/**************************************************
+ * Consumer side, used by the reader.
+ */
+
+// Returns whether the task has exited.  We read its state rather than using
+// kill() as a zombie still counts as alive there, and the application is often
+// an unreaped child of the analyzer's own launcher.
+static inline bool
+shm_ring_task_exited(uint32_t pid, uint32_t tid)
+{
+    std::string path = "/proc/" + std::to_string(pid) + "/task/" + std::to_string(tid) +
+        "/stat";
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr)
+        return errno == ENOENT || errno == ESRCH;
+    char buf[512];
+    size_t len = fread(buf, 1, sizeof(buf) - 1, file);
+    fclose(file);
+    buf[len] = '\0';
+    // The state follows the parenthesized name, which can itself hold ')'.
+    const char *name_end = strrchr(buf, ')');
+    return name_end != nullptr && name_end[1] == ' ' &&
+        (name_end[2] == 'Z' || name_end[2] == 'X');
+}
+
+// Called by a reader that has been waiting for a while.  Closes "ring" if its
+// thread died without closing it, and drops any process that died without
+// detaching.
+static inline void
+shm_ring_check_producers(shm_ring_control_t *control, shm_ring_t *ring)
+{
+    // Only our own reader frees the ring, so the owner cannot change under us
+    // while it is active.
+    uint64_t owner = ring->owner.load();
+    if (owner != 0 && ring->state.load() == SHM_RING_ACTIVE &&
+        shm_ring_task_exited(static_cast<uint32_t>(owner >> 32),
+                             static_cast<uint32_t>(owner))) {
+        uint32_t expected = SHM_RING_ACTIVE;
+        if (ring->state.compare_exchange_strong(expected, SHM_RING_CLOSED))
+            shm_ring_notify_consumer(ring);
+    }
+    for (uint32_t i = 0; i < SHM_RING_MAX_PROCESSES; ++i) {
+        uint32_t pid = control->pids[i].load();
+        if (pid != 0 && shm_ring_task_exited(pid, pid))
+            shm_ring_drop_process(control, i, pid);
+    }
+}
+
+// Returns a closed and drained ring to the free pool.
+static inline void
+shm_ring_release(shm_ring_control_t *control, shm_ring_t *ring)
+{
+    ring->owner.store(0);
+    ring->state.store(SHM_RING_FREE);
+    // If the last process detached before the store above, its scan for free
+    // rings missed this one and it is up to us to mark it unused.
+    if (control->attached.load() == 0) {
+        uint32_t expected = SHM_RING_FREE;
+        ring->state.compare_exchange_strong(expected, SHM_RING_UNUSED);
+    }
+    control->free_seq.fetch_add(1);
+    if (control->free_waiting.load() != 0)
+        shm_ring_futex_wake(&control->free_seq, INT_MAX);
+}
+
+// Copies up to "size" bytes into "buf", blocking until data arrives.  Returns 0
+// at the end of each thread's data, after which the ring is back in the free
+// pool, and on every call once the ring is unused and drained.
+static inline size_t
+shm_ring_read(shm_ring_control_t *control, shm_ring_t *ring, char *buf, size_t size)
+{
+    const uint64_t ring_size = control->ring_size;
+    const char *base = shm_ring_data(ring);
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t avail = ring->head.load(std::memory_order_acquire) - tail;
+        if (avail > 0) {
+            size_t chunk = static_cast<size_t>(avail < size ? avail : size);
+            size_t offs = static_cast<size_t>(tail & (ring_size - 1));
+            size_t first = chunk < ring_size - offs ? chunk : ring_size - offs;
+            memcpy(buf, base + offs, first);
+            memcpy(buf + first, base, chunk - first);
+            ring->tail.store(tail + chunk);
+            shm_ring_notify_producer(ring);
+            return chunk;
+        }
+        uint32_t state = ring->state.load();
+        if (state == SHM_RING_CLOSED || state == SHM_RING_UNUSED) {
+            // The final data is published before the state changes.
+            if (ring->head.load() != tail)
+                continue;
+            if (state == SHM_RING_CLOSED)
+                shm_ring_release(control, ring);
+            return 0;
+        }
+        uint32_t seq = ring->data_seq.load();
+        ring->consumer_waiting.store(1);
+        bool woken = true;
+        if (ring->head.load() == tail && ring->state.load() == state) {
+            struct timespec timeout = { SHM_RING_LIVENESS_CHECK_SECONDS, 0 };
+            woken = shm_ring_futex_wait(&ring->data_seq, seq, &timeout);
+        }
+        ring->consumer_waiting.store(0);
+        if (!woken)
+            shm_ring_check_producers(control, ring);
+    }
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _SHM_RING_H_ */
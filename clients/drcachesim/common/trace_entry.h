@@ -1557,6 +1557,13 @@ typedef struct _pt_data_buf_t pt_data_buf_t;
  */
 #define DRMEMTRACE_V2P_FILENAME "v2p.textproto"
 
+/**
+ * The suffix appended to a trace file's name to form the name of its chunk index
+ * file, which records where each chunk starts so that readers can skip directly
+ * to it.  It is written for compression formats that lack an index of their own.
+ */
+#define DRMEMTRACE_CHUNK_INDEX_SUFFIX ".idx"
+
 } // namespace drmemtrace
 } // namespace dynamorio
 
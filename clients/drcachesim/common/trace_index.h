@@ -0,0 +1,161 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* trace_index: the chunk index file written alongside a trace by archive_ostream_t
+ * implementations whose compression format has no seek table of its own.  For the
+ * start of each chunk it records the instruction ordinal, the timestamp which the
+ * chunk repeats in its header, and the file offset at which decompression can
+ * resume, letting file_reader_t jump straight to a chunk.
+ */
+
+#ifndef _TRACE_INDEX_H_
+#define _TRACE_INDEX_H_ 1
+
+#include <stdint.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+struct trace_index_entry_t {
+    trace_index_entry_t() = default;
+    trace_index_entry_t(uint64_t instr_ordinal, uint64_t timestamp, uint64_t offset)
+        : instr_ordinal(instr_ordinal)
+        , timestamp(timestamp)
+        , offset(offset)
+    {
+    }
+    // The count of instructions preceding the chunk.
+    uint64_t instr_ordinal = 0;
+    // The most recent timestamp at the start of the chunk.  This is 0 for the
+    // first chunk, which precedes any timestamp.
+    uint64_t timestamp = 0;
+    // The offset of the chunk in the (compressed) trace file.
+    uint64_t offset = 0;
+};
+
+// The file holds this magic number, the version, and the entry count, followed
+// by the entries, all as 64-bit values in the native byte order of the trace.
+static const uint64_t TRACE_INDEX_MAGIC = 0x58444e494b4e4843ULL; // "CHNKINDX"
+static const uint64_t TRACE_INDEX_VERSION = 1;
+
+static inline std::string
+trace_index_path(const std::string &trace_path)
+{
+    return trace_path + DRMEMTRACE_CHUNK_INDEX_SUFFIX;
+}
+
+// Reads the index for the trace at "trace_path".  Returns false if there is no
+// index or it is malformed.
+static inline bool
+read_trace_index(const std::string &trace_path, std::vector<trace_index_entry_t> &entries)
+{
+    std::ifstream file(trace_index_path(trace_path), std::ifstream::binary);
+    if (!file)
+        return false;
+    uint64_t header[3];
+    if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) ||
+        header[0] != TRACE_INDEX_MAGIC || header[1] != TRACE_INDEX_VERSION)
+        return false;
+    // Avoid a huge allocation for a corrupted count.
+    if (header[2] > (1ULL << 32))
+        return false;
+    entries.resize(static_cast<size_t>(header[2]));
+    if (!entries.empty() &&
+        !file.read(reinterpret_cast<char *>(entries.data()),
+                   entries.size() * sizeof(trace_index_entry_t))) {
+        entries.clear();
+        return false;
+    }
+    // Readers binary-search on the ordinals.
+    for (size_t i = 1; i < entries.size(); ++i) {
+        if (entries[i].instr_ordinal < entries[i - 1].instr_ordinal) {
+            entries.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Accumulates an entry per component for an archive_ostream_t and writes them
+// out when the archive is closed.
+class trace_index_writer_t {
+public:
+    explicit trace_index_writer_t(const std::string &trace_path)
+        : trace_path_(trace_path)
+    {
+        // The first chunk is implicitly open at the start of the file.
+        entries_.emplace_back(0, 0, 0);
+    }
+    // Records that a new chunk starts at "offset" in the trace file.
+    void
+    add_chunk(uint64_t offset)
+    {
+        entries_.emplace_back(0, 0, offset);
+    }
+    // Fills in the instruction ordinal and timestamp of the latest chunk.
+    void
+    set_chunk_start(uint64_t instr_ordinal, uint64_t timestamp)
+    {
+        if (entries_.empty())
+            return;
+        entries_.back().instr_ordinal = instr_ordinal;
+        entries_.back().timestamp = timestamp;
+    }
+    // Writes the index file, unless there are too few chunks for it to help.
+    bool
+    write() const
+    {
+        if (entries_.size() <= 1)
+            return true;
+        std::ofstream file(trace_index_path(trace_path_), std::ofstream::binary);
+        uint64_t header[3] = { TRACE_INDEX_MAGIC, TRACE_INDEX_VERSION, entries_.size() };
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(entries_.data()),
+                   entries_.size() * sizeof(trace_index_entry_t));
+        return static_cast<bool>(file);
+    }
+
+private:
+    std::string trace_path_;
+    std::vector<trace_index_entry_t> entries_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _TRACE_INDEX_H_ */
@@ -0,0 +1,95 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* uncompressed_ostream_t: an instance of archive_ostream_t that writes an
+ * uncompressed file.  Components are simply concatenated, and their offsets are
+ * written to a chunk index file (see trace_index.h) so that readers can seek
+ * directly to any component.
+ */
+
+#ifndef _UNCOMPRESSED_OSTREAM_H_
+#define _UNCOMPRESSED_OSTREAM_H_ 1
+
+#include <fstream>
+#include <string>
+
+#include "archive_ostream.h"
+#include "trace_index.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+class uncompressed_ostream_t : public archive_ostream_t {
+public:
+    explicit uncompressed_ostream_t(const std::string &path)
+        : archive_ostream_t(nullptr)
+        , index_(path)
+    {
+        // The buffer is only constructed once the base class is.
+        rdbuf(&buf_);
+        if (buf_.open(path, std::ios_base::out | std::ios_base::binary) == nullptr)
+            setstate(std::ios::badbit);
+    }
+    ~uncompressed_ostream_t() override
+    {
+        if (buf_.is_open()) {
+            flush();
+            buf_.close();
+            index_.write();
+        }
+    }
+    std::string
+    open_new_component(const std::string &name) override
+    {
+        if (!flush())
+            return "Failed to flush prior component";
+        std::streamoff offset = tellp();
+        if (offset < 0)
+            return "Failed to find the component offset";
+        index_.add_chunk(static_cast<uint64_t>(offset));
+        return "";
+    }
+    void
+    set_component_start(uint64_t instr_ordinal, uint64_t timestamp) override
+    {
+        index_.set_chunk_start(instr_ordinal, timestamp);
+    }
+
+private:
+    std::filebuf buf_;
+    trace_index_writer_t index_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _UNCOMPRESSED_OSTREAM_H_ */
@@ -0,0 +1,252 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* zstd_istream_t: a wrapper around zstd to match the parts of the
+ * std::istream interface we use for raw2trace and file_reader_t.
+ * Supports only limited seeking within the current internal buffer, plus
+ * jumping to the start of any frame when the file ends in a seek table
+ * in the zstd seekable format, as written by zstd_ostream_t.
+ */
+
+#ifndef _ZSTD_ISTREAM_H_
+#define _ZSTD_ISTREAM_H_ 1
+
+#ifndef HAS_ZSTD
+#    error HAS_ZSTD is required
+#endif
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <zstd.h>
+
+#include "zstd_seekable.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/* We need to override the stream buffer class which is where the file
+ * reads happen.  The stream buffer base class reads from eback()..egptr()
+ * with the next to read at gptr().
+ */
+class zstd_istreambuf_t : public std::basic_streambuf<char, std::char_traits<char>> {
+public:
+    explicit zstd_istreambuf_t(const std::string &path)
+    {
+        file_ = fopen(path.c_str(), "rb");
+        if (file_ == nullptr)
+            return;
+        dctx_ = ZSTD_createDCtx();
+        if (dctx_ == nullptr) {
+            fclose(file_);
+            file_ = nullptr;
+            return;
+        }
+        compressed_size_ = ZSTD_DStreamInSize();
+        buf_compressed_ = new char[compressed_size_];
+        buf_uncompressed_ = new char[buffer_size_];
+        read_seek_table();
+    }
+    ~zstd_istreambuf_t() override
+    {
+        if (file_ != nullptr)
+            fclose(file_);
+        delete[] buf_compressed_;
+        delete[] buf_uncompressed_;
+        ZSTD_freeDCtx(dctx_);
+    }
+    bool
+    is_open() const
+    {
+        return file_ != nullptr;
+    }
+    int
+    underflow() override
+    {
+        if (file_ == nullptr)
+            return traits_type::eof();
+        if (gptr() == egptr()) {
+            ZSTD_outBuffer out = { buf_uncompressed_, buffer_size_, 0 };
+            // Skippable frames such as the seek table produce no output.
+            do {
+                if (in_.pos == in_.size) {
+                    in_.src = buf_compressed_;
+                    in_.size = fread(buf_compressed_, 1, compressed_size_, file_);
+                    in_.pos = 0;
+                    if (ferror(file_) || in_.size == 0)
+                        return traits_type::eof();
+                }
+                size_t res = ZSTD_decompressStream(dctx_, &out, &in_);
+                if (ZSTD_isError(res))
+                    return traits_type::eof();
+            } while (out.pos == 0);
+            setg(buf_uncompressed_, buf_uncompressed_, buf_uncompressed_ + out.pos);
+        }
+        return traits_type::to_int_type(*gptr());
+    }
+    std::iostream::pos_type
+    seekoff(std::iostream::off_type off, std::ios_base::seekdir dir,
+            std::ios_base::openmode which = std::ios_base::in) override
+    {
+        if (dir == std::ios_base::cur &&
+            ((off >= 0 && gptr() + off < egptr()) ||
+             (off < 0 && gptr() + off >= eback())))
+            gbump(off);
+        else {
+            // Unsupported!
+            return -1;
+        }
+        return gptr() - eback();
+    }
+    // Returns the number of frames in the seek table, or 0 if there is none.
+    uint64_t
+    frame_count() const
+    {
+        return frame_offsets_.size();
+    }
+    // Discards buffered data and positions the stream at the start of the
+    // given frame.  Returns false if there is no such frame.
+    bool
+    seek_to_frame(uint64_t index)
+    {
+        if (index >= frame_offsets_.size() ||
+            fseek(file_, static_cast<long>(frame_offsets_[index]), SEEK_SET) != 0)
+            return false;
+        ZSTD_DCtx_reset(dctx_, ZSTD_reset_session_only);
+        in_.pos = 0;
+        in_.size = 0;
+        setg(buf_uncompressed_, buf_uncompressed_, buf_uncompressed_);
+        return true;
+    }
+
+private:
+    // Fills in frame_offsets_ if the file ends in a valid seek table.  We
+    // tolerate its absence: files from other zstd writers are read sequentially.
+    void
+    read_seek_table()
+    {
+        unsigned char footer[ZSTD_SEEKABLE_FOOTER_SIZE];
+        if (fseek(file_, -ZSTD_SEEKABLE_FOOTER_SIZE, SEEK_END) != 0) {
+            rewind(file_);
+            return;
+        }
+        long footer_start = ftell(file_);
+        if (fread(footer, 1, sizeof(footer), file_) != sizeof(footer) ||
+            zstd_seekable_read32(footer + 5) != ZSTD_SEEKABLE_MAGIC) {
+            rewind(file_);
+            return;
+        }
+        uint64_t num_frames = zstd_seekable_read32(footer);
+        uint64_t entry_size = ZSTD_SEEKABLE_ENTRY_SIZE;
+        if ((footer[4] & ZSTD_SEEKABLE_CHECKSUM_FLAG) != 0)
+            entry_size += ZSTD_SEEKABLE_CHECKSUM_SIZE;
+        uint64_t table_size = num_frames * entry_size;
+        // The entries plus the skippable frame header that precedes them.
+        uint64_t read_size = table_size + ZSTD_SEEKABLE_FRAME_HEADER_SIZE;
+        if (read_size > static_cast<uint64_t>(footer_start)) {
+            rewind(file_);
+            return;
+        }
+        long table_start = footer_start - static_cast<long>(read_size);
+        std::vector<unsigned char> table(static_cast<size_t>(read_size));
+        if (fseek(file_, table_start, SEEK_SET) != 0 ||
+            fread(&table.front(), 1, table.size(), file_) != table.size() ||
+            zstd_seekable_read32(&table.front()) != ZSTD_SEEKABLE_SKIPPABLE_MAGIC ||
+            zstd_seekable_read32(&table.front() + 4) !=
+                table_size + ZSTD_SEEKABLE_FOOTER_SIZE) {
+            rewind(file_);
+            return;
+        }
+        uint64_t offset = 0;
+        std::vector<uint64_t> offsets;
+        offsets.reserve(static_cast<size_t>(num_frames));
+        for (uint64_t i = 0; i < num_frames; ++i) {
+            offsets.push_back(offset);
+            offset += zstd_seekable_read32(&table.front() +
+                                           ZSTD_SEEKABLE_FRAME_HEADER_SIZE +
+                                           i * entry_size);
+        }
+        // The frames must exactly cover the data preceding the table.
+        if (offset == static_cast<uint64_t>(table_start))
+            frame_offsets_.swap(offsets);
+        rewind(file_);
+    }
+
+    static const int buffer_size_ = 1024 * 1024;
+    ZSTD_DCtx *dctx_ = nullptr;
+    FILE *file_ = nullptr;
+    ZSTD_inBuffer in_ = { nullptr, 0, 0 };
+    size_t compressed_size_ = 0;
+    char *buf_compressed_ = nullptr;
+    char *buf_uncompressed_ = nullptr;
+    // The compressed offset of the start of each frame.
+    std::vector<uint64_t> frame_offsets_;
+};
+
+class zstd_istream_t : public std::istream {
+public:
+    explicit zstd_istream_t(const std::string &path)
+        : std::istream(new zstd_istreambuf_t(path))
+    {
+        if (!zbuf()->is_open())
+            setstate(std::ios::badbit);
+    }
+    virtual ~zstd_istream_t() override
+    {
+        delete rdbuf();
+    }
+    uint64_t
+    frame_count()
+    {
+        return zbuf()->frame_count();
+    }
+    // Clears any error state on success, as a prior read may have hit the end.
+    bool
+    seek_to_frame(uint64_t index)
+    {
+        if (!zbuf()->seek_to_frame(index))
+            return false;
+        clear();
+        return true;
+    }
+
+private:
+    zstd_istreambuf_t *
+    zbuf()
+    {
+        return reinterpret_cast<zstd_istreambuf_t *>(rdbuf());
+    }
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _ZSTD_ISTREAM_H_ */
@@ -0,0 +1,238 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* zstd_ostream_t: an instance of archive_ostream_t that writes a zstd file.
+ * Each component is compressed as its own zstd frame, and a seek table in the
+ * zstd seekable format is appended on close so that zstd_istream_t can jump to
+ * the start of any component.  Component names are not recorded.  Any zstd
+ * decompressor can read the result as a single stream.
+ */
+
+#ifndef _ZSTD_OSTREAM_H_
+#define _ZSTD_OSTREAM_H_ 1
+
+#ifndef HAS_ZSTD
+#    error HAS_ZSTD is required
+#endif
+
+#include <array>
+#include <fstream>
+#include <streambuf>
+#include <utility>
+#include <vector>
+#include <zstd.h>
+
+#include "archive_ostream.h"
+#include "zstd_seekable.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+class zstd_ostreambuf_t : public std::basic_streambuf<char, std::char_traits<char>> {
+public:
+    zstd_ostreambuf_t(const std::string &path, int level)
+    {
+        cctx_ = ZSTD_createCCtx();
+        if (cctx_ == nullptr)
+            return;
+        if (ZSTD_isError(
+                ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, level))) {
+            ZSTD_freeCCtx(cctx_);
+            cctx_ = nullptr;
+            return;
+        }
+        dest_buf_.resize(ZSTD_CStreamOutSize());
+        file_ = new std::ofstream(path, std::ofstream::binary);
+        char *base = &src_buf_.front();
+        // We leave an extra slot for extra_char on overflow.
+        setp(base, base + src_buf_.size() - 1);
+    }
+
+    ~zstd_ostreambuf_t() override
+    {
+        if (file_ != nullptr) {
+            sync();
+            end_frame();
+            write_seek_table();
+            delete file_;
+            file_ = nullptr;
+        }
+        ZSTD_freeCCtx(cctx_);
+    }
+
+    bool
+    is_open() const
+    {
+        return file_ != nullptr && *file_;
+    }
+
+    // Ends the current frame, if any.  An explicitly opened component always
+    // produces a frame, even if empty, so that frame indices match components.
+    std::string
+    open_new_component(const std::string &name)
+    {
+        if (sync() != 0)
+            return "Failed to flush prior component";
+        if (!end_frame())
+            return "Failed to end prior component";
+        frame_open_ = true;
+        return "";
+    }
+
+private:
+    int
+    overflow(int extra_char) override
+    {
+        if (file_ == nullptr)
+            return traits_type::eof();
+        if (extra_char != traits_type::eof()) {
+            *pptr() = traits_type::to_char_type(extra_char);
+            pbump(1);
+        }
+        size_t size = pptr() - pbase();
+        setp(pbase(), epptr());
+        if (size > 0) {
+            frame_open_ = true;
+            ZSTD_inBuffer in = { pbase(), size, 0 };
+            if (!compress(in, ZSTD_e_continue))
+                return traits_type::eof();
+            frame_decompressed_ += size;
+        }
+        return traits_type::not_eof(extra_char);
+    }
+
+    int
+    sync() override
+    {
+        return overflow(traits_type::eof()) == traits_type::eof() ? -1 : 0;
+    }
+
+    // Feeds all of "in" to the compressor and writes out what it produces.  For
+    // ZSTD_e_end, also flushes until the frame is complete.
+    bool
+    compress(ZSTD_inBuffer &in, ZSTD_EndDirective mode)
+    {
+        size_t remaining;
+        do {
+            ZSTD_outBuffer out = { &dest_buf_.front(), dest_buf_.size(), 0 };
+            remaining = ZSTD_compressStream2(cctx_, &out, &in, mode);
+            if (ZSTD_isError(remaining))
+                return false;
+            file_->write(&dest_buf_.front(), out.pos);
+            frame_compressed_ += out.pos;
+        } while (mode == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+        return static_cast<bool>(*file_);
+    }
+
+    bool
+    end_frame()
+    {
+        if (!frame_open_)
+            return true;
+        ZSTD_inBuffer in = { nullptr, 0, 0 };
+        if (!compress(in, ZSTD_e_end))
+            return false;
+        // The seek table stores 32-bit sizes: we give up on it if a frame is
+        // too large, which leaves a valid but non-seekable file.
+        if (frame_compressed_ > UINT32_MAX || frame_decompressed_ > UINT32_MAX)
+            seekable_ = false;
+        frame_sizes_.emplace_back(static_cast<uint32_t>(frame_compressed_),
+                                  static_cast<uint32_t>(frame_decompressed_));
+        frame_compressed_ = 0;
+        frame_decompressed_ = 0;
+        frame_open_ = false;
+        return true;
+    }
+
+    void
+    write_seek_table()
+    {
+        if (!seekable_ || frame_sizes_.empty() || frame_sizes_.size() > UINT32_MAX)
+            return;
+        std::vector<unsigned char> table(ZSTD_SEEKABLE_FRAME_HEADER_SIZE +
+                                         frame_sizes_.size() * ZSTD_SEEKABLE_ENTRY_SIZE +
+                                         ZSTD_SEEKABLE_FOOTER_SIZE);
+        unsigned char *pos = &table.front();
+        zstd_seekable_write32(pos, ZSTD_SEEKABLE_SKIPPABLE_MAGIC);
+        zstd_seekable_write32(
+            pos + 4,
+            static_cast<uint32_t>(table.size() - ZSTD_SEEKABLE_FRAME_HEADER_SIZE));
+        pos += ZSTD_SEEKABLE_FRAME_HEADER_SIZE;
+        for (const auto &sizes : frame_sizes_) {
+            zstd_seekable_write32(pos, sizes.first);
+            zstd_seekable_write32(pos + 4, sizes.second);
+            pos += ZSTD_SEEKABLE_ENTRY_SIZE;
+        }
+        zstd_seekable_write32(pos, static_cast<uint32_t>(frame_sizes_.size()));
+        // No checksums.
+        pos[4] = 0;
+        zstd_seekable_write32(pos + 5, ZSTD_SEEKABLE_MAGIC);
+        file_->write(reinterpret_cast<char *>(&table.front()), table.size());
+    }
+
+    static const int buffer_size_ = 1024 * 1024;
+    std::ofstream *file_ = nullptr;
+    std::array<char, buffer_size_> src_buf_;
+    std::vector<char> dest_buf_;
+    ZSTD_CCtx *cctx_ = nullptr;
+    bool frame_open_ = false;
+    uint64_t frame_compressed_ = 0;
+    uint64_t frame_decompressed_ = 0;
+    // Compressed and decompressed size of each completed frame.
+    std::vector<std::pair<uint32_t, uint32_t>> frame_sizes_;
+    bool seekable_ = true;
+};
+
+class zstd_ostream_t : public archive_ostream_t {
+public:
+    explicit zstd_ostream_t(const std::string &path, int level = ZSTD_CLEVEL_DEFAULT)
+        : archive_ostream_t(new zstd_ostreambuf_t(path, level))
+    {
+        if (!reinterpret_cast<zstd_ostreambuf_t *>(rdbuf())->is_open())
+            setstate(std::ios::badbit);
+    }
+    ~zstd_ostream_t() override
+    {
+        delete rdbuf();
+    }
+    std::string
+    open_new_component(const std::string &name) override
+    {
+        zstd_ostreambuf_t *zbuf = reinterpret_cast<zstd_ostreambuf_t *>(rdbuf());
+        return zbuf->open_new_component(name);
+    }
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _ZSTD_OSTREAM_H_ */
@@ -0,0 +1,82 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Constants for the zstd seekable format, shared by zstd_ostream_t and
+ * zstd_istream_t.  The format appends a skippable frame holding a table of the
+ * compressed and decompressed size of each frame, letting readers jump to any
+ * frame without decompressing what precedes it.  See
+ * contrib/seekable_format/zstd_seekable_compression_format.md in the zstd sources.
+ */
+
+#ifndef _ZSTD_SEEKABLE_H_
+#define _ZSTD_SEEKABLE_H_ 1
+
+#include <stdint.h>
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// The skippable frame magic number used for the seek table.
+static const uint32_t ZSTD_SEEKABLE_SKIPPABLE_MAGIC = 0x184D2A5E;
+// The magic number that ends the seek table footer.
+static const uint32_t ZSTD_SEEKABLE_MAGIC = 0x8F92EAB1;
+// The skippable frame header: magic number plus frame size.
+static const int ZSTD_SEEKABLE_FRAME_HEADER_SIZE = 8;
+// The footer: number of frames, descriptor byte, and magic number.
+static const int ZSTD_SEEKABLE_FOOTER_SIZE = 9;
+// Each entry holds the compressed and decompressed size of one frame, followed
+// by a checksum if the descriptor has ZSTD_SEEKABLE_CHECKSUM_FLAG set.
+static const int ZSTD_SEEKABLE_ENTRY_SIZE = 8;
+static const int ZSTD_SEEKABLE_CHECKSUM_SIZE = 4;
+static const uint8_t ZSTD_SEEKABLE_CHECKSUM_FLAG = 0x80;
+
+// All fields are little-endian.
+static inline uint32_t
+zstd_seekable_read32(const unsigned char *src)
+{
+    return static_cast<uint32_t>(src[0]) | (static_cast<uint32_t>(src[1]) << 8) |
+        (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[3]) << 24);
+}
+
+static inline void
+zstd_seekable_write32(unsigned char *dst, uint32_t value)
+{
+    dst[0] = static_cast<unsigned char>(value);
+    dst[1] = static_cast<unsigned char>(value >> 8);
+    dst[2] = static_cast<unsigned char>(value >> 16);
+    dst[3] = static_cast<unsigned char>(value >> 24);
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _ZSTD_SEEKABLE_H_ */
@@ -0,0 +1,225 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "columnar_file_reader.h"
+
+#include <stddef.h>
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/**************************************************
+ * columnar_reader_t.
+ */
+
+columnar_reader_t::~columnar_reader_t()
+{
+    ZSTD_freeDCtx(dctx_);
+}
+
+bool
+columnar_reader_t::open(const std::string &path)
+{
+    file_.reset(new std::ifstream(path, std::ifstream::binary));
+    if (!*file_)
+        return false;
+    dctx_ = ZSTD_createDCtx();
+    return dctx_ != nullptr;
+}
+
+trace_entry_t *
+columnar_reader_t::read_next(bool *eof)
+{
+    while (next_record_ >= records_.size()) {
+        if (!read_block(eof))
+            return nullptr;
+    }
+    return &records_[next_record_++];
+}
+
+bool
+columnar_reader_t::seek(uint64_t offset)
+{
+    file_->clear();
+    if (!file_->seekg(offset))
+        return false;
+    records_.clear();
+    next_record_ = 0;
+    return true;
+}
+
+bool
+columnar_reader_t::read_block(bool *eof)
+{
+    columnar_block_header_t header;
+    const size_t fixed_size = offsetof(columnar_block_header_t, columns);
+    if (!file_->read(reinterpret_cast<char *>(&header), fixed_size)) {
+        *eof = file_->gcount() == 0;
+        return false;
+    }
+    // We accept extra columns from future versions but not a newer layout.
+    if (header.magic != COLUMNAR_BLOCK_MAGIC || header.version > COLUMNAR_VERSION ||
+        header.column_count < COLUMNAR_COLUMN_COUNT || header.column_count > 64 ||
+        header.record_count > COLUMNAR_BLOCK_RECORDS)
+        return false;
+    std::vector<columnar_column_header_t> columns(header.column_count);
+    if (!file_->read(reinterpret_cast<char *>(columns.data()),
+                     columns.size() * sizeof(columns[0])))
+        return false;
+    // No record needs more than two 3-byte varints for its type and size plus
+    // one 10-byte varint for its address.
+    const uint64_t max_raw_size = static_cast<uint64_t>(header.record_count) * 16;
+    for (uint32_t i = 0; i < header.column_count; ++i) {
+        if (i >= COLUMNAR_COLUMN_COUNT ||
+            (i == COLUMNAR_COLUMN_DATA_ADDRS && skip_data_addresses)) {
+            if (!file_->seekg(columns[i].compressed_size, std::ios_base::cur))
+                return false;
+            if (i < COLUMNAR_COLUMN_COUNT)
+                columns_[i].clear();
+            continue;
+        }
+        if (columns[i].raw_size > max_raw_size)
+            return false;
+        columns_[i].resize(columns[i].raw_size);
+        if (columns[i].raw_size == 0)
+            continue;
+        compressed_.resize(columns[i].compressed_size);
+        if (!file_->read(compressed_.data(), compressed_.size()))
+            return false;
+        size_t size = ZSTD_decompressDCtx(dctx_, columns_[i].data(), columns_[i].size(),
+                                          compressed_.data(), compressed_.size());
+        if (ZSTD_isError(size) || size != columns_[i].size())
+            return false;
+    }
+    return decode_block(header.record_count);
+}
+
+bool
+columnar_reader_t::decode_block(uint32_t record_count)
+{
+    const unsigned char *pos[COLUMNAR_COLUMN_COUNT];
+    const unsigned char *end[COLUMNAR_COLUMN_COUNT];
+    for (int i = 0; i < COLUMNAR_COLUMN_COUNT; ++i) {
+        pos[i] = columns_[i].data();
+        end[i] = pos[i] + columns_[i].size();
+    }
+    records_.resize(record_count);
+    next_record_ = 0;
+    predictor_.reset();
+    for (trace_entry_t &entry : records_) {
+        uint64_t type, size, value;
+        if (!columnar_read_varint(&pos[COLUMNAR_COLUMN_TYPES], end[COLUMNAR_COLUMN_TYPES],
+                                  &type) ||
+            !columnar_read_varint(&pos[COLUMNAR_COLUMN_TYPES], end[COLUMNAR_COLUMN_TYPES],
+                                  &size) ||
+            type > TRACE_TYPE_INVALID || size > UINT16_MAX)
+            return false;
+        entry.type = static_cast<unsigned short>(type);
+        entry.size = static_cast<unsigned short>(size);
+        columnar_column_t column =
+            columnar_address_column(static_cast<trace_type_t>(entry.type));
+        if (column == COLUMNAR_COLUMN_DATA_ADDRS && skip_data_addresses) {
+            entry.addr = 0;
+            continue;
+        }
+        if (!columnar_read_varint(&pos[column], end[column], &value))
+            return false;
+        uint64_t *predicted = nullptr;
+        if (column == COLUMNAR_COLUMN_PCS)
+            predicted = &predictor_.next_pc();
+        else if (column == COLUMNAR_COLUMN_DATA_ADDRS)
+            predicted = &predictor_.next_data_addr();
+        else if (type == TRACE_TYPE_MARKER && size == TRACE_MARKER_TYPE_TIMESTAMP)
+            predicted = &predictor_.next_timestamp();
+        if (predicted != nullptr) {
+            *predicted += columnar_zigzag_decode(value);
+            entry.addr = static_cast<addr_t>(*predicted);
+        } else
+            entry.addr = static_cast<addr_t>(value);
+    }
+    return true;
+}
+
+/**************************************************
+ * columnar_reader_t specializations for file_reader_t.
+ */
+
+/* clang-format off */ /* (make vera++ newline-after-type check happy) */
+template <>
+/* clang-format on */
+file_reader_t<columnar_reader_t>::file_reader_t()
+{
+}
+
+/* clang-format off */ /* (make vera++ newline-after-type check happy) */
+template <>
+/* clang-format on */
+file_reader_t<columnar_reader_t>::~file_reader_t()
+{
+}
+
+template <>
+bool
+file_reader_t<columnar_reader_t>::open_single_file(const std::string &path)
+{
+    if (!input_file_.open(path))
+        return false;
+    VPRINT(this, 1, "Opened input file %s\n", path.c_str());
+    return true;
+}
+
+template <>
+trace_entry_t *
+file_reader_t<columnar_reader_t>::read_next_entry()
+{
+    trace_entry_t *entry = read_queued_entry();
+    if (entry != nullptr)
+        return entry;
+    entry = input_file_.read_next(&at_eof_);
+    if (entry == nullptr)
+        return entry;
+    VPRINT(this, 4, "Read from file: type=%s (%d), size=%d, addr=%zu\n",
+           trace_type_names[entry->type], entry->type, entry->size, entry->addr);
+    entry_copy_ = *entry;
+    return &entry_copy_;
+}
+
+template <>
+bool
+file_reader_t<columnar_reader_t>::seek_to_chunk(uint64_t offset)
+{
+    // Each indexed chunk starts a new block.
+    return input_file_.seek(offset);
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,130 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* columnar_file_reader: reads files in the columnar trace format described in
+ * common/columnar_format.h.
+ */
+
+#ifndef _COLUMNAR_FILE_READER_H_
+#define _COLUMNAR_FILE_READER_H_ 1
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <zstd.h>
+
+#include "common/columnar_format.h"
+#include "file_reader.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// Decodes one block at a time back into trace_entry_t records.
+class columnar_reader_t {
+public:
+    columnar_reader_t() = default;
+    ~columnar_reader_t();
+    columnar_reader_t(const columnar_reader_t &) = delete;
+    columnar_reader_t &
+    operator=(const columnar_reader_t &) = delete;
+
+    bool
+    open(const std::string &path);
+
+    // Returns the next record.  Returns nullptr at the end of the file, setting
+    // *eof, or on an error, leaving *eof unset.
+    trace_entry_t *
+    read_next(bool *eof);
+
+    // Discards the decoded block and positions the file at "offset", which must
+    // be the start of a block.
+    bool
+    seek(uint64_t offset);
+
+    // Whether to leave the data address column compressed, returning data
+    // records with an address of 0.
+    bool skip_data_addresses = false;
+
+private:
+    // Reads and decodes the next block.  Sets *eof if there is none.
+    bool
+    read_block(bool *eof);
+
+    bool
+    decode_block(uint32_t record_count);
+
+    std::unique_ptr<std::ifstream> file_;
+    ZSTD_DCtx *dctx_ = nullptr;
+    std::vector<trace_entry_t> records_;
+    size_t next_record_ = 0;
+    std::vector<char> compressed_;
+    std::vector<unsigned char> columns_[COLUMNAR_COLUMN_COUNT];
+    columnar_predictor_t predictor_;
+};
+
+/* Declare these so the compiler knows not to use the default implementations
+ * when instantiating columnar_file_reader_t.
+ */
+/* clang-format off */ /* (make vera++ newline-after-type check happy) */
+template <>
+/* clang-format on */
+file_reader_t<columnar_reader_t>::file_reader_t();
+/* clang-format off */ /* (make vera++ newline-after-type check happy) */
+template <>
+/* clang-format on */
+file_reader_t<columnar_reader_t>::~file_reader_t();
+
+// The skip_data_addresses parameter is meant for tools that never look at data
+// addresses: see scheduler_options_t::skip_data_addresses.
+class columnar_file_reader_t : public file_reader_t<columnar_reader_t> {
+public:
+    columnar_file_reader_t() = default;
+    columnar_file_reader_t(const std::string &path, int verbosity = 0,
+                           bool skip_data_addresses = false)
+        : file_reader_t<columnar_reader_t>(path, verbosity)
+    {
+        input_file_.skip_data_addresses = skip_data_addresses;
+    }
+};
+
+/* Declare this so the compiler knows not to use the default implementation in the
+ * class declaration.
+ */
+template <>
+bool
+file_reader_t<columnar_reader_t>::seek_to_chunk(uint64_t offset);
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _COLUMNAR_FILE_READER_H_ */
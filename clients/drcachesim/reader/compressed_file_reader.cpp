@@ -32,7 +32,13 @@
 
 #include "compressed_file_reader.h"
 
+#include <fcntl.h>
 #include <zlib.h>
+#ifdef WINDOWS
+#    include <io.h>
+#else
+#    include <unistd.h>
+#endif
 
 #include <memory>
 #include <string>
@@ -134,6 +140,45 @@ file_reader_t<gzip_reader_t>::read_next_entry()
     return &entry_copy_;
 }
 
+template <>
+bool
+file_reader_t<gzip_reader_t>::seek_to_chunk(uint64_t offset)
+{
+    // Each indexed chunk starts a new gzip member, so a new decompressor can
+    // start right at its offset: gzdopen() reads from the descriptor's position.
+#ifdef WINDOWS
+    int fd = _open(input_path_.c_str(), _O_RDONLY | _O_BINARY);
+    if (fd < 0)
+        return false;
+    if (_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+        _close(fd);
+        return false;
+    }
+#else
+    int fd = open(input_path_.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    if (lseek(fd, static_cast<off_t>(offset), SEEK_SET) < 0) {
+        close(fd);
+        return false;
+    }
+#endif
+    gzFile file = gzdopen(fd, "rb");
+    if (file == nullptr) {
+#ifdef WINDOWS
+        _close(fd);
+#else
+        close(fd);
+#endif
+        return false;
+    }
+    gzclose(input_file_.file);
+    input_file_.file = file;
+    input_file_.cur_buf = input_file_.buf;
+    input_file_.max_buf = input_file_.buf;
+    return true;
+}
+
 /*********************************************************
  * gzip_reader_t specializations for record_file_reader_t.
  */
@@ -66,6 +66,13 @@ typedef file_reader_t<gzip_reader_t> compressed_file_reader_t;
 typedef dynamorio::drmemtrace::record_file_reader_t<gzip_reader_t>
     compressed_record_file_reader_t;
 
+/* Declare this so the compiler knows not to use the default implementation in the
+ * class declaration.
+ */
+template <>
+bool
+file_reader_t<gzip_reader_t>::seek_to_chunk(uint64_t offset);
+
 } // namespace drmemtrace
 } // namespace dynamorio
 
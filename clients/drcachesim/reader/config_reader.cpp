@@ -171,6 +171,44 @@ config_reader_t::configure(std::istream *config_file, cache_simulator_knobs_t &k
             } else {
                 knobs.use_physical = false;
             }
+        } else if (param == "sim_parallel") {
+            // Whether to simulate cores in parallel.
+            std::string bool_val;
+            if (!(*fin_ >> bool_val)) {
+                ERRMSG("Error reading sim_parallel from the configuration file\n");
+                return false;
+            }
+            if (is_true(bool_val)) {
+                knobs.sim_parallel = true;
+            } else {
+                knobs.sim_parallel = false;
+            }
+        } else if (param == "prefetcher_table_entries") {
+            // Entries in each table-based prefetcher's table.
+            if (!(*fin_ >> knobs.prefetcher_table_entries)) {
+                ERRMSG("Error reading prefetcher_table_entries from the configuration "
+                       "file\n");
+                return false;
+            }
+        } else if (param == "prefetcher_degree") {
+            // Lines fetched per prefetcher trigger.
+            if (!(*fin_ >> knobs.prefetcher_degree)) {
+                ERRMSG("Error reading prefetcher_degree from the configuration file\n");
+                return false;
+            }
+        } else if (param == "prefetcher_late_distance") {
+            // Demand accesses within which a prefetch is considered late.
+            if (!(*fin_ >> knobs.prefetcher_late_distance)) {
+                ERRMSG("Error reading prefetcher_late_distance from the configuration "
+                       "file\n");
+                return false;
+            }
+        } else if (param == "sim_parallel_batch") {
+            // Records per core between shared cache updates.
+            if (!(*fin_ >> knobs.sim_parallel_batch)) {
+                ERRMSG("Error reading sim_parallel_batch from the configuration file\n");
+                return false;
+            }
         } else {
             // A cache unit.
             cache_params_t cache;
@@ -322,19 +360,27 @@ config_reader_t::configure_cache(cache_params_t &cache)
             if (cache.replace_policy != REPLACE_POLICY_NON_SPECIFIED &&
                 cache.replace_policy != REPLACE_POLICY_LRU &&
                 cache.replace_policy != REPLACE_POLICY_LFU &&
-                cache.replace_policy != REPLACE_POLICY_FIFO) {
+                cache.replace_policy != REPLACE_POLICY_FIFO &&
+                cache.replace_policy != REPLACE_POLICY_SRRIP &&
+                cache.replace_policy != REPLACE_POLICY_BRRIP &&
+                cache.replace_policy != REPLACE_POLICY_DRRIP &&
+                cache.replace_policy != REPLACE_POLICY_SHIP &&
+                cache.replace_policy != REPLACE_POLICY_HAWKEYE) {
                 ERRMSG("Unknown replacement policy: %s\n", cache.replace_policy.c_str());
                 return false;
             }
         } else if (param == "prefetcher") {
-            // Type of prefetcher: PREFETCH_POLICY_NEXTLINE
-            // or PREFETCH_POLICY_NONE.
+            // Type of prefetcher: PREFETCH_POLICY_NEXTLINE, PREFETCH_POLICY_STRIDE,
+            // PREFETCH_POLICY_STREAM, PREFETCH_POLICY_SMS, or PREFETCH_POLICY_NONE.
             if (!(*fin_ >> cache.prefetcher)) {
                 ERRMSG("Error reading cache prefetcher from "
                        "the configuration file\n");
                 return false;
             }
             if (cache.prefetcher != PREFETCH_POLICY_NEXTLINE &&
+                cache.prefetcher != PREFETCH_POLICY_STRIDE &&
+                cache.prefetcher != PREFETCH_POLICY_STREAM &&
+                cache.prefetcher != PREFETCH_POLICY_SMS &&
                 cache.prefetcher != PREFETCH_POLICY_NONE) {
                 ERRMSG("Unknown prefetcher type: %s\n", cache.prefetcher.c_str());
                 return false;
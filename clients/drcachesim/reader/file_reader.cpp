@@ -88,5 +88,14 @@ file_reader_t<std::ifstream *>::read_next_entry()
     return &entry_copy_;
 }
 
+template <>
+bool
+file_reader_t<std::ifstream *>::seek_to_chunk(uint64_t offset)
+{
+    // A prior read may have hit the end.
+    input_file_->clear();
+    return static_cast<bool>(input_file_->seekg(static_cast<std::streamoff>(offset)));
+}
+
 } // namespace drmemtrace
 } // namespace dynamorio
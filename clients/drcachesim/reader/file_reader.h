@@ -42,6 +42,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
 #include <fstream>
 #include <queue>
 #include <string>
@@ -51,6 +52,7 @@
 #include "memref.h"
 #include "reader.h"
 #include "trace_entry.h"
+#include "trace_index.h"
 #include "utils.h"
 
 namespace dynamorio {
@@ -116,6 +118,10 @@ protected:
             ERRMSG("Failed to open %s\n", input_path_.c_str());
             return false;
         }
+        if (input_path_ != "-" && read_trace_index(input_path_, chunk_index_)) {
+            VPRINT(this, 1, "Read chunk index with %zu entries for %s\n",
+                   chunk_index_.size(), input_path_.c_str());
+        }
 
         // First read the tid and pid entries which precede any timestamps.
         // We hand out the tid to the output on every thread switch, and the pid
@@ -172,7 +178,54 @@ protected:
     reader_t &
     skip_instructions(uint64_t instruction_count) override
     {
-        return reader_t::skip_instructions(instruction_count);
+        if (chunk_index_.empty())
+            return reader_t::skip_instructions(instruction_count);
+        // Like the other chunked readers, we leave the headers alone for a 0 skip.
+        if (instruction_count == 0)
+            return *this;
+        VPRINT(this, 2, "Skipping %" PRIu64 " instrs in %s\n", instruction_count,
+               input_path_.c_str());
+        if (!pre_skip_instructions())
+            return *this;
+        uint64_t stop_count = cur_instr_count_ + instruction_count;
+        skip_to_indexed_chunk(stop_count);
+        // Walk the rest of the way, picking up the timestamp and cpu which the
+        // chunk we may have jumped to repeats in its header.
+        return skip_instructions_with_timestamp(stop_count);
+    }
+
+    // Positions the input at "offset" in the file, which is the start of a chunk
+    // in the chunk index, discarding any buffered data.  Returns false if this
+    // file type cannot seek.  Provided so that instantiations can specialize.
+    virtual bool
+    seek_to_chunk(uint64_t offset)
+    {
+        return false;
+    }
+
+    // Uses the chunk index to jump to the last chunk which starts no later than
+    // "stop_instruction_count", if that is past the current position.  Returns
+    // whether it moved.
+    bool
+    skip_to_indexed_chunk(uint64_t stop_instruction_count)
+    {
+        // Queued entries precede the current position.
+        if (chunk_index_.empty() || !queue_.empty())
+            return false;
+        auto it = std::upper_bound(
+            chunk_index_.begin(), chunk_index_.end(), stop_instruction_count,
+            [](uint64_t ordinal, const trace_index_entry_t &entry) {
+                return ordinal < entry.instr_ordinal;
+            });
+        if (it == chunk_index_.begin())
+            return false;
+        --it;
+        if (it->instr_ordinal <= cur_instr_count_ || !seek_to_chunk(it->offset))
+            return false;
+        VPRINT(this, 2, "At %" PRIu64 " instrs at chunk offset %" PRIu64 "\n",
+               it->instr_ordinal, it->offset);
+        cur_instr_count_ = it->instr_ordinal;
+        return true;
     }
 
     // Protected for access by mock_file_reader_t.
@@ -180,8 +233,17 @@ protected:
 
 private:
     std::string input_path_;
+    // Read from the trace's chunk index file, if it has one.
+    std::vector<trace_index_entry_t> chunk_index_;
 };
 
+/* Declare this so the compiler knows not to use the default implementation in the
+ * class declaration.
+ */
+template <>
+bool
+file_reader_t<std::ifstream *>::seek_to_chunk(uint64_t offset);
+
 } // namespace drmemtrace
 } // namespace dynamorio
 
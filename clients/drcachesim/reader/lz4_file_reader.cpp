@@ -104,5 +104,18 @@ file_reader_t<lz4_reader_t>::read_next_entry()
     return &entry_copy_;
 }
 
+template <>
+bool
+file_reader_t<lz4_reader_t>::seek_to_chunk(uint64_t offset)
+{
+    // Each indexed chunk starts a new lz4 frame.  We always create an
+    // lz4_istream_t in open_single_file().
+    if (!static_cast<lz4_istream_t *>(input_file_.file)->seek_to_frame_offset(offset))
+        return false;
+    input_file_.cur_buf = input_file_.buf;
+    input_file_.max_buf = input_file_.buf;
+    return true;
+}
+
 } // namespace drmemtrace
 } // namespace dynamorio
@@ -57,6 +57,13 @@ struct lz4_reader_t {
 
 typedef file_reader_t<lz4_reader_t> lz4_file_reader_t;
 
+/* Declare this so the compiler knows not to use the default implementation in the
+ * class declaration.
+ */
+template <>
+bool
+file_reader_t<lz4_reader_t>::seek_to_chunk(uint64_t offset);
+
 } // namespace drmemtrace
 } // namespace dynamorio
 
@@ -0,0 +1,236 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "mmap_file_reader.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dynamorio {
+namespace drmemtrace {
+
+namespace {
+
+bool
+map_file(const std::string &path, mmap_reader_t &map)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_size < static_cast<off_t>(sizeof(trace_entry_t)) ||
+        static_cast<uint64_t>(st.st_size) > SIZE_MAX) {
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    // The readers rewrite the type of some records in place, so we need a
+    // writable mapping.  It is private, so only the pages touched are copied.
+    void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file.
+    close(fd);
+    if (base == MAP_FAILED)
+        return false;
+    // These are only hints, so we ignore failure.
+    madvise(base, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    madvise(base, size, MADV_HUGEPAGE);
+#endif
+    map = mmap_reader_t(base, size);
+    return true;
+}
+
+void
+unmap_file(mmap_reader_t &map)
+{
+    if (map.map_base != nullptr) {
+        munmap(map.map_base, map.map_size);
+        map = mmap_reader_t();
+    }
+}
+
+// Moves past the next chunk footer.  Returns false and leaves the position alone
+// if there is none.
+bool
+skip_to_next_chunk(mmap_reader_t &map)
+{
+    for (trace_entry_t *entry = map.cur_buf; entry < map.max_buf; ++entry) {
+        if (entry->type == TRACE_TYPE_MARKER &&
+            entry->size == TRACE_MARKER_TYPE_CHUNK_FOOTER) {
+            map.cur_buf = entry + 1;
+            return true;
+        }
+    }
+    map.has_chunks = false;
+    return false;
+}
+
+} // namespace
+
+/**************************************************
+ * mmap_reader_t specializations for file_reader_t.
+ */
+
+/* clang-format off */ /* (make vera++ newline-after-type check happy) */
+template <>
+/* clang-format on */
+file_reader_t<mmap_reader_t>::file_reader_t()
+{
+}
+
+/* clang-format off */ /* (make vera++ newline-after-type check happy) */
+template <>
+/* clang-format on */
+file_reader_t<mmap_reader_t>::~file_reader_t()
+{
+    unmap_file(input_file_);
+}
+
+template <>
+bool
+file_reader_t<mmap_reader_t>::open_single_file(const std::string &path)
+{
+    if (!map_file(path, input_file_))
+        return false;
+    VPRINT(this, 1, "Mapped input file %s of %zu bytes\n", path.c_str(),
+           input_file_.map_size);
+    return true;
+}
+
+template <>
+trace_entry_t *
+file_reader_t<mmap_reader_t>::read_next_entry()
+{
+    trace_entry_t *entry = read_queued_entry();
+    if (entry != nullptr)
+        return entry;
+    if (input_file_.cur_buf >= input_file_.max_buf) {
+        at_eof_ = true;
+        return nullptr;
+    }
+    // We hand out the record in the mapping itself, with no copy.
+    entry = input_file_.cur_buf;
+    ++input_file_.cur_buf;
+    VPRINT(this, 4, "Read from file: type=%s (%d), size=%d, addr=%zu\n",
+           trace_type_names[entry->type], entry->type, entry->size, entry->addr);
+    return entry;
+}
+
+template <>
+reader_t &
+file_reader_t<mmap_reader_t>::skip_instructions(uint64_t instruction_count)
+{
+    if (instruction_count == 0)
+        return *this;
+    VPRINT(this, 2, "Skipping %" PRIu64 " instrs in %s\n", instruction_count,
+           input_path_.c_str());
+    if (!pre_skip_instructions())
+        return *this;
+    uint64_t stop_count = cur_instr_count_ + instruction_count + 1;
+    skip_to_indexed_chunk(stop_count - 1);
+    // Jump over whole chunks just like the zipfile reader does.  Without an index
+    // of where each chunk starts, finding the footers in the mapping is still much
+    // cheaper than processing every record.
+    if (chunk_instr_count_ > 0 && input_file_.has_chunks) {
+        while (cur_instr_count_ +
+                   (chunk_instr_count_ - (cur_instr_count_ % chunk_instr_count_)) <
+               stop_count) {
+            if (!skip_to_next_chunk(input_file_))
+                break;
+            cur_instr_count_ +=
+                chunk_instr_count_ - (cur_instr_count_ % chunk_instr_count_);
+            VPRINT(this, 2, "At %" PRIu64 " instrs at start of new chunk\n",
+                   cur_instr_count_);
+        }
+    }
+    // Now do a linear walk the rest of the way, remembering timestamps (we have
+    // duplicated timestamps at the start of the chunk to cover any skipped in
+    // the fast chunk jumps we just did).
+    // Subtract 1 to pass the target instr itself.
+    return skip_instructions_with_timestamp(stop_count - 1);
+}
+
+template <>
+bool
+file_reader_t<mmap_reader_t>::seek_to_chunk(uint64_t offset)
+{
+    if (offset % sizeof(trace_entry_t) != 0 || offset >= input_file_.map_size)
+        return false;
+    input_file_.cur_buf = reinterpret_cast<trace_entry_t *>(
+        reinterpret_cast<char *>(input_file_.map_base) + offset);
+    return true;
+}
+
+/*********************************************************
+ * mmap_reader_t specializations for record_file_reader_t.
+ */
+
+template <> record_file_reader_t<mmap_reader_t>::~record_file_reader_t()
+{
+    if (input_file_)
+        unmap_file(*input_file_);
+}
+
+template <>
+bool
+record_file_reader_t<mmap_reader_t>::open_single_file(const std::string &path)
+{
+    mmap_reader_t map;
+    if (!map_file(path, map))
+        return false;
+    input_file_ = std::unique_ptr<mmap_reader_t>(new mmap_reader_t(map));
+    VPRINT(this, 1, "Mapped input file %s of %zu bytes\n", path.c_str(), map.map_size);
+    return true;
+}
+
+template <>
+bool
+record_file_reader_t<mmap_reader_t>::read_next_entry()
+{
+    if (input_file_->cur_buf >= input_file_->max_buf) {
+        eof_ = true;
+        return false;
+    }
+    cur_entry_ = *input_file_->cur_buf;
+    ++input_file_->cur_buf;
+    VPRINT(this, 4, "Read from file: type=%s (%d), size=%d, addr=%zu\n",
+           trace_type_names[cur_entry_.type], cur_entry_.type, cur_entry_.size,
+           cur_entry_.addr);
+    return true;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
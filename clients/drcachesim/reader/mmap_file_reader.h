@@ -0,0 +1,98 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* mmap_file_reader: reads uncompressed files containing memory traces by mapping
+ * them into memory, handing out records directly from the mapping.
+ */
+
+#ifndef _MMAP_FILE_READER_H_
+#define _MMAP_FILE_READER_H_ 1
+
+#ifndef UNIX
+#    error UNIX-only
+#endif
+
+#include <stddef.h>
+
+#include "file_reader.h"
+#include "record_file_reader.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+struct mmap_reader_t {
+    mmap_reader_t()
+    {
+    }
+    mmap_reader_t(void *map_base, size_t map_size)
+        : map_base(map_base)
+        , map_size(map_size)
+        , cur_buf(reinterpret_cast<trace_entry_t *>(map_base))
+        , max_buf(reinterpret_cast<trace_entry_t *>(map_base) +
+                  map_size / sizeof(trace_entry_t))
+    {
+    }
+    void *map_base = nullptr;
+    size_t map_size = 0;
+    // The next record to read and the end of the whole records in the mapping.
+    trace_entry_t *cur_buf = nullptr;
+    trace_entry_t *max_buf = nullptr;
+    // Cleared once a search for a chunk footer runs off the end, so that we only
+    // pay for that scan once in a trace without chunks.
+    bool has_chunks = true;
+};
+
+/**
+ * Reads an uncompressed trace file through a private read-write mapping, which
+ * avoids copying each record out of a stream buffer.  The mapping is advised for
+ * sequential access and for transparent huge pages where the kernel supports them
+ * for file mappings.  Skipping moves across whole chunks using the chunk index, if
+ * the trace has one, or else by searching the mapping for chunk footers rather than
+ * by reading each record.
+ */
+typedef file_reader_t<mmap_reader_t> mmap_file_reader_t;
+typedef record_file_reader_t<mmap_reader_t> mmap_record_file_reader_t;
+
+/* Declare this so the compiler knows not to use the default implementation in the
+ * class declaration.
+ */
+template <>
+reader_t &
+file_reader_t<mmap_reader_t>::skip_instructions(uint64_t instruction_count);
+template <>
+bool
+file_reader_t<mmap_reader_t>::seek_to_chunk(uint64_t offset);
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _MMAP_FILE_READER_H_ */
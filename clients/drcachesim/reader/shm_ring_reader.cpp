@@ -0,0 +1,196 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "shm_ring_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace dynamorio {
+namespace drmemtrace {
+
+shm_ring_region_t::shm_ring_region_t(const std::string &ipc_name, uint32_t ring_count,
+                                     uint64_t ring_size)
+    : path_(shm_ring_path(ipc_name))
+{
+    if (ring_count == 0 || ring_size < SHM_RING_PAGE_SIZE ||
+        (ring_size & (ring_size - 1)) != 0) {
+        error_ = "The ring size must be a power of two of at least one page and the "
+                 "ring count must be non-zero";
+        return;
+    }
+    // Remove any stale file from a prior run that did not exit cleanly.
+    unlink(path_.c_str());
+    int fd = open(path_.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        error_ = "Failed to create " + path_ + ": " + strerror(errno);
+        return;
+    }
+    map_size_ = shm_ring_file_size(ring_count, ring_size);
+    // We reserve the space up front: running out of /dev/shm later would raise
+    // SIGBUS in the traced application.
+    int res = posix_fallocate(fd, 0, static_cast<off_t>(map_size_));
+    if (res != 0) {
+        error_ = "Failed to reserve " + std::to_string(map_size_) + " bytes for " +
+            path_ + ": " + strerror(res);
+        close(fd);
+        unlink(path_.c_str());
+        return;
+    }
+    void *map = mmap(nullptr, static_cast<size_t>(map_size_), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error_ = "Failed to map " + path_ + ": " + strerror(errno);
+        unlink(path_.c_str());
+        return;
+    }
+    // The file starts out zeroed, which is SHM_RING_FREE with empty rings.
+    control_ = static_cast<shm_ring_control_t *>(map);
+    control_->version = SHM_RING_VERSION;
+    control_->ring_count = ring_count;
+    control_->ring_size = ring_size;
+    // Tracers check this last so they never see a partially written control.
+    std::atomic_thread_fence(std::memory_order_release);
+    control_->magic = SHM_RING_MAGIC;
+}
+
+shm_ring_region_t::~shm_ring_region_t()
+{
+    if (control_ == nullptr)
+        return;
+    munmap(control_, static_cast<size_t>(map_size_));
+    unlink(path_.c_str());
+}
+
+shm_ring_reader_t::shm_ring_reader_t()
+{
+    /* Empty. */
+}
+
+shm_ring_reader_t::shm_ring_reader_t(std::shared_ptr<shm_ring_region_t> region,
+                                     uint32_t index, int verbosity)
+    : reader_t(verbosity, "SHM")
+    , region_(std::move(region))
+    , index_(index)
+{
+    if (region_ && region_->get_control() != nullptr)
+        ring_ = shm_ring_get(region_->get_control(), index_);
+}
+
+// Work around clang-format bug: no newline after return type for single-char operator.
+// clang-format off
+bool
+shm_ring_reader_t::operator!()
+// clang-format on
+{
+    return ring_ == nullptr;
+}
+
+std::string
+shm_ring_reader_t::get_stream_name() const
+{
+    if (!region_)
+        return "";
+    return region_->get_path() + ":" + std::to_string(index_);
+}
+
+bool
+shm_ring_reader_t::init()
+{
+    at_eof_ = false;
+    if (ring_ == nullptr)
+        return false;
+    cur_buf_ = buf_;
+    end_buf_ = buf_;
+    ++*this;
+    return true;
+}
+
+trace_entry_t *
+shm_ring_reader_t::read_next_entry()
+{
+    trace_entry_t *from_queue = read_queued_entry();
+    if (from_queue != nullptr)
+        return from_queue;
+    ++cur_buf_;
+    if (cur_buf_ >= end_buf_) {
+        // The producer may wrap in the middle of an entry, so keep reading until
+        // we have whole entries.  The ring carries one thread after another, each
+        // starting with its own header, until it is unused.
+        char *fill = reinterpret_cast<char *>(buf_);
+        size_t total = 0;
+        while (true) {
+            size_t got = shm_ring_read(region_->get_control(), ring_, fill + total,
+                                       sizeof(buf_) - total);
+            if (got == 0) {
+                // A thread that died mid-write can leave a partial entry, which
+                // we drop so the next thread on this ring starts aligned.
+                total -= total % sizeof(trace_entry_t);
+                if (total > 0 || ring_->state.load() == SHM_RING_UNUSED)
+                    break;
+                continue;
+            }
+            total += got;
+            if (total % sizeof(trace_entry_t) == 0)
+                break;
+        }
+        if (total == 0) {
+            // If called again at eof, do not return the footer: return an error.
+            if (at_eof_)
+                return nullptr;
+            cur_buf_ = buf_;
+            cur_buf_->type = TRACE_TYPE_FOOTER;
+            cur_buf_->size = 0;
+            cur_buf_->addr = 0;
+            at_eof_ = true;
+            return cur_buf_;
+        }
+        cur_buf_ = buf_;
+        end_buf_ = buf_ + (total / sizeof(trace_entry_t));
+    }
+    if (cur_buf_->type == TRACE_TYPE_FOOTER)
+        at_eof_ = true;
+    return cur_buf_;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
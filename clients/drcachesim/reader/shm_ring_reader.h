@@ -0,0 +1,117 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* shm_ring_reader: reads the traces of the threads that in turn wrote to one
+ * ring in the -ipc_shm shared-memory transport (see common/shm_ring.h).  The
+ * analyzer creates one reader per ring and consumes them in parallel shards.
+ */
+
+#ifndef _SHM_RING_READER_H_
+#define _SHM_RING_READER_H_ 1
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "reader.h"
+#include "../common/shm_ring.h"
+#include "../common/trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// Creates and owns the shared file; it is removed on destruction.  We create it
+// here so the user can launch the traced application *before* calling the
+// blocking analyzer_t::run(), just like for the named pipe.
+class shm_ring_region_t {
+public:
+    shm_ring_region_t(const std::string &ipc_name, uint32_t ring_count,
+                      uint64_t ring_size);
+    ~shm_ring_region_t();
+    // Returns a description of why creation failed, or "" on success.
+    const std::string &
+    get_error() const
+    {
+        return error_;
+    }
+    shm_ring_control_t *
+    get_control() const
+    {
+        return control_;
+    }
+    const std::string &
+    get_path() const
+    {
+        return path_;
+    }
+
+private:
+    std::string path_;
+    std::string error_;
+    shm_ring_control_t *control_ = nullptr;
+    uint64_t map_size_ = 0;
+};
+
+class shm_ring_reader_t : public reader_t {
+public:
+    shm_ring_reader_t();
+    shm_ring_reader_t(std::shared_ptr<shm_ring_region_t> region, uint32_t index,
+                      int verbosity);
+    bool
+    operator!() override;
+    // This blocks until a traced thread claims the ring.
+    bool
+    init() override;
+    std::string
+    get_stream_name() const override;
+
+protected:
+    trace_entry_t *
+    read_next_entry() override;
+
+private:
+    std::shared_ptr<shm_ring_region_t> region_;
+    shm_ring_t *ring_ = nullptr;
+    uint32_t index_ = 0;
+
+    // As for ipc_reader_t we read large chunks at a time.
+    static const int BUF_SIZE = 16 * 1024;
+    trace_entry_t buf_[BUF_SIZE];
+    trace_entry_t *cur_buf_ = nullptr;
+    trace_entry_t *end_buf_ = nullptr;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _SHM_RING_READER_H_ */
@@ -179,6 +179,19 @@ snappy_reader_t::read_new_chunk()
     }
 }
 
+bool
+snappy_reader_t::seek(uint64_t offset)
+{
+    // We still require the stream identifier at the start of the file.
+    if (!fstream_ || !seen_magic_)
+        return false;
+    fstream_->clear();
+    if (!fstream_->seekg(static_cast<std::streamoff>(offset)))
+        return false;
+    src_.reset();
+    return true;
+}
+
 int
 snappy_reader_t::read(size_t size, DR_PARAM_OUT void *to)
 {
@@ -244,5 +257,12 @@ file_reader_t<snappy_reader_t>::read_next_entry()
     return &entry_copy_;
 }
 
+template <>
+bool
+file_reader_t<snappy_reader_t>::seek_to_chunk(uint64_t offset)
+{
+    return input_file_.seek(offset);
+}
+
 } // namespace drmemtrace
 } // namespace dynamorio
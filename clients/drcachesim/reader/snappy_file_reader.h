@@ -68,6 +68,11 @@ public:
         return fstream_->eof();
     }
 
+    // Discards buffered data and positions the stream at "offset" in the file,
+    // which must be the start of a snappy chunk.
+    bool
+    seek(uint64_t offset);
+
 private:
     bool
     read_new_chunk();
@@ -98,6 +103,13 @@ private:
 
 typedef file_reader_t<snappy_reader_t> snappy_file_reader_t;
 
+/* Declare this so the compiler knows not to use the default implementation in the
+ * class declaration.
+ */
+template <>
+bool
+file_reader_t<snappy_reader_t>::seek_to_chunk(uint64_t offset);
+
 } // namespace drmemtrace
 } // namespace dynamorio
 
@@ -33,6 +33,14 @@
 #include "zipfile_file_reader.h"
 #include <inttypes.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace dynamorio {
 namespace drmemtrace {
 
@@ -126,8 +134,376 @@ read_if_at_end_of_buffer(zipfile_reader_t &zipfile, bool &at_eof,
     return true;
 }
 
+// Advances the handle from the current (fully read) component to the next one.
+bool
+advance_to_next_component(zipfile_reader_t &zipfile, bool &at_eof)
+{
+    if (unzCloseCurrentFile(zipfile.file) != UNZ_OK)
+        return false;
+    int res = unzGoToNextFile(zipfile.file);
+    if (res != UNZ_OK) {
+        if (res == UNZ_END_OF_LIST_OF_FILE) {
+            ZPRINT(zipfile.verbosity, 2, "Hit EOF in %s\n", zipfile.path.c_str());
+            at_eof = true;
+        }
+        return false;
+    }
+    if (unzOpenCurrentFile(zipfile.file) != UNZ_OK)
+        return false;
+    return true;
+}
+
+// Decompresses the entire current component into chunk and advances the handle
+// to the next component, skipping empty components.  Returns false at EOF
+// (setting at_eof) or on an error; in both cases chunk may still hold entries
+// which should be delivered before the failure.
+bool
+inflate_chunk(zipfile_reader_t &zipfile, std::vector<trace_entry_t> &chunk,
+              bool &at_eof)
+{
+    // unzReadCurrentFile takes an unsigned length so we read in pieces.
+    static constexpr size_t MAX_READ_BYTES = 1 << 30;
+    chunk.clear();
+    while (chunk.empty()) {
+        unz_file_info64 info;
+        if (unzGetCurrentFileInfo64(zipfile.file, &info, zipfile.name,
+                                    sizeof(zipfile.name), nullptr, 0, nullptr,
+                                    0) != UNZ_OK)
+            return false;
+        // The recorded size lets us inflate with a single allocation, but we do
+        // not rely on it being accurate.
+        chunk.resize(static_cast<size_t>(info.uncompressed_size) /
+                         sizeof(trace_entry_t) +
+                     1);
+        size_t bytes = 0;
+        while (true) {
+            size_t avail = chunk.size() * sizeof(trace_entry_t) - bytes;
+            if (avail == 0) {
+                chunk.resize(chunk.size() * 2);
+                continue;
+            }
+            int num_read = unzReadCurrentFile(
+                zipfile.file, reinterpret_cast<char *>(chunk.data()) + bytes,
+                static_cast<unsigned>(avail < MAX_READ_BYTES ? avail : MAX_READ_BYTES));
+            if (num_read < 0) {
+                ZPRINT(zipfile.verbosity, 1, "Failed to read: returned %d in %s %s\n",
+                       num_read, zipfile.path.c_str(), zipfile.name);
+                chunk.resize(bytes / sizeof(trace_entry_t));
+                return false;
+            }
+            if (num_read == 0)
+                break;
+            bytes += num_read;
+        }
+        chunk.resize(bytes / sizeof(trace_entry_t));
+        ZPRINT(zipfile.verbosity, 3,
+               "Inflated %zu entries from component %s; opening next component in %s\n",
+               chunk.size(), zipfile.name, zipfile.path.c_str());
+        if (!chunk.empty() &&
+            (chunk.back().type != TRACE_TYPE_MARKER ||
+             chunk.back().size != TRACE_MARKER_TYPE_CHUNK_FOOTER) &&
+            chunk.back().type != TRACE_TYPE_FOOTER) {
+            ZPRINT(zipfile.verbosity, 1,
+                   "Chunk is missing footer: truncation detected in %s %s\n",
+                   zipfile.path.c_str(), zipfile.name);
+            return false;
+        }
+        if (!advance_to_next_component(zipfile, at_eof))
+            return false;
+    }
+    return true;
+}
+
+typedef std::unique_ptr<std::vector<trace_entry_t>> chunk_buffer_t;
+
+// State shared by all inputs using read-ahead.  A single lock guards both this
+// and the per-input zipfile_read_ahead_t fields: hand-offs happen once per chunk,
+// so contention is negligible compared to the decompression itself.
+struct read_ahead_pool_t {
+    ~read_ahead_pool_t()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            exiting = true;
+        }
+        work_cond.notify_all();
+        for (std::thread &thread : threads)
+            thread.join();
+    }
+    int
+    max_outstanding() const
+    {
+        return chunks_per_input * static_cast<int>(threads.size());
+    }
+    chunk_buffer_t
+    take_buffer()
+    {
+        if (free_buffers.empty())
+            return chunk_buffer_t(new std::vector<trace_entry_t>());
+        chunk_buffer_t buffer = std::move(free_buffers.back());
+        free_buffers.pop_back();
+        return buffer;
+    }
+    void
+    release_buffer(chunk_buffer_t buffer)
+    {
+        // Recycled buffers keep their capacity so steady-state decompression
+        // does not allocate.  We only keep as many as can be in use at once.
+        if (static_cast<int>(free_buffers.size()) < max_outstanding())
+            free_buffers.push_back(std::move(buffer));
+    }
+
+    std::mutex lock;
+    std::condition_variable work_cond;
+    // Inputs with room for another chunk, in request order.
+    std::deque<zipfile_read_ahead_t *> work;
+    std::vector<chunk_buffer_t> free_buffers;
+    std::vector<std::thread> threads;
+    int chunks_per_input = 0;
+    int num_threads = 0;
+    // Chunks that have been inflated or are being inflated by the workers but
+    // have not yet been handed to a reader, across all inputs.
+    int outstanding = 0;
+    bool exiting = false;
+};
+
+read_ahead_pool_t &
+get_read_ahead_pool()
+{
+    static read_ahead_pool_t pool;
+    return pool;
+}
+
 } // namespace
 
+/**************************************************
+ * Background chunk decompression for file_reader_t.
+ */
+
+class zipfile_read_ahead_t {
+public:
+    // Returns nullptr if read-ahead is disabled.
+    static zipfile_read_ahead_t *
+    create(zipfile_reader_t *zipfile)
+    {
+        read_ahead_pool_t &pool = get_read_ahead_pool();
+        std::lock_guard<std::mutex> guard(pool.lock);
+        if (pool.chunks_per_input <= 0 || pool.num_threads <= 0)
+            return nullptr;
+        if (pool.threads.empty()) {
+            for (int i = 0; i < pool.num_threads; ++i)
+                pool.threads.emplace_back(worker_loop);
+        }
+        zipfile_read_ahead_t *read_ahead = new zipfile_read_ahead_t(zipfile);
+        read_ahead->maybe_enqueue(pool);
+        return read_ahead;
+    }
+
+    ~zipfile_read_ahead_t()
+    {
+        read_ahead_pool_t &pool = get_read_ahead_pool();
+        std::unique_lock<std::mutex> lock(pool.lock);
+        paused_ = true;
+        ready_cond_.wait(lock, [this] { return !in_flight_; });
+        pool.work.erase(std::remove(pool.work.begin(), pool.work.end(), this),
+                        pool.work.end());
+        pool.outstanding -= static_cast<int>(ready_.size());
+        for (chunk_buffer_t &buffer : ready_)
+            pool.release_buffer(std::move(buffer));
+        if (current_)
+            pool.release_buffer(std::move(current_));
+        pool.work_cond.notify_all();
+    }
+
+    // Recycles the chunk the reader has finished with and points the reader's
+    // cur_buf and max_buf at the next chunk.  Returns false with at_eof set at
+    // the end of the input, or false on an error.
+    bool
+    next_chunk(bool &at_eof)
+    {
+        read_ahead_pool_t &pool = get_read_ahead_pool();
+        std::unique_lock<std::mutex> lock(pool.lock);
+        if (current_)
+            pool.release_buffer(std::move(current_));
+        while (true) {
+            if (!ready_.empty()) {
+                current_ = std::move(ready_.front());
+                ready_.pop_front();
+                --pool.outstanding;
+                pool.work_cond.notify_one();
+                maybe_enqueue(pool);
+                zipfile_->cur_buf = current_->data();
+                zipfile_->max_buf = current_->data() + current_->size();
+                return true;
+            }
+            if (done_) {
+                if (at_eof_)
+                    at_eof = true;
+                return false;
+            }
+            if (in_flight_) {
+                ready_cond_.wait(lock);
+                continue;
+            }
+            // Nothing is pending for this input (the workers are busy with other
+            // inputs or the pool is full), so inflate the chunk ourselves rather
+            // than waiting.
+            ++pool.outstanding;
+            inflate_next(pool, lock);
+        }
+    }
+
+    // Stops background decompression for this input, waiting for any chunk
+    // being inflated, so that skip_chunk() can operate on the zip handle.
+    void
+    pause()
+    {
+        read_ahead_pool_t &pool = get_read_ahead_pool();
+        std::unique_lock<std::mutex> lock(pool.lock);
+        paused_ = true;
+        ready_cond_.wait(lock, [this] { return !in_flight_; });
+    }
+
+    void
+    resume()
+    {
+        read_ahead_pool_t &pool = get_read_ahead_pool();
+        std::lock_guard<std::mutex> guard(pool.lock);
+        paused_ = false;
+        maybe_enqueue(pool);
+    }
+
+    // Discards the next chunk without delivering it: the reader's current chunk,
+    // else the oldest inflated chunk, else the component the zip handle is on,
+    // which is skipped without being decompressed.  Must be called while paused.
+    bool
+    skip_chunk()
+    {
+        read_ahead_pool_t &pool = get_read_ahead_pool();
+        std::unique_lock<std::mutex> lock(pool.lock);
+        if (current_) {
+            pool.release_buffer(std::move(current_));
+            zipfile_->cur_buf = zipfile_->buf;
+            zipfile_->max_buf = zipfile_->buf;
+            return true;
+        }
+        if (!ready_.empty()) {
+            pool.release_buffer(std::move(ready_.front()));
+            ready_.pop_front();
+            --pool.outstanding;
+            pool.work_cond.notify_one();
+            return true;
+        }
+        if (done_)
+            return false;
+        lock.unlock();
+        bool at_eof = false;
+        if (advance_to_next_component(*zipfile_, at_eof))
+            return true;
+        lock.lock();
+        done_ = true;
+        at_eof_ = at_eof;
+        return false;
+    }
+
+private:
+    explicit zipfile_read_ahead_t(zipfile_reader_t *zipfile)
+        : zipfile_(zipfile)
+    {
+    }
+
+    static void
+    worker_loop()
+    {
+        read_ahead_pool_t &pool = get_read_ahead_pool();
+        std::unique_lock<std::mutex> lock(pool.lock);
+        while (true) {
+            pool.work_cond.wait(lock, [&pool] {
+                return pool.exiting ||
+                    (!pool.work.empty() && pool.outstanding < pool.max_outstanding());
+            });
+            if (pool.exiting)
+                return;
+            zipfile_read_ahead_t *input = pool.work.front();
+            pool.work.pop_front();
+            input->queued_ = false;
+            // The input's state may have changed since it was queued.
+            if (!input->can_inflate(pool))
+                continue;
+            ++pool.outstanding;
+            input->inflate_next(pool, lock);
+        }
+    }
+
+    bool
+    can_inflate(const read_ahead_pool_t &pool) const
+    {
+        return !in_flight_ && !paused_ && !done_ &&
+            static_cast<int>(ready_.size()) < pool.chunks_per_input;
+    }
+
+    void
+    maybe_enqueue(read_ahead_pool_t &pool)
+    {
+        if (queued_ || !can_inflate(pool))
+            return;
+        queued_ = true;
+        pool.work.push_back(this);
+        pool.work_cond.notify_one();
+    }
+
+    // Called with the pool lock held and with pool.outstanding already
+    // incremented for the new chunk.  Drops the lock while decompressing.
+    void
+    inflate_next(read_ahead_pool_t &pool, std::unique_lock<std::mutex> &lock)
+    {
+        in_flight_ = true;
+        chunk_buffer_t buffer = pool.take_buffer();
+        lock.unlock();
+        bool at_eof = false;
+        bool ok = inflate_chunk(*zipfile_, *buffer, at_eof);
+        lock.lock();
+        in_flight_ = false;
+        if (!ok) {
+            done_ = true;
+            at_eof_ = at_eof;
+        }
+        if (buffer->empty()) {
+            --pool.outstanding;
+            pool.release_buffer(std::move(buffer));
+            pool.work_cond.notify_one();
+        } else
+            ready_.push_back(std::move(buffer));
+        maybe_enqueue(pool);
+        ready_cond_.notify_all();
+    }
+
+    // Only touched by the thread with in_flight_ set, or by the reader while
+    // paused_ and not in_flight_.
+    zipfile_reader_t *zipfile_;
+    // The remaining fields are guarded by the pool lock.
+    std::condition_variable ready_cond_;
+    std::deque<chunk_buffer_t> ready_;
+    // The chunk the reader's cur_buf and max_buf point into.
+    chunk_buffer_t current_;
+    bool queued_ = false;
+    bool in_flight_ = false;
+    bool paused_ = false;
+    // Set once the zip handle has hit the end of the file or an error.
+    bool done_ = false;
+    bool at_eof_ = false;
+};
+
+void
+set_zipfile_read_ahead(int chunks_per_input, int num_threads)
+{
+    read_ahead_pool_t &pool = get_read_ahead_pool();
+    std::lock_guard<std::mutex> guard(pool.lock);
+    pool.chunks_per_input = chunks_per_input;
+    if (pool.threads.empty())
+        pool.num_threads = num_threads;
+}
+
 /**************************************************
  * zipfile_reader_t specializations for file_reader_t.
  */
@@ -145,6 +521,9 @@ template <>
 /* clang-format on */
 file_reader_t<zipfile_reader_t>::~file_reader_t()
 {
+    // This waits for any in-progress decompression of this input.
+    delete input_file_.read_ahead;
+    input_file_.read_ahead = nullptr;
     if (input_file_.file != nullptr) {
         unzClose(input_file_.file);
         input_file_.file = nullptr;
@@ -159,6 +538,7 @@ file_reader_t<zipfile_reader_t>::open_single_file(const std::string &path)
         return false;
     VPRINT(this, 1, "Opened input file %s\n", path.c_str());
     input_file_.verbosity = verbosity_;
+    input_file_.read_ahead = zipfile_read_ahead_t::create(&input_file_);
     return true;
 }
 
@@ -169,7 +549,12 @@ file_reader_t<zipfile_reader_t>::read_next_entry()
     trace_entry_t *from_queue = read_queued_entry();
     if (from_queue != nullptr)
         return from_queue;
-    if (!read_if_at_end_of_buffer(input_file_, at_eof_, entry_copy_))
+    if (input_file_.read_ahead != nullptr) {
+        // The chunk buffer is filled in the background and handed over as-is.
+        if (input_file_.cur_buf >= input_file_.max_buf &&
+            !input_file_.read_ahead->next_chunk(at_eof_))
+            return nullptr;
+    } else if (!read_if_at_end_of_buffer(input_file_, at_eof_, entry_copy_))
         return nullptr;
     entry_copy_ = *input_file_.cur_buf;
     ++input_file_.cur_buf;
@@ -203,28 +588,41 @@ file_reader_t<zipfile_reader_t>::skip_instructions(uint64_t instruction_count)
            stop_count, cur_instr_count_, chunk_instr_count_,
            cur_instr_count_ +
                (chunk_instr_count_ - (cur_instr_count_ % chunk_instr_count_)));
+    // With read-ahead we drop already-inflated chunks instead, and we keep the
+    // workers from decompressing chunks we are about to skip.
+    if (zipfile->read_ahead != nullptr)
+        zipfile->read_ahead->pause();
     // First, quickly skip over chunks to reach the chunk containing the target.
     while (cur_instr_count_ +
                (chunk_instr_count_ - (cur_instr_count_ % chunk_instr_count_)) <
            stop_count) {
-        if (unzCloseCurrentFile(zipfile->file) != UNZ_OK) {
-            VPRINT(this, 1, "Failed to close zip subfile\n");
-            at_eof_ = true;
-            return *this;
-        }
-        int res = unzGoToNextFile(zipfile->file);
-        if (res != UNZ_OK) {
-            if (res == UNZ_END_OF_LIST_OF_FILE)
-                VPRINT(this, 2, "Hit EOF\n");
-            else
-                VPRINT(this, 2, "Failed to go to next zip subfile\n");
-            at_eof_ = true;
-            return *this;
-        }
-        if (unzOpenCurrentFile(zipfile->file) != UNZ_OK) {
-            VPRINT(this, 1, "Failed to open zip subfile\n");
-            at_eof_ = true;
-            return *this;
+        if (zipfile->read_ahead != nullptr) {
+            if (!zipfile->read_ahead->skip_chunk()) {
+                VPRINT(this, 2, "Hit EOF or failed to skip zip subfile\n");
+                zipfile->read_ahead->resume();
+                at_eof_ = true;
+                return *this;
+            }
+        } else {
+            if (unzCloseCurrentFile(zipfile->file) != UNZ_OK) {
+                VPRINT(this, 1, "Failed to close zip subfile\n");
+                at_eof_ = true;
+                return *this;
+            }
+            int res = unzGoToNextFile(zipfile->file);
+            if (res != UNZ_OK) {
+                if (res == UNZ_END_OF_LIST_OF_FILE)
+                    VPRINT(this, 2, "Hit EOF\n");
+                else
+                    VPRINT(this, 2, "Failed to go to next zip subfile\n");
+                at_eof_ = true;
+                return *this;
+            }
+            if (unzOpenCurrentFile(zipfile->file) != UNZ_OK) {
+                VPRINT(this, 1, "Failed to open zip subfile\n");
+                at_eof_ = true;
+                return *this;
+            }
         }
         cur_instr_count_ += chunk_instr_count_ - (cur_instr_count_ % chunk_instr_count_);
         VPRINT(this, 2, "At %" PRIu64 " instrs at start of new chunk\n",
@@ -238,6 +636,8 @@ file_reader_t<zipfile_reader_t>::skip_instructions(uint64_t instruction_count)
         // Clear cached data from the prior chunk.
         zipfile->cur_buf = zipfile->max_buf;
     }
+    if (zipfile->read_ahead != nullptr)
+        zipfile->read_ahead->resume();
     // Now do a linear walk the rest of the way, remembering timestamps (we have
     // duplicated timestamps at the start of the chunk to cover any skipped in
     // the fast chunk jumps we just did).
@@ -43,6 +43,9 @@
 namespace dynamorio {
 namespace drmemtrace {
 
+// Per-input state for background chunk decompression.
+class zipfile_read_ahead_t;
+
 struct zipfile_reader_t {
     zipfile_reader_t()
         : file(nullptr)
@@ -68,11 +71,27 @@ struct zipfile_reader_t {
     std::string path;
     char name[128];
     int verbosity = 0;
+    // Non-null when chunks are being decompressed ahead of the reader by the
+    // shared read-ahead pool.  In that case cur_buf and max_buf point into a
+    // pooled chunk buffer rather than into buf.  Owned by file_reader_t.
+    zipfile_read_ahead_t *read_ahead = nullptr;
 };
 
 typedef file_reader_t<zipfile_reader_t> zipfile_file_reader_t;
 typedef record_file_reader_t<zipfile_reader_t> zipfile_record_file_reader_t;
 
+/**
+ * Enables decompression of zipfile chunks ahead of their consumption for each
+ * #zipfile_file_reader_t opened after this call.  Up to \p chunks_per_input
+ * chunks of each input are inflated in the background by a shared pool of
+ * \p num_threads threads, with at most \p chunks_per_input * \p num_threads
+ * decompressed chunks held across all inputs.  Each buffer holds an entire
+ * decompressed chunk.  Passing 0 for either value disables read-ahead.  The
+ * thread count is fixed by the first reader opened with read-ahead enabled.
+ */
+void
+set_zipfile_read_ahead(int chunks_per_input, int num_threads);
+
 /* Declare this so the compiler knows not to use the default implementation in the
  * class declaration.
  */
@@ -0,0 +1,165 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "zstd_file_reader.h"
+#include <inttypes.h>
+
+namespace dynamorio {
+namespace drmemtrace {
+
+namespace {
+
+trace_entry_t *
+read_next_entry_common(zstd_reader_t *reader, bool *eof)
+{
+    if (reader->cur_buf >= reader->max_buf) {
+        int len = reader->file
+                      ->read(reinterpret_cast<char *>(&reader->buf), sizeof(reader->buf))
+                      .gcount();
+        if (len < static_cast<int>(sizeof(trace_entry_t)) ||
+            len % static_cast<int>(sizeof(trace_entry_t)) != 0) {
+            *eof = (len >= 0);
+            return nullptr;
+        }
+        reader->cur_buf = reader->buf;
+        reader->max_buf = reader->buf + (len / sizeof(trace_entry_t));
+    }
+    trace_entry_t *res = reader->cur_buf;
+    ++reader->cur_buf;
+    if (res->type == TRACE_TYPE_MARKER && res->size == TRACE_MARKER_TYPE_CHUNK_FOOTER)
+        ++reader->frame_index;
+    return res;
+}
+
+} // namespace
+
+/**************************************************
+ * zstd_reader_t specializations for file_reader_t.
+ */
+
+/* clang-format off */ /* (make vera++ newline-after-type check happy) */
+template <>
+/* clang-format on */
+file_reader_t<zstd_reader_t>::file_reader_t()
+{
+    input_file_.file = nullptr;
+}
+
+/* clang-format off */ /* (make vera++ newline-after-type check happy) */
+template <>
+/* clang-format on */
+file_reader_t<zstd_reader_t>::~file_reader_t()
+{
+    if (input_file_.file != nullptr) {
+        delete input_file_.file;
+        input_file_.file = nullptr;
+    }
+}
+
+template <>
+bool
+file_reader_t<zstd_reader_t>::open_single_file(const std::string &path)
+{
+    auto file = new zstd_istream_t(path);
+    if (!*file) {
+        delete file;
+        return false;
+    }
+    VPRINT(this, 1, "Opened input file %s with %" PRIu64 " seekable frames\n",
+           path.c_str(), file->frame_count());
+    input_file_ = zstd_reader_t(file);
+    return true;
+}
+
+template <>
+trace_entry_t *
+file_reader_t<zstd_reader_t>::read_next_entry()
+{
+    trace_entry_t *entry = read_queued_entry();
+    if (entry != nullptr)
+        return entry;
+    entry = read_next_entry_common(&input_file_, &at_eof_);
+    if (entry == nullptr)
+        return entry;
+    VPRINT(this, 4, "Read from file: type=%s (%d), size=%d, addr=%zu\n",
+           trace_type_names[entry->type], entry->type, entry->size, entry->addr);
+    entry_copy_ = *entry;
+    return &entry_copy_;
+}
+
+template <>
+reader_t &
+file_reader_t<zstd_reader_t>::skip_instructions(uint64_t instruction_count)
+{
+    if (instruction_count == 0)
+        return *this;
+    VPRINT(this, 2, "Skipping %" PRIu64 " instrs in %s\n", instruction_count,
+           input_path_.c_str());
+    if (!pre_skip_instructions())
+        return *this;
+    uint64_t stop_count = cur_instr_count_ + instruction_count + 1;
+    zstd_reader_t *zstd = &input_file_;
+    // Without chunks or a seek table we can only walk linearly.
+    if (chunk_instr_count_ > 0 && zstd->file->frame_count() > 0) {
+        // Find the chunk containing the target just like the zipfile reader
+        // does, but then jump straight to its frame.
+        uint64_t target_frame = zstd->frame_index;
+        while (cur_instr_count_ +
+                   (chunk_instr_count_ - (cur_instr_count_ % chunk_instr_count_)) <
+               stop_count) {
+            cur_instr_count_ +=
+                chunk_instr_count_ - (cur_instr_count_ % chunk_instr_count_);
+            ++target_frame;
+        }
+        if (target_frame != zstd->frame_index) {
+            if (!zstd->file->seek_to_frame(target_frame)) {
+                VPRINT(this, 2, "Hit EOF\n");
+                at_eof_ = true;
+                return *this;
+            }
+            VPRINT(this, 2,
+                   "At %" PRIu64 " instrs at start of frame %" PRIu64 "\n",
+                   cur_instr_count_, target_frame);
+            zstd->frame_index = target_frame;
+            // Clear cached data from the prior frame.
+            zstd->cur_buf = zstd->max_buf;
+        }
+    }
+    // Now do a linear walk the rest of the way, remembering timestamps (we have
+    // duplicated timestamps at the start of the chunk to cover any skipped in
+    // the fast frame jumps we just did).
+    // Subtract 1 to pass the target instr itself.
+    return skip_instructions_with_timestamp(stop_count - 1);
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -42,8 +42,10 @@
 
 #define NOMINMAX // Avoid windows.h messing up std::max.
 #include <assert.h>
+#include <atomic>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <random>
 #include <string>
 #include <unordered_map>
@@ -69,7 +71,8 @@ public:
     static constexpr index_t INVALID_INDEX = (std::numeric_limits<index_t>::max)();
 
     flexible_queue_t(int rand_seed = 0, int verbose = 0)
-        : verbose_(verbose)
+        : size_hint_(new std::atomic<size_t>(0))
+        , verbose_(verbose)
     {
         rand_gen_.seed(rand_seed);
     }
@@ -81,6 +84,7 @@ public:
         entries_.push_back(entry);
         index_t node = entries_.size() - 1;
         entry2index_[entry] = node;
+        update_size_hint();
         percolate_up(node);
         vprint(1, "after push");
         return true;
@@ -129,6 +133,16 @@ public:
         return entries_.size();
     }
 
+    // Returns the size as of the most recent push or erase.  Unlike the other
+    // methods, this may be called without holding whatever lock the owner uses to
+    // protect this queue, which makes it suitable for cheaply skipping empty queues
+    // belonging to other threads.  The result may be stale by the time it is used.
+    size_t
+    size_hint() const
+    {
+        return size_hint_->load(std::memory_order_relaxed);
+    }
+
     bool
     find(T entry)
     {
@@ -148,11 +162,13 @@ public:
         if (node == entries_.size() - 1) {
             entry2index_.erase(entry);
             entries_.pop_back();
+            update_size_hint();
             return true;
         }
         swap(node, entries_.size() - 1);
         entry2index_.erase(entry);
         entries_.pop_back();
+        update_size_hint();
         percolate_down(node);
         percolate_up(node);
         vprint(1, "after erase");
@@ -160,6 +176,12 @@ public:
     }
 
 private:
+    void
+    update_size_hint()
+    {
+        size_hint_->store(entries_.size(), std::memory_order_relaxed);
+    }
+
     void
     vprint(int verbose_threshold, const std::string &message)
     {
@@ -243,6 +265,9 @@ private:
     // means that a is lower priority (worse) than b.
     comparator_t compare_;
     std::unordered_map<T, index_t, hash_t> entry2index_;
+    // A copy of entries_.size() for size_hint().  We use a unique_ptr to keep the
+    // queue moveable for vector storage.
+    std::unique_ptr<std::atomic<size_t>> size_hint_;
     int verbose_ = 0;
     std::minstd_rand rand_gen_;
 };
@@ -32,12 +32,19 @@
 
 #include "scheduler.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <memory>
 #include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
 
+#include "directory_iterator.h"
 #include "scheduler_impl.h"
 #include "trace_entry.h"
+#include "utils.h"
 
 namespace dynamorio {
 namespace drmemtrace {
@@ -99,6 +106,43 @@ scheduler_tmpl_t<RecordType, ReaderType>::get_input_stream_name(
     return impl_->get_input_stream_name(input);
 }
 
+template <typename RecordType, typename ReaderType>
+typename scheduler_tmpl_t<RecordType, ReaderType>::scheduler_status_t
+scheduler_tmpl_t<RecordType, ReaderType>::list_input_files(
+    const std::string &path, std::vector<std::string> &files, std::string &error)
+{
+    files.clear();
+    if (!directory_iterator_t::is_directory(path)) {
+        files.push_back(path);
+        return STATUS_SUCCESS;
+    }
+    directory_iterator_t end;
+    directory_iterator_t iter(path);
+    if (!iter) {
+        error = "Failed to list directory " + path + ": " + iter.error_string();
+        return STATUS_ERROR_FILE_OPEN_FAILED;
+    }
+    for (; iter != end; ++iter) {
+        const std::string fname = *iter;
+        if (fname == "." || fname == ".." ||
+            starts_with(fname, DRMEMTRACE_SERIAL_SCHEDULE_FILENAME) ||
+            fname == DRMEMTRACE_CPU_SCHEDULE_FILENAME ||
+            ends_with(fname, DRMEMTRACE_CHUNK_INDEX_SUFFIX))
+            continue;
+        // Skip the auxiliary files.
+        if (fname == DRMEMTRACE_MODULE_LIST_FILENAME ||
+            fname == DRMEMTRACE_FUNCTION_LIST_FILENAME ||
+            fname == DRMEMTRACE_ENCODING_FILENAME || fname == DRMEMTRACE_V2P_FILENAME)
+            continue;
+        files.push_back(path + DIRSEP + fname);
+    }
+    // Sort so we can have reliable shard ordinals for only_shards.
+    // We assume leading 0's are used for important numbers embedded in the path,
+    // so that a regular sort keeps numeric order.
+    std::sort(files.begin(), files.end());
+    return STATUS_SUCCESS;
+}
+
 template <typename RecordType, typename ReaderType>
 int64_t
 scheduler_tmpl_t<RecordType, ReaderType>::get_output_cpuid(output_ordinal_t output) const
@@ -120,6 +164,13 @@ scheduler_tmpl_t<RecordType, ReaderType>::write_recorded_schedule()
     return impl_->write_recorded_schedule();
 }
 
+template <typename RecordType, typename ReaderType>
+typename scheduler_tmpl_t<RecordType, ReaderType>::scheduler_status_t
+scheduler_tmpl_t<RecordType, ReaderType>::write_checkpoint(std::ostream &out)
+{
+    return impl_->write_checkpoint(out);
+}
+
 template <typename RecordType, typename ReaderType>
 void
 scheduler_tmpl_t<RecordType, ReaderType>::scheduler_impl_deleter_t::operator()(
@@ -143,6 +194,75 @@ template <typename RecordType, typename ReaderType>
 typename scheduler_tmpl_t<RecordType, ReaderType>::stream_status_t
 scheduler_tmpl_t<RecordType, ReaderType>::stream_t::next_record(RecordType &record,
                                                                 uint64_t cur_time)
+{
+    if (batch_has_carried_record_ || batch_pending_status_ != sched_type_t::STATUS_OK) {
+        // Hand back what a prior next_record_batch() call read ahead.
+        size_t count;
+        int shard_index;
+        return next_record_batch(&record, 1, count, shard_index, cur_time);
+    }
+    int input_index;
+    return next_record_from_input(record, cur_time, input_index);
+}
+
+template <typename RecordType, typename ReaderType>
+typename scheduler_tmpl_t<RecordType, ReaderType>::stream_status_t
+scheduler_tmpl_t<RecordType, ReaderType>::stream_t::next_record_batch(
+    RecordType *records, size_t max_count, size_t &count, int &shard_index,
+    uint64_t cur_time)
+{
+    count = 0;
+    if (batch_pending_status_ != sched_type_t::STATUS_OK) {
+        stream_status_t res = batch_pending_status_;
+        batch_pending_status_ = sched_type_t::STATUS_OK;
+        return res;
+    }
+    if (max_count == 0)
+        return sched_type_t::STATUS_INVALID;
+    // A round-robin stream changes outputs on every record, and a combined stream
+    // can change shards on every record.
+    if (max_ordinal_ > 0 ||
+        (scheduler_->inputs_.size() == 1 && scheduler_->inputs_[0].is_combined_stream()))
+        max_count = 1;
+    int batch_input = -1;
+    if (batch_has_carried_record_) {
+        records[count++] = batch_carried_record_;
+        batch_has_carried_record_ = false;
+        batch_input = batch_carried_input_;
+        shard_index = batch_carried_shard_;
+        if (scheduler_->record_type_is_thread_exit(records[0]))
+            return sched_type_t::STATUS_OK;
+    }
+    while (count < max_count) {
+        int input_index;
+        stream_status_t res =
+            next_record_from_input(records[count], cur_time, input_index);
+        if (res != sched_type_t::STATUS_OK) {
+            if (count == 0)
+                return res;
+            batch_pending_status_ = res;
+            break;
+        }
+        if (count == 0) {
+            batch_input = input_index;
+            shard_index = get_shard_index();
+        } else if (input_index != batch_input) {
+            batch_carried_record_ = records[count];
+            batch_carried_input_ = input_index;
+            batch_carried_shard_ = get_shard_index();
+            batch_has_carried_record_ = true;
+            break;
+        }
+        if (scheduler_->record_type_is_thread_exit(records[count++]))
+            break;
+    }
+    return sched_type_t::STATUS_OK;
+}
+
+template <typename RecordType, typename ReaderType>
+typename scheduler_tmpl_t<RecordType, ReaderType>::stream_status_t
+scheduler_tmpl_t<RecordType, ReaderType>::stream_t::next_record_from_input(
+    RecordType &record, uint64_t cur_time, int &input_index)
 {
     if (max_ordinal_ > 0) {
         ++ordinal_;
@@ -154,13 +274,18 @@ scheduler_tmpl_t<RecordType, ReaderType>::stream_t::next_record(RecordType &reco
         scheduler_->next_record(ordinal_, record, input, cur_time);
     if (res != sched_type_t::STATUS_OK)
         return res;
+    input_index = input->index;
 
     // Update our memtrace_stream_t state.
     std::lock_guard<mutex_dbg_owned> guard(*input->lock);
     if (!input->reader->is_record_synthetic())
         ++cur_ref_count_;
-    if (scheduler_->record_type_is_instr_boundary(record, prev_record_))
+    if (scheduler_->record_type_is_instr_boundary(record, prev_record_)) {
         ++cur_instr_count_;
+        if (scheduler_->options_.stop_after_instrs > 0) {
+            scheduler_->stop_instr_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
     VPRINT(scheduler_, 5,
            "stream record#=%" PRId64 ", instr#=%" PRId64 " (cur input %" PRId64
            " record#=%" PRId64 ", instr#=%" PRId64 ")\n",
@@ -47,10 +47,12 @@
 
 #include <atomic>
 #include <deque>
+#include <istream>
 #include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <ostream>
 #include <queue>
 #include <set>
 #include <stack>
@@ -630,6 +632,33 @@ public:
         SWITCH_PROCESS,
     };
 
+    /**
+     * Describes where one output sits in the cache and memory hierarchy of the
+     * simulated machine, for
+     * #dynamorio::drmemtrace::scheduler_tmpl_t::scheduler_options_t::output_topology.
+     * Each identifier is an arbitrary non-negative value: outputs with equal values
+     * share that level of the hierarchy.
+     */
+    struct output_topology_t {
+        /** Constructs an entry with every identifier unset. */
+        output_topology_t()
+        {
+        }
+        /** Convenience constructor. */
+        output_topology_t(int core, int llc, int node)
+            : core(core)
+            , llc(llc)
+            , node(node)
+        {
+        }
+        /** The physical core: outputs on the same core are SMT siblings. */
+        int core = -1;
+        /** The last-level cache domain.  All outputs on one core must share it. */
+        int llc = -1;
+        /** The socket or NUMA node.  All outputs in one LLC domain must share it. */
+        int node = -1;
+    };
+
     /**
      * Collects the parameters specifying how the scheduler should behave, outside
      * of the workload inputs and the output count.
@@ -908,6 +937,63 @@ public:
         std::unique_ptr<ReaderType> kernel_syscall_reader;
         /** The end reader for #kernel_syscall_reader. */
         std::unique_ptr<ReaderType> kernel_syscall_reader_end;
+        /**
+         * If non-zero, for #MAP_TO_ANY_OUTPUT, once the outputs have collectively
+         * returned this many instructions the scheduler exits (sets all outputs to
+         * EOF) while leaving the rest of the schedule in place, so that
+         * write_checkpoint() can capture it.  The count includes the instructions
+         * returned prior to a checkpoint passed in #checkpoint_istream.  As outputs
+         * only observe the limit at their next record, each output may return one
+         * more instruction than the limit when outputs are run in parallel.
+         */
+        uint64_t stop_after_instrs = 0;
+        /**
+         * If non-nullptr, for #MAP_TO_ANY_OUTPUT, the schedule resumes from the
+         * checkpoint previously written to this stream by write_checkpoint() rather
+         * than starting from the beginning of each input.  The same inputs, output
+         * count, and options (other than this field and #stop_after_instrs) must be
+         * re-specified.  Each input reader uses its skip_instructions() support to
+         * seek directly to its checkpointed position.  Not supported together with
+         * #schedule_record_ostream.
+         */
+        std::istream *checkpoint_istream = nullptr;
+        /**
+         * For #MAP_TO_ANY_OUTPUT, moves load between outputs primarily by work
+         * stealing rather than by periodic global rebalancing.  An output with an
+         * empty ready queue tries to steal on every idle step (rather than only on
+         * its first), choosing victims via a lock-free queue size hint and only
+         * try-locking their queues so that it never waits on another output.
+         * Inputs are stolen from the back of the victim's queue, leaving its
+         * highest-priority inputs in place.  The periodic rebalancing controlled by
+         * #rebalance_period_us is disabled; rebalancing still occurs when outputs
+         * are marked active or inactive.  This reduces lock contention with large
+         * output counts.
+         */
+        bool work_stealing = false;
+        /**
+         * For #MAP_TO_ANY_OUTPUT, if non-empty, this must hold one entry per output
+         * describing where that output sits in the simulated machine (see
+         * make_output_topology() for a convenient way to construct a regular one).
+         * When stealing from or rebalancing run queues, the scheduler then prefers to
+         * keep inputs close to the output they last ran on: on the same core first,
+         * then in the same last-level cache domain, then on the same node.  When
+         * empty, every output is treated as a separate core with one shared cache
+         * and node.  Either way, migrations of inputs between outputs in different
+         * domains are counted in the #memtrace_stream_t statistics
+         * #memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_CORE,
+         * #memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_LLC, and
+         * #memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_NODE.
+         */
+        std::vector<output_topology_t> output_topology;
+        /**
+         * Asserts that the user of the scheduler never examines the addresses of
+         * data references, letting input formats that store them separately avoid
+         * decoding them.  Data references from such inputs then have an address of
+         * 0.  Currently only the columnar trace format (".col" files) honors this.
+         * The drmemtrace analyzer sets this when every tool returns false from
+         * #dynamorio::drmemtrace::analysis_tool_tmpl_t::data_addresses_needed().
+         */
+        bool skip_data_addresses = false;
         // When adding new options, also add to print_configuration().
     };
 
@@ -936,6 +1022,30 @@ public:
             sched_type_t::MAP_TO_RECORDED_OUTPUT, sched_type_t::DEPENDENCY_TIMESTAMPS,
             sched_type_t::SCHEDULER_USE_SINGLE_INPUT_ORDINALS, verbosity);
     }
+    /**
+     * Constructs a value for scheduler_options_t::output_topology describing a
+     * regular machine with the given number of nodes, last-level cache domains per
+     * node, cores per cache domain, and SMT threads per core.  Outputs are numbered
+     * consecutively within each level: e.g., outputs 0 and 1 are the SMT siblings
+     * of the first core when there are two threads per core.  Returns an empty
+     * vector if any count is not positive.
+     */
+    static std::vector<output_topology_t>
+    make_output_topology(int nodes, int llcs_per_node, int cores_per_llc,
+                         int threads_per_core)
+    {
+        std::vector<output_topology_t> topology;
+        if (nodes <= 0 || llcs_per_node <= 0 || cores_per_llc <= 0 ||
+            threads_per_core <= 0)
+            return topology;
+        int num_cores = nodes * llcs_per_node * cores_per_llc;
+        for (int core = 0; core < num_cores; ++core) {
+            int llc = core / cores_per_llc;
+            for (int thread = 0; thread < threads_per_core; ++thread)
+                topology.emplace_back(core, llc, llc / llcs_per_node);
+        }
+        return topology;
+    }
 
     /**
      * Represents a stream of RecordType trace records derived from a
@@ -985,6 +1095,30 @@ public:
         virtual stream_status_t
         next_record(RecordType &record, uint64_t cur_time);
 
+        /**
+         * Advances through up to "max_count" records in the stream, storing them in
+         * "records" and their count in "count", with the same status codes and
+         * "cur_time" semantics as next_record().  A batch never spans two inputs or
+         * shards: it ends early when the input changes (such as at a quantum
+         * boundary) and just after a thread exit record.  The shard the records
+         * belong to is stored in "shard_index" (see get_shard_index()).  A
+         * non-#STATUS_OK status encountered after at least one record is held back
+         * and returned by the next call, so a batch with a non-zero count always
+         * returns #STATUS_OK.  A single combined-stream input, whose shards change
+         * with each record's thread, is delivered one record per batch.
+         *
+         * Queries on this stream made after this call reflect the state after the
+         * final record in the batch, except that when the batch ended because the
+         * input changed, the first record of the new input has already been read and
+         * is reflected (that record is returned at the start of the next batch).
+         * Each record is read as it would be by next_record(), so this saves the
+         * caller per-record overhead rather than scheduler work.  It may not be
+         * mixed with unread_last_record() or speculation.
+         */
+        virtual stream_status_t
+        next_record_batch(RecordType *records, size_t max_count, size_t &count,
+                          int &shard_index, uint64_t cur_time);
+
         /**
          * Queues the last-read record returned by next_record() such that it will be
          * returned on the subsequent call to next_record() when this same input is
@@ -1279,6 +1413,10 @@ public:
         get_schedule_statistic(schedule_statistic_t stat) const override;
 
     protected:
+        // Implements next_record(), also returning the index of the record's input.
+        stream_status_t
+        next_record_from_input(RecordType &record, uint64_t cur_time, int &input_index);
+
         scheduler_impl_tmpl_t<RecordType, ReaderType> *scheduler_ = nullptr;
         int ordinal_ = -1;
         // If max_ordinal_ >= 0, ordinal_ is incremented modulo max_ordinal_ at the start
@@ -1297,6 +1435,13 @@ public:
         uint64_t chunk_instr_count_ = 0;
         uint64_t page_size_ = 0;
         RecordType prev_record_ = {};
+        // State carried across next_record_batch() calls: a record from a new input
+        // that ended the prior batch, or a status held back from it.
+        RecordType batch_carried_record_ = {};
+        int batch_carried_input_ = -1;
+        int batch_carried_shard_ = -1;
+        bool batch_has_carried_record_ = false;
+        stream_status_t batch_pending_status_ = STATUS_OK;
 
         // Let the impl class update our state.
         friend class scheduler_impl_tmpl_t<RecordType, ReaderType>;
@@ -1338,6 +1483,17 @@ public:
     std::string
     get_input_stream_name(input_ordinal_t input) const;
 
+    /**
+     * Lists into \p files the paths of the trace files opened as inputs for the
+     * workload path \p path, in the order whose indices are used by
+     * #dynamorio::drmemtrace::scheduler_tmpl_t::input_workload_t::only_shards.
+     * A \p path that is not a directory is its own single input.  On failure,
+     * returns an error code and places a description in \p error.
+     */
+    static scheduler_status_t
+    list_input_files(const std::string &path, std::vector<std::string> &files,
+                     std::string &error);
+
     /**
      * Returns the get_output_cpuid() value for the given output.
      * This interface is exported so that a user can get the cpuids at initialization
@@ -1360,6 +1516,21 @@ public:
     scheduler_status_t
     write_recorded_schedule();
 
+    /**
+     * Writes the complete scheduling state (the position of each input, the ready
+     * queues, blocked and quantum times, the input-to-output assignments, and each
+     * output stream's ordinals and statistics) to 'out' for a later resumption via
+     * #dynamorio::drmemtrace::scheduler_tmpl_t::
+     * scheduler_options_t::checkpoint_istream.
+     * Only supported for #MAP_TO_ANY_OUTPUT.  No output stream may be in the middle
+     * of a next_record() call or in a speculation window; the typical usage is to
+     * call this once all outputs have reached EOF due to
+     * #dynamorio::drmemtrace::scheduler_tmpl_t::
+     * scheduler_options_t::stop_after_instrs.
+     */
+    scheduler_status_t
+    write_checkpoint(std::ostream &out);
+
 protected:
     typedef scheduler_tmpl_t<RecordType, ReaderType> sched_type_t;
     // We use the "pImpl" idiom to allow us to create the appropriate subclass
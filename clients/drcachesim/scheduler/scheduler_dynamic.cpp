@@ -40,9 +40,12 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <istream>
 #include <limits>
 #include <mutex>
+#include <ostream>
 #include <sstream>
+#include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -233,6 +236,52 @@ scheduler_dynamic_tmpl_t<RecordType, ReaderType>::set_output_active(
     return rebalance_queues(output, ordinals);
 }
 
+template <typename RecordType, typename ReaderType>
+bool
+scheduler_dynamic_tmpl_t<RecordType, ReaderType>::write_checkpoint_for_mode(
+    std::ostream &out)
+{
+    std::lock_guard<mutex_dbg_owned> unsched_lock(*unscheduled_priority_.lock);
+    std::vector<input_info_t *> unscheduled;
+    while (!unscheduled_priority_.queue.empty()) {
+        unscheduled.push_back(unscheduled_priority_.queue.top());
+        unscheduled_priority_.queue.pop();
+    }
+    out << "dynamic " << last_rebalance_time_.load(std::memory_order_acquire) << ' '
+        << unscheduled_priority_.fifo_counter << ' ' << unscheduled.size();
+    // Re-add without changing their counters so we preserve the FIFO order.
+    for (input_info_t *input : unscheduled) {
+        out << ' ' << input->index;
+        unscheduled_priority_.queue.push(input);
+    }
+    out << '\n';
+    return true;
+}
+
+template <typename RecordType, typename ReaderType>
+bool
+scheduler_dynamic_tmpl_t<RecordType, ReaderType>::read_checkpoint_for_mode(
+    std::istream &in)
+{
+    std::string tag;
+    uint64_t last_rebalance_time = 0;
+    size_t count = 0;
+    in >> tag >> last_rebalance_time >> unscheduled_priority_.fifo_counter >> count;
+    if (in.fail() || tag != "dynamic")
+        return false;
+    last_rebalance_time_.store(last_rebalance_time, std::memory_order_release);
+    std::lock_guard<mutex_dbg_owned> unsched_lock(*unscheduled_priority_.lock);
+    for (size_t i = 0; i < count; ++i) {
+        input_ordinal_t index = sched_type_t::INVALID_INPUT_ORDINAL;
+        in >> index;
+        if (in.fail() || index < 0 ||
+            index >= static_cast<input_ordinal_t>(inputs_.size()))
+            return false;
+        unscheduled_priority_.queue.push(&inputs_[index]);
+    }
+    return true;
+}
+
 template <typename RecordType, typename ReaderType>
 typename scheduler_tmpl_t<RecordType, ReaderType>::stream_status_t
 scheduler_dynamic_tmpl_t<RecordType, ReaderType>::pick_next_input_for_mode(
@@ -260,7 +309,8 @@ scheduler_dynamic_tmpl_t<RecordType, ReaderType>::pick_next_input_for_mode(
         last_rebalance_time_.store(cur_time, std::memory_order_release);
     } else {
         // Guard against time going backward, which happens: i#6966.
-        if (cur_time > last_time &&
+        // With work stealing, idle outputs pull work themselves instead.
+        if (!options_.work_stealing && cur_time > last_time &&
             cur_time - last_time >= static_cast<uint64_t>(options_.rebalance_period_us *
                                                           options_.time_units_per_us) &&
             rebalancer_.load(std::memory_order_acquire) == std::thread::id()) {
@@ -899,8 +949,7 @@ scheduler_dynamic_tmpl_t<RecordType, ReaderType>::rebalance_queues(
             while (
                 (outputs_[i].ready_queue.queue.size() < avg_ceiling || iteration > 1) &&
                 !inputs_to_add.empty()) {
-                input_ordinal_t ordinal = inputs_to_add.back();
-                inputs_to_add.pop_back();
+                input_ordinal_t ordinal = take_nearest_input(i, inputs_to_add);
                 input_info_t &input = inputs_[ordinal];
                 std::lock_guard<mutex_dbg_owned> input_lock(*input.lock);
                 if (input.binding.empty() ||
@@ -933,6 +982,38 @@ scheduler_dynamic_tmpl_t<RecordType, ReaderType>::rebalance_queues(
     return status;
 }
 
+template <typename RecordType, typename ReaderType>
+typename scheduler_tmpl_t<RecordType, ReaderType>::input_ordinal_t
+scheduler_dynamic_tmpl_t<RecordType, ReaderType>::take_nearest_input(
+    output_ordinal_t output, std::vector<input_ordinal_t> &candidates)
+{
+    assert(!candidates.empty());
+    size_t best = candidates.size() - 1;
+    if (!options_.output_topology.empty()) {
+        // Prefer an input that last ran close to "output".  Without a topology
+        // every other output is equally close so we skip the search.  Reading
+        // last_run_output without the input's lock is fine for a heuristic.
+        auto distance = [&](input_ordinal_t ordinal) {
+            output_ordinal_t last_run = inputs_[ordinal].last_run_output;
+            return last_run == sched_type_t::INVALID_OUTPUT_ORDINAL
+                ? this->TOPOLOGY_CROSS_NODE
+                : topology_distance(output, last_run);
+        };
+        auto best_distance = distance(candidates[best]);
+        for (size_t i = candidates.size() - 1;
+             i > 0 && best_distance > this->TOPOLOGY_SAME_OUTPUT; --i) {
+            auto cand_distance = distance(candidates[i - 1]);
+            if (cand_distance < best_distance) {
+                best = i - 1;
+                best_distance = cand_distance;
+            }
+        }
+    }
+    input_ordinal_t res = candidates[best];
+    candidates.erase(candidates.begin() + best);
+    return res;
+}
+
 template <typename RecordType, typename ReaderType>
 typename scheduler_tmpl_t<RecordType, ReaderType>::stream_status_t
 scheduler_dynamic_tmpl_t<RecordType, ReaderType>::eof_or_idle_for_mode(
@@ -949,13 +1030,28 @@ scheduler_dynamic_tmpl_t<RecordType, ReaderType>::eof_or_idle_for_mode(
         return sched_type_t::STATUS_EOF;
     }
     //  Before going idle, try to steal work from another output.
-    //  We start with us+1 to avoid everyone stealing from the low-numbered outputs.
-    //  We only try when we first transition to idle; we rely on rebalancing after
-    //  that, to avoid repeatededly grabbing other output's locks over and over.
-    if (!outputs_[output].tried_to_steal_on_idle) {
+    //  steal_victim() starts with the outputs nearest us in the topology, and with
+    //  us+1 within each distance to avoid everyone stealing from the low-numbered
+    //  outputs.
+    //  Without work stealing we only try when we first transition to idle; we rely
+    //  on rebalancing after that, to avoid repeatededly grabbing other output's
+    //  locks over and over.  With work stealing we try every time, as we never
+    //  wait on those locks.
+    if (options_.work_stealing) {
+        input_info_t *queue_next = nullptr;
+        output_ordinal_t target = sched_type_t::INVALID_OUTPUT_ORDINAL;
+        if (steal_from_ready_queues(output, target, queue_next)) {
+            set_cur_input(output, queue_next->index);
+            ++outputs_[output].stats[memtrace_stream_t::SCHED_STAT_RUNQUEUE_STEALS];
+            VPRINT(this, 2,
+                   "eof_or_idle: output %d stole input %d from %d's ready_queue\n",
+                   output, queue_next->index, target);
+            return sched_type_t::STATUS_STOLE;
+        }
+    } else if (!outputs_[output].tried_to_steal_on_idle) {
         outputs_[output].tried_to_steal_on_idle = true;
         for (unsigned int i = 1; i < outputs_.size(); ++i) {
-            output_ordinal_t target = (output + i) % outputs_.size();
+            output_ordinal_t target = steal_victim(output, i);
             assert(target != output); // Sanity check (we won't reach "output").
             input_info_t *queue_next = nullptr;
             VPRINT(this, 4,
@@ -977,6 +1073,52 @@ scheduler_dynamic_tmpl_t<RecordType, ReaderType>::eof_or_idle_for_mode(
     return sched_type_t::STATUS_IDLE;
 }
 
+template <typename RecordType, typename ReaderType>
+bool
+scheduler_dynamic_tmpl_t<RecordType, ReaderType>::steal_from_ready_queues(
+    output_ordinal_t output, output_ordinal_t &victim, input_info_t *&stolen)
+{
+    for (unsigned int i = 1; i < outputs_.size(); ++i) {
+        output_ordinal_t target = steal_victim(output, i);
+        // We read the size without the lock: a stale value only costs us a wasted
+        // attempt now or a missed one that we will make on our next idle step.
+        if (outputs_[target].ready_queue.queue.size_hint() == 0)
+            continue;
+        std::unique_lock<mutex_dbg_owned> target_lock;
+        std::unique_lock<mutex_dbg_owned> our_lock;
+        if (this->need_output_lock()) {
+            // Since we never wait, we can ignore the usual increasing-ordinal
+            // ordering of output locks without risking deadlock.
+            target_lock = std::unique_lock<mutex_dbg_owned>(
+                *outputs_[target].ready_queue.lock, std::try_to_lock);
+            if (!target_lock.owns_lock())
+                continue;
+            our_lock = std::unique_lock<mutex_dbg_owned>(
+                *outputs_[output].ready_queue.lock, std::try_to_lock);
+            if (!our_lock.owns_lock())
+                continue;
+        }
+        VPRINT(this, 4, "eof_or_idle: output %d trying to steal from %d's ready_queue\n",
+               output, target);
+        // We take from the back, leaving the victim its highest-priority inputs.
+        // A victim holding only blocked inputs counts an idle for us, but as we may
+        // try many victims on every idle step we undo that to keep our idle-based
+        // time from advancing any faster than without stealing.
+        input_info_t *queue_next = nullptr;
+        uint64_t prior_idle_count = outputs_[output].idle_count;
+        stream_status_t status = pop_from_ready_queue_hold_locks(
+            target, output, queue_next, /*from_back=*/true);
+        outputs_[output].idle_count = prior_idle_count;
+        if (status == sched_type_t::STATUS_OK && queue_next != nullptr) {
+            victim = target;
+            stolen = queue_next;
+            return true;
+        }
+    }
+    VPRINT(this, 4, "eof_or_idle: output %d failed to steal from anyone\n", output);
+    return false;
+}
+
 template <typename RecordType, typename ReaderType>
 bool
 scheduler_dynamic_tmpl_t<RecordType, ReaderType>::syscall_incurs_switch(
@@ -44,6 +44,7 @@
 #include <cstddef>
 #include <cstdio>
 #include <iomanip>
+#include <istream>
 #include <limits>
 #include <map>
 #include <memory>
@@ -63,9 +64,14 @@
 #include "reader.h"
 #include "record_file_reader.h"
 #include "trace_entry.h"
+#include "trace_index.h"
 #ifdef HAS_LZ4
 #    include "lz4_file_reader.h"
 #endif
+#ifdef HAS_ZSTD
+#    include "columnar_file_reader.h"
+#    include "zstd_file_reader.h"
+#endif
 #ifdef HAS_ZLIB
 #    include "compressed_file_reader.h"
 #endif
@@ -77,6 +83,9 @@
 #ifdef HAS_SNAPPY
 #    include "snappy_file_reader.h"
 #endif
+#ifdef UNIX
+#    include "mmap_file_reader.h"
+#endif
 #include "directory_iterator.h"
 #include "utils.h"
 
@@ -129,12 +138,25 @@ std::unique_ptr<reader_t>
 scheduler_impl_tmpl_t<memref_t, reader_t>::get_reader(const std::string &path,
                                                       int verbosity)
 {
-#if defined(HAS_SNAPPY) || defined(HAS_ZIP) || defined(HAS_LZ4)
+#ifdef UNIX
+    // Uncompressed files are mapped rather than read through a stream.
+    if (ends_with(path, ".trace"))
+        return std::unique_ptr<reader_t>(new mmap_file_reader_t(path, verbosity));
+#endif
+#if defined(HAS_SNAPPY) || defined(HAS_ZIP) || defined(HAS_LZ4) || defined(HAS_ZSTD)
 #    ifdef HAS_LZ4
     if (ends_with(path, ".lz4")) {
         return std::unique_ptr<reader_t>(new lz4_file_reader_t(path, verbosity));
     }
 #    endif
+#    ifdef HAS_ZSTD
+    if (ends_with(path, ".zst"))
+        return std::unique_ptr<reader_t>(new zstd_file_reader_t(path, verbosity));
+    if (ends_with(path, ".col")) {
+        return std::unique_ptr<reader_t>(new columnar_file_reader_t(
+            path, verbosity, options_.skip_data_addresses));
+    }
+#    endif
 #    ifdef HAS_SNAPPY
     if (ends_with(path, ".sz"))
         return std::unique_ptr<reader_t>(new snappy_file_reader_t(path, verbosity));
@@ -156,7 +178,8 @@ scheduler_impl_tmpl_t<memref_t, reader_t>::get_reader(const std::string &path,
             const std::string fname = *iter;
             if (fname == "." || fname == ".." ||
                 starts_with(fname, DRMEMTRACE_SERIAL_SCHEDULE_FILENAME) ||
-                fname == DRMEMTRACE_CPU_SCHEDULE_FILENAME)
+                fname == DRMEMTRACE_CPU_SCHEDULE_FILENAME ||
+                ends_with(fname, DRMEMTRACE_CHUNK_INDEX_SUFFIX))
                 continue;
             // Skip the auxiliary files.
             if (fname == DRMEMTRACE_MODULE_LIST_FILENAME ||
@@ -179,6 +202,12 @@ scheduler_impl_tmpl_t<memref_t, reader_t>::get_reader(const std::string &path,
             if (ends_with(path, ".lz4")) {
                 return std::unique_ptr<reader_t>(new lz4_file_reader_t(path, verbosity));
             }
+#    endif
+#    ifdef HAS_ZSTD
+            if (ends_with(*iter, ".zst")) {
+                return std::unique_ptr<reader_t>(
+                    new zstd_file_reader_t(path, verbosity));
+            }
 #    endif
         }
     }
@@ -430,6 +459,12 @@ scheduler_impl_tmpl_t<trace_entry_t, record_reader_t>::get_reader(const std::str
     // TODO i#5675: Add support for other file formats.
     if (ends_with(path, ".sz"))
         return nullptr;
+#ifdef UNIX
+    if (ends_with(path, ".trace")) {
+        return std::unique_ptr<dynamorio::drmemtrace::record_reader_t>(
+            new mmap_record_file_reader_t(path, verbosity));
+    }
+#endif
 #ifdef HAS_ZIP
     if (ends_with(path, ".zip")) {
         return std::unique_ptr<dynamorio::drmemtrace::record_reader_t>(
@@ -752,6 +787,15 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::print_configuration()
            options_.kernel_syscall_reader.get());
     VPRINT(this, 1, "  %-25s : %p\n", "kernel_syscall_reader_end",
            options_.kernel_syscall_reader_end.get());
+    VPRINT(this, 1, "  %-25s : %" PRIu64 "\n", "stop_after_instrs",
+           options_.stop_after_instrs);
+    VPRINT(this, 1, "  %-25s : %p\n", "checkpoint_istream",
+           options_.checkpoint_istream);
+    VPRINT(this, 1, "  %-25s : %d\n", "work_stealing", options_.work_stealing);
+    VPRINT(this, 1, "  %-25s : %zu entries\n", "output_topology",
+           options_.output_topology.size());
+    VPRINT(this, 1, "  %-25s : %d\n", "skip_data_addresses",
+           options_.skip_data_addresses);
 }
 
 template <typename RecordType, typename ReaderType>
@@ -775,6 +819,12 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::~scheduler_impl_tmpl_t()
                outputs_[i].stats[memtrace_stream_t::SCHED_STAT_DIRECT_SWITCH_SUCCESSES]);
         VPRINT(this, 1, "  %-35s: %9" PRId64 "\n", "Migrations",
                outputs_[i].stats[memtrace_stream_t::SCHED_STAT_MIGRATIONS]);
+        VPRINT(this, 1, "  %-35s: %9" PRId64 "\n", "Cross-core migrations",
+               outputs_[i].stats[memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_CORE]);
+        VPRINT(this, 1, "  %-35s: %9" PRId64 "\n", "Cross-LLC migrations",
+               outputs_[i].stats[memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_LLC]);
+        VPRINT(this, 1, "  %-35s: %9" PRId64 "\n", "Cross-node migrations",
+               outputs_[i].stats[memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_NODE]);
         VPRINT(this, 1, "  %-35s: %9" PRId64 "\n", "Runqueue steals",
                outputs_[i].stats[memtrace_stream_t::SCHED_STAT_RUNQUEUE_STEALS]);
         VPRINT(this, 1, "  %-35s: %9" PRId64 "\n", "Runqueue rebalances",
@@ -980,6 +1030,17 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::init(
     if (res != sched_type_t::STATUS_SUCCESS)
         return res;
 
+    if ((options_.stop_after_instrs > 0 || options_.checkpoint_istream != nullptr) &&
+        options_.mapping != sched_type_t::MAP_TO_ANY_OUTPUT) {
+        error_string_ = "Checkpoints are only supported for MAP_TO_ANY_OUTPUT";
+        return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+    }
+    if (options_.checkpoint_istream != nullptr &&
+        options_.schedule_record_ostream != nullptr) {
+        error_string_ = "Cannot record a schedule when resuming from a checkpoint";
+        return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+    }
+
     if (TESTANY(sched_type_t::SCHEDULER_USE_SINGLE_INPUT_ORDINALS, options_.flags) &&
         inputs_.size() == 1 && output_count == 1) {
         options_.flags = static_cast<scheduler_flags_t>(
@@ -1018,6 +1079,10 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::init(
         }
     }
 
+    res = init_output_topology();
+    if (res != sched_type_t::STATUS_SUCCESS)
+        return res;
+
     VDO(this, 1, { print_configuration(); });
 
     live_input_count_.store(static_cast<int>(inputs_.size()), std::memory_order_release);
@@ -1059,9 +1124,90 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::init(
         }
     }
 
+    if (options_.checkpoint_istream != nullptr)
+        return read_checkpoint(*options_.checkpoint_istream);
     return set_initial_schedule();
 }
 
+template <typename RecordType, typename ReaderType>
+typename scheduler_tmpl_t<RecordType, ReaderType>::scheduler_status_t
+scheduler_impl_tmpl_t<RecordType, ReaderType>::init_output_topology()
+{
+    const std::vector<output_topology_t> &topology = options_.output_topology;
+    if (topology.empty()) {
+        for (unsigned int i = 0; i < outputs_.size(); ++i)
+            outputs_[i].topology = output_topology_t(static_cast<int>(i), 0, 0);
+        return sched_type_t::STATUS_SUCCESS;
+    }
+    if (options_.mapping != sched_type_t::MAP_TO_ANY_OUTPUT) {
+        error_string_ = "output_topology is only supported for MAP_TO_ANY_OUTPUT";
+        return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+    }
+    if (topology.size() != outputs_.size()) {
+        error_string_ = "output_topology must have one entry per output";
+        return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+    }
+    // Each level must nest inside the next.
+    std::unordered_map<int, int> core2llc;
+    std::unordered_map<int, int> llc2node;
+    for (const output_topology_t &entry : topology) {
+        if (entry.core < 0 || entry.llc < 0 || entry.node < 0) {
+            error_string_ = "output_topology identifiers must be non-negative";
+            return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+        }
+        auto core_it = core2llc.emplace(entry.core, entry.llc).first;
+        auto llc_it = llc2node.emplace(entry.llc, entry.node).first;
+        if (core_it->second != entry.llc || llc_it->second != entry.node) {
+            error_string_ = "output_topology cores must each lie within one LLC "
+                            "domain and LLC domains within one node";
+            return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+        }
+    }
+    for (unsigned int i = 0; i < outputs_.size(); ++i)
+        outputs_[i].topology = topology[i];
+    for (unsigned int i = 0; i < outputs_.size(); ++i) {
+        std::vector<output_ordinal_t> &order = outputs_[i].steal_order;
+        order.reserve(outputs_.size() - 1);
+        for (unsigned int j = 1; j < outputs_.size(); ++j)
+            order.push_back(static_cast<output_ordinal_t>((i + j) % outputs_.size()));
+        // A stable sort preserves the rotation within each distance.
+        std::stable_sort(order.begin(), order.end(),
+                         [this, i](output_ordinal_t a, output_ordinal_t b) {
+                             return topology_distance(i, a) < topology_distance(i, b);
+                         });
+    }
+    return sched_type_t::STATUS_SUCCESS;
+}
+
+template <typename RecordType, typename ReaderType>
+typename scheduler_impl_tmpl_t<RecordType, ReaderType>::topology_distance_t
+scheduler_impl_tmpl_t<RecordType, ReaderType>::topology_distance(
+    output_ordinal_t a, output_ordinal_t b) const
+{
+    if (a == b)
+        return TOPOLOGY_SAME_OUTPUT;
+    const output_topology_t &topo_a = outputs_[a].topology;
+    const output_topology_t &topo_b = outputs_[b].topology;
+    if (topo_a.core == topo_b.core)
+        return TOPOLOGY_SAME_CORE;
+    if (topo_a.llc == topo_b.llc)
+        return TOPOLOGY_SAME_LLC;
+    if (topo_a.node == topo_b.node)
+        return TOPOLOGY_SAME_NODE;
+    return TOPOLOGY_CROSS_NODE;
+}
+
+template <typename RecordType, typename ReaderType>
+typename scheduler_tmpl_t<RecordType, ReaderType>::output_ordinal_t
+scheduler_impl_tmpl_t<RecordType, ReaderType>::steal_victim(output_ordinal_t output,
+                                                            unsigned int i) const
+{
+    assert(i >= 1 && i < outputs_.size());
+    if (outputs_[output].steal_order.empty())
+        return static_cast<output_ordinal_t>((output + i) % outputs_.size());
+    return outputs_[output].steal_order[i - 1];
+}
+
 template <typename RecordType, typename ReaderType>
 typename scheduler_tmpl_t<RecordType, ReaderType>::scheduler_status_t
 scheduler_impl_tmpl_t<RecordType, ReaderType>::legacy_field_support()
@@ -1167,39 +1313,453 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::write_recorded_schedule()
     return sched_type_t::STATUS_SUCCESS;
 }
 
+namespace {
+
+// The checkpoint is a whitespace-separated sequence of values, with each record
+// (whose layout is fixed for a given build) as a hex string of its bytes.
+static constexpr char CHECKPOINT_MAGIC[] = "drmemtrace_scheduler_checkpoint";
+static constexpr int CHECKPOINT_VERSION = 1;
+
+template <typename RecordType> class checkpoint_writer_t {
+public:
+    explicit checkpoint_writer_t(std::ostream &out)
+        : out_(out)
+    {
+    }
+    template <typename T>
+    void
+    operator()(T &value)
+    {
+        out_ << ' ' << value;
+    }
+    void
+    operator()(RecordType &record)
+    {
+        static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&record);
+        out_ << ' ';
+        for (size_t i = 0; i < sizeof(record); ++i)
+            out_ << HEX_DIGITS[bytes[i] >> 4] << HEX_DIGITS[bytes[i] & 0xf];
+    }
+
+private:
+    std::ostream &out_;
+};
+
+template <typename RecordType> class checkpoint_reader_t {
+public:
+    explicit checkpoint_reader_t(std::istream &in)
+        : in_(in)
+    {
+    }
+    template <typename T>
+    void
+    operator()(T &value)
+    {
+        in_ >> value;
+    }
+    void
+    operator()(RecordType &record)
+    {
+        std::string hex;
+        in_ >> hex;
+        if (hex.size() != 2 * sizeof(record)) {
+            in_.setstate(std::ios::failbit);
+            return;
+        }
+        unsigned char *bytes = reinterpret_cast<unsigned char *>(&record);
+        for (size_t i = 0; i < sizeof(record); ++i) {
+            int high = hex_value(hex[2 * i]);
+            int low = hex_value(hex[2 * i + 1]);
+            if (high < 0 || low < 0) {
+                in_.setstate(std::ios::failbit);
+                return;
+            }
+            bytes[i] = static_cast<unsigned char>((high << 4) | low);
+        }
+    }
+
+private:
+    static int
+    hex_value(char digit)
+    {
+        if (digit >= '0' && digit <= '9')
+            return digit - '0';
+        if (digit >= 'a' && digit <= 'f')
+            return digit - 'a' + 10;
+        return -1;
+    }
+    std::istream &in_;
+};
+
+} // namespace
+
+template <typename RecordType, typename ReaderType>
+template <typename Visitor>
+void
+scheduler_impl_tmpl_t<RecordType, ReaderType>::visit_checkpoint_fields(
+    input_info_t &input, Visitor &visit)
+{
+    visit(input.last_record_tid);
+    visit(input.cur_from_queue);
+    visit(input.last_pc_fallthrough);
+    visit(input.in_syscall_injection);
+    visit(input.priority);
+    visit(input.cur_region);
+    visit(input.in_cur_region);
+    visit(input.needs_init);
+    visit(input.needs_advance);
+    visit(input.needs_roi);
+    visit(input.at_eof);
+    visit(input.containing_output);
+    visit(input.prev_output);
+    visit(input.last_run_output);
+    visit(input.cur_output);
+    visit(input.next_timestamp);
+    visit(input.instrs_in_quantum);
+    visit(input.instrs_pre_read);
+    visit(input.base_timestamp);
+    visit(input.order_by_timestamp);
+    visit(input.queue_counter);
+    visit(input.processing_syscall);
+    visit(input.processing_maybe_blocking_syscall);
+    visit(input.pre_syscall_timestamp);
+    visit(input.switch_to_input);
+    visit(input.syscall_timeout_arg);
+    visit(input.switching_pre_instruction);
+    visit(input.prev_time_in_quantum);
+    visit(input.time_spent_in_quantum);
+    visit(input.blocked_time);
+    visit(input.blocked_start_time);
+    visit(input.unscheduled);
+    visit(input.skip_next_unscheduled);
+    visit(input.last_run_time);
+    visit(input.to_inject_syscall);
+    visit(input.saw_first_func_id_marker_after_syscall);
+}
+
+template <typename RecordType, typename ReaderType>
+template <typename Visitor>
+void
+scheduler_impl_tmpl_t<RecordType, ReaderType>::visit_checkpoint_fields(
+    output_info_t &output, Visitor &visit)
+{
+    visit(output.cur_input);
+    visit(output.prev_input);
+    visit(output.speculate_pc);
+    visit(output.prev_speculate_pc);
+    visit(output.last_record);
+    visit(output.waiting);
+    visit(output.tried_to_steal_on_idle);
+    visit(output.in_syscall_code);
+    visit(output.hit_syscall_code_end);
+    visit(output.in_context_switch_code);
+    visit(output.hit_switch_code_end);
+    visit(output.as_traced_cpuid);
+    visit(output.at_eof);
+    visit(output.idle_start_count);
+    visit(output.idle_count);
+    visit(output.base_timestamp);
+}
+
+template <typename RecordType, typename ReaderType>
+template <typename Visitor>
+void
+scheduler_impl_tmpl_t<RecordType, ReaderType>::visit_checkpoint_fields(
+    stream_t &stream, Visitor &visit)
+{
+    visit(stream.cur_ref_count_);
+    visit(stream.cur_instr_count_);
+    visit(stream.last_timestamp_);
+    visit(stream.first_timestamp_);
+    visit(stream.in_kernel_trace_);
+    visit(stream.version_);
+    visit(stream.filetype_);
+    visit(stream.cache_line_size_);
+    visit(stream.chunk_instr_count_);
+    visit(stream.page_size_);
+    visit(stream.prev_record_);
+}
+
+template <typename RecordType, typename ReaderType>
+typename scheduler_tmpl_t<RecordType, ReaderType>::scheduler_status_t
+scheduler_impl_tmpl_t<RecordType, ReaderType>::write_checkpoint(std::ostream &out)
+{
+    if (options_.mapping != sched_type_t::MAP_TO_ANY_OUTPUT) {
+        error_string_ = "Checkpoints are only supported for MAP_TO_ANY_OUTPUT";
+        return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+    }
+    checkpoint_writer_t<RecordType> writer(out);
+    out << CHECKPOINT_MAGIC << ' ' << CHECKPOINT_VERSION << ' ' << inputs_.size() << ' '
+        << outputs_.size() << ' ' << stop_instr_count_.load(std::memory_order_acquire)
+        << ' ' << live_input_count_.load(std::memory_order_acquire) << '\n';
+    for (input_info_t &input : inputs_) {
+        std::lock_guard<mutex_dbg_owned> lock(*input.lock);
+        if (input.is_combined_stream()) {
+            error_string_ = "Checkpoints are not supported for combined streams";
+            return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+        }
+        out << "input " << input.index << ' ' << input.workload << ' ' << input.tid
+            << ' ' << input.reader->get_record_ordinal() << ' '
+            << input.reader->get_instruction_ordinal();
+        visit_checkpoint_fields(input, writer);
+        out << ' ' << input.queue.size();
+        for (RecordType &record : input.queue)
+            writer(record);
+        out << '\n';
+    }
+    for (output_ordinal_t i = 0; i < static_cast<output_ordinal_t>(outputs_.size());
+         ++i) {
+        output_info_t &output = outputs_[i];
+        auto lock = acquire_scoped_output_lock_if_necessary(i);
+        if (!output.speculation_stack.empty()) {
+            error_string_ = "Cannot checkpoint an output that is speculating";
+            return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+        }
+        if (output.stream->batch_has_carried_record_ ||
+            output.stream->batch_pending_status_ != sched_type_t::STATUS_OK) {
+            error_string_ = "Cannot checkpoint an output with a partial record batch";
+            return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+        }
+        out << "output " << i;
+        visit_checkpoint_fields(output, writer);
+        if (!options_.single_lockstep_output)
+            visit_checkpoint_fields(*output.stream, writer);
+        out << ' ' << output.active->load(std::memory_order_acquire) << ' '
+            << output.cur_time->load(std::memory_order_acquire) << ' '
+            << output.initial_cur_time->load(std::memory_order_acquire);
+        out << ' ' << output.stats.size();
+        for (int64_t stat : output.stats)
+            out << ' ' << stat;
+        // The queue has no iterator: we drain it to list its entries in priority
+        // order and then put them back.  Each input's saved queue_counter preserves
+        // its position when re-added.
+        std::vector<input_info_t *> ready;
+        while (!output.ready_queue.queue.empty()) {
+            ready.push_back(output.ready_queue.queue.top());
+            output.ready_queue.queue.pop();
+        }
+        out << ' ' << output.ready_queue.fifo_counter << ' ' << ready.size();
+        for (input_info_t *input : ready) {
+            out << ' ' << input->index;
+            output.ready_queue.queue.push(input);
+        }
+        out << '\n';
+    }
+    if (options_.single_lockstep_output) {
+        out << "lockstep " << global_stream_->ordinal_;
+        visit_checkpoint_fields(*global_stream_, writer);
+        out << '\n';
+    }
+    if (!write_checkpoint_for_mode(out)) {
+        error_string_ = "Failed to write checkpoint state for the mapping mode";
+        return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+    }
+    out << "end\n";
+    if (!out.good())
+        return sched_type_t::STATUS_ERROR_FILE_WRITE_FAILED;
+    return sched_type_t::STATUS_SUCCESS;
+}
+
+template <typename RecordType, typename ReaderType>
+bool
+scheduler_impl_tmpl_t<RecordType, ReaderType>::seek_input_for_checkpoint(
+    input_info_t &input, uint64_t record_ordinal, uint64_t instr_ordinal)
+{
+    // A skip leaves the reader on a synthetic timestamp and cpuid ahead of the
+    // next instruction.  We stop one instruction short of the target so those
+    // records are walked over below rather than ending up in the resumed stream.
+    uint64_t cur_instr = input.reader->get_instruction_ordinal();
+    if (instr_ordinal > cur_instr + 1)
+        input.reader->skip_instructions(instr_ordinal - 1 - cur_instr);
+    while (input.reader->get_record_ordinal() < record_ordinal) {
+        if (*input.reader == *input.reader_end)
+            return false;
+        ++(*input.reader);
+    }
+    VPRINT(this, 2,
+           "Checkpointed input %d resumes at record #%" PRIu64 ", instr #%" PRIu64 "\n",
+           input.index, input.reader->get_record_ordinal(),
+           input.reader->get_instruction_ordinal());
+    return input.reader->get_record_ordinal() == record_ordinal &&
+        input.reader->get_instruction_ordinal() == instr_ordinal;
+}
+
+template <typename RecordType, typename ReaderType>
+typename scheduler_tmpl_t<RecordType, ReaderType>::scheduler_status_t
+scheduler_impl_tmpl_t<RecordType, ReaderType>::read_checkpoint(std::istream &in)
+{
+    checkpoint_reader_t<RecordType> reader(in);
+    std::string tag;
+    int version = 0;
+    size_t input_count = 0, output_count = 0;
+    uint64_t stop_count = 0;
+    int live_inputs = 0;
+    in >> tag >> version >> input_count >> output_count >> stop_count >> live_inputs;
+    if (in.fail() || tag != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION) {
+        error_string_ = "Invalid checkpoint header";
+        return sched_type_t::STATUS_ERROR_FILE_READ_FAILED;
+    }
+    if (input_count != inputs_.size() || output_count != outputs_.size()) {
+        error_string_ = "Checkpoint input or output count does not match";
+        return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+    }
+    for (input_info_t &input : inputs_) {
+        std::lock_guard<mutex_dbg_owned> lock(*input.lock);
+        int index = -1, workload = -1;
+        memref_tid_t tid = INVALID_THREAD_ID;
+        uint64_t record_ordinal = 0, instr_ordinal = 0;
+        in >> tag >> index >> workload >> tid >> record_ordinal >> instr_ordinal;
+        if (in.fail() || tag != "input" || index != input.index ||
+            workload != input.workload || tid != input.tid) {
+            error_string_ = "Checkpoint does not match input #" +
+                std::to_string(input.index);
+            return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+        }
+        bool reader_needs_init = input.needs_init;
+        visit_checkpoint_fields(input, reader);
+        size_t queue_size = 0;
+        in >> queue_size;
+        input.queue.clear();
+        for (size_t i = 0; i < queue_size && !in.fail(); ++i) {
+            RecordType record;
+            reader(record);
+            input.queue.push_back(record);
+        }
+        if (in.fail()) {
+            error_string_ = "Failed to read checkpoint for input #" +
+                std::to_string(input.index);
+            return sched_type_t::STATUS_ERROR_FILE_READ_FAILED;
+        }
+        if (input.needs_init || input.at_eof)
+            continue;
+        if (reader_needs_init)
+            input.reader->init();
+        if (!seek_input_for_checkpoint(input, record_ordinal, instr_ordinal)) {
+            error_string_ = "Failed to seek input #" + std::to_string(input.index) +
+                " to its checkpointed position";
+            return sched_type_t::STATUS_ERROR_RANGE_INVALID;
+        }
+    }
+    for (output_ordinal_t i = 0; i < static_cast<output_ordinal_t>(outputs_.size());
+         ++i) {
+        output_info_t &output = outputs_[i];
+        auto lock = acquire_scoped_output_lock_if_necessary(i);
+        in >> tag;
+        if (in.fail() || tag != "output") {
+            error_string_ = "Failed to read checkpoint for output #" + std::to_string(i);
+            return sched_type_t::STATUS_ERROR_FILE_READ_FAILED;
+        }
+        int index = -1;
+        in >> index;
+        visit_checkpoint_fields(output, reader);
+        if (!options_.single_lockstep_output)
+            visit_checkpoint_fields(*output.stream, reader);
+        bool active = true;
+        uint64_t cur_time = 0, initial_cur_time = 0;
+        size_t stat_count = 0;
+        in >> active >> cur_time >> initial_cur_time >> stat_count;
+        if (in.fail() || index != i || stat_count != output.stats.size()) {
+            error_string_ = "Failed to read checkpoint for output #" + std::to_string(i);
+            return sched_type_t::STATUS_ERROR_FILE_READ_FAILED;
+        }
+        output.active->store(active, std::memory_order_release);
+        output.cur_time->store(cur_time, std::memory_order_release);
+        output.initial_cur_time->store(initial_cur_time, std::memory_order_release);
+        for (int64_t &stat : output.stats)
+            in >> stat;
+        size_t ready_count = 0;
+        in >> output.ready_queue.fifo_counter >> ready_count;
+        // set_initial_schedule() never ran, so the queues start out empty.
+        assert(output.ready_queue.queue.empty());
+        for (size_t j = 0; j < ready_count && !in.fail(); ++j) {
+            input_ordinal_t input = sched_type_t::INVALID_INPUT_ORDINAL;
+            in >> input;
+            if (input < 0 || input >= static_cast<input_ordinal_t>(inputs_.size())) {
+                in.setstate(std::ios::failbit);
+                break;
+            }
+            if (inputs_[input].blocked_time > 0)
+                ++output.ready_queue.num_blocked;
+            output.ready_queue.queue.push(&inputs_[input]);
+        }
+        if (in.fail()) {
+            error_string_ = "Failed to read checkpoint for output #" + std::to_string(i);
+            return sched_type_t::STATUS_ERROR_FILE_READ_FAILED;
+        }
+        if (output.cur_input != sched_type_t::INVALID_INPUT_ORDINAL) {
+            workload_info_t &workload = workloads_[inputs_[output.cur_input].workload];
+            if (workload.output_limit > 0)
+                workload.live_output_count->fetch_add(1, std::memory_order_release);
+        }
+    }
+    if (options_.single_lockstep_output) {
+        in >> tag >> global_stream_->ordinal_;
+        visit_checkpoint_fields(*global_stream_, reader);
+        if (in.fail() || tag != "lockstep") {
+            error_string_ = "Failed to read checkpoint for the lockstep output";
+            return sched_type_t::STATUS_ERROR_FILE_READ_FAILED;
+        }
+    }
+    if (!read_checkpoint_for_mode(in)) {
+        error_string_ = "Failed to read checkpoint state for the mapping mode";
+        return sched_type_t::STATUS_ERROR_FILE_READ_FAILED;
+    }
+    in >> tag;
+    if (in.fail() || tag != "end") {
+        error_string_ = "Checkpoint is truncated";
+        return sched_type_t::STATUS_ERROR_FILE_READ_FAILED;
+    }
+    stop_instr_count_.store(stop_count, std::memory_order_release);
+    live_input_count_.store(live_inputs, std::memory_order_release);
+    VPRINT(this, 1, "Resumed from checkpoint after %" PRIu64 " instructions\n",
+           stop_count);
+    return sched_type_t::STATUS_SUCCESS;
+}
+
 template <typename RecordType, typename ReaderType>
 typename scheduler_tmpl_t<RecordType, ReaderType>::scheduler_status_t
 scheduler_impl_tmpl_t<RecordType, ReaderType>::create_regions_from_times(
     const std::unordered_map<memref_tid_t, int> &workload_tids,
     input_workload_t &workload)
 {
-    // First, read from the as-traced schedule file into data structures shared with
-    // replay-as-traced.
-    std::vector<std::vector<schedule_input_tracker_t>> input_sched(inputs_.size());
-    // These are all unused.
-    std::vector<std::set<uint64_t>> start2stop(inputs_.size());
-    std::vector<std::vector<schedule_output_tracker_t>> all_sched;
-    std::vector<output_ordinal_t> disk_ord2index;
-    std::vector<uint64_t> disk_ord2cpuid;
-    scheduler_status_t res = read_traced_schedule(input_sched, start2stop, all_sched,
-                                                  disk_ord2index, disk_ord2cpuid);
-    if (res != sched_type_t::STATUS_SUCCESS)
-        return res;
-    // Do not allow a replay mode to start later.
-    options_.replay_as_traced_istream = nullptr;
-
-    // Now create an interval tree of timestamps (with instr ordinals as payloads)
+    // We create an interval tree of timestamps (with instr ordinals as payloads)
     // for each input. As our intervals do not overlap and have no gaps we need
     // no size, just the start address key.
     std::vector<std::map<uint64_t, uint64_t>> time_tree(inputs_.size());
-    for (int input_idx = 0; input_idx < static_cast<input_ordinal_t>(inputs_.size());
-         ++input_idx) {
-        for (int sched_idx = 0;
-             sched_idx < static_cast<int>(input_sched[input_idx].size()); ++sched_idx) {
-            schedule_input_tracker_t &sched = input_sched[input_idx][sched_idx];
-            VPRINT(this, 4, "as-read: input=%d start=%" PRId64 " time=%" PRId64 "\n",
-                   input_idx, sched.start_instruction, sched.timestamp);
-            time_tree[input_idx][sched.timestamp] = sched.start_instruction;
+    if (options_.replay_as_traced_istream == nullptr) {
+        // Without the as-traced schedule file, fall back to the coarser chunk start
+        // times in the inputs' chunk index files.
+        if (!read_chunk_index_times(time_tree)) {
+            error_string_ = "Missing as-traced istream and chunk index files";
+            return sched_type_t::STATUS_ERROR_INVALID_PARAMETER;
+        }
+    } else {
+        // Read from the as-traced schedule file into data structures shared with
+        // replay-as-traced.
+        std::vector<std::vector<schedule_input_tracker_t>> input_sched(inputs_.size());
+        // These are all unused.
+        std::vector<std::set<uint64_t>> start2stop(inputs_.size());
+        std::vector<std::vector<schedule_output_tracker_t>> all_sched;
+        std::vector<output_ordinal_t> disk_ord2index;
+        std::vector<uint64_t> disk_ord2cpuid;
+        scheduler_status_t res = read_traced_schedule(input_sched, start2stop, all_sched,
+                                                      disk_ord2index, disk_ord2cpuid);
+        if (res != sched_type_t::STATUS_SUCCESS)
+            return res;
+        // Do not allow a replay mode to start later.
+        options_.replay_as_traced_istream = nullptr;
+        for (int input_idx = 0; input_idx < static_cast<input_ordinal_t>(inputs_.size());
+             ++input_idx) {
+            for (int sched_idx = 0;
+                 sched_idx < static_cast<int>(input_sched[input_idx].size());
+                 ++sched_idx) {
+                schedule_input_tracker_t &sched = input_sched[input_idx][sched_idx];
+                VPRINT(this, 4,
+                       "as-read: input=%d start=%" PRId64 " time=%" PRId64 "\n",
+                       input_idx, sched.start_instruction, sched.timestamp);
+                time_tree[input_idx][sched.timestamp] = sched.start_instruction;
+            }
         }
     }
 
@@ -1264,6 +1824,32 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::create_regions_from_times(
     return sched_type_t::STATUS_SUCCESS;
 }
 
+template <typename RecordType, typename ReaderType>
+bool
+scheduler_impl_tmpl_t<RecordType, ReaderType>::read_chunk_index_times(
+    std::vector<std::map<uint64_t, uint64_t>> &time_tree)
+{
+    bool found_any = false;
+    for (int input_idx = 0; input_idx < static_cast<input_ordinal_t>(inputs_.size());
+         ++input_idx) {
+        std::vector<trace_index_entry_t> entries;
+        if (inputs_[input_idx].path.empty() ||
+            !read_trace_index(inputs_[input_idx].path, entries))
+            continue;
+        found_any = true;
+        for (const trace_index_entry_t &entry : entries) {
+            // The first chunk precedes any timestamp.
+            if (entry.timestamp == 0)
+                continue;
+            VPRINT(this, 4, "chunk index: input=%d start=%" PRId64 " time=%" PRId64 "\n",
+                   input_idx, entry.instr_ordinal, entry.timestamp);
+            // Keep the earliest chunk if several share a timestamp.
+            time_tree[input_idx].emplace(entry.timestamp, entry.instr_ordinal);
+        }
+    }
+    return found_any;
+}
+
 template <typename RecordType, typename ReaderType>
 bool
 scheduler_impl_tmpl_t<RecordType, ReaderType>::time_tree_lookup(
@@ -1960,6 +2546,7 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::open_reader(
     inputs_.emplace_back();
     input_info_t &input = inputs_.back();
     input.index = index;
+    input.path = path;
     // We need the tid up front.  Rather than assume it's still part of the filename,
     // we read the first record (we generalize to read until we find the first but we
     // expect it to be the first after PR #5739 changed the order file_reader_t passes
@@ -2008,36 +2595,12 @@ typename scheduler_tmpl_t<RecordType, ReaderType>::scheduler_status_t
 scheduler_impl_tmpl_t<RecordType, ReaderType>::open_readers(
     const std::string &path, input_reader_info_t &reader_info)
 {
-    if (!directory_iterator_t::is_directory(path)) {
-        return open_reader(path, 0, reader_info);
-    }
-    directory_iterator_t end;
-    directory_iterator_t iter(path);
-    if (!iter) {
-        error_string_ = "Failed to list directory " + path + ": " + iter.error_string();
-        return sched_type_t::STATUS_ERROR_FILE_OPEN_FAILED;
-    }
     std::vector<std::string> files;
-    for (; iter != end; ++iter) {
-        const std::string fname = *iter;
-        if (fname == "." || fname == ".." ||
-            starts_with(fname, DRMEMTRACE_SERIAL_SCHEDULE_FILENAME) ||
-            fname == DRMEMTRACE_CPU_SCHEDULE_FILENAME)
-            continue;
-        // Skip the auxiliary files.
-        if (fname == DRMEMTRACE_MODULE_LIST_FILENAME ||
-            fname == DRMEMTRACE_FUNCTION_LIST_FILENAME ||
-            fname == DRMEMTRACE_ENCODING_FILENAME || fname == DRMEMTRACE_V2P_FILENAME)
-            continue;
-        const std::string file = path + DIRSEP + fname;
-        files.push_back(file);
-    }
-    // Sort so we can have reliable shard ordinals for only_shards.
-    // We assume leading 0's are used for important numbers embedded in the path,
-    // so that a regular sort keeps numeric order.
-    std::sort(files.begin(), files.end());
+    scheduler_status_t res = sched_type_t::list_input_files(path, files, error_string_);
+    if (res != sched_type_t::STATUS_SUCCESS)
+        return res;
     for (int i = 0; i < static_cast<int>(files.size()); ++i) {
-        scheduler_status_t res = open_reader(files[i], i, reader_info);
+        res = open_reader(files[i], i, reader_info);
         if (res != sched_type_t::STATUS_SUCCESS)
             return res;
     }
@@ -2619,6 +3182,17 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::set_cur_input(
 
     inputs_[input].cur_output = output;
     inputs_[input].containing_output = output;
+    output_ordinal_t last_run = inputs_[input].last_run_output;
+    if (last_run != sched_type_t::INVALID_OUTPUT_ORDINAL && last_run != output) {
+        topology_distance_t distance = topology_distance(last_run, output);
+        if (distance > TOPOLOGY_SAME_CORE)
+            ++outputs_[output].stats[memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_CORE];
+        if (distance > TOPOLOGY_SAME_LLC)
+            ++outputs_[output].stats[memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_LLC];
+        if (distance > TOPOLOGY_SAME_NODE)
+            ++outputs_[output].stats[memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_NODE];
+    }
+    inputs_[input].last_run_output = output;
 
     if (prev_input < 0 && outputs_[output].stream->version_ == 0) {
         // Set the version and filetype up front, to let the user query at init time
@@ -2832,6 +3406,11 @@ scheduler_impl_tmpl_t<RecordType, ReaderType>::next_record(output_ordinal_t outp
                                                            uint64_t cur_time)
 {
     record = create_invalid_record();
+    // We check before touching any state so a checkpoint written after the stop
+    // resumes precisely where this output left off.
+    if (options_.stop_after_instrs > 0 &&
+        stop_instr_count_.load(std::memory_order_relaxed) >= options_.stop_after_instrs)
+        return sched_type_t::STATUS_EOF;
     // We do not enforce a globally increasing time to avoid the synchronization cost; we
     // do return an error on a time smaller than an input's current start time when we
     // check for quantum end.
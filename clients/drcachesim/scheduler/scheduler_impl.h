@@ -42,10 +42,12 @@
 
 #include <atomic>
 #include <deque>
+#include <istream>
 #include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <ostream>
 #include <queue>
 #include <set>
 #include <stack>
@@ -105,6 +107,7 @@ protected:
     using scheduler_flags_t = typename sched_type_t::scheduler_flags_t;
     using range_t = typename sched_type_t::range_t;
     using switch_type_t = typename sched_type_t::switch_type_t;
+    using output_topology_t = typename sched_type_t::output_topology_t;
 
 public:
     scheduler_impl_tmpl_t() = default;
@@ -156,6 +159,9 @@ public:
     scheduler_status_t
     write_recorded_schedule();
 
+    scheduler_status_t
+    write_checkpoint(std::ostream &out);
+
 protected:
     typedef speculator_tmpl_t<RecordType> spec_type_t;
 
@@ -175,6 +181,8 @@ protected:
         int index = -1; // Position in inputs_ vector.
         std::unique_ptr<ReaderType> reader;
         std::unique_ptr<ReaderType> reader_end;
+        // The file the reader opened, if any, for locating its chunk index file.
+        std::string path;
         // While the scheduler only hands an input to one output at a time, during
         // scheduling decisions one thread may need to access another's fields.
         // This lock controls access to fields that are modified during scheduling.
@@ -196,7 +204,7 @@ protected:
         // This is used for read-ahead and inserting synthetic records.
         // We use a deque so we can iterate over it.
         std::deque<RecordType> queue;
-        bool cur_from_queue;
+        bool cur_from_queue = false;
         addr_t last_pc_fallthrough = 0;
         // Whether we're in the middle of returning injected syscall records.
         bool in_syscall_injection = false;
@@ -220,6 +228,9 @@ protected:
         output_ordinal_t prev_output = sched_type_t::INVALID_OUTPUT_ORDINAL;
         // The current output where we're actively running.
         output_ordinal_t cur_output = sched_type_t::INVALID_OUTPUT_ORDINAL;
+        // The output where we most recently started running, for topology-aware
+        // placement and cross-domain migration statistics.
+        output_ordinal_t last_run_output = sched_type_t::INVALID_OUTPUT_ORDINAL;
         uintptr_t next_timestamp = 0;
         uint64_t instrs_in_quantum = 0;
         int instrs_pre_read = 0;
@@ -421,6 +432,25 @@ protected:
     void
     update_syscall_state(RecordType record, output_ordinal_t output);
 
+    // How far apart two outputs are in the output topology, in increasing order.
+    enum topology_distance_t {
+        TOPOLOGY_SAME_OUTPUT,
+        TOPOLOGY_SAME_CORE,
+        TOPOLOGY_SAME_LLC,
+        TOPOLOGY_SAME_NODE,
+        TOPOLOGY_CROSS_NODE,
+    };
+
+    topology_distance_t
+    topology_distance(output_ordinal_t a, output_ordinal_t b) const;
+
+    // Returns the i-th output (1 <= i < outputs_.size()) which "output" should
+    // try to steal from: the nearest outputs in the topology first, starting with
+    // output+1 within each distance to avoid everyone stealing from the
+    // low-numbered outputs.
+    output_ordinal_t
+    steal_victim(output_ordinal_t output, unsigned int i) const;
+
     ///
     ///////////////////////////////////////////////////////////////////////////
 
@@ -489,6 +519,11 @@ protected:
         bool waiting = false; // Waiting or idling.
         // Used to limit stealing to one attempt per transition to idle.
         bool tried_to_steal_on_idle = false;
+        // Our place in options_.output_topology, or a core of our own if that is empty.
+        output_topology_t topology;
+        // The other outputs in steal_victim() order.  Only computed when
+        // options_.output_topology is supplied; otherwise we simply rotate.
+        std::vector<output_ordinal_t> steal_order;
         // This is accessed by other outputs for stealing and rebalancing.
         // Indirected so we can store it in our vector.
         std::unique_ptr<std::atomic<bool>> active;
@@ -661,6 +696,19 @@ protected:
     virtual stream_status_t
     eof_or_idle_for_mode(output_ordinal_t output, input_ordinal_t prev_input) = 0;
 
+    // Writes and reads checkpoint state owned by the mapping_t mode beyond the
+    // inputs and outputs.  Only dynamic schedules support checkpoints.
+    virtual bool
+    write_checkpoint_for_mode(std::ostream &out)
+    {
+        return false;
+    }
+    virtual bool
+    read_checkpoint_for_mode(std::istream &in)
+    {
+        return false;
+    }
+
     ///
     ///////////////////////////////////////////////////////////////////////////
 
@@ -675,9 +723,37 @@ protected:
     void
     print_configuration();
 
+    // Restores the state saved by write_checkpoint() in place of
+    // set_initial_schedule().
+    scheduler_status_t
+    read_checkpoint(std::istream &in);
+
+    // Positions the reader for 'input' at the given ordinals, using the reader's
+    // skip_instructions() to avoid a linear walk where it can.
+    bool
+    seek_input_for_checkpoint(input_info_t &input, uint64_t record_ordinal,
+                              uint64_t instr_ordinal);
+
+    // Applies 'visit' to each checkpointed field, in the order shared by
+    // write_checkpoint() and read_checkpoint().
+    template <typename Visitor>
+    void
+    visit_checkpoint_fields(input_info_t &input, Visitor &visit);
+    template <typename Visitor>
+    void
+    visit_checkpoint_fields(output_info_t &output, Visitor &visit);
+    template <typename Visitor>
+    void
+    visit_checkpoint_fields(stream_t &stream, Visitor &visit);
+
     scheduler_status_t
     legacy_field_support();
 
+    // Validates options_.output_topology and fills in each output's topology and
+    // steal_order fields.
+    scheduler_status_t
+    init_output_topology();
+
     // Opens readers for each file in 'path', subject to the constraints in
     // 'reader_info'.  'path' may be a directory.
     // Updates the ti2dinput, unfiltered_tids, and input_count fields of 'reader_info'.
@@ -737,6 +813,11 @@ protected:
     create_regions_from_times(const std::unordered_map<memref_tid_t, int> &workload_tids,
                               input_workload_t &workload);
 
+    // Fills in "time_tree" from the chunk start times in each input's chunk index
+    // file.  Returns false if no input has an index.
+    bool
+    read_chunk_index_times(std::vector<std::map<uint64_t, uint64_t>> &time_tree);
+
     // Interval time-to-instr-ord tree lookup with interpolation.
     bool
     time_tree_lookup(const std::map<uint64_t, uint64_t> &tree, uint64_t time,
@@ -1035,6 +1116,8 @@ protected:
     std::atomic<int> live_input_count_;
     // In replay mode, count of outputs not yet at the end of the replay sequence.
     std::atomic<int> live_replay_output_count_;
+    // Instructions returned across all outputs, for options_.stop_after_instrs.
+    std::atomic<uint64_t> stop_instr_count_ { 0 };
     // Map from workload,tid pair to input.
     struct workload_tid_t {
         workload_tid_t(int wl, memref_tid_t tid)
@@ -1118,6 +1201,8 @@ private:
                                 ReaderType>::acquire_scoped_output_lock_if_necessary;
     using scheduler_impl_tmpl_t<RecordType, ReaderType>::get_output_time;
     using scheduler_impl_tmpl_t<RecordType, ReaderType>::scale_blocked_time;
+    using scheduler_impl_tmpl_t<RecordType, ReaderType>::topology_distance;
+    using scheduler_impl_tmpl_t<RecordType, ReaderType>::steal_victim;
 
 protected:
     scheduler_status_t
@@ -1144,6 +1229,12 @@ protected:
     stream_status_t
     set_output_active(output_ordinal_t output, bool active) override;
 
+    bool
+    write_checkpoint_for_mode(std::ostream &out) override;
+
+    bool
+    read_checkpoint_for_mode(std::istream &in) override;
+
     // The input's lock must be held by the caller.
     // Returns a multiplier for how long the input should be considered blocked.
     bool
@@ -1160,6 +1251,12 @@ protected:
     rebalance_queues(output_ordinal_t triggering_output,
                      std::vector<input_ordinal_t> inputs_to_add);
 
+    // Removes and returns the entry of "candidates" that last ran nearest to
+    // "output" in the topology, preferring later entries on ties.
+    input_ordinal_t
+    take_nearest_input(output_ordinal_t output,
+                       std::vector<input_ordinal_t> &candidates);
+
     bool
     ready_queue_empty(output_ordinal_t output);
 
@@ -1194,6 +1291,14 @@ protected:
                                     output_ordinal_t for_output, input_info_t *&new_input,
                                     bool from_back = false);
 
+    // For options_.work_stealing: tries to take an input runnable on "output" from
+    // another output's ready queue without waiting on any lock.  Returns whether an
+    // input was found, in which case it is returned in "stolen" and the output it
+    // came from in "victim".
+    bool
+    steal_from_ready_queues(output_ordinal_t output, output_ordinal_t &victim,
+                            input_info_t *&stolen);
+
     // Up to the caller to check verbosity before calling.
     void
     print_queue_stats();
@@ -100,7 +100,7 @@ cache_t::flush(const memref_t &memref)
             continue;
         replacement_policy_->invalidation_update(compute_block_idx(tag),
                                                  block_way.second);
-        invalidate_caching_device_block(block_way.first);
+        invalidate_caching_device_block(block_way.first, block_way.second);
     }
     // We flush parent_'s code cache here.
     // XXX: should L1 data cache be flushed when L1 instr cache is flushed?
@@ -36,6 +36,8 @@
 #include <string>
 #include <vector>
 
+#include "memref.h"
+
 namespace dynamorio {
 namespace drmemtrace {
 
@@ -53,6 +55,10 @@ namespace drmemtrace {
  * ways.
  *  - When a way is invalidated, `invalidation_update()` is called.
  *
+ * Before the updates for each access, `caching_device_t` records the accessed line's
+ * tag and the accessing instruction with `set_access_context()`, so that policies
+ * which predict reuse from them can read `access_tag_` and `access_pc_`.
+ *
  * The policy also provides a `get_next_way_to_replace()` method that returns
  * the next way to replace in the block. This function assumes that all ways are valid,
  * and is called by `caching_device_t` when it cannot just replace an invalid way.
@@ -87,12 +93,24 @@ public:
     /// Returns the name of the replacement policy.
     virtual std::string
     get_name() const = 0;
+    /// Records the line and instruction of the access being processed.
+    void
+    set_access_context(addr_t tag, addr_t pc, bool is_prefetch)
+    {
+        access_tag_ = tag;
+        access_pc_ = pc;
+        access_is_prefetch_ = is_prefetch;
+    }
 
     virtual ~cache_replacement_policy_t() = default;
 
 protected:
     int associativity_;
     int num_sets_;
+    // The access being processed, as recorded by set_access_context().
+    addr_t access_tag_ = 0;
+    addr_t access_pc_ = 0;
+    bool access_is_prefetch_ = false;
 };
 
 } // namespace drmemtrace
@@ -34,10 +34,14 @@
 
 #include <stddef.h>
 #include <stdint.h> /* for supporting 64-bit integers*/
+#include <stdlib.h>
 
 #include <functional>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <queue>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -53,10 +57,15 @@
 #include "cache.h"
 #include "cache_simulator_create.h"
 #include "cache_stats.h"
+#include "cache_sweep.h"
 #include "caching_device.h"
 #include "caching_device_stats.h"
 #include "create_cache_replacement_policy.h"
+#include "parallel_cache_link.h"
 #include "prefetcher.h"
+#include "prefetcher_sms.h"
+#include "prefetcher_stream.h"
+#include "prefetcher_stride.h"
 #include "simulator.h"
 #include "snoop_filter.h"
 #include "utils.h"
@@ -64,6 +73,55 @@
 namespace dynamorio {
 namespace drmemtrace {
 
+// Returns whether the named prefetcher is one of the table-based models whose
+// usefulness statistics we print.
+static bool
+is_table_prefetcher(const std::string &prefetcher_name)
+{
+    return prefetcher_name == PREFETCH_POLICY_STRIDE ||
+        prefetcher_name == PREFETCH_POLICY_STREAM ||
+        prefetcher_name == PREFETCH_POLICY_SMS;
+}
+
+// Parses the LL_sweep knob's comma-separated "size[:assoc]" entries.
+static bool
+parse_sweep_configs(const std::string &spec, unsigned int default_assoc,
+                    std::vector<std::pair<int64_t, int>> *configs)
+{
+    std::stringstream stream(spec);
+    std::string entry;
+    while (std::getline(stream, entry, ',')) {
+        size_t colon = entry.find(':');
+        std::string size_str = entry.substr(0, colon);
+        int assoc = static_cast<int>(default_assoc);
+        if (colon != std::string::npos) {
+            char *end;
+            assoc = static_cast<int>(strtol(entry.c_str() + colon + 1, &end, 10));
+            if (*end != '\0' || end == entry.c_str() + colon + 1)
+                return false;
+        }
+        if (size_str.empty())
+            return false;
+        int64_t scale = 1;
+        switch (size_str.back()) {
+        case 'K':
+        case 'k': scale = 1024; break;
+        case 'M':
+        case 'm': scale = 1024 * 1024; break;
+        case 'G':
+        case 'g': scale = 1024 * 1024 * 1024; break;
+        }
+        if (scale != 1)
+            size_str.pop_back();
+        char *end;
+        int64_t size = strtoll(size_str.c_str(), &end, 10);
+        if (*end != '\0' || end == size_str.c_str() || size <= 0)
+            return false;
+        configs->emplace_back(size * scale, assoc);
+    }
+    return !configs->empty();
+}
+
 analysis_tool_t *
 cache_simulator_create(const cache_simulator_knobs_t &knobs)
 {
@@ -92,6 +150,7 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs,
     , knobs_(knobs)
     , l1_icaches_(NULL)
     , l1_dcaches_(NULL)
+    , snooped_caches_(NULL)
     , custom_prefetcher_factory_(custom_prefetcher_factory)
     , is_warmed_up_(false)
 {
@@ -99,13 +158,20 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs,
 
     // This configuration allows for one shared LLC only.
     std::string cache_name = "LL";
-    cache_t *llc = new cache_t(cache_name);
+    cache_t *llc;
+    if (knobs_.LL_sweep.empty())
+        llc = new cache_t(cache_name);
+    else {
+        LL_sweep_ = new cache_sweep_t(cache_name);
+        llc = LL_sweep_;
+    }
 
     all_caches_[cache_name] = llc;
     llcaches_[cache_name] = llc;
 
     if (knobs_.data_prefetcher != PREFETCH_POLICY_NEXTLINE &&
-        knobs_.data_prefetcher != PREFETCH_POLICY_NONE) {
+        knobs_.data_prefetcher != PREFETCH_POLICY_NONE &&
+        !is_table_prefetcher(knobs_.data_prefetcher)) {
         if (knobs_.data_prefetcher == PREFETCH_POLICY_CUSTOM) {
             if (custom_prefetcher_factory_ == nullptr) {
                 error_string_ =
@@ -136,6 +202,27 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs,
         success_ = false;
         return;
     }
+    if (LL_sweep_ != nullptr) {
+        std::vector<std::pair<int64_t, int>> sweep_configs;
+        if (!parse_sweep_configs(knobs_.LL_sweep, knobs_.LL_assoc, &sweep_configs)) {
+            error_string_ = "Usage error: failed to parse LL_sweep '" + knobs_.LL_sweep +
+                "'.  Expected a comma-separated list of size[:assoc] entries.";
+            success_ = false;
+            return;
+        }
+        for (const auto &config : sweep_configs) {
+            if (!LL_sweep_->add_sweep_config(config.second, config.first,
+                                             knobs_.replace_policy)) {
+                error_string_ = "Usage error: invalid LL_sweep configuration size=" +
+                    std::to_string(config.first) +
+                    ", assoc=" + std::to_string(config.second) +
+                    ".  Ensure size divided by associativity is a power of 2 and a "
+                    "multiple of the line size.";
+                success_ = false;
+                return;
+            }
+        }
+    }
 
     l1_icaches_ = new cache_t *[knobs_.num_cores];
     l1_dcaches_ = new cache_t *[knobs_.num_cores];
@@ -183,6 +270,9 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs,
         all_caches_[l1_dcaches_[i]->get_name()] = l1_dcaches_[i];
     }
 
+    if (is_table_prefetcher(knobs_.data_prefetcher))
+        enable_prefetcher_stats();
+
     if (knobs_.model_coherence &&
         !snoop_filter_->init(snooped_caches_, total_snooped_caches)) {
         ERRMSG("Usage error: failed to initialize snoop filter.\n");
@@ -214,7 +304,8 @@ cache_simulator_t::cache_simulator_t(std::istream *config_file,
                knobs_.use_physical, knobs_.verbose);
 
     if (knobs_.data_prefetcher != PREFETCH_POLICY_NEXTLINE &&
-        knobs_.data_prefetcher != PREFETCH_POLICY_NONE) {
+        knobs_.data_prefetcher != PREFETCH_POLICY_NONE &&
+        !is_table_prefetcher(knobs_.data_prefetcher)) {
         if (knobs_.data_prefetcher == PREFETCH_POLICY_CUSTOM) {
             if (custom_prefetcher_factory_ == nullptr) {
                 error_string_ = "custom prefetcher was requested but no factory was "
@@ -393,6 +484,12 @@ cache_simulator_t::cache_simulator_t(std::istream *config_file,
         success_ = false;
         return;
     }
+    for (const auto &cache_params_it : cache_params) {
+        if (is_table_prefetcher(cache_params_it.second.prefetcher)) {
+            enable_prefetcher_stats();
+            break;
+        }
+    }
     // For larger hierarchies, especially with coherence, using hashtables
     // for faster lookups provides performance wins as high as 15%.
     // However, hashtables can slow down smaller hierarchies, so we only
@@ -498,55 +595,9 @@ cache_simulator_t::process_memref(const memref_t &memref)
         simref = &phys_memref;
     }
 
-    if (type_is_instr(simref->instr.type) ||
-        simref->instr.type == TRACE_TYPE_PREFETCH_INSTR) {
-        if (knobs_.verbose >= 3) {
-            std::cerr << "::" << simref->data.pid << "." << simref->data.tid << ":: "
-                      << " @" << (void *)simref->instr.addr << " instr x"
-                      << simref->instr.size << "\n";
-        }
-        l1_icaches_[core_index]->request(*simref);
-    } else if (simref->data.type == TRACE_TYPE_READ ||
-               simref->data.type == TRACE_TYPE_WRITE ||
-               // We may potentially handle prefetches differently.
-               // TRACE_TYPE_PREFETCH_INSTR is handled above.
-               type_is_prefetch(simref->data.type)) {
-        if (knobs_.verbose >= 3) {
-            std::cerr << "::" << simref->data.pid << "." << simref->data.tid << ":: "
-                      << " @" << (void *)simref->data.pc << " "
-                      << trace_type_names[simref->data.type] << " "
-                      << (void *)simref->data.addr << " x" << simref->data.size << "\n";
-        }
-        l1_dcaches_[core_index]->request(*simref);
-    } else if (simref->flush.type == TRACE_TYPE_INSTR_FLUSH) {
-        if (knobs_.verbose >= 3) {
-            std::cerr << "::" << simref->data.pid << "." << simref->data.tid << ":: "
-                      << " @" << (void *)simref->data.pc << " iflush "
-                      << (void *)simref->data.addr << " x" << simref->data.size << "\n";
-        }
-        l1_icaches_[core_index]->flush(*simref);
-    } else if (simref->flush.type == TRACE_TYPE_DATA_FLUSH) {
-        if (knobs_.verbose >= 3) {
-            std::cerr << "::" << simref->data.pid << "." << simref->data.tid << ":: "
-                      << " @" << (void *)simref->data.pc << " dflush "
-                      << (void *)simref->data.addr << " x" << simref->data.size << "\n";
-        }
-        l1_dcaches_[core_index]->flush(*simref);
-    } else if (simref->exit.type == TRACE_TYPE_THREAD_EXIT) {
-        handle_thread_exit(simref->exit.tid);
-        last_thread_ = 0;
-    } else if (memref.marker.type == TRACE_TYPE_MARKER &&
-               memref.marker.marker_type == TRACE_MARKER_TYPE_CPU_ID) {
-        last_thread_ = 0;
-    } else if (simref->marker.type == TRACE_TYPE_INSTR_NO_FETCH) {
-        // Just ignore.
-        if (knobs_.verbose >= 3) {
-            std::cerr << "::" << simref->data.pid << "." << simref->data.tid << ":: "
-                      << " @" << (void *)simref->instr.addr << " non-fetched instr x"
-                      << simref->instr.size << "\n";
-        }
-    } else {
-        error_string_ = "Unhandled memref type " + std::to_string(simref->data.type);
+    std::string error = simulate_memref(*simref, core_index);
+    if (!error.empty()) {
+        error_string_ = error;
         return false;
     }
 
@@ -556,6 +607,8 @@ cache_simulator_t::process_memref(const memref_t &memref)
             cache_t *cache = cache_it.second;
             cache->get_stats()->reset();
         }
+        if (LL_sweep_ != nullptr)
+            LL_sweep_->reset_sweep_stats();
         if (knobs_.verbose >= 1) {
             std::cerr << "Cache simulation warmed up\n";
         }
@@ -566,12 +619,349 @@ cache_simulator_t::process_memref(const memref_t &memref)
     return true;
 }
 
+std::string
+cache_simulator_t::initialize_stream(memtrace_stream_t *serial_stream)
+{
+    std::string error = simulator_t::initialize_stream(serial_stream);
+    if (!error.empty())
+        return error;
+    // A null stream means the analyzer is running in parallel mode.
+    if (serial_stream == nullptr && knobs_.sim_parallel)
+        return init_parallel_sim();
+    return "";
+}
+
+std::string
+cache_simulator_t::initialize_shard_type(shard_type_t shard_type)
+{
+    std::string error = simulator_t::initialize_shard_type(shard_type);
+    if (!error.empty())
+        return error;
+    if (!shared_op_queues_.empty() && shard_type != SHARD_BY_CORE)
+        return "Usage error: -sim_parallel requires -core_sharded";
+    return "";
+}
+
+std::string
+cache_simulator_t::init_parallel_sim()
+{
+    if (knobs_.skip_refs > 0 || knobs_.warmup_refs > 0 || knobs_.warmup_fraction > 0.0 ||
+        knobs_.sim_refs != cache_simulator_knobs_t().sim_refs) {
+        return "Usage error: -sim_parallel does not support -skip_refs, -warmup_refs, "
+               "-warmup_fraction, or -sim_refs";
+    }
+    if (knobs_.use_physical)
+        return "Usage error: -sim_parallel does not support -use_physical";
+    // Coherence invalidations would reach the private caches of other cores up
+    // to a batch late, so the results would silently differ from -core_serial.
+    if (knobs_.model_coherence)
+        return "Usage error: -sim_parallel does not support -coherence";
+    if (knobs_.sim_parallel_batch == 0)
+        return "Usage error: -sim_parallel_batch must be > 0";
+    // Find the caches private to each core by walking up from its L1 caches.
+    // A cache reached from more than one core is shared.
+    const int shared = -1;
+    std::unordered_map<caching_device_t *, int> owner;
+    for (int core = 0; core < static_cast<int>(knobs_.num_cores); ++core) {
+        caching_device_t *l1_caches[] = { l1_icaches_[core], l1_dcaches_[core] };
+        for (caching_device_t *l1 : l1_caches) {
+            for (caching_device_t *cache = l1; cache != nullptr;
+                 cache = cache->get_parent()) {
+                auto it = owner.find(cache);
+                if (it == owner.end())
+                    owner[cache] = core;
+                else if (it->second != core)
+                    it->second = shared;
+            }
+        }
+    }
+    // An inclusive shared cache invalidates lines in private caches, and an
+    // exclusive one asks private caches whether they hold a line.  Either would
+    // see the private caches of other cores up to a batch ahead.
+    for (auto &it : owner) {
+        if (it.second == shared &&
+            (it.first->is_inclusive() || it.first->is_exclusive())) {
+            return "Usage error: -sim_parallel does not support inclusive or exclusive "
+                   "shared caches";
+        }
+    }
+    for (int core = 0; core < static_cast<int>(knobs_.num_cores); ++core)
+        shared_op_queues_.emplace_back(new shared_cache_op_queue_t(core));
+    for (auto &it : owner) {
+        caching_device_t *cache = it.first;
+        int core = it.second;
+        if (core == shared)
+            continue;
+        caching_device_t *parent = cache->get_parent();
+        if (parent != nullptr && owner[parent] == shared) {
+            cache_links_.emplace_back(new parallel_cache_link_t(
+                cache, parent, shared_op_queues_[core].get()));
+            link2target_[cache_links_.back().get()] = parent;
+        }
+    }
+    core_active_.assign(knobs_.num_cores, true);
+    shared_active_ = static_cast<int>(knobs_.num_cores);
+    return "";
+}
+
+caching_device_t *
+cache_simulator_t::get_parent_cache(caching_device_t *cache) const
+{
+    caching_device_t *parent = cache->get_parent();
+    auto it = link2target_.find(parent);
+    if (it != link2target_.end())
+        return it->second;
+    return parent;
+}
+
+bool
+cache_simulator_t::parallel_shard_supported()
+{
+    return knobs_.sim_parallel;
+}
+
+void *
+cache_simulator_t::parallel_worker_init(int worker_index)
+{
+    // For -core_sharded there is one worker per core.
+    if (worker_index < 0 || worker_index >= static_cast<int>(shared_op_queues_.size()))
+        return nullptr;
+    return shared_op_queues_[worker_index].get();
+}
+
+std::string
+cache_simulator_t::parallel_worker_exit(void *worker_data)
+{
+    // A core that never saw a record has no shard, so we leave the barrier
+    // here rather than in parallel_shard_exit().
+    shared_cache_op_queue_t *queue =
+        reinterpret_cast<shared_cache_op_queue_t *>(worker_data);
+    if (queue != nullptr)
+        leave_shared_caches(queue->get_core());
+    return "";
+}
+
+void *
+cache_simulator_t::parallel_shard_init_stream(int shard_index, void *worker_data,
+                                              memtrace_stream_t *stream)
+{
+    core_shard_data_t *shard = new core_shard_data_t;
+    shard->core = shard_index;
+    shard->stream = stream;
+    if (shard_index >= static_cast<int>(knobs_.num_cores)) {
+        shard->error = "Too-small core count " + std::to_string(knobs_.num_cores) +
+            " for trace core #" + std::to_string(shard_index);
+    }
+    return shard;
+}
+
+bool
+cache_simulator_t::parallel_shard_memref(void *shard_data, const memref_t &memref)
+{
+    core_shard_data_t *shard = reinterpret_cast<core_shard_data_t *>(shard_data);
+    if (!shard->error.empty())
+        return false;
+    shared_cache_op_queue_t *queue = shared_op_queues_[shard->core].get();
+    // Every record, including markers, counts as one step so that steps line up
+    // with the record-by-record rotation among cores used by -core_serial.
+    queue->advance_step();
+    if (memref.marker.type != TRACE_TYPE_MARKER) {
+        int64_t cpu = shard->stream->get_output_cpuid();
+        if (cpu != shard->last_cpu) {
+            shard->cpus.push_back(cpu);
+            shard->last_cpu = cpu;
+        }
+        shard->error = simulate_memref(memref, shard->core);
+        if (!shard->error.empty()) {
+            leave_shared_caches(shard->core);
+            return false;
+        }
+    }
+    if (queue->get_step() % knobs_.sim_parallel_batch == 0)
+        sync_shared_caches();
+    return true;
+}
+
+bool
+cache_simulator_t::parallel_shard_exit(void *shard_data)
+{
+    core_shard_data_t *shard = reinterpret_cast<core_shard_data_t *>(shard_data);
+    {
+        // Track the cpuid<->core relationship for our results printout.
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+        for (int64_t cpu : shard->cpus) {
+            if (cpu2core_.find(cpu) == cpu2core_.end())
+                cpu2core_[cpu] = shard->core;
+        }
+    }
+    delete shard;
+    return true;
+}
+
+std::string
+cache_simulator_t::parallel_shard_error(void *shard_data)
+{
+    core_shard_data_t *shard = reinterpret_cast<core_shard_data_t *>(shard_data);
+    return shard->error;
+}
+
+void
+cache_simulator_t::sync_shared_caches()
+{
+    std::unique_lock<std::mutex> lock(shared_mutex_);
+    uint64_t generation = shared_generation_;
+    if (++shared_arrived_ == shared_active_) {
+        drain_shared_ops();
+        shared_arrived_ = 0;
+        ++shared_generation_;
+        shared_cond_.notify_all();
+    } else {
+        shared_cond_.wait(lock, [&] { return shared_generation_ != generation; });
+    }
+}
+
+void
+cache_simulator_t::leave_shared_caches(int core)
+{
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    if (!core_active_[core])
+        return;
+    core_active_[core] = false;
+    --shared_active_;
+    // Our remaining operations were all issued at steps prior to the next
+    // barrier's, so it is fine to leave them queued for that barrier.
+    if (shared_active_ == 0 || shared_arrived_ == shared_active_) {
+        drain_shared_ops();
+        shared_arrived_ = 0;
+        ++shared_generation_;
+        shared_cond_.notify_all();
+    }
+}
+
+void
+cache_simulator_t::drain_shared_ops()
+{
+    // -core_serial rotates among the cores one record at a time starting with
+    // core 1 and ending with core 0.  We replay the queued operations in that
+    // same order: by step, then by core rotation rank, then in issue order.
+    struct cursor_t {
+        uint64_t step;
+        int rank;
+        size_t index;
+        shared_cache_op_queue_t *queue;
+        bool
+        operator>(const cursor_t &rhs) const
+        {
+            return step > rhs.step || (step == rhs.step && rank > rhs.rank);
+        }
+    };
+    int num_cores = static_cast<int>(shared_op_queues_.size());
+    std::priority_queue<cursor_t, std::vector<cursor_t>, std::greater<cursor_t>> heap;
+    for (auto &queue : shared_op_queues_) {
+        if (queue->get_ops().empty())
+            continue;
+        heap.push({ queue->get_ops()[0].step,
+                    (queue->get_core() + num_cores - 1) % num_cores, 0, queue.get() });
+    }
+    while (!heap.empty()) {
+        cursor_t cursor = heap.top();
+        heap.pop();
+        std::vector<shared_cache_op_t> &ops = cursor.queue->get_ops();
+        // Apply this core's operations up to the next step boundary in one go.
+        size_t index = cursor.index;
+        for (; index < ops.size() && ops[index].step == cursor.step; ++index) {
+            const shared_cache_op_t &op = ops[index];
+            op.link->apply(op);
+        }
+        if (index < ops.size()) {
+            cursor.step = ops[index].step;
+            cursor.index = index;
+            heap.push(cursor);
+        }
+    }
+    for (auto &queue : shared_op_queues_)
+        queue->get_ops().clear();
+}
+
+std::string
+cache_simulator_t::simulate_memref(const memref_t &simref, int core_index)
+{
+    if (type_is_instr(simref.instr.type) ||
+        simref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
+        if (knobs_.verbose >= 3) {
+            std::cerr << "::" << simref.data.pid << "." << simref.data.tid << ":: "
+                      << " @" << (void *)simref.instr.addr << " instr x"
+                      << simref.instr.size << "\n";
+        }
+        l1_icaches_[core_index]->request(simref);
+    } else if (simref.data.type == TRACE_TYPE_READ ||
+               simref.data.type == TRACE_TYPE_WRITE ||
+               // We may potentially handle prefetches differently.
+               // TRACE_TYPE_PREFETCH_INSTR is handled above.
+               type_is_prefetch(simref.data.type)) {
+        if (knobs_.verbose >= 3) {
+            std::cerr << "::" << simref.data.pid << "." << simref.data.tid << ":: "
+                      << " @" << (void *)simref.data.pc << " "
+                      << trace_type_names[simref.data.type] << " "
+                      << (void *)simref.data.addr << " x" << simref.data.size << "\n";
+        }
+        l1_dcaches_[core_index]->request(simref);
+    } else if (simref.flush.type == TRACE_TYPE_INSTR_FLUSH) {
+        if (knobs_.verbose >= 3) {
+            std::cerr << "::" << simref.data.pid << "." << simref.data.tid << ":: "
+                      << " @" << (void *)simref.data.pc << " iflush "
+                      << (void *)simref.data.addr << " x" << simref.data.size << "\n";
+        }
+        l1_icaches_[core_index]->flush(simref);
+    } else if (simref.flush.type == TRACE_TYPE_DATA_FLUSH) {
+        if (knobs_.verbose >= 3) {
+            std::cerr << "::" << simref.data.pid << "." << simref.data.tid << ":: "
+                      << " @" << (void *)simref.data.pc << " dflush "
+                      << (void *)simref.data.addr << " x" << simref.data.size << "\n";
+        }
+        l1_dcaches_[core_index]->flush(simref);
+    } else if (simref.exit.type == TRACE_TYPE_THREAD_EXIT) {
+        handle_thread_exit(simref.exit.tid);
+        if (shard_type_ == SHARD_BY_THREAD)
+            last_thread_ = 0;
+    } else if (simref.marker.type == TRACE_TYPE_MARKER &&
+               simref.marker.marker_type == TRACE_MARKER_TYPE_CPU_ID) {
+        if (shard_type_ == SHARD_BY_THREAD)
+            last_thread_ = 0;
+    } else if (simref.marker.type == TRACE_TYPE_INSTR_NO_FETCH) {
+        // Just ignore.
+        if (knobs_.verbose >= 3) {
+            std::cerr << "::" << simref.data.pid << "." << simref.data.tid << ":: "
+                      << " @" << (void *)simref.instr.addr << " non-fetched instr x"
+                      << simref.instr.size << "\n";
+        }
+    } else {
+        return "Unhandled memref type " + std::to_string(simref.data.type);
+    }
+    return "";
+}
+
 prefetcher_t *
 cache_simulator_t::get_prefetcher(std::string prefetcher_name)
 {
     if (prefetcher_name == PREFETCH_POLICY_NEXTLINE) {
         return new prefetcher_t((int)knobs_.line_size);
     }
+    if (prefetcher_name == PREFETCH_POLICY_STRIDE) {
+        return new prefetcher_stride_t((int)knobs_.line_size,
+                                       (int)knobs_.prefetcher_table_entries,
+                                       (int)knobs_.prefetcher_degree);
+    }
+    if (prefetcher_name == PREFETCH_POLICY_STREAM) {
+        return new prefetcher_stream_t((int)knobs_.line_size,
+                                       (int)knobs_.prefetcher_table_entries,
+                                       (int)knobs_.prefetcher_degree);
+    }
+    if (prefetcher_name == PREFETCH_POLICY_SMS) {
+        return new prefetcher_sms_t((int)knobs_.line_size,
+                                    (int)knobs_.prefetcher_table_entries,
+                                    (int)knobs_.prefetcher_degree);
+    }
     if (prefetcher_name == PREFETCH_POLICY_CUSTOM) {
         assert(custom_prefetcher_factory_ != nullptr);
         return custom_prefetcher_factory_->create_prefetcher((int)knobs_.line_size);
@@ -579,6 +969,17 @@ cache_simulator_t::get_prefetcher(std::string prefetcher_name)
     return nullptr;
 }
 
+void
+cache_simulator_t::enable_prefetcher_stats()
+{
+    // Every cache sees the prefetches of the caches below it, so all of them
+    // report prefetch usefulness.
+    for (auto &cache_it : all_caches_) {
+        static_cast<cache_stats_t *>(cache_it.second->get_stats())
+            ->enable_prefetcher_stats(knobs_.prefetcher_late_distance);
+    }
+}
+
 // Return true if the number of warmup references have been executed or if
 // specified fraction of the llcaches_ has been loaded. Also return true if the
 // cache has already been warmed up. When there are multiple last level caches
@@ -655,6 +1056,10 @@ cache_simulator_t::print_results()
                   << ") stats:" << std::endl;
         caches_it.second->get_stats()->print_stats("    ");
     }
+    if (LL_sweep_ != nullptr) {
+        std::cerr << "LL sweep stats:" << std::endl;
+        LL_sweep_->print_sweep_stats("  ");
+    }
 
     if (knobs_.model_coherence) {
         snoop_filter_->print_stats();
@@ -687,7 +1092,7 @@ cache_simulator_t::get_cache_metric(metric_name_t metric, unsigned level, unsign
     }
 
     for (size_t i = 1; i < level; i++) {
-        caching_device_t *parent = curr_cache->get_parent();
+        caching_device_t *parent = get_parent_cache(curr_cache);
 
         if (parent == NULL) {
             return STATS_ERROR_WRONG_CACHE_LEVEL;
@@ -710,6 +1115,15 @@ cache_simulator_t::get_knobs() const
 }
 
 // Access snoop filter stats.
+int64_t
+cache_simulator_t::get_LL_sweep_metric(metric_name_t metric, int index) const
+{
+    if (LL_sweep_ == nullptr || index < 0 || index >= LL_sweep_->get_sweep_config_count())
+        return STATS_ERROR_NO_CACHE_STATS;
+    int64_t value = LL_sweep_->get_sweep_metric(index, metric);
+    return value < 0 ? STATS_ERROR_NO_CACHE_STATS : value;
+}
+
 int64_t
 cache_simulator_t::get_num_snooped_caches(void)
 {
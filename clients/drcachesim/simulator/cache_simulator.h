@@ -39,13 +39,19 @@
 #include <limits.h>
 #include <stdint.h>
 
+#include <condition_variable>
 #include <istream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "cache.h"
 #include "cache_simulator_create.h"
 #include "cache_stats.h"
+#include "cache_sweep.h"
+#include "parallel_cache_link.h"
 #include "simulator.h"
 #include "snoop_filter.h"
 
@@ -79,15 +85,43 @@ public:
                       prefetcher_factory_t *custom_prefetcher_factory = nullptr);
 
     virtual ~cache_simulator_t();
+    std::string
+    initialize_stream(memtrace_stream_t *serial_stream) override;
+    std::string
+    initialize_shard_type(shard_type_t shard_type) override;
     bool
     process_memref(const memref_t &memref) override;
     bool
     print_results() override;
 
+    // With the sim_parallel knob, each core's private caches are simulated on
+    // the analyzer worker thread for that core in -core_sharded mode.  Shared
+    // caches are updated in a deterministic order at periodic barriers across
+    // all cores: see parallel_cache_link.h.
+    bool
+    parallel_shard_supported() override;
+    void *
+    parallel_worker_init(int worker_index) override;
+    void *
+    parallel_shard_init_stream(int shard_index, void *worker_data,
+                               memtrace_stream_t *stream) override;
+    bool
+    parallel_shard_exit(void *shard_data) override;
+    bool
+    parallel_shard_memref(void *shard_data, const memref_t &memref) override;
+    std::string
+    parallel_shard_error(void *shard_data) override;
+    std::string
+    parallel_worker_exit(void *worker_data) override;
+
     int64_t
     get_cache_metric(metric_name_t metric, unsigned level, unsigned core = 0,
                      cache_split_t split = cache_split_t::DATA) const;
 
+    // Returns HITS or MISSES for the index-th configuration of the LL_sweep knob.
+    int64_t
+    get_LL_sweep_metric(metric_name_t metric, int index) const;
+
     // Access snoop filter stats for coherent caches.
     // These are not per-cache metrics so it doesn't make sense to access them
     // through get_cache_metric().
@@ -110,9 +144,45 @@ public:
     get_knobs() const;
 
 protected:
+    struct core_shard_data_t {
+        int core = INVALID_CORE_INDEX;
+        memtrace_stream_t *stream = nullptr;
+        int64_t last_cpu = -1;
+        std::vector<int64_t> cpus;
+        std::string error;
+    };
+
     prefetcher_t *
     get_prefetcher(std::string prefetcher_name);
 
+    // Turns on printing of hardware prefetcher statistics for every cache.
+    void
+    enable_prefetcher_stats();
+
+    // Sends one non-marker record to the given core's L1 caches.  Returns an
+    // empty string on success or an error message.
+    std::string
+    simulate_memref(const memref_t &simref, int core_index);
+
+    // Inserts the parallel_cache_link_t instances that separate private from
+    // shared simulation state.
+    std::string
+    init_parallel_sim();
+    // Returns the real parent of "cache", skipping any parallel_cache_link_t.
+    caching_device_t *
+    get_parent_cache(caching_device_t *cache) const;
+    // Called by each core every sim_parallel_batch records.  Waits for all active
+    // cores and then applies their queued shared operations.
+    void
+    sync_shared_caches();
+    // Removes "core" from the set of cores that sync_shared_caches() waits for.
+    void
+    leave_shared_caches(int core);
+    // Applies all queued shared operations in -core_serial order.
+    // The caller must hold shared_mutex_ or be the only running thread.
+    void
+    drain_shared_ops();
+
     cache_simulator_knobs_t knobs_;
 
     // Implement a set of ICaches and DCaches with pointer arrays.
@@ -130,12 +200,26 @@ protected:
     // This is a list of non-coherent caches for shared caches above snoop filter.
     std::unordered_map<std::string, cache_t *> non_coherent_caches_;
 
+    // The LLC when the LL_sweep knob is set, which also owns it through all_caches_.
+    cache_sweep_t *LL_sweep_ = nullptr;
+
     // Snoop filter tracks ownership of cache lines across private caches.
     snoop_filter_t *snoop_filter_ = nullptr;
 
     // Used to get prefetcher instances if the dataprefetcher knob is "custom".
     prefetcher_factory_t *custom_prefetcher_factory_ = nullptr;
 
+    // State for the sim_parallel knob.  The per-core vectors are indexed by core.
+    std::vector<std::unique_ptr<shared_cache_op_queue_t>> shared_op_queues_;
+    std::vector<std::unique_ptr<parallel_cache_link_t>> cache_links_;
+    std::unordered_map<caching_device_t *, caching_device_t *> link2target_;
+    std::vector<bool> core_active_;
+    std::mutex shared_mutex_;
+    std::condition_variable shared_cond_;
+    int shared_active_ = 0;
+    int shared_arrived_ = 0;
+    uint64_t shared_generation_ = 0;
+
 private:
     bool is_warmed_up_;
 };
@@ -62,15 +62,21 @@ struct cache_simulator_knobs_t {
         , LL_size(8 * 1024 * 1024)
         , LL_assoc(16)
         , LL_miss_file("")
+        , LL_sweep("")
         , model_coherence(false)
         , replace_policy("LRU")
         , data_prefetcher("nextline")
+        , prefetcher_table_entries(0)
+        , prefetcher_degree(0)
+        , prefetcher_late_distance(32)
         , skip_refs(0)
         , warmup_refs(0)
         , warmup_fraction(0.0)
         , sim_refs(1ULL << 63)
         , cpu_scheduling(false)
         , use_physical(false)
+        , sim_parallel(false)
+        , sim_parallel_batch(4096)
         , verbose(0)
     {
     }
@@ -83,15 +89,21 @@ struct cache_simulator_knobs_t {
     uint64_t LL_size;
     unsigned int LL_assoc;
     std::string LL_miss_file;
+    std::string LL_sweep;
     bool model_coherence;
     std::string replace_policy;
     std::string data_prefetcher;
+    unsigned int prefetcher_table_entries;
+    unsigned int prefetcher_degree;
+    unsigned int prefetcher_late_distance;
     uint64_t skip_refs;
     uint64_t warmup_refs;
     double warmup_fraction;
     uint64_t sim_refs;
     bool cpu_scheduling;
     bool use_physical;
+    bool sim_parallel;
+    uint64_t sim_parallel_batch;
     unsigned int verbose;
 };
 
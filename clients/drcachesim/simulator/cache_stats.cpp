@@ -41,6 +41,7 @@
 #include "caching_device_block.h"
 #include "caching_device_stats.h"
 #include "trace_entry.h"
+#include "utils.h"
 
 namespace dynamorio {
 namespace drmemtrace {
@@ -51,16 +52,34 @@ cache_stats_t::cache_stats_t(int block_size, const std::string &miss_file,
     , num_flushes_(0)
     , num_prefetch_hits_(0)
     , num_prefetch_misses_(0)
+    , num_prefetch_useful_(0)
+    , num_prefetch_late_(0)
+    , num_prefetch_unused_(0)
+    , report_prefetcher_stats_(false)
+    , prefetch_late_distance_(0)
+    , block_size_bits_(compute_log2(block_size))
 {
     stats_map_.emplace(metric_name_t::FLUSHES, num_flushes_);
     stats_map_.emplace(metric_name_t::PREFETCH_HITS, num_prefetch_hits_);
     stats_map_.emplace(metric_name_t::PREFETCH_MISSES, num_prefetch_misses_);
+    stats_map_.emplace(metric_name_t::PREFETCH_USEFUL, num_prefetch_useful_);
+    stats_map_.emplace(metric_name_t::PREFETCH_LATE, num_prefetch_late_);
+    stats_map_.emplace(metric_name_t::PREFETCH_UNUSED, num_prefetch_unused_);
+}
+
+void
+cache_stats_t::enable_prefetcher_stats(int64_t late_distance)
+{
+    report_prefetcher_stats_ = true;
+    prefetch_late_distance_ = late_distance;
 }
 
 void
 cache_stats_t::access(const memref_t &memref, bool hit,
                       caching_device_block_t *cache_block)
 {
+    if (report_prefetcher_stats_)
+        access_prefetched_line(memref, hit, cache_block);
     // handle prefetching requests
     if (type_is_prefetch(memref.data.type)) {
         if (hit)
@@ -77,6 +96,46 @@ cache_stats_t::access(const memref_t &memref, bool hit,
     }
 }
 
+void
+cache_stats_t::access_prefetched_line(const memref_t &memref, bool hit,
+                                      caching_device_block_t *cache_block)
+{
+    // The caching device clears the prefetched flag after a demand hit and sets it
+    // after inserting a hardware-prefetched line, so here it still describes the
+    // line that was hit or, on a miss, the victim line.
+    int64_t now = num_hits_ + num_misses_;
+    if (!hit) {
+        if (cache_block->prefetched_) {
+            num_prefetch_unused_++;
+            if (prefetch_late_distance_ > 0)
+                prefetch_time_.erase(cache_block->tag_);
+        }
+        if (prefetch_late_distance_ > 0) {
+            addr_t line = memref.data.addr >> block_size_bits_;
+            if (memref.data.type == TRACE_TYPE_HARDWARE_PREFETCH)
+                prefetch_time_[line] = now;
+            else if (!prefetch_time_.empty()) {
+                // Drop any stale entry for a prefetched line that was invalidated.
+                prefetch_time_.erase(line);
+            }
+        }
+        return;
+    }
+    if (!cache_block->prefetched_ || type_is_prefetch(memref.data.type))
+        return;
+    num_prefetch_useful_++;
+    if (prefetch_late_distance_ > 0) {
+        auto it = prefetch_time_.find(cache_block->tag_);
+        if (it != prefetch_time_.end()) {
+            // The use is the (now - issue time + 1)th demand access after the
+            // prefetch.
+            if (now - it->second < prefetch_late_distance_)
+                num_prefetch_late_++;
+            prefetch_time_.erase(it);
+        }
+    }
+}
+
 void
 cache_stats_t::flush(const memref_t &memref)
 {
@@ -99,6 +158,41 @@ cache_stats_t::print_counts(std::string prefix)
                   << "Prefetch misses:" << std::setw(20) << std::right
                   << num_prefetch_misses_ << std::endl;
     }
+    if (report_prefetcher_stats_ && num_prefetch_useful_ + num_prefetch_unused_ != 0) {
+        std::cerr << prefix << std::setw(18) << std::left
+                  << "Prefetch useful:" << std::setw(20) << std::right
+                  << num_prefetch_useful_ << std::endl;
+        if (prefetch_late_distance_ > 0) {
+            std::cerr << prefix << std::setw(18) << std::left
+                      << "Prefetch late:" << std::setw(20) << std::right
+                      << num_prefetch_late_ << std::endl;
+        }
+        std::cerr << prefix << std::setw(18) << std::left
+                  << "Prefetch unused:" << std::setw(20) << std::right
+                  << num_prefetch_unused_ << std::endl;
+    }
+}
+
+void
+cache_stats_t::print_rates(std::string prefix)
+{
+    caching_device_stats_t::print_rates(prefix);
+    if (report_prefetcher_stats_ && num_prefetch_useful_ + num_prefetch_unused_ != 0) {
+        // Accuracy only considers prefetched lines whose fate is known: those
+        // still resident and unused are not counted either way.
+        std::cerr << prefix << std::setw(18) << std::left
+                  << "Prefetch accuracy:" << std::setw(20) << std::fixed
+                  << std::setprecision(2) << std::right
+                  << ((float)num_prefetch_useful_ * 100 /
+                      (num_prefetch_useful_ + num_prefetch_unused_))
+                  << "%" << std::endl;
+        std::cerr << prefix << std::setw(18) << std::left
+                  << "Prefetch coverage:" << std::setw(20) << std::fixed
+                  << std::setprecision(2) << std::right
+                  << ((float)num_prefetch_useful_ * 100 /
+                      (num_prefetch_useful_ + num_misses_))
+                  << "%" << std::endl;
+    }
 }
 
 void
@@ -108,6 +202,10 @@ cache_stats_t::reset()
     num_flushes_ = 0;
     num_prefetch_hits_ = 0;
     num_prefetch_misses_ = 0;
+    num_prefetch_useful_ = 0;
+    num_prefetch_late_ = 0;
+    num_prefetch_unused_ = 0;
+    prefetch_time_.clear();
 }
 
 } // namespace drmemtrace
@@ -41,6 +41,7 @@
 #include <string>
 
 #include "caching_device_stats.h"
+#include "flat_hash_map.h"
 #include "memref.h"
 
 namespace dynamorio {
@@ -64,18 +65,47 @@ public:
     void
     reset() override;
 
+    // Turns on counting and printing of the hardware prefetcher usefulness,
+    // lateness, accuracy, and coverage statistics, which are off by default to keep
+    // the default output and speed unchanged.  A prefetched line whose first demand
+    // use comes within "late_distance" demand accesses to this cache after the
+    // prefetch is counted as late; a late_distance of 0 disables lateness tracking.
+    void
+    enable_prefetcher_stats(int64_t late_distance);
+
 protected:
     // In addition to caching_device_stats_t::print_counts,
     // cache_stats_t::print_counts prints stats for flushes and
     // prefetching requests.
     void
     print_counts(std::string prefix) override;
+    // In addition to caching_device_stats_t::print_rates, prints the hardware
+    // prefetcher accuracy and coverage when enabled.
+    void
+    print_rates(std::string prefix) override;
+
+    // Updates the hardware prefetcher statistics for this access.
+    void
+    access_prefetched_line(const memref_t &memref, bool hit,
+                           caching_device_block_t *cache_block);
 
     // A CPU cache handles flushes and prefetching requests
     // as well as regular memory accesses.
     int64_t num_flushes_;
     int64_t num_prefetch_hits_;
     int64_t num_prefetch_misses_;
+
+    // Hardware prefetcher statistics.  A prefetched line is useful when a demand
+    // access hits it and unused when it is evicted before any demand use.
+    int64_t num_prefetch_useful_;
+    int64_t num_prefetch_late_;
+    int64_t num_prefetch_unused_;
+    bool report_prefetcher_stats_;
+    int64_t prefetch_late_distance_;
+    int block_size_bits_;
+    // The demand access count when each outstanding prefetched line was brought
+    // in, keyed by line address.  Only maintained when lateness is tracked.
+    flat_hash_map_t<addr_t, int64_t> prefetch_time_;
 };
 
 } // namespace drmemtrace
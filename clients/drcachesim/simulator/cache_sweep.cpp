@@ -0,0 +1,235 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "cache_sweep.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cache.h"
+#include "cache_stats.h"
+#include "caching_device_block.h"
+#include "caching_device_stats.h"
+#include "create_cache_replacement_policy.h"
+#include "memref.h"
+#include "options.h"
+#include "trace_entry.h"
+#include "utils.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+bool
+cache_sweep_t::add_sweep_config(int associativity, int64_t total_size,
+                                const std::string &replace_policy)
+{
+    int64_t block_size = get_block_size();
+    if (associativity < 1 || total_size % (block_size * associativity) != 0)
+        return false;
+    int64_t num_sets = total_size / block_size / associativity;
+    if (!IS_POWER_OF_2(num_sets))
+        return false;
+    sweep_config_t config;
+    config.associativity = associativity;
+    config.total_size = total_size;
+    config.replace_policy = replace_policy;
+    if (replace_policy == REPLACE_POLICY_LRU) {
+        auto it = std::find_if(stack_groups_.begin(), stack_groups_.end(),
+                               [num_sets](const lru_stack_group_t &group) {
+                                   return group.num_sets == num_sets;
+                               });
+        if (it == stack_groups_.end()) {
+            stack_groups_.emplace_back();
+            it = stack_groups_.end() - 1;
+            it->num_sets = static_cast<int>(num_sets);
+        }
+        config.stack_group = static_cast<int>(it - stack_groups_.begin());
+        if (associativity > it->max_associativity) {
+            // Widen every set's stack.  This is only done before any requests.
+            it->max_associativity = associativity;
+            it->stack.assign(static_cast<size_t>(num_sets) * associativity,
+                             TAG_INVALID);
+            it->depth_hits.assign(associativity, 0);
+        }
+    } else {
+        config.stats.reset(new cache_stats_t(static_cast<int>(block_size)));
+        config.cache.reset(new cache_t(get_name()));
+        std::unique_ptr<cache_replacement_policy_t> policy =
+            create_cache_replacement_policy(replace_policy, static_cast<int>(num_sets),
+                                            associativity);
+        if (!policy ||
+            !config.cache->init(associativity, block_size, total_size, nullptr,
+                                config.stats.get(), std::move(policy)))
+            return false;
+    }
+    configs_.push_back(std::move(config));
+    return true;
+}
+
+int
+cache_sweep_t::access_stack(lru_stack_group_t &group, addr_t tag)
+{
+    addr_t *stack = &group.stack[(tag & (group.num_sets - 1)) * group.max_associativity];
+    int depth = 0;
+    while (depth < group.max_associativity && stack[depth] != tag &&
+           stack[depth] != TAG_INVALID)
+        ++depth;
+    int result = depth;
+    if (depth == group.max_associativity) {
+        // A miss that evicts the least recently used line.
+        --depth;
+    } else if (stack[depth] == TAG_INVALID) {
+        // A miss that fills an empty way.
+        result = group.max_associativity;
+    }
+    std::copy_backward(stack, stack + depth, stack + depth + 1);
+    stack[0] = tag;
+    return result;
+}
+
+void
+cache_sweep_t::flush_stack(lru_stack_group_t &group, addr_t tag)
+{
+    addr_t *stack = &group.stack[(tag & (group.num_sets - 1)) * group.max_associativity];
+    addr_t *end = stack + group.max_associativity;
+    addr_t *found = std::find(stack, end, tag);
+    if (found == end)
+        return;
+    std::copy(found + 1, end, found);
+    *(end - 1) = TAG_INVALID;
+}
+
+void
+cache_sweep_t::request(const memref_t &memref)
+{
+    if (!stack_groups_.empty()) {
+        bool is_demand = !type_is_prefetch(memref.data.type);
+        addr_t tag = compute_tag(memref.data.addr);
+        addr_t final_tag = compute_tag(memref.data.addr + memref.data.size - 1);
+        for (; tag <= final_tag; ++tag) {
+            for (lru_stack_group_t &group : stack_groups_) {
+                int depth = access_stack(group, tag);
+                if (!is_demand)
+                    continue;
+                ++group.accesses;
+                if (depth < group.max_associativity)
+                    ++group.depth_hits[depth];
+            }
+        }
+    }
+    for (sweep_config_t &config : configs_) {
+        if (config.cache)
+            config.cache->request(memref);
+    }
+    cache_t::request(memref);
+}
+
+void
+cache_sweep_t::flush(const memref_t &memref)
+{
+    if (!stack_groups_.empty()) {
+        addr_t tag = compute_tag(memref.flush.addr);
+        addr_t final_tag = compute_tag(memref.flush.addr + memref.flush.size - 1);
+        for (; tag <= final_tag; ++tag) {
+            for (lru_stack_group_t &group : stack_groups_)
+                flush_stack(group, tag);
+        }
+    }
+    for (sweep_config_t &config : configs_) {
+        if (config.cache)
+            config.cache->flush(memref);
+    }
+    cache_t::flush(memref);
+}
+
+int64_t
+cache_sweep_t::get_sweep_metric(int index, metric_name_t metric) const
+{
+    const sweep_config_t &config = configs_[index];
+    if (metric != metric_name_t::HITS && metric != metric_name_t::MISSES)
+        return -1;
+    if (config.cache)
+        return config.stats->get_metric(metric);
+    const lru_stack_group_t &group = stack_groups_[config.stack_group];
+    int64_t hits = 0;
+    for (int depth = 0; depth < config.associativity; ++depth)
+        hits += group.depth_hits[depth];
+    return metric == metric_name_t::HITS ? hits : group.accesses - hits;
+}
+
+void
+cache_sweep_t::reset_sweep_stats()
+{
+    for (lru_stack_group_t &group : stack_groups_) {
+        std::fill(group.depth_hits.begin(), group.depth_hits.end(), 0);
+        group.accesses = 0;
+    }
+    for (sweep_config_t &config : configs_) {
+        if (config.stats)
+            config.stats->reset();
+    }
+}
+
+void
+cache_sweep_t::print_sweep_stats(const std::string &prefix) const
+{
+    std::cerr.imbue(std::locale("")); // Add commas, at least for my locale.
+    for (int i = 0; i < get_sweep_config_count(); ++i) {
+        const sweep_config_t &config = configs_[i];
+        int64_t hits = get_sweep_metric(i, metric_name_t::HITS);
+        int64_t misses = get_sweep_metric(i, metric_name_t::MISSES);
+        std::cerr << prefix << "size=" << config.total_size
+                  << ", assoc=" << config.associativity << ", "
+                  << config.replace_policy << ":" << std::endl;
+        std::cerr << prefix << "  " << std::setw(18) << std::left << "Hits:"
+                  << std::setw(20) << std::right << hits << std::endl;
+        std::cerr << prefix << "  " << std::setw(18) << std::left << "Misses:"
+                  << std::setw(20) << std::right << misses << std::endl;
+        if (hits + misses > 0) {
+            std::cerr << prefix << "  " << std::setw(18) << std::left
+                      << "Miss rate:" << std::setw(20) << std::fixed
+                      << std::setprecision(2) << std::right
+                      << ((float)misses * 100 / (hits + misses)) << "%" << std::endl;
+        }
+    }
+    std::cerr.imbue(std::locale("C")); // Reset to avoid affecting later prints.
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,131 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* cache_sweep: a cache that also simulates other configurations of itself.
+ */
+
+#ifndef _CACHE_SWEEP_H_
+#define _CACHE_SWEEP_H_ 1
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cache.h"
+#include "cache_stats.h"
+#include "caching_device_stats.h"
+#include "memref.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// A cache that, in addition to simulating itself, simulates a list of alternative
+// sizes and associativities on the same stream of requests and flushes, reporting
+// separate hit and miss counts for each.  This replaces one full simulation per
+// configuration with a single pass when sweeping the last-level cache, whose
+// request stream does not depend on its own contents as long as it is not inclusive
+// or exclusive of its children.  Invalidations are not applied to the alternative
+// configurations.
+//
+// With the LRU policy, configurations with the same number of sets share one
+// per-set LRU stack: by the inclusion property of LRU, an access hits in every
+// configuration whose associativity exceeds the line's depth in the stack, so one
+// stack update serves all of them.  Other policies get a full cache_t per
+// configuration.
+class cache_sweep_t : public cache_t {
+public:
+    explicit cache_sweep_t(const std::string &name = "cache")
+        : cache_t(name)
+    {
+    }
+    // Adds a configuration using the given replacement policy.  Must be called
+    // after init().  Returns false if the geometry is invalid.
+    bool
+    add_sweep_config(int associativity, int64_t total_size,
+                     const std::string &replace_policy);
+    void
+    request(const memref_t &memref) override;
+    void
+    flush(const memref_t &memref) override;
+
+    int
+    get_sweep_config_count() const
+    {
+        return static_cast<int>(configs_.size());
+    }
+    // Returns HITS or MISSES for the given configuration, or -1 for other metrics.
+    int64_t
+    get_sweep_metric(int index, metric_name_t metric) const;
+    void
+    reset_sweep_stats();
+    void
+    print_sweep_stats(const std::string &prefix) const;
+
+protected:
+    // The configurations that share an LRU stack.
+    struct lru_stack_group_t {
+        int num_sets = 0;
+        int max_associativity = 0;
+        // The tags of each set, most recently used first, with the sets stored
+        // contiguously.  Unused entries hold TAG_INVALID.
+        std::vector<addr_t> stack;
+        // The number of demand accesses that hit at each stack depth.
+        std::vector<int64_t> depth_hits;
+        int64_t accesses = 0;
+    };
+    struct sweep_config_t {
+        int associativity = 0;
+        int64_t total_size = 0;
+        std::string replace_policy;
+        // Either stack_group is set or cache and its stats are.
+        int stack_group = -1;
+        std::unique_ptr<cache_stats_t> stats;
+        std::unique_ptr<cache_t> cache;
+    };
+
+    // Returns the depth of tag in the group's stack before this access, or the
+    // maximum associativity if it was not present, and moves it to the top.
+    int
+    access_stack(lru_stack_group_t &group, addr_t tag);
+    void
+    flush_stack(lru_stack_group_t &group, addr_t tag);
+
+    std::vector<lru_stack_group_t> stack_groups_;
+    std::vector<sweep_config_t> configs_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _CACHE_SWEEP_H_ */
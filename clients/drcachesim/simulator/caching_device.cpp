@@ -127,6 +127,7 @@ caching_device_t::init(int associativity, int64_t block_size, int64_t num_blocks
     coherent_cache_ = coherent_cache;
     blocks_ = new caching_device_block_t *[static_cast<size_t>(num_blocks_)];
     init_blocks();
+    tags_.assign(static_cast<size_t>(num_blocks_), TAG_INVALID);
 
     last_tag_ = TAG_INVALID; // sentinel
 
@@ -162,12 +163,12 @@ caching_device_t::find_caching_device_block(addr_t tag)
         return it->second;
     }
     int block_idx = compute_block_idx(tag);
-    for (int way = 0; way < associativity_; ++way) {
-        caching_device_block_t &block = get_caching_device_block(block_idx, way);
-        if (block.tag_ == tag)
-            return std::make_pair(&block, way);
-    }
-    return std::make_pair(nullptr, 0);
+    int way = find_tag_in_set(&tags_[block_idx], associativity_, tag);
+    if (way < 0)
+        return std::make_pair(nullptr, 0);
+    caching_device_block_t &block = get_caching_device_block(block_idx, way);
+    assert(block.tag_ == tag);
+    return std::make_pair(&block, way);
 }
 
 void
@@ -190,6 +191,7 @@ caching_device_t::request(const memref_t &memref_in)
             &get_caching_device_block(last_block_idx_, last_way_);
         assert(tag != TAG_INVALID && tag == cache_block->tag_);
         record_access_stats(memref_in, true /*hit*/, cache_block);
+        set_replacement_context(memref_in, tag);
         access_update(last_block_idx_, last_way_);
         return;
     }
@@ -203,6 +205,7 @@ caching_device_t::request(const memref_t &memref_in)
         if (tag + 1 <= final_tag)
             memref.data.size = ((tag + 1) << block_size_bits_) - memref.data.addr;
 
+        set_replacement_context(memref, tag);
         auto block_way = find_caching_device_block(tag);
         if (block_way.first != nullptr) {
             // Access is a hit.
@@ -256,6 +259,8 @@ caching_device_t::request(const memref_t &memref_in)
                 continue;
             }
             insert_tag(tag, (memref.data.type == TRACE_TYPE_WRITE), way, block_idx);
+            if (memref.data.type == TRACE_TYPE_HARDWARE_PREFETCH)
+                get_caching_device_block(block_idx, way).prefetched_ = true;
         }
 
         access_update(block_idx, way);
@@ -295,10 +300,9 @@ caching_device_t::replace_which_way(int block_idx)
 int
 caching_device_t::get_next_way_to_replace(const int block_idx) const
 {
-    for (int way = 0; way < associativity_; ++way) {
-        if (get_caching_device_block(block_idx, way).tag_ == TAG_INVALID)
-            return way;
-    }
+    int way = find_tag_in_set(&tags_[block_idx], associativity_, TAG_INVALID);
+    if (way >= 0)
+        return way;
     return replacement_policy_->get_next_way_to_replace(compute_set_index(block_idx));
 }
 
@@ -307,7 +311,7 @@ caching_device_t::invalidate(addr_t tag, invalidation_type_t invalidation_type)
 {
     auto block_way = find_caching_device_block(tag);
     if (block_way.first != nullptr) {
-        invalidate_caching_device_block(block_way.first);
+        invalidate_caching_device_block(block_way.first, block_way.second);
         loaded_blocks_--;
         stats_->invalidate(invalidation_type);
         // Invalidate last_tag_ if it was this tag.
@@ -403,6 +407,7 @@ caching_device_t::propagate_eviction(addr_t tag, const caching_device_t *request
     // or inclusive caches see no change.
     if (is_exclusive()) {
         int block_idx = compute_block_idx(tag);
+        replacement_policy_->set_access_context(tag, /*pc=*/0, /*is_prefetch=*/false);
         int way = replace_which_way(block_idx);
         // Insert line and update snoop filter if appropriate.
         insert_tag(tag, /*is_write=*/false, way, block_idx);
@@ -455,6 +460,9 @@ caching_device_t::record_access_stats(const memref_t &memref, bool hit,
             up->stats_->child_access(memref, hit, cache_block);
     } else if (parent_ != nullptr)
         parent_->stats_->child_access(memref, hit, cache_block);
+    // The first demand hit consumes a prefetched line.
+    if (hit && cache_block->prefetched_ && !type_is_prefetch(memref.data.type))
+        cache_block->prefetched_ = false;
 }
 
 // Inserts a tag into the cache, updating the snoop filter and dealing with
@@ -50,6 +50,7 @@
 #include "caching_device_block.h"
 #include "caching_device_stats.h"
 #include "memref.h"
+#include "tag_lookup.h"
 #include "trace_entry.h"
 
 namespace dynamorio {
@@ -87,11 +88,11 @@ public:
     request(const memref_t &memref);
     virtual void
     invalidate(addr_t tag, invalidation_type_t invalidation_type_);
-    bool
+    virtual bool
     contains_tag(addr_t tag);
-    void
+    virtual void
     propagate_eviction(addr_t tag, const caching_device_t *requester);
-    void
+    virtual void
     propagate_write(addr_t tag, const caching_device_t *requester);
 
     caching_device_stats_t *
@@ -219,6 +220,15 @@ public:
 protected:
     virtual void
     access_update(int block_idx, int way);
+    // Tells the replacement policy which line and instruction the following
+    // updates are for.
+    inline void
+    set_replacement_context(const memref_t &memref, addr_t tag)
+    {
+        replacement_policy_->set_access_context(
+            tag, type_is_instr(memref.instr.type) ? memref.instr.addr : memref.data.pc,
+            type_is_prefetch(memref.data.type));
+    }
     virtual int
     replace_which_way(int block_idx);
     virtual int
@@ -253,12 +263,16 @@ protected:
         return *(blocks_[block_idx + way]);
     }
 
+    // Block tags must only be changed through these two functions so that
+    // tags_ and tag2block stay in sync with the blocks.
     inline void
-    invalidate_caching_device_block(caching_device_block_t *block)
+    invalidate_caching_device_block(caching_device_block_t *block, int way)
     {
         if (use_tag2block_table_)
             tag2block.erase(block->tag_);
+        tags_[compute_block_idx(block->tag_) + way] = TAG_INVALID;
         block->tag_ = TAG_INVALID;
+        block->prefetched_ = false;
     }
 
     inline void
@@ -269,7 +283,9 @@ protected:
                 tag2block.erase(block->tag_);
             tag2block[new_tag] = std::make_pair(block, way);
         }
+        tags_[compute_block_idx(new_tag) + way] = new_tag;
         block->tag_ = new_tag;
+        block->prefetched_ = false;
     }
 
     // Returns the block (and its way) whose tag equals `tag`.
@@ -304,6 +320,10 @@ protected:
     // an extended block class which has its own member variables cannot be indexed
     // correctly by base class pointers.
     caching_device_block_t **blocks_;
+    // A copy of each block's tag_ in the same order as blocks_.  Keeping the
+    // tags of a set contiguous lets find_tag_in_set() compare several ways at
+    // once without touching the blocks themselves.
+    std::vector<addr_t> tags_;
     int64_t blocks_per_way_;
     // Optimization fields for fast bit operations
     int blocks_per_way_mask_;
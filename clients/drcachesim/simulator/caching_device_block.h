@@ -55,6 +55,7 @@ public:
     caching_device_block_t()
         : tag_(TAG_INVALID)
         , counter_(0)
+        , prefetched_(false)
     {
     }
     // Destructor must be virtual and default is not.
@@ -68,6 +69,10 @@ public:
     // A 32-bit counter should be sufficient but we may want to revisit.
     // We already have stdint.h so we can reinstate int64_t easily.
     int counter_; // for use by replacement policies
+
+    // Set while the block holds a line brought in by a hardware prefetch that
+    // no demand access has used yet.  This fits in the padding after counter_.
+    bool prefetched_;
 };
 
 } // namespace drmemtrace
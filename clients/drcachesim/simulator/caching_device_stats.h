@@ -76,7 +76,10 @@ enum class metric_name_t {
     EXCLUSIVE_INVALIDATES,
     PREFETCH_HITS,
     PREFETCH_MISSES,
-    FLUSHES
+    FLUSHES,
+    PREFETCH_USEFUL,
+    PREFETCH_LATE,
+    PREFETCH_UNUSED
 };
 
 struct bound {
@@ -38,8 +38,11 @@
 #include "cache_replacement_policy.h"
 #include "policy_bit_plru.h"
 #include "policy_fifo.h"
+#include "policy_hawkeye.h"
 #include "policy_lfu.h"
 #include "policy_lru.h"
+#include "policy_rrip.h"
+#include "policy_ship.h"
 #include "options.h"
 
 namespace dynamorio {
@@ -63,6 +66,25 @@ create_cache_replacement_policy(const std::string &policy, int num_sets,
         return std::unique_ptr<policy_bit_plru_t>(
             new policy_bit_plru_t(num_sets, associativity));
     }
+    if (policy == REPLACE_POLICY_SRRIP) {
+        return std::unique_ptr<policy_rrip_t>(
+            new policy_rrip_t(num_sets, associativity, rrip_mode_t::SRRIP));
+    }
+    if (policy == REPLACE_POLICY_BRRIP) {
+        return std::unique_ptr<policy_rrip_t>(
+            new policy_rrip_t(num_sets, associativity, rrip_mode_t::BRRIP));
+    }
+    if (policy == REPLACE_POLICY_DRRIP) {
+        return std::unique_ptr<policy_rrip_t>(
+            new policy_rrip_t(num_sets, associativity, rrip_mode_t::DRRIP));
+    }
+    if (policy == REPLACE_POLICY_SHIP) {
+        return std::unique_ptr<policy_ship_t>(new policy_ship_t(num_sets, associativity));
+    }
+    if (policy == REPLACE_POLICY_HAWKEYE) {
+        return std::unique_ptr<policy_hawkeye_t>(
+            new policy_hawkeye_t(num_sets, associativity));
+    }
     return nullptr;
 }
 
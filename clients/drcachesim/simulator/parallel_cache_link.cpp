@@ -0,0 +1,184 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "parallel_cache_link.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cache.h"
+#include "caching_device.h"
+#include "caching_device_block.h"
+#include "caching_device_stats.h"
+#include "create_cache_replacement_policy.h"
+#include "memref.h"
+#include "trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+namespace {
+
+// The private child walks up its parent chain updating child_access() stats,
+// which for a link lands here and is deferred like every other shared update.
+class link_stats_t : public caching_device_stats_t {
+public:
+    link_stats_t(int block_size, parallel_cache_link_t *link,
+                 shared_cache_op_queue_t *queue)
+        : caching_device_stats_t("", block_size)
+        , link_(link)
+        , queue_(queue)
+    {
+    }
+    void
+    child_access(const memref_t &memref, bool hit,
+                 caching_device_block_t *cache_block) override
+    {
+        shared_cache_op_t &op = queue_->append(shared_cache_op_t::CHILD_ACCESS);
+        op.link = link_;
+        op.flag = hit;
+        op.memref = memref;
+    }
+
+private:
+    parallel_cache_link_t *link_;
+    shared_cache_op_queue_t *queue_;
+};
+
+} // namespace
+
+parallel_cache_link_t::parallel_cache_link_t(caching_device_t *child,
+                                             caching_device_t *target,
+                                             shared_cache_op_queue_t *queue)
+    : cache_t("link:" + child->get_name())
+    , child_(child)
+    , target_(target)
+    , queue_(queue)
+{
+    int block_size = static_cast<int>(child->get_block_size());
+    link_stats_.reset(new link_stats_t(block_size, this, queue));
+    // The single block is never used: every lookup is forwarded.
+    bool res = init(1, block_size, block_size, nullptr, link_stats_.get(),
+                    create_cache_replacement_policy("", 1, 1));
+    assert(res);
+    (void)res;
+    // Splice ourselves in between the child and the target.  We keep our own
+    // parent pointer null so that the child's upward walks stop here.
+    const std::vector<caching_device_t *> &siblings = target->get_children();
+    bool target_knows_child =
+        std::find(siblings.begin(), siblings.end(), child) != siblings.end();
+    child->set_parent(this);
+    if (target_knows_child) {
+        // Take the child's place in the target's list of children.
+        set_parent(target);
+        parent_ = nullptr;
+    }
+}
+
+void
+parallel_cache_link_t::request(const memref_t &memref)
+{
+    shared_cache_op_t &op = queue_->append(shared_cache_op_t::REQUEST);
+    op.link = this;
+    op.memref = memref;
+}
+
+void
+parallel_cache_link_t::flush(const memref_t &memref)
+{
+    shared_cache_op_t &op = queue_->append(shared_cache_op_t::FLUSH);
+    op.link = this;
+    op.memref = memref;
+}
+
+void
+parallel_cache_link_t::propagate_eviction(addr_t tag, const caching_device_t *requester)
+{
+    shared_cache_op_t &op = queue_->append(shared_cache_op_t::PROPAGATE_EVICTION);
+    op.link = this;
+    op.tag = tag;
+}
+
+void
+parallel_cache_link_t::propagate_write(addr_t tag, const caching_device_t *requester)
+{
+    shared_cache_op_t &op = queue_->append(shared_cache_op_t::PROPAGATE_WRITE);
+    op.link = this;
+    op.tag = tag;
+}
+
+void
+parallel_cache_link_t::invalidate(addr_t tag, invalidation_type_t invalidation_type)
+{
+    child_->invalidate(tag, invalidation_type);
+}
+
+bool
+parallel_cache_link_t::contains_tag(addr_t tag)
+{
+    return child_->contains_tag(tag);
+}
+
+void
+parallel_cache_link_t::apply(const shared_cache_op_t &op)
+{
+    switch (op.type) {
+    case shared_cache_op_t::REQUEST: target_->request(op.memref); break;
+    case shared_cache_op_t::CHILD_ACCESS:
+        // Mirror caching_device_t::record_access_stats(): hits are propagated all
+        // the way up while misses only go one level up.
+        target_->get_stats()->child_access(op.memref, op.flag, nullptr);
+        if (op.flag) {
+            for (caching_device_t *up = target_->get_parent(); up != nullptr;
+                 up = up->get_parent())
+                up->get_stats()->child_access(op.memref, op.flag, nullptr);
+        }
+        break;
+    // A link is only ever spliced in under a cache_t so this cast is safe.
+    case shared_cache_op_t::FLUSH:
+        static_cast<cache_t *>(target_)->flush(op.memref);
+        break;
+    case shared_cache_op_t::PROPAGATE_EVICTION:
+        target_->propagate_eviction(op.tag, this);
+        break;
+    case shared_cache_op_t::PROPAGATE_WRITE:
+        target_->propagate_write(op.tag, this);
+        break;
+    }
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
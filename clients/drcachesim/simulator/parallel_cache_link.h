@@ -0,0 +1,183 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* parallel_cache_link: decouples per-core private caches from the shared levels
+ * of the hierarchy so that each core can be simulated on its own thread.
+ */
+
+#ifndef _PARALLEL_CACHE_LINK_H_
+#define _PARALLEL_CACHE_LINK_H_ 1
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "cache.h"
+#include "caching_device.h"
+#include "caching_device_stats.h"
+#include "memref.h"
+#include "trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+class parallel_cache_link_t;
+
+// One operation issued by a core's private caches against a shared cache.  Each
+// is tagged with the core-local record ordinal ("step") at which it was issued so
+// that the operations from all cores can be replayed in the same global order
+// that -core_serial would produce.
+struct shared_cache_op_t {
+    enum op_type_t {
+        REQUEST,
+        CHILD_ACCESS,
+        FLUSH,
+        PROPAGATE_EVICTION,
+        PROPAGATE_WRITE,
+    };
+    uint64_t step;
+    op_type_t type;
+    // The hit flag for CHILD_ACCESS.
+    bool flag;
+    addr_t tag;
+    // The device the operation is applied to.
+    parallel_cache_link_t *link;
+    memref_t memref;
+};
+
+// The ordered list of pending shared operations for one core.  Only the thread
+// simulating the core appends to it; it is drained while all cores are paused.
+class shared_cache_op_queue_t {
+public:
+    explicit shared_cache_op_queue_t(int core)
+        : core_(core)
+    {
+    }
+    int
+    get_core() const
+    {
+        return core_;
+    }
+    // The step is advanced once per record presented to the core.
+    void
+    advance_step()
+    {
+        ++step_;
+    }
+    uint64_t
+    get_step() const
+    {
+        return step_;
+    }
+    shared_cache_op_t &
+    append(shared_cache_op_t::op_type_t type)
+    {
+        ops_.emplace_back();
+        shared_cache_op_t &op = ops_.back();
+        op.step = step_;
+        op.type = type;
+        op.flag = false;
+        op.tag = TAG_INVALID;
+        op.link = nullptr;
+        return op;
+    }
+    std::vector<shared_cache_op_t> &
+    get_ops()
+    {
+        return ops_;
+    }
+
+private:
+    int core_;
+    uint64_t step_ = 0;
+    std::vector<shared_cache_op_t> ops_;
+};
+
+// Sits between a private cache and its shared parent.  The private cache sees
+// this as its parent; every upward request, flush, stats update, and eviction or
+// write notification is recorded in the core's queue and applied to the real
+// parent (the "target") by apply().  Downward traffic from the target
+// (invalidations and contains_tag() queries) is only issued while applying queued
+// operations, when all cores are paused, and is forwarded directly to the private
+// child.
+class parallel_cache_link_t : public cache_t {
+public:
+    parallel_cache_link_t(caching_device_t *child, caching_device_t *target,
+                          shared_cache_op_queue_t *queue);
+    void
+    request(const memref_t &memref) override;
+    void
+    flush(const memref_t &memref) override;
+    void
+    invalidate(addr_t tag, invalidation_type_t invalidation_type) override;
+    bool
+    contains_tag(addr_t tag) override;
+    void
+    propagate_eviction(addr_t tag, const caching_device_t *requester) override;
+    void
+    propagate_write(addr_t tag, const caching_device_t *requester) override;
+    bool
+    is_inclusive() const override
+    {
+        return target_->is_inclusive();
+    }
+    bool
+    is_exclusive() const override
+    {
+        return target_->is_exclusive();
+    }
+    caching_device_t *
+    get_target() const
+    {
+        return target_;
+    }
+    caching_device_t *
+    get_child() const
+    {
+        return child_;
+    }
+    // Applies an operation queued by this link to the target.
+    void
+    apply(const shared_cache_op_t &op);
+
+protected:
+    caching_device_t *child_;
+    caching_device_t *target_;
+    shared_cache_op_queue_t *queue_;
+    std::unique_ptr<caching_device_stats_t> link_stats_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _PARALLEL_CACHE_LINK_H_ */
@@ -0,0 +1,191 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "policy_hawkeye.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cache_replacement_policy.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// 3-bit RRPVs: averse lines sit at the maximum and friendly lines age up to one
+// below it.
+static constexpr int HAWKEYE_RRPV_MAX = 7;
+// The predictor has this many 3-bit counters, predicting friendly from the midpoint.
+static constexpr int HAWKEYE_PREDICTOR_ENTRIES = 8 * 1024;
+static constexpr int HAWKEYE_COUNTER_MAX = 7;
+static constexpr int HAWKEYE_FRIENDLY_THRESHOLD = 4;
+// The number of sets OPTgen samples.
+static constexpr int HAWKEYE_SAMPLED_SETS = 64;
+// OPTgen's window, in accesses to the set, as a multiple of the associativity.
+static constexpr int HAWKEYE_WINDOW_PER_WAY = 8;
+
+policy_hawkeye_t::policy_hawkeye_t(int num_sets, int associativity)
+    : cache_replacement_policy_t(num_sets, associativity)
+    , lines_(static_cast<size_t>(num_sets) * associativity)
+    , predictor_(HAWKEYE_PREDICTOR_ENTRIES, HAWKEYE_FRIENDLY_THRESHOLD)
+    , sample_stride_(std::max(num_sets / HAWKEYE_SAMPLED_SETS, 1))
+    , window_(static_cast<uint64_t>(HAWKEYE_WINDOW_PER_WAY) * associativity)
+    , pending_insert_(-1)
+{
+    for (line_t &line : lines_)
+        line.rrpv = HAWKEYE_RRPV_MAX;
+    sampled_sets_.resize((num_sets + sample_stride_ - 1) / sample_stride_);
+    for (sampled_set_t &sampled : sampled_sets_)
+        sampled.occupancy.resize(window_, 0);
+}
+
+uint16_t
+policy_hawkeye_t::get_signature(addr_t pc) const
+{
+    return static_cast<uint16_t>((pc ^ (pc >> 13)) % HAWKEYE_PREDICTOR_ENTRIES);
+}
+
+bool
+policy_hawkeye_t::is_friendly(uint16_t signature) const
+{
+    return predictor_[signature] >= HAWKEYE_FRIENDLY_THRESHOLD;
+}
+
+void
+policy_hawkeye_t::train(uint16_t signature, bool opt_hit)
+{
+    int &counter = predictor_[signature];
+    if (opt_hit && counter < HAWKEYE_COUNTER_MAX)
+        counter++;
+    else if (!opt_hit && counter > 0)
+        counter--;
+}
+
+void
+policy_hawkeye_t::optgen_update(sampled_set_t &sampled, addr_t tag, uint16_t signature)
+{
+    uint64_t now = sampled.time++;
+    sampled.occupancy[now % window_] = 0;
+    auto it = sampled.history.find(tag);
+    if (it != sampled.history.end()) {
+        uint64_t last = it->second.first;
+        // OPT would have hit if the line fit in the cache for its whole liveness
+        // interval, i.e., the set was never full between the two accesses.
+        bool opt_hit = now - last < window_;
+        for (uint64_t t = last; opt_hit && t < now; ++t) {
+            if (sampled.occupancy[t % window_] >= associativity_)
+                opt_hit = false;
+        }
+        if (opt_hit) {
+            for (uint64_t t = last; t < now; ++t)
+                sampled.occupancy[t % window_]++;
+        }
+        train(it->second.second, opt_hit);
+    }
+    sampled.history[tag] = std::make_pair(now, signature);
+    // Forget lines that have fallen out of the window.  They will be treated as
+    // first accesses, which OPT would also have missed on.
+    if (sampled.history.size() > 4 * window_) {
+        for (auto entry = sampled.history.begin(); entry != sampled.history.end();) {
+            if (now - entry->second.first >= window_)
+                entry = sampled.history.erase(entry);
+            else
+                ++entry;
+        }
+    }
+}
+
+void
+policy_hawkeye_t::access_update(int set_idx, int way)
+{
+    int idx = set_idx * associativity_ + way;
+    uint16_t signature = get_signature(access_pc_);
+    if (set_idx % sample_stride_ == 0)
+        optgen_update(sampled_sets_[set_idx / sample_stride_], access_tag_, signature);
+    line_t *set = &lines_[set_idx * associativity_];
+    bool friendly = is_friendly(signature);
+    if (idx == pending_insert_) {
+        pending_insert_ = -1;
+        if (friendly) {
+            for (int i = 0; i < associativity_; ++i) {
+                if (i != way && set[i].rrpv < HAWKEYE_RRPV_MAX - 1)
+                    set[i].rrpv++;
+            }
+        }
+    }
+    set[way].rrpv = friendly ? 0 : HAWKEYE_RRPV_MAX;
+    set[way].signature = signature;
+}
+
+void
+policy_hawkeye_t::eviction_update(int set_idx, int way)
+{
+    line_t &line = lines_[set_idx * associativity_ + way];
+    // Evicting a line predicted to be friendly means the prediction was wrong.
+    if (line.rrpv < HAWKEYE_RRPV_MAX)
+        train(line.signature, false);
+    line.rrpv = HAWKEYE_RRPV_MAX;
+    pending_insert_ = set_idx * associativity_ + way;
+}
+
+void
+policy_hawkeye_t::invalidation_update(int set_idx, int way)
+{
+    lines_[set_idx * associativity_ + way].rrpv = HAWKEYE_RRPV_MAX;
+}
+
+int
+policy_hawkeye_t::get_next_way_to_replace(int set_idx) const
+{
+    // Evict an averse line if there is one, else the oldest friendly line.
+    const line_t *set = &lines_[set_idx * associativity_];
+    int max_way = 0;
+    for (int i = 0; i < associativity_; ++i) {
+        if (set[i].rrpv == HAWKEYE_RRPV_MAX)
+            return i;
+        if (set[i].rrpv > set[max_way].rrpv)
+            max_way = i;
+    }
+    return max_way;
+}
+
+std::string
+policy_hawkeye_t::get_name() const
+{
+    return "HAWKEYE";
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
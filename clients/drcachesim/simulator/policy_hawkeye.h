@@ -0,0 +1,115 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#ifndef _HAWKEYE_H_
+#define _HAWKEYE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cache_replacement_policy.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/**
+ * A Hawkeye replacement policy.
+ *
+ * On a sample of the sets, OPTgen reconstructs which past accesses Belady's optimal
+ * policy would have hit on, and trains a table of saturating counters indexed by a
+ * hash of the PC that last touched each line: up on an OPT hit and down on an OPT
+ * miss.  Lines accessed by a PC predicted to be cache-friendly get an RRPV of 0, and
+ * inserting one ages the other friendly lines of the set.  Lines from cache-averse
+ * PCs get the maximum RRPV and are evicted first.  Evicting a friendly line detrains
+ * its PC.
+ */
+class policy_hawkeye_t : public cache_replacement_policy_t {
+public:
+    policy_hawkeye_t(int num_sets, int associativity);
+    void
+    access_update(int set_idx, int way) override;
+    void
+    eviction_update(int set_idx, int way) override;
+    void
+    invalidation_update(int set_idx, int way) override;
+    int
+    get_next_way_to_replace(int set_idx) const override;
+    std::string
+    get_name() const override;
+
+    ~policy_hawkeye_t() override = default;
+
+private:
+    struct line_t {
+        int rrpv = 0;
+        uint16_t signature = 0;
+    };
+    // OPTgen's view of one sampled set.
+    struct sampled_set_t {
+        // The time of the next access to the set.
+        uint64_t time = 0;
+        // For each time in the window, the number of lines OPT keeps cached.
+        std::vector<int> occupancy;
+        // The last access time and signature of each line.
+        std::unordered_map<addr_t, std::pair<uint64_t, uint16_t>> history;
+    };
+
+    uint16_t
+    get_signature(addr_t pc) const;
+    bool
+    is_friendly(uint16_t signature) const;
+    void
+    train(uint16_t signature, bool opt_hit);
+    void
+    optgen_update(sampled_set_t &sampled, addr_t tag, uint16_t signature);
+
+    // The RRPV and last signature of each way's line.
+    std::vector<line_t> lines_;
+    // The PC-indexed predictor counters.
+    std::vector<int> predictor_;
+    std::vector<sampled_set_t> sampled_sets_;
+    // Every sample_stride_'th set is sampled.
+    int sample_stride_;
+    // OPTgen looks this many accesses to a set into the past.
+    uint64_t window_;
+    // The way whose eviction_update() is awaiting the access_update() for the
+    // line inserted in its place, or -1.
+    int pending_insert_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif // _HAWKEYE_H_
@@ -42,40 +42,38 @@ namespace drmemtrace {
 
 policy_lfu_t::policy_lfu_t(int num_sets, int associativity)
     : cache_replacement_policy_t(num_sets, associativity)
+    , access_counts_(static_cast<size_t>(num_sets) * associativity, 0)
 {
-    access_counts_.reserve(num_sets);
-    for (int i = 0; i < num_sets; ++i) {
-        access_counts_.emplace_back(associativity, 0);
-    }
 }
 
 void
 policy_lfu_t::access_update(int set_idx, int way)
 {
-    access_counts_[set_idx][way]++;
+    get_set_counts(set_idx)[way]++;
 }
 
 void
 policy_lfu_t::eviction_update(int set_idx, int way)
 {
-    access_counts_[set_idx][way] = 0;
+    get_set_counts(set_idx)[way] = 0;
 }
 
 void
 policy_lfu_t::invalidation_update(int set_idx, int way)
 {
-    access_counts_[set_idx][way] = 0;
+    get_set_counts(set_idx)[way] = 0;
 }
 
 int
 policy_lfu_t::get_next_way_to_replace(int set_idx) const
 {
     // Find the way with the minimum frequency counter.
-    int min_freq = access_counts_[set_idx][0];
+    const int *counts = get_set_counts(set_idx);
+    int min_freq = counts[0];
     int min_way = 0;
     for (int i = 1; i < associativity_; ++i) {
-        if (access_counts_[set_idx][i] < min_freq) {
-            min_freq = access_counts_[set_idx][i];
+        if (counts[i] < min_freq) {
+            min_freq = counts[i];
             min_way = i;
         }
     }
@@ -62,8 +62,20 @@ public:
     ~policy_lfu_t() override = default;
 
 private:
-    // Frequency counters for each way in each line.
-    std::vector<std::vector<int>> access_counts_;
+    int *
+    get_set_counts(int set_idx)
+    {
+        return &access_counts_[static_cast<size_t>(set_idx) * associativity_];
+    }
+    const int *
+    get_set_counts(int set_idx) const
+    {
+        return &access_counts_[static_cast<size_t>(set_idx) * associativity_];
+    }
+
+    // Frequency counters for each way, with the ways of each set stored
+    // contiguously.
+    std::vector<int> access_counts_;
 };
 
 } // namespace drmemtrace
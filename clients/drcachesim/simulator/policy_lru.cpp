@@ -42,28 +42,25 @@ namespace drmemtrace {
 
 policy_lru_t::policy_lru_t(int num_sets, int associativity)
     : cache_replacement_policy_t(num_sets, associativity)
+    , lru_counters_(static_cast<size_t>(num_sets) * associativity, 1)
 {
-    // Initialize the LRU list for each set.
-    lru_counters_.reserve(num_sets);
-    for (int i = 0; i < num_sets; ++i) {
-        lru_counters_.emplace_back(associativity, 1);
-    }
 }
 
 void
 policy_lru_t::access_update(int set_idx, int way)
 {
-    int count = lru_counters_[set_idx][way];
+    int *counters = get_set_counters(set_idx);
+    int count = counters[way];
     // Optimization: return early if it is a repeated access.
     if (count == 0)
         return;
     // We inc all the counters that are not larger than count for LRU.
     for (int i = 0; i < associativity_; ++i) {
-        if (i != way && lru_counters_[set_idx][i] <= count)
-            lru_counters_[set_idx][i]++;
+        if (i != way && counters[i] <= count)
+            counters[i]++;
     }
     // Clear the counter for LRU.
-    lru_counters_[set_idx][way] = 0;
+    counters[way] = 0;
 }
 
 void
@@ -76,20 +73,21 @@ policy_lru_t::eviction_update(int set_idx, int way)
 void
 policy_lru_t::invalidation_update(int set_idx, int way)
 {
-    int max_counter =
-        *std::max_element(lru_counters_[set_idx].begin(), lru_counters_[set_idx].end());
-    lru_counters_[set_idx][way] = max_counter + 1;
+    int *counters = get_set_counters(set_idx);
+    int max_counter = *std::max_element(counters, counters + associativity_);
+    counters[way] = max_counter + 1;
 }
 
 int
 policy_lru_t::get_next_way_to_replace(int set_idx) const
 {
     // We implement LRU by picking the slot with the largest counter value.
+    const int *counters = get_set_counters(set_idx);
     int max_counter = 0;
     int max_way = 0;
     for (int way = 0; way < associativity_; ++way) {
-        if (lru_counters_[set_idx][way] > max_counter) {
-            max_counter = lru_counters_[set_idx][way];
+        if (counters[way] > max_counter) {
+            max_counter = counters[way];
             max_way = way;
         }
     }
@@ -64,8 +64,19 @@ public:
     ~policy_lru_t() override = default;
 
 private:
-    // LRU list for each set.
-    std::vector<std::vector<int>> lru_counters_;
+    int *
+    get_set_counters(int set_idx)
+    {
+        return &lru_counters_[static_cast<size_t>(set_idx) * associativity_];
+    }
+    const int *
+    get_set_counters(int set_idx) const
+    {
+        return &lru_counters_[static_cast<size_t>(set_idx) * associativity_];
+    }
+
+    // LRU counters for each way, with the ways of each set stored contiguously.
+    std::vector<int> lru_counters_;
 };
 
 } // namespace drmemtrace
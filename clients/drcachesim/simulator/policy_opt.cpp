@@ -0,0 +1,111 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "policy_opt.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cache_replacement_policy.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+policy_opt_t::policy_opt_t(int num_sets, int associativity,
+                           std::vector<uint64_t> next_uses)
+    : cache_replacement_policy_t(num_sets, associativity)
+    , next_uses_(std::move(next_uses))
+    , position_(0)
+    , way_next_use_(static_cast<size_t>(num_sets) * associativity, NEVER)
+{
+}
+
+std::vector<uint64_t>
+policy_opt_t::compute_next_uses(const std::vector<addr_t> &tags)
+{
+    std::vector<uint64_t> next_uses(tags.size(), NEVER);
+    std::unordered_map<addr_t, uint64_t> last_seen;
+    for (uint64_t i = tags.size(); i > 0; --i) {
+        auto it = last_seen.find(tags[i - 1]);
+        if (it != last_seen.end()) {
+            next_uses[i - 1] = it->second;
+            it->second = i - 1;
+        } else
+            last_seen.emplace(tags[i - 1], i - 1);
+    }
+    return next_uses;
+}
+
+void
+policy_opt_t::access_update(int set_idx, int way)
+{
+    way_next_use_[set_idx * associativity_ + way] =
+        position_ < next_uses_.size() ? next_uses_[position_] : NEVER;
+    ++position_;
+}
+
+void
+policy_opt_t::eviction_update(int set_idx, int way)
+{
+    // Nothing to update, when the way is accessed we will update it.
+}
+
+void
+policy_opt_t::invalidation_update(int set_idx, int way)
+{
+    way_next_use_[set_idx * associativity_ + way] = NEVER;
+}
+
+int
+policy_opt_t::get_next_way_to_replace(int set_idx) const
+{
+    const uint64_t *next_use = &way_next_use_[set_idx * associativity_];
+    int max_way = 0;
+    for (int i = 1; i < associativity_; ++i) {
+        if (next_use[i] > next_use[max_way])
+            max_way = i;
+    }
+    return max_way;
+}
+
+std::string
+policy_opt_t::get_name() const
+{
+    return "OPT";
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
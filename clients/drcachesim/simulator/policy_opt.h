@@ -0,0 +1,94 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#ifndef _OPT_H_
+#define _OPT_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "cache_replacement_policy.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/**
+ * Belady's optimal (OPT) replacement policy, as an oracle giving a bound on what
+ * any replacement policy could achieve.
+ *
+ * The line whose next use lies furthest in the future is evicted.  Since that
+ * requires knowing the future, this policy is not available through
+ * create_cache_replacement_policy(): it is constructed with the position of the next
+ * access to the same line for every access the cache will see, as computed by
+ * compute_next_uses() from the cache's complete access sequence.  Each
+ * access_update() call consumes one position, so the cache must see exactly that
+ * sequence, one line per request, without exclusive-cache hits, which skip the
+ * update.
+ */
+class policy_opt_t : public cache_replacement_policy_t {
+public:
+    /// Marks an access whose line is never accessed again.
+    static constexpr uint64_t NEVER = UINT64_MAX;
+
+    policy_opt_t(int num_sets, int associativity, std::vector<uint64_t> next_uses);
+    void
+    access_update(int set_idx, int way) override;
+    void
+    eviction_update(int set_idx, int way) override;
+    void
+    invalidation_update(int set_idx, int way) override;
+    int
+    get_next_way_to_replace(int set_idx) const override;
+    std::string
+    get_name() const override;
+
+    ~policy_opt_t() override = default;
+
+    /// Returns, for each access in a sequence of line tags, the index of the next
+    /// access to the same line, or NEVER.
+    static std::vector<uint64_t>
+    compute_next_uses(const std::vector<addr_t> &tags);
+
+private:
+    std::vector<uint64_t> next_uses_;
+    // The index of the access the next access_update() is for.
+    uint64_t position_;
+    // The next use of each way's line, with the ways of each set stored contiguously.
+    std::vector<uint64_t> way_next_use_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif // _OPT_H_
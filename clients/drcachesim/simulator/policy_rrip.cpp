@@ -0,0 +1,168 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "policy_rrip.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "cache_replacement_policy.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// One in this many BRRIP insertions uses the long rather than the distant interval.
+static constexpr int BRRIP_LONG_INTERVAL_PERIOD = 32;
+// The number of leader sets for each of SRRIP and BRRIP in DRRIP.  Small caches
+// get fewer so that at least half of the sets follow the winner.
+static constexpr int DRRIP_LEADER_SETS = 32;
+static constexpr int DRRIP_MIN_LEADER_STRIDE = 4;
+// DRRIP uses a 10-bit saturating selector.
+static constexpr int DRRIP_PSEL_MAX = 1023;
+
+policy_rrip_t::policy_rrip_t(int num_sets, int associativity, rrip_mode_t mode,
+                             int rrpv_bits)
+    : cache_replacement_policy_t(num_sets, associativity)
+    , mode_(mode)
+    , rrpv_max_((1 << rrpv_bits) - 1)
+    , rrpv_(static_cast<size_t>(num_sets) * associativity, rrpv_max_)
+    , pending_insert_(-1)
+    , psel_(DRRIP_PSEL_MAX / 2)
+    , bimodal_count_(0)
+    , leader_stride_(std::max(num_sets / DRRIP_LEADER_SETS, DRRIP_MIN_LEADER_STRIDE))
+{
+}
+
+bool
+policy_rrip_t::is_srrip_leader(int set_idx) const
+{
+    return set_idx % leader_stride_ == 0;
+}
+
+bool
+policy_rrip_t::is_brrip_leader(int set_idx) const
+{
+    return set_idx % leader_stride_ == 1;
+}
+
+int
+policy_rrip_t::get_bimodal_rrpv()
+{
+    if (++bimodal_count_ >= BRRIP_LONG_INTERVAL_PERIOD) {
+        bimodal_count_ = 0;
+        return rrpv_max_ - 1;
+    }
+    return rrpv_max_;
+}
+
+int
+policy_rrip_t::get_insertion_rrpv(int set_idx, int way)
+{
+    bool bimodal = mode_ == rrip_mode_t::BRRIP;
+    if (mode_ == rrip_mode_t::DRRIP) {
+        if (is_srrip_leader(set_idx))
+            bimodal = false;
+        else if (is_brrip_leader(set_idx))
+            bimodal = true;
+        else
+            bimodal = psel_ > DRRIP_PSEL_MAX / 2;
+    }
+    return bimodal ? get_bimodal_rrpv() : rrpv_max_ - 1;
+}
+
+void
+policy_rrip_t::access_update(int set_idx, int way)
+{
+    int idx = set_idx * associativity_ + way;
+    if (idx == pending_insert_) {
+        pending_insert_ = -1;
+        rrpv_[idx] = get_insertion_rrpv(set_idx, way);
+        return;
+    }
+    hit_update(set_idx, way);
+    rrpv_[idx] = 0;
+}
+
+void
+policy_rrip_t::eviction_update(int set_idx, int way)
+{
+    int *rrpv = &rrpv_[set_idx * associativity_];
+    victim_update(set_idx, way);
+    // Age the set as if we had incremented every RRPV until the victim's reached
+    // the maximum.  Invalid ways are already at the maximum.
+    int age = rrpv_max_ - rrpv[way];
+    if (age > 0) {
+        for (int i = 0; i < associativity_; ++i)
+            rrpv[i] = std::min(rrpv[i] + age, rrpv_max_);
+    }
+    // An eviction means a miss, which the leader sets use to vote.
+    if (mode_ == rrip_mode_t::DRRIP) {
+        if (is_srrip_leader(set_idx))
+            psel_ = std::min(psel_ + 1, DRRIP_PSEL_MAX);
+        else if (is_brrip_leader(set_idx))
+            psel_ = std::max(psel_ - 1, 0);
+    }
+    pending_insert_ = set_idx * associativity_ + way;
+}
+
+void
+policy_rrip_t::invalidation_update(int set_idx, int way)
+{
+    rrpv_[set_idx * associativity_ + way] = rrpv_max_;
+}
+
+int
+policy_rrip_t::get_next_way_to_replace(int set_idx) const
+{
+    const int *rrpv = &rrpv_[set_idx * associativity_];
+    int max_way = 0;
+    for (int i = 1; i < associativity_; ++i) {
+        if (rrpv[i] > rrpv[max_way])
+            max_way = i;
+    }
+    return max_way;
+}
+
+std::string
+policy_rrip_t::get_name() const
+{
+    switch (mode_) {
+    case rrip_mode_t::SRRIP: return "SRRIP";
+    case rrip_mode_t::BRRIP: return "BRRIP";
+    case rrip_mode_t::DRRIP: return "DRRIP";
+    }
+    return "";
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,124 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#ifndef _RRIP_H_
+#define _RRIP_H_
+
+#include <string>
+#include <vector>
+
+#include "cache_replacement_policy.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/**
+ * The insertion variants of re-reference interval prediction.
+ */
+enum class rrip_mode_t {
+    /// Static RRIP: new lines are inserted with a long re-reference interval.
+    SRRIP,
+    /// Bimodal RRIP: new lines are mostly inserted with a distant re-reference
+    /// interval, which keeps scans from flushing the cache.
+    BRRIP,
+    /// Dynamic RRIP: set dueling between SRRIP and BRRIP picks the insertion
+    /// policy for the remaining sets.
+    DRRIP,
+};
+
+/**
+ * A re-reference interval prediction (RRIP) replacement policy.
+ *
+ * Each way holds a re-reference prediction value (RRPV).  Hits set it to 0, the
+ * way with the largest RRPV is evicted, and on eviction the whole set is aged so
+ * that the victim's RRPV reaches the maximum.  The mode selects the RRPV given to
+ * newly inserted lines.
+ */
+class policy_rrip_t : public cache_replacement_policy_t {
+public:
+    policy_rrip_t(int num_sets, int associativity, rrip_mode_t mode,
+                  int rrpv_bits = 2);
+    void
+    access_update(int set_idx, int way) override;
+    void
+    eviction_update(int set_idx, int way) override;
+    void
+    invalidation_update(int set_idx, int way) override;
+    int
+    get_next_way_to_replace(int set_idx) const override;
+    std::string
+    get_name() const override;
+
+    ~policy_rrip_t() override = default;
+
+protected:
+    // Returns the RRPV for a line being inserted into the given way.
+    virtual int
+    get_insertion_rrpv(int set_idx, int way);
+    // Called on a hit to the given way, before its RRPV is reset.
+    virtual void
+    hit_update(int set_idx, int way)
+    {
+    }
+    // Called when the line in the given way is about to be evicted.
+    virtual void
+    victim_update(int set_idx, int way)
+    {
+    }
+
+    int
+    get_bimodal_rrpv();
+    bool
+    is_srrip_leader(int set_idx) const;
+    bool
+    is_brrip_leader(int set_idx) const;
+
+    rrip_mode_t mode_;
+    int rrpv_max_;
+    // The RRPV of each way, with the ways of each set stored contiguously.
+    std::vector<int> rrpv_;
+    // The way whose eviction_update() is awaiting the access_update() for the
+    // line inserted in its place, or -1.
+    int pending_insert_;
+    // The set dueling selector: larger values mean SRRIP leaders miss more.
+    int psel_;
+    // Counts bimodal insertions.
+    int bimodal_count_;
+    // Sets are split into groups of this many, each with one leader set for
+    // each of SRRIP and BRRIP.
+    int leader_stride_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif // _RRIP_H_
@@ -0,0 +1,100 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "policy_ship.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "policy_rrip.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// The signature history counter table has this many 3-bit counters.
+static constexpr int SHIP_SHCT_ENTRIES = 16 * 1024;
+static constexpr int SHIP_COUNTER_MAX = 7;
+
+policy_ship_t::policy_ship_t(int num_sets, int associativity)
+    : policy_rrip_t(num_sets, associativity, rrip_mode_t::SRRIP)
+    , shct_(SHIP_SHCT_ENTRIES, 1)
+    , lines_(static_cast<size_t>(num_sets) * associativity)
+{
+}
+
+int
+policy_ship_t::get_insertion_rrpv(int set_idx, int way)
+{
+    line_t &line = lines_[set_idx * associativity_ + way];
+    line.signature =
+        static_cast<uint16_t>((access_pc_ ^ (access_pc_ >> 14)) % SHIP_SHCT_ENTRIES);
+    line.reused = false;
+    line.valid = true;
+    return shct_[line.signature] == 0 ? rrpv_max_ : rrpv_max_ - 1;
+}
+
+void
+policy_ship_t::hit_update(int set_idx, int way)
+{
+    line_t &line = lines_[set_idx * associativity_ + way];
+    line.reused = true;
+    if (shct_[line.signature] < SHIP_COUNTER_MAX)
+        shct_[line.signature]++;
+}
+
+void
+policy_ship_t::victim_update(int set_idx, int way)
+{
+    line_t &line = lines_[set_idx * associativity_ + way];
+    if (line.valid && !line.reused && shct_[line.signature] > 0)
+        shct_[line.signature]--;
+    line.valid = false;
+}
+
+void
+policy_ship_t::invalidation_update(int set_idx, int way)
+{
+    policy_rrip_t::invalidation_update(set_idx, way);
+    // An invalidation says nothing about reuse, so we do not train on it.
+    lines_[set_idx * associativity_ + way].valid = false;
+}
+
+std::string
+policy_ship_t::get_name() const
+{
+    return "SHIP";
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,89 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#ifndef _SHIP_H_
+#define _SHIP_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "policy_rrip.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/**
+ * A signature-based hit predictor (SHiP) replacement policy.
+ *
+ * This is SRRIP whose insertion RRPV is predicted from the PC of the access that
+ * brought the line in.  A table of saturating counters indexed by a hash of that PC
+ * is incremented when a line it inserted is hit and decremented when such a line is
+ * evicted without ever being hit.  Lines whose PC's counter is zero are inserted with
+ * a distant re-reference interval.
+ */
+class policy_ship_t : public policy_rrip_t {
+public:
+    policy_ship_t(int num_sets, int associativity);
+    void
+    invalidation_update(int set_idx, int way) override;
+    std::string
+    get_name() const override;
+
+    ~policy_ship_t() override = default;
+
+protected:
+    int
+    get_insertion_rrpv(int set_idx, int way) override;
+    void
+    hit_update(int set_idx, int way) override;
+    void
+    victim_update(int set_idx, int way) override;
+
+private:
+    struct line_t {
+        uint16_t signature = 0;
+        bool reused = false;
+        bool valid = false;
+    };
+
+    // The signature history counter table.
+    std::vector<int> shct_;
+    // The signature and outcome of each way's line.
+    std::vector<line_t> lines_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif // _SHIP_H_
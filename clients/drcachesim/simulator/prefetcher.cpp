@@ -38,11 +38,14 @@
 #include "memref.h"
 #include "caching_device.h"
 #include "trace_entry.h"
+#include "utils.h"
+
 namespace dynamorio {
 namespace drmemtrace {
 
 prefetcher_t::prefetcher_t(int block_size)
     : block_size_(block_size)
+    , block_size_bits_(compute_log2(block_size))
 {
     // Nothing else to do.
 }
@@ -59,5 +62,17 @@ prefetcher_t::prefetch(caching_device_t *cache, const memref_t &memref_in,
         cache->request(memref);
     }
 }
+
+void
+prefetcher_t::issue_prefetch(caching_device_t *cache, const memref_t &memref_in,
+                             addr_t line)
+{
+    memref_t memref = memref_in;
+    memref.data.addr = line << block_size_bits_;
+    memref.data.size = block_size_;
+    memref.data.type = TRACE_TYPE_HARDWARE_PREFETCH;
+    cache->request(memref);
+}
+
 } // namespace drmemtrace
 } // namespace dynamorio
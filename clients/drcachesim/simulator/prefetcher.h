@@ -57,7 +57,13 @@ public:
     prefetch(caching_device_t *cache, const memref_t &memref, bool missed);
 
 protected:
+    // Issues a hardware prefetch to "cache" of the line with address
+    // "line" << log2(block_size), taking the remaining fields from "memref".
+    void
+    issue_prefetch(caching_device_t *cache, const memref_t &memref, addr_t line);
+
     int block_size_;
+    int block_size_bits_;
 };
 
 class prefetcher_factory_t {
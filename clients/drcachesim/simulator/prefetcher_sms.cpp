@@ -0,0 +1,126 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* prefetcher_sms: a spatial memory streaming prefetcher.
+ */
+
+#include "prefetcher_sms.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "caching_device.h"
+#include "memref.h"
+#include "prefetcher.h"
+#include "utils.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// Regions cover this many bytes, limited to 64 lines so a footprint fits in a
+// uint64_t and to at least one line.
+static constexpr int SMS_REGION_SIZE = 2048;
+static constexpr int SMS_MAX_REGION_LINES = 64;
+
+prefetcher_sms_t::prefetcher_sms_t(int block_size, int table_entries, int degree)
+    : prefetcher_t(block_size)
+    , generations_(ACCUMULATION_TABLE_ENTRIES)
+    , patterns_(table_entries > 0 ? table_entries : DEFAULT_TABLE_ENTRIES)
+    , degree_(degree > 0 ? degree : DEFAULT_DEGREE)
+    , region_lines_(std::min(std::max(SMS_REGION_SIZE / block_size, 1),
+                             SMS_MAX_REGION_LINES))
+    , region_shift_(compute_log2(region_lines_))
+    , timestamp_(0)
+{
+    if (degree_ == 0)
+        degree_ = region_lines_;
+}
+
+prefetcher_sms_t::pattern_t &
+prefetcher_sms_t::lookup_pattern(addr_t pc, int offset)
+{
+    addr_t hash = (pc ^ (pc >> 16)) * region_lines_ + offset;
+    return patterns_[hash % patterns_.size()];
+}
+
+void
+prefetcher_sms_t::prefetch(caching_device_t *cache, const memref_t &memref,
+                           bool missed)
+{
+    addr_t line = memref.data.addr >> block_size_bits_;
+    addr_t region = line >> region_shift_;
+    int offset = static_cast<int>(line & (region_lines_ - 1));
+    ++timestamp_;
+    generation_t *lru = &generations_[0];
+    for (generation_t &generation : generations_) {
+        if (generation.valid && generation.region == region) {
+            generation.footprint |= 1ULL << offset;
+            generation.last_use = timestamp_;
+            return;
+        }
+        // Unused entries have a last_use of 0 and so are picked first.
+        if (generation.last_use < lru->last_use)
+            lru = &generation;
+    }
+    // This is a trigger access.  End the least recently used generation by
+    // recording its footprint, and start a new one for this region.
+    if (lru->valid) {
+        pattern_t &pattern = lookup_pattern(lru->pc, lru->offset);
+        pattern.pc = lru->pc;
+        pattern.offset = lru->offset;
+        pattern.footprint = lru->footprint;
+        pattern.valid = true;
+    }
+    lru->region = region;
+    lru->pc = memref.data.pc;
+    lru->offset = offset;
+    lru->footprint = 1ULL << offset;
+    lru->last_use = timestamp_;
+    lru->valid = true;
+
+    const pattern_t &pattern = lookup_pattern(memref.data.pc, offset);
+    if (!pattern.valid || pattern.pc != memref.data.pc || pattern.offset != offset)
+        return;
+    int issued = 0;
+    for (int i = 1; i < region_lines_ && issued < degree_; ++i) {
+        int target = (offset + i) & (region_lines_ - 1);
+        if ((pattern.footprint & (1ULL << target)) == 0)
+            continue;
+        issue_prefetch(cache, memref, (region << region_shift_) + target);
+        ++issued;
+    }
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,106 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* prefetcher_sms: a spatial memory streaming prefetcher.
+ */
+
+#ifndef _PREFETCHER_SMS_H_
+#define _PREFETCHER_SMS_H_ 1
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "caching_device.h"
+#include "memref.h"
+#include "prefetcher.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/**
+ * A spatial memory streaming (SMS) prefetcher.
+ *
+ * Memory is divided into 2K regions.  The first access to a region that is not
+ * being tracked (the trigger) starts a generation in a small LRU accumulation
+ * table, which records a bit for every line of the region touched until the
+ * generation is evicted from that table.  The resulting footprint is then stored
+ * in a direct-mapped pattern history table indexed by the trigger's PC and its
+ * line offset within the region.  A later trigger with the same PC and offset
+ * prefetches the lines of the stored footprint, up to "degree" of them, nearest
+ * following lines first.
+ */
+class prefetcher_sms_t : public prefetcher_t {
+public:
+    static constexpr int DEFAULT_TABLE_ENTRIES = 2048;
+    // The default degree of 0 prefetches the whole footprint.
+    static constexpr int DEFAULT_DEGREE = 0;
+    // The number of generations tracked at once.
+    static constexpr int ACCUMULATION_TABLE_ENTRIES = 32;
+
+    // A table_entries of 0 selects the default.  The table_entries value sizes the
+    // pattern history table.
+    prefetcher_sms_t(int block_size, int table_entries, int degree);
+    void
+    prefetch(caching_device_t *cache, const memref_t &memref, bool missed) override;
+
+private:
+    struct generation_t {
+        addr_t region = 0;
+        addr_t pc = 0;
+        int offset = 0;
+        uint64_t footprint = 0;
+        uint64_t last_use = 0;
+        bool valid = false;
+    };
+    struct pattern_t {
+        addr_t pc = 0;
+        int offset = 0;
+        uint64_t footprint = 0;
+        bool valid = false;
+    };
+
+    pattern_t &
+    lookup_pattern(addr_t pc, int offset);
+
+    std::vector<generation_t> generations_;
+    std::vector<pattern_t> patterns_;
+    int degree_;
+    int region_lines_;
+    int region_shift_;
+    uint64_t timestamp_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _PREFETCHER_SMS_H_ */
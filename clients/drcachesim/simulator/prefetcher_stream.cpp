@@ -0,0 +1,126 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* prefetcher_stream: a stream prefetcher that follows ascending and descending
+ * runs of lines within a page.
+ */
+
+#include "prefetcher_stream.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "caching_device.h"
+#include "memref.h"
+#include "prefetcher.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// Streams are tracked within pages of this size.
+static constexpr int STREAM_PAGE_BITS = 12;
+// The number of same-direction steps before a stream starts prefetching.
+static constexpr int STREAM_CONFIDENCE_THRESHOLD = 2;
+
+prefetcher_stream_t::prefetcher_stream_t(int block_size, int table_entries, int degree)
+    : prefetcher_t(block_size)
+    , streams_(table_entries > 0 ? table_entries : DEFAULT_TABLE_ENTRIES)
+    , degree_(degree > 0 ? degree : DEFAULT_DEGREE)
+    , page_shift_(block_size_bits_ < STREAM_PAGE_BITS
+                      ? STREAM_PAGE_BITS - block_size_bits_
+                      : 0)
+    , timestamp_(0)
+{
+}
+
+void
+prefetcher_stream_t::prefetch(caching_device_t *cache, const memref_t &memref,
+                              bool missed)
+{
+    addr_t line = memref.data.addr >> block_size_bits_;
+    addr_t page = line >> page_shift_;
+    ++timestamp_;
+    stream_t *stream = nullptr;
+    stream_t *lru = &streams_[0];
+    for (stream_t &candidate : streams_) {
+        if (candidate.valid && candidate.page == page) {
+            stream = &candidate;
+            break;
+        }
+        // Unused entries have a last_use of 0 and so are picked first.
+        if (candidate.last_use < lru->last_use)
+            lru = &candidate;
+    }
+    if (stream == nullptr) {
+        // Only misses start new streams so that hits cannot thrash the table.
+        if (!missed)
+            return;
+        lru->page = page;
+        lru->last_line = line;
+        lru->prefetched_line = line;
+        lru->direction = 0;
+        lru->confidence = 0;
+        lru->last_use = timestamp_;
+        lru->valid = true;
+        return;
+    }
+    stream->last_use = timestamp_;
+    if (line == stream->last_line)
+        return;
+    int direction = line > stream->last_line ? 1 : -1;
+    stream->last_line = line;
+    if (direction == stream->direction) {
+        if (stream->confidence < STREAM_CONFIDENCE_THRESHOLD)
+            stream->confidence++;
+    } else {
+        stream->direction = direction;
+        stream->confidence = 1;
+        stream->prefetched_line = line;
+    }
+    if (stream->confidence < STREAM_CONFIDENCE_THRESHOLD)
+        return;
+    // Never re-prefetch lines behind the current access.
+    if (static_cast<int64_t>(stream->prefetched_line - line) * direction < 0)
+        stream->prefetched_line = line;
+    while (true) {
+        addr_t next = stream->prefetched_line + direction;
+        if (static_cast<int64_t>(next - line) * direction > degree_ ||
+            (next >> page_shift_) != page)
+            break;
+        issue_prefetch(cache, memref, next);
+        stream->prefetched_line = next;
+    }
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,97 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* prefetcher_stride: a PC-indexed stride prefetcher.
+ */
+
+#include "prefetcher_stride.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "caching_device.h"
+#include "memref.h"
+#include "prefetcher.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// The confidence at which a stride is trusted, and its saturation value.
+static constexpr int STRIDE_CONFIDENCE_THRESHOLD = 1;
+static constexpr int STRIDE_CONFIDENCE_MAX = 3;
+
+prefetcher_stride_t::prefetcher_stride_t(int block_size, int table_entries, int degree)
+    : prefetcher_t(block_size)
+    , table_(table_entries > 0 ? table_entries : DEFAULT_TABLE_ENTRIES)
+    , degree_(degree > 0 ? degree : DEFAULT_DEGREE)
+{
+}
+
+void
+prefetcher_stride_t::prefetch(caching_device_t *cache, const memref_t &memref,
+                              bool missed)
+{
+    addr_t pc = memref.data.pc;
+    addr_t line = memref.data.addr >> block_size_bits_;
+    entry_t &entry = table_[(pc ^ (pc >> 16)) % table_.size()];
+    if (!entry.valid || entry.pc != pc) {
+        entry.pc = pc;
+        entry.last_line = line;
+        entry.stride = 0;
+        entry.confidence = 0;
+        entry.valid = true;
+        return;
+    }
+    int64_t stride = static_cast<int64_t>(line - entry.last_line);
+    // Repeated accesses to the same line neither confirm nor break a stride.
+    if (stride == 0)
+        return;
+    entry.last_line = line;
+    if (stride == entry.stride) {
+        if (entry.confidence < STRIDE_CONFIDENCE_MAX)
+            entry.confidence++;
+    } else {
+        if (entry.confidence > 0)
+            entry.confidence--;
+        if (entry.confidence == 0)
+            entry.stride = stride;
+        return;
+    }
+    if (entry.confidence < STRIDE_CONFIDENCE_THRESHOLD)
+        return;
+    for (int i = 1; i <= degree_; ++i)
+        issue_prefetch(cache, memref, line + i * stride);
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
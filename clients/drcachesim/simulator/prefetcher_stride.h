@@ -0,0 +1,84 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* prefetcher_stride: a PC-indexed stride prefetcher.
+ */
+
+#ifndef _PREFETCHER_STRIDE_H_
+#define _PREFETCHER_STRIDE_H_ 1
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "caching_device.h"
+#include "memref.h"
+#include "prefetcher.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/**
+ * A PC-indexed stride prefetcher.
+ *
+ * A direct-mapped table indexed by the PC of the memory access records the last
+ * line each instruction touched and the stride in lines between its last two
+ * accesses.  Once the same stride has been seen twice in a row, each access by
+ * that instruction prefetches the next "degree" lines along the stride.
+ */
+class prefetcher_stride_t : public prefetcher_t {
+public:
+    static constexpr int DEFAULT_TABLE_ENTRIES = 256;
+    static constexpr int DEFAULT_DEGREE = 4;
+
+    // A table_entries or degree of 0 selects the default.
+    prefetcher_stride_t(int block_size, int table_entries, int degree);
+    void
+    prefetch(caching_device_t *cache, const memref_t &memref, bool missed) override;
+
+private:
+    struct entry_t {
+        addr_t pc = 0;
+        addr_t last_line = 0;
+        int64_t stride = 0;
+        int confidence = 0;
+        bool valid = false;
+    };
+
+    std::vector<entry_t> table_;
+    int degree_;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _PREFETCHER_STRIDE_H_ */
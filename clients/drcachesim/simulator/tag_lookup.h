@@ -0,0 +1,106 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* tag_lookup: whole-set tag comparison for caching devices.
+ */
+
+#ifndef _TAG_LOOKUP_H_
+#define _TAG_LOOKUP_H_ 1
+
+#include <stdint.h>
+
+#include "trace_entry.h"
+
+// We use 64-bit lane compares, so we only vectorize for 64-bit targets.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#    include <immintrin.h>
+#    ifdef __AVX2__
+#        define TAG_LOOKUP_AVX2 1
+#    else
+#        define TAG_LOOKUP_SSE2 1
+#    endif
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__) && \
+    defined(__ARM_NEON)
+#    include <arm_neon.h>
+#    define TAG_LOOKUP_NEON 1
+#endif
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// Returns the index of the first of the "count" contiguous entries in "tags"
+// that equals "tag", or -1 if there is none.  This is the hot loop for every
+// cache lookup so it compares several ways per instruction where possible.
+inline int
+find_tag_in_set(const addr_t *tags, int count, addr_t tag)
+{
+    int way = 0;
+#if defined(TAG_LOOKUP_AVX2)
+    const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(tag));
+    for (; way + 4 <= count; way += 4) {
+        __m256i ways = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tags + way));
+        int mask =
+            _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(ways, needle)));
+        if (mask != 0)
+            return way + __builtin_ctz(mask);
+    }
+#elif defined(TAG_LOOKUP_SSE2)
+    // SSE2 has no 64-bit compare: we combine the two 32-bit halves instead.
+    const __m128i needle = _mm_set1_epi64x(static_cast<long long>(tag));
+    for (; way + 2 <= count; way += 2) {
+        __m128i eq = _mm_cmpeq_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags + way)), needle);
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(eq));
+        if (mask != 0)
+            return way + ((mask & 1) != 0 ? 0 : 1);
+    }
+#elif defined(TAG_LOOKUP_NEON)
+    const uint64x2_t needle = vdupq_n_u64(tag);
+    for (; way + 2 <= count; way += 2) {
+        uint64x2_t eq =
+            vceqq_u64(vld1q_u64(reinterpret_cast<const uint64_t *>(tags + way)), needle);
+        if (vmaxvq_u32(vreinterpretq_u32_u64(eq)) != 0)
+            return way + (vgetq_lane_u64(eq, 0) != 0 ? 0 : 1);
+    }
+#endif
+    for (; way < count; ++way) {
+        if (tags[way] == tag)
+            return way;
+    }
+    return -1;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _TAG_LOOKUP_H_ */
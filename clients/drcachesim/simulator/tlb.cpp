@@ -88,6 +88,7 @@ tlb_t::request(const memref_t &memref_in)
         assert(tag != TAG_INVALID && tag == tlb_entry->tag_ &&
                pid == ((tlb_entry_t *)tlb_entry)->pid_);
         record_access_stats(memref_in, true /*hit*/, tlb_entry);
+        set_replacement_context(memref_in, tag);
         access_update(last_block_idx_, last_way_);
         return;
     }
@@ -100,6 +101,7 @@ tlb_t::request(const memref_t &memref_in)
         if (tag + 1 <= final_tag)
             memref.data.size = ((tag + 1) << block_size_bits_) - memref.data.addr;
 
+        set_replacement_context(memref, tag);
         for (way = 0; way < associativity_; ++way) {
             caching_device_block_t *tlb_entry = &get_caching_device_block(block_idx, way);
             if (tlb_entry->tag_ == tag && ((tlb_entry_t *)tlb_entry)->pid_ == pid) {
@@ -119,7 +121,7 @@ tlb_t::request(const memref_t &memref_in)
 
             // XXX: do we need to handle TLB coherency?
 
-            tlb_entry->tag_ = tag;
+            update_tag(tlb_entry, way, tag);
             ((tlb_entry_t *)tlb_entry)->pid_ = pid;
         }
 
@@ -36,13 +36,24 @@
 #include <assert.h>
 
 #include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <string>
 #include <thread>
 #include <vector>
 
+#ifdef UNIX
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    include <utime.h>
+#endif
+
 #include "analyzer.h"
+#include "directory_iterator.h"
 #include "mock_reader.h"
 #include "scheduler.h"
+#include "tools/basic_counts.h"
 #ifdef HAS_ZIP
 #    include "zipfile_istream.h"
 #    include "zipfile_ostream.h"
@@ -490,10 +501,152 @@ test_tool_errors()
     return true;
 }
 
+#ifdef UNIX
+// An analyzer of the trace files in a directory that saves shard state in
+// cache_dir.
+class cached_analyzer_t : public analyzer_t {
+public:
+    cached_analyzer_t(const std::string &trace_dir, const std::string &cache_dir,
+                      analysis_tool_t **tools, int num_tools)
+        : analyzer_t()
+    {
+        num_tools_ = num_tools;
+        tools_ = tools;
+        worker_count_ = 2;
+        shard_state_dir_ = cache_dir;
+        if (!init_scheduler({ trace_dir }, {}, {}, /*output_limit=*/0, /*verbosity=*/1,
+                            scheduler_t::scheduler_options_t()))
+            success_ = false;
+    }
+};
+
+// Counts the shards that are analyzed rather than restored.
+class counting_basic_counts_t : public basic_counts_t {
+public:
+    counting_basic_counts_t()
+        : basic_counts_t(/*verbose=*/0)
+    {
+    }
+    void *
+    parallel_shard_init_stream(int shard_index, void *worker_data,
+                               memtrace_stream_t *stream) override
+    {
+        ++analyzed_shards;
+        return basic_counts_t::parallel_shard_init_stream(shard_index, worker_data,
+                                                          stream);
+    }
+    std::atomic<int> analyzed_shards { 0 };
+};
+
+// Writes a trace of num_instrs instructions, the last num_markers of which are
+// replaced by markers of the same size.
+static void
+write_thread_trace(const std::string &dir, memref_tid_t tid, int num_instrs,
+                   int num_markers = 0)
+{
+    std::vector<trace_entry_t> entries = {
+        test_util::make_header(TRACE_ENTRY_VERSION),
+        test_util::make_thread(tid),
+        test_util::make_pid(1),
+        test_util::make_version(TRACE_ENTRY_VERSION),
+        test_util::make_timestamp(static_cast<uint64_t>(tid)),
+    };
+    for (int i = 0; i < num_instrs; ++i) {
+        if (i >= num_instrs - num_markers)
+            entries.push_back(test_util::make_marker(TRACE_MARKER_TYPE_CPU_ID, 0));
+        else
+            entries.push_back(test_util::make_instr(42 + i * 4));
+    }
+    entries.push_back(test_util::make_exit(tid));
+    entries.push_back(test_util::make_footer());
+    std::ofstream out(dir + "/" + std::to_string(tid) + ".trace", std::ofstream::binary);
+    out.write(reinterpret_cast<const char *>(entries.data()),
+              entries.size() * sizeof(entries[0]));
+    assert(out.good());
+}
+
+static void
+clear_directory(const std::string &dir)
+{
+    mkdir(dir.c_str(), 0755);
+    directory_iterator_t end;
+    for (directory_iterator_t iter(dir); iter != end; ++iter) {
+        if (*iter != "." && *iter != "..")
+            remove((dir + "/" + *iter).c_str());
+    }
+}
+
+// Runs basic_counts over trace_dir and returns its total instruction count and the
+// number of shards it analyzed rather than restored.
+static void
+run_cached_basic_counts(const std::string &trace_dir, const std::string &cache_dir,
+                        int64_t &instrs, int &analyzed_shards)
+{
+    counting_basic_counts_t tool;
+    analysis_tool_t *tools[] = { &tool };
+    cached_analyzer_t analyzer(trace_dir, cache_dir, tools, 1);
+    assert(!!analyzer);
+    bool res = analyzer.run();
+    assert(res);
+    instrs = tool.get_total_counts().instrs;
+    analyzed_shards = tool.analyzed_shards;
+}
+#endif
+
+bool
+test_saved_shard_state()
+{
+#ifdef UNIX
+    std::cerr << "\n----------------\nTesting saved shard state\n";
+    const std::string trace_dir = "tmp_test_saved_shard_state.trace";
+    const std::string cache_dir = "tmp_test_saved_shard_state.cache";
+    clear_directory(trace_dir);
+    clear_directory(cache_dir);
+    write_thread_trace(trace_dir, 101, 3);
+    write_thread_trace(trace_dir, 102, 5);
+    write_thread_trace(trace_dir, 103, 7);
+    int64_t instrs;
+    int analyzed_shards;
+    // The first run analyzes every input and saves its state.
+    run_cached_basic_counts(trace_dir, cache_dir, instrs, analyzed_shards);
+    assert(instrs == 15 && analyzed_shards == 3);
+    // A re-run restores all but the one input the scheduler needs.
+    run_cached_basic_counts(trace_dir, cache_dir, instrs, analyzed_shards);
+    assert(instrs == 15 && analyzed_shards == 1);
+    // A new thread and a changed thread are analyzed while the rest are restored.
+    write_thread_trace(trace_dir, 100, 11);
+    write_thread_trace(trace_dir, 102, 13);
+    run_cached_basic_counts(trace_dir, cache_dir, instrs, analyzed_shards);
+    assert(instrs == 34 && analyzed_shards == 2);
+    run_cached_basic_counts(trace_dir, cache_dir, instrs, analyzed_shards);
+    assert(instrs == 34 && analyzed_shards == 1);
+    // A change that keeps both the size and the modification time is caught by
+    // the hash of the sampled contents, which for a small input is all of it.
+    const std::string changed = trace_dir + "/101.trace";
+    struct stat st;
+    int stat_res = stat(changed.c_str(), &st);
+    assert(stat_res == 0);
+    write_thread_trace(trace_dir, 101, 3, /*num_markers=*/1);
+    struct utimbuf times;
+    times.actime = st.st_atime;
+    times.modtime = st.st_mtime;
+    int utime_res = utime(changed.c_str(), &times);
+    assert(utime_res == 0);
+    run_cached_basic_counts(trace_dir, cache_dir, instrs, analyzed_shards);
+    assert(instrs == 33 && analyzed_shards == 1);
+    clear_directory(trace_dir);
+    clear_directory(cache_dir);
+    rmdir(trace_dir.c_str());
+    rmdir(cache_dir.c_str());
+#endif
+    return true;
+}
+
 int
 test_main(int argc, const char *argv[])
 {
-    if (!test_queries() || !test_wait_records() || !test_tool_errors())
+    if (!test_queries() || !test_wait_records() || !test_tool_errors() ||
+        !test_saved_shard_state())
         return 1;
     std::cerr << "All done!\n";
     return 0;
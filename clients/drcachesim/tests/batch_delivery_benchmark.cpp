@@ -0,0 +1,191 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Compares the record throughput of the analyzer delivering records to a tool one
+ * at a time through parallel_shard_memref() versus in batches through
+ * parallel_shard_memref_batch(), using basic_counts as a tool whose per-record
+ * work is small enough for the delivery overhead to matter.  Run on a checked-in
+ * trace directory such as clients/drcachesim/tests/drmemtrace.threadsig.x64.tracedir:
+ *   $ tool.drcachesim.batch_delivery_benchmark trace_dir [workers] [repetitions]
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "analysis_tool.h"
+#include "analyzer.h"
+#include "memref.h"
+#include "tools/basic_counts.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+namespace {
+
+// Counts the records delivered, to convert run times to rates.
+class record_counter_t : public analysis_tool_t {
+public:
+    bool
+    process_memref(const memref_t &memref) override
+    {
+        ++records_;
+        return true;
+    }
+    bool
+    print_results() override
+    {
+        return true;
+    }
+    bool
+    parallel_shard_supported() override
+    {
+        return true;
+    }
+    void *
+    parallel_shard_init_stream(int shard_index, void *worker_data,
+                               memtrace_stream_t *stream) override
+    {
+        return new uint64_t(0);
+    }
+    bool
+    parallel_shard_exit(void *shard_data) override
+    {
+        uint64_t *count = reinterpret_cast<uint64_t *>(shard_data);
+        records_ += *count;
+        delete count;
+        return true;
+    }
+    bool
+    parallel_shard_memref(void *shard_data, const memref_t &memref) override
+    {
+        ++*reinterpret_cast<uint64_t *>(shard_data);
+        return true;
+    }
+    uint64_t
+    get_records() const
+    {
+        return records_;
+    }
+
+private:
+    std::atomic<uint64_t> records_ { 0 };
+};
+
+// basic_counts with batch delivery turned off.
+class unbatched_basic_counts_t : public basic_counts_t {
+public:
+    unbatched_basic_counts_t()
+        : basic_counts_t(0)
+    {
+    }
+    bool
+    parallel_shard_batch_supported() override
+    {
+        return false;
+    }
+};
+
+double
+seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Returns the run time in seconds, or a negative value on failure.
+double
+time_run(const std::string &trace_dir, analysis_tool_t *tool, int workers)
+{
+    analysis_tool_t *tools[] = { tool };
+    analyzer_t analyzer(trace_dir, tools, 1, workers);
+    if (!analyzer) {
+        std::cerr << "Failed to initialize analyzer: " << analyzer.get_error_string()
+                  << "\n";
+        return -1.;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (!analyzer.run()) {
+        std::cerr << "Failed to run analyzer: " << analyzer.get_error_string() << "\n";
+        return -1.;
+    }
+    return seconds_since(start);
+}
+
+} // namespace
+
+int
+test_main(int argc, const char *argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " trace_dir [workers] [repetitions]\n";
+        return 1;
+    }
+    std::string trace_dir = argv[1];
+    int workers = argc > 2 ? atoi(argv[2]) : 1;
+    int repetitions = argc > 3 ? atoi(argv[3]) : 5;
+    record_counter_t counter;
+    if (time_run(trace_dir, &counter, workers) < 0.)
+        return 1;
+    const double records = static_cast<double>(counter.get_records());
+    std::cout << trace_dir << ": " << counter.get_records() << " records, " << workers
+              << " workers, best of " << repetitions << " runs\n";
+    std::cout << std::fixed << std::setprecision(2);
+    double best_single = 0., best_batched = 0.;
+    for (int i = 0; i < repetitions; ++i) {
+        // Alternate the modes so that any drift in the machine affects both.
+        unbatched_basic_counts_t single;
+        double secs = time_run(trace_dir, &single, workers);
+        if (secs < 0.)
+            return 1;
+        best_single = i == 0 ? secs : std::min(best_single, secs);
+        basic_counts_t batched(0);
+        secs = time_run(trace_dir, &batched, workers);
+        if (secs < 0.)
+            return 1;
+        best_batched = i == 0 ? secs : std::min(best_batched, secs);
+    }
+    std::cout << "  per-record " << std::setw(8) << records / best_single / 1e6
+              << " M records/s\n";
+    std::cout << "  batched    " << std::setw(8) << records / best_batched / 1e6
+              << " M records/s (" << best_single / best_batched << "x)\n";
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -39,8 +39,12 @@
 #include "simulator/policy_bit_plru.h"
 #include "simulator/cache.h"
 #include "simulator/policy_fifo.h"
+#include "simulator/policy_hawkeye.h"
 #include "simulator/policy_lfu.h"
 #include "simulator/policy_lru.h"
+#include "simulator/policy_opt.h"
+#include "simulator/policy_rrip.h"
+#include "simulator/policy_ship.h"
 #include "simulator/tlb.h"
 #include "test_helpers.h"
 
@@ -94,6 +98,21 @@ public:
                expected_replacement_way_after_access);
     }
 
+    // Accesses addr from the instruction at pc and returns whether it hit.
+    bool
+    access_with_pc(const addr_t addr, const addr_t pc)
+    {
+        memref_t ref = {};
+        ref.data.type = TRACE_TYPE_READ;
+        ref.data.size = 1;
+        ref.data.addr = addr;
+        ref.data.pid = 1;
+        ref.data.pc = pc;
+        int64_t misses = this->get_stats()->get_metric(metric_name_t::MISSES);
+        this->request(ref);
+        return this->get_stats()->get_metric(metric_name_t::MISSES) == misses;
+    }
+
     void
     invalidate_and_check(const addr_t addr,
                          const int expected_replacement_way_after_access)
@@ -455,6 +474,206 @@ unit_test_tlb_lfu_four_way()
     tlb_lfu_test.access_and_check(addr_vec[ADDR_D], 3); //     A2 B2 C2 D1
 }
 
+void
+unit_test_cache_srrip_four_way()
+{
+    caching_device_policy_test_t<cache_t> cache_srrip_test(/*associativity=*/4,
+                                                           /*line_size=*/32);
+    cache_srrip_test.initialize_cache(
+        std::unique_ptr<policy_rrip_t>(new policy_rrip_t(
+            /*num_sets=*/256 / 32 / 4, /*associativity=*/4, rrip_mode_t::SRRIP)),
+        256);
+
+    assert(cache_srrip_test.get_replace_policy() == "SRRIP");
+    assert(cache_srrip_test.block_indices_are_identical(addr_vec));
+    assert(cache_srrip_test.tags_are_different(addr_vec));
+
+    // The number after each line is its RRPV; lower-case letters show the way
+    // to be replaced next.  Lines are inserted with RRPV 2 and hits reset it to 0.
+    cache_srrip_test.access_and_check(addr_vec[ADDR_A], 1); //     A2 x  X  X
+    cache_srrip_test.access_and_check(addr_vec[ADDR_B], 2); //     A2 B2 x  X
+    cache_srrip_test.access_and_check(addr_vec[ADDR_C], 3); //     A2 B2 C2 x
+    cache_srrip_test.access_and_check(addr_vec[ADDR_D], 0); //     a2 B2 C2 D2
+    cache_srrip_test.access_and_check(addr_vec[ADDR_A], 1); //     A0 b2 C2 D2
+    // Evicting B ages the set by 1.
+    cache_srrip_test.access_and_check(addr_vec[ADDR_E], 2); //     A1 E2 c3 D3
+    cache_srrip_test.access_and_check(addr_vec[ADDR_B], 3); //     A1 E2 B2 d3
+    cache_srrip_test.access_and_check(addr_vec[ADDR_E], 3); //     A1 E0 B2 d3
+    cache_srrip_test.access_and_check(addr_vec[ADDR_C], 2); //     A1 E0 b2 C2
+
+    cache_srrip_test.invalidate_and_check(addr_vec[ADDR_A], 0); // x  E0 B2 C2
+
+    cache_srrip_test.access_and_check(addr_vec[ADDR_F], 0); //     f2 E0 B2 C2
+}
+
+void
+unit_test_cache_brrip_four_way()
+{
+    caching_device_policy_test_t<cache_t> cache_brrip_test(/*associativity=*/4,
+                                                           /*line_size=*/32);
+    cache_brrip_test.initialize_cache(
+        std::unique_ptr<policy_rrip_t>(new policy_rrip_t(
+            /*num_sets=*/256 / 32 / 4, /*associativity=*/4, rrip_mode_t::BRRIP)),
+        256);
+
+    assert(cache_brrip_test.get_replace_policy() == "BRRIP");
+
+    // Lines are inserted with the distant RRPV 3, so a scan of new lines keeps
+    // replacing the same way and leaves the reused A alone.
+    cache_brrip_test.access_and_check(addr_vec[ADDR_A], 1); //     A3 x  X  X
+    cache_brrip_test.access_and_check(addr_vec[ADDR_B], 2); //     A3 B3 x  X
+    cache_brrip_test.access_and_check(addr_vec[ADDR_C], 3); //     A3 B3 C3 x
+    cache_brrip_test.access_and_check(addr_vec[ADDR_D], 0); //     a3 B3 C3 D3
+    cache_brrip_test.access_and_check(addr_vec[ADDR_A], 1); //     A0 b3 C3 D3
+    cache_brrip_test.access_and_check(addr_vec[ADDR_E], 1); //     A0 e3 C3 D3
+    cache_brrip_test.access_and_check(addr_vec[ADDR_F], 1); //     A0 f3 C3 D3
+    cache_brrip_test.access_and_check(addr_vec[ADDR_G], 1); //     A0 g3 C3 D3
+    cache_brrip_test.access_and_check(addr_vec[ADDR_A], 1); //     A0 g3 C3 D3
+}
+
+// Exposes the RRPVs of an RRIP-based policy.
+template <class T> class policy_rrpv_test_t : public T {
+public:
+    using T::T;
+    int
+    get_rrpv(int set_idx, int way) const
+    {
+        return this->rrpv_[set_idx * this->associativity_ + way];
+    }
+    // Simulates a miss in the given way.
+    void
+    insert(int set_idx, int way)
+    {
+        this->eviction_update(set_idx, way);
+        this->access_update(set_idx, way);
+    }
+};
+
+void
+unit_test_drrip_set_dueling()
+{
+    // With 8 sets, sets 0 and 4 are SRRIP leaders, 1 and 5 are BRRIP leaders, and
+    // the rest follow whichever leader misses less.
+    policy_rrpv_test_t<policy_rrip_t> drrip(/*num_sets=*/8, /*associativity=*/4,
+                                            rrip_mode_t::DRRIP);
+    assert(drrip.get_name() == "DRRIP");
+    // With no misses yet the followers use SRRIP.
+    drrip.insert(2, 0);
+    assert(drrip.get_rrpv(2, 0) == 2);
+    // Once the SRRIP leaders miss more, the followers use BRRIP.
+    drrip.insert(0, 0);
+    drrip.insert(0, 1);
+    drrip.insert(3, 0);
+    assert(drrip.get_rrpv(3, 0) == 3);
+    // And back to SRRIP when the BRRIP leaders miss more.
+    for (int i = 0; i < 4; ++i)
+        drrip.insert(1, i);
+    drrip.insert(2, 1);
+    assert(drrip.get_rrpv(2, 1) == 2);
+    // The leaders themselves never switch.
+    assert(drrip.get_rrpv(0, 0) == 2);
+    assert(drrip.get_rrpv(1, 0) == 3);
+}
+
+void
+unit_test_ship_prediction()
+{
+    const addr_t PC_X = 0x1000;
+    const addr_t PC_Y = 0x2000;
+    policy_rrpv_test_t<policy_ship_t> ship(/*num_sets=*/1, /*associativity=*/4);
+    assert(ship.get_name() == "SHIP");
+    // New signatures are predicted to be reused and get the SRRIP insertion RRPV.
+    ship.set_access_context(/*tag=*/1, PC_X, /*is_prefetch=*/false);
+    ship.insert(0, 0);
+    assert(ship.get_rrpv(0, 0) == 2);
+    // Evicting X's line without a hit makes X's lines distant.
+    ship.set_access_context(/*tag=*/2, PC_Y, /*is_prefetch=*/false);
+    ship.insert(0, 0);
+    assert(ship.get_rrpv(0, 0) == 2);
+    ship.set_access_context(/*tag=*/3, PC_X, /*is_prefetch=*/false);
+    ship.insert(0, 1);
+    assert(ship.get_rrpv(0, 1) == 3);
+    // A hit on one of X's lines restores the prediction.
+    ship.access_update(0, 1);
+    assert(ship.get_rrpv(0, 1) == 0);
+    ship.set_access_context(/*tag=*/4, PC_X, /*is_prefetch=*/false);
+    ship.insert(0, 2);
+    assert(ship.get_rrpv(0, 2) == 2);
+}
+
+void
+unit_test_cache_hawkeye()
+{
+    // A single 4-way set accessed by one PC that cycles through 3 lines and another
+    // that streams through new lines.  Each reused line is accessed again after 4
+    // other lines, so LRU never hits, but once Hawkeye learns that the streaming
+    // PC's lines are not worth caching it keeps the reused ones.
+    const int ITERATIONS = 50;
+    const int MEASURED = 20;
+    const addr_t PC_REUSE = 0x1000;
+    const addr_t PC_STREAM = 0x2000;
+    for (const std::string &policy : { "LRU", "HAWKEYE" }) {
+        caching_device_policy_test_t<cache_t> cache_test(/*associativity=*/4,
+                                                         /*line_size=*/32);
+        if (policy == "LRU") {
+            cache_test.initialize_cache(
+                std::unique_ptr<policy_lru_t>(new policy_lru_t(1, 4)), 4 * 32);
+        } else {
+            cache_test.initialize_cache(
+                std::unique_ptr<policy_hawkeye_t>(new policy_hawkeye_t(1, 4)), 4 * 32);
+        }
+        assert(cache_test.get_replace_policy() == policy);
+        int reuse_hits = 0;
+        addr_t stream_addr = 1000 * 32;
+        for (int i = 0; i < ITERATIONS; ++i) {
+            for (int line = 0; line < 3; ++line) {
+                bool hit = cache_test.access_with_pc(line * 32, PC_REUSE);
+                if (i >= ITERATIONS - MEASURED && hit)
+                    ++reuse_hits;
+            }
+            for (int line = 0; line < 2; ++line) {
+                cache_test.access_with_pc(stream_addr, PC_STREAM);
+                stream_addr += 32;
+            }
+        }
+        assert(reuse_hits == (policy == "LRU" ? 0 : 3 * MEASURED));
+    }
+}
+
+void
+unit_test_cache_opt()
+{
+    // Cycling through 5 lines in a 4-way set: LRU misses on every access, while OPT
+    // only misses on the first 5 and then on the one line it chose to drop.
+    const std::vector<addr_t> addresses = {
+        addr_vec[ADDR_A], addr_vec[ADDR_B], addr_vec[ADDR_C], addr_vec[ADDR_D],
+        addr_vec[ADDR_E], addr_vec[ADDR_A], addr_vec[ADDR_B], addr_vec[ADDR_C],
+        addr_vec[ADDR_D], addr_vec[ADDR_E],
+    };
+    caching_device_policy_test_t<cache_t> cache_opt_test(/*associativity=*/4,
+                                                         /*line_size=*/32);
+    // The policy needs the future accesses before the cache is initialized.
+    std::vector<addr_t> tags;
+    for (addr_t addr : addresses)
+        tags.push_back(addr / 32);
+    std::vector<uint64_t> next_uses = policy_opt_t::compute_next_uses(tags);
+    assert(next_uses[0] == 5);
+    assert(next_uses[5] == policy_opt_t::NEVER);
+    cache_opt_test.initialize_cache(
+        std::unique_ptr<policy_opt_t>(new policy_opt_t(
+            /*num_sets=*/256 / 32 / 4, /*associativity=*/4, std::move(next_uses))),
+        256);
+    assert(cache_opt_test.get_replace_policy() == "OPT");
+    int misses = 0;
+    for (addr_t addr : addresses) {
+        if (!cache_opt_test.access_with_pc(addr, 0))
+            ++misses;
+    }
+    // E replaces D, the line used furthest in the future, and D later replaces
+    // one of the lines that are never used again.
+    assert(misses == 6);
+}
+
 void
 unit_test_cache_replacement_policy()
 {
@@ -466,6 +685,12 @@ unit_test_cache_replacement_policy()
     unit_test_cache_lfu_eight_way();
     unit_test_tlb_plru_four_way();
     unit_test_tlb_lfu_four_way();
+    unit_test_cache_srrip_four_way();
+    unit_test_cache_brrip_four_way();
+    unit_test_drrip_set_dueling();
+    unit_test_ship_prediction();
+    unit_test_cache_hawkeye();
+    unit_test_cache_opt();
     // XXX i#4842: Add more test sequences.
 }
 
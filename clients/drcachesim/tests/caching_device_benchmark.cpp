@@ -0,0 +1,186 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Microbenchmark for the caching_device_t tag lookup.
+ *
+ * Compares the structure-of-arrays tag store used by caching_device_t
+ * (see find_tag_in_set()) against scanning an array of block pointers, which
+ * is how lookups were done before, and measures whole-cache request()
+ * throughput with and without the tag2block hashtable.  Run with an optional
+ * lookup count:
+ *   $ tool.drcachesim.caching_device_benchmark [num_lookups]
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "simulator/cache.h"
+#include "simulator/cache_stats.h"
+#include "simulator/caching_device_block.h"
+#include "simulator/create_cache_replacement_policy.h"
+#include "simulator/tag_lookup.h"
+#include "memref.h"
+#include "trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+namespace {
+
+// Keeps the compiler from discarding the lookups.
+volatile uint64_t benchmark_sink;
+
+double
+elapsed_ns(std::chrono::steady_clock::time_point start, uint64_t count)
+{
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / count;
+}
+
+// Scans the ways of a set one block at a time, as caching_device_t used to.
+int
+find_tag_in_blocks(caching_device_block_t **blocks, int count, addr_t tag)
+{
+    for (int way = 0; way < count; ++way) {
+        if (blocks[way]->tag_ == tag)
+            return way;
+    }
+    return -1;
+}
+
+void
+bench_set_lookup(int associativity, uint64_t num_lookups)
+{
+    const int num_sets = 4096;
+    const int num_blocks = num_sets * associativity;
+    std::mt19937_64 rng(associativity);
+    std::vector<addr_t> tags(num_blocks);
+    std::vector<std::unique_ptr<caching_device_block_t>> storage;
+    std::vector<caching_device_block_t *> blocks(num_blocks);
+    for (int i = 0; i < num_blocks; ++i) {
+        tags[i] = rng() >> 8;
+        storage.emplace_back(new caching_device_block_t);
+        storage.back()->tag_ = tags[i];
+        blocks[i] = storage.back().get();
+    }
+    // Half of the lookups hit, at a random way.
+    std::vector<std::pair<int, addr_t>> lookups(1 << 16);
+    for (auto &lookup : lookups) {
+        lookup.first = static_cast<int>(rng() % num_sets) * associativity;
+        if (rng() % 2 == 0)
+            lookup.second = tags[lookup.first + rng() % associativity];
+        else
+            lookup.second = TAG_INVALID - 1;
+    }
+    uint64_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_lookups; ++i) {
+        const auto &lookup = lookups[i & (lookups.size() - 1)];
+        found +=
+            find_tag_in_blocks(&blocks[lookup.first], associativity, lookup.second) + 1;
+    }
+    double blocks_ns = elapsed_ns(start, num_lookups);
+    start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_lookups; ++i) {
+        const auto &lookup = lookups[i & (lookups.size() - 1)];
+        found += find_tag_in_set(&tags[lookup.first], associativity, lookup.second) + 1;
+    }
+    double tags_ns = elapsed_ns(start, num_lookups);
+    benchmark_sink = found;
+    std::cout << "  " << std::setw(2) << associativity << "-way set lookup: blocks "
+              << std::setw(6) << blocks_ns << " ns, tags " << std::setw(6) << tags_ns
+              << " ns\n";
+}
+
+void
+bench_cache_request(int associativity, bool use_hashtable, uint64_t num_lookups)
+{
+    const int line_size = 64;
+    const int64_t total_size = 8 * 1024 * 1024;
+    const int num_sets = static_cast<int>(total_size / line_size / associativity);
+    cache_t cache;
+    cache_stats_t *stats = new cache_stats_t(line_size);
+    if (!cache.init(associativity, line_size, total_size, nullptr, stats,
+                    create_cache_replacement_policy("LRU", num_sets, associativity))) {
+        std::cerr << "Failed to initialize cache\n";
+        exit(1);
+    }
+    cache.set_hashtable_use(use_hashtable);
+    // A working set 1.5x the cache size gives a mix of hits and misses.
+    std::mt19937_64 rng(associativity);
+    std::vector<memref_t> refs(1 << 16);
+    for (memref_t &ref : refs) {
+        ref = {};
+        ref.data.type = TRACE_TYPE_READ;
+        ref.data.size = 4;
+        ref.data.addr = (rng() % (total_size * 3 / 2)) & ~(addr_t)(line_size - 1);
+    }
+    for (const memref_t &ref : refs)
+        cache.request(ref);
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_lookups; ++i)
+        cache.request(refs[i & (refs.size() - 1)]);
+    std::cout << "  " << std::setw(2) << associativity << "-way 8MB cache request "
+              << (use_hashtable ? "with" : "without") << " hashtable: " << std::setw(6)
+              << elapsed_ns(start, num_lookups) << " ns\n";
+    delete stats;
+}
+
+} // namespace
+
+int
+test_main(int argc, const char *argv[])
+{
+    uint64_t num_lookups = 20000000;
+    if (argc > 1)
+        num_lookups = strtoull(argv[1], nullptr, 10);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Per-lookup time:\n";
+    for (int associativity : { 4, 8, 16, 32 })
+        bench_set_lookup(associativity, num_lookups);
+    for (int associativity : { 8, 16, 32 }) {
+        bench_cache_request(associativity, false, num_lookups / 4);
+        bench_cache_request(associativity, true, num_lookups / 4);
+    }
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,305 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Tests for columnar_ostream_t and columnar_file_reader_t. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "columnar_file_reader.h"
+#include "columnar_ostream.h"
+#include "memref.h"
+#include "mock_reader.h"
+#include "scheduler.h"
+#include "trace_entry.h"
+#include "trace_index.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+#define CHECK(cond, msg, ...)             \
+    do {                                  \
+        if (!(cond)) {                    \
+            fprintf(stderr, "%s\n", msg); \
+            exit(1);                      \
+        }                                 \
+    } while (0)
+
+static constexpr memref_tid_t TID = 21;
+static constexpr memref_pid_t PID = 7;
+static constexpr int CHUNK_INSTRS = 100;
+static constexpr addr_t PC_BASE = 0x401000;
+static constexpr addr_t DATA_BASE = 0x7fff0000;
+
+// Returns a trace laid out like raw2trace output, with a chunk footer followed by
+// a timestamp and cpuid every CHUNK_INSTRS instructions.  Some of the jumps in
+// the pcs and data addresses are far enough to defeat the column predictors.
+static std::vector<trace_entry_t>
+make_trace(int num_instrs)
+{
+    std::vector<trace_entry_t> trace = {
+        test_util::make_header(TRACE_ENTRY_VERSION),
+        test_util::make_thread(TID),
+        test_util::make_pid(PID),
+        test_util::make_version(TRACE_ENTRY_VERSION),
+        test_util::make_marker(TRACE_MARKER_TYPE_FILETYPE, OFFLINE_FILE_TYPE_ENCODINGS),
+        test_util::make_marker(TRACE_MARKER_TYPE_CACHE_LINE_SIZE, 64),
+        test_util::make_marker(TRACE_MARKER_TYPE_CHUNK_INSTR_COUNT, CHUNK_INSTRS),
+        // The readers expect the page size to end the header.
+        test_util::make_marker(TRACE_MARKER_TYPE_PAGE_SIZE, 4096),
+    };
+    uint64_t timestamp = 1000;
+    addr_t pc = PC_BASE;
+    addr_t data = DATA_BASE;
+    for (int i = 0; i < num_instrs; ++i) {
+        if (i % CHUNK_INSTRS == 0) {
+            if (i > 0) {
+                trace.push_back(test_util::make_marker(TRACE_MARKER_TYPE_CHUNK_FOOTER,
+                                                       i / CHUNK_INSTRS - 1));
+            }
+            timestamp += 10 + i % 7;
+            trace.push_back(test_util::make_timestamp(timestamp));
+            trace.push_back(test_util::make_marker(TRACE_MARKER_TYPE_CPU_ID, i % 3));
+        }
+        trace.push_back(test_util::make_encoding(4, 0x90000000 + i));
+        trace.push_back(test_util::make_instr(pc, TRACE_TYPE_INSTR, 4));
+        pc += (i % 17 == 0) ? 0x123400 : 4;
+        if (i % 3 == 0)
+            trace.push_back(test_util::make_memref(data, TRACE_TYPE_READ, 8));
+        if (i % 5 == 0) {
+            trace.push_back(test_util::make_memref(data + 0x10000000 * (i % 4),
+                                                   TRACE_TYPE_WRITE, 4));
+        }
+        data += (i % 11 == 0) ? -0x2000 : 8;
+    }
+    trace.push_back(test_util::make_exit(TID));
+    trace.push_back(test_util::make_footer());
+    return trace;
+}
+
+// Writes "trace" to "path", starting a new component after each chunk footer
+// just as raw2trace does.
+static void
+write_trace(const std::string &path, const std::vector<trace_entry_t> &trace)
+{
+    columnar_ostream_t out(path);
+    CHECK(out, "failed to open columnar output");
+    uint64_t instr_count = 0;
+    uint64_t last_timestamp = 0;
+    for (const trace_entry_t &entry : trace) {
+        out.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        if (type_is_instr(static_cast<trace_type_t>(entry.type)))
+            ++instr_count;
+        else if (entry.type == TRACE_TYPE_MARKER &&
+                 entry.size == TRACE_MARKER_TYPE_TIMESTAMP)
+            last_timestamp = entry.addr;
+        else if (entry.type == TRACE_TYPE_MARKER &&
+                 entry.size == TRACE_MARKER_TYPE_CHUNK_FOOTER) {
+            CHECK(out.open_new_component("chunk").empty(), "failed to open component");
+            out.set_component_start(instr_count, last_timestamp);
+        }
+    }
+    CHECK(out, "failed to write columnar output");
+}
+
+static bool
+same_memref(const memref_t &a, const memref_t &b)
+{
+    return a.data.type == b.data.type && a.data.pid == b.data.pid &&
+        a.data.tid == b.data.tid && a.data.addr == b.data.addr &&
+        a.data.size == b.data.size;
+}
+
+// Checks that every record, including the markers, encodings, and chunk footers,
+// decodes to what was written.
+static void
+test_round_trip(const std::string &path, const std::vector<trace_entry_t> &trace)
+{
+    columnar_reader_t reader;
+    CHECK(reader.open(path), "failed to open columnar input");
+    bool eof = false;
+    for (const trace_entry_t &expect : trace) {
+        trace_entry_t *entry = reader.read_next(&eof);
+        CHECK(entry != nullptr, "columnar input ended early");
+        CHECK(entry->type == expect.type && entry->size == expect.size &&
+                  entry->addr == expect.addr,
+              "columnar record mismatch");
+    }
+    CHECK(reader.read_next(&eof) == nullptr && eof, "columnar input did not end");
+    // Every chunk after the first starts a block listed in the index.
+    std::vector<trace_index_entry_t> entries;
+    CHECK(read_trace_index(path, entries), "failed to read chunk index");
+    CHECK(entries.size() > 2 && entries[1].instr_ordinal == CHUNK_INSTRS &&
+              entries[1].timestamp > entries[0].timestamp &&
+              entries[2].offset > entries[1].offset,
+          "unexpected chunk index");
+    // Each block must also decode on its own.
+    CHECK(reader.seek(entries[2].offset), "failed to seek to block");
+    trace_entry_t *entry = reader.read_next(&eof);
+    CHECK(entry != nullptr && entry->type == TRACE_TYPE_MARKER &&
+              entry->size == TRACE_MARKER_TYPE_TIMESTAMP,
+          "block does not start with its chunk's timestamp");
+}
+
+// Counts the chunk index seeks of the reader.
+class seek_counting_reader_t : public columnar_file_reader_t {
+public:
+    seek_counting_reader_t(const std::string &path, int *seek_count)
+        : columnar_file_reader_t(path)
+        , seek_count_(seek_count)
+    {
+    }
+
+protected:
+    bool
+    seek_to_chunk(uint64_t offset) override
+    {
+        if (!columnar_file_reader_t::seek_to_chunk(offset))
+            return false;
+        ++*seek_count_;
+        return true;
+    }
+
+private:
+    int *seek_count_;
+};
+
+// Checks that skipping through the chunk index ends up where a linear walk over
+// the same records does.
+static void
+test_skip(const std::string &path, const std::vector<trace_entry_t> &trace)
+{
+    const int num_instrs = CHUNK_INSTRS * 5;
+    int seek_count = 0;
+    for (uint64_t skip : { 1, CHUNK_INSTRS - 1, CHUNK_INSTRS, CHUNK_INSTRS + 1,
+                           CHUNK_INSTRS * 3 + 42, num_instrs - 2 }) {
+        seek_counting_reader_t columnar(path, &seek_count);
+        // skip_instructions() is only public through the base class.
+        reader_t &reader = columnar;
+        columnar_file_reader_t end;
+        CHECK(reader.init(), "failed to initialize columnar reader");
+        test_util::mock_reader_t linear(trace);
+        test_util::mock_reader_t linear_end;
+        CHECK(linear.init(), "failed to initialize mock reader");
+        // Start both from the first instruction, past the headers.
+        while (!type_is_instr((*reader).instr.type))
+            ++reader;
+        while (!type_is_instr((*linear).instr.type))
+            ++linear;
+        reader.skip_instructions(skip);
+        linear.skip_instructions(skip);
+        for (int i = 0; i < 10 && linear != linear_end; ++i, ++reader, ++linear) {
+            CHECK(reader != end, "columnar reader ended early after skip");
+            CHECK(same_memref(*reader, *linear), "record mismatch after skip");
+            CHECK(reader.get_instruction_ordinal() == linear.get_instruction_ordinal(),
+                  "instruction ordinal mismatch after skip");
+            CHECK(reader.get_last_timestamp() == linear.get_last_timestamp(),
+                  "timestamp mismatch after skip");
+        }
+    }
+    // Each skip reaching past the first chunk should have seeked.
+    CHECK(seek_count == 5, "chunk index was not used for skipping");
+}
+
+// Checks that skipping the data address column zeroes just those addresses, both
+// directly and through scheduler_options_t::skip_data_addresses.
+static void
+test_skip_data_addresses(const std::string &path)
+{
+    columnar_file_reader_t full(path);
+    columnar_file_reader_t skipped(path, /*verbosity=*/0, /*skip_data_addresses=*/true);
+    columnar_file_reader_t end;
+    CHECK(full.init() && skipped.init(), "failed to initialize columnar readers");
+    std::vector<memref_t> expect;
+    int data_count = 0;
+    for (; full != end; ++full, ++skipped) {
+        CHECK(skipped != end, "data-skipping reader ended early");
+        memref_t memref = *full;
+        if (type_is_data(memref.data.type)) {
+            memref.data.addr = 0;
+            ++data_count;
+        }
+        CHECK(same_memref(*skipped, memref), "data-skipping record mismatch");
+        expect.push_back(memref);
+    }
+    CHECK(skipped == end, "data-skipping reader did not end");
+    CHECK(data_count > 0, "no data records");
+
+    std::vector<scheduler_t::input_workload_t> sched_inputs;
+    sched_inputs.emplace_back(path);
+    scheduler_t::scheduler_options_t sched_ops(scheduler_t::MAP_TO_ANY_OUTPUT,
+                                               scheduler_t::DEPENDENCY_IGNORE,
+                                               scheduler_t::SCHEDULER_DEFAULTS);
+    sched_ops.skip_data_addresses = true;
+    scheduler_t scheduler;
+    if (scheduler.init(sched_inputs, 1, std::move(sched_ops)) !=
+        scheduler_t::STATUS_SUCCESS) {
+        std::cerr << scheduler.get_error_string() << "\n";
+        CHECK(false, "failed to initialize scheduler");
+    }
+    auto *stream = scheduler.get_stream(0);
+    size_t index = 0;
+    memref_t memref;
+    for (scheduler_t::stream_status_t status = stream->next_record(memref);
+         status != scheduler_t::STATUS_EOF; status = stream->next_record(memref)) {
+        CHECK(status == scheduler_t::STATUS_OK, "scheduler failed");
+        CHECK(index < expect.size(), "scheduler returned too many records");
+        CHECK(same_memref(memref, expect[index]), "scheduler record mismatch");
+        ++index;
+    }
+    CHECK(index == expect.size(), "scheduler returned too few records");
+}
+
+int
+test_main(int argc, const char *argv[])
+{
+    const std::string path = "columnar_unit_tests.trace.col";
+    std::vector<trace_entry_t> trace = make_trace(CHUNK_INSTRS * 5);
+    write_trace(path, trace);
+    test_round_trip(path, trace);
+    test_skip(path, trace);
+    test_skip_data_addresses(path);
+    remove(path.c_str());
+    remove(trace_index_path(path).c_str());
+    std::cerr << "columnar_unit_tests passed\n";
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,337 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Compares the compressed size, write speed, and read and skip speed of the
+ * offline trace compression formats.
+ *
+ * The records of a trace file are loaded into memory and then written out in each
+ * format this build supports, with each original chunk placed in its own archive
+ * component, zstd frame, or columnar block.  Each output is then read back in full
+ * and, separately, skipped to its midpoint.  Run with a single-thread trace file such as
+ * clients/drcachesim/tests/drmemtrace.simple_app.trace.zip:
+ *   $ tool.drcachesim.compression_benchmark trace_file [scratch_dir]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "archive_ostream.h"
+#include "memref.h"
+#include "reader.h"
+#include "record_file_reader.h"
+#include "trace_entry.h"
+#include "utils.h"
+#include "tracer/raw2trace_shared.h"
+#ifdef HAS_ZLIB
+#    include "common/gzip_ostream.h"
+#    include "reader/compressed_file_reader.h"
+#endif
+#ifdef HAS_LZ4
+#    include "common/lz4_ostream.h"
+#    include "reader/lz4_file_reader.h"
+#endif
+#ifdef HAS_ZIP
+#    include "common/zipfile_ostream.h"
+#    include "reader/zipfile_file_reader.h"
+#endif
+#ifdef HAS_ZSTD
+#    include "common/columnar_ostream.h"
+#    include "common/zstd_ostream.h"
+#    include "reader/columnar_file_reader.h"
+#    include "reader/zstd_file_reader.h"
+#endif
+
+namespace dynamorio {
+namespace drmemtrace {
+
+namespace {
+
+#ifdef HAS_ZLIB
+// The gzip readers also read uncompressed files.
+typedef compressed_file_reader_t plain_file_reader_t;
+typedef compressed_record_file_reader_t plain_record_file_reader_t;
+#else
+typedef file_reader_t<std::ifstream *> plain_file_reader_t;
+typedef record_file_reader_t<std::ifstream> plain_record_file_reader_t;
+#endif
+
+struct format_t {
+    std::string name;
+    std::string suffix;
+    // Whether chunks are written as separate components.
+    bool archive;
+    std::function<std::unique_ptr<std::ostream>(const std::string &)> create_writer;
+    std::function<std::unique_ptr<reader_t>(const std::string &)> create_reader;
+};
+
+double
+seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+template <typename T>
+bool
+load_records_from(const std::string &path, std::vector<trace_entry_t> *records)
+{
+    T reader(path);
+    // Only the eof state of the end reader is examined.
+    plain_record_file_reader_t end;
+    if (!reader.init())
+        return false;
+    for (; reader != end; ++reader)
+        records->push_back(*reader);
+    return true;
+}
+
+bool
+load_records(const std::string &path, std::vector<trace_entry_t> *records)
+{
+#ifdef HAS_ZIP
+    if (ends_with(path, ".zip"))
+        return load_records_from<zipfile_record_file_reader_t>(path, records);
+#endif
+    return load_records_from<plain_record_file_reader_t>(path, records);
+}
+
+std::vector<format_t>
+get_formats()
+{
+    std::vector<format_t> formats;
+    formats.push_back(
+        { "none", ".trace", false,
+          [](const std::string &path) {
+              return std::unique_ptr<std::ostream>(
+                  new std::ofstream(path, std::ofstream::binary));
+          },
+          [](const std::string &path) {
+              return std::unique_ptr<reader_t>(new plain_file_reader_t(path));
+          } });
+#ifdef HAS_ZLIB
+    formats.push_back(
+        { "gzip", ".trace.gz", false,
+          [](const std::string &path) {
+              return std::unique_ptr<std::ostream>(new gzip_ostream_t(path));
+          },
+          [](const std::string &path) {
+              return std::unique_ptr<reader_t>(new compressed_file_reader_t(path));
+          } });
+#endif
+#ifdef HAS_LZ4
+    formats.push_back(
+        { "lz4", ".trace.lz4", false,
+          [](const std::string &path) {
+              return std::unique_ptr<std::ostream>(new lz4_ostream_t(path));
+          },
+          [](const std::string &path) {
+              return std::unique_ptr<reader_t>(new lz4_file_reader_t(path));
+          } });
+#endif
+#ifdef HAS_ZIP
+    formats.push_back(
+        { "zip", ".trace.zip", true,
+          [](const std::string &path) {
+              return std::unique_ptr<std::ostream>(new zipfile_ostream_t(path));
+          },
+          [](const std::string &path) {
+              return std::unique_ptr<reader_t>(new zipfile_file_reader_t(path));
+          } });
+#endif
+#ifdef HAS_ZSTD
+    for (int level : { 1, 3, 9, 19 }) {
+        formats.push_back(
+            { "zstd-" + std::to_string(level), ".trace.zst", true,
+              [level](const std::string &path) {
+                  return std::unique_ptr<std::ostream>(new zstd_ostream_t(path, level));
+              },
+              [](const std::string &path) {
+                  return std::unique_ptr<reader_t>(new zstd_file_reader_t(path));
+              } });
+    }
+    // The second columnar reader measures an instruction-only tool, which
+    // leaves the data addresses compressed.
+    for (bool skip_data : { false, true }) {
+        formats.push_back(
+            { skip_data ? "col-noda" : "columnar", ".trace.col", true,
+              [](const std::string &path) {
+                  return std::unique_ptr<std::ostream>(new columnar_ostream_t(path));
+              },
+              [skip_data](const std::string &path) {
+                  return std::unique_ptr<reader_t>(
+                      new columnar_file_reader_t(path, 0, skip_data));
+              } });
+    }
+#endif
+    return formats;
+}
+
+bool
+write_records(const format_t &format, const std::string &path,
+              const std::vector<trace_entry_t> &records)
+{
+    std::unique_ptr<std::ostream> out = format.create_writer(path);
+    if (!*out)
+        return false;
+    archive_ostream_t *archive = nullptr;
+    if (format.archive) {
+        archive = reinterpret_cast<archive_ostream_t *>(out.get());
+        if (!archive->open_new_component(TRACE_CHUNK_PREFIX "0").empty())
+            return false;
+    }
+    uint64_t chunk = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (archive == nullptr || i + 1 < records.size()) {
+            const trace_entry_t &entry = records[i];
+            if (entry.type != TRACE_TYPE_MARKER ||
+                entry.size != TRACE_MARKER_TYPE_CHUNK_FOOTER)
+                continue;
+        }
+        // Write the chunk ending with this footer in one call.
+        if (!out->write(reinterpret_cast<const char *>(&records[start]),
+                        (i + 1 - start) * sizeof(trace_entry_t)))
+            return false;
+        start = i + 1;
+        if (archive != nullptr && start < records.size()) {
+            ++chunk;
+            if (!archive->open_new_component(TRACE_CHUNK_PREFIX + std::to_string(chunk))
+                     .empty())
+                return false;
+        }
+    }
+    if (start < records.size() &&
+        !out->write(reinterpret_cast<const char *>(&records[start]),
+                    (records.size() - start) * sizeof(trace_entry_t)))
+        return false;
+    return true;
+}
+
+int64_t
+file_size(const std::string &path)
+{
+    std::ifstream file(path, std::ifstream::binary | std::ifstream::ate);
+    if (!file)
+        return -1;
+    return static_cast<int64_t>(file.tellg());
+}
+
+bool
+run_format(const format_t &format, const std::string &scratch_dir,
+           const std::vector<trace_entry_t> &records)
+{
+    const std::string path =
+        scratch_dir + DIRSEP + "drmemtrace.compression_benchmark" + format.suffix;
+    auto start = std::chrono::steady_clock::now();
+    if (!write_records(format, path, records)) {
+        std::cerr << "Failed to write " << path << "\n";
+        return false;
+    }
+    double write_secs = seconds_since(start);
+    int64_t size = file_size(path);
+
+    start = std::chrono::steady_clock::now();
+    std::unique_ptr<reader_t> reader = format.create_reader(path);
+    plain_file_reader_t end;
+    if (!reader->init()) {
+        std::cerr << "Failed to read " << path << "\n";
+        return false;
+    }
+    uint64_t memrefs = 0;
+    for (; *reader != end; ++*reader)
+        ++memrefs;
+    uint64_t instrs = reader->get_instruction_ordinal();
+    double read_secs = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    reader = format.create_reader(path);
+    if (!reader->init()) {
+        std::cerr << "Failed to read " << path << "\n";
+        return false;
+    }
+    reader->skip_instructions(instrs / 2);
+    if (*reader == end || reader->get_instruction_ordinal() != instrs / 2) {
+        std::cerr << "Failed to skip to instruction " << instrs / 2 << " in " << path
+                  << "\n";
+        return false;
+    }
+    double skip_secs = seconds_since(start);
+    remove(path.c_str());
+
+    const double raw_bytes = static_cast<double>(records.size() * sizeof(trace_entry_t));
+    std::cout << "  " << std::setw(8) << std::left << format.name << std::right
+              << std::setw(12) << size << " bytes, ratio " << std::setw(6)
+              << raw_bytes / size << ", write " << std::setw(8)
+              << raw_bytes / write_secs / 1e6 << " MB/s, read " << std::setw(8)
+              << memrefs / read_secs / 1e6 << " M/s, skip " << std::setw(8)
+              << skip_secs * 1e3 << " ms\n";
+    return true;
+}
+
+} // namespace
+
+int
+test_main(int argc, const char *argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " trace_file [scratch_dir]\n";
+        return 1;
+    }
+    std::string trace_file = argv[1];
+    std::string scratch_dir = ".";
+    if (argc > 2)
+        scratch_dir = argv[2];
+    std::vector<trace_entry_t> records;
+    if (!load_records(trace_file, &records) || records.empty()) {
+        std::cerr << "Failed to read trace " << trace_file << "\n";
+        return 1;
+    }
+    std::cout << trace_file << ": " << records.size() << " records\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (const format_t &format : get_formats()) {
+        if (!run_format(format, scratch_dir, records))
+            return 1;
+    }
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -33,6 +33,7 @@
 /* Tests for the decode_cache_t library. */
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
 // Needs to be included before memref.h or build_target_arch_type() will not
@@ -441,6 +442,102 @@ check_init_error_cases(void *drcontext)
     return "";
 }
 
+std::string
+check_shared_decode_cache(void *drcontext)
+{
+    static constexpr addr_t BASE_ADDR = 0x123450;
+    instr_t *nop = XINST_CREATE_nop(drcontext);
+    instr_t *ret = XINST_CREATE_return(drcontext);
+    instr_t *interrupt = XINST_CREATE_interrupt(drcontext, OPND_CREATE_INT8(10));
+    instrlist_t *ilist = instrlist_create(drcontext);
+    instrlist_append(ilist, nop);
+    instrlist_append(ilist, ret);
+    instrlist_append(ilist, interrupt);
+    std::vector<memref_with_IR_t> memref_setup = {
+        { gen_instr(TID_A), nop },
+        { gen_instr(TID_A), ret },
+        { gen_instr(TID_A), nop },
+        { gen_instr(TID_A), interrupt },
+    };
+    std::vector<memref_t> memrefs =
+        add_encodings_to_memrefs(ilist, memref_setup, BASE_ADDR);
+
+    // Two caches, as for two tools or shards, decode each unique instr only once
+    // between them.
+    auto shared = std::make_shared<shared_decode_cache_t>(1024);
+    decode_cache_base_t::set_shared_decode_cache(shared);
+    test_decode_info_t::expect_decoded_instr_ = true;
+    test_decode_cache_t<test_decode_info_t> first(drcontext,
+                                                  /*include_decoded_instr=*/true,
+                                                  /*persist_decoded_instr=*/false);
+    test_decode_cache_t<test_decode_info_t> second(drcontext,
+                                                   /*include_decoded_instr=*/true,
+                                                   /*persist_decoded_instr=*/false);
+    std::string err = first.init(ENCODING_FILE_TYPE);
+    if (err.empty())
+        err = second.init(ENCODING_FILE_TYPE);
+    if (!err.empty())
+        return err;
+    for (const memref_t &memref : memrefs) {
+        test_decode_info_t *decode_info;
+        err = first.add_decode_info(memref.instr, decode_info);
+        if (err.empty())
+            err = second.add_decode_info(memref.instr, decode_info);
+        if (!err.empty())
+            return err;
+    }
+    // The second cache hits in the shared one for each instr, as does each cache
+    // for the repeated nop with its encoding_is_new.
+    if (shared->get_decode_count() != 3 || shared->get_hit_count() != 5 ||
+        shared->size() != 3) {
+        return "Expected one shared decode per unique instr";
+    }
+    test_decode_info_t *decode_info_ret =
+        second.get_decode_info(reinterpret_cast<app_pc>(memrefs[1].instr.addr));
+    if (decode_info_ret == nullptr || !decode_info_ret->is_ret_)
+        return "Unexpected test_decode_info_t for shared ret instr";
+
+    // A persisted instr is a private copy of the shared one.
+    test_decode_cache_t<instr_decode_info_t> persisted(drcontext,
+                                                       /*include_decoded_instr=*/true,
+                                                       /*persist_decoded_instr=*/true);
+    err = persisted.init(ENCODING_FILE_TYPE);
+    if (!err.empty())
+        return err;
+    instr_decode_info_t *decode_info_nop;
+    err = persisted.add_decode_info(memrefs[0].instr, decode_info_nop);
+    if (!err.empty())
+        return err;
+    if (!instr_is_nop(decode_info_nop->get_decoded_instr()) ||
+        shared->get_decode_count() != 3) {
+        return "Unexpected persisted instr from the shared cache";
+    }
+    decode_cache_base_t::set_shared_decode_cache(nullptr);
+
+    // Past its bound, the cache evicts an instr not recently used.
+    shared_decode_cache_t bounded(2);
+    auto decode = [&](int index) {
+        return bounded.decode(drcontext, memrefs[index].instr.encoding,
+                              reinterpret_cast<app_pc>(memrefs[index].instr.addr),
+                              memrefs[index].instr.size);
+    };
+    std::shared_ptr<const shared_decode_cache_t::decoded_t> first_nop = decode(0);
+    decode(1);
+    decode(3);
+    if (bounded.size() != 2 || bounded.get_eviction_count() != 1)
+        return "Expected an eviction past the bound";
+    // The evicted entry remains valid while held, and is decoded anew.
+    std::shared_ptr<const shared_decode_cache_t::decoded_t> second_nop = decode(0);
+    if (bounded.get_decode_count() != 4 || first_nop == second_nop ||
+        !instr_is_nop(first_nop->instr) || !instr_is_nop(second_nop->instr)) {
+        return "Expected the evicted nop to be decoded again";
+    }
+
+    instrlist_clear_and_destroy(drcontext, ilist);
+    std::cerr << "check_shared_decode_cache passed\n";
+    return "";
+}
+
 int
 test_main(int argc, const char *argv[])
 {
@@ -496,6 +593,11 @@ test_main(int argc, const char *argv[])
         std::cerr << err << "\n";
         exit(1);
     }
+    err = check_shared_decode_cache(drcontext);
+    if (!err.empty()) {
+        std::cerr << err << "\n";
+        exit(1);
+    }
 
     return 0;
 }
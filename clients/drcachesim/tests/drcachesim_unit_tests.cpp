@@ -36,6 +36,9 @@
 #include <cstdlib>
 #include <random>
 #include <regex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <assert.h>
 #include "config_reader_unit_test.h"
@@ -47,6 +50,8 @@
 #include "simulator/policy_lfu.h"
 #include "simulator/policy_lru.h"
 #include "simulator/prefetcher.h"
+#include "simulator/prefetcher_sms.h"
+#include "simulator/tag_lookup.h"
 #include "../common/memref.h"
 #include "../common/utils.h"
 #include "test_helpers.h"
@@ -375,6 +380,187 @@ unit_test_custom_prefetcher()
     assert(next2line_prefetcher_factory.prefetcher_->hits_ == 4);
     assert(next2line_prefetcher_factory.prefetcher_->misses_ == 2);
 }
+
+static void
+run_prefetcher_test(cache_simulator_t &cache_sim, const std::vector<memref_t> &refs)
+{
+    for (const memref_t &ref : refs) {
+        if (!cache_sim.process_memref(ref)) {
+            std::cerr << "drcachesim unit_test_table_prefetchers failed: "
+                      << cache_sim.get_error_string() << "\n";
+            exit(1);
+        }
+    }
+}
+
+void
+unit_test_table_prefetchers()
+{
+    const int LINE_SIZE = 64;
+    auto make_pc_memref = [](addr_t address, addr_t pc) {
+        memref_t ref = make_memref(address);
+        ref.data.pc = pc;
+        return ref;
+    };
+    {
+        // A single instruction striding by 3 lines.  The stride is confirmed on the
+        // third access, after which every access hits a prefetched line.
+        std::vector<memref_t> refs;
+        for (int i = 0; i < 10; i++)
+            refs.push_back(make_pc_memref(i * 3 * LINE_SIZE, 0x1000));
+        // Another instruction touching a single line must not disturb it.
+        refs.insert(refs.begin() + 5, make_pc_memref(31 * LINE_SIZE, 0x2044));
+        // Then evict everything, including the never-used final prefetch.
+        for (int i = 0; i < 40; i++)
+            refs.push_back(make_pc_memref((100 + i) * LINE_SIZE, 0x3000 + i * 4));
+        cache_simulator_knobs_t knobs = make_test_knobs();
+        knobs.data_prefetcher = "stride";
+        knobs.prefetcher_degree = 1;
+        knobs.prefetcher_late_distance = 1;
+        cache_simulator_t cache_sim(knobs);
+        run_prefetcher_test(cache_sim, refs);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::MISSES, 1, 0), 44);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_MISSES, 1, 0), 8);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_USEFUL, 1, 0), 7);
+        // Each prefetch is used by the very next access except for the one with the
+        // other instruction's access in between.
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_LATE, 1, 0), 6);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_UNUSED, 1, 0), 1);
+    }
+    for (int direction : { 1, -1 }) {
+        // Ascending and descending streams within one page, with a different
+        // PC for every access.
+        std::vector<memref_t> refs;
+        addr_t start = direction > 0 ? 0 : 63;
+        for (int i = 0; i < 16; i++) {
+            refs.push_back(
+                make_pc_memref((start + direction * i) * LINE_SIZE, 0x1000 + i * 4));
+        }
+        cache_simulator_knobs_t knobs = make_test_knobs();
+        knobs.data_prefetcher = "stream";
+        knobs.prefetcher_degree = 4;
+        cache_simulator_t cache_sim(knobs);
+        run_prefetcher_test(cache_sim, refs);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::MISSES, 1, 0), 3);
+        // The stream stays 4 lines ahead of the last access.
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_MISSES, 1, 0), 17);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_USEFUL, 1, 0), 13);
+    }
+    {
+        // The same 3-line footprint in 40 regions of 32 lines.  Footprints are only
+        // learned once their generation leaves the 32-entry accumulation table, so
+        // only the last 8 regions are prefetched.
+        const int REGIONS = 40;
+        const int REGION_LINES = 32;
+        std::vector<memref_t> refs;
+        for (int i = 0; i < REGIONS; i++) {
+            addr_t base = i * REGION_LINES * LINE_SIZE;
+            refs.push_back(make_pc_memref(base, 0x1000));
+            refs.push_back(make_pc_memref(base + 5 * LINE_SIZE, 0x2000));
+            refs.push_back(make_pc_memref(base + 9 * LINE_SIZE, 0x3000));
+        }
+        cache_simulator_knobs_t knobs = make_test_knobs();
+        knobs.data_prefetcher = "sms";
+        cache_simulator_t cache_sim(knobs);
+        run_prefetcher_test(cache_sim, refs);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::MISSES, 1, 0),
+                prefetcher_sms_t::ACCUMULATION_TABLE_ENTRIES * 3 +
+                    (REGIONS - prefetcher_sms_t::ACCUMULATION_TABLE_ENTRIES));
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_USEFUL, 1, 0),
+                (REGIONS - prefetcher_sms_t::ACCUMULATION_TABLE_ENTRIES) * 2);
+    }
+    {
+        // The default nextline prefetcher does not pay for usefulness tracking.
+        std::vector<memref_t> refs;
+        for (int i = 0; i < 16; i++)
+            refs.push_back(make_pc_memref(i * 2 * LINE_SIZE, 0x1000));
+        cache_simulator_knobs_t knobs = make_test_knobs();
+        knobs.data_prefetcher = "nextline";
+        cache_simulator_t cache_sim(knobs);
+        run_prefetcher_test(cache_sim, refs);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_MISSES, 1, 0), 16);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_USEFUL, 1, 0), 0);
+        TEST_EQ(cache_sim.get_cache_metric(metric_name_t::PREFETCH_UNUSED, 1, 0), 0);
+    }
+}
+static void
+run_sweep_test(cache_simulator_t &cache_sim, const std::vector<memref_t> &refs)
+{
+    for (const memref_t &ref : refs) {
+        if (!cache_sim.process_memref(ref)) {
+            std::cerr << "drcachesim unit_test_LL_sweep failed: "
+                      << cache_sim.get_error_string() << "\n";
+            exit(1);
+        }
+    }
+}
+
+void
+unit_test_LL_sweep()
+{
+    // Each configuration in the sweep must see exactly what a separate simulation
+    // with that LLC would, whether it shares an LRU stack or has its own cache.
+    const int LINE_SIZE = 64;
+    const std::string SWEEP = "4K:4,8K,8K:8,16K:16,16K:1,1K:2";
+    const std::vector<std::pair<uint64_t, unsigned int>> configs = {
+        { 4 * 1024, 4 },  { 8 * 1024, 32 },  { 8 * 1024, 8 },
+        { 16 * 1024, 16 }, { 16 * 1024, 1 }, { 1024, 2 },
+    };
+    std::vector<memref_t> refs;
+    std::mt19937 rng(42);
+    for (int i = 0; i < 20000; i++) {
+        // Mostly a working set larger than the L1, with some far-away lines.
+        addr_t line = rng() % 512;
+        if (rng() % 8 == 0)
+            line += 4096 + rng() % 4096;
+        refs.push_back(make_memref(line * LINE_SIZE));
+    }
+    // A line-crossing access and a flush.
+    refs.push_back(make_memref(3 * LINE_SIZE - 2, TRACE_TYPE_READ, 4));
+    memref_t flush = make_memref(0, TRACE_TYPE_DATA_FLUSH, 8 * LINE_SIZE);
+    flush.flush.addr = 0;
+    flush.flush.size = 8 * LINE_SIZE;
+    refs.push_back(flush);
+    for (int i = 0; i < 16; i++)
+        refs.push_back(make_memref(i * LINE_SIZE));
+    for (const std::string &policy : { "LRU", "FIFO" }) {
+        cache_simulator_knobs_t knobs = make_test_knobs();
+        knobs.L1D_size = 1024;
+        knobs.L1D_assoc = 4;
+        knobs.replace_policy = policy;
+        knobs.LL_sweep = SWEEP;
+        cache_simulator_t sweep_sim(knobs);
+        if (!sweep_sim) {
+            std::cerr << "drcachesim unit_test_LL_sweep failed: "
+                      << sweep_sim.get_error_string() << "\n";
+            exit(1);
+        }
+        run_sweep_test(sweep_sim, refs);
+        TEST_EQ(sweep_sim.get_LL_sweep_metric(metric_name_t::MISSES,
+                                              static_cast<int>(configs.size())),
+                STATS_ERROR_NO_CACHE_STATS);
+        for (size_t i = 0; i < configs.size(); i++) {
+            knobs.LL_sweep = "";
+            knobs.LL_size = configs[i].first;
+            knobs.LL_assoc = configs[i].second;
+            cache_simulator_t single_sim(knobs);
+            run_sweep_test(single_sim, refs);
+            TEST_EQ(sweep_sim.get_LL_sweep_metric(metric_name_t::HITS,
+                                                  static_cast<int>(i)),
+                    single_sim.get_cache_metric(metric_name_t::HITS, 2, 0));
+            TEST_EQ(sweep_sim.get_LL_sweep_metric(metric_name_t::MISSES,
+                                                  static_cast<int>(i)),
+                    single_sim.get_cache_metric(metric_name_t::MISSES, 2, 0));
+        }
+    }
+    for (const std::string &bad_sweep : { "4K:3", "3K", "4K:", "4Q", "," }) {
+        cache_simulator_knobs_t knobs = make_test_knobs();
+        knobs.LL_sweep = bad_sweep;
+        cache_simulator_t sim(knobs);
+        assert(!sim);
+    }
+}
+
 void
 unit_test_child_hits()
 {
@@ -1264,6 +1450,217 @@ Core #1 \(traced CPU\(s\): #567800\)
     }
 }
 
+void
+unit_test_tag_lookup()
+{
+    // Cover every vector width plus the scalar tail, with the match in each way.
+    for (int count = 1; count <= 33; ++count) {
+        std::vector<addr_t> tags(count);
+        for (int i = 0; i < count; ++i)
+            tags[i] = 0x1000 + i;
+        // Differs from the first tag only in the upper 32 bits, if there are any.
+        addr_t upper = static_cast<addr_t>(0x100000000ULL);
+        if (upper != 0)
+            TEST_EQ(find_tag_in_set(tags.data(), count, 0x1000 + upper), -1);
+        TEST_EQ(find_tag_in_set(tags.data(), count, TAG_INVALID), -1);
+        for (int way = 0; way < count; ++way) {
+            TEST_EQ(find_tag_in_set(tags.data(), count, 0x1000 + way), way);
+            // The first match wins.
+            addr_t saved = tags[count - 1];
+            tags[count - 1] = tags[way];
+            TEST_EQ(find_tag_in_set(tags.data(), count, tags[way]), way);
+            tags[count - 1] = saved;
+        }
+    }
+}
+
+static void
+run_parallel_sim(cache_simulator_t &sim, const std::vector<std::vector<memref_t>> &refs)
+{
+    std::string error = sim.initialize_stream(nullptr);
+    assert(error.empty());
+    error = sim.initialize_shard_type(SHARD_BY_CORE);
+    assert(error.empty());
+    std::vector<std::thread> threads;
+    for (int core = 0; core < static_cast<int>(refs.size()); ++core) {
+        threads.emplace_back([&sim, &refs, core]() {
+            default_memtrace_stream_t stream;
+            stream.set_shard_index(core);
+            stream.set_output_cpuid(core);
+            void *worker_data = sim.parallel_worker_init(core);
+            void *shard_data = sim.parallel_shard_init_stream(core, worker_data, &stream);
+            for (const memref_t &ref : refs[core]) {
+                bool res = sim.parallel_shard_memref(shard_data, ref);
+                assert(res);
+            }
+            bool res = sim.parallel_shard_exit(shard_data);
+            assert(res);
+            std::string error = sim.parallel_worker_exit(worker_data);
+            assert(error.empty());
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+static void
+run_serial_sim(cache_simulator_t &sim, const std::vector<std::vector<memref_t>> &refs)
+{
+    default_memtrace_stream_t stream;
+    sim.initialize_stream(&stream);
+    std::string error = sim.initialize_shard_type(SHARD_BY_CORE);
+    assert(error.empty());
+    // Mirror the -core_serial rotation: core 1 first and core 0 last.
+    int num_cores = static_cast<int>(refs.size());
+    for (size_t step = 0;; ++step) {
+        bool any = false;
+        for (int i = 1; i <= num_cores; ++i) {
+            int core = i % num_cores;
+            if (step >= refs[core].size())
+                continue;
+            any = true;
+            stream.set_shard_index(core);
+            stream.set_output_cpuid(core);
+            bool res = sim.process_memref(refs[core][step]);
+            assert(res);
+        }
+        if (!any)
+            break;
+    }
+}
+
+void
+unit_test_parallel_sim()
+{
+    cache_simulator_knobs_t knobs = make_test_knobs();
+    knobs.num_cores = 4;
+    knobs.LL_size = 128 * 64;
+    knobs.LL_assoc = 8;
+    knobs.L1I_assoc = 4;
+    knobs.L1D_assoc = 4;
+    knobs.sim_parallel_batch = 7;
+    // Give each core a different length so cores leave at different points.
+    std::vector<std::vector<memref_t>> refs(knobs.num_cores);
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<addr_t> addr_dist(0, 512 * 64);
+    for (int core = 0; core < static_cast<int>(knobs.num_cores); ++core) {
+        for (int i = 0; i < 2000 + 300 * core; ++i) {
+            trace_type_t type = TRACE_TYPE_READ;
+            switch (rng() % 5) {
+            case 0: type = TRACE_TYPE_INSTR; break;
+            case 1: type = TRACE_TYPE_WRITE; break;
+            case 2: type = TRACE_TYPE_DATA_FLUSH; break;
+            }
+            memref_t ref = make_memref(addr_dist(rng), type);
+            if (rng() % 11 == 0) {
+                // Idle markers count toward the rotation too.
+                ref.marker.type = TRACE_TYPE_MARKER;
+                ref.marker.marker_type = TRACE_MARKER_TYPE_CORE_IDLE;
+            }
+            refs[core].push_back(ref);
+        }
+    }
+    {
+        // Without coherence or inclusive shared caches the results must match
+        // the serial results exactly.
+        cache_simulator_t serial(knobs);
+        run_serial_sim(serial, refs);
+        knobs.sim_parallel = true;
+        cache_simulator_t parallel(knobs);
+        run_parallel_sim(parallel, refs);
+        knobs.sim_parallel = false;
+        for (metric_name_t metric :
+             { metric_name_t::HITS, metric_name_t::MISSES, metric_name_t::CHILD_HITS,
+               metric_name_t::FLUSHES }) {
+            for (unsigned level = 1; level <= 2; ++level) {
+                for (unsigned core = 0; core < knobs.num_cores; ++core) {
+                    for (cache_split_t split :
+                         { cache_split_t::DATA, cache_split_t::INSTRUCTION }) {
+                        TEST_EQ(parallel.get_cache_metric(metric, level, core, split),
+                                serial.get_cache_metric(metric, level, core, split));
+                    }
+                }
+            }
+        }
+        assert(parallel.get_cache_metric(metric_name_t::MISSES, 2) > 0);
+        assert(parallel.get_cache_metric(metric_name_t::HITS, 2) > 0);
+    }
+    {
+        // Test the unsupported combinations.
+        knobs.sim_parallel = true;
+        knobs.warmup_refs = 10;
+        cache_simulator_t sim(knobs);
+        assert(!sim.initialize_stream(nullptr).empty());
+        knobs.warmup_refs = 0;
+        knobs.model_coherence = true;
+        cache_simulator_t sim_coherent(knobs);
+        assert(!sim_coherent.initialize_stream(nullptr).empty());
+        knobs.model_coherence = false;
+        cache_simulator_t sim2(knobs);
+        assert(sim2.initialize_stream(nullptr).empty());
+        assert(!sim2.initialize_shard_type(SHARD_BY_THREAD).empty());
+    }
+    for (bool llc_inclusive : { false, true }) {
+        // An inclusive shared cache is rejected while inclusive private ones are not.
+        std::string config = R"MYCONFIG(// 2 cores with private inclusive L2 caches.
+num_cores       2
+line_size       64
+sim_parallel    true
+
+L1I0 {
+  type            instruction
+  core            0
+  size            1K
+  assoc           1
+  parent          L2_0
+}
+L1D0 {
+  type            data
+  core            0
+  size            1K
+  assoc           1
+  parent          L2_0
+}
+L1I1 {
+  type            instruction
+  core            1
+  size            1K
+  assoc           1
+  parent          L2_1
+}
+L1D1 {
+  type            data
+  core            1
+  size            1K
+  assoc           1
+  parent          L2_1
+}
+L2_0 {
+  size            4K
+  assoc           4
+  inclusive       true
+  parent          LLC
+}
+L2_1 {
+  size            4K
+  assoc           4
+  inclusive       true
+  parent          LLC
+}
+LLC {
+  size            16K
+  assoc           8
+  parent          memory
+)MYCONFIG";
+        config += std::string("  inclusive       ") +
+            (llc_inclusive ? "true" : "false") + "\n}\n";
+        std::istringstream config_in(config);
+        cache_simulator_t sim(&config_in);
+        assert(!!sim);
+        TEST_EQ(sim.initialize_stream(nullptr).empty(), !llc_inclusive);
+    }
+}
+
 int
 test_main(int argc, const char *argv[])
 {
@@ -1274,6 +1671,7 @@ test_main(int argc, const char *argv[])
     unit_test_exclusive_cache_policy();
     unit_test_exclusive_cache_policy_rand();
     unit_test_cache_accessors();
+    unit_test_tag_lookup();
     unit_test_config_reader(std::string(argv[1]));
     unit_test_v2p_reader(std::string(argv[1]));
     unit_test_tlb_simulator(std::string(argv[1]));
@@ -1287,10 +1685,13 @@ test_main(int argc, const char *argv[])
     unit_test_warmup_refs();
     unit_test_sim_refs();
     unit_test_child_hits();
+    unit_test_LL_sweep();
     unit_test_cache_replacement_policy();
     unit_test_core_sharded();
+    unit_test_parallel_sim();
     unit_test_nextline_prefetcher();
     unit_test_custom_prefetcher();
+    unit_test_table_prefetchers();
     unit_test_set_parent();
     return 0;
 }
@@ -0,0 +1,178 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Microbenchmark for flat_hash_map_t.
+ *
+ * Compares flat_hash_map_t against std::unordered_map on the access patterns of
+ * the tools that keep per-cache-line state: counting (histogram_t), updating a
+ * last-access time (reuse_time_t), and inserting with pruning of the oldest
+ * entry (reuse_distance_t with a distance limit).  Run with an optional
+ * operation count:
+ *   $ tool.drcachesim.flat_hash_map_benchmark [num_ops]
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "flat_hash_map.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+namespace {
+
+// Keeps the compiler from discarding the work.
+volatile uint64_t benchmark_sink;
+
+double
+elapsed_ns(std::chrono::steady_clock::time_point start, uint64_t count)
+{
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / count;
+}
+
+// Cache line keys drawn from a working set of "num_lines" lines, skewed so that a
+// small fraction of lines receives most accesses, as in real traces.
+std::vector<uint64_t>
+make_keys(uint64_t num_lines)
+{
+    std::mt19937_64 rng(num_lines);
+    std::vector<uint64_t> keys(1 << 20);
+    for (uint64_t &key : keys) {
+        uint64_t line = rng() % num_lines;
+        if (rng() % 4 != 0)
+            line %= (num_lines / 16 + 1);
+        key = (0x7f0000000000ULL >> 6) + line * 7;
+    }
+    return keys;
+}
+
+template <typename Map>
+double
+bench_count(const std::vector<uint64_t> &keys, uint64_t num_ops)
+{
+    Map map;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_ops; ++i)
+        ++map[keys[i & (keys.size() - 1)]];
+    double ns = elapsed_ns(start, num_ops);
+    benchmark_sink = map.size();
+    return ns;
+}
+
+template <typename Map>
+double
+bench_update(const std::vector<uint64_t> &keys, uint64_t num_ops)
+{
+    Map map;
+    uint64_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_ops; ++i) {
+        uint64_t key = keys[i & (keys.size() - 1)];
+        auto it = map.find(key);
+        if (it == map.end())
+            map.emplace(key, i);
+        else {
+            total += i - it->second;
+            it->second = i;
+        }
+    }
+    double ns = elapsed_ns(start, num_ops);
+    benchmark_sink = total;
+    return ns;
+}
+
+// A distinct, scattered line for each ordinal.
+uint64_t
+new_line(uint64_t ordinal)
+{
+    return (ordinal * 0x9e3779b97f4a7c15ULL) >> 6;
+}
+
+template <typename Map>
+double
+bench_prune(uint64_t limit, uint64_t num_ops)
+{
+    Map map;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_ops; ++i) {
+        map.emplace(new_line(i), i);
+        if (i >= limit)
+            map.erase(new_line(i - limit));
+    }
+    double ns = elapsed_ns(start, num_ops);
+    benchmark_sink = map.size();
+    return ns;
+}
+
+void
+report(const char *name, uint64_t lines, double std_ns, double flat_ns)
+{
+    std::cout << "  " << std::setw(8) << name << std::setw(9) << lines
+              << " lines: unordered_map " << std::setw(6) << std_ns << " ns, flat "
+              << std::setw(6) << flat_ns << " ns (" << std_ns / flat_ns << "x)\n";
+}
+
+} // namespace
+
+int
+test_main(int argc, const char *argv[])
+{
+    uint64_t num_ops = 20000000;
+    if (argc > 1)
+        num_ops = strtoull(argv[1], nullptr, 10);
+    typedef std::unordered_map<uint64_t, uint64_t> std_map_t;
+    typedef flat_hash_map_t<uint64_t, uint64_t> flat_map_t;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Per-operation time:\n";
+    for (uint64_t lines : { 1ULL << 10, 1ULL << 16, 1ULL << 20 }) {
+        std::vector<uint64_t> keys = make_keys(lines);
+        report("count", lines, bench_count<std_map_t>(keys, num_ops),
+               bench_count<flat_map_t>(keys, num_ops));
+        report("update", lines, bench_update<std_map_t>(keys, num_ops),
+               bench_update<flat_map_t>(keys, num_ops));
+        report("prune", lines, bench_prune<std_map_t>(lines, num_ops),
+               bench_prune<flat_map_t>(lines, num_ops));
+    }
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,179 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Tests for flat_hash_map_t. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "flat_hash_map.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+#define CHECK(cond, msg, ...)             \
+    do {                                  \
+        if (!(cond)) {                    \
+            fprintf(stderr, "%s\n", msg); \
+            exit(1);                      \
+        }                                 \
+    } while (0)
+
+// Applies the same random operations to a flat_hash_map_t and a
+// std::unordered_map and checks that they agree throughout.
+static void
+test_against_unordered_map()
+{
+    flat_hash_map_t<uint64_t, uint64_t> map;
+    std::unordered_map<uint64_t, uint64_t> reference;
+    std::mt19937_64 rng(42);
+    for (int i = 0; i < 500000; ++i) {
+        // Multiples of the cache line size, like the tools' keys, with enough
+        // erasures to exercise deleted slots.
+        uint64_t key = (rng() % 20000) << 6;
+        switch (rng() % 4) {
+        case 0:
+            CHECK(map.erase(key) == reference.erase(key), "erase by key mismatch");
+            break;
+        case 1: {
+            auto it = map.find(key);
+            auto ref_it = reference.find(key);
+            CHECK((it == map.end()) == (ref_it == reference.end()), "find mismatch");
+            if (ref_it != reference.end()) {
+                CHECK(it->first == key && it->second == ref_it->second,
+                      "found value mismatch");
+                if (rng() % 2 == 0) {
+                    map.erase(it);
+                    reference.erase(ref_it);
+                }
+            }
+            break;
+        }
+        default:
+            map[key] += i;
+            reference[key] += i;
+        }
+        CHECK(map.size() == reference.size(), "size mismatch");
+    }
+    size_t count = 0;
+    for (const auto &entry : map) {
+        auto ref_it = reference.find(entry.first);
+        CHECK(ref_it != reference.end() && ref_it->second == entry.second,
+              "iteration mismatch");
+        ++count;
+    }
+    CHECK(count == reference.size(), "iteration count mismatch");
+}
+
+static void
+test_api()
+{
+    flat_hash_map_t<int, std::string> map = { { 1, "one" }, { 2, "two" } };
+    CHECK(map.size() == 2 && map.at(2) == "two", "initializer list failed");
+    auto res = map.try_emplace(3, "three");
+    CHECK(res.second && res.first->second == "three", "try_emplace insert failed");
+    res = map.try_emplace(3, "other");
+    CHECK(!res.second && res.first->second == "three", "try_emplace existing failed");
+    CHECK(map.insert(std::make_pair(4, std::string("four"))).second, "insert failed");
+    CHECK(map.count(4) == 1 && map.count(5) == 0, "count failed");
+    bool threw = false;
+    try {
+        map.at(5);
+    } catch (const std::out_of_range &) {
+        threw = true;
+    }
+    CHECK(threw, "at() should throw for a missing key");
+
+    // Copies are independent; moves leave the source empty.
+    flat_hash_map_t<int, std::string> copy = map;
+    CHECK(copy == map, "copy mismatch");
+    copy[1] = "uno";
+    CHECK(copy != map && map.at(1) == "one", "copy is not independent");
+    flat_hash_map_t<int, std::string> moved = std::move(copy);
+    CHECK(moved.size() == 4 && moved.at(1) == "uno", "move failed");
+    CHECK(copy.empty() && copy.begin() == copy.end(), "moved-from map not empty");
+
+    // Erasing every entry while iterating.
+    for (auto it = moved.begin(); it != moved.end();)
+        it = moved.erase(it);
+    CHECK(moved.empty(), "erase while iterating failed");
+
+    // Growth keeps every entry, and clear keeps the map usable.
+    flat_hash_map_t<int64_t, int64_t> big;
+    big.reserve(1000);
+    for (int64_t i = -5000; i < 5000; ++i)
+        big[i] = i * 2;
+    CHECK(big.size() == 10000, "growth lost entries");
+    for (int64_t i = -5000; i < 5000; ++i)
+        CHECK(big.at(i) == i * 2, "growth corrupted an entry");
+    big.clear();
+    CHECK(big.empty() && big.find(7) == big.end(), "clear failed");
+    big[7] = 1;
+    CHECK(big.size() == 1 && big.at(7) == 1, "insert after clear failed");
+}
+
+// Repeated insertion and erasure at a steady size must reuse deleted slots
+// rather than growing without bound, as in reuse_distance_t's pruning.
+static void
+test_steady_churn()
+{
+    flat_hash_map_t<uint64_t, uint64_t> map;
+    for (uint64_t i = 0; i < 1000000; ++i) {
+        map[i] = i;
+        if (i >= 1000)
+            CHECK(map.erase(i - 1000) == 1, "churn erase failed");
+    }
+    CHECK(map.size() == 1000, "churn size mismatch");
+    for (uint64_t i = 1000000 - 1000; i < 1000000; ++i)
+        CHECK(map.count(i) == 1, "churn lost an entry");
+}
+
+int
+test_main(int argc, const char *argv[])
+{
+    test_against_unordered_map();
+    test_api();
+    test_steady_churn();
+    std::cerr << "flat_hash_map_test passed\n";
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -70,12 +70,36 @@ test_basics()
     return true;
 }
 
+bool
+test_size_hint()
+{
+    flexible_queue_t<int, std::greater<int>> q;
+    assert(q.size_hint() == 0);
+    q.push(4);
+    q.push(3);
+    assert(q.size_hint() == 2);
+    // Duplicates are rejected and should not change the size.
+    q.push(3);
+    assert(q.size_hint() == 2);
+    q.erase(4);
+    assert(q.size_hint() == 1);
+    q.pop();
+    assert(q.size_hint() == 0);
+    assert(q.size_hint() == q.size());
+    // The queue must remain moveable.
+    q.push(7);
+    flexible_queue_t<int, std::greater<int>> moved(std::move(q));
+    assert(moved.size_hint() == 1);
+    assert(moved.top() == 7);
+    return true;
+}
+
 } // namespace
 
 int
 test_main(int argc, const char *argv[])
 {
-    if (!test_basics())
+    if (!test_basics() || !test_size_hint())
         return 1;
     return 0;
 }
@@ -79,10 +79,33 @@ check_cross_line()
     return true;
 }
 
+bool
+check_sketch_mode()
+{
+    static constexpr unsigned int LINE_SIZE = 64;
+    histogram_t tool(LINE_SIZE, 0, 0, /*sketch_mode=*/true);
+    for (int i = 0; i < 20000; ++i) {
+        tool.process_memref(gen_instr(1, (i % 500) * LINE_SIZE));
+        tool.process_memref(gen_data(1, /*load=*/true, i * LINE_SIZE, 8));
+        // Test repeated lines: should not affect unique.
+        tool.process_memref(gen_data(1, /*load=*/false, (i % 3) * LINE_SIZE, 8));
+    }
+    uint64_t unique_icache_lines, unique_dcache_lines;
+    tool.reduce_results(&unique_icache_lines, &unique_dcache_lines);
+    // The estimates have about 1.6% standard error.
+    if (unique_icache_lines < 490 || unique_icache_lines > 510 ||
+        unique_dcache_lines < 19000 || unique_dcache_lines > 21000) {
+        std::cerr << "got incorrect sketched icache " << unique_icache_lines
+                  << ", dcache " << unique_dcache_lines << "\n";
+        return false;
+    }
+    return true;
+}
+
 int
 test_main(int argc, const char *argv[])
 {
-    if (check_cross_line()) {
+    if (check_cross_line() && check_sketch_mode()) {
         std::cerr << "histogram_test passed\n";
         return 0;
     }
@@ -53,7 +53,7 @@ public:
         , instrs_(instrs)
     {
     }
-    std::unordered_map<int, int64_t>
+    flat_hash_map_t<int, int64_t>
     get_opcode_mix(void *shard)
     {
         shard_data_t *shard_data = reinterpret_cast<shard_data_t *>(shard);
@@ -141,7 +141,7 @@ check_opcode_mix(void *drcontext, bool use_module_mapper)
             return opcode_mix.parallel_shard_error(shard_data);
         }
     }
-    std::unordered_map<int, int64_t> mix = opcode_mix.get_opcode_mix(shard_data);
+    flat_hash_map_t<int, int64_t> mix = opcode_mix.get_opcode_mix(shard_data);
     if (mix.size() != 2) {
         return "Found incorrect count of opcodes";
     }
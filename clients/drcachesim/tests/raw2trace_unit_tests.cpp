@@ -103,12 +103,12 @@ class raw2trace_test_t : public raw2trace_t {
 public:
     raw2trace_test_t(const std::vector<std::istream *> &input,
                      const std::vector<std::ostream *> &output, instrlist_t &instrs,
-                     void *drcontext)
+                     void *drcontext, int worker_count = -1)
         : raw2trace_t(nullptr, input, output, {}, INVALID_FILE, nullptr, nullptr,
                       drcontext,
                       // The sequences are small so we print everything for easier
                       // debugging and viewing of what's going on.
-                      /*verbosity=*/4)
+                      /*verbosity=*/4, worker_count)
     {
         module_mapper_ = std::unique_ptr<module_mapper_t>(
             new test_module_mapper_t(&instrs, drcontext));
@@ -169,6 +169,11 @@ public:
     {
         return raw2trace_t::is_maybe_blocking_syscall(number);
     }
+    int
+    shared_cache_bits()
+    {
+        return estimate_shared_cache_bits();
+    }
 };
 
 class archive_ostream_test_t : public archive_ostream_t {
@@ -429,6 +434,59 @@ run_raw2trace(void *drcontext, const std::vector<offline_entry_t> raw, instrlist
     return true;
 }
 
+// Converts each element of "raw" as a separate thread using "worker_count" workers
+// and returns each thread's output in "results".  Does not destroy ilist.
+bool
+run_raw2trace_threads(void *drcontext,
+                      const std::vector<std::vector<offline_entry_t>> &raw,
+                      instrlist_t *ilist, int worker_count,
+                      std::vector<std::string> &results)
+{
+    std::vector<std::unique_ptr<std::istringstream>> raw_in;
+    std::vector<std::unique_ptr<std::ostringstream>> result_streams;
+    std::vector<std::istream *> input;
+    std::vector<std::ostream *> output;
+    for (const auto &thread_raw : raw) {
+        std::string as_string(reinterpret_cast<const char *>(thread_raw.data()),
+                              reinterpret_cast<const char *>(thread_raw.data() +
+                                                             thread_raw.size()));
+        raw_in.emplace_back(new std::istringstream(as_string));
+        input.push_back(raw_in.back().get());
+        result_streams.emplace_back(new std::ostringstream);
+        output.push_back(result_streams.back().get());
+    }
+    raw2trace_test_t raw2trace(input, output, *ilist, drcontext, worker_count);
+    std::string error = raw2trace.do_conversion();
+    CHECK(error.empty(), error);
+    results.clear();
+    for (const auto &stream : result_streams)
+        results.push_back(stream->str());
+    return true;
+}
+
+// Returns a thread that executes the blocks at "block_offs", each of which holds
+// "instrs_per_block" instructions, "iters" times.
+std::vector<offline_entry_t>
+make_looping_thread(memref_tid_t tid, const std::vector<uint64_t> &block_offs,
+                    uint64_t instrs_per_block, int iters)
+{
+    std::vector<offline_entry_t> raw;
+    raw.push_back(make_header());
+    raw.push_back(make_tid(tid));
+    raw.push_back(make_pid());
+    raw.push_back(make_line_size());
+    raw.push_back(make_timestamp(tid * 1000));
+    raw.push_back(make_core());
+    for (int i = 0; i < iters; ++i) {
+        for (uint64_t offs : block_offs)
+            raw.push_back(make_block(offs, instrs_per_block));
+        if (i % 16 == 15)
+            raw.push_back(make_timestamp(tid * 1000 + i));
+    }
+    raw.push_back(make_exit());
+    return raw;
+}
+
 bool
 test_branch_delays(void *drcontext)
 {
@@ -3790,6 +3848,105 @@ test_syscall_injection(void *drcontext)
         check_entry(entries, idx, TRACE_TYPE_FOOTER, -1));
 }
 
+bool
+test_shared_decode_cache(void *drcontext)
+{
+    std::cerr << "\n===============\nTesting shared decode cache\n";
+    instrlist_t *ilist = instrlist_create(drcontext);
+    // raw2trace doesn't like offsets of 0 so we shift with a nop.
+    instr_t *nop = XINST_CREATE_nop(drcontext);
+    instr_t *move1 =
+        XINST_CREATE_move(drcontext, opnd_create_reg(REG1), opnd_create_reg(REG2));
+    instr_t *move2 =
+        XINST_CREATE_move(drcontext, opnd_create_reg(REG2), opnd_create_reg(REG1));
+    instr_t *move3 =
+        XINST_CREATE_move(drcontext, opnd_create_reg(REG1), opnd_create_reg(REG2));
+    instr_t *move4 =
+        XINST_CREATE_move(drcontext, opnd_create_reg(REG2), opnd_create_reg(REG1));
+    instrlist_append(ilist, nop);
+    instrlist_append(ilist, move1);
+    instrlist_append(ilist, move2);
+    instrlist_append(ilist, move3);
+    instrlist_append(ilist, move4);
+    uint64_t offs_move1 = instr_length(drcontext, nop);
+    uint64_t offs_move3 = offs_move1 + instr_length(drcontext, move1) +
+        instr_length(drcontext, move2);
+
+    // Both threads run the same blocks of the same module, so with two workers
+    // they race to publish each block into the shared cache.
+    std::vector<std::vector<offline_entry_t>> raw;
+    raw.push_back(make_looping_thread(1, { offs_move1, offs_move3 }, 2, 200));
+    raw.push_back(make_looping_thread(2, { offs_move3, offs_move1 }, 2, 200));
+    std::vector<std::string> serial, parallel;
+    bool res = run_raw2trace_threads(drcontext, raw, ilist, /*worker_count=*/0, serial) &&
+        run_raw2trace_threads(drcontext, raw, ilist, /*worker_count=*/2, parallel);
+    instrlist_clear_and_destroy(drcontext, ilist);
+    if (!res)
+        return false;
+    CHECK(serial.size() == 2 && parallel == serial,
+          "shared decode cache changed the output");
+
+    // The bucket count follows the size of the mapped code, within limits.
+    std::istringstream no_input;
+    std::ostringstream no_output;
+    std::vector<std::istream *> input = { &no_input };
+    std::vector<std::ostream *> output = { &no_output };
+    struct {
+        addr_t code_size;
+        int bits;
+    } sizes[] = { { 0x1000, 12 }, { 0x100000, 14 }, { 0x10000000, 18 } };
+    for (const auto &size : sizes) {
+        raw2trace_test_t raw2trace(input, output,
+                                   { { 0x10000, 0x10000 + size.code_size } }, drcontext);
+        std::string error = raw2trace.do_module_parsing_and_mapping();
+        CHECK(error.empty(), error);
+        CHECK(raw2trace.shared_cache_bits() == size.bits,
+              "shared decode cache is not sized from the modules");
+    }
+    return true;
+}
+
+bool
+test_work_stealing(void *drcontext)
+{
+    std::cerr << "\n===============\nTesting work stealing\n";
+    instrlist_t *ilist = instrlist_create(drcontext);
+    // raw2trace doesn't like offsets of 0 so we shift with a nop.
+    instr_t *nop = XINST_CREATE_nop(drcontext);
+    instr_t *move1 =
+        XINST_CREATE_move(drcontext, opnd_create_reg(REG1), opnd_create_reg(REG2));
+    instr_t *move2 =
+        XINST_CREATE_move(drcontext, opnd_create_reg(REG2), opnd_create_reg(REG1));
+    instrlist_append(ilist, nop);
+    instrlist_append(ilist, move1);
+    instrlist_append(ilist, move2);
+    uint64_t offs_move1 = instr_length(drcontext, nop);
+    uint64_t offs_move2 = offs_move1 + instr_length(drcontext, move1);
+
+    // One thread dominates, so with two workers the one dealt the small threads
+    // runs dry and steals; with more workers than threads most start out idle.
+    std::vector<std::vector<offline_entry_t>> raw;
+    const int iters[] = { 20, 2000, 5, 40, 10, 80 };
+    for (size_t i = 0; i < sizeof(iters) / sizeof(iters[0]); ++i) {
+        raw.push_back(make_looping_thread(static_cast<memref_tid_t>(i + 1),
+                                          { offs_move1, offs_move2 }, 1, iters[i]));
+    }
+    std::vector<std::string> serial;
+    bool res = run_raw2trace_threads(drcontext, raw, ilist, /*worker_count=*/0, serial);
+    for (int workers : { 2, 8 }) {
+        std::vector<std::string> parallel;
+        res = res &&
+            run_raw2trace_threads(drcontext, raw, ilist, workers, parallel) &&
+            parallel == serial;
+        if (!res) {
+            std::cerr << "Output with " << workers << " workers does not match\n";
+            break;
+        }
+    }
+    instrlist_clear_and_destroy(drcontext, ilist);
+    return res;
+}
+
 int
 test_main(int argc, const char *argv[])
 {
@@ -3812,7 +3969,8 @@ test_main(int argc, const char *argv[])
         !test_branch_decoration(drcontext) ||
         !test_stats_timestamp_instr_count(drcontext) ||
         !test_is_maybe_blocking_syscall(drcontext) || !test_ifiltered(drcontext) ||
-        !test_asynchronous_signal(drcontext) || !test_syscall_injection(drcontext))
+        !test_asynchronous_signal(drcontext) || !test_syscall_injection(drcontext) ||
+        !test_shared_decode_cache(drcontext) || !test_work_stealing(drcontext))
         return 1;
     return 0;
 }
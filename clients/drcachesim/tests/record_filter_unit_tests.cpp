@@ -35,7 +35,10 @@
 #include "analyzer.h"
 #include "archive_ostream.h"
 #include "dr_api.h"
+#include "directory_iterator.h"
 #include "droption.h"
+#include "gzip_ostream.h"
+#include "parallel_archive_ostream.h"
 #include "tools/basic_counts.h"
 #include "tools/filter/null_filter.h"
 #include "tools/filter/cache_filter.h"
@@ -46,12 +49,20 @@
 #include "tools/filter/func_id_filter.h"
 #include "tools/filter/modify_marker_value_filter.h"
 #include "trace_entry.h"
+#include "trace_index.h"
+#include "uncompressed_ostream.h"
 #include "zipfile_ostream.h"
+#ifdef HAS_ZIP
+#    include "minizip/unzip.h"
+#endif
+#include <zlib.h>
 
 #include <cstdint>
 #include <inttypes.h>
 #include <fstream>
 #include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace dynamorio {
@@ -1512,6 +1523,262 @@ test_wait_filter()
     return true;
 }
 
+static bool
+read_file(const std::string &path, std::string &contents)
+{
+    std::ifstream file(path, std::ifstream::binary);
+    if (!file)
+        return false;
+    contents.assign(std::istreambuf_iterator<char>(file),
+                    std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Inflates the gzip members in "bytes" from "offset" to the end, failing if
+// "offset" is not the start of a member.
+static bool
+inflate_gzip_members(const std::string &bytes, size_t offset, std::string &contents)
+{
+    contents.clear();
+    z_stream zstream = {};
+    if (inflateInit2(&zstream, 16 + MAX_WBITS) != Z_OK)
+        return false;
+    zstream.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(bytes.data())) + offset;
+    zstream.avail_in = static_cast<uInt>(bytes.size() - offset);
+    char buf[4096];
+    int res = Z_OK;
+    while (zstream.avail_in > 0) {
+        zstream.next_out = reinterpret_cast<Bytef *>(buf);
+        zstream.avail_out = sizeof(buf);
+        res = inflate(&zstream, Z_NO_FLUSH);
+        if (res != Z_OK && res != Z_STREAM_END)
+            break;
+        contents.append(buf, sizeof(buf) - zstream.avail_out);
+        // Move on to the next member.
+        if (res == Z_STREAM_END && zstream.avail_in > 0 && inflateReset(&zstream) != Z_OK)
+            break;
+    }
+    inflateEnd(&zstream);
+    return res == Z_STREAM_END;
+}
+
+// Checks that the file written by the parallel writer at "parallel_path" holds the
+// same data as the one written by a sequential writer at "serial_path", split into
+// the same chunks with the same chunk index entries.
+static bool
+check_same_chunks(const std::string &serial_path, const std::string &parallel_path,
+                  bool is_gzip)
+{
+    std::string serial, parallel;
+    CHECK(read_file(serial_path, serial) && read_file(parallel_path, parallel),
+          "Failed to read output files");
+    // A single-chunk file has no index.
+    std::vector<trace_index_entry_t> serial_index, parallel_index;
+    CHECK(read_trace_index(serial_path, serial_index) ==
+              read_trace_index(parallel_path, parallel_index),
+          "Chunk index presence differs");
+    CHECK(serial_index.size() == parallel_index.size(), "Chunk counts differ");
+    for (size_t i = 0; i < serial_index.size(); ++i) {
+        CHECK(serial_index[i].instr_ordinal == parallel_index[i].instr_ordinal &&
+                  serial_index[i].timestamp == parallel_index[i].timestamp,
+              "Chunk starts differ");
+        if (!is_gzip) {
+            CHECK(serial_index[i].offset == parallel_index[i].offset,
+                  "Chunk offsets differ");
+            continue;
+        }
+        // The compressed offsets differ but each must start a member holding the
+        // same data.
+        std::string serial_tail, parallel_tail;
+        CHECK(inflate_gzip_members(serial, serial_index[i].offset, serial_tail),
+              "Failed to inflate serial chunk");
+        CHECK(inflate_gzip_members(parallel, parallel_index[i].offset, parallel_tail),
+              "Failed to inflate parallel chunk");
+        CHECK(serial_tail == parallel_tail, "Chunk contents differ");
+    }
+    if (is_gzip) {
+        std::string serial_data, parallel_data;
+        CHECK(inflate_gzip_members(serial, 0, serial_data) &&
+                  inflate_gzip_members(parallel, 0, parallel_data),
+              "Failed to inflate output files");
+        CHECK(serial_data == parallel_data, "Output contents differ");
+    } else
+        CHECK(serial == parallel, "Output contents differ");
+    return true;
+}
+
+#ifdef HAS_ZIP
+static bool
+read_zip_components(const std::string &path,
+                    std::vector<std::pair<std::string, std::string>> &components)
+{
+    unzFile zip = unzOpen(path.c_str());
+    if (zip == nullptr)
+        return false;
+    bool ok = true;
+    for (int res = unzGoToFirstFile(zip); ok && res == UNZ_OK;
+         res = unzGoToNextFile(zip)) {
+        char name[128];
+        if (unzGetCurrentFileInfo64(zip, nullptr, name, sizeof(name), nullptr, 0,
+                                    nullptr, 0) != UNZ_OK ||
+            unzOpenCurrentFile(zip) != UNZ_OK) {
+            ok = false;
+            break;
+        }
+        components.emplace_back(name, "");
+        char buf[4096];
+        int size;
+        while ((size = unzReadCurrentFile(zip, buf, sizeof(buf))) > 0)
+            components.back().second.append(buf, size);
+        if (size < 0 || unzCloseCurrentFile(zip) != UNZ_OK)
+            ok = false;
+    }
+    unzClose(zip);
+    return ok;
+}
+#endif
+
+// Writes "data" to "out" in components of COMPONENT_SIZE bytes.
+static bool
+write_components(archive_ostream_t &out, const std::string &data, bool is_zip)
+{
+    static constexpr size_t COMPONENT_SIZE = 1000 * sizeof(trace_entry_t);
+    for (size_t pos = 0, i = 0; pos < data.size(); pos += COMPONENT_SIZE, ++i) {
+        // Only zip lacks an implicitly open first component.
+        if (i > 0 || is_zip) {
+            CHECK(out.open_new_component("chunk." + std::to_string(i)).empty(),
+                  "Failed to open component");
+            out.set_component_start(i * 1000, 100 + i);
+        }
+        size_t size = std::min(COMPONENT_SIZE, data.size() - pos);
+        CHECK(out.write(data.data() + pos, size), "Failed to write component");
+    }
+    return true;
+}
+
+// Compares each format of parallel_archive_ostream_t with its sequential writer,
+// using blocks small enough to split every component across several workers.
+static bool
+test_parallel_writer(const std::string &output_dir, const std::string &data)
+{
+    static constexpr size_t BLOCK_SIZE = 4096;
+    compression_pool_t pool(/*num_threads=*/3, /*max_tasks=*/6);
+    const std::string serial_path = output_dir + DIRSEP + "serial.trace";
+    const std::string parallel_path = output_dir + DIRSEP + "parallel.trace";
+    {
+        uncompressed_ostream_t serial(serial_path);
+        if (!write_components(serial, data, /*is_zip=*/false))
+            return false;
+    }
+    {
+        parallel_archive_ostream_t parallel(parallel_path, PARALLEL_ARCHIVE_UNCOMPRESSED,
+                                            &pool, BLOCK_SIZE);
+        if (!write_components(parallel, data, /*is_zip=*/false))
+            return false;
+        CHECK(parallel.close().empty(), "Failed to close parallel writer");
+    }
+    if (!check_same_chunks(serial_path, parallel_path, /*is_gzip=*/false))
+        return false;
+    std::vector<trace_index_entry_t> index;
+    CHECK(read_trace_index(serial_path, index) && index.size() > 2,
+          "Too few components to test");
+    {
+        gzip_ostream_t serial(serial_path + ".gz");
+        if (!write_components(serial, data, /*is_zip=*/false))
+            return false;
+    }
+    {
+        parallel_archive_ostream_t parallel(parallel_path + ".gz", PARALLEL_ARCHIVE_GZIP,
+                                            &pool, BLOCK_SIZE);
+        if (!write_components(parallel, data, /*is_zip=*/false))
+            return false;
+        CHECK(parallel.close().empty(), "Failed to close parallel writer");
+    }
+    if (!check_same_chunks(serial_path + ".gz", parallel_path + ".gz",
+                           /*is_gzip=*/true))
+        return false;
+#ifdef HAS_ZIP
+    {
+        zipfile_ostream_t serial(serial_path + ".zip");
+        if (!write_components(serial, data, /*is_zip=*/true))
+            return false;
+    }
+    {
+        parallel_archive_ostream_t parallel(parallel_path + ".zip", PARALLEL_ARCHIVE_ZIP,
+                                            &pool, BLOCK_SIZE);
+        if (!write_components(parallel, data, /*is_zip=*/true))
+            return false;
+        CHECK(parallel.close().empty(), "Failed to close parallel writer");
+    }
+    std::vector<std::pair<std::string, std::string>> serial_components,
+        parallel_components;
+    CHECK(read_zip_components(serial_path + ".zip", serial_components) &&
+              read_zip_components(parallel_path + ".zip", parallel_components),
+          "Failed to read zipfiles");
+    CHECK(serial_components.size() > 1 && serial_components == parallel_components,
+          "Zipfile components differ");
+#endif
+    return true;
+}
+
+static bool
+run_null_filter(const std::string &output_dir, int output_threads)
+{
+    if (!local_create_dir(output_dir.c_str()))
+        FATAL_ERROR("Failed to create filtered trace output dir %s", output_dir.c_str());
+    std::vector<std::unique_ptr<record_filter_func_t>> filter_funcs;
+    filter_funcs.push_back(std::unique_ptr<record_filter_func_t>(
+        new dynamorio::drmemtrace::null_filter_t()));
+    auto record_filter = std::unique_ptr<dynamorio::drmemtrace::record_filter_t>(
+        new dynamorio::drmemtrace::record_filter_t(output_dir, std::move(filter_funcs),
+                                                   /*stop_timestamp=*/0,
+                                                   /*verbosity=*/0, output_threads));
+    std::vector<record_analysis_tool_t *> tools;
+    tools.push_back(record_filter.get());
+    record_analyzer_t record_analyzer(op_trace_dir.get_value(), &tools[0],
+                                      static_cast<int>(tools.size()));
+    CHECK(!!record_analyzer, "Failed to initialize record filter");
+    CHECK(record_analyzer.run(), "Failed to run record filter");
+    return true;
+}
+
+// Tests that -filter_output_threads writes the same traces as the per-shard
+// writers.
+static bool
+test_parallel_output()
+{
+    const std::string serial_dir = op_tmp_output_dir.get_value() + DIRSEP + "serial";
+    const std::string parallel_dir =
+        op_tmp_output_dir.get_value() + DIRSEP + "parallel_output";
+    if (!run_null_filter(serial_dir, 0) || !run_null_filter(parallel_dir, 2))
+        return false;
+    std::string largest;
+    directory_iterator_t end;
+    directory_iterator_t iter(op_trace_dir.get_value());
+    CHECK(!!iter, "Failed to list trace dir");
+    for (; iter != end; ++iter) {
+        const std::string fname = *iter;
+        if (!ends_with(fname, ".trace.gz"))
+            continue;
+        // The input trace is gzipped so the outputs are too.
+        if (!check_same_chunks(serial_dir + DIRSEP + fname, parallel_dir + DIRSEP + fname,
+                               /*is_gzip=*/true))
+            return false;
+        std::string contents, data;
+        CHECK(read_file(serial_dir + DIRSEP + fname, contents) &&
+                  inflate_gzip_members(contents, 0, data),
+              "Failed to read filtered trace");
+        if (data.size() > largest.size())
+            largest = data;
+    }
+    CHECK(!largest.empty(), "No filtered traces");
+    if (!test_parallel_writer(op_tmp_output_dir.get_value(), largest))
+        return false;
+    fprintf(stderr, "test_parallel_output passed\n");
+    return true;
+}
+
 int
 test_main(int argc, const char *argv[])
 {
@@ -1525,7 +1792,8 @@ test_main(int argc, const char *argv[])
     dr_standalone_init();
     if (!test_cache_and_type_filter() || !test_chunk_update() || !test_trim_filter() ||
         !test_null_filter() || !test_wait_filter() || !test_encodings2regdeps_filter() ||
-        !test_func_id_filter() || !test_modify_marker_value_filter())
+        !test_func_id_filter() || !test_modify_marker_value_filter() ||
+        !test_parallel_output())
         return 1;
     fprintf(stderr, "All done!\n");
     dr_standalone_exit();
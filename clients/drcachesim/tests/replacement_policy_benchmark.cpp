@@ -0,0 +1,245 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Compares the miss rates and simulation speed of the cache replacement policies.
+ *
+ * Each policy, plus Belady's OPT as a lower bound on the miss rate, simulates the
+ * same data accesses in a single cache.  The accesses come from a set of synthetic
+ * patterns or, if a trace directory is given, from the data references of that
+ * trace.  Run with optional cache geometry and trace:
+ *   $ tool.drcachesim.replacement_policy_benchmark [size_KB [assoc [trace_dir]]]
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "analysis_tool.h"
+#include "analyzer.h"
+#include "simulator/cache.h"
+#include "simulator/cache_stats.h"
+#include "simulator/create_cache_replacement_policy.h"
+#include "simulator/policy_opt.h"
+#include "memref.h"
+#include "trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+namespace {
+
+const int LINE_SIZE = 64;
+
+struct access_t {
+    addr_t addr;
+    addr_t pc;
+};
+
+// Collects the data references of a trace.
+class access_collector_t : public analysis_tool_t {
+public:
+    explicit access_collector_t(std::vector<access_t> *accesses)
+        : accesses_(accesses)
+    {
+    }
+    bool
+    process_memref(const memref_t &memref) override
+    {
+        if (type_is_prefetch(memref.data.type) ||
+            memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE)
+            accesses_->push_back({ memref.data.addr, memref.data.pc });
+        return true;
+    }
+    bool
+    print_results() override
+    {
+        return true;
+    }
+
+private:
+    std::vector<access_t> *accesses_;
+};
+
+// A loop over a working set a little larger than the cache, which defeats LRU.
+std::vector<access_t>
+make_loop(int64_t cache_size)
+{
+    std::vector<access_t> accesses;
+    const int64_t lines = cache_size / LINE_SIZE * 5 / 4;
+    for (int iter = 0; iter < 64; ++iter) {
+        for (int64_t i = 0; i < lines; ++i)
+            accesses.push_back({ static_cast<addr_t>(i * LINE_SIZE), 0x1000 });
+    }
+    return accesses;
+}
+
+// A hot working set half the size of the cache, interleaved with a stream of
+// lines that are never reused.
+std::vector<access_t>
+make_scan(int64_t cache_size)
+{
+    std::vector<access_t> accesses;
+    const int64_t hot_lines = cache_size / LINE_SIZE / 2;
+    addr_t stream_addr = static_cast<addr_t>(cache_size) * 16;
+    for (int iter = 0; iter < 64; ++iter) {
+        for (int64_t i = 0; i < hot_lines; ++i) {
+            accesses.push_back({ static_cast<addr_t>(i * LINE_SIZE), 0x1000 });
+            for (int j = 0; j < 2; ++j) {
+                accesses.push_back({ stream_addr, 0x2000 });
+                stream_addr += LINE_SIZE;
+            }
+        }
+    }
+    return accesses;
+}
+
+// Random accesses where a quarter of the lines receive most of the accesses.
+std::vector<access_t>
+make_skewed(int64_t cache_size)
+{
+    std::vector<access_t> accesses;
+    const int64_t lines = cache_size / LINE_SIZE * 4;
+    std::mt19937_64 rng(lines);
+    for (int64_t i = 0; i < lines * 64; ++i) {
+        int64_t line = static_cast<int64_t>(rng() % lines);
+        if (rng() % 4 != 0)
+            line /= 4;
+        accesses.push_back({ static_cast<addr_t>(line * LINE_SIZE),
+                             static_cast<addr_t>(0x1000 + (line % 8) * 4) });
+    }
+    return accesses;
+}
+
+// Returns the miss rate and sets *ns_per_access.
+double
+simulate(const std::string &policy, const std::vector<access_t> &accesses,
+         int64_t cache_size, int associativity, double *ns_per_access)
+{
+    const int num_sets = static_cast<int>(cache_size / LINE_SIZE / associativity);
+    std::unique_ptr<cache_replacement_policy_t> replace_policy;
+    if (policy == "OPT") {
+        std::vector<addr_t> tags;
+        tags.reserve(accesses.size());
+        for (const access_t &access : accesses)
+            tags.push_back(access.addr / LINE_SIZE);
+        replace_policy.reset(new policy_opt_t(num_sets, associativity,
+                                              policy_opt_t::compute_next_uses(tags)));
+    } else
+        replace_policy = create_cache_replacement_policy(policy, num_sets, associativity);
+    cache_t cache;
+    cache_stats_t *stats = new cache_stats_t(LINE_SIZE);
+    if (!replace_policy ||
+        !cache.init(associativity, LINE_SIZE, static_cast<int>(cache_size), nullptr,
+                    stats, std::move(replace_policy))) {
+        std::cerr << "Failed to initialize cache with policy " << policy << "\n";
+        exit(1);
+    }
+    memref_t ref = {};
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 1;
+    auto start = std::chrono::steady_clock::now();
+    for (const access_t &access : accesses) {
+        ref.data.addr = access.addr;
+        ref.data.pc = access.pc;
+        cache.request(ref);
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    *ns_per_access = elapsed.count() / accesses.size();
+    double miss_rate =
+        static_cast<double>(stats->get_metric(metric_name_t::MISSES)) / accesses.size();
+    delete stats;
+    return miss_rate;
+}
+
+void
+run_workload(const std::string &name, const std::vector<access_t> &accesses,
+             int64_t cache_size, int associativity)
+{
+    if (accesses.empty())
+        return;
+    std::cout << name << " (" << accesses.size() << " accesses):\n";
+    for (const std::string &policy : { "LRU", "LFU", "FIFO", "BIT_PLRU", "SRRIP",
+                                       "BRRIP", "DRRIP", "SHIP", "HAWKEYE", "OPT" }) {
+        double ns_per_access;
+        double miss_rate =
+            simulate(policy, accesses, cache_size, associativity, &ns_per_access);
+        std::cout << "  " << std::setw(8) << std::left << policy << std::right
+                  << " miss rate " << std::setw(6) << miss_rate * 100 << "%, "
+                  << std::setw(6) << ns_per_access << " ns/access\n";
+    }
+}
+
+} // namespace
+
+int
+test_main(int argc, const char *argv[])
+{
+    int64_t cache_size = 64 * 1024;
+    int associativity = 16;
+    if (argc > 1)
+        cache_size = strtoll(argv[1], nullptr, 10) * 1024;
+    if (argc > 2)
+        associativity = atoi(argv[2]);
+    if (cache_size <= 0 || associativity <= 0 ||
+        cache_size % (LINE_SIZE * associativity) != 0) {
+        std::cerr << "Invalid cache geometry\n";
+        return 1;
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    if (argc > 3) {
+        std::vector<access_t> accesses;
+        access_collector_t collector(&accesses);
+        analysis_tool_t *tools[] = { &collector };
+        analyzer_t analyzer(argv[3], tools, 1);
+        if (!analyzer || !analyzer.run()) {
+            std::cerr << "Failed to read trace: " << analyzer.get_error_string() << "\n";
+            return 1;
+        }
+        run_workload(argv[3], accesses, cache_size, associativity);
+        return 0;
+    }
+    run_workload("loop", make_loop(cache_size), cache_size, associativity);
+    run_workload("scan", make_scan(cache_size), cache_size, associativity);
+    run_workload("skewed", make_skewed(cache_size), cache_size, associativity);
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -31,6 +31,7 @@
  */
 
 #include <iostream>
+#include <random>
 #include <assert.h>
 
 #include "../tools/reuse_distance.h"
@@ -507,6 +508,87 @@ data_histogram_test()
     }
 }
 
+// Test that the order-statistic tree computes the same distances as the skip list.
+void
+tree_reuse_distance_test()
+{
+    std::cerr << "tree_reuse_distance_test()\n";
+    constexpr uint32_t LINE_SIZE = 64;
+    constexpr int NUM_LINES = 5000;
+    constexpr int NUM_ACCESSES = 50000;
+
+    // With and without pruning, which removes lines from the tree.
+    for (unsigned int distance_limit : { 0, 700 }) {
+        reuse_distance_knobs_t knobs;
+        knobs.line_size = LINE_SIZE;
+        knobs.skip_list_distance = 50;
+        knobs.distance_limit = distance_limit;
+        reuse_distance_test_t skip_list(knobs);
+        knobs.use_tree = true;
+        reuse_distance_test_t tree(knobs);
+        // Skewed random accesses give a wide range of distances, and many more
+        // accesses than lines exercise the renumbering of tree positions.
+        std::mt19937 rng(17);
+        for (int i = 0; i < NUM_ACCESSES; ++i) {
+            addr_t line = rng() % NUM_LINES;
+            if (rng() % 2 == 0)
+                line /= 16;
+            memref_t memref = generate_memref(line * LINE_SIZE);
+            bool success = skip_list.process_memref(memref);
+            success = success && tree.process_memref(memref);
+            assert(success);
+        }
+        auto *skip_shard = skip_list.get_aggregated_results();
+        auto *tree_shard = tree.get_aggregated_results();
+        assert(skip_shard->dist_map.size() > 500);
+        assert(tree_shard->dist_map == skip_shard->dist_map);
+        assert(tree_shard->pruned_address_hits == skip_shard->pruned_address_hits);
+        // The distant reference counts also depend on the list order.
+        for (const auto &entry : skip_shard->cache_map) {
+            const line_ref_t *tree_ref = tree_shard->cache_map.at(entry.first);
+            assert(tree_ref->total_refs == entry.second->total_refs);
+            assert(tree_ref->distant_refs == entry.second->distant_refs);
+        }
+    }
+}
+
+// Test that sampled reuse distances approximate the full ones.
+void
+sampled_reuse_distance_test()
+{
+    std::cerr << "sampled_reuse_distance_test()\n";
+    constexpr uint32_t LINE_SIZE = 64;
+    constexpr int NUM_LINES = 20000;
+    constexpr int NUM_LOOPS = 4;
+    constexpr double SAMPLE_RATE = 0.1;
+
+    reuse_distance_knobs_t knobs;
+    knobs.line_size = LINE_SIZE;
+    knobs.use_tree = true;
+    knobs.sample_rate = SAMPLE_RATE;
+    reuse_distance_test_t reuse_distance(knobs);
+    // Looping over the lines gives every reuse a distance of NUM_LINES - 1.
+    for (int loop = 0; loop < NUM_LOOPS; ++loop) {
+        for (int i = 0; i < NUM_LINES; ++i) {
+            bool success = reuse_distance.process_memref(generate_memref(i * LINE_SIZE));
+            assert(success);
+        }
+    }
+    auto *shard = reuse_distance.get_aggregated_results();
+    assert(shard->total_refs == NUM_LINES * NUM_LOOPS);
+    // Roughly the sampled fraction of the lines is tracked.
+    int64_t tracked = shard->cache_map.size();
+    assert(tracked > NUM_LINES * SAMPLE_RATE * 0.8);
+    assert(tracked < NUM_LINES * SAMPLE_RATE * 1.2);
+    int64_t count = 0;
+    for (const auto &entry : shard->dist_map) {
+        assert(entry.first > (NUM_LINES - 1) * 0.8);
+        assert(entry.first < (NUM_LINES - 1) * 1.2);
+        count += entry.second;
+    }
+    assert(count == tracked * (NUM_LOOPS - 1));
+}
+
 int
 test_main(int argc, const char *argv[])
 {
@@ -516,6 +598,8 @@ test_main(int argc, const char *argv[])
     simple_reuse_distance_test();
     reuse_distance_limit_test();
     data_histogram_test();
+    tree_reuse_distance_test();
+    sampled_reuse_distance_test();
     return 0;
 }
 
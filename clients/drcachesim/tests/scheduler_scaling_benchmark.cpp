@@ -0,0 +1,226 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Compares the throughput of the dynamic scheduler with periodic rebalancing
+ * versus with work stealing (scheduler_options_t::work_stealing) as the output
+ * count grows, using synthetic inputs of uneven lengths so that outputs run dry at
+ * different times.  Each output is driven by its own thread, doing no work per
+ * record, so that scheduler overhead and lock contention dominate:
+ *   $ tool.drcachesim.scheduler_scaling_benchmark [max_outputs] [instrs_per_input]
+ *         [repetitions]
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "memref.h"
+#include "mock_reader.h"
+#include "scheduler.h"
+#include "trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+namespace {
+
+// Inputs per output, so that each ready queue holds several inputs.
+static constexpr int INPUTS_PER_OUTPUT = 4;
+// Short enough to produce frequent queue operations.
+static constexpr uint64_t QUANTUM_INSTRS = 1000;
+static constexpr memref_tid_t TID_BASE = 100;
+
+struct run_result_t {
+    double seconds = 0.;
+    uint64_t records = 0;
+    double steals = 0.;
+};
+
+std::vector<trace_entry_t>
+make_input(memref_tid_t tid, int instrs)
+{
+    std::vector<trace_entry_t> refs;
+    refs.push_back(test_util::make_thread(tid));
+    refs.push_back(test_util::make_pid(1));
+    refs.push_back(test_util::make_version(TRACE_ENTRY_VERSION));
+    refs.push_back(test_util::make_timestamp(10));
+    for (int i = 0; i < instrs; ++i)
+        refs.push_back(test_util::make_instr(/*pc=*/42 + i % 64));
+    refs.push_back(test_util::make_exit(tid));
+    return refs;
+}
+
+// Returns false on failure.
+bool
+time_run(int num_outputs, int instrs_per_input, bool work_stealing, run_result_t &res)
+{
+    std::vector<scheduler_t::input_workload_t> sched_inputs;
+    int num_inputs = num_outputs * INPUTS_PER_OUTPUT;
+    for (int i = 0; i < num_inputs; ++i) {
+        memref_tid_t tid = TID_BASE + i;
+        // Vary the lengths by up to 4x so the outputs finish unevenly.
+        int instrs = instrs_per_input / 2 + (i % 7) * instrs_per_input / 4;
+        std::vector<scheduler_t::input_reader_t> readers;
+        readers.emplace_back(
+            std::unique_ptr<test_util::mock_reader_t>(
+                new test_util::mock_reader_t(make_input(tid, instrs))),
+            std::unique_ptr<test_util::mock_reader_t>(new test_util::mock_reader_t()),
+            tid);
+        sched_inputs.emplace_back(std::move(readers));
+    }
+    scheduler_t::scheduler_options_t sched_ops(scheduler_t::MAP_TO_ANY_OUTPUT,
+                                               scheduler_t::DEPENDENCY_IGNORE,
+                                               scheduler_t::SCHEDULER_DEFAULTS,
+                                               /*verbosity=*/0);
+    sched_ops.quantum_duration_instrs = QUANTUM_INSTRS;
+    sched_ops.exit_if_fraction_inputs_left = 0.;
+    sched_ops.work_stealing = work_stealing;
+    scheduler_t scheduler;
+    if (scheduler.init(sched_inputs, num_outputs, std::move(sched_ops)) !=
+        scheduler_t::STATUS_SUCCESS) {
+        std::cerr << "Failed to initialize scheduler: " << scheduler.get_error_string()
+                  << "\n";
+        return false;
+    }
+    std::vector<uint64_t> records(num_outputs, 0);
+    // Not vector<bool>, whose packed elements cannot be written concurrently.
+    std::vector<char> failed(num_outputs, false);
+    std::vector<std::thread> threads;
+    threads.reserve(num_outputs);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_outputs; ++i) {
+        threads.emplace_back([&scheduler, &records, &failed, i]() {
+            scheduler_t::stream_t *stream = scheduler.get_stream(i);
+            memref_t memref;
+            // A local count avoids false sharing between the threads.
+            uint64_t count = 0;
+            for (scheduler_t::stream_status_t status = stream->next_record(memref);
+                 status != scheduler_t::STATUS_EOF;
+                 status = stream->next_record(memref)) {
+                if (status == scheduler_t::STATUS_WAIT ||
+                    status == scheduler_t::STATUS_IDLE) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (status != scheduler_t::STATUS_OK) {
+                    failed[i] = true;
+                    return;
+                }
+                ++count;
+            }
+            records[i] = count;
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                      .count();
+    res.records = 0;
+    res.steals = 0.;
+    for (int i = 0; i < num_outputs; ++i) {
+        if (failed[i]) {
+            std::cerr << "Output " << i << " failed\n";
+            return false;
+        }
+        res.records += records[i];
+        res.steals += scheduler.get_stream(i)->get_schedule_statistic(
+            memtrace_stream_t::SCHED_STAT_RUNQUEUE_STEALS);
+    }
+    return true;
+}
+
+// Returns the fastest of "repetitions" runs, or false on failure.
+bool
+best_run(int num_outputs, int instrs_per_input, bool work_stealing, int repetitions,
+         run_result_t &best)
+{
+    for (int i = 0; i < repetitions; ++i) {
+        run_result_t res;
+        if (!time_run(num_outputs, instrs_per_input, work_stealing, res))
+            return false;
+        if (i == 0 || res.seconds < best.seconds)
+            best = res;
+    }
+    return true;
+}
+
+} // namespace
+
+int
+test_main(int argc, const char *argv[])
+{
+    int max_outputs = argc > 1 ? atoi(argv[1]) : 256;
+    int instrs_per_input = argc > 2 ? atoi(argv[2]) : 10000;
+    int repetitions = argc > 3 ? atoi(argv[3]) : 3;
+    if (max_outputs < 1 || instrs_per_input < 1 || repetitions < 1) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [max_outputs] [instrs_per_input] [repetitions]\n";
+        return 1;
+    }
+    std::cout << INPUTS_PER_OUTPUT << " inputs per output, ~" << instrs_per_input
+              << " instrs per input, best of " << repetitions << " runs\n";
+    std::cout << std::setw(8) << "outputs" << std::setw(14) << "rebalancing"
+              << std::setw(14) << "stealing" << std::setw(10) << "speedup"
+              << std::setw(10) << "steals\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (int outputs = 1; outputs <= max_outputs; outputs *= 2) {
+        run_result_t rebalancing, stealing;
+        if (!best_run(outputs, instrs_per_input, /*work_stealing=*/false, repetitions,
+                      rebalancing) ||
+            !best_run(outputs, instrs_per_input, /*work_stealing=*/true, repetitions,
+                      stealing))
+            return 1;
+        // Both modes must deliver every record.
+        if (rebalancing.records != stealing.records) {
+            std::cerr << "Record count mismatch: " << rebalancing.records << " vs "
+                      << stealing.records << "\n";
+            return 1;
+        }
+        std::cout << std::setw(8) << outputs << std::setw(9)
+                  << rebalancing.records / rebalancing.seconds / 1e6 << " Mr/s"
+                  << std::setw(9) << stealing.records / stealing.seconds / 1e6
+                  << " Mr/s" << std::setw(9) << rebalancing.seconds / stealing.seconds
+                  << "x" << std::setw(10) << static_cast<uint64_t>(stealing.steals)
+                  << "\n";
+    }
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -40,6 +40,7 @@
 #include <random>
 #include <regex>
 #include <set>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <unordered_set>
@@ -53,6 +54,8 @@
 #include "memref.h"
 #include "trace_entry.h"
 #include "noise_generator.h"
+#include "trace_index.h"
+#include "uncompressed_ostream.h"
 #ifdef HAS_ZIP
 #    include "zipfile_istream.h"
 #    include "zipfile_ostream.h"
@@ -4992,6 +4995,94 @@ test_times_of_interest()
 #endif
 }
 
+static void
+test_times_of_interest_chunk_index()
+{
+    std::cerr << "\n----------------\nTesting times of interest from chunk index\n";
+    static constexpr memref_tid_t TID = 100;
+    static constexpr int NUM_CHUNKS = 4;
+    static constexpr int NUM_INSTRS_PER_CHUNK = 3;
+    static constexpr addr_t PC_BASE = 42;
+    // Without an as-traced schedule file, the chunk start times in the chunk index
+    // written alongside the trace are used instead.
+    std::string trace_fname = "tmp_test_times_of_interest_index.trace";
+    {
+        uncompressed_ostream_t outfile(trace_fname);
+        auto write_entry = [&outfile](const trace_entry_t &entry) {
+            outfile.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        };
+        write_entry(test_util::make_header(TRACE_ENTRY_VERSION));
+        write_entry(test_util::make_thread(TID));
+        write_entry(test_util::make_pid(1));
+        write_entry(test_util::make_version(TRACE_ENTRY_VERSION));
+        for (int i = 0; i < NUM_CHUNKS; ++i) {
+            uint64_t timestamp = 10 * (i + 1);
+            if (i > 0) {
+                write_entry(
+                    test_util::make_marker(TRACE_MARKER_TYPE_CHUNK_FOOTER, i - 1));
+                std::string err = outfile.open_new_component("chunk");
+                assert(err.empty());
+                outfile.set_component_start(i * NUM_INSTRS_PER_CHUNK, timestamp);
+            }
+            write_entry(test_util::make_timestamp(timestamp));
+            for (int j = 0; j < NUM_INSTRS_PER_CHUNK; ++j) {
+                write_entry(test_util::make_instr(PC_BASE + 1 /*1-based ranges*/ +
+                                                  i * NUM_INSTRS_PER_CHUNK + j));
+            }
+        }
+        write_entry(test_util::make_exit(TID));
+        write_entry(test_util::make_footer());
+        assert(outfile);
+    }
+    std::vector<trace_index_entry_t> entries;
+    assert(read_trace_index(trace_fname, entries) && entries.size() == NUM_CHUNKS);
+    {
+        std::vector<scheduler_t::input_workload_t> sched_inputs;
+        sched_inputs.emplace_back(trace_fname);
+        // The chunks start at instructions 0, 3, 6, and 9 at times 10, 20, 30, and
+        // 40.  The first chunk's time is not in the index so times before 20 cannot
+        // be mapped.
+        sched_inputs.back().times_of_interest = { { 25, 35 } };
+        scheduler_t::scheduler_options_t sched_ops(scheduler_t::MAP_TO_ANY_OUTPUT,
+                                                   scheduler_t::DEPENDENCY_TIMESTAMPS,
+                                                   scheduler_t::SCHEDULER_DEFAULTS,
+                                                   /*verbosity=*/3);
+        scheduler_t scheduler;
+        if (scheduler.init(sched_inputs, 1, std::move(sched_ops)) !=
+            scheduler_t::STATUS_SUCCESS) {
+            std::cerr << scheduler.get_error_string() << "\n";
+            assert(false);
+        }
+        auto *stream = scheduler.get_stream(0);
+        // Interpolating between the chunk starts gives the range [4, 7].
+        std::vector<addr_t> pcs;
+        memref_t record;
+        for (scheduler_t::stream_status_t status = stream->next_record(record);
+             status != scheduler_t::STATUS_EOF; status = stream->next_record(record)) {
+            assert(status == scheduler_t::STATUS_OK);
+            if (type_is_instr(record.instr.type))
+                pcs.push_back(record.instr.addr);
+        }
+        assert(pcs == std::vector<addr_t>({ PC_BASE + 4, PC_BASE + 5, PC_BASE + 6,
+                                            PC_BASE + 7 }));
+    }
+    // Without the chunk index there are no times to map.
+    remove(trace_index_path(trace_fname).c_str());
+    {
+        std::vector<scheduler_t::input_workload_t> sched_inputs;
+        sched_inputs.emplace_back(trace_fname);
+        sched_inputs.back().times_of_interest = { { 25, 35 } };
+        scheduler_t::scheduler_options_t sched_ops(scheduler_t::MAP_TO_ANY_OUTPUT,
+                                                   scheduler_t::DEPENDENCY_TIMESTAMPS,
+                                                   scheduler_t::SCHEDULER_DEFAULTS,
+                                                   /*verbosity=*/3);
+        scheduler_t scheduler;
+        assert(scheduler.init(sched_inputs, 1, std::move(sched_ops)) ==
+               scheduler_t::STATUS_ERROR_INVALID_PARAMETER);
+    }
+    remove(trace_fname.c_str());
+}
+
 static void
 test_inactive()
 {
@@ -7132,6 +7223,202 @@ test_random_schedule()
     }
 }
 
+static void
+test_batch_delivery()
+{
+    std::cerr << "\n----------------\nTesting batched record delivery\n";
+    static constexpr int NUM_INPUTS = 3;
+    static constexpr int NUM_INSTRS = 10;
+    static constexpr int QUANTUM_DURATION = 3;
+    static constexpr size_t BATCH_SIZE = 4;
+    static constexpr memref_tid_t TID_BASE = 100;
+    std::vector<trace_entry_t> inputs[NUM_INPUTS];
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        memref_tid_t tid = TID_BASE + i;
+        inputs[i].push_back(test_util::make_thread(tid));
+        inputs[i].push_back(test_util::make_pid(1));
+        inputs[i].push_back(test_util::make_version(TRACE_ENTRY_VERSION));
+        inputs[i].push_back(test_util::make_timestamp(10));
+        for (int j = 0; j < NUM_INSTRS; j++)
+            inputs[i].push_back(test_util::make_instr(42 + j * 4));
+        inputs[i].push_back(test_util::make_exit(tid));
+    }
+    // Returns the shard and type of each record as a string.
+    auto run = [&](bool batched) {
+        std::vector<scheduler_t::input_workload_t> sched_inputs;
+        for (int i = 0; i < NUM_INPUTS; i++) {
+            std::vector<scheduler_t::input_reader_t> readers;
+            readers.emplace_back(
+                std::unique_ptr<test_util::mock_reader_t>(
+                    new test_util::mock_reader_t(inputs[i])),
+                std::unique_ptr<test_util::mock_reader_t>(new test_util::mock_reader_t()),
+                TID_BASE + i);
+            sched_inputs.emplace_back(std::move(readers));
+        }
+        // Use input ordinals so that each shard is one input.
+        scheduler_t::scheduler_options_t sched_ops(
+            scheduler_t::MAP_TO_ANY_OUTPUT, scheduler_t::DEPENDENCY_IGNORE,
+            scheduler_t::SCHEDULER_USE_INPUT_ORDINALS, /*verbosity=*/2);
+        sched_ops.quantum_duration_instrs = QUANTUM_DURATION;
+        scheduler_t scheduler;
+        if (scheduler.init(sched_inputs, 1, std::move(sched_ops)) !=
+            scheduler_t::STATUS_SUCCESS)
+            assert(false);
+        auto *stream = scheduler.get_stream(0);
+        std::string sched;
+        std::map<int, memref_tid_t> shard2tid;
+        memref_t records[BATCH_SIZE];
+        while (true) {
+            size_t count = 1;
+            int shard = -1;
+            scheduler_t::stream_status_t status;
+            if (batched) {
+                status = stream->next_record_batch(records, BATCH_SIZE, count, shard,
+                                                   /*cur_time=*/0);
+            } else {
+                status = stream->next_record(records[0]);
+                shard = stream->get_shard_index();
+            }
+            if (status == scheduler_t::STATUS_EOF)
+                break;
+            assert(status == scheduler_t::STATUS_OK);
+            assert(count >= 1 && count <= BATCH_SIZE);
+            for (size_t i = 0; i < count; ++i) {
+                // Each shard is a single input and thus a single thread.
+                auto it = shard2tid.emplace(shard, records[i].instr.tid).first;
+                assert(records[i].instr.tid == it->second);
+                // A thread exit must end its batch.
+                assert(records[i].exit.type != TRACE_TYPE_THREAD_EXIT ||
+                       i == count - 1);
+                sched += static_cast<char>('A' + shard);
+                sched += type_is_instr(records[i].instr.type) ? 'i' : '.';
+            }
+        }
+        return sched;
+    };
+    std::string unbatched = run(false);
+    std::string batched = run(true);
+    std::cerr << "unbatched: " << unbatched << "\nbatched:   " << batched << "\n";
+    assert(!unbatched.empty());
+    assert(batched == unbatched);
+}
+
+static void
+test_checkpoint_restore()
+{
+    std::cerr << "\n----------------\nTesting scheduler checkpoints\n";
+    static constexpr int NUM_INPUTS = 5;
+    static constexpr int NUM_OUTPUTS = 2;
+    static constexpr int NUM_INSTRS = 12;
+    static constexpr int QUANTUM_DURATION = 3;
+    static constexpr uint64_t BLOCK_LATENCY = 1500;
+    static constexpr memref_tid_t TID_BASE = 100;
+    std::vector<trace_entry_t> inputs[NUM_INPUTS];
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        memref_tid_t tid = TID_BASE + i;
+        inputs[i].push_back(test_util::make_thread(tid));
+        inputs[i].push_back(test_util::make_pid(1));
+        inputs[i].push_back(test_util::make_version(TRACE_ENTRY_VERSION));
+        inputs[i].push_back(test_util::make_marker(TRACE_MARKER_TYPE_PAGE_SIZE, 4096));
+        uint64_t timestamp = 10 + i;
+        inputs[i].push_back(test_util::make_timestamp(timestamp));
+        for (int j = 0; j < NUM_INSTRS; j++) {
+            inputs[i].push_back(test_util::make_instr(42 + j * 4));
+            inputs[i].push_back(test_util::make_memref(1024 + j));
+            if (j == NUM_INSTRS / 2 && i % 2 == 0) {
+                // Add a blocking syscall to exercise blocked times.
+                inputs[i].push_back(test_util::make_timestamp(++timestamp));
+                inputs[i].push_back(
+                    test_util::make_marker(TRACE_MARKER_TYPE_SYSCALL, 42));
+                inputs[i].push_back(
+                    test_util::make_marker(TRACE_MARKER_TYPE_MAYBE_BLOCKING_SYSCALL, 0));
+                timestamp += BLOCK_LATENCY;
+                inputs[i].push_back(test_util::make_timestamp(timestamp));
+            }
+        }
+        inputs[i].push_back(test_util::make_exit(tid));
+    }
+    // Walks the outputs in lockstep starting with 'first_output' and returns the
+    // schedule for each output as a string, along with the output that would have
+    // been next when the scheduler stopped.
+    auto run = [&](uint64_t stop_after_instrs, std::istream *checkpoint_in,
+                   std::ostream *checkpoint_out, int first_output, int &next_output) {
+        std::vector<scheduler_t::input_workload_t> sched_inputs;
+        for (int i = 0; i < NUM_INPUTS; i++) {
+            std::vector<scheduler_t::input_reader_t> readers;
+            readers.emplace_back(
+                std::unique_ptr<test_util::mock_reader_t>(
+                    new test_util::mock_reader_t(inputs[i])),
+                std::unique_ptr<test_util::mock_reader_t>(new test_util::mock_reader_t()),
+                TID_BASE + i);
+            sched_inputs.emplace_back(std::move(readers));
+        }
+        scheduler_t::scheduler_options_t sched_ops(scheduler_t::MAP_TO_ANY_OUTPUT,
+                                                   scheduler_t::DEPENDENCY_TIMESTAMPS,
+                                                   scheduler_t::SCHEDULER_DEFAULTS,
+                                                   /*verbosity=*/2);
+        sched_ops.quantum_duration_instrs = QUANTUM_DURATION;
+        sched_ops.blocking_switch_threshold = BLOCK_LATENCY;
+        sched_ops.block_time_multiplier = 0.01;
+        sched_ops.time_units_per_us = 1.;
+        // Keep the tail from being dropped so that all instructions are compared.
+        sched_ops.exit_if_fraction_inputs_left = 0.;
+        sched_ops.stop_after_instrs = stop_after_instrs;
+        sched_ops.checkpoint_istream = checkpoint_in;
+        scheduler_t scheduler;
+        if (scheduler.init(sched_inputs, NUM_OUTPUTS, std::move(sched_ops)) !=
+            scheduler_t::STATUS_SUCCESS)
+            assert(false);
+        std::vector<std::string> sched(NUM_OUTPUTS);
+        std::vector<bool> eof(NUM_OUTPUTS, false);
+        int num_eof = 0;
+        int output = first_output;
+        next_output = -1;
+        while (num_eof < NUM_OUTPUTS) {
+            if (!eof[output]) {
+                memref_t memref;
+                scheduler_t::stream_status_t status =
+                    scheduler.get_stream(output)->next_record(memref);
+                if (status == scheduler_t::STATUS_EOF) {
+                    if (next_output < 0)
+                        next_output = output;
+                    eof[output] = true;
+                    ++num_eof;
+                } else if (status == scheduler_t::STATUS_IDLE) {
+                    sched[output] += '_';
+                } else {
+                    assert(status == scheduler_t::STATUS_OK);
+                    if (type_is_instr(memref.instr.type)) {
+                        sched[output] +=
+                            static_cast<char>('A' + memref.instr.tid - TID_BASE);
+                    } else
+                        sched[output] += '.';
+                }
+            }
+            output = (output + 1) % NUM_OUTPUTS;
+        }
+        if (checkpoint_out != nullptr &&
+            scheduler.write_checkpoint(*checkpoint_out) != scheduler_t::STATUS_SUCCESS)
+            assert(false);
+        return sched;
+    };
+    int next_output;
+    std::vector<std::string> full = run(0, nullptr, nullptr, 0, next_output);
+    // Stop at several points, including mid-instruction (the memref after an
+    // instruction) and inside blocked periods, and resume from each checkpoint.
+    for (uint64_t stop : { 1, 7, 20, 31, 44 }) {
+        std::stringstream checkpoint;
+        std::vector<std::string> before = run(stop, nullptr, &checkpoint, 0, next_output);
+        std::vector<std::string> after =
+            run(0, &checkpoint, nullptr, next_output, next_output);
+        for (int i = 0; i < NUM_OUTPUTS; i++) {
+            std::cerr << "stop " << stop << " output " << i << ": " << before[i] << " | "
+                      << after[i] << "\n";
+            assert(before[i] + after[i] == full[i]);
+        }
+    }
+}
+
 static void
 test_record_scheduler()
 {
@@ -7294,9 +7581,10 @@ test_record_scheduler()
 }
 
 static void
-test_rebalancing()
+test_rebalancing_queues(bool work_stealing)
 {
-    std::cerr << "\n----------------\nTesting rebalancing\n";
+    std::cerr << "\n----------------\nTesting rebalancing with work_stealing="
+              << work_stealing << "\n";
     // We want to get the cores into an unbalanced state.
     // The scheduler will start out with round-robin even assignment.
     // We use "unschedule" and "direct switch" operations to get all
@@ -7397,6 +7685,7 @@ test_rebalancing()
     sched_ops.migration_threshold_us = MIGRATION_THRESHOLD;
     sched_ops.rebalance_period_us = REBALANCE_PERIOD;
     sched_ops.block_time_max_us = BLOCK_TIME_MAX;
+    sched_ops.work_stealing = work_stealing;
     scheduler_t scheduler;
     if (scheduler.init(sched_inputs, NUM_OUTPUTS, std::move(sched_ops)) !=
         scheduler_t::STATUS_SUCCESS)
@@ -7418,6 +7707,152 @@ test_rebalancing()
         }
         assert(inputs.size() >= (NUM_INPUTS_UNSCHED / NUM_OUTPUTS) - 1);
     }
+    // With work stealing the idle outputs should have pulled the inputs themselves.
+    double steals = 0;
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        steals += scheduler.get_stream(i)->get_schedule_statistic(
+            memtrace_stream_t::SCHED_STAT_RUNQUEUE_STEALS);
+    }
+    std::cerr << "steals: " << steals << "\n";
+    if (work_stealing)
+        assert(steals >= (NUM_INPUTS_UNSCHED / NUM_OUTPUTS) * (NUM_OUTPUTS - 1) - 1);
+}
+
+static void
+test_rebalancing()
+{
+    test_rebalancing_queues(/*work_stealing=*/false);
+    test_rebalancing_queues(/*work_stealing=*/true);
+}
+
+static void
+test_output_topology()
+{
+    std::cerr << "\n----------------\nTesting output topology\n";
+    // Two nodes, each with one LLC domain holding two single-threaded cores.
+    static constexpr int NUM_OUTPUTS = 4;
+    // The initial schedule places inputs i and i+NUM_OUTPUTS on output i.
+    static constexpr int NUM_INPUTS = NUM_OUTPUTS * 2;
+    static constexpr int SHORT_INSTRS = 15;
+    static constexpr int LONG_INSTRS = 60;
+    // Short enough for the long inputs to run before they are stolen.
+    static constexpr int QUANTUM_DURATION = 10;
+    static constexpr memref_tid_t TID_BASE = 100;
+    std::vector<scheduler_t::output_topology_t> topology =
+        scheduler_t::make_output_topology(/*nodes=*/2, /*llcs_per_node=*/1,
+                                          /*cores_per_llc=*/2, /*threads_per_core=*/1);
+    assert(topology.size() == NUM_OUTPUTS);
+    assert(topology[1].core == 1 && topology[1].llc == 0 && topology[1].node == 0);
+    assert(topology[2].core == 2 && topology[2].llc == 1 && topology[2].node == 1);
+    {
+        // Check the SMT numbering.
+        std::vector<scheduler_t::output_topology_t> smt =
+            scheduler_t::make_output_topology(2, 2, 2, 2);
+        assert(smt.size() == 16);
+        assert(smt[1].core == 0 && smt[2].core == 1);
+        assert(smt[4].llc == 1 && smt[4].node == 0);
+        assert(smt[8].llc == 2 && smt[8].node == 1);
+        assert(scheduler_t::make_output_topology(2, 0, 2, 2).empty());
+    }
+    // Outputs 0 and 2 get long inputs; 1 and 3 short ones, so that 1 and 3 run dry
+    // while the others still have a queued input to steal that has already run.
+    auto make_inputs = [&]() {
+        std::vector<scheduler_t::input_workload_t> sched_inputs;
+        for (int i = 0; i < NUM_INPUTS; i++) {
+            memref_tid_t tid = TID_BASE + i;
+            int instrs = (i % 2 == 0) ? LONG_INSTRS : SHORT_INSTRS;
+            std::vector<trace_entry_t> refs;
+            refs.push_back(test_util::make_thread(tid));
+            refs.push_back(test_util::make_pid(1));
+            refs.push_back(test_util::make_version(TRACE_ENTRY_VERSION));
+            refs.push_back(test_util::make_timestamp(10));
+            for (int j = 0; j < instrs; j++)
+                refs.push_back(test_util::make_instr(42 + j * 4));
+            refs.push_back(test_util::make_exit(tid));
+            std::vector<scheduler_t::input_reader_t> readers;
+            readers.emplace_back(
+                std::unique_ptr<test_util::mock_reader_t>(
+                    new test_util::mock_reader_t(refs)),
+                std::unique_ptr<test_util::mock_reader_t>(new test_util::mock_reader_t()),
+                tid);
+            sched_inputs.emplace_back(std::move(readers));
+        }
+        return sched_inputs;
+    };
+    auto make_options = [&]() {
+        scheduler_t::scheduler_options_t sched_ops(scheduler_t::MAP_TO_ANY_OUTPUT,
+                                                   scheduler_t::DEPENDENCY_IGNORE,
+                                                   scheduler_t::SCHEDULER_DEFAULTS,
+                                                   /*verbosity=*/3);
+        sched_ops.quantum_duration_instrs = QUANTUM_DURATION;
+        sched_ops.migration_threshold_us = 0;
+        sched_ops.exit_if_fraction_inputs_left = 0.;
+        return sched_ops;
+    };
+    {
+        // Test invalid topologies.
+        std::vector<scheduler_t::input_workload_t> sched_inputs = make_inputs();
+        scheduler_t::scheduler_options_t sched_ops = make_options();
+        sched_ops.output_topology = topology;
+        sched_ops.output_topology.pop_back();
+        scheduler_t scheduler;
+        assert(scheduler.init(sched_inputs, NUM_OUTPUTS, std::move(sched_ops)) ==
+               scheduler_t::STATUS_ERROR_INVALID_PARAMETER);
+    }
+    {
+        std::vector<scheduler_t::input_workload_t> sched_inputs = make_inputs();
+        scheduler_t::scheduler_options_t sched_ops = make_options();
+        sched_ops.output_topology = topology;
+        // A core split across LLC domains.
+        sched_ops.output_topology[1].core = 2;
+        scheduler_t scheduler;
+        assert(scheduler.init(sched_inputs, NUM_OUTPUTS, std::move(sched_ops)) ==
+               scheduler_t::STATUS_ERROR_INVALID_PARAMETER);
+    }
+    auto run = [&](bool use_topology, double &cross_core, double &cross_node) {
+        std::vector<scheduler_t::input_workload_t> sched_inputs = make_inputs();
+        scheduler_t::scheduler_options_t sched_ops = make_options();
+        if (use_topology)
+            sched_ops.output_topology = topology;
+        scheduler_t scheduler;
+        if (scheduler.init(sched_inputs, NUM_OUTPUTS, std::move(sched_ops)) !=
+            scheduler_t::STATUS_SUCCESS)
+            assert(false);
+        std::vector<std::string> sched_as_string =
+            run_lockstep_simulation(scheduler, NUM_OUTPUTS, TID_BASE);
+        cross_core = 0.;
+        cross_node = 0.;
+        for (int i = 0; i < NUM_OUTPUTS; i++) {
+            std::cerr << "cpu #" << i << " schedule: " << sched_as_string[i] << "\n";
+            cross_core += scheduler.get_stream(i)->get_schedule_statistic(
+                memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_CORE);
+            cross_node += scheduler.get_stream(i)->get_schedule_statistic(
+                memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_NODE);
+        }
+        return sched_as_string;
+    };
+    double cross_core, cross_node;
+    // Without a topology, each idle output steals from the next output over, which
+    // for outputs 1 and 3 crosses into the other node.
+    std::vector<std::string> sched_as_string =
+        run(/*use_topology=*/false, cross_core, cross_node);
+    assert(sched_as_string[1] ==
+           "..BBBBBBBBBB..FFFFFFFFFFBBBBB.FFFFF.CCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCC."
+           "_________");
+    assert(sched_as_string[3] ==
+           "..DDDDDDDDDD..HHHHHHHHHHDDDDD.HHHHH.AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA."
+           "________");
+    // The flat default puts every output in one node.
+    assert(cross_core == 2 && cross_node == 0);
+    // With the topology, each idle output steals from its node sibling instead.
+    sched_as_string = run(/*use_topology=*/true, cross_core, cross_node);
+    assert(sched_as_string[1] ==
+           "..BBBBBBBBBB..FFFFFFFFFFBBBBB.FFFFF.AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA."
+           "_________");
+    assert(sched_as_string[3] ==
+           "..DDDDDDDDDD..HHHHHHHHHHDDDDD.HHHHH.CCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCC."
+           "________");
+    assert(cross_core == 2 && cross_node == 0);
 }
 
 static void
@@ -8051,14 +8486,18 @@ test_main(int argc, const char *argv[])
     test_replay_as_traced_dup_start();
     test_replay_as_traced_sort();
     test_times_of_interest();
+    test_times_of_interest_chunk_index();
     test_inactive();
     test_direct_switch();
     test_unscheduled();
     test_kernel_switch_sequences();
     test_kernel_syscall_sequences();
     test_random_schedule();
+    test_batch_delivery();
+    test_checkpoint_restore();
     test_record_scheduler();
     test_rebalancing();
+    test_output_topology();
     test_initial_migrate();
     test_exit_early();
     test_marker_updates();
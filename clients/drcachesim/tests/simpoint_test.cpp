@@ -0,0 +1,179 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Unit tests for the simpoint tool. */
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "../tools/simpoint.h"
+#include "../common/memref.h"
+#include "memref_gen.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+bool
+check_blocks()
+{
+    simpoint_t tool(/*max_k=*/1, /*dimensions=*/1, /*output_file=*/"", /*verbose=*/0);
+    std::vector<memref_t> memrefs = {
+        gen_instr(1, 0x10, 4),
+        gen_data(1, /*load=*/true, 0x800, 8),
+        gen_instr(1, 0x14, 4),
+        // A second thread entering the middle of the first block starts a new block.
+        gen_instr(2, 0x14, 4),
+        gen_instr_type(TRACE_TYPE_INSTR_TAKEN_JUMP, 1, 0x18, 2),
+        gen_instr(1, 0x100, 4),
+        // An untaken branch still ends the block.
+        gen_branch(1, 0x104),
+        gen_instr(1, 0x105, 4),
+        // A discontinuity with no branch, as after a signal, starts a new block.
+        gen_instr(2, 0x200, 4),
+        gen_instr(2, 0x204, 4),
+    };
+    for (const auto &memref : memrefs) {
+        if (!tool.process_memref(memref)) {
+            std::cerr << "process_memref failed: " << tool.get_error_string() << "\n";
+            return false;
+        }
+    }
+    auto *snapshot = dynamic_cast<simpoint_t::bbv_snapshot_t *>(
+        tool.generate_interval_snapshot(/*interval_id=*/1));
+    if (snapshot == nullptr) {
+        std::cerr << "failed to generate a snapshot\n";
+        return false;
+    }
+    const flat_hash_map_t<addr_t, uint64_t> expected = {
+        { 0x10, 3 }, { 0x14, 1 }, { 0x100, 2 }, { 0x105, 1 }, { 0x200, 2 }
+    };
+    bool res = snapshot->bbv.block_instrs == expected;
+    if (!res) {
+        std::cerr << "got incorrect basic block vector:\n";
+        for (const auto &entry : snapshot->bbv.block_instrs)
+            std::cerr << "  " << std::hex << entry.first << std::dec << ": "
+                      << entry.second << "\n";
+    }
+    tool.release_interval_snapshot(snapshot);
+    return res;
+}
+
+bool
+check_clustering()
+{
+    static constexpr uint64_t INTERVAL_LENGTH = 1000;
+    static constexpr int BLOCKS_PER_PHASE = 10;
+    // Three phases, each executing its own set of blocks with some noise in the
+    // per-block counts, laid out as A A ... B B ... A A ... C C ...
+    auto phase_of = [](size_t interval) {
+        return (interval < 10 || (interval >= 15 && interval < 30))
+            ? 0
+            : (interval < 15 ? 1 : 2);
+    };
+    std::vector<simpoint_t::bbv_t> bbvs(40);
+    for (size_t i = 0; i < bbvs.size(); ++i) {
+        simpoint_t::bbv_t &bbv = bbvs[i];
+        bbv.start_instr = i * INTERVAL_LENGTH;
+        bbv.instr_count = INTERVAL_LENGTH;
+        addr_t base = 0x10000 * (phase_of(i) + 1);
+        uint64_t remaining = INTERVAL_LENGTH;
+        for (int j = 0; j < BLOCKS_PER_PHASE - 1; ++j) {
+            uint64_t noise = ((i * BLOCKS_PER_PHASE + j) * 2654435761ULL >> 16) % 21;
+            uint64_t count = INTERVAL_LENGTH / BLOCKS_PER_PHASE - 10 + noise;
+            bbv.block_instrs[base + j * 0x10] = count;
+            remaining -= count;
+        }
+        bbv.block_instrs[base + (BLOCKS_PER_PHASE - 1) * 0x10] = remaining;
+    }
+    std::vector<const simpoint_t::bbv_t *> intervals;
+    for (const auto &bbv : bbvs)
+        intervals.push_back(&bbv);
+    simpoint_t tool(/*max_k=*/10, /*dimensions=*/15, /*output_file=*/"", /*verbose=*/0);
+    std::vector<int> assignment;
+    std::vector<simpoint_t::simpoint_info_t> simpoints =
+        tool.select_simpoints(intervals, &assignment);
+    if (simpoints.size() != 3) {
+        std::cerr << "expected 3 simpoints, got " << simpoints.size() << "\n";
+        return false;
+    }
+    // Every interval of a phase must land in the same cluster.
+    for (size_t i = 0; i < bbvs.size(); ++i) {
+        static constexpr size_t FIRST_OF_PHASE[] = { 0, 10, 30 };
+        if (assignment[i] != assignment[FIRST_OF_PHASE[phase_of(i)]]) {
+            std::cerr << "interval " << i << " is in the wrong cluster\n";
+            return false;
+        }
+    }
+    // Each phase gets one representative from within it, weighted by its share.
+    const double expected_weights[] = { 25. / 40., 5. / 40., 10. / 40. };
+    bool seen_phase[3] = { false, false, false };
+    for (size_t i = 0; i < simpoints.size(); ++i) {
+        uint64_t index = simpoints[i].start_instr / INTERVAL_LENGTH;
+        int phase = phase_of(index);
+        if ((i > 0 && simpoints[i].start_instr <= simpoints[i - 1].start_instr) ||
+            seen_phase[phase] ||
+            std::abs(simpoints[i].weight - expected_weights[phase]) > 1e-9 ||
+            simpoints[i].instr_count != INTERVAL_LENGTH ||
+            simpoints[i].interval_index != index ||
+            assignment[index] != simpoints[i].cluster) {
+            std::cerr << "incorrect simpoint #" << i << ": start "
+                      << simpoints[i].start_instr << " weight " << simpoints[i].weight
+                      << "\n";
+            return false;
+        }
+        seen_phase[phase] = true;
+    }
+    // The result must not depend on anything but the input.
+    std::vector<simpoint_t::simpoint_info_t> again = tool.select_simpoints(intervals);
+    for (size_t i = 0; i < simpoints.size(); ++i) {
+        if (again[i].start_instr != simpoints[i].start_instr) {
+            std::cerr << "non-deterministic simpoint selection\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int
+test_main(int argc, const char *argv[])
+{
+    if (check_blocks() && check_clustering()) {
+        std::cerr << "simpoint_test passed\n";
+        return 0;
+    }
+    std::cerr << "simpoint_test FAILED\n";
+    exit(1);
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
@@ -0,0 +1,203 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Tests for the mergeable sketches in sketches.h. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "sketches.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+#define CHECK(cond, msg, ...)             \
+    do {                                  \
+        if (!(cond)) {                    \
+            fprintf(stderr, "%s\n", msg); \
+            exit(1);                      \
+        }                                 \
+    } while (0)
+
+static bool
+within(double estimate, double actual, double relative_error)
+{
+    return std::abs(estimate - actual) <= relative_error * actual;
+}
+
+static void
+test_hyperloglog()
+{
+    hyperloglog_t empty;
+    CHECK(empty.empty() && empty.estimate() == 0, "empty estimate should be 0");
+
+    // Small sets are counted nearly exactly by linear counting.
+    hyperloglog_t small;
+    for (uint64_t i = 0; i < 100; ++i) {
+        small.add(i << 6);
+        small.add(i << 6);
+    }
+    CHECK(within(static_cast<double>(small.estimate()), 100., 0.02),
+          "small cardinality estimate too far off");
+
+    // Split a large key set unevenly across shards, with overlap, and check that
+    // merging the shards matches a single sketch of the union exactly.
+    const int num_shards = 8;
+    std::vector<hyperloglog_t> shards(num_shards);
+    hyperloglog_t whole;
+    std::mt19937_64 rng(7);
+    std::unordered_set<uint64_t> distinct;
+    for (int i = 0; i < 400000; ++i) {
+        uint64_t key = (rng() % 300000) << 6;
+        distinct.insert(key);
+        whole.add(key);
+        shards[rng() % num_shards].add(key);
+    }
+    hyperloglog_t merged;
+    for (const auto &shard : shards)
+        merged.merge(shard);
+    CHECK(merged == whole, "merged sketch differs from sketch of the union");
+    // The standard error at the default precision is 1.6%.
+    CHECK(within(static_cast<double>(merged.estimate()),
+                 static_cast<double>(distinct.size()), 0.05),
+          "large cardinality estimate too far off");
+    merged.clear();
+    CHECK(merged.empty() && merged.estimate() == 0, "clear failed");
+}
+
+static void
+test_count_min()
+{
+    count_min_sketch_t first(256, 4), second(256, 4);
+    std::unordered_map<uint64_t, uint64_t> actual;
+    std::mt19937_64 rng(11);
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t key = rng() % 5000;
+        ++actual[key];
+        (i % 3 == 0 ? first : second).add(key);
+    }
+    first.merge(second);
+    CHECK(first.total() == 100000, "merged total mismatch");
+    for (const auto &entry : actual) {
+        // Never an undercount, and bounded overcount with high probability.
+        uint64_t estimate = first.estimate(entry.first);
+        CHECK(estimate >= entry.second, "count-min estimate undercounted");
+        CHECK(estimate <= entry.second + 8 * first.total() / 256,
+              "count-min estimate overcounted");
+    }
+}
+
+static void
+test_heavy_hitters()
+{
+    // A skewed stream in which keys 0..9 are much more frequent than the rest,
+    // spread over shards that each see only part of it.
+    const int num_shards = 4;
+    std::vector<heavy_hitters_t> shards(num_shards, heavy_hitters_t(40));
+    std::unordered_map<uint64_t, uint64_t> actual;
+    std::mt19937_64 rng(13);
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t key = rng() % 4 == 0 ? rng() % 10 : 10 + rng() % 100000;
+        ++actual[key];
+        shards[rng() % num_shards].add(key << 6);
+    }
+    heavy_hitters_t merged(40);
+    for (const auto &shard : shards)
+        merged.merge(shard);
+    std::vector<std::pair<uint64_t, uint64_t>> top = merged.top(10);
+    CHECK(top.size() == 10, "wrong number of heavy hitters");
+    for (size_t i = 0; i < top.size(); ++i) {
+        CHECK((top[i].first >> 6) < 10, "missed a heavy hitter");
+        CHECK(top[i].second >= actual[top[i].first >> 6], "heavy hitter undercounted");
+        CHECK(i == 0 || top[i].second <= top[i - 1].second, "heavy hitters unsorted");
+    }
+    CHECK(merged.total() == 200000, "heavy hitters total mismatch");
+    CHECK(heavy_hitters_t().top(5).empty(), "empty heavy hitters not empty");
+}
+
+static void
+test_ddsketch()
+{
+    ddsketch_t empty;
+    CHECK(empty.empty() && empty.quantile(0.5) == 0., "empty quantile should be 0");
+
+    // Heavy-tailed integer values like reuse times, split across sketches.
+    const double accuracy = 0.01;
+    ddsketch_t first(accuracy), second(accuracy);
+    std::vector<double> values;
+    std::mt19937_64 rng(17);
+    std::lognormal_distribution<double> lognormal(4., 2.);
+    for (int i = 0; i < 100000; ++i) {
+        double value = std::floor(lognormal(rng)) + 1.;
+        values.push_back(value);
+        (i % 2 == 0 ? first : second).add(value);
+    }
+    first.add(0.);
+    values.push_back(0.);
+    first.merge(second);
+    std::sort(values.begin(), values.end());
+    CHECK(first.count() == values.size(), "merged count mismatch");
+    CHECK(first.min() == values.front() && first.max() == values.back(),
+          "min or max mismatch");
+    const double quantiles[] = { 0., 0.1, 0.5, 0.9, 0.99, 0.999, 1. };
+    for (double quantile : quantiles) {
+        double actual = values[static_cast<size_t>(quantile * (values.size() - 1))];
+        CHECK(within(first.quantile(quantile), actual, accuracy + 1e-9),
+              "quantile outside the relative accuracy");
+    }
+    // The bucket count depends on the range of values, not their number.
+    CHECK(first.get_bucket_count() < 2200, "too many buckets");
+}
+
+int
+test_main(int argc, const char *argv[])
+{
+    test_hyperloglog();
+    test_count_min();
+    test_heavy_hitters();
+    test_ddsketch();
+    std::cerr << "sketches_test passed\n";
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
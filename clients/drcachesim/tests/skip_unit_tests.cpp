@@ -34,10 +34,27 @@
 
 #include "droption.h"
 #include "zipfile_file_reader.h"
+#include "compressed_file_reader.h"
+#include "file_reader.h"
+#ifdef HAS_LZ4
+#    include "lz4_file_reader.h"
+#endif
+#ifdef UNIX
+#    include "mmap_file_reader.h"
+#endif
+#include "common/gzip_ostream.h"
+#ifdef HAS_LZ4
+#    include "common/lz4_ostream.h"
+#endif
+#include "common/trace_index.h"
+#include "common/uncompressed_ostream.h"
 #include "tools/view_create.h"
 
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <stdio.h>
 
 namespace dynamorio {
 namespace drmemtrace {
@@ -74,8 +91,19 @@ static droption_t<bool> op_verbose(DROPTION_SCOPE_FRONTEND, "verbose", false,
                                    "Whether to print diagnostics",
                                    "Whether to print diagnostics");
 
+typedef std::function<std::unique_ptr<reader_t>(const std::string &)> reader_factory_t;
+
+static std::unique_ptr<reader_t>
+create_zipfile_reader(const std::string &path)
+{
+    if (path.empty())
+        return std::unique_ptr<reader_t>(new zipfile_file_reader_t());
+    return std::unique_ptr<reader_t>(new zipfile_file_reader_t(path));
+}
+
 bool
-test_skip_initial()
+test_skip_initial(const std::string &trace_file = op_trace_file.get_value(),
+                  reader_factory_t create_reader = create_zipfile_reader)
 {
     int view_count = 10;
     // Our checked-in trace has a chunk size of 20, letting us test cross-chunk
@@ -90,12 +118,10 @@ test_skip_initial()
         std::stringstream capture;
         std::streambuf *prior = std::cerr.rdbuf(capture.rdbuf());
         // Open the trace.
-        std::unique_ptr<reader_t> iter = std::unique_ptr<reader_t>(
-            new zipfile_file_reader_t(op_trace_file.get_value()));
-        CHECK(!!iter, "failed to open zipfile");
+        std::unique_ptr<reader_t> iter = create_reader(trace_file);
+        CHECK(!!iter, "failed to open trace");
         CHECK(iter->init(), "failed to initialize reader");
-        std::unique_ptr<reader_t> iter_end =
-            std::unique_ptr<reader_t>(new zipfile_file_reader_t());
+        std::unique_ptr<reader_t> iter_end = create_reader("");
         // Run the tool.
         std::unique_ptr<analysis_tool_t> tool = std::unique_ptr<analysis_tool_t>(
             view_tool_create("", /*skip_refs=*/0, /*sim_refs=*/view_count, "att"));
@@ -160,6 +186,227 @@ test_skip_initial()
     return true;
 }
 
+bool
+test_read_ahead()
+{
+    // Compare what we read with background decompression against a plain reader.
+    set_zipfile_read_ahead(/*chunks_per_input=*/2, /*num_threads=*/2);
+    std::unique_ptr<reader_t> ahead =
+        std::unique_ptr<reader_t>(new zipfile_file_reader_t(op_trace_file.get_value()));
+    CHECK(ahead->init(), "failed to initialize read-ahead reader");
+    set_zipfile_read_ahead(0, 0);
+    std::unique_ptr<reader_t> plain =
+        std::unique_ptr<reader_t>(new zipfile_file_reader_t(op_trace_file.get_value()));
+    CHECK(plain->init(), "failed to initialize reader");
+    std::unique_ptr<reader_t> iter_end =
+        std::unique_ptr<reader_t>(new zipfile_file_reader_t());
+    int64_t count = 0;
+    for (; *plain != *iter_end; ++(*plain), ++(*ahead), ++count) {
+        CHECK(*ahead != *iter_end, "read-ahead reader ended early");
+        const memref_t &expect = **plain;
+        const memref_t &memref = **ahead;
+        CHECK(memref.data.type == expect.data.type &&
+                  memref.data.tid == expect.data.tid &&
+                  memref.data.addr == expect.data.addr &&
+                  memref.data.size == expect.data.size,
+              "read-ahead record mismatch");
+        CHECK(memref.marker.type != TRACE_TYPE_MARKER ||
+                  (memref.marker.marker_type == expect.marker.marker_type &&
+                   memref.marker.marker_value == expect.marker.marker_value),
+              "read-ahead marker mismatch");
+    }
+    CHECK(*ahead == *iter_end, "read-ahead reader did not end");
+    CHECK(count > 0, "no records read");
+    return true;
+}
+
+#ifdef UNIX
+bool
+test_mmap()
+{
+    // Write out the checked-in trace uncompressed, chunk footers and all, as an
+    // uncompressed trace converted from an archive would be.
+    const std::string path = "skip_unit_tests.mmap.trace";
+    {
+        zipfile_record_file_reader_t records(op_trace_file.get_value());
+        CHECK(records.init(), "failed to initialize record reader");
+        std::ofstream out(path, std::ofstream::binary);
+        CHECK(!!out, "failed to create uncompressed trace");
+        // The zipfile record reader cannot be default-constructed.
+        mmap_record_file_reader_t records_end;
+        for (; records != records_end; ++records) {
+            const trace_entry_t &entry = *records;
+            out.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        }
+    }
+    auto create_mmap_reader = [](const std::string &path) {
+        if (path.empty())
+            return std::unique_ptr<reader_t>(new mmap_file_reader_t());
+        return std::unique_ptr<reader_t>(new mmap_file_reader_t(path));
+    };
+    // The mapped records must match those from the archive.
+    std::unique_ptr<reader_t> mapped = create_mmap_reader(path);
+    CHECK(mapped->init(), "failed to initialize mmap reader");
+    std::unique_ptr<reader_t> zipped = create_zipfile_reader(op_trace_file.get_value());
+    CHECK(zipped->init(), "failed to initialize reader");
+    std::unique_ptr<reader_t> iter_end = create_zipfile_reader("");
+    std::unique_ptr<reader_t> mapped_end = create_mmap_reader("");
+    for (; *zipped != *iter_end; ++(*zipped), ++(*mapped)) {
+        CHECK(*mapped != *mapped_end, "mmap reader ended early");
+        const memref_t &expect = **zipped;
+        const memref_t &memref = **mapped;
+        CHECK(memref.data.type == expect.data.type &&
+                  memref.data.tid == expect.data.tid &&
+                  memref.data.addr == expect.data.addr &&
+                  memref.data.size == expect.data.size,
+              "mmap record mismatch");
+    }
+    CHECK(*mapped == *mapped_end, "mmap reader did not end");
+    // Skips jump across chunks by finding their footers.
+    if (!test_skip_initial(path, create_mmap_reader))
+        return false;
+    remove(path.c_str());
+    return true;
+}
+#endif
+
+// Copies the checked-in trace into "out", starting a new component after each chunk
+// footer just as raw2trace does.
+static bool
+write_indexed_trace(archive_ostream_t &out)
+{
+    zipfile_record_file_reader_t records(op_trace_file.get_value());
+    CHECK(records.init(), "failed to initialize record reader");
+    // The zipfile record reader cannot be default-constructed.
+    compressed_record_file_reader_t records_end;
+    uint64_t instr_count = 0;
+    uint64_t last_timestamp = 0;
+    for (; records != records_end; ++records) {
+        const trace_entry_t &entry = *records;
+        out.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        if (type_is_instr(static_cast<trace_type_t>(entry.type)))
+            ++instr_count;
+        else if (entry.type == TRACE_TYPE_MARKER &&
+                 entry.size == TRACE_MARKER_TYPE_TIMESTAMP)
+            last_timestamp = entry.addr;
+        else if (entry.type == TRACE_TYPE_MARKER &&
+                 entry.size == TRACE_MARKER_TYPE_CHUNK_FOOTER) {
+            CHECK(out.open_new_component("chunk").empty(), "failed to open component");
+            out.set_component_start(instr_count, last_timestamp);
+        }
+    }
+    CHECK(!!out, "failed to write trace");
+    return true;
+}
+
+// Counts the chunk index seeks of a reader, so that we know a skip used the
+// index rather than walking the whole way.
+template <typename ReaderType> class seek_counting_reader_t : public ReaderType {
+public:
+    seek_counting_reader_t()
+        : ReaderType()
+    {
+    }
+    seek_counting_reader_t(const std::string &path, int *seek_count)
+        : ReaderType(path)
+        , seek_count_(seek_count)
+    {
+    }
+
+protected:
+    bool
+    seek_to_chunk(uint64_t offset) override
+    {
+        if (!ReaderType::seek_to_chunk(offset))
+            return false;
+        ++*seek_count_;
+        return true;
+    }
+
+private:
+    int *seek_count_ = nullptr;
+};
+
+// Runs test_skip_initial() on the indexed trace at "path" and checks that each
+// skip reaching past the first chunk seeked there through the index.
+template <typename ReaderType>
+static bool
+test_indexed_skip(const std::string &path)
+{
+    int seek_count = 0;
+    auto create_reader = [&seek_count](const std::string &path) {
+        if (path.empty())
+            return std::unique_ptr<reader_t>(new seek_counting_reader_t<ReaderType>());
+        return std::unique_ptr<reader_t>(
+            new seek_counting_reader_t<ReaderType>(path, &seek_count));
+    };
+    if (!test_skip_initial(path, create_reader))
+        return false;
+    // test_skip_initial() skips 0 through 49 instructions and the chunks hold 20.
+    CHECK(seek_count == 30, "chunk index was not used for skipping");
+    return true;
+}
+
+bool
+test_chunk_index()
+{
+    // A gzip trace seeks to a chunk by starting a new decompressor at its member.
+    const std::string gz_path = "skip_unit_tests.index.trace.gz";
+    {
+        gzip_ostream_t out(gz_path);
+        if (!write_indexed_trace(out))
+            return false;
+    }
+    std::vector<trace_index_entry_t> entries;
+    CHECK(read_trace_index(gz_path, entries), "failed to read chunk index");
+    // The trace has 20-instruction chunks.
+    CHECK(entries.size() > 2 && entries[0].offset == 0 &&
+              entries[1].instr_ordinal == 20 && entries[1].timestamp > 0 &&
+              entries[2].offset > entries[1].offset,
+          "unexpected chunk index");
+    if (!test_indexed_skip<compressed_file_reader_t>(gz_path))
+        return false;
+    remove(gz_path.c_str());
+    remove(trace_index_path(gz_path).c_str());
+#ifdef HAS_LZ4
+    // An lz4 trace seeks to a chunk by starting a new decompressor at its frame.
+    const std::string lz4_path = "skip_unit_tests.index.trace.lz4";
+    {
+        lz4_ostream_t out(lz4_path);
+        if (!write_indexed_trace(out))
+            return false;
+    }
+    CHECK(read_trace_index(lz4_path, entries), "failed to read chunk index");
+    CHECK(entries.size() > 2 && entries[2].offset > entries[1].offset,
+          "unexpected chunk index");
+    if (!test_indexed_skip<lz4_file_reader_t>(lz4_path))
+        return false;
+    remove(lz4_path.c_str());
+    remove(trace_index_path(lz4_path).c_str());
+#endif
+    // An uncompressed trace's index holds plain file offsets, which both the
+    // stream reader and the mmap reader seek to.
+    const std::string path = "skip_unit_tests.index.trace";
+    {
+        uncompressed_ostream_t out(path);
+        if (!write_indexed_trace(out))
+            return false;
+    }
+    CHECK(read_trace_index(path, entries), "failed to read chunk index");
+    CHECK(entries.size() > 2 && entries[1].offset > 0 &&
+              entries[1].offset % sizeof(trace_entry_t) == 0,
+          "unexpected chunk index");
+    if (!test_indexed_skip<file_reader_t<std::ifstream *>>(path))
+        return false;
+#ifdef UNIX
+    if (!test_indexed_skip<mmap_file_reader_t>(path))
+        return false;
+#endif
+    remove(path.c_str());
+    remove(trace_index_path(path).c_str());
+    return true;
+}
+
 int
 test_main(int argc, const char *argv[])
 {
@@ -172,6 +419,18 @@ test_main(int argc, const char *argv[])
     }
     if (!test_skip_initial())
         return 1;
+    if (!test_read_ahead())
+        return 1;
+    // Repeat the skip tests with chunks inflated in the background.
+    set_zipfile_read_ahead(/*chunks_per_input=*/2, /*num_threads=*/2);
+    if (!test_skip_initial())
+        return 1;
+#ifdef UNIX
+    if (!test_mmap())
+        return 1;
+#endif
+    if (!test_chunk_index())
+        return 1;
     // TODO i#5538: Add tests that skip from the middle once we have full support
     // for duplicating the timestamp,cpu in that scenario.
     fprintf(stderr, "Success\n");
@@ -0,0 +1,218 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Tests for zstd_ostream_t, zstd_istream_t, and zstd_file_reader_t. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "archive_ostream.h"
+#include "memref.h"
+#include "mock_reader.h"
+#include "trace_entry.h"
+#include "zstd_file_reader.h"
+#include "zstd_istream.h"
+#include "zstd_ostream.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+#define CHECK(cond, msg, ...)             \
+    do {                                  \
+        if (!(cond)) {                    \
+            fprintf(stderr, "%s\n", msg); \
+            exit(1);                      \
+        }                                 \
+    } while (0)
+
+static constexpr memref_tid_t TID = 21;
+static constexpr memref_pid_t PID = 7;
+static constexpr int CHUNK_INSTRS = 100;
+static constexpr addr_t PC_BASE = 0x401000;
+static constexpr addr_t DATA_BASE = 0x7fff0000;
+
+// Returns a trace laid out like raw2trace output, with a chunk footer followed by
+// a timestamp and cpuid every CHUNK_INSTRS instructions.  Some of the jumps in
+// the pcs and data addresses are far enough to defeat the column predictors.
+static std::vector<trace_entry_t>
+make_trace(int num_instrs)
+{
+    std::vector<trace_entry_t> trace = {
+        test_util::make_header(TRACE_ENTRY_VERSION),
+        test_util::make_thread(TID),
+        test_util::make_pid(PID),
+        test_util::make_version(TRACE_ENTRY_VERSION),
+        test_util::make_marker(TRACE_MARKER_TYPE_FILETYPE, OFFLINE_FILE_TYPE_ENCODINGS),
+        test_util::make_marker(TRACE_MARKER_TYPE_CACHE_LINE_SIZE, 64),
+        test_util::make_marker(TRACE_MARKER_TYPE_CHUNK_INSTR_COUNT, CHUNK_INSTRS),
+        // The readers expect the page size to end the header.
+        test_util::make_marker(TRACE_MARKER_TYPE_PAGE_SIZE, 4096),
+    };
+    uint64_t timestamp = 1000;
+    addr_t pc = PC_BASE;
+    addr_t data = DATA_BASE;
+    for (int i = 0; i < num_instrs; ++i) {
+        if (i % CHUNK_INSTRS == 0) {
+            if (i > 0) {
+                trace.push_back(test_util::make_marker(TRACE_MARKER_TYPE_CHUNK_FOOTER,
+                                                       i / CHUNK_INSTRS - 1));
+            }
+            timestamp += 10 + i % 7;
+            trace.push_back(test_util::make_timestamp(timestamp));
+            trace.push_back(test_util::make_marker(TRACE_MARKER_TYPE_CPU_ID, i % 3));
+        }
+        trace.push_back(test_util::make_encoding(4, 0x90000000 + i));
+        trace.push_back(test_util::make_instr(pc, TRACE_TYPE_INSTR, 4));
+        pc += (i % 17 == 0) ? 0x123400 : 4;
+        if (i % 3 == 0)
+            trace.push_back(test_util::make_memref(data, TRACE_TYPE_READ, 8));
+        if (i % 5 == 0) {
+            trace.push_back(test_util::make_memref(data + 0x10000000 * (i % 4),
+                                                   TRACE_TYPE_WRITE, 4));
+        }
+        data += (i % 11 == 0) ? -0x2000 : 8;
+    }
+    trace.push_back(test_util::make_exit(TID));
+    trace.push_back(test_util::make_footer());
+    return trace;
+}
+
+// Writes "trace" to "out", starting a new component after each chunk footer
+// just as raw2trace does.
+static void
+write_trace(archive_ostream_t &out, const std::vector<trace_entry_t> &trace)
+{
+    CHECK(out, "failed to open output");
+    uint64_t instr_count = 0;
+    uint64_t last_timestamp = 0;
+    for (const trace_entry_t &entry : trace) {
+        out.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        if (type_is_instr(static_cast<trace_type_t>(entry.type)))
+            ++instr_count;
+        else if (entry.type == TRACE_TYPE_MARKER &&
+                 entry.size == TRACE_MARKER_TYPE_TIMESTAMP)
+            last_timestamp = entry.addr;
+        else if (entry.type == TRACE_TYPE_MARKER &&
+                 entry.size == TRACE_MARKER_TYPE_CHUNK_FOOTER) {
+            CHECK(out.open_new_component("chunk").empty(), "failed to open component");
+            out.set_component_start(instr_count, last_timestamp);
+        }
+    }
+    CHECK(out, "failed to write output");
+}
+
+static bool
+same_memref(const memref_t &a, const memref_t &b)
+{
+    return a.data.type == b.data.type && a.data.pid == b.data.pid &&
+        a.data.tid == b.data.tid && a.data.addr == b.data.addr &&
+        a.data.size == b.data.size;
+}
+
+// Checks that skipping "skip" instructions from the first instruction of the
+// zstd trace at "path" ends up where a linear walk over the same records does.
+static void
+check_skip(const std::string &path, const std::vector<trace_entry_t> &trace,
+           uint64_t skip)
+{
+    zstd_file_reader_t zstd(path);
+    // skip_instructions() is only public through the base class.
+    reader_t &reader = zstd;
+    zstd_file_reader_t end;
+    CHECK(reader.init(), "failed to initialize zstd reader");
+    test_util::mock_reader_t linear(trace);
+    test_util::mock_reader_t linear_end;
+    CHECK(linear.init(), "failed to initialize mock reader");
+    // Start both from the first instruction, past the headers.
+    while (!type_is_instr((*reader).instr.type))
+        ++reader;
+    while (!type_is_instr((*linear).instr.type))
+        ++linear;
+    reader.skip_instructions(skip);
+    linear.skip_instructions(skip);
+    for (int i = 0; i < 10 && linear != linear_end; ++i, ++reader, ++linear) {
+        CHECK(reader != end, "zstd reader ended early after skip");
+        CHECK(same_memref(*reader, *linear), "record mismatch after skip");
+        CHECK(reader.get_instruction_ordinal() == linear.get_instruction_ordinal(),
+              "instruction ordinal mismatch after skip");
+        CHECK(reader.get_last_timestamp() == linear.get_last_timestamp(),
+              "timestamp mismatch after skip");
+    }
+}
+
+// Checks that the frames of a zstd trace decompress to what was written and that
+// skipping through its seek table ends up where a linear walk does.
+static void
+test_zstd(const std::string &path, const std::vector<trace_entry_t> &trace)
+{
+    {
+        zstd_ostream_t out(path);
+        write_trace(out, trace);
+    }
+    {
+        zstd_istream_t in(path);
+        // Each chunk is a frame listed in the seek table.
+        CHECK(in.frame_count() == 5, "unexpected zstd frame count");
+        std::vector<trace_entry_t> entries(trace.size() + 1);
+        in.read(reinterpret_cast<char *>(entries.data()),
+                entries.size() * sizeof(trace_entry_t));
+        CHECK(static_cast<size_t>(in.gcount()) == trace.size() * sizeof(trace_entry_t),
+              "zstd input has the wrong size");
+        for (size_t i = 0; i < trace.size(); ++i) {
+            CHECK(entries[i].type == trace[i].type && entries[i].size == trace[i].size &&
+                      entries[i].addr == trace[i].addr,
+                  "zstd record mismatch");
+        }
+    }
+    for (uint64_t skip : { 1, CHUNK_INSTRS - 1, CHUNK_INSTRS, CHUNK_INSTRS + 1,
+                           CHUNK_INSTRS * 3 + 42, CHUNK_INSTRS * 5 - 2 })
+        check_skip(path, trace, skip);
+}
+
+int
+test_main(int argc, const char *argv[])
+{
+    std::vector<trace_entry_t> trace = make_trace(CHUNK_INSTRS * 5);
+    const std::string path = "zstd_unit_tests.trace.zst";
+    test_zstd(path, trace);
+    remove(path.c_str());
+    std::cerr << "zstd_unit_tests passed\n";
+    return 0;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
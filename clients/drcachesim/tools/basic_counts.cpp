@@ -41,7 +41,10 @@
 #include <cassert>
 #include <iomanip>
 #include <iostream>
+#include <istream>
+#include <memory>
 #include <mutex>
+#include <ostream>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -60,13 +63,14 @@ const std::string basic_counts_t::TOOL_NAME = "Basic counts tool";
 const char *const basic_counts_t::TOTAL_COUNT_PREFIX = " total";
 
 analysis_tool_t *
-basic_counts_tool_create(unsigned int verbose)
+basic_counts_tool_create(unsigned int verbose, bool sketch_mode)
 {
-    return new basic_counts_t(verbose);
+    return new basic_counts_t(verbose, sketch_mode);
 }
 
-basic_counts_t::basic_counts_t(unsigned int verbose)
+basic_counts_t::basic_counts_t(unsigned int verbose, bool sketch_mode)
     : knob_verbose_(verbose)
+    , knob_sketch_mode_(sketch_mode)
 {
     // Empty.
 }
@@ -92,6 +96,12 @@ basic_counts_t::initialize_shard_type(shard_type_t shard_type)
     return "";
 }
 
+bool
+basic_counts_t::data_addresses_needed()
+{
+    return false;
+}
+
 bool
 basic_counts_t::parallel_shard_supported()
 {
@@ -125,6 +135,97 @@ basic_counts_t::parallel_shard_error(void *shard_data)
     return per_shard->error;
 }
 
+static bool
+read_counters(basic_counts_t::counters_t &counters, std::istream &in)
+{
+    for (int64_t basic_counts_t::counters_t::*field :
+         basic_counts_t::counters_t::scalar_fields()) {
+        if (!(in >> counters.*field))
+            return false;
+    }
+    bool tracking;
+    size_t count;
+    if (!(in >> tracking >> count))
+        return false;
+    if (!tracking)
+        counters.stop_tracking_unique_pc_addrs();
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t pc;
+        if (!(in >> pc))
+            return false;
+        counters.unique_pc_addrs.insert(pc);
+    }
+    if (!(in >> count))
+        return false;
+    for (size_t i = 0; i < count; ++i) {
+        memref_tid_t tid;
+        if (!(in >> tid))
+            return false;
+        counters.unique_threads.insert(tid);
+    }
+    return counters.unique_pc_sketch.load(in);
+}
+
+bool
+basic_counts_t::parallel_shard_state_supported(std::string &config)
+{
+    config = TOOL_NAME + " sketch_mode=" + std::to_string(knob_sketch_mode_);
+    return true;
+}
+
+bool
+basic_counts_t::parallel_shard_state_save(void *shard_data, std::ostream &out)
+{
+    per_shard_t *per_shard = reinterpret_cast<per_shard_t *>(shard_data);
+    out << per_shard->tid << ' ' << per_shard->core << ' ' << per_shard->filetype_
+        << ' ' << per_shard->counters.size() << '\n';
+    for (counters_t &counters : per_shard->counters) {
+        for (int64_t counters_t::*field : counters_t::scalar_fields())
+            out << counters.*field << ' ';
+        out << counters.is_tracking_unique_pc_addrs() << ' '
+            << counters.unique_pc_addrs.size();
+        for (uint64_t pc : counters.unique_pc_addrs)
+            out << ' ' << pc;
+        out << ' ' << counters.unique_threads.size();
+        for (memref_tid_t tid : counters.unique_threads)
+            out << ' ' << tid;
+        out << ' ';
+        counters.unique_pc_sketch.save(out);
+        out << '\n';
+    }
+    if (!out.good()) {
+        per_shard->error = "Failed to write shard state";
+        return false;
+    }
+    return true;
+}
+
+void *
+basic_counts_t::parallel_shard_state_restore(int shard_index, std::istream &in)
+{
+    std::unique_ptr<per_shard_t> per_shard(new per_shard_t);
+    size_t num_counters;
+    bool ok = static_cast<bool>(in >> per_shard->tid >> per_shard->core >>
+                                per_shard->filetype_ >> num_counters) &&
+        num_counters > 0;
+    if (ok) {
+        per_shard->counters.resize(num_counters);
+        for (counters_t &counters : per_shard->counters) {
+            if (!read_counters(counters, in)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    if (!ok) {
+        error_string_ = "Invalid " + TOOL_NAME + " shard state";
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(shard_map_mutex_);
+    shard_map_[shard_index] = per_shard.get();
+    return per_shard.release();
+}
+
 bool
 basic_counts_t::parallel_shard_memref(void *shard_data, const memref_t &memref)
 {
@@ -142,7 +243,10 @@ basic_counts_t::parallel_shard_memref(void *shard_data, const memref_t &memref)
         } else {
             ++counters->user_instrs;
         }
-        counters->unique_pc_addrs.insert(memref.instr.addr);
+        if (knob_sketch_mode_)
+            counters->unique_pc_sketch.add(memref.instr.addr);
+        else
+            counters->unique_pc_addrs.insert(memref.instr.addr);
         // The encoding entries aren't exposed at the memref_t level, but
         // we use encoding_is_new as a proxy.
         if (TESTANY(OFFLINE_FILE_TYPE_ENCODINGS, per_shard->filetype_) &&
@@ -244,6 +348,24 @@ basic_counts_t::parallel_shard_memref(void *shard_data, const memref_t &memref)
     return true;
 }
 
+bool
+basic_counts_t::parallel_shard_batch_supported()
+{
+    return true;
+}
+
+bool
+basic_counts_t::parallel_shard_memref_batch(void *shard_data, const memref_t *memrefs,
+                                            size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        // A qualified call avoids the virtual dispatch.
+        if (!basic_counts_t::parallel_shard_memref(shard_data, memrefs[i]))
+            return false;
+    }
+    return true;
+}
+
 bool
 basic_counts_t::process_memref(const memref_t &memref)
 {
@@ -278,7 +400,10 @@ basic_counts_t::print_counters(const counters_t &counters, const std::string &pr
 {
     std::cerr << std::setw(12) << counters.instrs << prefix
               << " (fetched) instructions\n";
-    if (counters.is_tracking_unique_pc_addrs()) {
+    if (!counters.unique_pc_sketch.empty()) {
+        std::cerr << std::setw(12) << counters.unique_pc_sketch.estimate() << prefix
+                  << " unique (fetched) instructions (estimated)\n";
+    } else if (counters.is_tracking_unique_pc_addrs()) {
         std::cerr << std::setw(12) << counters.unique_pc_addrs.size() << prefix
                   << " unique (fetched) instructions\n";
     }
@@ -412,6 +537,7 @@ basic_counts_t::generate_shard_interval_snapshot(void *shard_data, uint64_t inte
     per_shard_t *per_shard = reinterpret_cast<per_shard_t *>(shard_data);
     count_snapshot_t *snapshot = new count_snapshot_t;
     // Tracking unique pc addresses for each snapshot takes up excessive space.
+    // In sketch mode the fixed-size unique_pc_sketch is still merged in.
     snapshot->counters.stop_tracking_unique_pc_addrs();
     for (const auto &ctr : per_shard->counters) {
         snapshot->counters += ctr;
@@ -424,6 +550,7 @@ basic_counts_t::generate_interval_snapshot(uint64_t interval_id)
 {
     count_snapshot_t *snapshot = new count_snapshot_t;
     // Tracking unique pc addresses for each snapshot takes up excessive space.
+    // In sketch mode the fixed-size unique_pc_sketch is still merged in.
     snapshot->counters.stop_tracking_unique_pc_addrs();
     for (const auto &shard : shard_map_) {
         for (const auto &ctr : shard.second->counters) {
@@ -445,7 +572,8 @@ basic_counts_t::combine_interval_snapshots(
     // unique_pc_addrs set. But we still need to explicitly disable
     // unique_pc_addrs tracking in result->counters using the following function
     // call. This is so that printing of unique_pc_addrs count is skipped as
-    // intended during print_interval_results.
+    // intended during print_interval_results. The unique_pc_sketch of each
+    // snapshot, present in sketch mode, is merged as usual.
     result->counters.stop_tracking_unique_pc_addrs();
     result->counters.shard_count = 0;
     for (const auto snapshot : latest_shard_snapshots) {
@@ -479,7 +607,14 @@ basic_counts_t::print_interval_results(
                   << ":\n";
         counters_t diff = snapshot->counters;
         diff -= last;
+        // A sketch of unique instructions cannot be differenced, so only the
+        // cumulative estimate is printed.
+        diff.unique_pc_sketch.clear();
         print_counters(diff, " interval delta");
+        if (!snapshot->counters.unique_pc_sketch.empty()) {
+            std::cerr << std::setw(12) << snapshot->counters.unique_pc_sketch.estimate()
+                      << " cumulative unique (fetched) instructions (estimated)\n";
+        }
         last = snapshot->counters;
         if (knob_verbose_ > 0) {
             if (snapshot->get_instr_count_cumulative() !=
@@ -44,13 +44,14 @@
 
 #include "analysis_tool.h"
 #include "memref.h"
+#include "sketches.h"
 
 namespace dynamorio {
 namespace drmemtrace {
 
 class basic_counts_t : public analysis_tool_t {
 public:
-    basic_counts_t(unsigned int verbose);
+    basic_counts_t(unsigned int verbose, bool sketch_mode = false);
     ~basic_counts_t() override;
     std::string
     initialize_stream(memtrace_stream_t *serial_stream) override;
@@ -63,6 +64,8 @@ public:
     bool
     print_results() override;
     bool
+    data_addresses_needed() override;
+    bool
     parallel_shard_supported() override;
     void *
     parallel_shard_init_stream(int shard_index, void *worker_data,
@@ -71,8 +74,19 @@ public:
     parallel_shard_exit(void *shard_data) override;
     bool
     parallel_shard_memref(void *shard_data, const memref_t &memref) override;
+    bool
+    parallel_shard_batch_supported() override;
+    bool
+    parallel_shard_memref_batch(void *shard_data, const memref_t *memrefs,
+                                size_t count) override;
     std::string
     parallel_shard_error(void *shard_data) override;
+    bool
+    parallel_shard_state_supported(std::string &config) override;
+    bool
+    parallel_shard_state_save(void *shard_data, std::ostream &out) override;
+    void *
+    parallel_shard_state_restore(int shard_index, std::istream &in) override;
     interval_state_snapshot_t *
     generate_shard_interval_snapshot(void *shard_data, uint64_t interval_id) override;
     interval_state_snapshot_t *
@@ -90,72 +104,64 @@ public:
         counters_t()
         {
         }
+        // The plain count fields, listed once so that the operators below and the
+        // saved shard state cannot miss a newly added counter.
+        static const std::vector<int64_t counters_t::*> &
+        scalar_fields()
+        {
+            static const std::vector<int64_t counters_t::*> fields = {
+                &counters_t::instrs,
+                &counters_t::user_instrs,
+                &counters_t::kernel_instrs,
+                &counters_t::instrs_nofetch,
+                &counters_t::user_nofetch_instrs,
+                &counters_t::kernel_nofetch_instrs,
+                &counters_t::prefetches,
+                &counters_t::loads,
+                &counters_t::stores,
+                &counters_t::sched_markers,
+                &counters_t::idle_markers,
+                &counters_t::wait_markers,
+                &counters_t::xfer_markers,
+                &counters_t::func_id_markers,
+                &counters_t::func_retaddr_markers,
+                &counters_t::func_arg_markers,
+                &counters_t::func_retval_markers,
+                &counters_t::phys_addr_markers,
+                &counters_t::phys_unavail_markers,
+                &counters_t::syscall_number_markers,
+                &counters_t::syscall_blocking_markers,
+                &counters_t::other_markers,
+                &counters_t::icache_flushes,
+                &counters_t::dcache_flushes,
+                &counters_t::encodings
+            };
+            return fields;
+        }
         counters_t &
         operator+=(const counters_t &rhs)
         {
-            instrs += rhs.instrs;
-            user_instrs += rhs.user_instrs;
-            kernel_instrs += rhs.kernel_instrs;
-            instrs_nofetch += rhs.instrs_nofetch;
-            user_nofetch_instrs += rhs.user_nofetch_instrs;
-            kernel_nofetch_instrs += rhs.kernel_nofetch_instrs;
-            prefetches += rhs.prefetches;
-            loads += rhs.loads;
-            stores += rhs.stores;
-            sched_markers += rhs.sched_markers;
-            idle_markers += rhs.idle_markers;
-            wait_markers += rhs.wait_markers;
-            xfer_markers += rhs.xfer_markers;
-            func_id_markers += rhs.func_id_markers;
-            func_retaddr_markers += rhs.func_retaddr_markers;
-            func_arg_markers += rhs.func_arg_markers;
-            func_retval_markers += rhs.func_retval_markers;
-            phys_addr_markers += rhs.phys_addr_markers;
-            phys_unavail_markers += rhs.phys_unavail_markers;
-            syscall_number_markers += rhs.syscall_number_markers;
-            syscall_blocking_markers += rhs.syscall_blocking_markers;
-            other_markers += rhs.other_markers;
-            icache_flushes += rhs.icache_flushes;
-            dcache_flushes += rhs.dcache_flushes;
-            encodings += rhs.encodings;
+            for (int64_t counters_t::*field : scalar_fields())
+                this->*field += rhs.*field;
             if (track_unique_pc_addrs) {
                 unique_pc_addrs.insert(rhs.unique_pc_addrs.begin(),
                                        rhs.unique_pc_addrs.end());
             }
+            unique_pc_sketch.merge(rhs.unique_pc_sketch);
             unique_threads.insert(rhs.unique_threads.begin(), rhs.unique_threads.end());
             return *this;
         }
         counters_t &
         operator-=(const counters_t &rhs)
         {
-            instrs -= rhs.instrs;
-            user_instrs -= rhs.user_instrs;
-            kernel_instrs -= rhs.kernel_instrs;
-            instrs_nofetch -= rhs.instrs_nofetch;
-            user_nofetch_instrs -= rhs.user_nofetch_instrs;
-            kernel_nofetch_instrs -= rhs.kernel_nofetch_instrs;
-            prefetches -= rhs.prefetches;
-            loads -= rhs.loads;
-            stores -= rhs.stores;
-            sched_markers -= rhs.sched_markers;
-            idle_markers -= rhs.idle_markers;
-            wait_markers -= rhs.wait_markers;
-            xfer_markers -= rhs.xfer_markers;
-            func_id_markers -= rhs.func_id_markers;
-            func_retaddr_markers -= rhs.func_retaddr_markers;
-            func_arg_markers -= rhs.func_arg_markers;
-            func_retval_markers -= rhs.func_retval_markers;
-            phys_addr_markers -= rhs.phys_addr_markers;
-            phys_unavail_markers -= rhs.phys_unavail_markers;
-            syscall_number_markers -= rhs.syscall_number_markers;
-            syscall_blocking_markers -= rhs.syscall_blocking_markers;
-            other_markers -= rhs.other_markers;
-            icache_flushes -= rhs.icache_flushes;
-            dcache_flushes -= rhs.dcache_flushes;
-            encodings -= rhs.encodings;
+            for (int64_t counters_t::*field : scalar_fields())
+                this->*field -= rhs.*field;
             for (const uint64_t addr : rhs.unique_pc_addrs) {
                 unique_pc_addrs.erase(addr);
             }
+            // A sketch cannot be subtracted from, so a difference has none.
+            if (!rhs.unique_pc_sketch.empty())
+                unique_pc_sketch.clear();
             for (const memref_tid_t tid : rhs.unique_threads) {
                 unique_threads.erase(tid);
             }
@@ -167,27 +173,12 @@ public:
             // memcmp doesn't work with the unordered_set member. Also,
             // cannot compare till offsetof(basic_counts_t::counters_t, unique_pc_addrs)
             // as it gives a non-standard-layout type warning on osx.
-            return instrs == rhs.instrs && user_instrs == rhs.user_instrs &&
-                kernel_instrs == rhs.kernel_instrs &&
-                instrs_nofetch == rhs.instrs_nofetch &&
-                user_nofetch_instrs == rhs.user_nofetch_instrs &&
-                kernel_nofetch_instrs == rhs.kernel_nofetch_instrs &&
-                prefetches == rhs.prefetches && loads == rhs.loads &&
-                stores == rhs.stores && sched_markers == rhs.sched_markers &&
-                idle_markers == rhs.idle_markers && wait_markers == rhs.wait_markers &&
-                xfer_markers == rhs.xfer_markers &&
-                func_id_markers == rhs.func_id_markers &&
-                func_retaddr_markers == rhs.func_retaddr_markers &&
-                func_arg_markers == rhs.func_arg_markers &&
-                func_retval_markers == rhs.func_retval_markers &&
-                phys_addr_markers == rhs.phys_addr_markers &&
-                phys_unavail_markers == rhs.phys_unavail_markers &&
-                syscall_number_markers == rhs.syscall_number_markers &&
-                syscall_blocking_markers == rhs.syscall_blocking_markers &&
-                other_markers == rhs.other_markers &&
-                icache_flushes == rhs.icache_flushes &&
-                dcache_flushes == rhs.dcache_flushes && encodings == rhs.encodings &&
-                unique_pc_addrs == rhs.unique_pc_addrs &&
+            for (int64_t counters_t::*field : scalar_fields()) {
+                if (this->*field != rhs.*field)
+                    return false;
+            }
+            return unique_pc_addrs == rhs.unique_pc_addrs &&
+                unique_pc_sketch == rhs.unique_pc_sketch &&
                 unique_threads == rhs.unique_threads;
         }
         int64_t instrs = 0;
@@ -218,6 +209,9 @@ public:
         // we use encoding_is_new as a proxy.
         int64_t encodings = 0;
         std::unordered_set<uint64_t> unique_pc_addrs;
+        // Used instead of unique_pc_addrs in sketch mode.  Unlike the set, this
+        // has a fixed size and so is kept in interval snapshots.
+        hyperloglog_t unique_pc_sketch;
         std::unordered_set<memref_tid_t> unique_threads;
 
         // Metadata for the counts. These are not used for the equality, increment,
@@ -295,6 +289,7 @@ protected:
     // shard_map (process_memref, print_results) we are single-threaded.
     std::mutex shard_map_mutex_;
     unsigned int knob_verbose_;
+    bool knob_sketch_mode_;
     static const std::string TOOL_NAME;
     static const char *const TOTAL_COUNT_PREFIX;
     shard_type_t shard_type_ = SHARD_BY_THREAD;
@@ -47,10 +47,12 @@ namespace drmemtrace {
 
 /**
  * Creates an analysis tool which counts the number of instructions, loads, stores,
- * prefetch, threads, and markers in the trace.
+ * prefetch, threads, and markers in the trace.  If \p sketch_mode is set, the
+ * unique instruction count is estimated with a fixed-size mergeable sketch rather
+ * than an exact set of addresses, which also lets interval snapshots report it.
  */
 analysis_tool_t *
-basic_counts_tool_create(unsigned int verbose = 0);
+basic_counts_tool_create(unsigned int verbose = 0, bool sketch_mode = false);
 
 } // namespace drmemtrace
 } // namespace dynamorio
@@ -30,10 +30,13 @@
  * DAMAGE.
  */
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <mutex>
+#include <utility>
 
 // Needs to be included before trace_entry.h or build_target_arch_type will not
 // be defined by trace_entry.h.
@@ -76,6 +79,161 @@ instr_decode_info_t::~instr_decode_info_t()
     }
 }
 
+shared_decode_cache_t::decoded_t::~decoded_t()
+{
+    if (instr != nullptr)
+        instr_destroy(dcontext, instr);
+}
+
+shared_decode_cache_t::shared_decode_cache_t(size_t max_entries)
+    : hits_(0)
+    , decodes_(0)
+    , evictions_(0)
+{
+    // Misses in the tools' own caches are rare after warmup, so a few stripes
+    // suffice to keep lock contention low; a small cache uses fewer so that its
+    // bound stays close to exact.
+    static constexpr size_t MAX_STRIPES = 64;
+    static constexpr size_t MIN_STRIPE_CAPACITY = 1024;
+    size_t num_stripes = 1;
+    while (num_stripes < MAX_STRIPES &&
+           num_stripes * 2 * MIN_STRIPE_CAPACITY <= max_entries)
+        num_stripes *= 2;
+    stripe_capacity_ = std::max<size_t>(max_entries / num_stripes, 1);
+    for (size_t i = 0; i < num_stripes; ++i)
+        stripes_.emplace_back(new stripe_t);
+}
+
+shared_decode_cache_t::~shared_decode_cache_t()
+{
+    // Free the instrs while DR is still initialized.
+    stripes_.clear();
+    if (dr_initialized_)
+        dr_standalone_exit();
+}
+
+size_t
+shared_decode_cache_t::key_hash_t::operator()(const key_t &key) const
+{
+    uint64_t hash = key.pc ^ (static_cast<uint64_t>(key.isa_mode) << 56) ^ key.length;
+    for (size_t i = 0; i < key.length; i += sizeof(uint64_t)) {
+        uint64_t chunk = 0;
+        memcpy(&chunk, key.encoding + i, std::min(sizeof(chunk), key.length - i));
+        hash = (hash ^ chunk) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 29;
+    }
+    return static_cast<size_t>(hash);
+}
+
+std::shared_ptr<const shared_decode_cache_t::decoded_t>
+shared_decode_cache_t::decode(void *dcontext, app_pc decode_pc, app_pc trace_pc,
+                              size_t length)
+{
+    assert(length <= MAX_ENCODING_LENGTH);
+    key_t key;
+    key.pc = reinterpret_cast<uint64_t>(trace_pc);
+    key.isa_mode = static_cast<int>(dr_get_isa_mode(dcontext));
+    key.length = length;
+    memcpy(key.encoding, decode_pc, length);
+    const size_t hash = key_hash_t()(key);
+    // Use the high bits, as the unordered_map uses the low ones.
+    stripe_t &stripe = *stripes_[(hash >> 48) % stripes_.size()];
+    {
+        std::lock_guard<std::mutex> guard(stripe.mutex);
+        auto it = stripe.index.find(key);
+        if (it != stripe.index.end()) {
+            slot_t &slot = stripe.slots[it->second];
+            slot.referenced = true;
+            ++hits_;
+            return slot.decoded;
+        }
+    }
+    std::call_once(dr_init_once_, [this]() {
+        dr_standalone_init();
+        dr_initialized_ = true;
+    });
+    // Decode outside the lock, from our own copy of the encoding so that the
+    // raw bits remain valid for the life of the entry.
+    std::shared_ptr<decoded_t> decoded(new decoded_t);
+    decoded->dcontext = dcontext;
+    memcpy(decoded->encoding, key.encoding, length);
+    decoded->instr = instr_create(dcontext);
+    app_pc next_pc =
+        decode_from_copy(dcontext, decoded->encoding, trace_pc, decoded->instr);
+    if (next_pc == nullptr || !instr_valid(decoded->instr)) {
+        instr_destroy(dcontext, decoded->instr);
+        decoded->instr = nullptr;
+    } else {
+        // See the comment on decoded_t::shareable.
+        decoded->shareable =
+            instr_get_category(decoded->instr) != DR_INSTR_CATEGORY_UNCATEGORIZED;
+    }
+    ++decodes_;
+    std::lock_guard<std::mutex> guard(stripe.mutex);
+    auto it = stripe.index.find(key);
+    if (it != stripe.index.end()) {
+        // Another thread decoded it first; ours is freed on return.
+        return stripe.slots[it->second].decoded;
+    }
+    insert(stripe, key, decoded);
+    return decoded;
+}
+
+void
+shared_decode_cache_t::insert(stripe_t &stripe, const key_t &key,
+                              std::shared_ptr<const decoded_t> decoded)
+{
+    if (stripe.slots.size() < stripe_capacity_) {
+        stripe.index.emplace(key, stripe.slots.size());
+        stripe.slots.emplace_back();
+        stripe.slots.back().key = key;
+        stripe.slots.back().decoded = std::move(decoded);
+        return;
+    }
+    // Advance the clock hand past recently used slots, giving each a second
+    // chance, and replace the first one not used since the hand last passed.
+    while (stripe.slots[stripe.hand].referenced) {
+        stripe.slots[stripe.hand].referenced = false;
+        stripe.hand = (stripe.hand + 1) % stripe.slots.size();
+    }
+    slot_t &victim = stripe.slots[stripe.hand];
+    stripe.index.erase(victim.key);
+    ++evictions_;
+    victim.key = key;
+    victim.decoded = std::move(decoded);
+    stripe.index.emplace(key, stripe.hand);
+    stripe.hand = (stripe.hand + 1) % stripe.slots.size();
+}
+
+size_t
+shared_decode_cache_t::size()
+{
+    size_t total = 0;
+    for (auto &stripe : stripes_) {
+        std::lock_guard<std::mutex> guard(stripe->mutex);
+        total += stripe->slots.size();
+    }
+    return total;
+}
+
+uint64_t
+shared_decode_cache_t::get_hit_count() const
+{
+    return hits_.load();
+}
+
+uint64_t
+shared_decode_cache_t::get_decode_count() const
+{
+    return decodes_.load();
+}
+
+uint64_t
+shared_decode_cache_t::get_eviction_count() const
+{
+    return evictions_.load();
+}
+
 decode_cache_base_t::decode_cache_base_t(unsigned int verbosity)
     : verbosity_(verbosity)
 {
@@ -98,6 +256,20 @@ decode_cache_base_t::~decode_cache_base_t()
     }
 }
 
+void
+decode_cache_base_t::set_shared_decode_cache(std::shared_ptr<shared_decode_cache_t> cache)
+{
+    std::lock_guard<std::mutex> guard(shared_decode_cache_mutex_);
+    installed_shared_decode_cache_ = std::move(cache);
+}
+
+void
+decode_cache_base_t::init_shared_decode_cache()
+{
+    std::lock_guard<std::mutex> guard(shared_decode_cache_mutex_);
+    shared_decode_cache_ = installed_shared_decode_cache_;
+}
+
 std::string
 decode_cache_base_t::init_module_mapper(const std::string &module_file_path,
                                         const std::string &alt_module_dir)
@@ -206,6 +378,9 @@ std::unique_ptr<module_mapper_t> decode_cache_base_t::module_mapper_;
 std::string decode_cache_base_t::module_file_path_used_for_init_;
 char *decode_cache_base_t::modfile_bytes_ = nullptr;
 int decode_cache_base_t::module_mapper_use_count_ = 0;
+std::mutex decode_cache_base_t::shared_decode_cache_mutex_;
+std::shared_ptr<shared_decode_cache_t>
+    decode_cache_base_t::installed_shared_decode_cache_;
 
 } // namespace drmemtrace
 } // namespace dynamorio
@@ -38,7 +38,9 @@
  *   from the mapped app binaries otherwise;
  * - decoding the instr raw bytes to create the #instr_t;
  * - caching of data derived from the decoded #instr_t, and updating the cache
- *   appropriately based on the encoding_is_new field for embedded encodings.
+ *   appropriately based on the encoding_is_new field for embedded encodings;
+ * - optionally sharing the decoded #instr_t for each unique encoding among all
+ *   tools and shards via a #dynamorio::drmemtrace::shared_decode_cache_t.
  */
 
 #ifndef _DECODE_CACHE_H_
@@ -47,11 +49,13 @@
 #include "memref.h"
 #include "raw2trace_shared.h"
 
+#include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace dynamorio {
 namespace drmemtrace {
@@ -164,6 +168,114 @@ private:
     void *dcontext_ = nullptr;
 };
 
+/**
+ * A concurrent cache of decoded instructions keyed by encoding bytes, pc, and ISA
+ * mode, meant to be owned by the analyzer and shared by every
+ * #dynamorio::drmemtrace::decode_cache_t of every tool and shard, so that each
+ * unique instruction is decoded once per run rather than once per tool per shard.
+ * Once installed with decode_cache_base_t::set_shared_decode_cache(),
+ * #dynamorio::drmemtrace::decode_cache_t instances initialized afterward obtain
+ * their decoded #instr_t from it on a miss in their own cache.
+ *
+ * The cache is split into independently locked stripes, and decoding happens
+ * outside of any lock: if two threads race to decode the same encoding, the
+ * first to insert it wins and the other's copy is discarded.  Memory is bounded
+ * by \p max_entries, past which entries are evicted in CLOCK (second chance)
+ * order.  A returned entry stays valid for as long as the caller holds it, even
+ * if it is evicted meanwhile.
+ */
+class shared_decode_cache_t {
+public:
+    /**
+     * A decoded instruction.  The #instr_t is nullptr if decoding failed; it is
+     * fully decoded and is shared, so it must not be modified.
+     */
+    struct decoded_t {
+        ~decoded_t();
+        instr_t *instr = nullptr;
+        void *dcontext = nullptr;
+        // Whether instr can be read by multiple threads at once.  This is false
+        // for instrs without a category, which DR decodes again in place on every
+        // instr_get_category() call; those are decoded privately by each user.
+        bool shareable = false;
+        // The instr's raw bits point here.
+        unsigned char encoding[MAX_ENCODING_LENGTH];
+    };
+
+    /**
+     * Creates a cache holding at most \p max_entries decoded instructions.
+     */
+    explicit shared_decode_cache_t(size_t max_entries);
+    ~shared_decode_cache_t();
+
+    /**
+     * Returns the decoded instruction for the \p length bytes at \p decode_pc
+     * which were traced at \p trace_pc, decoding them with \p dcontext and its
+     * current ISA mode if they are not yet cached.  \p length must be at most
+     * #MAX_ENCODING_LENGTH.
+     */
+    std::shared_ptr<const decoded_t>
+    decode(void *dcontext, app_pc decode_pc, app_pc trace_pc, size_t length);
+
+    /** Returns the number of instructions currently cached. */
+    size_t
+    size();
+    /** Returns the number of decode() calls that found a cached instruction. */
+    uint64_t
+    get_hit_count() const;
+    /** Returns the number of instructions decoded, including discarded races. */
+    uint64_t
+    get_decode_count() const;
+    /** Returns the number of instructions evicted to stay within the bound. */
+    uint64_t
+    get_eviction_count() const;
+
+private:
+    struct key_t {
+        bool
+        operator==(const key_t &rhs) const
+        {
+            return pc == rhs.pc && isa_mode == rhs.isa_mode && length == rhs.length &&
+                memcmp(encoding, rhs.encoding, length) == 0;
+        }
+        uint64_t pc = 0;
+        int isa_mode = 0;
+        size_t length = 0;
+        unsigned char encoding[MAX_ENCODING_LENGTH] = {};
+    };
+    struct key_hash_t {
+        size_t
+        operator()(const key_t &key) const;
+    };
+    struct slot_t {
+        key_t key;
+        std::shared_ptr<const decoded_t> decoded;
+        // Set on each hit and cleared as the clock hand passes.
+        bool referenced = false;
+    };
+    struct stripe_t {
+        std::mutex mutex;
+        std::unordered_map<key_t, size_t, key_hash_t> index;
+        std::vector<slot_t> slots;
+        size_t hand = 0;
+    };
+
+    // Inserts into the locked stripe, evicting if it is full.
+    void
+    insert(stripe_t &stripe, const key_t &key, std::shared_ptr<const decoded_t> decoded);
+
+    std::vector<std::unique_ptr<stripe_t>> stripes_;
+    size_t stripe_capacity_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> decodes_;
+    std::atomic<uint64_t> evictions_;
+    // Holds a reference to DR's standalone mode, taken on the first decode, so
+    // that cached instrs can be freed in the destructor whatever the tools' order
+    // of destruction.
+    std::once_flag dr_init_once_;
+    bool dr_initialized_ = false;
+};
+
 /**
  * Base class for #dynamorio::drmemtrace::decode_cache_t.
  *
@@ -171,6 +283,16 @@ private:
  * of #dynamorio::drmemtrace::decode_cache_t.
  */
 class decode_cache_base_t {
+public:
+    /**
+     * Installs \p cache as the #dynamorio::drmemtrace::shared_decode_cache_t used
+     * by #dynamorio::drmemtrace::decode_cache_t instances on which init() is
+     * called afterward, or stops sharing if \p cache is nullptr.  Instances share
+     * ownership of the cache they were initialized with.
+     */
+    static void
+    set_shared_decode_cache(std::shared_ptr<shared_decode_cache_t> cache);
+
 protected:
     /**
      * Constructor for the base class, intentionally declared as protected so
@@ -188,6 +310,21 @@ protected:
     static char *modfile_bytes_;
     static int module_mapper_use_count_;
 
+    static std::mutex shared_decode_cache_mutex_;
+    static std::shared_ptr<shared_decode_cache_t> installed_shared_decode_cache_;
+
+    /**
+     * The cache installed by set_shared_decode_cache() when init() was called,
+     * if any.
+     */
+    std::shared_ptr<shared_decode_cache_t> shared_decode_cache_;
+
+    /**
+     * Sets shared_decode_cache_ to the installed cache.
+     */
+    void
+    init_shared_decode_cache();
+
     /**
      * use_module_mapper_ describes whether we lookup the instr encodings
      * from the module map, or alternatively from embedded-encodings in the
@@ -412,10 +549,30 @@ public:
             }
         }
 
-        // Optionally decode the instruction.
+        // Optionally decode the instruction, preferably by looking it up in the
+        // shared cache.  The shared entry need only outlive set_decode_info().
         instr_t *instr = nullptr;
         instr_noalloc_t noalloc;
-        if (include_decoded_instr_) {
+        std::shared_ptr<const shared_decode_cache_t::decoded_t> shared;
+        if (include_decoded_instr_ && shared_decode_cache_ != nullptr &&
+            memref_instr.size > 0 && memref_instr.size <= MAX_ENCODING_LENGTH) {
+            shared = shared_decode_cache_->decode(dcontext_, decode_pc, trace_pc,
+                                                  memref_instr.size);
+            if (shared->instr == nullptr) {
+                cached_decode_info->error_string_ = "decode_from_copy failed";
+                return cached_decode_info->get_error_string();
+            }
+            if (persist_decoded_instr_) {
+                instr = instr_clone(dcontext_, shared->instr);
+                // Stop pointing at the shared entry's encoding.
+                instr_make_persistent(dcontext_, instr);
+            } else if (shared->shareable) {
+                // The DecodeInfo only reads the instr during the call, so it can
+                // be given the shared one in place of a private noalloc decoding.
+                instr = shared->instr;
+            }
+        }
+        if (include_decoded_instr_ && instr == nullptr) {
             if (persist_decoded_instr_) {
                 instr = instr_create(dcontext_);
             } else {
@@ -522,6 +679,8 @@ public:
             return "Trace does not have embedded encodings, and no module_file_path "
                    "provided";
         }
+        if (include_decoded_instr_)
+            init_shared_decode_cache();
         if (module_file_path.empty()) {
             init_done_ = true;
             return "";
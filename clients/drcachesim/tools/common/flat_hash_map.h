@@ -0,0 +1,625 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* flat_hash_map: an open-addressing hash map for integer keys, used for the
+ * per-shard state of the analysis tools.
+ */
+
+#ifndef _FLAT_HASH_MAP_H_
+#define _FLAT_HASH_MAP_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#    include <emmintrin.h>
+#    define FLAT_HASH_MAP_SSE2 1
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__) && \
+    defined(__ARM_NEON)
+#    include <arm_neon.h>
+#    define FLAT_HASH_MAP_NEON 1
+#endif
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/**
+ * A hash map from an integer key to a value, laid out in the style of
+ * SwissTable.  Entries live in one flat array of slots alongside an array of
+ * one-byte control values: the top bit of a control byte marks an empty or
+ * deleted slot, and otherwise the low 7 bits hold 7 bits of the key's hash.
+ * A lookup examines a whole group of 16 control bytes at once, with SSE2 or NEON
+ * where available, and only compares keys in slots whose hash bits match.
+ *
+ * Compared to std::unordered_map there is no allocation per entry: the table
+ * grows by moving every entry into a new single allocation holding both arrays.
+ * As with other open-addressing tables, any insertion can invalidate iterators
+ * and references to entries.  Iteration order is unspecified.
+ *
+ * The interface is the subset of std::unordered_map used by the tools.
+ */
+template <typename Key, typename Value> class flat_hash_map_t {
+    static_assert(std::is_integral<Key>::value || std::is_enum<Key>::value,
+                  "flat_hash_map_t requires an integer key");
+
+public:
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef std::pair<const Key, Value> value_type;
+    typedef size_t size_type;
+
+    template <bool IS_CONST> class iterator_base_t {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef flat_hash_map_t::value_type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef typename std::conditional<IS_CONST, const value_type *,
+                                          value_type *>::type pointer;
+        typedef typename std::conditional<IS_CONST, const value_type &,
+                                          value_type &>::type reference;
+
+        iterator_base_t() = default;
+        // Allows converting an iterator to a const_iterator.
+        template <bool OTHER_CONST,
+                  typename = typename std::enable_if<IS_CONST && !OTHER_CONST>::type>
+        iterator_base_t(const iterator_base_t<OTHER_CONST> &other)
+            : map_(other.map_)
+            , index_(other.index_)
+        {
+        }
+        reference
+        operator*() const
+        {
+            return map_->slots_[index_];
+        }
+        pointer
+        operator->() const
+        {
+            return &map_->slots_[index_];
+        }
+        iterator_base_t &
+        operator++()
+        {
+            index_ = map_->next_full(index_ + 1);
+            return *this;
+        }
+        iterator_base_t
+        operator++(int)
+        {
+            iterator_base_t old = *this;
+            ++*this;
+            return old;
+        }
+        bool
+        operator==(const iterator_base_t &other) const
+        {
+            return index_ == other.index_;
+        }
+        bool
+        operator!=(const iterator_base_t &other) const
+        {
+            return index_ != other.index_;
+        }
+
+    private:
+        friend class flat_hash_map_t;
+        template <bool> friend class iterator_base_t;
+        typedef typename std::conditional<IS_CONST, const flat_hash_map_t *,
+                                          flat_hash_map_t *>::type map_pointer;
+        iterator_base_t(map_pointer map, size_t index)
+            : map_(map)
+            , index_(index)
+        {
+        }
+        map_pointer map_ = nullptr;
+        size_t index_ = 0;
+    };
+    typedef iterator_base_t<false> iterator;
+    typedef iterator_base_t<true> const_iterator;
+
+    flat_hash_map_t() = default;
+    flat_hash_map_t(std::initializer_list<value_type> init)
+    {
+        reserve(init.size());
+        for (const value_type &entry : init)
+            insert(entry);
+    }
+    flat_hash_map_t(const flat_hash_map_t &other)
+    {
+        if (other.size_ == 0)
+            return;
+        allocate(other.capacity_);
+        memcpy(ctrl_, other.ctrl_, capacity_);
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (is_full(ctrl_[i]))
+                new (&slots_[i]) value_type(other.slots_[i]);
+        }
+        size_ = other.size_;
+        deleted_ = other.deleted_;
+    }
+    flat_hash_map_t(flat_hash_map_t &&other) noexcept
+    {
+        swap(other);
+    }
+    flat_hash_map_t &
+    operator=(const flat_hash_map_t &other)
+    {
+        if (this != &other) {
+            flat_hash_map_t copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+    flat_hash_map_t &
+    operator=(flat_hash_map_t &&other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            swap(other);
+        }
+        return *this;
+    }
+    ~flat_hash_map_t()
+    {
+        destroy();
+    }
+
+    iterator
+    begin()
+    {
+        return iterator(this, next_full(0));
+    }
+    iterator
+    end()
+    {
+        return iterator(this, capacity_);
+    }
+    const_iterator
+    begin() const
+    {
+        return const_iterator(this, next_full(0));
+    }
+    const_iterator
+    end() const
+    {
+        return const_iterator(this, capacity_);
+    }
+
+    size_t
+    size() const
+    {
+        return size_;
+    }
+    bool
+    empty() const
+    {
+        return size_ == 0;
+    }
+
+    iterator
+    find(const Key &key)
+    {
+        return iterator(this, find_index(key));
+    }
+    const_iterator
+    find(const Key &key) const
+    {
+        return const_iterator(this, find_index(key));
+    }
+    size_t
+    count(const Key &key) const
+    {
+        return find_index(key) == capacity_ ? 0 : 1;
+    }
+    Value &
+    at(const Key &key)
+    {
+        size_t index = find_index(key);
+        if (index == capacity_)
+            throw std::out_of_range("flat_hash_map_t::at");
+        return slots_[index].second;
+    }
+    const Value &
+    at(const Key &key) const
+    {
+        size_t index = find_index(key);
+        if (index == capacity_)
+            throw std::out_of_range("flat_hash_map_t::at");
+        return slots_[index].second;
+    }
+    Value &
+    operator[](const Key &key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool>
+    try_emplace(const Key &key, Args &&...args)
+    {
+        uint64_t hash = hash_key(key);
+        size_t index = find_index(key, hash);
+        if (index != capacity_)
+            return std::make_pair(iterator(this, index), false);
+        index = prepare_insert(hash);
+        new (&slots_[index])
+            value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+        return std::make_pair(iterator(this, index), true);
+    }
+    template <typename... Args>
+    std::pair<iterator, bool>
+    emplace(const Key &key, Args &&...args)
+    {
+        return try_emplace(key, std::forward<Args>(args)...);
+    }
+    template <typename Pair>
+    std::pair<iterator, bool>
+    insert(const Pair &entry)
+    {
+        return try_emplace(entry.first, entry.second);
+    }
+
+    size_t
+    erase(const Key &key)
+    {
+        size_t index = find_index(key);
+        if (index == capacity_)
+            return 0;
+        erase_index(index);
+        return 1;
+    }
+    iterator
+    erase(const_iterator pos)
+    {
+        erase_index(pos.index_);
+        return iterator(this, next_full(pos.index_ + 1));
+    }
+    iterator
+    erase(iterator pos)
+    {
+        return erase(const_iterator(pos));
+    }
+
+    // Removes all entries but keeps the allocated capacity.
+    void
+    clear()
+    {
+        if (capacity_ == 0)
+            return;
+        destroy_slots();
+        memset(ctrl_, CTRL_EMPTY, capacity_);
+        size_ = 0;
+        deleted_ = 0;
+    }
+    // Ensures that "count" entries fit without growing.
+    void
+    reserve(size_t count)
+    {
+        size_t capacity = GROUP_SIZE;
+        while (max_load(capacity) < count)
+            capacity *= 2;
+        if (capacity > capacity_)
+            rehash(capacity);
+    }
+    void
+    swap(flat_hash_map_t &other) noexcept
+    {
+        std::swap(memory_, other.memory_);
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(deleted_, other.deleted_);
+    }
+
+    bool
+    operator==(const flat_hash_map_t &other) const
+    {
+        if (size_ != other.size_)
+            return false;
+        for (const value_type &entry : *this) {
+            size_t index = other.find_index(entry.first);
+            if (index == other.capacity_ ||
+                !(other.slots_[index].second == entry.second))
+                return false;
+        }
+        return true;
+    }
+    bool
+    operator!=(const flat_hash_map_t &other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    static constexpr size_t GROUP_SIZE = 16;
+    // Control byte values.  Full slots hold 7 bits of the hash.
+    static constexpr int8_t CTRL_EMPTY = -128;
+    static constexpr int8_t CTRL_DELETED = -2;
+
+    // A bitmask with one bit, or for NEON one nibble, per slot of a group.
+#if defined(FLAT_HASH_MAP_NEON)
+    typedef uint64_t group_mask_t;
+    static constexpr int MASK_SHIFT = 2;
+    static group_mask_t
+    to_mask(uint8x16_t eq)
+    {
+        // Narrow each byte to a nibble and keep one bit per nibble.
+        uint8x8_t narrow = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(narrow), 0) & 0x8888888888888888ULL;
+    }
+#else
+    typedef uint32_t group_mask_t;
+    static constexpr int MASK_SHIFT = 0;
+#endif
+
+    static group_mask_t
+    match_byte(const int8_t *group, int8_t value)
+    {
+#if defined(FLAT_HASH_MAP_SSE2)
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<group_mask_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#elif defined(FLAT_HASH_MAP_NEON)
+        return to_mask(vceqq_s8(vld1q_s8(group), vdupq_n_s8(value)));
+#else
+        group_mask_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i) {
+            if (group[i] == value)
+                mask |= 1U << i;
+        }
+        return mask;
+#endif
+    }
+    // Matches empty and deleted slots, which are exactly those with the top bit set.
+    static group_mask_t
+    match_free(const int8_t *group)
+    {
+#if defined(FLAT_HASH_MAP_SSE2)
+        return static_cast<group_mask_t>(
+            _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group))));
+#elif defined(FLAT_HASH_MAP_NEON)
+        return to_mask(vcltzq_s8(vld1q_s8(group)));
+#else
+        group_mask_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i) {
+            if (group[i] < 0)
+                mask |= 1U << i;
+        }
+        return mask;
+#endif
+    }
+    static size_t
+    lowest_slot(group_mask_t mask)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_ctzll(mask)) >> MASK_SHIFT;
+#else
+        size_t bit = 0;
+        while ((mask & 1) == 0) {
+            mask >>= 1;
+            ++bit;
+        }
+        return bit >> MASK_SHIFT;
+#endif
+    }
+
+    static bool
+    is_full(int8_t ctrl)
+    {
+        return ctrl >= 0;
+    }
+    static uint64_t
+    hash_key(const Key &key)
+    {
+        // Keys such as cache line addresses have little entropy in their low bits,
+        // so we mix all bits into both the group index and the control bits.
+        uint64_t hash = static_cast<uint64_t>(key);
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+    static int8_t
+    hash_ctrl(uint64_t hash)
+    {
+        return static_cast<int8_t>(hash & 0x7f);
+    }
+    // The table is at most 7/8 full, counting deleted slots.
+    static size_t
+    max_load(size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+
+    // Returns the slot index holding "key", or capacity_ if there is none.
+    size_t
+    find_index(const Key &key) const
+    {
+        return find_index(key, hash_key(key));
+    }
+    size_t
+    find_index(const Key &key, uint64_t hash) const
+    {
+        if (size_ == 0)
+            return capacity_;
+        const size_t group_mask = capacity_ / GROUP_SIZE - 1;
+        const int8_t ctrl = hash_ctrl(hash);
+        size_t group = (hash >> 7) & group_mask;
+        // Triangular probing over a power-of-two group count visits every group.
+        for (size_t step = 1;; ++step) {
+            const int8_t *group_ctrl = ctrl_ + group * GROUP_SIZE;
+            for (group_mask_t mask = match_byte(group_ctrl, ctrl); mask != 0;
+                 mask &= mask - 1) {
+                size_t index = group * GROUP_SIZE + lowest_slot(mask);
+                if (slots_[index].first == key)
+                    return index;
+            }
+            // A group with an empty slot ends every probe sequence that reaches it.
+            if (match_byte(group_ctrl, CTRL_EMPTY) != 0)
+                return capacity_;
+            group = (group + step) & group_mask;
+        }
+    }
+    // Claims a free slot for a key with "hash" that is not present, growing the
+    // table if needed.  The caller constructs the slot.
+    size_t
+    prepare_insert(uint64_t hash)
+    {
+        if (size_ + deleted_ + 1 > max_load(capacity_)) {
+            // If most of the load is deleted slots, rehashing at the same size
+            // is enough to reclaim them.
+            size_t capacity = capacity_ == 0 ? GROUP_SIZE : capacity_;
+            if (size_ + 1 > max_load(capacity) / 2)
+                capacity *= 2;
+            rehash(capacity);
+        }
+        size_t index = find_free(hash);
+        if (ctrl_[index] == CTRL_DELETED)
+            --deleted_;
+        ctrl_[index] = hash_ctrl(hash);
+        ++size_;
+        return index;
+    }
+    size_t
+    find_free(uint64_t hash) const
+    {
+        const size_t group_mask = capacity_ / GROUP_SIZE - 1;
+        size_t group = (hash >> 7) & group_mask;
+        for (size_t step = 1;; ++step) {
+            group_mask_t mask = match_free(ctrl_ + group * GROUP_SIZE);
+            if (mask != 0)
+                return group * GROUP_SIZE + lowest_slot(mask);
+            group = (group + step) & group_mask;
+        }
+    }
+    void
+    erase_index(size_t index)
+    {
+        slots_[index].~value_type();
+        // A slot in a group that has never been full can become empty again, as
+        // no probe sequence continued past that group.  Otherwise we must leave a
+        // tombstone so probes keep going.
+        const int8_t *group_ctrl = ctrl_ + index / GROUP_SIZE * GROUP_SIZE;
+        if (match_byte(group_ctrl, CTRL_EMPTY) != 0)
+            ctrl_[index] = CTRL_EMPTY;
+        else {
+            ctrl_[index] = CTRL_DELETED;
+            ++deleted_;
+        }
+        --size_;
+    }
+    size_t
+    next_full(size_t index) const
+    {
+        while (index < capacity_ && !is_full(ctrl_[index]))
+            ++index;
+        return index;
+    }
+
+    void
+    allocate(size_t capacity)
+    {
+        // The control bytes and the slots share one allocation, with the slots
+        // aligned after the control bytes.
+        const size_t align = alignof(value_type);
+        size_t slot_offset = (capacity + align - 1) / align * align;
+        memory_ = ::operator new(slot_offset + capacity * sizeof(value_type));
+        ctrl_ = static_cast<int8_t *>(memory_);
+        slots_ =
+            reinterpret_cast<value_type *>(static_cast<char *>(memory_) + slot_offset);
+        capacity_ = capacity;
+        memset(ctrl_, CTRL_EMPTY, capacity_);
+    }
+    void
+    rehash(size_t capacity)
+    {
+        flat_hash_map_t old;
+        swap(old);
+        allocate(capacity);
+        for (size_t i = 0; i < old.capacity_; ++i) {
+            if (!is_full(old.ctrl_[i]))
+                continue;
+            uint64_t hash = hash_key(old.slots_[i].first);
+            size_t index = find_free(hash);
+            ctrl_[index] = hash_ctrl(hash);
+            new (&slots_[index]) value_type(std::move(old.slots_[i]));
+        }
+        size_ = old.size_;
+    }
+    void
+    destroy_slots()
+    {
+        if (std::is_trivially_destructible<value_type>::value)
+            return;
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (is_full(ctrl_[i]))
+                slots_[i].~value_type();
+        }
+    }
+    void
+    destroy()
+    {
+        if (memory_ == nullptr)
+            return;
+        destroy_slots();
+        ::operator delete(memory_);
+        memory_ = nullptr;
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+        size_ = 0;
+        deleted_ = 0;
+    }
+
+    void *memory_ = nullptr;
+    int8_t *ctrl_ = nullptr;
+    value_type *slots_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    size_t deleted_ = 0;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _FLAT_HASH_MAP_H_ */
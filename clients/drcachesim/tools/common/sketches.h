@@ -0,0 +1,556 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* sketches: mergeable probabilistic summaries used by the analysis tools'
+ * -sketch_mode to bound per-shard memory independently of the trace footprint.
+ */
+
+#ifndef _SKETCHES_H_
+#define _SKETCHES_H_ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "flat_hash_map.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+// Mixes all bits of a key such as a cache line or pc, whose low bits carry
+// little entropy.  This is the 64-bit murmur3 finalizer.
+static inline uint64_t
+sketch_hash(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+/**
+ * A HyperLogLog estimate of the number of distinct keys added.  The table of
+ * 2^precision one-byte registers is allocated on the first add(), so an unused
+ * instance costs nothing.  The standard error is about 1.04 / sqrt(2^precision):
+ * 1.6% at the default precision of 12, which takes 4KB.
+ *
+ * Two instances of the same precision merge exactly: the merged registers are
+ * those that would result from adding the union of both key sets.
+ */
+class hyperloglog_t {
+public:
+    static const int DEFAULT_PRECISION = 12;
+
+    explicit hyperloglog_t(int precision = DEFAULT_PRECISION)
+        : precision_(precision)
+    {
+        assert(precision_ >= 4 && precision_ <= 18);
+    }
+    void
+    add(uint64_t key)
+    {
+        if (registers_.empty())
+            registers_.resize(static_cast<size_t>(1) << precision_, 0);
+        uint64_t hash = sketch_hash(key);
+        size_t index = static_cast<size_t>(hash >> (64 - precision_));
+        // The guard bit bounds the rank at 64 - precision + 1.
+        uint64_t rest =
+            (hash << precision_) | (static_cast<uint64_t>(1) << (precision_ - 1));
+        uint8_t rank = static_cast<uint8_t>(leading_zeros(rest) + 1);
+        if (rank > registers_[index])
+            registers_[index] = rank;
+    }
+    void
+    merge(const hyperloglog_t &other)
+    {
+        assert(precision_ == other.precision_);
+        if (other.registers_.empty())
+            return;
+        if (registers_.empty()) {
+            registers_ = other.registers_;
+            return;
+        }
+        for (size_t i = 0; i < registers_.size(); ++i)
+            registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+    uint64_t
+    estimate() const
+    {
+        if (registers_.empty())
+            return 0;
+        const double num_registers = static_cast<double>(registers_.size());
+        double sum = 0.;
+        size_t zeros = 0;
+        for (uint8_t reg : registers_) {
+            sum += std::ldexp(1., -static_cast<int>(reg));
+            if (reg == 0)
+                ++zeros;
+        }
+        const double alpha = 0.7213 / (1. + 1.079 / num_registers);
+        double estimate = alpha * num_registers * num_registers / sum;
+        // Linear counting is more accurate while many registers are still zero.
+        if (estimate <= 2.5 * num_registers && zeros > 0)
+            estimate = num_registers * std::log(num_registers / zeros);
+        return static_cast<uint64_t>(estimate + 0.5);
+    }
+    bool
+    empty() const
+    {
+        return registers_.empty();
+    }
+    void
+    clear()
+    {
+        registers_.clear();
+    }
+    int
+    get_precision() const
+    {
+        return precision_;
+    }
+    bool
+    operator==(const hyperloglog_t &rhs) const
+    {
+        return precision_ == rhs.precision_ && registers_ == rhs.registers_;
+    }
+    // Writes the registers as text that load() reads back.
+    void
+    save(std::ostream &out) const
+    {
+        out << registers_.size();
+        for (uint8_t reg : registers_)
+            out << ' ' << static_cast<int>(reg);
+    }
+    bool
+    load(std::istream &in)
+    {
+        size_t size;
+        if (!(in >> size) ||
+            (size != 0 && size != static_cast<size_t>(1) << precision_))
+            return false;
+        registers_.resize(size);
+        for (uint8_t &reg : registers_) {
+            int value;
+            if (!(in >> value) || value < 0 || value > 64)
+                return false;
+            reg = static_cast<uint8_t>(value);
+        }
+        return true;
+    }
+
+private:
+    static int
+    leading_zeros(uint64_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(value);
+#else
+        int count = 0;
+        while ((value & (static_cast<uint64_t>(1) << 63)) == 0) {
+            value <<= 1;
+            ++count;
+        }
+        return count;
+#endif
+    }
+
+    int precision_;
+    std::vector<uint8_t> registers_;
+};
+
+/**
+ * A Count-Min sketch of per-key counts in depth rows of width counters each,
+ * allocated on the first add().  An estimate never undercounts, and with the
+ * conservative update used here it overcounts by at most a small multiple of
+ * total() / width with high probability.  Sketches of the same dimensions merge
+ * by adding their counters.
+ */
+class count_min_sketch_t {
+public:
+    explicit count_min_sketch_t(size_t width = 2048, size_t depth = 4)
+        : depth_(depth)
+    {
+        // Round up to a power of two so a row index is a mask.
+        width_ = 1;
+        while (width_ < width)
+            width_ <<= 1;
+    }
+    // Adds count to key and returns key's new estimated count.
+    uint64_t
+    add(uint64_t key, uint64_t count = 1)
+    {
+        if (counters_.empty())
+            counters_.resize(width_ * depth_, 0);
+        total_ += count;
+        uint64_t hash = sketch_hash(key);
+        uint64_t new_estimate = row_minimum(hash) + count;
+        // Conservative update: raise each row only as far as the new estimate.
+        for (size_t row = 0; row < depth_; ++row) {
+            uint64_t &counter = counters_[slot(hash, row)];
+            if (counter < new_estimate)
+                counter = new_estimate;
+        }
+        return new_estimate;
+    }
+    uint64_t
+    estimate(uint64_t key) const
+    {
+        if (counters_.empty())
+            return 0;
+        return row_minimum(sketch_hash(key));
+    }
+    void
+    merge(const count_min_sketch_t &other)
+    {
+        assert(width_ == other.width_ && depth_ == other.depth_);
+        total_ += other.total_;
+        if (other.counters_.empty())
+            return;
+        if (counters_.empty()) {
+            counters_ = other.counters_;
+            return;
+        }
+        for (size_t i = 0; i < counters_.size(); ++i)
+            counters_[i] += other.counters_[i];
+    }
+    // Returns the sum of all counts added.
+    uint64_t
+    total() const
+    {
+        return total_;
+    }
+
+private:
+    // Derives the row hashes from two halves of one hash (Kirsch and
+    // Mitzenmacher), which keeps the rows independent enough in practice.
+    size_t
+    slot(uint64_t hash, size_t row) const
+    {
+        uint64_t row_hash = (hash & 0xffffffffULL) + row * ((hash >> 32) | 1);
+        return row * width_ + static_cast<size_t>(row_hash & (width_ - 1));
+    }
+    uint64_t
+    row_minimum(uint64_t hash) const
+    {
+        uint64_t minimum = std::numeric_limits<uint64_t>::max();
+        for (size_t row = 0; row < depth_; ++row)
+            minimum = std::min(minimum, counters_[slot(hash, row)]);
+        return minimum;
+    }
+
+    size_t width_;
+    size_t depth_;
+    uint64_t total_ = 0;
+    std::vector<uint64_t> counters_;
+};
+
+/**
+ * Tracks the most frequent keys using a Count-Min sketch for the counts and a
+ * bounded set of candidate keys.  A key enters the candidate set when its
+ * estimated count exceeds that of the smallest candidate, which it evicts.
+ * Merging merges the sketches and keeps the largest of the union of both
+ * candidate sets, re-estimated from the merged sketch.
+ */
+class heavy_hitters_t {
+public:
+    explicit heavy_hitters_t(size_t capacity = 64)
+        : capacity_(std::max<size_t>(capacity, 1))
+    {
+    }
+    void
+    add(uint64_t key, uint64_t count = 1)
+    {
+        uint64_t estimate = sketch_.add(key, count);
+        auto it = candidates_.find(key);
+        if (it != candidates_.end()) {
+            it->second = estimate;
+            return;
+        }
+        if (candidates_.size() < capacity_) {
+            candidates_.emplace(key, estimate);
+            if (candidates_.size() == capacity_)
+                min_candidate_ = find_min_candidate()->second;
+            return;
+        }
+        // Candidate counts only grow, so min_candidate_ is a lower bound and this
+        // filters out nearly all keys without a scan.
+        if (estimate <= min_candidate_)
+            return;
+        auto min_it = find_min_candidate();
+        if (estimate > min_it->second) {
+            candidates_.erase(min_it);
+            candidates_.emplace(key, estimate);
+            min_it = find_min_candidate();
+        }
+        min_candidate_ = min_it->second;
+    }
+    void
+    merge(const heavy_hitters_t &other)
+    {
+        sketch_.merge(other.sketch_);
+        std::vector<std::pair<uint64_t, uint64_t>> merged;
+        merged.reserve(candidates_.size() + other.candidates_.size());
+        for (const auto &entry : candidates_)
+            merged.emplace_back(entry.first, sketch_.estimate(entry.first));
+        for (const auto &entry : other.candidates_) {
+            if (candidates_.find(entry.first) == candidates_.end())
+                merged.emplace_back(entry.first, sketch_.estimate(entry.first));
+        }
+        keep_largest(&merged, capacity_);
+        candidates_.clear();
+        for (const auto &entry : merged)
+            candidates_.emplace(entry.first, entry.second);
+        min_candidate_ = candidates_.size() < capacity_ || candidates_.empty()
+            ? 0
+            : find_min_candidate()->second;
+    }
+    // Returns up to count (key, estimated count) pairs, most frequent first.
+    std::vector<std::pair<uint64_t, uint64_t>>
+    top(size_t count) const
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> result(candidates_.begin(),
+                                                          candidates_.end());
+        keep_largest(&result, count);
+        return result;
+    }
+    uint64_t
+    estimate(uint64_t key) const
+    {
+        return sketch_.estimate(key);
+    }
+    uint64_t
+    total() const
+    {
+        return sketch_.total();
+    }
+
+private:
+    flat_hash_map_t<uint64_t, uint64_t>::iterator
+    find_min_candidate()
+    {
+        return std::min_element(candidates_.begin(), candidates_.end(),
+                                [](const std::pair<const uint64_t, uint64_t> &l,
+                                   const std::pair<const uint64_t, uint64_t> &r) {
+                                    return l.second < r.second;
+                                });
+    }
+    // Sorts by descending count, breaking ties by key for a deterministic order,
+    // and truncates to count entries.
+    static void
+    keep_largest(std::vector<std::pair<uint64_t, uint64_t>> *entries, size_t count)
+    {
+        auto greater = [](const std::pair<uint64_t, uint64_t> &l,
+                          const std::pair<uint64_t, uint64_t> &r) {
+            return l.second > r.second || (l.second == r.second && l.first < r.first);
+        };
+        if (entries->size() > count) {
+            std::partial_sort(entries->begin(), entries->begin() + count, entries->end(),
+                              greater);
+            entries->resize(count);
+        } else
+            std::sort(entries->begin(), entries->end(), greater);
+    }
+
+    size_t capacity_;
+    count_min_sketch_t sketch_;
+    flat_hash_map_t<uint64_t, uint64_t> candidates_;
+    uint64_t min_candidate_ = 0;
+};
+
+/**
+ * A quantile sketch in the style of DDSketch.  Positive values are counted in
+ * logarithmically sized buckets, where bucket i holds values in
+ * (gamma^(i-1), gamma^i] with gamma = (1 + accuracy) / (1 - accuracy), so any
+ * quantile is returned within the given relative accuracy of a value of that
+ * rank.  The number of buckets grows only with the logarithm of the range of
+ * values: under 2200 buckets cover every 64-bit integer at 1% accuracy.  The
+ * count, sum, minimum, and maximum are exact.  Sketches of the same accuracy
+ * merge by adding their buckets.
+ */
+class ddsketch_t {
+public:
+    explicit ddsketch_t(double relative_accuracy = 0.01)
+        : relative_accuracy_(relative_accuracy)
+        , gamma_((1. + relative_accuracy) / (1. - relative_accuracy))
+        , inverse_log_gamma_(1. / std::log(gamma_))
+    {
+        assert(relative_accuracy > 0. && relative_accuracy < 1.);
+    }
+    // Values that are not positive share a single bucket that reports 0.
+    void
+    add(double value, uint64_t count = 1)
+    {
+        if (count == 0)
+            return;
+        if (count_ == 0) {
+            min_ = value;
+            max_ = value;
+        } else {
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+        }
+        count_ += count;
+        sum_ += value * count;
+        if (value <= 0.) {
+            zero_count_ += count;
+            return;
+        }
+        *bucket(bucket_key(value)) += count;
+    }
+    void
+    merge(const ddsketch_t &other)
+    {
+        assert(relative_accuracy_ == other.relative_accuracy_);
+        if (other.count_ == 0)
+            return;
+        if (count_ == 0) {
+            min_ = other.min_;
+            max_ = other.max_;
+        } else {
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        zero_count_ += other.zero_count_;
+        for (size_t i = 0; i < other.buckets_.size(); ++i) {
+            if (other.buckets_[i] > 0)
+                *bucket(other.offset_ + static_cast<int>(i)) += other.buckets_[i];
+        }
+    }
+    // Returns the value of rank quantile * (count() - 1), to within the relative
+    // accuracy.  Returns 0 if the sketch is empty.
+    double
+    quantile(double quantile) const
+    {
+        if (count_ == 0)
+            return 0.;
+        quantile = std::min(std::max(quantile, 0.), 1.);
+        const double rank = quantile * static_cast<double>(count_ - 1);
+        uint64_t cumulative = zero_count_;
+        if (rank < cumulative)
+            return std::min(max_, std::max(min_, 0.));
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            cumulative += buckets_[i];
+            if (rank < cumulative) {
+                double value = 2. * std::pow(gamma_, offset_ + static_cast<int>(i)) /
+                    (gamma_ + 1.);
+                return std::min(max_, std::max(min_, value));
+            }
+        }
+        return max_;
+    }
+    uint64_t
+    count() const
+    {
+        return count_;
+    }
+    double
+    sum() const
+    {
+        return sum_;
+    }
+    double
+    min() const
+    {
+        return min_;
+    }
+    double
+    max() const
+    {
+        return max_;
+    }
+    bool
+    empty() const
+    {
+        return count_ == 0;
+    }
+    double
+    get_relative_accuracy() const
+    {
+        return relative_accuracy_;
+    }
+    size_t
+    get_bucket_count() const
+    {
+        return buckets_.size();
+    }
+
+private:
+    int
+    bucket_key(double value) const
+    {
+        return static_cast<int>(std::ceil(std::log(value) * inverse_log_gamma_));
+    }
+    // Returns the counter for key, growing the dense bucket range to include it.
+    uint64_t *
+    bucket(int key)
+    {
+        if (buckets_.empty()) {
+            offset_ = key;
+            buckets_.resize(1, 0);
+        } else if (key < offset_) {
+            buckets_.insert(buckets_.begin(), static_cast<size_t>(offset_ - key), 0);
+            offset_ = key;
+        } else if (key - offset_ >= static_cast<int>(buckets_.size())) {
+            buckets_.resize(static_cast<size_t>(key - offset_) + 1, 0);
+        }
+        return &buckets_[static_cast<size_t>(key - offset_)];
+    }
+
+    double relative_accuracy_;
+    double gamma_;
+    double inverse_log_gamma_;
+    // buckets_[i] counts the values with key offset_ + i.
+    std::vector<uint64_t> buckets_;
+    int offset_ = 0;
+    uint64_t zero_count_ = 0;
+    uint64_t count_ = 0;
+    double sum_ = 0.;
+    double min_ = 0.;
+    double max_ = 0.;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _SKETCHES_H_ */
@@ -47,10 +47,13 @@
 
 #ifdef HAS_ZLIB
 #    include "common/gzip_ostream.h"
+#    include "common/parallel_archive_ostream.h"
 #endif
 #ifdef HAS_ZIP
 #    include "common/zipfile_ostream.h"
 #endif
+#include "common/compression_pool.h"
+#include "common/uncompressed_ostream.h"
 #include "memref.h"
 #include "memtrace_stream.h"
 #include "raw2trace_shared.h"
@@ -122,7 +125,8 @@ record_filter_tool_create(const std::string &output_dir, uint64_t stop_timestamp
                           const std::string &remove_marker_types,
                           uint64_t trim_before_timestamp, uint64_t trim_after_timestamp,
                           bool encodings2regdeps, const std::string &keep_func_ids,
-                          const std::string &modify_marker_value, unsigned int verbose)
+                          const std::string &modify_marker_value, unsigned int verbose,
+                          int output_threads)
 {
     std::vector<
         std::unique_ptr<dynamorio::drmemtrace::record_filter_t::record_filter_func_t>>
@@ -174,14 +178,14 @@ record_filter_tool_create(const std::string &output_dir, uint64_t stop_timestamp
 
     // TODO i#5675: Add other filters.
 
-    return new dynamorio::drmemtrace::record_filter_t(output_dir, std::move(filter_funcs),
-                                                      stop_timestamp, verbose);
+    return new dynamorio::drmemtrace::record_filter_t(
+        output_dir, std::move(filter_funcs), stop_timestamp, verbose, output_threads);
 }
 
 record_filter_t::record_filter_t(
     const std::string &output_dir,
     std::vector<std::unique_ptr<record_filter_func_t>> filters, uint64_t stop_timestamp,
-    unsigned int verbose)
+    unsigned int verbose, int output_threads)
     : output_dir_(output_dir)
     , filters_(std::move(filters))
     , stop_timestamp_(stop_timestamp)
@@ -189,6 +193,12 @@ record_filter_t::record_filter_t(
 {
     UNUSED(verbosity_);
     UNUSED(output_prefix_);
+#ifdef HAS_ZLIB
+    if (output_threads > 0) {
+        // Two blocks per thread keeps every thread busy while bounding memory.
+        output_pool_.reset(new compression_pool_t(output_threads, 2 * output_threads));
+    }
+#endif
 }
 
 record_filter_t::~record_filter_t()
@@ -292,12 +302,30 @@ record_filter_t::get_writer(per_shard_t *per_shard, memtrace_stream_t *shard_str
     if (per_shard->output_path.empty())
         return "Error: output_path is empty";
 #ifdef HAS_ZLIB
+    if (output_pool_) {
+        parallel_archive_format_t format = PARALLEL_ARCHIVE_UNCOMPRESSED;
+        if (ends_with(per_shard->output_path, ".gz"))
+            format = PARALLEL_ARCHIVE_GZIP;
+#    ifdef HAS_ZIP
+        else if (ends_with(per_shard->output_path, ".zip"))
+            format = PARALLEL_ARCHIVE_ZIP;
+#    endif
+        VPRINT(this, 3, "Using the parallel writer for %s\n",
+               per_shard->output_path.c_str());
+        per_shard->parallel_writer = new parallel_archive_ostream_t(
+            per_shard->output_path, format, output_pool_.get());
+        per_shard->archive_writer =
+            std::unique_ptr<archive_ostream_t>(per_shard->parallel_writer);
+        per_shard->writer = per_shard->archive_writer.get();
+        return open_new_chunk(per_shard);
+    }
     if (ends_with(per_shard->output_path, ".gz")) {
         VPRINT(this, 3, "Using the gzip writer for %s\n", per_shard->output_path.c_str());
-        per_shard->file_writer =
-            std::unique_ptr<std::ostream>(new gzip_ostream_t(per_shard->output_path));
-        per_shard->writer = per_shard->file_writer.get();
-        return "";
+        // Each chunk becomes a gzip member, listed in a chunk index file.
+        per_shard->archive_writer = std::unique_ptr<archive_ostream_t>(
+            new gzip_ostream_t(per_shard->output_path));
+        per_shard->writer = per_shard->archive_writer.get();
+        return open_new_chunk(per_shard);
     }
 #endif
 #ifdef HAS_ZIP
@@ -310,10 +338,11 @@ record_filter_t::get_writer(per_shard_t *per_shard, memtrace_stream_t *shard_str
     }
 #endif
     VPRINT(this, 3, "Using the default writer for %s\n", per_shard->output_path.c_str());
-    per_shard->file_writer = std::unique_ptr<std::ostream>(
-        new std::ofstream(per_shard->output_path, std::ofstream::binary));
-    per_shard->writer = per_shard->file_writer.get();
-    return "";
+    // Chunks are listed in a chunk index file.
+    per_shard->archive_writer = std::unique_ptr<archive_ostream_t>(
+        new uncompressed_ostream_t(per_shard->output_path));
+    per_shard->writer = per_shard->archive_writer.get();
+    return open_new_chunk(per_shard);
 }
 
 std::string
@@ -357,6 +386,9 @@ record_filter_t::open_new_chunk(per_shard_t *shard)
     err = shard->archive_writer->open_new_component(stream.str());
     if (!err.empty())
         return err;
+    // For archives which write a chunk index.
+    shard->archive_writer->set_component_start(shard->chunk_ordinal * shard->chunk_size,
+                                               shard->last_timestamp);
 
     if (shard->chunk_ordinal > 0) {
         // XXX i#6593: This sequence is currently duplicated with
@@ -452,6 +484,17 @@ record_filter_t::parallel_shard_exit(void *shard_data)
             return false;
         }
     }
+#ifdef HAS_ZLIB
+    if (per_shard->parallel_writer != nullptr) {
+        // Wait for the pool to write out this shard's queued blocks.
+        std::string error = per_shard->parallel_writer->close();
+        per_shard->parallel_writer = nullptr;
+        if (!error.empty()) {
+            per_shard->error = "Failed to write " + per_shard->output_path + ": " + error;
+            res = false;
+        }
+    }
+#endif
     // Destroy the writer since we do not need it anymore. This also makes sure
     // that data is written out to the file; curiously, a simple flush doesn't
     // do it.
@@ -54,6 +54,9 @@
 namespace dynamorio {
 namespace drmemtrace {
 
+class compression_pool_t;
+class parallel_archive_ostream_t;
+
 /**
  * Analysis tool that filters the #trace_entry_t records of an offline
  * trace. Streams through each shard independenty and parallelly, and
@@ -156,9 +159,12 @@ public:
     };
 
     // stop_timestamp sets a point beyond which no filtering will occur.
+    // A non-zero output_threads compresses and writes the output files on that
+    // many threads shared by all shards, rather than on each shard's own thread.
     record_filter_t(const std::string &output_dir,
                     std::vector<std::unique_ptr<record_filter_func_t>> filters,
-                    uint64_t stop_timestamp, unsigned int verbose);
+                    uint64_t stop_timestamp, unsigned int verbose,
+                    int output_threads = 0);
     ~record_filter_t() override;
     std::string
     initialize_stream(memtrace_stream_t *serial_stream) override;
@@ -214,6 +220,9 @@ protected:
         std::unique_ptr<archive_ostream_t> archive_writer;
         // This points to one of the writers.
         std::ostream *writer = nullptr;
+        // Set when archive_writer compresses on output_pool_, which needs an
+        // explicit close to report errors.
+        parallel_archive_ostream_t *parallel_writer = nullptr;
         std::string error;
         std::vector<void *> filter_shard_data;
         std::unordered_map<uint64_t, std::vector<trace_entry_t>> delayed_encodings;
@@ -333,6 +342,8 @@ private:
 
     std::string output_dir_;
     std::vector<std::unique_ptr<record_filter_func_t>> filters_;
+    // Shared by all shards' writers when output_threads is non-zero.
+    std::unique_ptr<compression_pool_t> output_pool_;
     uint64_t stop_timestamp_;
     unsigned int verbosity_;
     const char *output_prefix_ = "[record_filter]";
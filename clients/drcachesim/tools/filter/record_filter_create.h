@@ -71,6 +71,9 @@ namespace drmemtrace {
  *   <TRACE_MARKER_TYPE_, new_value> to modify the value of all listed TRACE_MARKER_TYPE_
  *   in the trace with their corresponding new_value.
  * @param[in] verbose  Verbosity level for notifications.
+ * @param[in] output_threads  If non-zero, the number of threads shared by all shards
+ *   which compress and write the output files, so that output compression is not
+ *   limited to one thread per shard.  If zero, each shard writes its own output.
  */
 record_analysis_tool_t *
 record_filter_tool_create(const std::string &output_dir, uint64_t stop_timestamp,
@@ -78,7 +81,8 @@ record_filter_tool_create(const std::string &output_dir, uint64_t stop_timestamp
                           const std::string &remove_marker_types,
                           uint64_t trim_before_timestamp, uint64_t trim_after_timestamp,
                           bool encodings2regdeps, const std::string &keep_func_ids,
-                          const std::string &modify_marker_value, unsigned int verbose);
+                          const std::string &modify_marker_value, unsigned int verbose,
+                          int output_threads = 0);
 
 } // namespace drmemtrace
 } // namespace dynamorio
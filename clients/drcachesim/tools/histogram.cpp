@@ -56,15 +56,19 @@ const std::string histogram_t::TOOL_NAME = "Cache line histogram tool";
 
 analysis_tool_t *
 histogram_tool_create(unsigned int line_size = 64, unsigned int report_top = 10,
-                      unsigned int verbose = 0)
+                      unsigned int verbose = 0, bool sketch_mode = false)
 {
-    return new histogram_t(line_size, report_top, verbose);
+    return new histogram_t(line_size, report_top, verbose, sketch_mode);
 }
 
 histogram_t::histogram_t(unsigned int line_size, unsigned int report_top,
-                         unsigned int verbose)
+                         unsigned int verbose, bool sketch_mode)
     : knob_line_size_(line_size)
     , knob_report_top_(report_top)
+    , knob_sketch_mode_(sketch_mode)
+    , top_capacity_(std::max<size_t>(4 * static_cast<size_t>(report_top), 64))
+    , serial_shard_(top_capacity_)
+    , reduced_(top_capacity_)
 {
     line_size_bits_ = compute_log2((int)line_size);
 }
@@ -97,7 +101,7 @@ histogram_t::parallel_worker_exit(void *worker_data)
 void *
 histogram_t::parallel_shard_init(int shard_index, void *worker_data)
 {
-    auto shard = new shard_data_t;
+    auto shard = new shard_data_t(top_capacity_);
     std::lock_guard<std::mutex> guard(shard_map_mutex_);
     shard_map_[shard_index] = shard;
     return reinterpret_cast<void *>(shard);
@@ -120,12 +124,14 @@ bool
 histogram_t::parallel_shard_memref(void *shard_data, const memref_t &memref)
 {
     shard_data_t *shard = reinterpret_cast<shard_data_t *>(shard_data);
-    std::unordered_map<addr_t, uint64_t> *cache_map = nullptr;
+    flat_hash_map_t<addr_t, uint64_t> *cache_map = nullptr;
+    line_summary_t *summary = nullptr;
     addr_t start_addr;
     size_t size;
     if (type_is_instr(memref.instr.type) ||
         memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
         cache_map = &shard->icache_map;
+        summary = &shard->icache_summary;
         start_addr = memref.instr.addr;
         size = memref.instr.size;
     } else if (memref.data.type == TRACE_TYPE_READ ||
@@ -134,6 +140,7 @@ histogram_t::parallel_shard_memref(void *shard_data, const memref_t &memref)
                // TRACE_TYPE_PREFETCH_INSTR is handled above.
                type_is_prefetch(memref.data.type)) {
         cache_map = &shard->dcache_map;
+        summary = &shard->dcache_summary;
         start_addr = memref.instr.addr;
         size = memref.instr.size;
     } else
@@ -141,7 +148,10 @@ histogram_t::parallel_shard_memref(void *shard_data, const memref_t &memref)
     for (addr_t addr = back_align(start_addr, knob_line_size_);
          addr < start_addr + size && addr < addr + knob_line_size_ /* overflow */;
          addr += knob_line_size_) {
-        ++(*cache_map)[addr >> line_size_bits_];
+        if (knob_sketch_mode_)
+            summary->add(addr >> line_size_bits_);
+        else
+            ++(*cache_map)[addr >> line_size_bits_];
     }
     return true;
 }
@@ -176,6 +186,11 @@ histogram_t::reduce_results(uint64_t *unique_icache_lines, uint64_t *unique_dcac
         reduced_ = serial_shard_;
     } else {
         for (const auto &shard : shard_map_) {
+            if (knob_sketch_mode_) {
+                reduced_.icache_summary.merge(shard.second->icache_summary);
+                reduced_.dcache_summary.merge(shard.second->dcache_summary);
+                continue;
+            }
             for (const auto &keyvals : shard.second->icache_map) {
                 reduced_.icache_map[keyvals.first] += keyvals.second;
             }
@@ -184,13 +199,42 @@ histogram_t::reduce_results(uint64_t *unique_icache_lines, uint64_t *unique_dcac
             }
         }
     }
-    if (unique_icache_lines != nullptr)
-        *unique_icache_lines = reduced_.icache_map.size();
-    if (unique_dcache_lines != nullptr)
-        *unique_dcache_lines = reduced_.dcache_map.size();
+    if (unique_icache_lines != nullptr) {
+        *unique_icache_lines = knob_sketch_mode_
+            ? reduced_.icache_summary.unique_lines.estimate()
+            : reduced_.icache_map.size();
+    }
+    if (unique_dcache_lines != nullptr) {
+        *unique_dcache_lines = knob_sketch_mode_
+            ? reduced_.dcache_summary.unique_lines.estimate()
+            : reduced_.dcache_map.size();
+    }
     return true;
 }
 
+void
+histogram_t::print_top(const char *name,
+                       const flat_hash_map_t<addr_t, uint64_t> &cache_map,
+                       const line_summary_t &summary)
+{
+    std::vector<std::pair<addr_t, uint64_t>> top;
+    if (knob_sketch_mode_) {
+        for (const auto &entry : summary.top_lines.top(knob_report_top_))
+            top.emplace_back(static_cast<addr_t>(entry.first), entry.second);
+        std::cerr << name << " top " << top.size() << " (estimated counts)\n";
+    } else {
+        top.resize(knob_report_top_);
+        std::partial_sort_copy(cache_map.begin(), cache_map.end(), top.begin(),
+                               top.end(), cmp);
+        std::cerr << name << " top " << top.size() << "\n";
+    }
+    for (std::vector<std::pair<addr_t, uint64_t>>::iterator it = top.begin();
+         it != top.end(); ++it) {
+        std::cerr << std::setw(18) << std::hex << std::showbase << (it->first << 6)
+                  << ": " << std::dec << it->second << "\n";
+    }
+}
+
 bool
 histogram_t::print_results()
 {
@@ -198,27 +242,17 @@ histogram_t::print_results()
         return false;
 
     std::cerr << TOOL_NAME << " results:\n";
-    std::cerr << "icache: " << reduced_.icache_map.size() << " unique cache lines\n";
-    std::cerr << "dcache: " << reduced_.dcache_map.size() << " unique cache lines\n";
-    std::vector<std::pair<addr_t, uint64_t>> top(knob_report_top_);
-    std::partial_sort_copy(reduced_.icache_map.begin(), reduced_.icache_map.end(),
-                           top.begin(), top.end(), cmp);
-    std::cerr << "icache top " << top.size() << "\n";
-    for (std::vector<std::pair<addr_t, uint64_t>>::iterator it = top.begin();
-         it != top.end(); ++it) {
-        std::cerr << std::setw(18) << std::hex << std::showbase << (it->first << 6)
-                  << ": " << std::dec << it->second << "\n";
-    }
-    top.clear();
-    top.resize(knob_report_top_);
-    std::partial_sort_copy(reduced_.dcache_map.begin(), reduced_.dcache_map.end(),
-                           top.begin(), top.end(), cmp);
-    std::cerr << "dcache top " << top.size() << "\n";
-    for (std::vector<std::pair<addr_t, uint64_t>>::iterator it = top.begin();
-         it != top.end(); ++it) {
-        std::cerr << std::setw(18) << std::hex << std::showbase << (it->first << 6)
-                  << ": " << std::dec << it->second << "\n";
+    if (knob_sketch_mode_) {
+        std::cerr << "icache: " << reduced_.icache_summary.unique_lines.estimate()
+                  << " unique cache lines (estimated)\n";
+        std::cerr << "dcache: " << reduced_.dcache_summary.unique_lines.estimate()
+                  << " unique cache lines (estimated)\n";
+    } else {
+        std::cerr << "icache: " << reduced_.icache_map.size() << " unique cache lines\n";
+        std::cerr << "dcache: " << reduced_.dcache_map.size() << " unique cache lines\n";
     }
+    print_top("icache", reduced_.icache_map, reduced_.icache_summary);
+    print_top("dcache", reduced_.dcache_map, reduced_.dcache_summary);
     // Reset the i/o format for subsequent tool invocations.
     std::cerr << std::dec;
     return true;
@@ -44,7 +44,9 @@
 #include <unordered_map>
 
 #include "analysis_tool.h"
+#include "flat_hash_map.h"
 #include "memref.h"
+#include "sketches.h"
 #include "trace_entry.h"
 
 namespace dynamorio {
@@ -52,7 +54,8 @@ namespace drmemtrace {
 
 class histogram_t : public analysis_tool_t {
 public:
-    histogram_t(unsigned int line_size, unsigned int report_top, unsigned int verbose);
+    histogram_t(unsigned int line_size, unsigned int report_top, unsigned int verbose,
+                bool sketch_mode = false);
     virtual ~histogram_t();
     bool
     process_memref(const memref_t &memref) override;
@@ -79,14 +82,51 @@ public:
                    uint64_t *unique_dcache_lines = nullptr);
 
 protected:
+    // The fixed-size summary of one cache that replaces its map in sketch mode.
+    struct line_summary_t {
+        explicit line_summary_t(size_t top_capacity)
+            : top_lines(top_capacity)
+        {
+        }
+        void
+        add(addr_t line)
+        {
+            unique_lines.add(line);
+            top_lines.add(line);
+        }
+        void
+        merge(const line_summary_t &other)
+        {
+            unique_lines.merge(other.unique_lines);
+            top_lines.merge(other.top_lines);
+        }
+        hyperloglog_t unique_lines;
+        heavy_hitters_t top_lines;
+    };
     struct shard_data_t {
-        std::unordered_map<addr_t, uint64_t> icache_map;
-        std::unordered_map<addr_t, uint64_t> dcache_map;
+        explicit shard_data_t(size_t top_capacity)
+            : icache_summary(top_capacity)
+            , dcache_summary(top_capacity)
+        {
+        }
+        flat_hash_map_t<addr_t, uint64_t> icache_map;
+        flat_hash_map_t<addr_t, uint64_t> dcache_map;
+        // Used instead of the maps when knob_sketch_mode_ is set.
+        line_summary_t icache_summary;
+        line_summary_t dcache_summary;
         std::string error;
     };
 
+    void
+    print_top(const char *name, const flat_hash_map_t<addr_t, uint64_t> &cache_map,
+              const line_summary_t &summary);
+
     unsigned int knob_line_size_;
     unsigned int knob_report_top_; /* most accessed lines */
+    bool knob_sketch_mode_;
+    // The candidate lines kept by each sketch, a multiple of knob_report_top_ so
+    // that lines near the cutoff are not lost to estimation error.
+    size_t top_capacity_;
     size_t line_size_bits_;
     static const std::string TOOL_NAME;
     std::unordered_map<int, shard_data_t *> shard_map_;
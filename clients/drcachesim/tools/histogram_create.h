@@ -47,12 +47,14 @@ namespace drmemtrace {
 
 /**
  * Creates an analysis tool which computes the most-referenced cache lines.
+ * If \p sketch_mode is set, the unique line counts and the top lines are
+ * estimated with fixed-size mergeable sketches rather than exact per-shard maps.
  * The options are currently documented in \ref sec_drcachesim_ops.
  */
 // These options are currently documented in ../common/options.cpp.
 analysis_tool_t *
 histogram_tool_create(unsigned int line_size = 64, unsigned int report_top = 10,
-                      unsigned int verbose = 0);
+                      unsigned int verbose = 0, bool sketch_mode = false);
 
 } // namespace drmemtrace
 } // namespace dynamorio
@@ -116,6 +116,12 @@ opcode_mix_t::~opcode_mix_t()
     }
 }
 
+bool
+opcode_mix_t::data_addresses_needed()
+{
+    return false;
+}
+
 bool
 opcode_mix_t::parallel_shard_supported()
 {
@@ -45,6 +45,7 @@
 #include "dr_api.h" // Must be before trace_entry.h from analysis_tool.h.
 #include "analysis_tool.h"
 #include "decode_cache.h"
+#include "flat_hash_map.h"
 #include "memref.h"
 #include "raw2trace.h"
 #include "trace_entry.h"
@@ -68,6 +69,8 @@ public:
     bool
     print_results() override;
     bool
+    data_addresses_needed() override;
+    bool
     parallel_shard_supported() override;
     void *
     parallel_shard_init_stream(
@@ -136,8 +139,8 @@ protected:
     public:
         // Snapshot the counts as cumulative stats, and then converted them to deltas in
         // finalize_interval_snapshots().  Printed interval results are all deltas.
-        std::unordered_map<int, int64_t> opcode_counts_;
-        std::unordered_map<uint, int64_t> category_counts_;
+        flat_hash_map_t<int, int64_t> opcode_counts_;
+        flat_hash_map_t<uint, int64_t> category_counts_;
     };
 
     struct shard_data_t {
@@ -146,8 +149,8 @@ protected:
         }
 
         int64_t instr_count = 0;
-        std::unordered_map<int, int64_t> opcode_counts;
-        std::unordered_map<uint, int64_t> category_counts;
+        flat_hash_map_t<int, int64_t> opcode_counts;
+        flat_hash_map_t<uint, int64_t> category_counts;
         std::string error;
         dynamorio::drmemtrace::memtrace_stream_t *stream = nullptr;
         std::unique_ptr<decode_cache_t<opcode_data_t>> decode_cache;
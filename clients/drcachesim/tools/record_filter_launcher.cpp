@@ -148,6 +148,16 @@ droption_t<std::string> op_modify_marker_value(
     "sets all TRACE_MARKER_TYPE_CPU_ID == 3 in the trace to core 24 and "
     "TRACE_MARKER_TYPE_PAGE_SIZE == 18 to 2k.");
 
+droption_t<int> op_filter_output_threads(
+    DROPTION_SCOPE_FRONTEND, "filter_output_threads", 0,
+    "Threads for compressing and writing record_filter output.",
+    "This option is for -tool record_filter. When non-zero, the filtered "
+    "records of every shard are handed in blocks to a pool of this many threads which "
+    "compress them in parallel, and the blocks are then assembled into each output "
+    "file in order.  This keeps output compression from limiting each shard to one "
+    "thread's deflate speed.  The output format is unchanged.  When 0, each shard "
+    "compresses and writes its own output.  Requires zlib support.");
+
 } // namespace
 
 int
@@ -179,7 +189,7 @@ _tmain(int argc, const TCHAR *targv[])
             op_remove_marker_types.get_value(), op_trim_before_timestamp.get_value(),
             op_trim_after_timestamp.get_value(), op_encodings2regdeps.get_value(),
             op_filter_func_ids.get_value(), op_modify_marker_value.get_value(),
-            op_verbose.get_value()));
+            op_verbose.get_value(), op_filter_output_threads.get_value()));
     std::vector<record_analysis_tool_t *> tools;
     tools.push_back(record_filter.get());
 
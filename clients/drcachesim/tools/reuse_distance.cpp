@@ -72,6 +72,10 @@ reuse_distance_t::reuse_distance_t(const reuse_distance_knobs_t &knobs)
     , line_size_bits_(compute_log2((int)knobs_.line_size))
 {
     reuse_distance_t::knob_verbose = knobs.verbose;
+    if (knobs_.sample_rate > 0.0 && knobs_.sample_rate < 1.0) {
+        sample_threshold_ = static_cast<uint64_t>(
+            std::ceil(knobs_.sample_rate * (1ULL << SAMPLE_HASH_BITS)));
+    }
     IF_DEBUG_VERBOSE(2,
                      std::cerr << "cache line size " << knobs_.line_size << ", "
                                << "reuse distance threshold " << knobs_.distance_threshold
@@ -100,11 +104,23 @@ reuse_distance_t::initialize_shard_type(shard_type_t shard_type)
 }
 
 reuse_distance_t::shard_data_t::shard_data_t(uint64_t reuse_threshold, uint64_t skip_dist,
-                                             uint32_t distance_limit, bool verify)
+                                             uint32_t distance_limit, bool verify,
+                                             bool use_tree)
     : distance_limit(distance_limit)
 {
     ref_list = std::unique_ptr<line_ref_list_t>(
-        new line_ref_list_t(reuse_threshold, skip_dist, verify));
+        new line_ref_list_t(reuse_threshold, skip_dist, verify, use_tree));
+}
+
+reuse_distance_t::shard_data_t *
+reuse_distance_t::create_shard_data() const
+{
+    // The list only holds sampled lines, so its distances are scaled down.
+    uint64_t threshold = knobs_.distance_threshold;
+    if (sample_threshold_ > 0)
+        threshold = static_cast<uint64_t>(threshold * knobs_.sample_rate);
+    return new shard_data_t(threshold, knobs_.skip_list_distance, knobs_.distance_limit,
+                            knobs_.verify_skip, knobs_.use_tree);
 }
 
 bool
@@ -117,8 +133,7 @@ void *
 reuse_distance_t::parallel_shard_init_stream(int shard_index, void *worker_data,
                                              memtrace_stream_t *stream)
 {
-    auto shard = new shard_data_t(knobs_.distance_threshold, knobs_.skip_list_distance,
-                                  knobs_.distance_limit, knobs_.verify_skip);
+    auto shard = create_shard_data();
     std::lock_guard<std::mutex> guard(shard_map_mutex_);
     shard->core = stream->get_output_cpuid();
     shard->tid = stream->get_tid();
@@ -166,8 +181,9 @@ reuse_distance_t::parallel_shard_memref(void *shard_data, const memref_t &memref
             ++shard->data_refs;
         }
         addr_t tag = memref.data.addr >> line_size_bits_;
-        std::unordered_map<addr_t, line_ref_t *>::iterator it =
-            shard->cache_map.find(tag);
+        if (sample_threshold_ > 0 && !is_sampled(tag))
+            return true;
+        flat_hash_map_t<addr_t, line_ref_t *>::iterator it = shard->cache_map.find(tag);
         if (it == shard->cache_map.end()) {
             line_ref_t *ref = new line_ref_t(tag);
             // insert into the map
@@ -196,6 +212,8 @@ reuse_distance_t::parallel_shard_memref(void *shard_data, const memref_t &memref
             }
         } else {
             int64_t dist = shard->ref_list->move_to_front(it->second);
+            if (sample_threshold_ > 0)
+                dist = static_cast<int64_t>(dist / knobs_.sample_rate);
             auto &dist_map = is_instr_type ? shard->dist_map : shard->dist_map_data;
             distance_histogram_t::iterator dist_it = dist_map.find(dist);
             if (dist_it == dist_map.end())
@@ -215,8 +233,7 @@ reuse_distance_t::process_memref(const memref_t &memref)
     int shard_index = serial_stream_->get_shard_index();
     const auto &lookup = shard_map_.find(shard_index);
     if (lookup == shard_map_.end()) {
-        shard = new shard_data_t(knobs_.distance_threshold, knobs_.skip_list_distance,
-                                 knobs_.distance_limit, knobs_.verify_skip);
+        shard = create_shard_data();
         shard->core = serial_stream_->get_output_cpuid();
         shard->tid = serial_stream_->get_tid();
         shard_map_[shard_index] = shard;
@@ -276,6 +293,11 @@ reuse_distance_t::print_shard_results(const shard_data_t *shard)
         return;
     std::cerr << "Instruction accesses: " << shard->total_refs - shard->data_refs << "\n";
     std::cerr << "Data accesses: " << shard->data_refs << "\n";
+    if (sample_threshold_ > 0) {
+        std::cerr << "Sampled cache line rate: " << knobs_.sample_rate
+                  << " (the statistics below only cover sampled lines, with scaled "
+                     "distances)\n";
+    }
     std::cerr << "Unique accesses: " << shard->ref_list->cur_time_ << "\n";
     std::cerr << "Unique cache lines accessed: "
               << shard->cache_map.size() + shard->pruned_addresses.size() << "\n";
@@ -451,9 +473,7 @@ reuse_distance_t::get_aggregated_results()
         return aggregated_results_.get();
 
     // Otherwise, aggregate the per-shard data to get whole-trace data.
-    aggregated_results_ = std::unique_ptr<shard_data_t>(
-        new shard_data_t(knobs_.distance_threshold, knobs_.skip_list_distance,
-                         knobs_.distance_limit, knobs_.verify_skip));
+    aggregated_results_ = std::unique_ptr<shard_data_t>(create_shard_data());
     for (auto &shard : shard_map_) {
         aggregated_results_->total_refs += shard.second->total_refs;
         aggregated_results_->data_refs += shard.second->data_refs;
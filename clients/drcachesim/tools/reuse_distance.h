@@ -50,6 +50,7 @@
 #include <vector>
 
 #include "analysis_tool.h"
+#include "flat_hash_map.h"
 #include "memref.h"
 #include "reuse_distance_create.h"
 #include "trace_entry.h"
@@ -104,7 +105,7 @@ public:
     // different verbosities.
     static unsigned int knob_verbose;
 
-    using distance_histogram_t = std::unordered_map<int64_t, int64_t>;
+    using distance_histogram_t = flat_hash_map_t<int64_t, int64_t>;
     using distance_map_pair_t = std::pair<int64_t, int64_t>;
 
 protected:
@@ -115,8 +116,8 @@ protected:
     // for computing over different units if for some reason that was desired.
     struct shard_data_t {
         shard_data_t(uint64_t reuse_threshold, uint64_t skip_dist,
-                     unsigned int distance_limit, bool verify);
-        std::unordered_map<addr_t, line_ref_t *> cache_map;
+                     unsigned int distance_limit, bool verify, bool use_tree);
+        flat_hash_map_t<addr_t, line_ref_t *> cache_map;
         std::unordered_set<addr_t> pruned_addresses;
         // These are our reuse distance histograms: one for all accesses and one
         // only for data references.  An instruction histogram can be computed by
@@ -153,6 +154,20 @@ protected:
     void
     print_shard_results(const shard_data_t *shard);
 
+    shard_data_t *
+    create_shard_data() const;
+
+    // With -reuse_sample_rate, whether accesses to the line with this tag are
+    // tracked.  As in SHARDS, a line is sampled when a hash of its tag falls below
+    // a threshold, so every access to a sampled line is tracked and the reuse
+    // distances among the sampled lines scale by the rate.
+    bool
+    is_sampled(addr_t tag) const
+    {
+        return ((tag * 0x9e3779b97f4a7c15ULL) >> (64 - SAMPLE_HASH_BITS)) <
+            sample_threshold_;
+    }
+
     // Return a pointer to aggregate results, building them if needed.
     virtual const shard_data_t *
     get_aggregated_results();
@@ -160,6 +175,10 @@ protected:
 
     const reuse_distance_knobs_t knobs_;
     const size_t line_size_bits_;
+    static constexpr int SAMPLE_HASH_BITS = 24;
+    // The sampled fraction of the 2^SAMPLE_HASH_BITS hash values, or 0 when every
+    // line is tracked.
+    uint64_t sample_threshold_ = 0;
     static const std::string TOOL_NAME;
     std::unordered_map<int, shard_data_t *> shard_map_;
     // This mutex is only needed in parallel_shard_init.  In all other accesses to
@@ -184,6 +203,10 @@ struct line_ref_t {
     struct line_ref_t *next_skip; // the next line_ref in the skip list
     int64_t depth;                // only valid for skip list nodes; -1 for others
 
+    // The position of the most recent reference in the order-statistic tree, when
+    // that is used instead of the skip list.
+    uint64_t tree_pos;
+
     line_ref_t(addr_t val)
         : prev(NULL)
         , next(NULL)
@@ -193,6 +216,7 @@ struct line_ref_t {
         , prev_skip(NULL)
         , next_skip(NULL)
         , depth(-1)
+        , tree_pos(0)
     {
     }
 };
@@ -212,6 +236,13 @@ struct line_ref_t {
 // We have a second doubly-linked list, a one-layer skip list, for
 // more efficient computation of the depth.  Each node in the skip
 // list stores its depth from the front.
+//
+// The skip list still costs time linear in the distance.  Alternatively, an
+// order-statistic tree computes the depth in logarithmic time: each reference
+// takes the next position in a Fenwick tree, which holds a 1 at the position of
+// each line's most recent reference, and the depth of a line is the number of
+// 1s after its position.  Positions are renumbered once they run out, which
+// keeps the tree proportional to the number of lines.
 struct line_ref_list_t {
     line_ref_t *head_;       // the most recently accessed cache line
     line_ref_t *gate_;       // the earliest cache line refs within the threshold
@@ -221,8 +252,14 @@ struct line_ref_list_t {
     uint64_t threshold_;     // the reuse distance threshold
     uint64_t skip_distance_; // distance between skip list nodes
     bool verify_skip_;       // check results using brute-force walks
-
-    line_ref_list_t(uint64_t reuse_threshold_, uint64_t skip_dist, bool verify)
+    bool use_tree_;          // use the order-statistic tree instead of the skip list
+    // The Fenwick tree, indexed from 1.
+    std::vector<int64_t> tree_;
+    uint64_t tree_next_pos_; // the next position to assign
+    int64_t tree_lines_;     // the number of lines in the tree
+
+    line_ref_list_t(uint64_t reuse_threshold_, uint64_t skip_dist, bool verify,
+                    bool use_tree = false)
         : head_(NULL)
         , gate_(NULL)
         , tail_(NULL)
@@ -231,7 +268,12 @@ struct line_ref_list_t {
         , threshold_(reuse_threshold_)
         , skip_distance_(skip_dist)
         , verify_skip_(verify)
+        , use_tree_(use_tree)
+        , tree_next_pos_(0)
+        , tree_lines_(0)
     {
+        if (use_tree_)
+            tree_.resize(TREE_MIN_POSITIONS + 1);
     }
 
     virtual ~line_ref_list_t()
@@ -272,6 +314,67 @@ struct line_ref_list_t {
         }
     }
 
+    static constexpr uint64_t TREE_MIN_POSITIONS = 1024;
+
+    void
+    tree_add(uint64_t pos, int64_t delta)
+    {
+        for (uint64_t i = pos + 1; i < tree_.size(); i += i & (~i + 1))
+            tree_[i] += delta;
+    }
+
+    // Returns the number of lines at positions up to and including pos.
+    int64_t
+    tree_prefix_sum(uint64_t pos) const
+    {
+        int64_t sum = 0;
+        for (uint64_t i = pos + 1; i > 0; i -= i & (~i + 1))
+            sum += tree_[i];
+        return sum;
+    }
+
+    // Gives ref the next position.  ref must not be in the tree.
+    void
+    tree_insert(line_ref_t *ref)
+    {
+        ref->tree_pos = tree_next_pos_++;
+        tree_add(ref->tree_pos, 1);
+        ++tree_lines_;
+    }
+
+    void
+    tree_remove(line_ref_t *ref)
+    {
+        tree_add(ref->tree_pos, -1);
+        --tree_lines_;
+    }
+
+    // Renumbers the lines from 0 in list order if the positions have run out.
+    // Must be called while the list and the tree agree.
+    void
+    maybe_compact_tree()
+    {
+        if (tree_next_pos_ < tree_.size() - 1)
+            return;
+        uint64_t capacity = 2 * (uint64_t)tree_lines_;
+        if (capacity < TREE_MIN_POSITIONS)
+            capacity = TREE_MIN_POSITIONS;
+        tree_.assign(capacity + 1, 0);
+        uint64_t pos = 0;
+        for (line_ref_t *node = tail_; node != NULL; node = node->prev)
+            node->tree_pos = pos++;
+        assert(pos == (uint64_t)tree_lines_);
+        tree_next_pos_ = pos;
+        // Build the tree in linear time by pushing each partial sum to its parent.
+        for (uint64_t i = 1; i < tree_.size(); ++i) {
+            if (i <= pos)
+                ++tree_[i];
+            uint64_t parent = i + (i & (~i + 1));
+            if (parent < tree_.size())
+                tree_[parent] += tree_[i];
+        }
+    }
+
     void
     move_skip_fields(line_ref_t *src, line_ref_t *dst)
     {
@@ -295,6 +398,8 @@ struct line_ref_list_t {
     add_to_front(line_ref_t *ref)
     {
         IF_DEBUG_VERBOSE(3, std::cerr << "Add tag 0x" << std::hex << ref->tag << "\n");
+        if (use_tree_)
+            maybe_compact_tree();
         // update head_
         ref->next = head_;
         if (head_ != NULL)
@@ -309,6 +414,10 @@ struct line_ref_list_t {
             tail_ = ref;
         unique_lines_++;
         head_->time_stamp = cur_time_++;
+        if (use_tree_) {
+            tree_insert(ref);
+            return;
+        }
 
         // Add a new skip node if necessary.
         // We don't bother keeping one right at the front: too much overhead_.
@@ -353,6 +462,8 @@ struct line_ref_list_t {
 
         line_ref_t *new_tail = tail_->prev;
         new_tail->next = NULL;
+        if (use_tree_)
+            tree_remove(tail_);
 
         // If there's a prior skip, remove its ptr to tail.
         if (tail_->depth != -1 && tail_->prev_skip != NULL) {
@@ -383,6 +494,8 @@ struct line_ref_list_t {
         ref->total_refs++;
         if (ref == head_)
             return 0;
+        if (use_tree_)
+            maybe_compact_tree();
         if (ref_is_distant(ref)) {
             ref->distant_refs++;
             gate_ = gate_->prev;
@@ -396,13 +509,18 @@ struct line_ref_list_t {
 
         // Compute reuse distance.
         int64_t dist = 0;
-        line_ref_t *skip;
-        for (skip = ref; skip != NULL && skip->depth == -1; skip = skip->prev)
-            ++dist;
-        if (skip != NULL)
-            dist += skip->depth;
-        else
-            --dist; // Don't count self.
+        line_ref_t *skip = NULL;
+        if (use_tree_) {
+            // Every line with a later position is closer to the front.
+            dist = tree_lines_ - tree_prefix_sum(ref->tree_pos);
+        } else {
+            for (skip = ref; skip != NULL && skip->depth == -1; skip = skip->prev)
+                ++dist;
+            if (skip != NULL)
+                dist += skip->depth;
+            else
+                --dist; // Don't count self.
+        }
 
         IF_DEBUG_VERBOSE(
             0, if (verify_skip_) {
@@ -414,7 +532,8 @@ struct line_ref_list_t {
                     ++brute_dist;
                 if (brute_dist != dist) {
                     std::cerr << "Mismatch!  Brute=" << std::dec << brute_dist
-                              << " vs skip=" << dist << "\n";
+                              << " vs " << (use_tree_ ? "tree=" : "skip=") << dist
+                              << "\n";
                     print_list();
                     assert(false);
                 }
@@ -430,6 +549,10 @@ struct line_ref_list_t {
             }
         } else
             assert(ref->depth == -1);
+        if (use_tree_) {
+            tree_remove(ref);
+            tree_insert(ref);
+        }
 
         // remove ref from the list
         prev = ref->prev;
@@ -61,6 +61,8 @@ struct reuse_distance_knobs_t {
         , verify_skip(false)
         , verbose(0)
         , histogram_bin_multiplier(1.00)
+        , use_tree(false)
+        , sample_rate(1.0)
     {
     }
     unsigned int line_size;
@@ -72,6 +74,8 @@ struct reuse_distance_knobs_t {
     bool verify_skip;
     unsigned int verbose;
     double histogram_bin_multiplier;
+    bool use_tree;
+    double sample_rate;
 };
 
 /** Creates an analysis tool which computes reuse distance. */
@@ -35,6 +35,7 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -61,15 +62,17 @@ namespace drmemtrace {
 const std::string reuse_time_t::TOOL_NAME = "Reuse time tool";
 
 analysis_tool_t *
-reuse_time_tool_create(unsigned int line_size, unsigned int verbose)
+reuse_time_tool_create(unsigned int line_size, unsigned int verbose, bool sketch_mode)
 {
-    return new reuse_time_t(line_size, verbose);
+    return new reuse_time_t(line_size, verbose, sketch_mode);
 }
 
-reuse_time_t::reuse_time_t(unsigned int line_size, unsigned int verbose)
+reuse_time_t::reuse_time_t(unsigned int line_size, unsigned int verbose,
+                           bool sketch_mode)
     : knob_verbose_(verbose)
     , knob_line_size_(line_size)
     , line_size_bits_(compute_log2((int)knob_line_size_))
+    , knob_sketch_mode_(sketch_mode)
 {
 }
 
@@ -157,14 +160,18 @@ reuse_time_t::parallel_shard_memref(void *shard_data, const memref_t &memref)
 
     shard->time_stamp++;
     addr_t line = memref.data.addr >> line_size_bits_;
-    if (shard->time_map.count(line) > 0) {
-        int64_t reuse_time = shard->time_stamp - shard->time_map[line];
+    auto prior = shard->time_map.try_emplace(line, shard->time_stamp);
+    if (!prior.second) {
+        int64_t reuse_time = shard->time_stamp - prior.first->second;
         if (DEBUG_VERBOSE(3)) {
             std::cerr << "Reuse " << reuse_time << std::endl;
         }
-        shard->reuse_time_histogram[reuse_time]++;
+        if (knob_sketch_mode_)
+            shard->reuse_time_sketch.add(static_cast<double>(reuse_time));
+        else
+            shard->reuse_time_histogram[reuse_time]++;
+        prior.first->second = shard->time_stamp;
     }
-    shard->time_map[line] = shard->time_stamp;
     return true;
 }
 
@@ -201,6 +208,10 @@ reuse_time_t::print_shard_results(const shard_data_t *shard)
     std::cerr << "Total instructions: " << shard->total_instructions << "\n";
     std::cerr.precision(2);
     std::cerr.setf(std::ios::fixed);
+    if (knob_sketch_mode_) {
+        print_shard_quantiles(shard);
+        return;
+    }
 
     int64_t count = 0;
     int64_t sum = 0;
@@ -237,6 +248,26 @@ reuse_time_t::print_shard_results(const shard_data_t *shard)
     }
 }
 
+void
+reuse_time_t::print_shard_quantiles(const shard_data_t *shard)
+{
+    const ddsketch_t &sketch = shard->reuse_time_sketch;
+    std::cerr << "Mean reuse time: " << sketch.sum() / static_cast<double>(sketch.count())
+              << "\n";
+    std::cerr << "Reuse time quantiles (within "
+              << sketch.get_relative_accuracy() * 100.0 << "% relative error):\n";
+    std::cerr << std::setw(9) << "Quantile" << std::setw(12) << "Distance";
+    std::cerr << std::endl;
+    if (sketch.empty())
+        return;
+    static const double quantiles[] = { 0.5, 0.75, 0.9, 0.95, 0.99, 0.999, 1.0 };
+    for (double quantile : quantiles) {
+        std::cerr << std::setw(8) << quantile * 100.0 << "%" << std::setw(12)
+                  << static_cast<int64_t>(std::round(sketch.quantile(quantile)));
+        std::cerr << std::endl;
+    }
+}
+
 bool
 reuse_time_t::print_results()
 {
@@ -247,6 +278,7 @@ reuse_time_t::print_results()
         // We simply sum the accesses.
         aggregate->time_stamp += shard.second->time_stamp;
         // Merge the histograms.
+        aggregate->reuse_time_sketch.merge(shard.second->reuse_time_sketch);
         for (const auto &entry : shard.second->reuse_time_histogram) {
             aggregate->reuse_time_histogram[entry.first] += entry.second;
         }
@@ -40,7 +40,9 @@
 #include <unordered_map>
 
 #include "analysis_tool.h"
+#include "flat_hash_map.h"
 #include "memref.h"
+#include "sketches.h"
 #include "trace_entry.h"
 
 namespace dynamorio {
@@ -48,7 +50,7 @@ namespace drmemtrace {
 
 class reuse_time_t : public analysis_tool_t {
 public:
-    reuse_time_t(unsigned int line_size, unsigned int verbose);
+    reuse_time_t(unsigned int line_size, unsigned int verbose, bool sketch_mode = false);
     ~reuse_time_t() override;
     std::string
     initialize_stream(memtrace_stream_t *serial_stream) override;
@@ -74,10 +76,12 @@ protected:
     // Just like for reuse_distance_t, we assume that the shard unit is the unit over
     // which we should measure time.  By default this is a traced thread.
     struct shard_data_t {
-        std::unordered_map<addr_t, int64_t> time_map;
+        flat_hash_map_t<addr_t, int64_t> time_map;
         int64_t time_stamp = 0;
         int64_t total_instructions = 0;
-        std::unordered_map<int64_t, int64_t> reuse_time_histogram;
+        flat_hash_map_t<int64_t, int64_t> reuse_time_histogram;
+        // Used instead of reuse_time_histogram when knob_sketch_mode_ is set.
+        ddsketch_t reuse_time_sketch;
         memref_tid_t tid = 0; // For SHARD_BY_THREAD.
         int64_t core = 0;     // For SHARD_BY_CORE.
         std::string error;
@@ -85,10 +89,13 @@ protected:
 
     void
     print_shard_results(const shard_data_t *shard);
+    void
+    print_shard_quantiles(const shard_data_t *shard);
 
     const unsigned int knob_verbose_;
     const unsigned int knob_line_size_;
     const unsigned int line_size_bits_;
+    const bool knob_sketch_mode_;
 
     static const std::string TOOL_NAME;
 
@@ -48,12 +48,15 @@ namespace drmemtrace {
 
 /**
  * Creates an analysis tool which computes reuse time (i.e., reuse
- * distance without regard to uniqueness).  The options are currently
- * documented in \ref sec_drcachesim_ops.
+ * distance without regard to uniqueness).  If \p sketch_mode is set, reuse
+ * time quantiles are reported from a fixed-size mergeable sketch rather than
+ * an exact histogram.  The options are currently documented in
+ * \ref sec_drcachesim_ops.
  */
 // These options are currently documented in ../common/options.cpp.
 analysis_tool_t *
-reuse_time_tool_create(unsigned int line_size = 64, unsigned int verbose = 0);
+reuse_time_tool_create(unsigned int line_size = 64, unsigned int verbose = 0,
+                       bool sketch_mode = false);
 
 } // namespace drmemtrace
 } // namespace dynamorio
@@ -160,6 +160,12 @@ schedule_stats_t::get_scheduler_stats(memtrace_stream_t *stream, counters_t &cou
         stream->get_schedule_statistic(memtrace_stream_t::SCHED_STAT_QUANTUM_PREEMPTS));
     counters.migrations = static_cast<int64_t>(
         stream->get_schedule_statistic(memtrace_stream_t::SCHED_STAT_MIGRATIONS));
+    counters.cross_core_migrations = static_cast<int64_t>(stream->get_schedule_statistic(
+        memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_CORE));
+    counters.cross_llc_migrations = static_cast<int64_t>(stream->get_schedule_statistic(
+        memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_LLC));
+    counters.cross_node_migrations = static_cast<int64_t>(stream->get_schedule_statistic(
+        memtrace_stream_t::SCHED_STAT_MIGRATIONS_CROSS_NODE));
     counters.steals = static_cast<int64_t>(
         stream->get_schedule_statistic(memtrace_stream_t::SCHED_STAT_RUNQUEUE_STEALS));
     counters.rebalances = static_cast<int64_t>(stream->get_schedule_statistic(
@@ -522,6 +528,12 @@ schedule_stats_t::print_counters(const counters_t &counters)
     std::cerr << std::setw(12) << counters.switches_nop << " switches nop-ed\n";
     std::cerr << std::setw(12) << counters.quantum_preempts << " quantum_preempts\n";
     std::cerr << std::setw(12) << counters.migrations << " migrations\n";
+    std::cerr << std::setw(12) << counters.cross_core_migrations
+              << " cross-core migrations\n";
+    std::cerr << std::setw(12) << counters.cross_llc_migrations
+              << " cross-LLC migrations\n";
+    std::cerr << std::setw(12) << counters.cross_node_migrations
+              << " cross-node migrations\n";
     std::cerr << std::setw(12) << counters.steals << " work steals\n";
     std::cerr << std::setw(12) << counters.rebalances << " rebalances\n";
     std::cerr << std::setw(12) << counters.at_output_limit << " output limits hit\n";
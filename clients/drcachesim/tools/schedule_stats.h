@@ -206,6 +206,9 @@ public:
             switches_nop += rhs.switches_nop;
             quantum_preempts += rhs.quantum_preempts;
             migrations += rhs.migrations;
+            cross_core_migrations += rhs.cross_core_migrations;
+            cross_llc_migrations += rhs.cross_llc_migrations;
+            cross_node_migrations += rhs.cross_node_migrations;
             steals += rhs.steals;
             rebalances += rhs.rebalances;
             at_output_limit += rhs.at_output_limit;
@@ -254,6 +257,10 @@ public:
         int64_t switches_nop = 0;
         int64_t quantum_preempts = 0;
         int64_t migrations = 0;
+        // Observed by the scheduler across its output topology's domains.
+        int64_t cross_core_migrations = 0;
+        int64_t cross_llc_migrations = 0;
+        int64_t cross_node_migrations = 0;
         int64_t steals = 0;
         int64_t rebalances = 0;
         int64_t at_output_limit = 0;
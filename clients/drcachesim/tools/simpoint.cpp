@@ -0,0 +1,461 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "simpoint.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "analysis_tool.h"
+#include "memref.h"
+#include "simpoint_create.h"
+#include "trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+const std::string simpoint_t::TOOL_NAME = "SimPoint tool";
+
+namespace {
+
+// A fixed seed keeps the selected intervals stable across runs.
+constexpr uint64_t RANDOM_SEED = 0x5eed5eed5eedULL;
+// The SimPoint convention: pick the smallest k whose BIC score is within this
+// fraction of the best score's distance from the worst.
+constexpr double BIC_THRESHOLD = 0.9;
+constexpr int MAX_KMEANS_ITERATIONS = 100;
+constexpr double PI = 3.14159265358979323846;
+
+uint64_t
+mix64(uint64_t x)
+{
+    // The splitmix64 finalizer.
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Maps the top 53 bits of a random value to [0,1).
+double
+unit_fraction(uint64_t random)
+{
+    return static_cast<double>(random >> 11) / static_cast<double>(1ULL << 53);
+}
+
+double
+squared_distance(const std::vector<double> &a, const std::vector<double> &b)
+{
+    double sum = 0.;
+    for (size_t i = 0; i < a.size(); ++i) {
+        double diff = a[i] - b[i];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+} // namespace
+
+analysis_tool_t *
+simpoint_tool_create(unsigned int max_k, unsigned int dimensions,
+                     const std::string &output_file, unsigned int verbose)
+{
+    return new simpoint_t(max_k, dimensions, output_file, verbose);
+}
+
+simpoint_t::simpoint_t(unsigned int max_k, unsigned int dimensions,
+                       const std::string &output_file, unsigned int verbose)
+    : knob_max_k_(max_k == 0 ? 1 : max_k)
+    , knob_dimensions_(dimensions == 0 ? 1 : dimensions)
+    , knob_output_file_(output_file)
+    , knob_verbose_(verbose)
+{
+}
+
+bool
+simpoint_t::parallel_shard_supported()
+{
+    return false;
+}
+
+bool
+simpoint_t::process_memref(const memref_t &memref)
+{
+    if (!type_is_instr(memref.instr.type))
+        return true;
+    // Threads are interleaved in serial mode, so block boundaries are tracked
+    // per thread.  A new block starts after any branch and at any discontinuity,
+    // such as a return from the kernel or a signal handler.
+    block_state_t &state = block_state_[memref.instr.tid];
+    if (state.prev_was_branch || memref.instr.addr != state.next_pc)
+        state.block_start = memref.instr.addr;
+    state.next_pc = memref.instr.addr + memref.instr.size;
+    state.prev_was_branch = type_is_instr_branch(memref.instr.type);
+    // Counting every instruction against its block weights each block by its
+    // length, as SimPoint does.
+    ++cur_bbv_[state.block_start];
+    ++total_instrs_;
+    return true;
+}
+
+analysis_tool_t::interval_state_snapshot_t *
+simpoint_t::generate_interval_snapshot(uint64_t interval_id)
+{
+    bbv_snapshot_t *snapshot = new bbv_snapshot_t;
+    snapshot->bbv.block_instrs.swap(cur_bbv_);
+    cur_bbv_.clear();
+    return snapshot;
+}
+
+simpoint_t::point_t
+simpoint_t::project(const bbv_t &bbv) const
+{
+    // Random projection onto a few dimensions keeps clustering cheap regardless of
+    // the number of distinct blocks.  The projection matrix is never materialized:
+    // each entry is a hash of the block and the dimension, uniform in [-1,1].
+    point_t point(knob_dimensions_, 0.);
+    if (bbv.instr_count == 0)
+        return point;
+    for (const auto &entry : bbv.block_instrs) {
+        double frequency =
+            static_cast<double>(entry.second) / static_cast<double>(bbv.instr_count);
+        uint64_t block_hash = mix64(entry.first ^ RANDOM_SEED);
+        for (unsigned int dim = 0; dim < knob_dimensions_; ++dim) {
+            uint64_t hash = mix64(block_hash + dim);
+            double value = unit_fraction(hash) * 2. - 1.;
+            point[dim] += frequency * value;
+        }
+    }
+    return point;
+}
+
+double
+simpoint_t::kmeans(const std::vector<point_t> &points, int k,
+                   std::vector<point_t> &centers, std::vector<int> &assignment) const
+{
+    std::mt19937_64 rng(RANDOM_SEED + k);
+    // k-means++ seeding: each new center is chosen with probability proportional
+    // to its squared distance from the nearest existing center.
+    centers.clear();
+    centers.push_back(points[rng() % points.size()]);
+    std::vector<double> nearest(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+        nearest[i] = squared_distance(points[i], centers[0]);
+    while (static_cast<int>(centers.size()) < k) {
+        double total = 0.;
+        for (double dist : nearest)
+            total += dist;
+        size_t chosen = points.size() - 1;
+        if (total > 0.) {
+            double target = unit_fraction(rng()) * total;
+            for (size_t i = 0; i < points.size(); ++i) {
+                if (nearest[i] <= 0.)
+                    continue;
+                chosen = i;
+                target -= nearest[i];
+                if (target <= 0.)
+                    break;
+            }
+        } else {
+            // Every point coincides with a center; extra centers stay empty.
+            chosen = rng() % points.size();
+        }
+        centers.push_back(points[chosen]);
+        for (size_t i = 0; i < points.size(); ++i) {
+            nearest[i] =
+                std::min(nearest[i], squared_distance(points[i], centers.back()));
+        }
+    }
+    // Lloyd iterations.
+    assignment.assign(points.size(), -1);
+    double distortion = 0.;
+    for (int iter = 0; iter < MAX_KMEANS_ITERATIONS; ++iter) {
+        bool changed = false;
+        distortion = 0.;
+        for (size_t i = 0; i < points.size(); ++i) {
+            int best = 0;
+            double best_dist = std::numeric_limits<double>::max();
+            for (int c = 0; c < k; ++c) {
+                double dist = squared_distance(points[i], centers[c]);
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best = c;
+                }
+            }
+            if (assignment[i] != best) {
+                assignment[i] = best;
+                changed = true;
+            }
+            distortion += best_dist;
+        }
+        if (!changed)
+            break;
+        std::vector<point_t> sums(k, point_t(knob_dimensions_, 0.));
+        std::vector<uint64_t> sizes(k, 0);
+        for (size_t i = 0; i < points.size(); ++i) {
+            ++sizes[assignment[i]];
+            for (unsigned int dim = 0; dim < knob_dimensions_; ++dim)
+                sums[assignment[i]][dim] += points[i][dim];
+        }
+        for (int c = 0; c < k; ++c) {
+            // An empty cluster keeps its previous center.
+            if (sizes[c] == 0)
+                continue;
+            for (unsigned int dim = 0; dim < knob_dimensions_; ++dim)
+                centers[c][dim] = sums[c][dim] / static_cast<double>(sizes[c]);
+        }
+    }
+    return distortion;
+}
+
+double
+simpoint_t::bic_score(const std::vector<point_t> &points,
+                      const std::vector<point_t> &centers,
+                      const std::vector<int> &assignment, double distortion) const
+{
+    // The spherical Gaussian formulation from Pelleg and Moore's X-means, which
+    // is what SimPoint uses.
+    const double num_points = static_cast<double>(points.size());
+    const double dims = static_cast<double>(knob_dimensions_);
+    std::vector<uint64_t> sizes(centers.size(), 0);
+    for (int cluster : assignment)
+        ++sizes[cluster];
+    double num_clusters = 0.;
+    double log_likelihood = 0.;
+    for (uint64_t size : sizes) {
+        if (size == 0)
+            continue;
+        ++num_clusters;
+        double cluster_size = static_cast<double>(size);
+        log_likelihood += cluster_size * std::log(cluster_size / num_points);
+    }
+    double variance = num_points > num_clusters
+        ? distortion / (dims * (num_points - num_clusters))
+        : 0.;
+    // Avoid an infinite likelihood for a perfect fit.
+    variance = std::max(variance, std::numeric_limits<double>::epsilon());
+    log_likelihood -= num_points * dims / 2. * std::log(2. * PI * variance);
+    log_likelihood -= dims * (num_points - num_clusters) / 2.;
+    double num_params = (num_clusters - 1.) + dims * num_clusters + 1.;
+    return log_likelihood - num_params / 2. * std::log(num_points);
+}
+
+std::vector<simpoint_t::simpoint_info_t>
+simpoint_t::select_simpoints(const std::vector<const bbv_t *> &intervals,
+                             std::vector<int> *assignment_out)
+{
+    std::vector<simpoint_info_t> result;
+    if (assignment_out != nullptr)
+        assignment_out->assign(intervals.size(), -1);
+    // Empty intervals (such as a final interval with no instructions) carry no
+    // information, so they are left out of clustering.
+    std::vector<size_t> members;
+    std::vector<point_t> points;
+    uint64_t total_instrs = 0;
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        if (intervals[i]->instr_count == 0)
+            continue;
+        members.push_back(i);
+        points.push_back(project(*intervals[i]));
+        total_instrs += intervals[i]->instr_count;
+    }
+    if (points.empty())
+        return result;
+
+    int max_k = static_cast<int>(std::min<size_t>(knob_max_k_, points.size()));
+    std::vector<std::vector<point_t>> all_centers(max_k + 1);
+    std::vector<std::vector<int>> all_assignments(max_k + 1);
+    std::vector<double> scores(max_k + 1);
+    double min_score = std::numeric_limits<double>::max();
+    double max_score = std::numeric_limits<double>::lowest();
+    for (int k = 1; k <= max_k; ++k) {
+        double distortion = kmeans(points, k, all_centers[k], all_assignments[k]);
+        scores[k] = bic_score(points, all_centers[k], all_assignments[k], distortion);
+        min_score = std::min(min_score, scores[k]);
+        max_score = std::max(max_score, scores[k]);
+        if (knob_verbose_ >= 1) {
+            std::cerr << TOOL_NAME << ": k=" << k << " distortion=" << distortion
+                      << " BIC=" << scores[k] << "\n";
+        }
+    }
+    int best_k = max_k;
+    for (int k = 1; k <= max_k; ++k) {
+        if (scores[k] >= min_score + BIC_THRESHOLD * (max_score - min_score)) {
+            best_k = k;
+            break;
+        }
+    }
+    const std::vector<point_t> &centers = all_centers[best_k];
+    const std::vector<int> &assignment = all_assignments[best_k];
+
+    // The representative of each cluster is the interval nearest its center.
+    std::vector<size_t> nearest(best_k, members.size());
+    std::vector<double> nearest_dist(best_k, std::numeric_limits<double>::max());
+    std::vector<uint64_t> cluster_instrs(best_k, 0);
+    for (size_t i = 0; i < points.size(); ++i) {
+        int cluster = assignment[i];
+        cluster_instrs[cluster] += intervals[members[i]]->instr_count;
+        double dist = squared_distance(points[i], centers[cluster]);
+        if (dist < nearest_dist[cluster]) {
+            nearest_dist[cluster] = dist;
+            nearest[cluster] = i;
+        }
+        if (assignment_out != nullptr)
+            (*assignment_out)[members[i]] = cluster;
+    }
+    for (int c = 0; c < best_k; ++c) {
+        if (cluster_instrs[c] == 0)
+            continue;
+        simpoint_info_t info;
+        info.cluster = c;
+        info.interval_index = members[nearest[c]];
+        info.start_instr = intervals[info.interval_index]->start_instr;
+        info.instr_count = intervals[info.interval_index]->instr_count;
+        info.weight = static_cast<double>(cluster_instrs[c]) /
+            static_cast<double>(total_instrs);
+        result.push_back(info);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const simpoint_info_t &a, const simpoint_info_t &b) {
+                  return a.start_instr < b.start_instr;
+              });
+    return result;
+}
+
+bool
+simpoint_t::finalize_interval_snapshots(
+    std::vector<interval_state_snapshot_t *> &interval_snapshots)
+{
+    std::vector<const bbv_t *> intervals;
+    for (interval_state_snapshot_t *base : interval_snapshots) {
+        bbv_snapshot_t *snapshot = dynamic_cast<bbv_snapshot_t *>(base);
+        if (snapshot == nullptr) {
+            error_string_ = "Unexpected interval snapshot type";
+            return false;
+        }
+        snapshot->bbv.instr_count = snapshot->get_instr_count_delta();
+        snapshot->bbv.start_instr =
+            snapshot->get_instr_count_cumulative() - snapshot->get_instr_count_delta();
+        intervals.push_back(&snapshot->bbv);
+    }
+    num_intervals_ = intervals.size();
+    std::vector<int> assignment;
+    simpoints_ = select_simpoints(intervals, &assignment);
+    for (size_t i = 0; i < interval_snapshots.size(); ++i)
+        static_cast<bbv_snapshot_t *>(interval_snapshots[i])->cluster = assignment[i];
+    return write_output_file();
+}
+
+bool
+simpoint_t::write_output_file()
+{
+    if (knob_output_file_.empty())
+        return true;
+    std::ofstream file(knob_output_file_);
+    if (!file.is_open()) {
+        error_string_ = "Failed to open " + knob_output_file_;
+        return false;
+    }
+    // The format of -trace_instr_intervals_file: the number of instructions to
+    // skip and the number to trace, followed by fields the tracer ignores.
+    for (const simpoint_info_t &info : simpoints_) {
+        file << info.start_instr << "," << info.instr_count << "," << std::fixed
+             << std::setprecision(6) << info.weight << "\n";
+    }
+    if (!file.good()) {
+        error_string_ = "Failed to write " + knob_output_file_;
+        return false;
+    }
+    return true;
+}
+
+bool
+simpoint_t::print_results()
+{
+    std::cerr << TOOL_NAME << " results:\n";
+    if (num_intervals_ == 0) {
+        error_string_ = "The simpoint tool requires -interval_instr_count";
+        return false;
+    }
+    std::cerr << std::setw(15) << total_instrs_ << " : total instructions\n";
+    std::cerr << std::setw(15) << num_intervals_ << " : intervals\n";
+    std::cerr << std::setw(15) << simpoints_.size() << " : simulation points\n";
+    std::cerr << std::setw(15) << "start" << std::setw(15) << "instructions"
+              << std::setw(10) << "weight"
+              << "  cluster\n";
+    for (const simpoint_info_t &info : simpoints_) {
+        std::cerr << std::setw(15) << info.start_instr << std::setw(15)
+                  << info.instr_count << std::setw(10) << std::fixed
+                  << std::setprecision(4) << info.weight << "  " << info.cluster
+                  << "\n";
+    }
+    std::cerr.unsetf(std::ios_base::floatfield);
+    if (!knob_output_file_.empty())
+        std::cerr << "Wrote intervals to " << knob_output_file_ << "\n";
+    return true;
+}
+
+bool
+simpoint_t::print_interval_results(
+    const std::vector<interval_state_snapshot_t *> &interval_snapshots)
+{
+    std::cerr << "Cluster assignment per interval:\n";
+    for (const interval_state_snapshot_t *base : interval_snapshots) {
+        const bbv_snapshot_t *snapshot = static_cast<const bbv_snapshot_t *>(base);
+        std::cerr << "Interval #" << snapshot->get_interval_id() << " at instruction "
+                  << snapshot->bbv.start_instr << ": " << snapshot->bbv.instr_count
+                  << " instructions, " << snapshot->bbv.block_instrs.size()
+                  << " blocks, cluster " << snapshot->cluster << "\n";
+    }
+    return true;
+}
+
+bool
+simpoint_t::release_interval_snapshot(interval_state_snapshot_t *interval_snapshot)
+{
+    delete interval_snapshot;
+    return true;
+}
+
+} // namespace drmemtrace
+} // namespace dynamorio
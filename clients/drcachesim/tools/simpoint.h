@@ -0,0 +1,149 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* simpoint: computes per-interval basic block vectors and selects representative
+ * intervals by clustering them, following the SimPoint methodology.
+ */
+
+#ifndef _SIMPOINT_H_
+#define _SIMPOINT_H_ 1
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "analysis_tool.h"
+#include "flat_hash_map.h"
+#include "memref.h"
+#include "trace_entry.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+class simpoint_t : public analysis_tool_t {
+public:
+    simpoint_t(unsigned int max_k, unsigned int dimensions,
+               const std::string &output_file, unsigned int verbose);
+    virtual ~simpoint_t() = default;
+    bool
+    process_memref(const memref_t &memref) override;
+    bool
+    print_results() override;
+    // Basic block vectors are global across all threads, so we only support
+    // serial operation, where the analyzer produces whole-trace intervals.
+    bool
+    parallel_shard_supported() override;
+    interval_state_snapshot_t *
+    generate_interval_snapshot(uint64_t interval_id) override;
+    bool
+    finalize_interval_snapshots(
+        std::vector<interval_state_snapshot_t *> &interval_snapshots) override;
+    bool
+    print_interval_results(
+        const std::vector<interval_state_snapshot_t *> &interval_snapshots) override;
+    bool
+    release_interval_snapshot(interval_state_snapshot_t *interval_snapshot) override;
+
+    // The basic block vector for one interval: the count of instructions executed
+    // in each basic block, keyed by the block's starting pc.
+    struct bbv_t {
+        uint64_t start_instr = 0;
+        uint64_t instr_count = 0;
+        flat_hash_map_t<addr_t, uint64_t> block_instrs;
+    };
+
+    // A representative interval for one cluster of similar intervals.
+    struct simpoint_info_t {
+        int cluster = 0;
+        // Index into the vector of intervals passed to select_simpoints().
+        size_t interval_index = 0;
+        uint64_t start_instr = 0;
+        uint64_t instr_count = 0;
+        // The fraction of all instructions executed in intervals of this cluster.
+        double weight = 0.;
+    };
+
+    // Clusters the given intervals and returns one representative per cluster,
+    // sorted by start_instr.  If non-null, 'assignment' is filled with the cluster
+    // of each interval.  The result is deterministic for a given input.
+    std::vector<simpoint_info_t>
+    select_simpoints(const std::vector<const bbv_t *> &intervals,
+                     std::vector<int> *assignment = nullptr);
+
+    class bbv_snapshot_t : public interval_state_snapshot_t {
+    public:
+        bbv_t bbv;
+        int cluster = -1;
+    };
+
+protected:
+    struct block_state_t {
+        addr_t block_start = 0;
+        addr_t next_pc = 0;
+        bool prev_was_branch = true;
+    };
+
+    typedef std::vector<double> point_t;
+
+    point_t
+    project(const bbv_t &bbv) const;
+    // Runs k-means with k-means++ seeding and returns the sum of squared distances.
+    double
+    kmeans(const std::vector<point_t> &points, int k, std::vector<point_t> &centers,
+           std::vector<int> &assignment) const;
+    // Returns the Bayesian Information Criterion score of a clustering.
+    double
+    bic_score(const std::vector<point_t> &points, const std::vector<point_t> &centers,
+              const std::vector<int> &assignment, double distortion) const;
+    bool
+    write_output_file();
+
+    unsigned int knob_max_k_;
+    unsigned int knob_dimensions_;
+    std::string knob_output_file_;
+    unsigned int knob_verbose_;
+
+    flat_hash_map_t<memref_tid_t, block_state_t> block_state_;
+    // Block counts for the current interval.
+    flat_hash_map_t<addr_t, uint64_t> cur_bbv_;
+    uint64_t total_instrs_ = 0;
+    uint64_t num_intervals_ = 0;
+    std::vector<simpoint_info_t> simpoints_;
+
+    static const std::string TOOL_NAME;
+};
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _SIMPOINT_H_ */
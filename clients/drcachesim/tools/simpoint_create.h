@@ -0,0 +1,66 @@
+/* **********************************************************
+ * Copyright (c) 2026 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* simpoint tool creation */
+
+#ifndef _SIMPOINT_CREATE_H_
+#define _SIMPOINT_CREATE_H_ 1
+
+#include <string>
+
+#include "analysis_tool.h"
+
+namespace dynamorio {
+namespace drmemtrace {
+
+/**
+ * @file drmemtrace/simpoint_create.h
+ * @brief DrMemtrace SimPoint basic block vector analysis tool creation.
+ */
+
+/**
+ * Creates an analysis tool which records a basic block vector for each interval
+ * of the analyzer's -interval_instr_count and clusters them to select
+ * representative simulation points.  At most \p max_k clusters are considered,
+ * after randomly projecting each vector onto \p dimensions dimensions.  If \p
+ * output_file is non-empty, the selected intervals are written to it in the
+ * format of the tracer's -trace_instr_intervals_file, with each cluster's weight
+ * as a third field.
+ */
+analysis_tool_t *
+simpoint_tool_create(unsigned int max_k = 30, unsigned int dimensions = 15,
+                     const std::string &output_file = "", unsigned int verbose = 0);
+
+} // namespace drmemtrace
+} // namespace dynamorio
+
+#endif /* _SIMPOINT_CREATE_H_ */
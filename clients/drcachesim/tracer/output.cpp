@@ -55,6 +55,9 @@
 #include "options.h"
 #include "physaddr.h"
 #include "raw2trace_shared.h"
+#ifdef LINUX
+#    include "shm_ring.h"
+#endif
 #include "trace_entry.h"
 #include "tracer.h"
 #include "utils.h"
@@ -69,6 +72,11 @@
 #ifdef HAS_LZ4
 #    include <lz4frame.h>
 #endif
+#ifdef HAS_ZSTD
+// For ZSTD_createCCtx_advanced(), which lets us supply our own allocator.
+#    define ZSTD_STATIC_LINKING_ONLY
+#    include <zstd.h>
+#endif
 
 namespace dynamorio {
 namespace drmemtrace {
@@ -293,6 +301,47 @@ redirect_free(void *drcontext, void *ptr)
 }
 #endif
 
+#ifdef HAS_ZSTD
+static void *
+zstd_redirect_malloc(void *opaque, size_t size)
+{
+    size += sizeof(size_t);
+    void *mem = dr_custom_alloc(nullptr, static_cast<dr_alloc_flags_t>(0), size,
+                                DR_MEMPROT_READ | DR_MEMPROT_WRITE, nullptr);
+    if (mem == NULL)
+        return NULL;
+    *((size_t *)mem) = size;
+    return (byte *)mem + sizeof(size_t);
+}
+
+static void
+zstd_redirect_free(void *opaque, void *ptr)
+{
+    if (ptr != NULL) {
+        byte *mem = (byte *)ptr;
+        mem -= sizeof(size_t);
+        dr_custom_free(nullptr, static_cast<dr_alloc_flags_t>(0), mem, *((size_t *)mem));
+    }
+}
+
+// Feeds size bytes at start to the per-thread zstd stream and writes out the
+// compressed result.  For ZSTD_e_end, also flushes until the frame is complete.
+static void
+zstd_compress_and_write(per_thread_t *data, byte *start, size_t size,
+                        ZSTD_EndDirective mode)
+{
+    ZSTD_inBuffer in = { start, size, 0 };
+    size_t remaining;
+    do {
+        ZSTD_outBuffer out = { data->buf_zstd, data->buf_zstd_size, 0 };
+        remaining = ZSTD_compressStream2(data->zstd_cctx, &out, &in, mode);
+        DR_ASSERT(!ZSTD_isError(remaining));
+        ssize_t wrote = file_ops_func.write_file(data->file, data->buf_zstd, out.pos);
+        DR_ASSERT(static_cast<size_t>(wrote) == out.pos);
+    } while (mode == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+}
+#endif
+
 int
 append_unit_header(void *drcontext, byte *buf_ptr, thread_id_t tid, ptr_int_t window)
 {
@@ -334,10 +383,14 @@ open_new_window_dir(ptr_int_t window_num)
     NOTIFY(2, "Created new window dir %s\n", windir);
 }
 
+static void
+async_drain(per_thread_t *data);
+
 static void
 close_thread_file(void *drcontext)
 {
     per_thread_t *data = (per_thread_t *)drmgr_get_tls_field(drcontext, tls_idx);
+    async_drain(data);
 #ifdef HAS_SNAPPY
     if (op_offline.get_value() && snappy_enabled()) {
         data->snappy_writer->~snappy_file_writer_t();
@@ -379,6 +432,14 @@ close_thread_file(void *drcontext)
         res = LZ4F_freeCompressionContext(data->lzcxt);
         DR_ASSERT(!LZ4F_isError(res));
     }
+#endif
+#ifdef HAS_ZSTD
+    if (op_offline.get_value() && op_raw_compress.get_value() == "zstd") {
+        // Flush remaining data and end the frame.
+        zstd_compress_and_write(data, nullptr, 0, ZSTD_e_end);
+        ZSTD_freeCCtx(data->zstd_cctx);
+        data->zstd_cctx = nullptr;
+    }
 #endif
     file_ops_func.close_file(data->file);
     data->file = INVALID_FILE;
@@ -429,6 +490,10 @@ open_new_thread_file(void *drcontext, ptr_int_t window_num)
 #ifdef HAS_LZ4
     if (op_raw_compress.get_value() == "lz4")
         suffix = OUTFILE_SUFFIX_LZ4;
+#endif
+#ifdef HAS_ZSTD
+    if (op_raw_compress.get_value() == "zstd")
+        suffix = OUTFILE_SUFFIX_ZSTD;
 #endif
     for (i = 0; i < NUM_OF_TRIES; i++) {
         drx_open_unique_appid_file(dir, dr_get_thread_id(drcontext), subdir_prefix,
@@ -492,6 +557,16 @@ open_new_thread_file(void *drcontext, ptr_int_t window_num)
             ssize_t wrote = file_ops_func.write_file(data->file, data->buf_lz4, res);
             DR_ASSERT(static_cast<size_t>(wrote) == res);
         }
+#endif
+#ifdef HAS_ZSTD
+        if (op_offline.get_value() && op_raw_compress.get_value() == "zstd") {
+            ZSTD_customMem mem = { zstd_redirect_malloc, zstd_redirect_free, drcontext };
+            data->zstd_cctx = ZSTD_createCCtx_advanced(mem);
+            DR_ASSERT(data->zstd_cctx != nullptr);
+            size_t res = ZSTD_CCtx_setParameter(data->zstd_cctx, ZSTD_c_compressionLevel,
+                                                op_raw_compress_level.get_value());
+            DR_ASSERT(!ZSTD_isError(res));
+        }
 #endif
         break;
     }
@@ -537,6 +612,535 @@ atomic_pipe_write(void *drcontext, byte *pipe_start, byte *pipe_end, ptr_int_t w
     return pipe_start;
 }
 
+// Compresses the data if requested and writes it to the thread's raw file.  With
+// -raw_output_threads this is called on a writer thread for full buffers, so it
+// must not use the thread's drcontext.
+static void
+write_thread_file(per_thread_t *data, thread_id_t tid, byte *towrite_start,
+                  byte *towrite_end)
+{
+    ssize_t size = towrite_end - towrite_start;
+    DR_ASSERT(data->file != INVALID_FILE);
+    ssize_t wrote;
+#ifdef HAS_SNAPPY
+    if (op_offline.get_value() && snappy_enabled())
+        wrote = data->snappy_writer->compress_and_write(towrite_start, size);
+    else
+#endif
+#ifdef HAS_ZLIB
+        if (op_offline.get_value() &&
+            (op_raw_compress.get_value() == "zlib" ||
+             op_raw_compress.get_value() == "gzip")) {
+        data->zstream.next_in = (Bytef *)towrite_start;
+        data->zstream.avail_in = static_cast<uInt>(size);
+        int res;
+        do {
+            data->zstream.next_out = (Bytef *)data->buf_compressed;
+            data->zstream.avail_out = static_cast<uInt>(max_buf_size);
+            res = deflate(&data->zstream, Z_NO_FLUSH);
+            NOTIFY(3, "deflate => %d in=%d out=%d => in=%d, out=%d, write=%d\n", res,
+                   size, size, data->zstream.avail_in, data->zstream.avail_out,
+                   max_buf_size - data->zstream.avail_out);
+            DR_ASSERT(res != Z_STREAM_ERROR);
+            wrote = file_ops_func.write_file(data->file, data->buf_compressed,
+                                             max_buf_size - data->zstream.avail_out);
+        } while (data->zstream.avail_out == 0);
+        DR_ASSERT(data->zstream.avail_in == 0);
+        wrote = size;
+    } else
+#endif
+#ifdef HAS_LZ4
+        if (op_offline.get_value() && op_raw_compress.get_value() == "lz4") {
+        size_t res = LZ4F_compressUpdate(data->lzcxt, data->buf_lz4, data->buf_lz4_size,
+                                         towrite_start, size, nullptr);
+        DR_ASSERT(!LZ4F_isError(res));
+        wrote = file_ops_func.write_file(data->file, data->buf_lz4, res);
+        DR_ASSERT(static_cast<size_t>(wrote) == res);
+        wrote = size;
+    } else
+#endif
+#ifdef HAS_ZSTD
+        if (op_offline.get_value() && op_raw_compress.get_value() == "zstd") {
+        zstd_compress_and_write(data, towrite_start, size, ZSTD_e_continue);
+        wrote = size;
+    } else
+#endif
+        wrote = file_ops_func.write_file(data->file, towrite_start, size);
+    if (wrote < size) {
+        FATAL("Fatal error: failed to write trace for T%d window %zd: wrote %zd "
+              "of %zd\n",
+              tid, get_local_window(data), wrote, size);
+    }
+}
+
+/***************************************************************************
+ * Asynchronous output for -raw_output_threads.
+ *
+ * A full buffer is swapped for a clean one taken from a bounded pool of slots and
+ * pushed, without locking, onto its thread's stream.  A stream with new buffers
+ * is pushed onto the ready list of the writer thread it is assigned to, which
+ * writes out the stream's buffers in order and returns their slots, with clean
+ * buffers, to the pool.  Each stream has a DR mutex that is held while its
+ * buffers are written.  This lets the owning thread write out its own queue when
+ * it needs the file in order (window changes and thread exit), and since DR does
+ * not suspend a client thread holding a DR lock it never suspends a writer
+ * part-way through a buffer.  The writers are stopped in the process exit event.
+ */
+
+struct async_slot_t {
+    // While free: the index plus one of the next free slot, or 0.
+    std::atomic<uint> next_free;
+    // While queued: the next older buffer on the stream.
+    async_slot_t *next;
+    // While queued, the full buffer and the end of its data; while free, a clean
+    // buffer or nullptr if none has been allocated yet.
+    byte *buf;
+    byte *end;
+};
+
+struct async_stream_t {
+    // The slots awaiting writing, newest first.  Only the owning thread pushes.
+    std::atomic<async_slot_t *> queue;
+    // Held while writing the queued buffers.
+    void *lock;
+    // Whether the stream is on its writer's ready list.
+    std::atomic<bool> scheduled;
+    async_stream_t *next_ready;
+    // The owner's data, or nullptr once the owner exits and the stream can be reused.
+    per_thread_t *data;
+    thread_id_t tid;
+    uint writer;
+    async_stream_t *next_stream;
+};
+
+struct async_writer_t {
+    std::atomic<async_stream_t *> ready;
+    void *event;
+};
+
+static bool async_active;
+static std::atomic<bool> async_exiting;
+static async_slot_t *async_slots;
+static uint async_num_slots;
+// The free slot stack: a tag in the top half to avoid ABA problems, and the top
+// slot's index plus one, or 0 if empty, in the bottom half.
+static std::atomic<uint64> async_free_slots;
+static std::atomic<int> async_slot_waiters;
+static void *async_slot_event;
+static async_writer_t *async_writers;
+static uint async_num_writers;
+// Set once the writer threads have been created.
+static std::atomic<bool> async_writers_started;
+// The writers still running, and the event the last one to finish signals.
+static std::atomic<uint> async_writers_running;
+static void *async_writers_done;
+// All streams, for reuse and cleanup.  Guarded by async_streams_lock.
+static async_stream_t *async_streams;
+static uint async_streams_created;
+static void *async_streams_lock;
+
+static void
+async_push_free_slot(async_slot_t *slot)
+{
+    uint64 index = slot - async_slots;
+    uint64 head = async_free_slots.load(std::memory_order_relaxed);
+    uint64 new_head;
+    do {
+        slot->next_free.store(static_cast<uint>(head), std::memory_order_relaxed);
+        new_head = (((head >> 32) + 1) << 32) | (index + 1);
+    } while (!async_free_slots.compare_exchange_weak(
+        head, new_head, std::memory_order_release, std::memory_order_relaxed));
+}
+
+static async_slot_t *
+async_pop_free_slot()
+{
+    uint64 head = async_free_slots.load(std::memory_order_acquire);
+    uint64 new_head;
+    do {
+        uint index = static_cast<uint>(head);
+        if (index == 0)
+            return nullptr;
+        uint next = async_slots[index - 1].next_free.load(std::memory_order_relaxed);
+        new_head = (((head >> 32) + 1) << 32) | next;
+    } while (!async_free_slots.compare_exchange_weak(
+        head, new_head, std::memory_order_acquire, std::memory_order_acquire));
+    return &async_slots[static_cast<uint>(head) - 1];
+}
+
+// Cleans the written buffer in the same way process_and_output_buffer() does for
+// a synchronous write and returns the slot to the pool.
+static void
+async_release_slot(async_slot_t *slot)
+{
+    memset(slot->buf, 0, trace_buf_size);
+    byte *redzone = slot->buf + trace_buf_size;
+    if (slot->end > redzone)
+        memset(redzone, -1, slot->end - redzone);
+    slot->end = nullptr;
+    async_push_free_slot(slot);
+    if (async_slot_waiters.load(std::memory_order_acquire) > 0)
+        dr_event_signal(async_slot_event);
+}
+
+// Writes out every buffer queued on the stream.  The caller must hold stream->lock.
+static void
+async_write_stream(async_stream_t *stream)
+{
+    async_slot_t *slot = stream->queue.exchange(nullptr, std::memory_order_seq_cst);
+    // Reverse into oldest-first order.
+    async_slot_t *oldest = nullptr;
+    while (slot != nullptr) {
+        async_slot_t *next = slot->next;
+        slot->next = oldest;
+        oldest = slot;
+        slot = next;
+    }
+    while (oldest != nullptr) {
+        async_slot_t *next = oldest->next;
+        write_thread_file(stream->data, stream->tid, oldest->buf, oldest->end);
+        async_release_slot(oldest);
+        oldest = next;
+    }
+}
+
+// Writes out anything the thread has queued so that a synchronous write, or a file
+// close, stays in order.
+static void
+async_drain(per_thread_t *data)
+{
+    async_stream_t *stream = data->async_stream;
+    if (stream == nullptr)
+        return;
+    dr_mutex_lock(stream->lock);
+    async_write_stream(stream);
+    dr_mutex_unlock(stream->lock);
+}
+
+static void
+async_writer_thread(void *arg)
+{
+    async_writer_t *writer = reinterpret_cast<async_writer_t *>(arg);
+    while (true) {
+        async_stream_t *stream =
+            writer->ready.exchange(nullptr, std::memory_order_acquire);
+        if (stream == nullptr) {
+            // We only stop once the list is empty, so that the buffers of threads
+            // with no exit event are still written.
+            if (async_exiting.load(std::memory_order_acquire))
+                break;
+            dr_event_wait(writer->event);
+            continue;
+        }
+        while (stream != nullptr) {
+            async_stream_t *next = stream->next_ready;
+            // Clear this first so that a buffer queued from here on schedules the
+            // stream again, rather than being missed.
+            stream->scheduled.store(false, std::memory_order_seq_cst);
+            dr_mutex_lock(stream->lock);
+            async_write_stream(stream);
+            dr_mutex_unlock(stream->lock);
+            stream = next;
+        }
+    }
+    if (async_writers_running.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        dr_event_signal(async_writers_done);
+    // Returning from here during the exit event hangs the process, so as for any
+    // client thread still alive at exit we wait for DR to terminate us.
+    while (true)
+        dr_sleep(1000);
+}
+
+static void
+async_schedule(async_stream_t *stream)
+{
+    if (stream->scheduled.exchange(true, std::memory_order_seq_cst))
+        return;
+    async_writer_t *writer = &async_writers[stream->writer];
+    async_stream_t *head = writer->ready.load(std::memory_order_relaxed);
+    do {
+        stream->next_ready = head;
+    } while (!writer->ready.compare_exchange_weak(
+        head, stream, std::memory_order_release, std::memory_order_relaxed));
+    // The writer only waits once it has emptied its list.
+    if (head == nullptr)
+        dr_event_signal(writer->event);
+}
+
+// Creates the writer threads on the first hand-off.  Client threads created from
+// our init crash before they start running, so we wait until the app is running.
+static void
+async_start_writers()
+{
+    if (async_writers_started.load(std::memory_order_acquire) ||
+        async_writers_started.exchange(true, std::memory_order_acq_rel))
+        return;
+    async_writers_running.store(async_num_writers, std::memory_order_release);
+    for (uint i = 0; i < async_num_writers; ++i) {
+        if (!dr_create_client_thread(async_writer_thread, &async_writers[i]))
+            FATAL("Fatal error: failed to create -raw_output_threads thread.\n");
+    }
+}
+
+// Returns a free slot, blocking if the cap on queued buffers has been reached.
+static async_slot_t *
+async_acquire_slot(per_thread_t *data)
+{
+    async_slot_t *slot = async_pop_free_slot();
+    if (slot != nullptr)
+        return slot;
+    // Before blocking, write out our own buffers if no writer is doing so already.
+    async_stream_t *stream = data->async_stream;
+    if (dr_mutex_trylock(stream->lock)) {
+        async_write_stream(stream);
+        dr_mutex_unlock(stream->lock);
+    }
+    async_slot_waiters.fetch_add(1, std::memory_order_acq_rel);
+    while ((slot = async_pop_free_slot()) == nullptr)
+        dr_event_wait(async_slot_event);
+    // The event wakes one waiter per signal, so pass a wakeup along if another
+    // slot is already free.
+    if (async_slot_waiters.fetch_sub(1, std::memory_order_acq_rel) > 1 &&
+        static_cast<uint>(async_free_slots.load(std::memory_order_acquire)) != 0)
+        dr_event_signal(async_slot_event);
+    return slot;
+}
+
+// Queues the full buffer [buf_base, buf_ptr), which must be the thread's current
+// buffer, for a writer thread and gives the thread a clean buffer.  Returns false
+// if the caller should write the data itself.
+static bool
+async_output_buffer(per_thread_t *data, byte *buf_base, byte *buf_ptr)
+{
+    // The -L0_filter_until_instrs mode switch moves buf_base inside the buffer,
+    // which we cannot hand off.
+    if (data->async_stream == nullptr || buf_base != data->buf_base ||
+        file_ops_func.handoff_buf != NULL || op_L0_filter_until_instrs.get_value())
+        return false;
+    async_start_writers();
+    async_slot_t *slot = async_acquire_slot(data);
+    byte *clean_buf = slot->buf;
+    if (clean_buf == nullptr) {
+        clean_buf = (byte *)dr_raw_mem_alloc(max_buf_size,
+                                             DR_MEMPROT_READ | DR_MEMPROT_WRITE, NULL);
+        if (clean_buf == nullptr) {
+            async_push_free_slot(slot);
+            return false;
+        }
+        // As in create_buffer(), the memory is zeroed but the redzone is not.
+        memset(clean_buf + trace_buf_size, -1, redzone_size);
+    }
+    slot->buf = buf_base;
+    slot->end = buf_ptr;
+    async_stream_t *stream = data->async_stream;
+    slot->next = stream->queue.load(std::memory_order_relaxed);
+    while (!stream->queue.compare_exchange_weak(slot->next, slot,
+                                                std::memory_order_seq_cst))
+        ;
+    async_schedule(stream);
+    data->buf_base = clean_buf;
+    return true;
+}
+
+static void
+async_thread_init(void *drcontext, per_thread_t *data)
+{
+    if (!async_active)
+        return;
+    dr_mutex_lock(async_streams_lock);
+    async_stream_t *stream = async_streams;
+    while (stream != nullptr && stream->data != nullptr)
+        stream = stream->next_stream;
+    if (stream == nullptr) {
+        stream = static_cast<async_stream_t *>(dr_global_alloc(sizeof(*stream)));
+        new (stream) async_stream_t();
+        stream->lock = dr_mutex_create();
+        stream->writer = async_streams_created++ % async_num_writers;
+        stream->next_stream = async_streams;
+        async_streams = stream;
+    }
+    stream->data = data;
+    stream->tid = dr_get_thread_id(drcontext);
+    dr_mutex_unlock(async_streams_lock);
+    data->async_stream = stream;
+}
+
+// Writes out the thread's queue and detaches it from its stream, so that any
+// further output, such as the thread's final buffer, is written synchronously.
+static void
+async_thread_exit(per_thread_t *data)
+{
+    async_stream_t *stream = data->async_stream;
+    if (stream == nullptr)
+        return;
+    async_drain(data);
+    data->async_stream = nullptr;
+    dr_mutex_lock(async_streams_lock);
+    stream->data = nullptr;
+    dr_mutex_unlock(async_streams_lock);
+}
+
+static void
+async_init()
+{
+    if (async_active || !op_offline.get_value() ||
+        op_raw_output_threads.get_value() == 0)
+        return;
+    if (op_raw_output_max_buffers.get_value() == 0)
+        FATAL("Usage error: -raw_output_max_buffers must be positive.\n");
+    async_num_slots = op_raw_output_max_buffers.get_value();
+    async_slots = static_cast<async_slot_t *>(
+        dr_global_alloc(async_num_slots * sizeof(*async_slots)));
+    async_free_slots.store(0, std::memory_order_relaxed);
+    for (uint i = 0; i < async_num_slots; ++i) {
+        new (&async_slots[i]) async_slot_t();
+        async_push_free_slot(&async_slots[i]);
+    }
+    async_slot_event = dr_event_create();
+    async_slot_waiters.store(0, std::memory_order_relaxed);
+    async_streams_lock = dr_mutex_create();
+    async_streams = nullptr;
+    async_streams_created = 0;
+    async_exiting.store(false, std::memory_order_release);
+    async_num_writers = op_raw_output_threads.get_value();
+    async_writers = static_cast<async_writer_t *>(
+        dr_global_alloc(async_num_writers * sizeof(*async_writers)));
+    async_writers_done = dr_event_create();
+    async_writers_running.store(0, std::memory_order_release);
+    async_writers_started.store(false, std::memory_order_release);
+    for (uint i = 0; i < async_num_writers; ++i) {
+        new (&async_writers[i]) async_writer_t();
+        async_writers[i].event = dr_event_create();
+    }
+    async_active = true;
+}
+
+static void
+async_exit()
+{
+    if (!async_active)
+        return;
+    // DR only suspends client threads after this exit event, so the writers
+    // are still running: we have them write out what is left and wait for them
+    // to finish before freeing anything they use.
+    async_active = false;
+    async_exiting.store(true, std::memory_order_release);
+    for (uint i = 0; i < async_num_writers; ++i)
+        dr_event_signal(async_writers[i].event);
+    while (async_writers_running.load(std::memory_order_acquire) > 0)
+        dr_event_wait(async_writers_done);
+    dr_event_destroy(async_writers_done);
+    for (uint i = 0; i < async_num_writers; ++i)
+        dr_event_destroy(async_writers[i].event);
+    dr_global_free(async_writers, async_num_writers * sizeof(*async_writers));
+    while (async_streams != nullptr) {
+        async_stream_t *next = async_streams->next_stream;
+        DR_ASSERT(async_streams->queue.load(std::memory_order_acquire) == nullptr);
+        dr_mutex_destroy(async_streams->lock);
+        dr_global_free(async_streams, sizeof(*async_streams));
+        async_streams = next;
+    }
+    dr_mutex_destroy(async_streams_lock);
+    for (uint i = 0; i < async_num_slots; ++i) {
+        DR_ASSERT(async_slots[i].end == nullptr);
+        if (async_slots[i].buf != nullptr)
+            dr_raw_mem_free(async_slots[i].buf, max_buf_size);
+    }
+    dr_global_free(async_slots, async_num_slots * sizeof(*async_slots));
+    dr_event_destroy(async_slot_event);
+}
+
+/***************************************************************************
+ * Shared-memory ring transport for -ipc_shm.
+ * The analyzer creates the file and its rings.  Each thread claims a ring at
+ * init and writes whole buffers to it, so no splitting for atomicity is needed.
+ * The ring goes back to the pool once the thread exits and the analyzer drains it.
+ */
+
+#ifdef LINUX
+static shm_ring_control_t *shm_control;
+static size_t shm_map_size;
+static std::atomic<bool> shm_rings_exhausted;
+
+bool
+init_shm_rings(const std::string &ipc_name)
+{
+    std::string path = shm_ring_path(ipc_name);
+    if (!dr_file_exists(path.c_str())) {
+        NOTIFY(0,
+               "drmemtrace WARNING: -ipc_shm file %s does not exist: the analyzer "
+               "must be started first.\n",
+               path.c_str());
+        return false;
+    }
+    file_t f = dr_open_file(path.c_str(), DR_FILE_READ | DR_FILE_WRITE_APPEND);
+    if (f == INVALID_FILE)
+        return false;
+    uint64 size;
+    if (!dr_file_size(f, &size) || size < SHM_RING_PAGE_SIZE) {
+        dr_close_file(f);
+        return false;
+    }
+    size_t map_size = static_cast<size_t>(size);
+    void *map =
+        dr_map_file(f, &map_size, 0, nullptr, DR_MEMPROT_READ | DR_MEMPROT_WRITE, 0);
+    dr_close_file(f);
+    if (map == nullptr)
+        return false;
+    shm_ring_control_t *control = static_cast<shm_ring_control_t *>(map);
+    // The analyzer writes the magic last.
+    uint64_t magic = control->magic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (magic != SHM_RING_MAGIC || control->version != SHM_RING_VERSION ||
+        shm_ring_file_size(control->ring_count, control->ring_size) > map_size) {
+        dr_unmap_file(map, map_size);
+        return false;
+    }
+    shm_ring_attach(control, static_cast<uint32_t>(dr_get_process_id()));
+    shm_control = control;
+    shm_map_size = map_size;
+    return true;
+}
+
+static void
+shm_thread_init(void *drcontext, per_thread_t *data)
+{
+    if (shm_control == nullptr)
+        return;
+    data->shm_ring = shm_ring_claim(shm_control,
+                                    static_cast<uint32_t>(dr_get_process_id()),
+                                    static_cast<uint32_t>(dr_get_thread_id(drcontext)));
+    // Aborting here would leave the analyzer waiting forever on the rings
+    // owned by the other threads, so we instead leave this thread untraced.
+    if (data->shm_ring == nullptr && !shm_rings_exhausted.exchange(true)) {
+        NOTIFY(0,
+               "drmemtrace WARNING: all %u -ipc_shm rings are in use: threads "
+               "started while they are will not be traced; re-run with a larger "
+               "-ipc_shm_rings\n",
+               shm_control->ring_count);
+    }
+}
+
+static void
+shm_thread_exit(per_thread_t *data)
+{
+    if (data->shm_ring == nullptr)
+        return;
+    shm_ring_close(data->shm_ring);
+    data->shm_ring = nullptr;
+}
+
+static void
+shm_exit()
+{
+    if (shm_control == nullptr)
+        return;
+    shm_ring_detach(shm_control, static_cast<uint32_t>(dr_get_process_id()));
+    dr_unmap_file(shm_control, shm_map_size);
+    shm_control = nullptr;
+}
+#endif
+
 static inline byte *
 write_trace_data(void *drcontext, byte *towrite_start, byte *towrite_end,
                  ptr_int_t window)
@@ -551,56 +1155,25 @@ write_trace_data(void *drcontext, byte *towrite_start, byte *towrite_end,
                 FATAL("Fatal error: failed to hand off trace\n");
             }
         } else {
-            ssize_t wrote;
-#ifdef HAS_SNAPPY
-            if (op_offline.get_value() && snappy_enabled())
-                wrote = data->snappy_writer->compress_and_write(towrite_start, size);
-            else
-#endif
-#ifdef HAS_ZLIB
-                if (op_offline.get_value() &&
-                    (op_raw_compress.get_value() == "zlib" ||
-                     op_raw_compress.get_value() == "gzip")) {
-                data->zstream.next_in = (Bytef *)towrite_start;
-                data->zstream.avail_in = static_cast<uInt>(size);
-                int res;
-                do {
-                    data->zstream.next_out = (Bytef *)data->buf_compressed;
-                    data->zstream.avail_out = static_cast<uInt>(max_buf_size);
-                    res = deflate(&data->zstream, Z_NO_FLUSH);
-                    NOTIFY(3, "deflate => %d in=%d out=%d => in=%d, out=%d, write=%d\n",
-                           res, size, size, data->zstream.avail_in,
-                           data->zstream.avail_out,
-                           max_buf_size - data->zstream.avail_out);
-                    DR_ASSERT(res != Z_STREAM_ERROR);
-                    wrote =
-                        file_ops_func.write_file(data->file, data->buf_compressed,
-                                                 max_buf_size - data->zstream.avail_out);
-                } while (data->zstream.avail_out == 0);
-                DR_ASSERT(data->zstream.avail_in == 0);
-                wrote = size;
-            } else
-#endif
-#ifdef HAS_LZ4
-                if (op_offline.get_value() && op_raw_compress.get_value() == "lz4") {
-                size_t res =
-                    LZ4F_compressUpdate(data->lzcxt, data->buf_lz4, data->buf_lz4_size,
-                                        towrite_start, size, nullptr);
-                DR_ASSERT(!LZ4F_isError(res));
-                wrote = file_ops_func.write_file(data->file, data->buf_lz4, res);
-                DR_ASSERT(static_cast<size_t>(wrote) == res);
-                wrote = size;
-            } else
-#endif
-                wrote = file_ops_func.write_file(data->file, towrite_start, size);
-            if (wrote < size) {
-                FATAL("Fatal error: failed to write trace for T%d window %zd: wrote %zd "
-                      "of %zd\n",
-                      dr_get_thread_id(drcontext), get_local_window(data), wrote, size);
-            }
+            // Anything still queued for the writer threads must come first.
+            async_drain(data);
+            write_thread_file(data, dr_get_thread_id(drcontext), towrite_start,
+                              towrite_end);
         }
         return towrite_start;
     } else {
+#ifdef LINUX
+        if (shm_control != nullptr) {
+            per_thread_t *data =
+                (per_thread_t *)drmgr_get_tls_field(drcontext, tls_idx);
+            if (data->shm_ring == nullptr)
+                return towrite_start;
+            shm_ring_write(shm_control, data->shm_ring,
+                           reinterpret_cast<const char *>(towrite_start),
+                           towrite_end - towrite_start);
+            return towrite_start;
+        }
+#endif
 #ifdef HAS_SNAPPY
         // XXX i#5427: Use snappy compression for pipe data as well.  We need to
         // create a reader on the other end first.
@@ -748,7 +1321,12 @@ output_buffer(void *drcontext, per_thread_t *data, byte *buf_base, byte *buf_ptr
               size_t header_size)
 {
     byte *pipe_start = buf_base;
-    if (!op_offline.get_value()) {
+    if (!op_offline.get_value()
+#ifdef LINUX
+        // The rings take the whole buffer via write_trace_data().
+        && shm_control == nullptr
+#endif
+    ) {
         byte *post_header = buf_base + header_size;
         byte *last_ok_to_split_ref = nullptr;
         // Pipe split headers are just the tid.
@@ -820,7 +1398,7 @@ output_buffer(void *drcontext, per_thread_t *data, byte *buf_base, byte *buf_ptr
                                                              instru->sizeof_entry())));
             atomic_pipe_write(drcontext, pipe_start, buf_ptr, get_local_window(data));
         }
-    } else {
+    } else if (!async_output_buffer(data, buf_base, buf_ptr)) {
         write_trace_data(drcontext, pipe_start, buf_ptr, get_local_window(data));
     }
     auto span = buf_ptr - buf_base; // Include the header.
@@ -1033,6 +1611,7 @@ process_and_output_buffer(void *drcontext, bool skip_size_cap)
     per_thread_t *data = (per_thread_t *)drmgr_get_tls_field(drcontext, tls_idx);
     byte *mem_ref, *buf_ptr;
     byte *redzone;
+    byte *full_buf = data->buf_base;
     bool do_write = true;
     uint current_num_refs = 0;
 
@@ -1251,11 +1830,13 @@ process_and_output_buffer(void *drcontext, bool skip_size_cap)
         if (op_use_physical.get_value()) {
             skip = process_buffer_for_physaddr(drcontext, data, header_size, buf_ptr);
         }
+        full_buf = data->buf_base;
         current_num_refs +=
             output_buffer(drcontext, data, data->buf_base + skip, buf_ptr, header_size);
     }
 
-    if (file_ops_func.handoff_buf == NULL) {
+    // If the buffer was queued for a writer thread we were given a clean one.
+    if (file_ops_func.handoff_buf == NULL && data->buf_base == full_buf) {
         // Our instrumentation reads from buffer and skips the clean call if the
         // content is 0, so we need set zero in the trace buffer and set non-zero
         // in redzone.
@@ -1330,6 +1911,14 @@ init_thread_io(void *drcontext)
             data->buf_lz4_size, DR_MEMPROT_READ | DR_MEMPROT_WRITE, nullptr));
     }
 #endif
+#ifdef HAS_ZSTD
+    if (op_offline.get_value() && op_raw_compress.get_value() == "zstd") {
+        // Large enough that a whole buffer usually compresses in one step.
+        data->buf_zstd_size = ZSTD_compressBound(max_buf_size);
+        data->buf_zstd = static_cast<byte *>(dr_raw_mem_alloc(
+            data->buf_zstd_size, DR_MEMPROT_READ | DR_MEMPROT_WRITE, nullptr));
+    }
+#endif
 
     if (op_use_physical.get_value()) {
         if (!data->physaddr.init()) {
@@ -1338,6 +1927,7 @@ init_thread_io(void *drcontext)
                   dr_get_thread_id(drcontext));
         }
     }
+    async_thread_init(drcontext, data);
 
     set_local_window(drcontext, -1);
     if (has_tracing_windows())
@@ -1367,6 +1957,9 @@ init_thread_io(void *drcontext)
         }
 
     } else {
+#ifdef LINUX
+        shm_thread_init(drcontext, data);
+#endif
         /* pass pid and tid to the simulator to register current thread */
         char buf[MAXIMUM_PATH];
         proc_info = (byte *)buf;
@@ -1403,6 +1996,9 @@ exit_thread_io(void *drcontext)
         return;
     }
 #endif
+    // DR suspends the writer threads before the final thread exits at process exit,
+    // so we write out our queue and our final buffer ourselves.
+    async_thread_exit(data);
 
     // Append a thread exit marker and output remaining records for this thread if it has
     // data from a prior window that it never wrote out.
@@ -1436,6 +2032,9 @@ exit_thread_io(void *drcontext)
     }
     if (op_offline.get_value() && data->file != INVALID_FILE)
         close_thread_file(drcontext);
+#ifdef LINUX
+    shm_thread_exit(data);
+#endif
 
 #ifdef HAS_ZLIB
     if (op_offline.get_value() &&
@@ -1449,6 +2048,11 @@ exit_thread_io(void *drcontext)
         dr_raw_mem_free(data->buf_lz4, data->buf_lz4_size);
     }
 #endif
+#ifdef HAS_ZSTD
+    if (op_offline.get_value() && op_raw_compress.get_value() == "zstd") {
+        dr_raw_mem_free(data->buf_zstd, data->buf_zstd_size);
+    }
+#endif
 }
 
 void
@@ -1464,6 +2068,9 @@ init_io()
 #endif
 #ifdef HAS_LZ4
         || op_raw_compress.get_value() == "lz4"
+#endif
+#ifdef HAS_ZSTD
+        || op_raw_compress.get_value() == "zstd"
 #endif
     ) {
         // Valid option.
@@ -1496,13 +2103,39 @@ init_io()
 #endif
 
     DR_ASSERT(cur_window_instr_count.is_lock_free());
+    // The early call from drmemtrace_client_main() precedes the buffer size
+    // computation, so we set up on the second call.
+    if (max_buf_size > 0)
+        async_init();
 }
 
 void
 exit_io()
 {
     notify_beyond_global_max_once = 0;
+    async_exit();
+#ifdef LINUX
+    shm_exit();
+#endif
+}
+
+#ifdef UNIX
+void
+fork_init_io(void *drcontext)
+{
+    // The writer threads do not exist in the child, whose output is synchronous.
+    per_thread_t *data = (per_thread_t *)drmgr_get_tls_field(drcontext, tls_idx);
+    async_active = false;
+    data->async_stream = nullptr;
+#    ifdef LINUX
+    // The child shares the mapping but needs its own ring, claimed by the
+    // init_thread_io() that follows.
+    if (shm_control != nullptr)
+        shm_ring_attach(shm_control, static_cast<uint32_t>(dr_get_process_id()));
+    data->shm_ring = nullptr;
+#    endif
 }
+#endif
 
 } // namespace drmemtrace
 } // namespace dynamorio
@@ -64,6 +64,17 @@ init_io();
 void
 exit_io();
 
+#ifdef UNIX
+void
+fork_init_io(void *drcontext);
+#endif
+
+#ifdef LINUX
+// Maps the -ipc_shm rings created by the analyzer for "ipc_name".
+bool
+init_shm_rings(const std::string &ipc_name);
+#endif
+
 // Returns true for an empty new (non-initial) buffer for a tracing window
 // with no instructions traced yet in the window.
 inline bool
@@ -98,6 +98,24 @@ namespace drmemtrace {
 
 static online_instru_t instru(NULL, NULL, NULL);
 
+// Returns the total size of "f" if it supports seeking to the end, restoring its
+// position; returns 0 for streams such as compressed ones that cannot seek.
+static uint64_t
+get_stream_size(std::istream *f)
+{
+    if (f == nullptr)
+        return 0;
+    std::streambuf *buf = f->rdbuf();
+    std::streampos cur = buf->pubseekoff(0, std::ios_base::cur, std::ios_base::in);
+    if (cur == std::streampos(-1))
+        return 0;
+    std::streampos end = buf->pubseekoff(0, std::ios_base::end, std::ios_base::in);
+    buf->pubseekpos(cur, std::ios_base::in);
+    if (end == std::streampos(-1) || end < cur)
+        return 0;
+    return static_cast<uint64_t>(end);
+}
+
 int
 trace_metadata_writer_t::write_thread_exit(byte *buffer, thread_id_t tid)
 {
@@ -1015,7 +1033,7 @@ raw2trace_t::process_next_thread_buffer(raw2trace_thread_data_t *tdata,
                 return false;
             }
             if (flush_decode_cache)
-                decode_cache_[tdata->worker].clear();
+                clear_decode_cache(tdata);
             if ((uint)(buf - buf_base) >= WRITE_BUFFER_SIZE) {
                 tdata->error = "Too many entries";
                 return false;
@@ -1066,7 +1084,7 @@ raw2trace_t::process_next_thread_buffer(raw2trace_thread_data_t *tdata,
         bool success = process_offline_entry(tdata, &entry, tdata->tid, end_of_record,
                                              &last_bb_handled, &flush_decode_cache);
         if (flush_decode_cache)
-            decode_cache_[tdata->worker].clear();
+            clear_decode_cache(tdata);
         if (!success)
             return false;
     }
@@ -1094,7 +1112,7 @@ raw2trace_t::process_thread_file(raw2trace_thread_data_t *tdata)
                     process_offline_entry(tdata, &entry, tdata->tid, &end_of_file,
                                           &last_bb_handled, &flush_decode_cache);
                 if (flush_decode_cache)
-                    decode_cache_[tdata->worker].clear();
+                    clear_decode_cache(tdata);
                 if (!end_of_file) {
                     tdata->error = "Synthetic footer failed";
                     return false;
@@ -1160,15 +1178,68 @@ raw2trace_t::check_kthread_file(std::istream *f)
 }
 #endif
 
-void
-raw2trace_t::process_tasks(std::vector<raw2trace_thread_data_t *> *tasks)
+raw2trace_t::raw2trace_thread_data_t *
+raw2trace_t::next_task(int worker)
 {
-    if (tasks->empty()) {
-        VPRINT(1, "Worker has no tasks\n");
-        return;
+    raw2trace_thread_data_t *tdata = nullptr;
+    worker_queue_t *own = worker_tasks_[worker].get();
+    {
+        std::lock_guard<std::mutex> guard(own->lock);
+        if (!own->tasks.empty()) {
+            tdata = own->tasks.front();
+            own->tasks.pop_front();
+            own->pending_bytes -= tdata->thread_file_size;
+            return tdata;
+        }
+    }
+    // Our own queue is drained: steal from whichever queue has the most work
+    // left.  The sizes can change between the scan and the steal, which only
+    // costs some balance, so we do not hold more than one lock at a time.
+    while (true) {
+        int victim = -1;
+        uint64_t victim_bytes = 0;
+        size_t victim_count = 0;
+        for (int i = 0; i < worker_count_; ++i) {
+            if (i == worker)
+                continue;
+            std::lock_guard<std::mutex> guard(worker_tasks_[i]->lock);
+            size_t count = worker_tasks_[i]->tasks.size();
+            uint64_t bytes = worker_tasks_[i]->pending_bytes;
+            if (count > 0 &&
+                (victim < 0 || bytes > victim_bytes ||
+                 (bytes == victim_bytes && count > victim_count))) {
+                victim = i;
+                victim_bytes = bytes;
+                victim_count = count;
+            }
+        }
+        if (victim < 0)
+            return nullptr;
+        worker_queue_t *queue = worker_tasks_[victim].get();
+        std::lock_guard<std::mutex> guard(queue->lock);
+        if (queue->tasks.empty())
+            continue;
+        // The queues are sorted largest-first, so the front is the biggest
+        // task nobody has started yet: taking it keeps the longest work
+        // starting earliest.
+        tdata = queue->tasks.front();
+        queue->tasks.pop_front();
+        queue->pending_bytes -= tdata->thread_file_size;
+        VPRINT(2, "Worker %d stole trace thread %d from worker %d\n", worker,
+               tdata->index, victim);
+        return tdata;
     }
-    VPRINT(1, "Worker %d assigned %zd task(s)\n", (*tasks)[0]->worker, tasks->size());
-    for (raw2trace_thread_data_t *tdata : *tasks) {
+}
+
+void
+raw2trace_t::process_tasks(int worker)
+{
+    int count = 0;
+    raw2trace_thread_data_t *tdata;
+    while ((tdata = next_task(worker)) != nullptr) {
+        // The decode cache is per-worker, so the thread is now ours.
+        tdata->worker = worker;
+        ++count;
         VPRINT(1, "Worker %d starting on trace thread %d\n", tdata->worker, tdata->index);
         if (!process_thread_file(tdata)) {
             VPRINT(1, "Worker %d hit error %s on trace thread %d\n", tdata->worker,
@@ -1177,6 +1248,7 @@ raw2trace_t::process_tasks(std::vector<raw2trace_thread_data_t *> *tasks)
         }
         VPRINT(1, "Worker %d finished trace thread %d\n", tdata->worker, tdata->index);
     }
+    VPRINT(1, "Worker %d processed %d task(s)\n", worker, count);
 }
 
 // XXX i#6495: This assumes that all contents of the file can easily fit into memory.
@@ -1252,6 +1324,11 @@ raw2trace_t::do_conversion()
     error = read_syscall_template_file();
     if (!error.empty())
         return error;
+    if (worker_count_ > 1) {
+        int bits = estimate_shared_cache_bits();
+        VPRINT(1, "Using %d buckets for the shared decode cache\n", 1 << bits);
+        shared_decode_cache_.reset(new shared_block_hashtable_t(bits));
+    }
     // XXX i#3286: Add a %-completed progress message by looking at the file sizes.
     if (worker_count_ == 0) {
         for (size_t i = 0; i < thread_data_.size(); ++i) {
@@ -1284,8 +1361,7 @@ raw2trace_t::do_conversion()
         VPRINT(1, "Creating %d worker threads\n", worker_count_);
         threads.reserve(worker_count_);
         for (int i = 0; i < worker_count_; ++i) {
-            threads.push_back(
-                std::thread(&raw2trace_t::process_tasks, this, &worker_tasks_[i]));
+            threads.push_back(std::thread(&raw2trace_t::process_tasks, this, i));
         }
         for (std::thread &thread : threads)
             thread.join();
@@ -1627,8 +1703,13 @@ raw2trace_t::append_bb_entries(raw2trace_thread_data_t *tdata,
     } else {
         if (!instr_summary_exists(tdata, in_entry->pc.modidx, in_entry->pc.modoffs,
                                   start_pc, 0, decode_pc)) {
-            if (!analyze_elidable_addresses(tdata, in_entry->pc.modidx,
-                                            in_entry->pc.modoffs, start_pc, instr_count))
+            if (use_shared_decode_cache(tdata)) {
+                if (!publish_block_summary(tdata, in_entry->pc.modidx,
+                                           in_entry->pc.modoffs, start_pc, instr_count))
+                    return false;
+            } else if (!analyze_elidable_addresses(tdata, in_entry->pc.modidx,
+                                                   in_entry->pc.modoffs, start_pc,
+                                                   instr_count))
                 return false;
         }
     }
@@ -2590,7 +2671,12 @@ raw2trace_t::lookup_block_summary(raw2trace_thread_data_t *tdata, uint64 modidx,
                tdata->last_block_summary, tdata->last_decode_block_start);
         return tdata->last_block_summary;
     }
-    block_summary_t *ret = decode_cache_[tdata->worker].lookup(modidx, modoffs);
+    block_summary_t *ret;
+    if (use_shared_decode_cache(tdata)) {
+        tdata->used_shared_decode_cache = true;
+        ret = shared_decode_cache_->lookup(modidx, modoffs);
+    } else
+        ret = decode_cache_[tdata->worker].lookup(modidx, modoffs);
     if (ret != nullptr) {
         DEBUG_ASSERT(ret->start_pc == block_start);
         tdata->last_decode_block_start = block_start;
@@ -2635,6 +2721,24 @@ raw2trace_t::create_instr_summary(raw2trace_thread_data_t *tdata, uint64 modidx,
                                   app_pc block_start, int instr_count, int index,
                                   DR_PARAM_INOUT app_pc *pc, app_pc orig)
 {
+    if (block == nullptr && use_shared_decode_cache(tdata)) {
+        if (!publish_block_summary(tdata, modidx, modoffs, block_start, instr_count))
+            return nullptr;
+        block = tdata->last_block_summary;
+    }
+    if (block != nullptr && block->published) {
+        // A shared block was decoded in full before it was published, so a missing
+        // instruction failed to decode then.
+        instr_summary_t *desc = &block->instrs[index];
+        if (desc->pc() == nullptr) {
+            WARN("Encountered invalid/undecodable instr @ idx=" INT64_FORMAT_STRING
+                 " offs=" INT64_FORMAT_STRING,
+                 modidx, modoffs);
+            return nullptr;
+        }
+        *pc = desc->next_pc();
+        return desc;
+    }
     if (block == nullptr) {
         block = new block_summary_t(block_start, instr_count);
         DEBUG_ASSERT(index >= 0 && index < static_cast<int>(block->instrs.size()));
@@ -2660,6 +2764,65 @@ raw2trace_t::create_instr_summary(raw2trace_thread_data_t *tdata, uint64 modidx,
     return desc;
 }
 
+bool
+raw2trace_t::use_shared_decode_cache(raw2trace_thread_data_t *tdata)
+{
+    return shared_decode_cache_ != nullptr && !tdata->private_decode_cache &&
+        !TESTANY(OFFLINE_FILE_TYPE_FILTERED | OFFLINE_FILE_TYPE_IFILTERED,
+                 get_file_type(tdata));
+}
+
+void
+raw2trace_t::clear_decode_cache(raw2trace_thread_data_t *tdata)
+{
+    // The shared cache cannot be flushed, so once a thread that has read from it
+    // needs a flush it switches to its worker's private cache for good.
+    if (tdata->used_shared_decode_cache)
+        tdata->private_decode_cache = true;
+    decode_cache_[tdata->worker].clear();
+    tdata->last_decode_block_start = nullptr;
+    tdata->last_block_summary = nullptr;
+}
+
+bool
+raw2trace_t::publish_block_summary(raw2trace_thread_data_t *tdata, uint64 modidx,
+                                   uint64 modoffs, app_pc block_start, int instr_count)
+{
+    // Install the new block as the thread's last block so that the elision
+    // analysis below finds and fills it in before anyone else can see it.
+    block_summary_t *block = new block_summary_t(block_start, instr_count);
+    tdata->last_decode_block_start = block_start;
+    tdata->last_decode_modidx = modidx;
+    tdata->last_decode_modoffs = modoffs;
+    tdata->last_block_summary = block;
+    if (!analyze_elidable_addresses(tdata, modidx, modoffs, block_start, instr_count)) {
+        tdata->last_decode_block_start = nullptr;
+        tdata->last_block_summary = nullptr;
+        delete block;
+        return false;
+    }
+    app_pc pc = block_start;
+    for (int i = 0; i < instr_count; ++i) {
+        instr_summary_t *desc = &block->instrs[i];
+        if (desc->pc() != nullptr) {
+            pc = desc->next_pc();
+            continue;
+        }
+        app_pc orig = modmap_().get_orig_pc_from_map_pc(pc, modidx, modoffs);
+        if (!instr_summary_t::construct(dcontext_, block_start, &pc, orig, desc,
+                                        verbosity_)) {
+            // Leave the rest empty: create_instr_summary() reports the failure
+            // once the thread reaches this instruction.
+            desc->pc_ = nullptr;
+            break;
+        }
+    }
+    block = shared_decode_cache_->add(modidx, modoffs, block);
+    VPRINT(5, "Published block summary " PFX " for " PFX "\n", block, block_start);
+    tdata->last_block_summary = block;
+    return true;
+}
+
 const instr_summary_t *
 raw2trace_t::get_instr_summary(raw2trace_thread_data_t *tdata, uint64 modidx,
                                uint64 modoffs, app_pc block_start, int instr_count,
@@ -3107,6 +3270,10 @@ raw2trace_t::open_new_chunk(raw2trace_thread_data_t *tdata)
     tdata->error = tdata->out_archive->open_new_component(stream.str());
     if (!tdata->error.empty())
         return false;
+    // For archives which write a chunk index.  The chunk header below repeats
+    // this timestamp.
+    tdata->out_archive->set_component_start(tdata->chunk_count_ * chunk_instr_count_,
+                                            tdata->last_timestamp_);
     tdata->cur_chunk_instr_count = 0;
     ++tdata->chunk_count_;
     if (tdata->chunk_count_ == 1) {
@@ -3553,9 +3720,6 @@ raw2trace_t::raw2trace_t(
             thread_data_[i]->out_file = out_files[i];
         }
     }
-    // Since we know the traced-thread count up front, we use a simple round-robin
-    // static work assignment.  This won't be as load balanced as a dynamic work
-    // queue but it is much simpler.
     if (worker_count_ < 0) {
         worker_count_ = std::thread::hardware_concurrency();
         if (worker_count_ > kDefaultJobMax)
@@ -3563,12 +3727,30 @@ raw2trace_t::raw2trace_t(
     }
     int cache_count = worker_count_;
     if (worker_count_ > 0) {
-        worker_tasks_.resize(worker_count_);
+        // A few huge threads commonly dominate, so we deal the files out
+        // largest-first and let idle workers steal (see next_task()).  Streams
+        // that cannot report a size sort last in their original order.
+        std::vector<raw2trace_thread_data_t *> order;
+        order.reserve(thread_data_.size());
+        for (auto &tdata : thread_data_) {
+            tdata->thread_file_size = get_stream_size(tdata->thread_file);
+            order.push_back(tdata.get());
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [](const raw2trace_thread_data_t *a,
+                            const raw2trace_thread_data_t *b) {
+                             return a->thread_file_size > b->thread_file_size;
+                         });
+        worker_tasks_.reserve(worker_count_);
+        for (int i = 0; i < worker_count_; ++i)
+            worker_tasks_.emplace_back(new worker_queue_t);
         int worker = 0;
-        for (size_t i = 0; i < thread_data_.size(); ++i) {
-            VPRINT(2, "Worker %d assigned trace thread %zd\n", worker, i);
-            worker_tasks_[worker].push_back(thread_data_[i].get());
-            thread_data_[i]->worker = worker;
+        for (raw2trace_thread_data_t *tdata : order) {
+            VPRINT(2, "Worker %d assigned trace thread %d of size " UINT64_FORMAT_STRING
+                   "\n", worker, tdata->index, tdata->thread_file_size);
+            worker_tasks_[worker]->tasks.push_back(tdata);
+            worker_tasks_[worker]->pending_bytes += tdata->thread_file_size;
+            tdata->worker = worker;
             worker = (worker + 1) % worker_count_;
         }
     } else
@@ -3578,6 +3760,24 @@ raw2trace_t::raw2trace_t(
         decode_cache_.emplace_back(cache_count);
 }
 
+int
+raw2trace_t::estimate_shared_cache_bits()
+{
+    // Only a fraction of a module's code is executed, so we budget one bucket per
+    // this many bytes of mapped code.
+    static const uint64 kCodeBytesPerBlock = 64;
+    static const int kMinBits = 12;
+    static const int kMaxBits = 18;
+    uint64 code_bytes = 0;
+    for (const module_t &mod : modvec_())
+        code_bytes += mod.seg_size;
+    uint64 blocks = code_bytes / kCodeBytesPerBlock;
+    int bits = kMinBits;
+    while (bits < kMaxBits && (static_cast<uint64>(1) << bits) < blocks)
+        ++bits;
+    return bits;
+}
+
 raw2trace_t::~raw2trace_t()
 {
     module_mapper_.reset();
@@ -54,6 +54,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <set>
 #include <string>
@@ -90,6 +91,11 @@ namespace drmemtrace {
 #    define TRACE_SUFFIX_LZ4 "trace.lz4"
 #endif
 
+#ifdef HAS_ZSTD
+#    define TRACE_SUFFIX_ZSTD "trace.zst"
+#    define TRACE_SUFFIX_COLUMNAR "trace.col"
+#endif
+
 #ifdef HAS_ZIP
 #    define TRACE_SUFFIX_ZIP "trace.zip"
 #endif
@@ -624,6 +630,9 @@ protected:
         }
         app_pc start_pc;
         std::vector<instr_summary_t> instrs;
+        // Set once the block is in the shared cache, after which it is never
+        // modified.
+        bool published = false;
     };
 
     struct branch_info_t {
@@ -677,6 +686,9 @@ protected:
         thread_id_t tid;
         int worker;
         std::istream *thread_file;
+        // The raw file size when the stream can report it, else 0.  Used to
+        // order the work queues largest-first.
+        uint64_t thread_file_size = 0;
         archive_ostream_t *out_archive; // May be nullptr.
         std::ostream *out_file;         // Always set; for archive, == "out_archive".
         std::string error;
@@ -712,6 +724,11 @@ protected:
         uint64 last_decode_modidx;
         uint64 last_decode_modoffs;
         block_summary_t *last_block_summary;
+        // Set once this thread has looked up blocks in the shared decode cache.
+        bool used_shared_decode_cache = false;
+        // Set once such a thread has flushed its decodings, after which it uses the
+        // per-worker cache as the shared cache cannot be flushed.
+        bool private_decode_cache = false;
         uint64 last_window = 0;
 
         // Statistics on the processing.
@@ -999,6 +1016,11 @@ protected:
 
     std::vector<std::unique_ptr<raw2trace_thread_data_t>> thread_data_;
 
+    // Returns the log2 bucket count for the shared decode cache, sized from the
+    // code in the mapped modules as an estimate of the number of distinct blocks.
+    int
+    estimate_shared_cache_bits();
+
 private:
     // We store this in drmodtrack_info_t.custom to combine our binary contents
     // data with any user-added module data from drmemtrace_custom_module_data.
@@ -1090,6 +1112,20 @@ private:
                          block_summary_t *block, app_pc block_start, int instr_count,
                          int index, DR_PARAM_INOUT app_pc *pc, app_pc orig);
 
+    // Returns whether tdata's decodings live in shared_decode_cache_.  Filtered
+    // threads record single instructions rather than blocks and so stay private.
+    bool
+    use_shared_decode_cache(raw2trace_thread_data_t *tdata);
+    // Discards tdata's decodings.  A thread that has used the shared cache moves
+    // to its worker's cache for the rest of the conversion.
+    void
+    clear_decode_cache(raw2trace_thread_data_t *tdata);
+    // Decodes and analyzes a new block completely and then adds it to the shared
+    // cache, as shared blocks cannot be filled in lazily.  Returns false on an error.
+    bool
+    publish_block_summary(raw2trace_thread_data_t *tdata, uint64 modidx,
+                          uint64 modoffs, app_pc block_start, int instr_count);
+
     // Return the #instr_summary_t representation of the index-th instruction (at *pc)
     // inside the block that begins at block_start_pc and contains instr_count
     // instructions in the specified module.  Updates the value at pc to the PC of the
@@ -1161,7 +1197,13 @@ private:
     process_thread_file(raw2trace_thread_data_t *tdata);
 
     void
-    process_tasks(std::vector<raw2trace_thread_data_t *> *tasks);
+    process_tasks(int worker);
+
+    // Returns the next task for "worker": the front of its own queue, or else
+    // one stolen from the queue with the most bytes left.  Returns nullptr once
+    // all queues are empty.
+    raw2trace_thread_data_t *
+    next_task(int worker);
 
     bool
     emit_new_chunk_header(raw2trace_thread_data_t *tdata);
@@ -1212,7 +1254,14 @@ private:
     is_marker_type(const offline_entry_t *entry, trace_marker_type_t marker_type);
 
     int worker_count_;
-    std::vector<std::vector<raw2trace_thread_data_t *>> worker_tasks_;
+    // Each worker owns a queue of traced threads, initially dealt out
+    // largest-first so every worker starts on one of the biggest files.
+    struct worker_queue_t {
+        std::mutex lock;
+        std::deque<raw2trace_thread_data_t *> tasks;
+        uint64_t pending_bytes = 0;
+    };
+    std::vector<std::unique_ptr<worker_queue_t>> worker_tasks_;
 
     class block_hashtable_t {
         // We use a hashtable to cache decodings.  We compared the performance of
@@ -1308,8 +1357,110 @@ private:
 #endif
     };
 
-    // We use a per-worker cache to avoid locks.
+    // A cache shared by all workers so that each block is decoded once.  Lookups
+    // are lock-free and each key is inserted once: a worker that loses the race to
+    // add a block discards its copy.  Entries are only freed on destruction.
+    class shared_block_hashtable_t {
+    public:
+        // The table does not resize, so the caller sizes it from the expected
+        // number of distinct blocks (see estimate_shared_cache_bits()).
+        explicit shared_block_hashtable_t(int bucket_bits)
+            : bucket_bits_(bucket_bits)
+            , buckets_(static_cast<size_t>(1) << bucket_bits)
+            , table_(new std::atomic<node_t *>[buckets_])
+        {
+            for (size_t i = 0; i < buckets_; ++i)
+                table_[i].store(nullptr, std::memory_order_relaxed);
+        }
+        ~shared_block_hashtable_t()
+        {
+            for (size_t i = 0; i < buckets_; ++i) {
+                node_t *node = table_[i].load(std::memory_order_relaxed);
+                while (node != nullptr) {
+                    node_t *next = node->next;
+                    delete node->block;
+                    delete node;
+                    node = next;
+                }
+            }
+        }
+        block_summary_t *
+        lookup(uint64 modidx, uint64 modoffs)
+        {
+            uint64 key = hash_key(modidx, modoffs);
+            return find(table_[bucket(key)].load(std::memory_order_acquire), nullptr,
+                        key);
+        }
+        // Takes ownership of "block" and returns the block now in the table for
+        // this key, which is a different one if another worker added it first.
+        block_summary_t *
+        add(uint64 modidx, uint64 modoffs, block_summary_t *block)
+        {
+            uint64 key = hash_key(modidx, modoffs);
+            std::atomic<node_t *> &head = table_[bucket(key)];
+            node_t *node = new node_t(key, block);
+            node_t *old_head = head.load(std::memory_order_acquire);
+            node_t *searched = nullptr;
+            while (true) {
+                // Only the nodes added since our last search need checking.
+                block_summary_t *existing = find(old_head, searched, key);
+                if (existing != nullptr) {
+                    delete node;
+                    delete block;
+                    return existing;
+                }
+                searched = old_head;
+                node->next = old_head;
+                block->published = true;
+                if (head.compare_exchange_weak(old_head, node,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_acquire))
+                    return block;
+            }
+        }
+
+    private:
+        struct node_t {
+            node_t(uint64 key, block_summary_t *block)
+                : key(key)
+                , block(block)
+                , next(nullptr)
+            {
+            }
+            uint64 key;
+            block_summary_t *block;
+            node_t *next;
+        };
+        static block_summary_t *
+        find(node_t *node, node_t *stop, uint64 key)
+        {
+            for (; node != stop; node = node->next) {
+                if (node->key == key)
+                    return node->block;
+            }
+            return nullptr;
+        }
+        static inline uint64
+        hash_key(uint64 modidx, uint64 modoffs)
+        {
+            return (modidx << PC_MODOFFS_BITS) | modoffs;
+        }
+        inline size_t
+        bucket(uint64 key) const
+        {
+            // Fibonacci hashing spreads the mostly-sequential offsets.
+            return static_cast<size_t>((key * 0x9e3779b97f4a7c15ULL) >>
+                                       (64 - bucket_bits_));
+        }
+        const int bucket_bits_;
+        const size_t buckets_;
+        std::unique_ptr<std::atomic<node_t *>[]> table_;
+    };
+
+    // We use a per-worker cache to avoid locks for single-worker conversions and
+    // for threads that cannot share decodings (see use_shared_decode_cache()).
     std::vector<block_hashtable_t> decode_cache_;
+    std::unique_ptr<shared_block_hashtable_t> shared_decode_cache_;
 
     // Store optional parameters for the module_mapper_t until we need to construct it.
     const char *(*user_parse_)(const char *src, DR_PARAM_OUT void **data) = nullptr;
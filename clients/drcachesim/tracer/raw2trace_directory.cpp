@@ -61,6 +61,7 @@
 #include "raw2trace.h"
 #include "record_file_reader.h"
 #include "trace_entry.h"
+#include "uncompressed_ostream.h"
 #include "utils.h"
 #ifdef HAS_ZLIB
 #    include "common/gzip_istream.h"
@@ -78,6 +79,11 @@
 #    include "common/lz4_istream.h"
 #    include "common/lz4_ostream.h"
 #endif
+#ifdef HAS_ZSTD
+#    include "common/columnar_ostream.h"
+#    include "common/zstd_istream.h"
+#    include "common/zstd_ostream.h"
+#endif
 
 namespace dynamorio {
 namespace drmemtrace {
@@ -145,6 +151,14 @@ raw2trace_directory_t::trace_suffix()
     } else if (compress_type_ == "lz4") {
 #ifdef HAS_LZ4
         return TRACE_SUFFIX_LZ4;
+#endif
+    } else if (compress_type_ == "zstd") {
+#ifdef HAS_ZSTD
+        return TRACE_SUFFIX_ZSTD;
+#endif
+    } else if (compress_type_ == "columnar") {
+#ifdef HAS_ZSTD
+        return TRACE_SUFFIX_COLUMNAR;
 #endif
     }
     return TRACE_SUFFIX;
@@ -211,6 +225,19 @@ raw2trace_directory_t::open_thread_log_file(const char *basename)
         }
     }
 #endif
+#ifdef HAS_ZSTD
+    bool is_zstd = false;
+    if (strlen(basename) > strlen(OUTFILE_SUFFIX_ZSTD) + 1) {
+        if (basename_pre_suffix == nullptr) {
+            basename_pre_suffix =
+                strstr(basename + strlen(basename) - strlen(OUTFILE_SUFFIX_ZSTD),
+                       OUTFILE_SUFFIX_ZSTD);
+            if (basename_pre_suffix != nullptr) {
+                is_zstd = true;
+            }
+        }
+    }
+#endif
 
     if (basename_pre_suffix == nullptr)
         basename_pre_suffix = strstr(basename_dot, OUTFILE_SUFFIX);
@@ -241,6 +268,13 @@ raw2trace_directory_t::open_thread_log_file(const char *basename)
             return "Internal Error in determining input file type.";
         ifile = new lz4_istream_t(path);
     }
+#endif
+#ifdef HAS_ZSTD
+    if (is_zstd) {
+        if (ifile != nullptr)
+            return "Internal Error in determining input file type.";
+        ifile = new zstd_istream_t(path);
+    }
 #endif
     if (ifile == nullptr)
         ifile = new std::ifstream(path, std::ifstream::binary);
@@ -278,18 +312,53 @@ raw2trace_directory_t::open_thread_log_file(const char *basename)
 #endif
     } else if (compress_type_ == "gzip") {
 #ifdef HAS_ZLIB
+        // Each chunk becomes a gzip member, listed in a chunk index file.
         ofile = new gzip_ostream_t(path);
+        out_archives_.push_back(reinterpret_cast<archive_ostream_t *>(ofile));
+        if (!(*out_archives_.back()))
+            return "Failed to open output file " + std::string(path);
+
+        VPRINT(1, "Opened output file %s\n", path);
+        return "";
 #endif
     } else if (compress_type_ == "lz4") {
 #ifdef HAS_LZ4
+        // Each chunk becomes an lz4 frame, listed in a chunk index file.
         ofile = new lz4_ostream_t(path);
+        out_archives_.push_back(reinterpret_cast<archive_ostream_t *>(ofile));
+        if (!(*out_archives_.back()))
+            return "Failed to open output file " + std::string(path);
+
+        VPRINT(1, "Opened output file %s\n", path);
+        return "";
+#endif
+    } else if (compress_type_ == "zstd") {
+#ifdef HAS_ZSTD
+        // Each chunk becomes a seekable frame.
+        ofile = new zstd_ostream_t(path, compress_level_);
+        out_archives_.push_back(reinterpret_cast<archive_ostream_t *>(ofile));
+        if (!(*out_archives_.back()))
+            return "Failed to open output file " + std::string(path);
+
+        VPRINT(1, "Opened output file %s\n", path);
+        return "";
+#endif
+    } else if (compress_type_ == "columnar") {
+#ifdef HAS_ZSTD
+        // Each chunk starts a new block, listed in a chunk index file.
+        ofile = new columnar_ostream_t(path, compress_level_);
+        out_archives_.push_back(reinterpret_cast<archive_ostream_t *>(ofile));
+        if (!(*out_archives_.back()))
+            return "Failed to open output file " + std::string(path);
+
+        VPRINT(1, "Opened output file %s\n", path);
+        return "";
 #endif
     }
-    if (!ofile) {
-        ofile = new std::ofstream(path, std::ofstream::binary);
-    }
-    out_files_.push_back(ofile);
-    if (!(*out_files_.back()))
+    // Chunks are listed in a chunk index file.
+    ofile = new uncompressed_ostream_t(path);
+    out_archives_.push_back(reinterpret_cast<archive_ostream_t *>(ofile));
+    if (!(*out_archives_.back()))
         return "Failed to open output file " + std::string(path);
 
     VPRINT(1, "Opened output file %s\n", path);
@@ -494,11 +563,13 @@ raw2trace_directory_t::tracedir_from_rawdir(const std::string &rawdir_in)
 std::string
 raw2trace_directory_t::initialize(const std::string &indir, const std::string &outdir,
                                   const std::string &compress,
-                                  const std::string &syscall_template_file)
+                                  const std::string &syscall_template_file,
+                                  int compress_level)
 {
     indir_ = indir;
     outdir_ = outdir;
     compress_type_ = compress;
+    compress_level_ = compress_level;
 #ifdef WINDOWS
     // Canonicalize.
     std::replace(indir_.begin(), indir_.end(), ALT_DIRSEP[0], DIRSEP[0]);
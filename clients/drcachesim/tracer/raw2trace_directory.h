@@ -74,10 +74,12 @@ public:
 
     // If outdir.empty() then a peer of indir's OUTFILE_SUBDIR named TRACE_SUBDIR
     // is used by default.  Returns "" on success or an error message on failure.
+    // compress_level is used for "zstd" and "columnar" compression, where 0 selects
+    // zstd's default.
     std::string
     initialize(const std::string &indir, const std::string &outdir,
                const std::string &compress = DEFAULT_TRACE_COMPRESSION_TYPE,
-               const std::string &syscall_template_file = "");
+               const std::string &syscall_template_file = "", int compress_level = 0);
     // Use this instead of initialize() to only read the funcion map file.
     // Returns "" on success or an error message on failure.
     // On success, pushes the parsed entries from the file into "entries".
@@ -129,6 +131,7 @@ private:
     std::string outdir_;
     unsigned int verbosity_;
     std::string compress_type_;
+    int compress_level_ = 0;
 };
 
 } // namespace drmemtrace
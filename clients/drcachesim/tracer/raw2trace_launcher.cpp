@@ -92,15 +92,28 @@ static droption_t<int>
 
 static droption_t<std::string> op_trace_compress(
     DROPTION_SCOPE_FRONTEND, "compress", DEFAULT_TRACE_COMPRESSION_TYPE,
-    "Trace compression: \"zip\",\"gzip\",\"zlib\",\"lz4\",\"none\"",
+    "Trace compression: \"zip\",\"gzip\",\"zlib\",\"lz4\",\"zstd\",\"columnar\","
+    "\"none\"",
     "Specifies the compression type to use for trace files: \"zip\", "
-    "\"gzip\", \"zlib\", \"lz4\", or \"none\". "
+    "\"gzip\", \"zlib\", \"lz4\", \"zstd\", \"columnar\", or \"none\". "
     "In most cases where fast skipping by instruction count is not needed "
     "lz4 compression generally improves performance and is recommended. "
+    "zstd supports fast skipping like zip, as each chunk is a separately seekable "
+    "frame, with a better ratio and faster decompression. "
+    "columnar stores the record types, instruction addresses, data addresses, and "
+    "marker values as separately zstd-compressed delta-encoded columns, which "
+    "compresses better still and lets tools that ignore data addresses skip "
+    "decompressing them. "
     "When it comes to storage types, the impact on overhead varies: "
     "for SSDs, zip and gzip often increase overhead and should only be chosen "
     "if space is limited.");
 
+static droption_t<int> op_trace_compress_level(
+    DROPTION_SCOPE_FRONTEND, "compress_level", 0,
+    "Compression level for -compress zstd or columnar",
+    "The zstd compression level for trace files with -compress zstd or columnar.  "
+    "Negative levels trade ratio for speed; 0 selects zstd's default level.");
+
 droption_t<std::string> op_syscall_template_file(
     DROPTION_SCOPE_FRONTEND, "syscall_template_file", "",
     "Path to the file that contains system call trace templates.",
@@ -136,7 +149,8 @@ _tmain(int argc, const TCHAR *targv[])
 
     raw2trace_directory_t dir(op_verbose.get_value());
     std::string dir_err = dir.initialize(op_indir.get_value(), op_outdir.get_value(),
-                                         op_trace_compress.get_value());
+                                         op_trace_compress.get_value(), "",
+                                         op_trace_compress_level.get_value());
     if (!dir_err.empty())
         FATAL_ERROR("Directory parsing failed: %s", dir_err.c_str());
     raw2trace_t raw2trace(dir.modfile_bytes_, dir.in_files_, dir.out_files_,
@@ -2142,6 +2142,7 @@ fork_init(void *drcontext)
             FATAL("Failed to create a subdir in %s\n", op_outdir.get_value().c_str());
         }
     }
+    fork_init_io(drcontext);
     init_thread_in_process(drcontext);
 }
 #endif
@@ -2396,37 +2397,48 @@ drmemtrace_client_main(client_id_t id, int argc, const char *argv[])
         placement = dr_global_alloc(MAX_INSTRU_SIZE);
         instru = new (placement) online_instru_t(
             insert_load_buf_ptr, insert_update_buf_ptr, &scratch_reserve_vec);
-        if (!ipc_pipe.set_name(op_ipc_name.get_value().c_str()))
-            DR_ASSERT(false);
+        if (op_ipc_shm.get_value()) {
+#ifdef LINUX
+            if (!init_shm_rings(op_ipc_name.get_value())) {
+                FATAL("Fatal error: failed to attach to -ipc_shm rings for %s.\n",
+                      op_ipc_name.get_value().c_str());
+            }
+#else
+            FATAL("Usage error: -ipc_shm is only supported on Linux.\n");
+#endif
+        } else {
+            if (!ipc_pipe.set_name(op_ipc_name.get_value().c_str()))
+                DR_ASSERT(false);
 #ifdef UNIX
-        /* we want an isolated fd so we don't use ipc_pipe.open_for_write() */
-        const char *pipe_path = ipc_pipe.get_pipe_path().c_str();
-        if (!dr_file_exists(pipe_path)) {
-            NOTIFY(0,
-                   "drmemtrace WARNING: attempting to open write end of pipe at %s "
-                   "for online analysis but pipe does not exist. Use \"-offline\" "
-                   "mode if you are using drmemtrace without a reader.\n",
-                   pipe_path);
-        }
+            /* we want an isolated fd so we don't use ipc_pipe.open_for_write() */
+            const char *pipe_path = ipc_pipe.get_pipe_path().c_str();
+            if (!dr_file_exists(pipe_path)) {
+                NOTIFY(0,
+                       "drmemtrace WARNING: attempting to open write end of pipe at %s "
+                       "for online analysis but pipe does not exist. Use \"-offline\" "
+                       "mode if you are using drmemtrace without a reader.\n",
+                       pipe_path);
+            }
 
-        int fd = dr_open_file(pipe_path, DR_FILE_WRITE_ONLY);
-        DR_ASSERT(fd != INVALID_FILE);
-        if (!ipc_pipe.set_fd(fd))
-            DR_ASSERT(false);
+            int fd = dr_open_file(pipe_path, DR_FILE_WRITE_ONLY);
+            DR_ASSERT(fd != INVALID_FILE);
+            if (!ipc_pipe.set_fd(fd))
+                DR_ASSERT(false);
 #else
-        if (!ipc_pipe.open_for_write()) {
-            if (GetLastError() == ERROR_PIPE_BUSY) {
-                // FIXME i#1727: add multi-process support to Windows named_pipe_t.
-                FATAL("Fatal error: multi-process applications not yet supported "
-                      "for drcachesim on Windows\n");
-            } else {
-                FATAL("Fatal error: Failed to open pipe %s.\n",
-                      op_ipc_name.get_value().c_str());
+            if (!ipc_pipe.open_for_write()) {
+                if (GetLastError() == ERROR_PIPE_BUSY) {
+                    // FIXME i#1727: add multi-process support to Windows named_pipe_t.
+                    FATAL("Fatal error: multi-process applications not yet supported "
+                          "for drcachesim on Windows\n");
+                } else {
+                    FATAL("Fatal error: Failed to open pipe %s.\n",
+                          op_ipc_name.get_value().c_str());
+                }
             }
-        }
 #endif
-        if (!ipc_pipe.maximize_buffer())
-            NOTIFY(1, "Failed to maximize pipe buffer: performance may suffer.\n");
+            if (!ipc_pipe.maximize_buffer())
+                NOTIFY(1, "Failed to maximize pipe buffer: performance may suffer.\n");
+        }
     }
 
     if (op_offline.get_value() &&
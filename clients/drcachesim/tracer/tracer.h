@@ -57,6 +57,9 @@
 #ifdef HAS_LZ4
 #    include <lz4frame.h>
 #endif
+#ifdef HAS_ZSTD
+#    include <zstd.h>
+#endif
 #ifdef BUILD_PT_TRACER
 #    include "syscall_pt_trace.h"
 #endif
@@ -75,6 +78,9 @@ extern named_pipe_t ipc_pipe;
         dr_abort();                      \
     } while (0)
 
+struct async_stream_t;
+struct shm_ring_t;
+
 /* Thread private data.  This is all set to 0 at thread init. */
 typedef struct {
     byte *seg_base;
@@ -109,6 +115,15 @@ typedef struct {
     size_t buf_lz4_size;
     byte *buf_lz4;
 #endif
+#ifdef HAS_ZSTD
+    ZSTD_CCtx *zstd_cctx;
+    size_t buf_zstd_size;
+    byte *buf_zstd;
+#endif
+    /* For -raw_output_threads: the queue of full buffers awaiting writing. */
+    async_stream_t *async_stream;
+    /* For -ipc_shm: the ring this thread writes to. */
+    shm_ring_t *shm_ring;
     bool has_thread_header;
     // The physaddr_t class is designed to be per-thread.
     physaddr_t physaddr;